@@ -2609,6 +2609,94 @@ dds_waitset_wait_until(
   size_t nxs,
   dds_time_t abstimeout);
 
+/**
+ * @brief Edge-triggered variant of dds_waitset_wait: wait for attached
+ *        entities to trigger anew.
+ *
+ * The "dds_waitset_wait_edge" operation blocks until some of the attached
+ * entities have triggered since they were last returned by an edge-triggered
+ * wait on this waitset, or until "reltimeout" has been reached. It returns
+ * only those entities and not the ones that were returned before and are
+ * still triggered. An entity counts as triggered anew when it goes from not
+ * triggered to triggered, but also on a further status change while it is
+ * triggered, e.g., when a reader receives new data while it still has
+ * unread data.
+ *
+ * In contrast with dds_waitset_wait, the returned entities are consumed: if
+ * multiple threads are waiting on the same waitset, each triggering entity
+ * is returned by only one of them. If more entities triggered than fit in
+ * "xs", the others are returned by a subsequent call.
+ *
+ * The cost of waiting is proportional to the number of triggered entities
+ * rather than to the number of attached entities, which makes it suitable
+ * for waitsets with a large number of attached entities.
+ *
+ * Edge-triggered and level-triggered (dds_waitset_wait) waits can be mixed
+ * on a waitset; the latter don't affect which entities are returned by the
+ * former.
+ *
+ * @param[in]  waitset    The waitset to wait on.
+ * @param[out] xs         Pre-allocated list to store the 'blobs' that were
+ *                        provided during the attach of the triggered entities.
+ * @param[in]  nxs        The size of the pre-allocated blobs list (> 0).
+ * @param[in]  reltimeout Relative timeout
+ *
+ * @returns A dds_return_t with the number of entities stored in xs or an error code.
+ *
+ * @retval >0
+ *             Number of newly triggered entities stored in xs.
+ * @retval  0
+ *             Time out (no entities were triggered anew).
+ * @retval DDS_RETCODE_ERROR
+ *             An internal error has occurred.
+ * @retval DDS_RETCODE_BAD_PARAMETER
+ *             The given waitset is not valid or xs is a null pointer.
+ * @retval DDS_RETCODE_ILLEGAL_OPERATION
+ *             The operation is invoked on an inappropriate object.
+ * @retval DDS_RETCODE_ALREADY_DELETED
+ *             The waitset has already been deleted.
+ */
+DDS_EXPORT dds_return_t
+dds_waitset_wait_edge(
+  dds_entity_t waitset,
+  dds_attach_t *xs,
+  size_t nxs,
+  dds_duration_t reltimeout);
+
+/**
+ * @brief Edge-triggered variant of dds_waitset_wait_until.
+ *
+ * The "dds_waitset_wait_edge_until" operation is the same as
+ * "dds_waitset_wait_edge" except that it takes an absolute timeout.
+ *
+ * @param[in]  waitset    The waitset to wait on.
+ * @param[out] xs         Pre-allocated list to store the 'blobs' that were
+ *                        provided during the attach of the triggered entities.
+ * @param[in]  nxs        The size of the pre-allocated blobs list (> 0).
+ * @param[in]  abstimeout Absolute timeout
+ *
+ * @returns A dds_return_t with the number of entities stored in xs or an error code.
+ *
+ * @retval >0
+ *             Number of newly triggered entities stored in xs.
+ * @retval  0
+ *             Time out (no entities were triggered anew).
+ * @retval DDS_RETCODE_ERROR
+ *             An internal error has occurred.
+ * @retval DDS_RETCODE_BAD_PARAMETER
+ *             The given waitset is not valid or xs is a null pointer.
+ * @retval DDS_RETCODE_ILLEGAL_OPERATION
+ *             The operation is invoked on an inappropriate object.
+ * @retval DDS_RETCODE_ALREADY_DELETED
+ *             The waitset has already been deleted.
+ */
+DDS_EXPORT dds_return_t
+dds_waitset_wait_edge_until(
+  dds_entity_t waitset,
+  dds_attach_t *xs,
+  size_t nxs,
+  dds_time_t abstimeout);
+
 /*
   There are a number of read and take variations.
 
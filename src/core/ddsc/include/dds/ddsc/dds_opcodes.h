@@ -145,6 +145,7 @@ enum dds_stream_typecode_subtype {
 #define DDS_TOPIC_CONTAINS_UNION 0x0004
 #define DDS_TOPIC_DISABLE_TYPECHECK 0x0008
 #define DDS_TOPIC_FIXED_SIZE 0x0010
+#define DDS_TOPIC_CDR_FUNCS 0x0020 /* descriptor has m_cdr_funcs; not part of the type definition */
 
 #if defined(__cplusplus)
 }
@@ -47,6 +47,24 @@ typedef struct dds_key_descriptor
 }
 dds_key_descriptor_t;
 
+struct dds_ostream;
+struct dds_istream;
+
+/*
+  Type-specialised (de)serialisation functions, optionally generated by the
+  IDL compiler. Each is semantically equivalent to interpreting m_ops, and
+  the interpreter remains the fallback for anything not covered here.
+*/
+
+typedef struct dds_topic_cdr_funcs
+{
+  void (*write) (struct dds_ostream *os, const void *sample);
+  void (*write_key) (struct dds_ostream *os, const void *sample);
+  void (*read) (struct dds_istream *is, void *sample);
+  bool (*normalize) (char *data, uint32_t *off, uint32_t size, bool bswap);
+}
+dds_topic_cdr_funcs_t;
+
 /*
   Topic definitions are output by a preprocessor and have an
   implementation-private definition. The only thing exposed on the
@@ -64,6 +82,7 @@ typedef struct dds_topic_descriptor
   const uint32_t m_nops;               /* Number of ops in m_ops */
   const uint32_t * m_ops;              /* Marshalling meta data */
   const char * m_meta;                 /* XML topic description meta data */
+  const dds_topic_cdr_funcs_t * m_cdr_funcs; /* Generated (de)serialisers, only valid if DDS_TOPIC_CDR_FUNCS set */
 }
 dds_topic_descriptor_t;
 
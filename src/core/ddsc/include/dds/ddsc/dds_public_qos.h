@@ -473,6 +473,27 @@ dds_qset_type_consistency (
   bool prevent_type_widening,
   bool force_type_validation);
 
+/**
+ * @brief Set the content filter of a reader qos structure
+ *
+ * The filter is published in discovery, so that matching writers can
+ * drop samples the reader is not interested in before sending them.
+ * The expression uses SQL-like syntax over the key fields of the topic
+ * type, e.g. "id > %0 AND name = 'x'", where %n refers to ps[n].  A
+ * null pointer for expression removes the filter.
+ *
+ * @param[in,out] qos - Pointer to a dds_qos_t structure that will store the policy
+ * @param[in] expression - Filter expression, or a null pointer
+ * @param[in] n - Number of parameters stored in ps
+ * @param[in] ps - Pointer to string(s) storing the parameter values
+ */
+DDS_EXPORT void
+dds_qset_content_filter (
+  dds_qos_t * __restrict qos,
+  const char * __restrict expression,
+  uint32_t n,
+  const char ** __restrict ps);
+
 
 /**
  * @brief Get the userdata from a qos structure
@@ -866,6 +887,23 @@ dds_qget_type_consistency (
   bool *prevent_type_widening,
   bool *force_type_validation);
 
+/**
+ * @brief Get the content filter qos policy
+ *
+ * @param[in] qos - Pointer to a dds_qos_t structure storing the policy
+ * @param[in,out] expression - Pointer that will store the filter expression (optional)
+ * @param[in,out] n - Pointer that will store the number of parameters (optional)
+ * @param[in,out] ps - Pointer that will store the parameter string(s) (optional)
+ *
+ * @returns - false iff any of the arguments is invalid or the qos is not present in the qos object
+ */
+DDS_EXPORT bool
+dds_qget_content_filter (
+  const dds_qos_t * __restrict qos,
+  char **expression,
+  uint32_t *n,
+  char ***ps);
+
 #if defined (__cplusplus)
 }
 #endif
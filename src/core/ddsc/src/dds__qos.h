@@ -37,7 +37,7 @@ extern "C" {
    QP_RELIABILITY | QP_DESTINATION_ORDER | QP_HISTORY |                 \
    QP_RESOURCE_LIMITS | QP_ADLINK_READER_DATA_LIFECYCLE |               \
    QP_CYCLONE_IGNORELOCAL | QP_PROPERTY_LIST |                          \
-   QP_TYPE_CONSISTENCY_ENFORCEMENT)
+   QP_TYPE_CONSISTENCY_ENFORCEMENT | QP_CYCLONE_CONTENT_FILTER)
 
 #define DDS_SUBSCRIBER_QOS_MASK                                         \
   (QP_PARTITION | QP_PRESENTATION | QP_GROUP_DATA |                     \
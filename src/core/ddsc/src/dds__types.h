@@ -49,6 +49,7 @@ struct dds_statuscond;
 
 struct ddsi_sertype;
 struct ddsi_rhc;
+struct ddsi_cfilter;
 
 typedef uint16_t status_mask_t;
 typedef ddsrt_atomic_uint32_t status_and_enabled_t;
@@ -313,6 +314,7 @@ typedef struct dds_reader {
   void *m_loan;
   uint32_t m_loan_size;
   unsigned m_wrapped_sertopic : 1; /* set iff reader's topic is a wrapped ddsi_sertopic for backwards compatibility */
+  struct ddsi_cfilter *m_cfilter; /* compiled content filter QoS, or NULL; constant */
 #ifdef DDS_HAS_SHM
   iox_sub_storage_extension_t m_iox_sub_stor;
   iox_sub_t m_iox_sub;
@@ -335,6 +337,7 @@ typedef struct dds_writer {
   struct writer *m_wr;
   struct whc *m_whc; /* FIXME: ownership still with underlying DDSI writer (cos of DDSI built-in writers )*/
   bool whc_batch; /* FIXME: channels + latency budget */
+  struct dds_write_queue *m_queue; /* NULL unless Internal/WriteQueueSize > 0, constant */
 #ifdef DDS_HAS_SHM
   iox_pub_storage_t m_iox_pub_stor;
   iox_pub_t m_iox_pub;
@@ -381,6 +384,7 @@ typedef struct dds_attachment {
   dds_entity *entity;
   dds_entity_t handle;
   dds_attach_t arg;
+  size_t index;             /* [wait_lock] position in dds_waitset::entities */
 } dds_attachment;
 
 typedef struct dds_waitset {
@@ -393,7 +397,11 @@ typedef struct dds_waitset {
   ddsrt_cond_t wait_cond;
   size_t nentities;         /* [wait_lock] */
   size_t ntriggered;        /* [wait_lock] */
-  dds_attachment *entities; /* [wait_lock] 0 .. ntriggered are triggred, ntriggred .. nentities are not */
+  size_t nreported;         /* [wait_lock] */
+  /* [wait_lock] 0 .. nreported are triggered and have been returned by an edge-triggered wait,
+     nreported .. ntriggered are triggered but haven't been, ntriggered .. nentities are not triggered */
+  dds_attachment **entities;
+  struct ddsrt_hh *entity_index; /* [wait_lock] attachments indexed on handle */
 } dds_waitset;
 
 DDS_EXPORT extern dds_cyclonedds_entity dds_global;
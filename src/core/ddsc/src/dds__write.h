@@ -21,6 +21,7 @@ extern "C" {
 #define DDS_WR_UNREGISTER_BIT 0x04
 
 struct ddsi_serdata;
+struct dds_write_queue;
 
 typedef enum {
   DDS_WR_ACTION_WRITE = 0,
@@ -33,6 +34,11 @@ dds_return_t dds_write_impl (dds_writer *wr, const void *data, dds_time_t tstamp
 dds_return_t dds_writecdr_impl (dds_writer *wr, struct nn_xpack *xp, struct ddsi_serdata *d, bool flush);
 dds_return_t dds_writecdr_local_orphan_impl (struct local_orphan_writer *lowr, struct nn_xpack *xp, struct ddsi_serdata *d);
 
+/* takes ownership of xp */
+struct dds_write_queue *dds_write_queue_new (struct nn_xpack *xp, uint32_t size);
+void dds_write_queue_free (struct dds_write_queue *q);
+void dds_write_queue_flush (struct dds_write_queue *q);
+
 #if defined (__cplusplus)
 }
 #endif
@@ -205,6 +205,7 @@ fail_threadmon_new:
   rtps_fini (&domain->gv);
 fail_rtps_init:
 fail_rtps_config:
+  rtps_config_close_bintrace (&domain->gv);
   if (domain->cfgst)
     config_fini (domain->cfgst);
 fail_config:
@@ -348,6 +349,7 @@ static dds_return_t dds_domain_free (dds_entity *vdomain)
 
   ddsrt_avl_delete (&dds_domaintree_def, &dds_global.m_domains, domain);
   dds_entity_final_deinit_before_free (vdomain);
+  rtps_config_close_bintrace (&domain->gv);
   if (domain->cfgst)
     config_fini (domain->cfgst);
   dds_free (vdomain);
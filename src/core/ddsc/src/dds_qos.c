@@ -455,6 +455,33 @@ void dds_qset_type_consistency (dds_qos_t * __restrict qos, dds_type_consistency
   qos->present |= QP_TYPE_CONSISTENCY_ENFORCEMENT;
 }
 
+void dds_qset_content_filter (dds_qos_t * __restrict qos, const char * __restrict expression, uint32_t n, const char ** __restrict ps)
+{
+  if (qos == NULL || (n > 0 && ps == NULL))
+    return;
+  if (qos->present & QP_CYCLONE_CONTENT_FILTER)
+  {
+    ddsrt_free (qos->content_filter.expression);
+    for (uint32_t i = 0; i < qos->content_filter.parameters.n; i++)
+      ddsrt_free (qos->content_filter.parameters.strs[i]);
+    ddsrt_free (qos->content_filter.parameters.strs);
+    qos->present &= ~QP_CYCLONE_CONTENT_FILTER;
+  }
+  if (expression == NULL)
+    return;
+  qos->content_filter.expression = ddsrt_strdup (expression);
+  qos->content_filter.parameters.n = n;
+  if (n == 0)
+    qos->content_filter.parameters.strs = NULL;
+  else
+  {
+    qos->content_filter.parameters.strs = ddsrt_malloc (n * sizeof (*qos->content_filter.parameters.strs));
+    for (uint32_t i = 0; i < n; i++)
+      qos->content_filter.parameters.strs[i] = ddsrt_strdup (ps[i]);
+  }
+  qos->present |= QP_CYCLONE_CONTENT_FILTER;
+}
+
 bool dds_qget_userdata (const dds_qos_t * __restrict qos, void **value, size_t *sz)
 {
   if (qos == NULL || !(qos->present & QP_USER_DATA))
@@ -768,3 +795,27 @@ bool dds_qget_type_consistency (const dds_qos_t * __restrict qos, dds_type_consi
     *force_type_validation = qos->type_consistency.force_type_validation;
   return true;
 }
+
+bool dds_qget_content_filter (const dds_qos_t * __restrict qos, char **expression, uint32_t *n, char ***ps)
+{
+  if (qos == NULL || !(qos->present & QP_CYCLONE_CONTENT_FILTER))
+    return false;
+  if (n == NULL && ps != NULL)
+    return false;
+  if (expression)
+    *expression = dds_string_dup (qos->content_filter.expression);
+  if (n)
+    *n = qos->content_filter.parameters.n;
+  if (ps)
+  {
+    if (qos->content_filter.parameters.n == 0)
+      *ps = NULL;
+    else
+    {
+      *ps = dds_alloc (sizeof (char*) * qos->content_filter.parameters.n);
+      for (uint32_t i = 0; i < qos->content_filter.parameters.n; i++)
+        (*ps)[i] = dds_string_dup (qos->content_filter.parameters.strs[i]);
+    }
+  }
+  return true;
+}
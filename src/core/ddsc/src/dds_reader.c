@@ -35,6 +35,7 @@
 #include "dds/ddsi/ddsi_entity_index.h"
 #include "dds/ddsi/ddsi_security_omg.h"
 #include "dds/ddsi/ddsi_statistics.h"
+#include "dds/ddsi/ddsi_cfilter.h"
 
 #ifdef DDS_HAS_SHM
 #include "shm__monitor.h"
@@ -113,6 +114,7 @@ static dds_return_t dds_reader_delete (dds_entity *e)
   }
 #endif
 
+  ddsi_cfilter_free (rd->m_cfilter);
   dds_entity_drop_ref (&rd->m_topic->m_entity);
   return DDS_RETCODE_OK;
 }
@@ -472,6 +474,7 @@ static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscribe
   dds_subscriber *sub = NULL;
   dds_entity_t subscriber;
   dds_topic *tp;
+  struct ddsi_cfilter *cfilter = NULL;
   dds_return_t rc;
   dds_entity_t pseudo_topic = 0;
   bool created_implicit_sub = false;
@@ -562,6 +565,10 @@ static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscribe
     goto err_bad_qos;
   }
 
+  if ((rqos->present & QP_CYCLONE_CONTENT_FILTER) &&
+      (rc = ddsi_cfilter_compile (&cfilter, tp->m_stype, rqos->content_filter.expression, rqos->content_filter.parameters.n, rqos->content_filter.parameters.strs)) != DDS_RETCODE_OK)
+    goto err_bad_qos;
+
   thread_state_awake (lookup_thread_state (), gv);
   const struct ddsi_guid * ppguid = dds_entity_participant_guid (&sub->m_entity);
   struct participant * pp = entidx_lookup_participant_guid (gv->entity_index, ppguid);
@@ -590,6 +597,7 @@ static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscribe
   rd->m_sample_rejected_status.last_reason = DDS_NOT_REJECTED;
   rd->m_topic = tp;
   rd->m_wrapped_sertopic = (tp->m_stype->wrapped_sertopic != NULL) ? 1 : 0;
+  rd->m_cfilter = cfilter;
   rd->m_rhc = rhc ? rhc : dds_rhc_default_new (rd, tp->m_stype);
   if (dds_rhc_associate (rd->m_rhc, rd, tp->m_stype, rd->m_entity.m_domain->gv.m_tkmap) < 0)
   {
@@ -659,6 +667,7 @@ static dds_entity_t dds_create_reader_int (dds_entity_t participant_or_subscribe
 #ifdef DDS_HAS_SECURITY
 err_not_allowed:
   thread_state_asleep (lookup_thread_state ());
+  ddsi_cfilter_free (cfilter);
 #endif
 err_bad_qos:
   dds_delete_qos (rqos);
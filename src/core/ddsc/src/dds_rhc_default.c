@@ -40,6 +40,7 @@
 #include "dds/ddsi/q_entity.h" /* proxy_writer_info */
 #include "dds/ddsi/ddsi_serdata.h"
 #include "dds/ddsi/ddsi_serdata_default.h"
+#include "dds/ddsi/ddsi_cfilter.h"
 #ifdef DDS_HAS_LIFESPAN
 #include "dds/ddsi/ddsi_lifespan.h"
 #endif
@@ -100,11 +101,13 @@
    QOS SUPPORT
    ===========
 
-   History is implemented as a (circular) linked list, but the invalid samples
-   model implemented here allows this to trivially be changed to an array of
-   samples, and this is probably profitable for shallow histories.  Currently
-   the instance has a single sample embedded in particular to optimise the
-   KEEP_LAST with depth=1 case.
+   History is implemented as a (circular) linked list.  For shallow KEEP_LAST
+   histories (depth <= MAX_EMBEDDED_SAMPLES) the instance is allocated with
+   storage for the full history depth embedded in it, so that, once an instance
+   exists, storing, reading and taking samples neither allocates nor frees
+   memory and only touches the instance and the samples immediately following
+   it.  Deeper histories have a single sample embedded (in particular to
+   optimise the case of a single sample) and allocate the others separately.
 
    BY_SOURCE ordering is implemented differently from OpenSplice and does not
    perform back-filling of the history.  The arguments against that can be
@@ -160,6 +163,10 @@
 
 #define MAX_ATTACHED_QUERYCONDS (CHAR_BIT * sizeof (dds_querycond_mask_t))
 
+/* Maximum history depth for which all samples are embedded in the instance,
+   must fit in rhc_instance::a_sample_free */
+#define MAX_EMBEDDED_SAMPLES 4
+
 #define INCLUDE_TRACE 1
 #if INCLUDE_TRACE
 #define TRACE(...) DDS_CLOG (DDS_LC_RHC, &rhc->gv->logconfig, __VA_ARGS__)
@@ -262,13 +269,14 @@ struct rhc_instance {
   dds_querycond_mask_t conds;  /* matching query conditions */
   uint32_t wrcount;            /* number of live writers */
   unsigned isnew : 1;          /* NEW or NOT_NEW view state */
-  unsigned a_sample_free : 1;  /* whether or not a_sample is in use */
   unsigned isdisposed : 1;     /* DISPOSED or NOT_DISPOSED (if not disposed, wrcount determines ALIVE/NOT_ALIVE_NO_WRITERS) */
   unsigned autodispose : 1;    /* wrcount > 0 => at least one registered writer has had auto-dispose set on some update */
   unsigned wr_iid_islive : 1;  /* whether wr_iid is of a live writer */
   unsigned inv_exists : 1;     /* whether or not state change occurred since last sample (i.e., must return invalid sample) */
   unsigned inv_isread : 1;     /* whether or not that state change has been read before */
   unsigned deadline_reg : 1;   /* whether or not registered for a deadline (== isdisposed, except store() defers updates) */
+  uint8_t a_sample_n;          /* number of samples in a_sample */
+  uint8_t a_sample_free;       /* bitmask of unused entries in a_sample */
   uint32_t disposed_gen;       /* bloody generation counters - worst invention of mankind */
   uint32_t no_writers_gen;     /* __/ */
   int32_t strength;            /* "current" ownership strength */
@@ -279,7 +287,7 @@ struct rhc_instance {
   struct deadline_elem deadline; /* element in deadline missed administration */
 #endif
   struct ddsi_tkmap_instance *tk;/* backref into TK for unref'ing */
-  struct rhc_sample a_sample;  /* pre-allocated storage for 1 sample */
+  struct rhc_sample a_sample[]; /* pre-allocated storage for a_sample_n samples */
 };
 
 typedef enum rhc_store_result {
@@ -320,6 +328,7 @@ struct dds_rhc_default {
   struct ddsi_domaingv *gv;          /* globals -- so far only for log config */
   const struct ddsi_sertype *type;   /* type description */
   uint32_t history_depth;            /* depth, 1 for KEEP_LAST_1, 2**32-1 for KEEP_ALL */
+  uint32_t n_embedded_samples;       /* number of samples embedded in a new instance */
 
   ddsrt_mutex_t lock;
   dds_readcond * conds;              /* List of associated read conditions */
@@ -611,6 +620,7 @@ static void dds_rhc_default_set_qos (struct ddsi_rhc *rhc_common, const dds_qos_
   rhc->reliable = (qos->reliability.kind == DDS_RELIABILITY_RELIABLE);
   assert(qos->history.kind != DDS_HISTORY_KEEP_LAST || qos->history.depth > 0);
   rhc->history_depth = (qos->history.kind == DDS_HISTORY_KEEP_LAST) ? (uint32_t)qos->history.depth : ~0u;
+  rhc->n_embedded_samples = (rhc->history_depth <= MAX_EMBEDDED_SAMPLES) ? rhc->history_depth : 1;
   /* FIXME: updating deadline duration not yet supported
   rhc->deadline.dur = qos->deadline.deadline; */
 }
@@ -629,15 +639,25 @@ static bool eval_predicate_invsample (const struct dds_rhc_default *rhc, const s
   return ret;
 }
 
+static bool is_embedded_sample (const struct rhc_instance *inst, const struct rhc_sample *s)
+{
+  const uintptr_t a = (uintptr_t) inst->a_sample;
+  return (uintptr_t) s >= a && (uintptr_t) s < a + inst->a_sample_n * sizeof (*s);
+}
+
 static struct rhc_sample *alloc_sample (struct rhc_instance *inst)
 {
   if (inst->a_sample_free)
   {
-    inst->a_sample_free = 0;
+    /* lowest free one, so a history that is not full is at the front */
+    uint32_t i = 0;
+    while (!(inst->a_sample_free & (1u << i)))
+      i++;
+    inst->a_sample_free &= (uint8_t) ~(1u << i);
 #if USE_VALGRIND
-    VALGRIND_MAKE_MEM_UNDEFINED (&inst->a_sample, sizeof (inst->a_sample));
+    VALGRIND_MAKE_MEM_UNDEFINED (&inst->a_sample[i], sizeof (inst->a_sample[i]));
 #endif
-    return &inst->a_sample;
+    return &inst->a_sample[i];
   }
   else
   {
@@ -657,13 +677,14 @@ static void free_sample (struct dds_rhc_default *rhc, struct rhc_instance *inst,
 #ifdef DDS_HAS_LIFESPAN
   lifespan_unregister_sample_locked (&rhc->lifespan, &s->lifespan);
 #endif
-  if (s == &inst->a_sample)
+  if (is_embedded_sample (inst, s))
   {
-    assert (!inst->a_sample_free);
+    const uint32_t i = (uint32_t) (s - inst->a_sample);
+    assert (!(inst->a_sample_free & (1u << i)));
 #if USE_VALGRIND
-    VALGRIND_MAKE_MEM_NOACCESS (&inst->a_sample, sizeof (inst->a_sample));
+    VALGRIND_MAKE_MEM_NOACCESS (s, sizeof (*s));
 #endif
-    inst->a_sample_free = 1;
+    inst->a_sample_free |= (uint8_t) (1u << i);
   }
   else
   {
@@ -969,6 +990,10 @@ static bool content_filter_accepts (const dds_reader *reader, const struct ddsi_
   if (reader)
   {
     const struct dds_topic *tp = reader->m_topic;
+    /* the QoS content filter is also applied by writers that support it,
+       but not by all of them and not in all cases */
+    if (reader->m_cfilter && !ddsi_cfilter_accepts (reader->m_cfilter, sample))
+      return false;
     switch (tp->m_filter.mode)
     {
       case DDS_TOPIC_FILTER_NONE:
@@ -1384,8 +1409,10 @@ static struct rhc_instance *alloc_new_instance (struct dds_rhc_default *rhc, con
   struct rhc_instance *inst;
 
   ddsi_tkmap_instance_ref (tk);
-  inst = ddsrt_malloc (sizeof (*inst));
-  memset (inst, 0, sizeof (*inst));
+  assert (rhc->n_embedded_samples >= 1 && rhc->n_embedded_samples <= MAX_EMBEDDED_SAMPLES);
+  const size_t size = offsetof (struct rhc_instance, a_sample) + rhc->n_embedded_samples * sizeof (inst->a_sample[0]);
+  inst = ddsrt_malloc (size);
+  memset (inst, 0, size);
   inst->iid = tk->m_iid;
   inst->tk = tk;
   inst->wrcount = 1;
@@ -1393,7 +1420,8 @@ static struct rhc_instance *alloc_new_instance (struct dds_rhc_default *rhc, con
   inst->autodispose = wrinfo->auto_dispose;
   inst->deadline_reg = 0;
   inst->isnew = 1;
-  inst->a_sample_free = 1;
+  inst->a_sample_n = (uint8_t) rhc->n_embedded_samples;
+  inst->a_sample_free = (uint8_t) ((1u << rhc->n_embedded_samples) - 1);
   inst->conds = 0;
   inst->wr_iid = wrinfo->iid;
   inst->wr_iid_islive = (inst->wrcount != 0);
@@ -2757,7 +2785,7 @@ static int rhc_check_counts_locked (struct dds_rhc_default *rhc, bool check_cond
   for (inst = ddsrt_hh_iter_first (rhc->instances, &iter); inst; inst = ddsrt_hh_iter_next (&iter))
   {
     uint32_t n_vsamples_in_instance = 0, n_read_vsamples_in_instance = 0;
-    bool a_sample_free = true;
+    uint32_t a_sample_used = 0;
 
     n_instances++;
     if (inst->isnew)
@@ -2775,10 +2803,11 @@ static int rhc_check_counts_locked (struct dds_rhc_default *rhc, bool check_cond
     {
       struct rhc_sample *sample = inst->latest->next, * const end = sample;
       do {
-        if (sample == &inst->a_sample)
+        if (is_embedded_sample (inst, sample))
         {
-          assert (a_sample_free);
-          a_sample_free = false;
+          const uint32_t bit = 1u << (uint32_t) (sample - inst->a_sample);
+          assert (!(a_sample_used & bit));
+          a_sample_used |= bit;
         }
         n_vsamples++;
         n_vsamples_in_instance++;
@@ -2799,7 +2828,8 @@ static int rhc_check_counts_locked (struct dds_rhc_default *rhc, bool check_cond
 
     assert (n_read_vsamples_in_instance == inst->nvread);
     assert (n_vsamples_in_instance == inst->nvsamples);
-    assert (a_sample_free == inst->a_sample_free);
+    assert ((a_sample_used | inst->a_sample_free) == (1u << inst->a_sample_n) - 1);
+    assert (!(a_sample_used & inst->a_sample_free));
 
     if (check_conds)
     {
@@ -620,13 +620,17 @@ dds_entity_t dds_create_topic (dds_entity_t participant, const dds_topic_descrip
   st->serpool = ppent->m_domain->gv.serpool;
   st->type.size = desc->m_size;
   st->type.align = desc->m_align;
-  st->type.flagset = desc->m_flagset;
+  st->type.flagset = desc->m_flagset & ~(uint32_t) DDS_TOPIC_CDR_FUNCS;
   st->type.keys.nkeys = desc->m_nkeys;
   st->type.keys.keys = ddsrt_malloc (st->type.keys.nkeys  * sizeof (*st->type.keys.keys));
   for (uint32_t i = 0; i < st->type.keys.nkeys; i++)
     st->type.keys.keys[i] = desc->m_keys[i].m_index;
+  st->type.keynames = ddsrt_malloc (st->type.keys.nkeys * sizeof (*st->type.keynames));
+  for (uint32_t i = 0; i < st->type.keys.nkeys; i++)
+    st->type.keynames[i] = ddsrt_strdup (desc->m_keys[i].m_name);
   st->type.ops.nops = dds_stream_countops (desc->m_ops);
   st->type.ops.ops = ddsrt_memdup (desc->m_ops, st->type.ops.nops * sizeof (*st->type.ops.ops));
+  st->type.cdr_funcs = (desc->m_flagset & DDS_TOPIC_CDR_FUNCS) ? desc->m_cdr_funcs : NULL;
 
   /* Check if topic cannot be optimised (memcpy marshal) */
   if (!(st->type.flagset & DDS_TOPIC_NO_OPTIMIZE)) {
@@ -12,6 +12,7 @@
 #include <assert.h>
 
 #include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/hopscotch.h"
 #include "dds/ddsrt/log.h"
 #include "dds__entity.h"
 #include "dds__participant.h"
@@ -39,12 +40,77 @@ static bool is_triggered (struct dds_entity *e)
   return t;
 }
 
-static dds_return_t dds_waitset_wait_impl (dds_entity_t waitset, dds_attach_t *xs, size_t nxs, dds_time_t abstimeout)
+/* Attachments move between the ranges of ws->entities (see dds_waitset) by swapping them with
+   an element at the boundary of the range, so each state change costs O(1).  Only the observer
+   callback moves attachments into the triggered range: an entity can only become triggered by a
+   status change and that always gets signalled to the observers. */
+
+static void ws_swap (dds_waitset *ws, size_t i, size_t j)
+{
+  dds_attachment * const tmp = ws->entities[i];
+  ws->entities[i] = ws->entities[j];
+  ws->entities[j] = tmp;
+  ws->entities[i]->index = i;
+  ws->entities[j]->index = j;
+}
+
+/* Moves an attachment to the triggered-but-not-reported range, returns true if that range was
+   empty, because only then can there be threads blocked in wait */
+static bool ws_mark_triggered (dds_waitset *ws, dds_attachment *a)
+{
+  const bool was_empty = (ws->nreported == ws->ntriggered);
+  if (a->index >= ws->ntriggered)
+    ws_swap (ws, a->index, ws->ntriggered++);
+  else if (a->index < ws->nreported)
+    ws_swap (ws, a->index, --ws->nreported);
+  return was_empty;
+}
+
+static void ws_mark_untriggered (dds_waitset *ws, dds_attachment *a)
+{
+  assert (a->index < ws->ntriggered);
+  if (a->index < ws->nreported)
+    ws_swap (ws, a->index, --ws->nreported);
+  ws_swap (ws, a->index, --ws->ntriggered);
+}
+
+static void ws_drop_no_longer_triggered (dds_waitset *ws)
+{
+  /* Going backwards means anything swapped into position i has been checked already */
+  for (size_t i = ws->ntriggered; i-- > 0; )
+  {
+    if (!is_triggered (ws->entities[i]->entity))
+      ws_mark_untriggered (ws, ws->entities[i]);
+  }
+}
+
+static uint32_t attachment_hash (const void *va)
+{
+  /* handles are already pseudo-random numbers, so not much point in hashing it again */
+  const dds_attachment *a = va;
+  return (uint32_t) a->handle;
+}
+
+static int attachment_equal (const void *va, const void *vb)
+{
+  const dds_attachment *a = va;
+  const dds_attachment *b = vb;
+  return a->handle == b->handle;
+}
+
+static dds_attachment *ws_lookup (const dds_waitset *ws, dds_entity_t handle)
+{
+  dds_attachment template;
+  template.handle = handle;
+  return ddsrt_hh_lookup (ws->entity_index, &template);
+}
+
+static dds_return_t dds_waitset_wait_impl (dds_entity_t waitset, dds_attach_t *xs, size_t nxs, dds_time_t abstimeout, bool edge)
 {
   dds_waitset *ws;
   dds_return_t ret;
 
-  if ((xs == NULL) != (nxs == 0))
+  if ((xs == NULL) != (nxs == 0) || (edge && xs == NULL))
     return DDS_RETCODE_BAD_PARAMETER;
 
   /* Locking the waitset here will delay a possible deletion until it is
@@ -63,25 +129,31 @@ static dds_return_t dds_waitset_wait_impl (dds_entity_t waitset, dds_attach_t *x
 
   /* Move any previously but no longer triggering entities back to the observed list */
   ddsrt_mutex_lock (&ws->wait_lock);
-  ws->ntriggered = 0;
-  for (size_t i = 0; i < ws->nentities; i++)
+  ws_drop_no_longer_triggered (ws);
+
+  if (!edge)
   {
-    if (is_triggered (ws->entities[i].entity))
-    {
-      dds_attachment tmp = ws->entities[i];
-      ws->entities[i] = ws->entities[ws->ntriggered];
-      ws->entities[ws->ntriggered++] = tmp;
-    }
+    /* Only wait/keep waiting when we have something to observe and there aren't any triggers yet. */
+    while (ws->nentities > 0 && ws->ntriggered == 0 && !dds_handle_is_closed (&ws->m_entity.m_hdllink))
+      if (!ddsrt_cond_waituntil (&ws->wait_cond, &ws->wait_lock, abstimeout))
+        break;
+
+    ret = (int32_t) ws->ntriggered;
+    for (size_t i = 0; i < ws->ntriggered && i < nxs; i++)
+      xs[i] = ws->entities[i]->arg;
+  }
+  else
+  {
+    /* Same, but only for entities that haven't been returned yet since they last triggered */
+    while (ws->nentities > 0 && ws->nreported == ws->ntriggered && !dds_handle_is_closed (&ws->m_entity.m_hdllink))
+      if (!ddsrt_cond_waituntil (&ws->wait_cond, &ws->wait_lock, abstimeout))
+        break;
+
+    size_t n = 0;
+    while (ws->nreported < ws->ntriggered && n < nxs)
+      xs[n++] = ws->entities[ws->nreported++]->arg;
+    ret = (int32_t) n;
   }
-
-  /* Only wait/keep waiting when we have something to observe and there aren't any triggers yet. */
-  while (ws->nentities > 0 && ws->ntriggered == 0 && !dds_handle_is_closed (&ws->m_entity.m_hdllink))
-    if (!ddsrt_cond_waituntil (&ws->wait_cond, &ws->wait_lock, abstimeout))
-      break;
-
-  ret = (int32_t) ws->ntriggered;
-  for (size_t i = 0; i < ws->ntriggered && i < nxs; i++)
-    xs[i] = ws->entities[i].arg;
   ddsrt_mutex_unlock (&ws->wait_lock);
   dds_entity_unpin (&ws->m_entity);
   return ret;
@@ -103,7 +175,7 @@ static void dds_waitset_close (struct dds_entity *e)
   while (ws->nentities > 0)
   {
     dds_entity *observed;
-    if (dds_entity_pin (ws->entities[0].handle, &observed) < 0)
+    if (dds_entity_pin (ws->entities[0]->handle, &observed) < 0)
     {
       /* can't be pinned => being deleted => will be removed from wait set soon enough
        and go through delete_observer (which will trigger the condition variable) */
@@ -115,7 +187,7 @@ static void dds_waitset_close (struct dds_entity *e)
       ddsrt_mutex_unlock (&ws->wait_lock);
       (void) dds_entity_observer_unregister (observed, ws, true);
       ddsrt_mutex_lock (&ws->wait_lock);
-      assert (ws->nentities == 0 || ws->entities[0].entity != observed);
+      assert (ws->nentities == 0 || ws->entities[0]->entity != observed);
       dds_entity_unpin (observed);
     }
   }
@@ -127,6 +199,8 @@ static dds_return_t dds_waitset_delete (struct dds_entity *e)
   dds_waitset *ws = (dds_waitset *) e;
   ddsrt_mutex_destroy (&ws->wait_lock);
   ddsrt_cond_destroy (&ws->wait_cond);
+  assert (ws->nentities == 0);
+  ddsrt_hh_free (ws->entity_index);
   ddsrt_free (ws->entities);
   return DDS_RETCODE_OK;
 }
@@ -175,7 +249,9 @@ dds_entity_t dds_create_waitset (dds_entity_t owner)
   dds_entity_register_child (e, &waitset->m_entity);
   waitset->nentities = 0;
   waitset->ntriggered = 0;
+  waitset->nreported = 0;
   waitset->entities = NULL;
+  waitset->entity_index = ddsrt_hh_new (1, attachment_hash, attachment_equal);
   dds_entity_init_complete (&waitset->m_entity);
   dds_entity_unlock (e);
   dds_entity_unpin_and_drop_ref (&dds_global.m_entity);
@@ -206,7 +282,7 @@ dds_return_t dds_waitset_get_entities (dds_entity_t waitset, dds_entity_t *entit
     if (entities != NULL)
     {
       for (size_t i = 0; i < ws->nentities && i < size; i++)
-        entities[i] = ws->entities[i].handle;
+        entities[i] = ws->entities[i]->handle;
     }
     ret = (int32_t) ws->nentities;
     ddsrt_mutex_unlock (&ws->wait_lock);
@@ -221,19 +297,11 @@ static void dds_waitset_observer (struct dds_waitset *ws, dds_entity_t observed,
   (void) status;
 
   ddsrt_mutex_lock (&ws->wait_lock);
-  /* Move observed entity to triggered list. */
-  size_t i;
-  for (i = 0; i < ws->nentities; i++)
-    if (ws->entities[i].handle == observed)
-      break;
-  if (i < ws->nentities && i >= ws->ntriggered)
-  {
-    dds_attachment tmp = ws->entities[i];
-    ws->entities[i] = ws->entities[ws->ntriggered];
-    ws->entities[ws->ntriggered++] = tmp;
-  }
-  /* Trigger waitset to wake up. */
-  ddsrt_cond_broadcast (&ws->wait_cond);
+  /* Move observed entity to triggered list, waking up the waiting threads only if there
+     can be any: a status change of an entity that already triggered doesn't affect them. */
+  dds_attachment * const a = ws_lookup (ws, observed);
+  if (a != NULL && ws_mark_triggered (ws, a))
+    ddsrt_cond_broadcast (&ws->wait_cond);
   ddsrt_mutex_unlock (&ws->wait_lock);
 }
 
@@ -244,43 +312,35 @@ struct dds_waitset_attach_observer_arg {
 static bool dds_waitset_attach_observer (struct dds_waitset *ws, struct dds_entity *observed, void *varg)
 {
   struct dds_waitset_attach_observer_arg *arg = varg;
+  dds_attachment * const a = ddsrt_malloc (sizeof (*a));
+  a->arg = arg->x;
+  a->entity = observed;
+  a->handle = observed->m_hdllink.hdl;
   ddsrt_mutex_lock (&ws->wait_lock);
   ws->entities = ddsrt_realloc (ws->entities, (ws->nentities + 1) * sizeof (*ws->entities));
-  ws->entities[ws->nentities].arg = arg->x;
-  ws->entities[ws->nentities].entity = observed;
-  ws->entities[ws->nentities].handle = observed->m_hdllink.hdl;
-  ws->nentities++;
-  if (is_triggered (observed))
-  {
-    const size_t i = ws->nentities - 1;
-    dds_attachment tmp = ws->entities[i];
-    ws->entities[i] = ws->entities[ws->ntriggered];
-    ws->entities[ws->ntriggered++] = tmp;
-  }
-  ddsrt_cond_broadcast (&ws->wait_cond);
+  a->index = ws->nentities;
+  ws->entities[ws->nentities++] = a;
+  ddsrt_hh_add (ws->entity_index, a);
+  if (is_triggered (observed) && ws_mark_triggered (ws, a))
+    ddsrt_cond_broadcast (&ws->wait_cond);
   ddsrt_mutex_unlock (&ws->wait_lock);
   return true;
 }
 
 static void dds_waitset_delete_observer (struct dds_waitset *ws, dds_entity_t observed)
 {
-  size_t i;
   ddsrt_mutex_lock (&ws->wait_lock);
-  for (i = 0; i < ws->nentities; i++)
-    if (ws->entities[i].handle == observed)
-      break;
-  if (i < ws->nentities)
+  dds_attachment * const a = ws_lookup (ws, observed);
+  if (a != NULL)
   {
-    if (i < ws->ntriggered)
-    {
-      ws->entities[i] = ws->entities[--ws->ntriggered];
-      ws->entities[ws->ntriggered] = ws->entities[--ws->nentities];
-    }
-    else
-    {
-      ws->entities[i] = ws->entities[--ws->nentities];
-    }
+    if (a->index < ws->ntriggered)
+      ws_mark_untriggered (ws, a);
+    ws_swap (ws, a->index, --ws->nentities);
+    ddsrt_hh_remove (ws->entity_index, a);
+    ddsrt_free (a);
   }
+  /* Always wake up: waiting threads return when the last entity is removed, and
+     closing the waitset waits for entities being deleted */
   ddsrt_cond_broadcast (&ws->wait_cond);
   ddsrt_mutex_unlock (&ws->wait_lock);
 }
@@ -361,18 +421,35 @@ dds_return_t dds_waitset_detach (dds_entity_t waitset, dds_entity_t entity)
   }
 }
 
+static dds_time_t reltime_to_abstime (dds_duration_t reltimeout)
+{
+  assert (reltimeout >= 0);
+  const dds_time_t tnow = dds_time ();
+  return (DDS_INFINITY - reltimeout <= tnow) ? DDS_NEVER : (tnow + reltimeout);
+}
+
 dds_return_t dds_waitset_wait_until (dds_entity_t waitset, dds_attach_t *xs, size_t nxs, dds_time_t abstimeout)
 {
-  return dds_waitset_wait_impl (waitset, xs, nxs, abstimeout);
+  return dds_waitset_wait_impl (waitset, xs, nxs, abstimeout, false);
 }
 
 dds_return_t dds_waitset_wait (dds_entity_t waitset, dds_attach_t *xs, size_t nxs, dds_duration_t reltimeout)
 {
   if (reltimeout < 0)
     return DDS_RETCODE_BAD_PARAMETER;
-  const dds_time_t tnow = dds_time ();
-  const dds_time_t abstimeout = (DDS_INFINITY - reltimeout <= tnow) ? DDS_NEVER : (tnow + reltimeout);
-  return dds_waitset_wait_impl (waitset, xs, nxs, abstimeout);
+  return dds_waitset_wait_impl (waitset, xs, nxs, reltime_to_abstime (reltimeout), false);
+}
+
+dds_return_t dds_waitset_wait_edge_until (dds_entity_t waitset, dds_attach_t *xs, size_t nxs, dds_time_t abstimeout)
+{
+  return dds_waitset_wait_impl (waitset, xs, nxs, abstimeout, true);
+}
+
+dds_return_t dds_waitset_wait_edge (dds_entity_t waitset, dds_attach_t *xs, size_t nxs, dds_duration_t reltimeout)
+{
+  if (reltimeout < 0)
+    return DDS_RETCODE_BAD_PARAMETER;
+  return dds_waitset_wait_impl (waitset, xs, nxs, reltime_to_abstime (reltimeout), true);
 }
 
 dds_return_t dds_waitset_set_trigger (dds_entity_t waitset, bool trigger)
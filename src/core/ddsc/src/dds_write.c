@@ -26,6 +26,9 @@
 #include "dds/ddsi/q_radmin.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 #include "dds/ddsi/ddsi_deliver_locally.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/atomics.h"
 
 #ifdef DDS_HAS_SHM
 #include "dds/ddsi/shm_sync.h"
@@ -115,21 +118,40 @@ dds_return_t dds_loan_sample(dds_entity_t writer, void** sample)
 #endif
 }
 
-dds_return_t dds_write (dds_entity_t writer, const void *data)
+static dds_return_t dds_write_pinned (dds_entity_t writer, const void *data, dds_time_t tstamp)
 {
   dds_return_t ret;
-  dds_writer *wr;
+  dds_entity *e;
 
-  if (data == NULL)
-    return DDS_RETCODE_BAD_PARAMETER;
-
-  if ((ret = dds_writer_lock (writer, &wr)) != DDS_RETCODE_OK)
+  if ((ret = dds_entity_pin (writer, &e)) < 0)
     return ret;
-  ret = dds_write_impl (wr, data, dds_time (), 0);
-  dds_writer_unlock (wr);
+  if (dds_entity_kind (e) != DDS_KIND_WRITER)
+    ret = DDS_RETCODE_ILLEGAL_OPERATION;
+  else
+  {
+    dds_writer * const wr = (dds_writer *) e;
+    /* The write queue orders concurrent writes without needing the entity
+       lock, pinning suffices to keep the writer alive */
+    if (wr->m_queue != NULL)
+      ret = dds_write_impl (wr, data, tstamp, 0);
+    else
+    {
+      ddsrt_mutex_lock (&e->m_mutex);
+      ret = dds_write_impl (wr, data, tstamp, 0);
+      ddsrt_mutex_unlock (&e->m_mutex);
+    }
+  }
+  dds_entity_unpin (e);
   return ret;
 }
 
+dds_return_t dds_write (dds_entity_t writer, const void *data)
+{
+  if (data == NULL)
+    return DDS_RETCODE_BAD_PARAMETER;
+  return dds_write_pinned (writer, data, dds_time ());
+}
+
 dds_return_t dds_writecdr (dds_entity_t writer, struct ddsi_serdata *serdata)
 {
   dds_return_t ret;
@@ -174,17 +196,9 @@ dds_return_t dds_forwardcdr (dds_entity_t writer, struct ddsi_serdata *serdata)
 
 dds_return_t dds_write_ts (dds_entity_t writer, const void *data, dds_time_t timestamp)
 {
-  dds_return_t ret;
-  dds_writer *wr;
-
   if (data == NULL || timestamp < 0)
     return DDS_RETCODE_BAD_PARAMETER;
-
-  if ((ret = dds_writer_lock (writer, &wr)) != DDS_RETCODE_OK)
-    return ret;
-  ret = dds_write_impl (wr, data, timestamp, 0);
-  dds_writer_unlock (wr);
-  return ret;
+  return dds_write_pinned (writer, data, timestamp);
 }
 
 static struct reader *writer_first_in_sync_reader (struct entity_index *entity_index, struct entity_common *wrcmn, ddsrt_avl_iter_t *it)
@@ -270,6 +284,236 @@ static dds_return_t deliver_locally (struct writer *wr, struct ddsi_serdata *pay
   return rc;
 }
 
+static dds_return_t write_sample_and_deliver (struct thread_state1 * const ts1, struct nn_xpack *xp, struct writer *ddsi_wr, struct ddsi_serdata *d, struct ddsi_tkmap_instance *tk, bool flush, bool suppress_local_delivery)
+{
+  dds_return_t ret;
+  int w_rc = write_sample_gc (ts1, xp, ddsi_wr, d, tk);
+  if (w_rc >= 0) {
+    /* Flush out write unless configured to batch */
+    if (flush)
+      nn_xpack_send (xp, false);
+    ret = DDS_RETCODE_OK;
+  } else if (w_rc == DDS_RETCODE_TIMEOUT) {
+    ret = DDS_RETCODE_TIMEOUT;
+  } else if (w_rc == DDS_RETCODE_BAD_PARAMETER) {
+    ret = DDS_RETCODE_ERROR;
+  } else {
+    ret = DDS_RETCODE_ERROR;
+  }
+  if (ret == DDS_RETCODE_OK && !suppress_local_delivery)
+    ret = deliver_locally (ddsi_wr, d, tk);
+  return ret;
+}
+
+/* Write queue: a bounded multi-producer ring in front of the WHC and the
+   transmit path.  A writing thread takes a ticket with an atomic increment
+   and fills the slot for it without locking.  It then tries to become the
+   drainer by setting the "draining" flag: the drainer writes all consecutive
+   filled slots in ticket order (so the DDSI sequence numbers follow the
+   tickets) with a single flush of the queue's xpack at the end.  A thread
+   that finds another one draining needn't do anything but pick up its
+   result once the slot has been written.
+
+   The slot state is the ticket shifted left by 2 with the phase in the low
+   bits: a slot is free for ticket t if it is WRQ_STATE(t, FREE); the
+   writing thread releases it for ticket t + size once it has seen the
+   result.
+
+   The lock and condition variable are only used for blocking when a thread
+   can't make progress, i.e., when another thread is draining or the queue
+   is full.  Every event a blocked thread may be waiting for (the end of a
+   drain, a slot being released) increments "gen" and then only broadcasts
+   if there are waiting threads, so that uncontended writes never touch the
+   lock. */
+#define WRQ_FREE 0u
+#define WRQ_FILLED 1u
+#define WRQ_DONE 2u
+#define WRQ_STATE(t, phase) (((uint32_t) (t) << 2) | (phase))
+
+struct dds_write_queue_slot {
+  ddsrt_atomic_uint32_t state;
+  struct ddsi_serdata *d;
+  struct ddsi_tkmap_instance *tk;
+  dds_return_t ret;
+};
+
+struct dds_write_queue {
+  ddsrt_atomic_uint32_t tail;
+  ddsrt_atomic_uint32_t draining;
+  ddsrt_atomic_uint32_t gen;
+  ddsrt_atomic_uint32_t nwaiting;
+  uint32_t mask;
+  uint32_t head; /* protected by draining */
+  struct nn_xpack *xp; /* protected by draining */
+  ddsrt_mutex_t lock;
+  ddsrt_cond_t cond;
+  struct dds_write_queue_slot slots[];
+};
+
+struct dds_write_queue *dds_write_queue_new (struct nn_xpack *xp, uint32_t size)
+{
+  struct dds_write_queue *q;
+  uint32_t n = 1;
+  while (n < size && n < DDSI_WRITE_QUEUE_SIZE_MAX)
+    n <<= 1;
+  q = ddsrt_malloc (sizeof (*q) + n * sizeof (q->slots[0]));
+  ddsrt_atomic_st32 (&q->tail, 0);
+  ddsrt_atomic_st32 (&q->draining, 0);
+  ddsrt_atomic_st32 (&q->gen, 0);
+  ddsrt_atomic_st32 (&q->nwaiting, 0);
+  q->mask = n - 1;
+  q->head = 0;
+  q->xp = xp;
+  ddsrt_mutex_init (&q->lock);
+  ddsrt_cond_init (&q->cond);
+  for (uint32_t i = 0; i < n; i++)
+  {
+    ddsrt_atomic_st32 (&q->slots[i].state, WRQ_STATE (i, WRQ_FREE));
+    q->slots[i].d = NULL;
+    q->slots[i].tk = NULL;
+    q->slots[i].ret = DDS_RETCODE_OK;
+  }
+  return q;
+}
+
+void dds_write_queue_free (struct dds_write_queue *q)
+{
+  assert (ddsrt_atomic_ld32 (&q->tail) == q->head);
+  assert (ddsrt_atomic_ld32 (&q->draining) == 0);
+  nn_xpack_free (q->xp);
+  ddsrt_cond_destroy (&q->cond);
+  ddsrt_mutex_destroy (&q->lock);
+  ddsrt_free (q);
+}
+
+static void dds_write_queue_signal (struct dds_write_queue *q)
+{
+  ddsrt_atomic_inc32 (&q->gen);
+  ddsrt_atomic_fence ();
+  if (ddsrt_atomic_ld32 (&q->nwaiting) > 0)
+  {
+    ddsrt_mutex_lock (&q->lock);
+    ddsrt_cond_broadcast (&q->cond);
+    ddsrt_mutex_unlock (&q->lock);
+  }
+}
+
+static void dds_write_queue_wait (struct dds_write_queue *q, uint32_t gen)
+{
+  /* the signalling thread increments gen before checking nwaiting, so either
+     it sees this thread waiting, or this thread sees the new gen */
+  ddsrt_mutex_lock (&q->lock);
+  ddsrt_atomic_inc32 (&q->nwaiting);
+  ddsrt_atomic_fence ();
+  while (ddsrt_atomic_ld32 (&q->gen) == gen)
+    ddsrt_cond_wait (&q->cond, &q->lock);
+  ddsrt_atomic_dec32 (&q->nwaiting);
+  ddsrt_mutex_unlock (&q->lock);
+}
+
+static bool dds_write_queue_try_acquire (struct dds_write_queue *q)
+{
+  return ddsrt_atomic_ld32 (&q->draining) == 0 && ddsrt_atomic_cas32 (&q->draining, 0, 1);
+}
+
+static void dds_write_queue_release (struct dds_write_queue *q)
+{
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_st32 (&q->draining, 0);
+  dds_write_queue_signal (q);
+}
+
+void dds_write_queue_flush (struct dds_write_queue *q)
+{
+  uint32_t gen;
+  while (gen = ddsrt_atomic_ld32 (&q->gen), !dds_write_queue_try_acquire (q))
+    dds_write_queue_wait (q, gen);
+  nn_xpack_send (q->xp, true);
+  dds_write_queue_release (q);
+}
+
+static uint32_t dds_write_queue_drain (struct thread_state1 * const ts1, dds_writer *wr, struct dds_write_queue *q)
+{
+  /* bounded by the size of the queue so a thread doesn't get stuck writing
+     on behalf of others for ever */
+  uint32_t n = 0;
+  assert (ddsrt_atomic_ld32 (&q->draining) == 1);
+  while (n <= q->mask)
+  {
+    struct dds_write_queue_slot * const s = &q->slots[q->head & q->mask];
+    if (ddsrt_atomic_ld32 (&s->state) != WRQ_STATE (q->head, WRQ_FILLED))
+      break;
+    ddsrt_atomic_fence_acq ();
+    s->ret = write_sample_and_deliver (ts1, q->xp, wr->m_wr, s->d, s->tk, false, false);
+    ddsrt_atomic_fence_rel ();
+    ddsrt_atomic_st32 (&s->state, WRQ_STATE (q->head, WRQ_DONE));
+    q->head++;
+    n++;
+  }
+  if (n > 0 && !wr->whc_batch)
+    nn_xpack_send (q->xp, false);
+  return n;
+}
+
+static void dds_write_queue_await (struct thread_state1 * const ts1, dds_writer *wr, struct dds_write_queue *q, struct dds_write_queue_slot *s, uint32_t state)
+{
+  /* A slot changes state only when it is drained or released, and both are
+     followed by a signal, so checking the state after reading gen means a
+     change can't be missed.  If draining yields nothing, either the slot at
+     the head hasn't been filled yet and the thread filling it will drain
+     it, or (for a full queue) the owner of the slot has yet to release it:
+     in both cases waiting for a signal is safe. */
+  uint32_t gen = ddsrt_atomic_ld32 (&q->gen);
+  while (ddsrt_atomic_ld32 (&s->state) != state)
+  {
+    if (!dds_write_queue_try_acquire (q))
+      dds_write_queue_wait (q, gen);
+    else
+    {
+      const uint32_t n = dds_write_queue_drain (ts1, wr, q);
+      dds_write_queue_release (q);
+      if (n == 0)
+      {
+        gen = ddsrt_atomic_ld32 (&q->gen);
+        if (ddsrt_atomic_ld32 (&s->state) != state)
+          dds_write_queue_wait (q, gen);
+      }
+    }
+    gen = ddsrt_atomic_ld32 (&q->gen);
+  }
+  ddsrt_atomic_fence_acq ();
+}
+
+static dds_return_t dds_write_queue_write (struct thread_state1 * const ts1, dds_writer *wr, struct ddsi_serdata *d, struct ddsi_tkmap_instance *tk)
+{
+  struct dds_write_queue * const q = wr->m_queue;
+  const uint32_t t = ddsrt_atomic_inc32_ov (&q->tail);
+  struct dds_write_queue_slot * const s = &q->slots[t & q->mask];
+  dds_return_t ret;
+
+  /* if the queue is full, wait for the thread with ticket t - size to
+     release the slot, which it can only do once it has been written */
+  dds_write_queue_await (ts1, wr, q, s, WRQ_STATE (t, WRQ_FREE));
+
+  /* the reference consumed by write_sample_gc is the caller's extra one */
+  s->d = d;
+  s->tk = tk;
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_st32 (&s->state, WRQ_STATE (t, WRQ_FILLED));
+
+  dds_write_queue_await (ts1, wr, q, s, WRQ_STATE (t, WRQ_DONE));
+  ret = s->ret;
+  s->d = NULL;
+  s->tk = NULL;
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_st32 (&s->state, WRQ_STATE (t + q->mask + 1, WRQ_FREE));
+  /* only a thread that found the queue full can be waiting for this */
+  ddsrt_atomic_fence ();
+  if (ddsrt_atomic_ld32 (&q->tail) - t > q->mask)
+    dds_write_queue_signal (q);
+  return ret;
+}
+
 dds_return_t dds_write_impl (dds_writer *wr, const void * data, dds_time_t tstamp, dds_write_action action)
 {
   struct thread_state1 * const ts1 = lookup_thread_state ();
@@ -277,7 +521,6 @@ dds_return_t dds_write_impl (dds_writer *wr, const void * data, dds_time_t tstam
   struct writer *ddsi_wr = wr->m_wr;
   struct ddsi_serdata *d;
   dds_return_t ret = DDS_RETCODE_OK;
-  int w_rc;
 
   if (data == NULL)
     return DDS_RETCODE_BAD_PARAMETER;
@@ -354,22 +597,15 @@ dds_return_t dds_write_impl (dds_writer *wr, const void * data, dds_time_t tstam
 #endif
 
     tk = ddsi_tkmap_lookup_instance_ref (wr->m_entity.m_domain->gv.m_tkmap, d);
-    w_rc = write_sample_gc (ts1, wr->m_xp, ddsi_wr, d, tk);
-
-    if (w_rc >= 0) {
-      /* Flush out write unless configured to batch */
-      if (!wr->whc_batch)
-        nn_xpack_send (wr->m_xp, false);
-      ret = DDS_RETCODE_OK;
-    } else if (w_rc == DDS_RETCODE_TIMEOUT) {
-      ret = DDS_RETCODE_TIMEOUT;
-    } else if (w_rc == DDS_RETCODE_BAD_PARAMETER) {
-      ret = DDS_RETCODE_ERROR;
-    } else {
-      ret = DDS_RETCODE_ERROR;
+    if (wr->m_queue != NULL)
+    {
+      assert (!suppress_local_delivery);
+      ret = dds_write_queue_write (ts1, wr, d, tk);
+    }
+    else
+    {
+      ret = write_sample_and_deliver (ts1, wr->m_xp, ddsi_wr, d, tk, !wr->whc_batch, suppress_local_delivery);
     }
-    if (ret == DDS_RETCODE_OK && !suppress_local_delivery)
-      ret = deliver_locally (ddsi_wr, d, tk);
     ddsi_serdata_unref (d);
     ddsi_tkmap_instance_unref (wr->m_entity.m_domain->gv.m_tkmap, tk);
   }
@@ -507,6 +743,8 @@ void dds_write_flush (dds_entity_t writer)
   {
     thread_state_awake (ts1, &wr->m_entity.m_domain->gv);
     nn_xpack_send (wr->m_xp, true);
+    if (wr->m_queue)
+      dds_write_queue_flush (wr->m_queue);
     thread_state_asleep (ts1);
     dds_writer_unlock (wr);
   }
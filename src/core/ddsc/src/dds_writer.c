@@ -23,6 +23,7 @@
 #include "dds/ddsi/ddsi_entity_index.h"
 #include "dds/ddsi/ddsi_security_omg.h"
 #include "dds__writer.h"
+#include "dds__write.h"
 #include "dds__listener.h"
 #include "dds__init.h"
 #include "dds__publisher.h"
@@ -197,6 +198,8 @@ static void dds_writer_close (dds_entity *e)
   struct thread_state1 * const ts1 = lookup_thread_state ();
   thread_state_awake (ts1, gv);
   nn_xpack_send (wr->m_xp, false);
+  if (wr->m_queue)
+    dds_write_queue_flush (wr->m_queue);
   (void) delete_writer (gv, &e->m_guid);
   thread_state_asleep (ts1);
 
@@ -222,6 +225,8 @@ static dds_return_t dds_writer_delete (dds_entity *e)
   /* FIXME: not freeing WHC here because it is owned by the DDSI entity */
   thread_state_awake (lookup_thread_state (), &e->m_domain->gv);
   nn_xpack_free (wr->m_xp);
+  if (wr->m_queue)
+    dds_write_queue_free (wr->m_queue);
   thread_state_asleep (lookup_thread_state ());
   dds_entity_drop_ref (&wr->m_topic->m_entity);
   return DDS_RETCODE_OK;
@@ -454,6 +459,16 @@ dds_entity_t dds_create_writer (dds_entity_t participant_or_publisher, dds_entit
   }
 #endif
 
+  /* the write queue bypasses the entity lock, which the loans of the
+     shared memory publisher depend on */
+  wr->m_queue = NULL;
+#ifdef DDS_HAS_SHM
+  if (gv->config.write_queue_size > 0 && wr->m_iox_pub == NULL)
+#else
+  if (gv->config.write_queue_size > 0)
+#endif
+    wr->m_queue = dds_write_queue_new (nn_xpack_new (gv, get_bandwidth_limit (wqos->transport_priority), async_mode), gv->config.write_queue_size);
+
   wr->m_entity.m_iid = get_entity_instance_id (&wr->m_entity.m_domain->gv, &wr->m_entity.m_guid);
   dds_entity_register_child (&pub->m_entity, &wr->m_entity);
 
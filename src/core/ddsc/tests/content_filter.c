@@ -0,0 +1,534 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "dds/dds.h"
+#include "dds/ddsc/dds_statistics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/process.h"
+
+#include "test_common.h"
+
+/* Content filters can only refer to key fields, so the test type has a key
+   of every supported kind, with one following a string so that extracting
+   it requires walking the serialized data */
+struct cf_type {
+  int8_t c;
+  uint16_t us;
+  int32_t l;
+  uint64_t ull;
+  double d;
+  char *s;
+  int32_t l2;
+  int32_t v;
+};
+
+static const dds_key_descriptor_t cf_type_keys[] = {
+  { "c", 0 }, { "us", 2 }, { "l", 4 }, { "ull", 6 }, { "d", 8 }, { "s", 10 }, { "l2", 12 }
+};
+
+static const dds_topic_descriptor_t cf_type_desc = {
+  .m_size = sizeof (struct cf_type),
+  .m_align = sizeof (void *),
+  .m_flagset = DDS_TOPIC_NO_OPTIMIZE | DDS_TOPIC_DISABLE_TYPECHECK,
+  .m_nkeys = (uint32_t) (sizeof (cf_type_keys) / sizeof (cf_type_keys[0])),
+  .m_typename = "content_filter_type",
+  .m_keys = cf_type_keys,
+  .m_nops = 9,
+  .m_ops = (const uint32_t[]) {
+    DDS_OP_ADR | DDS_OP_TYPE_1BY | DDS_OP_FLAG_SGN | DDS_OP_FLAG_KEY, offsetof (struct cf_type, c),
+    DDS_OP_ADR | DDS_OP_TYPE_2BY | DDS_OP_FLAG_KEY, offsetof (struct cf_type, us),
+    DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_SGN | DDS_OP_FLAG_KEY, offsetof (struct cf_type, l),
+    DDS_OP_ADR | DDS_OP_TYPE_8BY | DDS_OP_FLAG_KEY, offsetof (struct cf_type, ull),
+    DDS_OP_ADR | DDS_OP_TYPE_8BY | DDS_OP_FLAG_FP | DDS_OP_FLAG_KEY, offsetof (struct cf_type, d),
+    DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (struct cf_type, s),
+    DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_SGN | DDS_OP_FLAG_KEY, offsetof (struct cf_type, l2),
+    DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_SGN, offsetof (struct cf_type, v),
+    DDS_OP_RTS
+  },
+  .m_meta = ""
+};
+
+#define NSAMPLES 10
+
+static void make_sample (struct cf_type *s, char *sbuf, size_t sbufsize, int32_t i)
+{
+  (void) snprintf (sbuf, sbufsize, "s%"PRId32, i);
+  s->c = (int8_t) (i - 5);
+  s->us = (uint16_t) (1000 * i);
+  s->l = i;
+  s->ull = UINT64_MAX - (uint64_t) i;
+  s->d = 0.5 * i;
+  s->s = sbuf;
+  s->l2 = 10 * i;
+  s->v = i;
+}
+
+static dds_entity_t create_filtered_reader (dds_entity_t pp, dds_entity_t tp, const char *expr, uint32_t nparams, const char **params)
+{
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  dds_qset_content_filter (qos, expr, nparams, params);
+  const dds_entity_t rd = dds_create_reader (pp, tp, qos, NULL);
+  dds_delete_qos (qos);
+  return rd;
+}
+
+static uint32_t take_mask (dds_entity_t rd)
+{
+  void *raw[NSAMPLES + 1] = { NULL };
+  dds_sample_info_t si[NSAMPLES + 1];
+  uint32_t mask = 0;
+  int32_t n;
+  while ((n = dds_take (rd, raw, si, NSAMPLES + 1, NSAMPLES + 1)) > 0)
+  {
+    for (int32_t i = 0; i < n; i++)
+    {
+      const struct cf_type *s = raw[i];
+      CU_ASSERT_FATAL (si[i].valid_data);
+      CU_ASSERT_FATAL (s->l >= 0 && s->l < NSAMPLES);
+      CU_ASSERT (!(mask & (1u << s->l)));
+      mask |= 1u << s->l;
+    }
+    (void) dds_return_loan (rd, raw, n);
+  }
+  CU_ASSERT_FATAL (n == 0);
+  return mask;
+}
+
+static bool wait_for_mask (dds_entity_t rd, uint32_t expected)
+{
+  // acknowledgement doesn't imply it has been delivered yet
+  const dds_time_t tend = dds_time () + DDS_SECS (5);
+  uint32_t mask = 0;
+  while ((mask |= take_mask (rd)) != expected && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (10));
+  if (mask != expected)
+    printf ("got %03"PRIx32" expected %03"PRIx32"\n", mask, expected);
+  return mask == expected;
+}
+
+CU_Test (ddsc_content_filter, qos)
+{
+  const char *ps[] = { "1", "'x'" };
+  dds_qos_t *qos = dds_create_qos ();
+  char *expr, **ps1;
+  uint32_t n;
+
+  CU_ASSERT_FATAL (!dds_qget_content_filter (qos, &expr, &n, &ps1));
+  dds_qset_content_filter (qos, "l = %0 OR s = %1", 2, ps);
+  CU_ASSERT_FATAL (dds_qget_content_filter (qos, &expr, &n, &ps1));
+  CU_ASSERT_STRING_EQUAL_FATAL (expr, "l = %0 OR s = %1");
+  CU_ASSERT_FATAL (n == 2);
+  CU_ASSERT_STRING_EQUAL (ps1[0], "1");
+  CU_ASSERT_STRING_EQUAL (ps1[1], "'x'");
+  dds_free (expr);
+  for (uint32_t i = 0; i < n; i++)
+    dds_free (ps1[i]);
+  dds_free (ps1);
+
+  dds_qos_t *qos1 = dds_create_qos ();
+  dds_copy_qos (qos1, qos);
+  CU_ASSERT (dds_qos_equal (qos, qos1));
+  dds_qset_content_filter (qos1, "l = %0 OR s = %1", 1, ps);
+  CU_ASSERT (!dds_qos_equal (qos, qos1));
+  dds_delete_qos (qos1);
+  dds_delete_qos (qos);
+}
+
+CU_Test (ddsc_content_filter, invalid)
+{
+  static const struct { const char *expr; uint32_t nparams; } tests[] = {
+    { "", 0 },
+    { "l", 0 },
+    { "l <", 0 },
+    { "l == 1", 0 },
+    { "l = 1 AND", 0 },
+    { "(l = 1", 0 },
+    { "l = 1)", 0 },
+    { "x = 1", 0 },      /* unknown field */
+    { "v = 1", 0 },      /* not a key field */
+    { "s = 1", 0 },      /* type mismatch */
+    { "l = 's'", 0 },    /* type mismatch */
+    { "l = 'abc", 0 },   /* unterminated string */
+    { "l = %1", 1 }      /* no such parameter */
+  };
+  const char *ps[] = { "1" };
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_content_filter", topicname, sizeof (topicname));
+  const dds_entity_t tp = dds_create_topic (pp, &cf_type_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  for (size_t i = 0; i < sizeof (tests) / sizeof (tests[0]); i++)
+  {
+    const dds_entity_t rd = create_filtered_reader (pp, tp, tests[i].expr, tests[i].nparams, ps);
+    if (rd >= 0)
+      printf ("expression \"%s\" unexpectedly accepted\n", tests[i].expr);
+    CU_ASSERT (rd == DDS_RETCODE_BAD_PARAMETER);
+  }
+  dds_delete (pp);
+}
+
+CU_Test (ddsc_content_filter, local)
+{
+  static const struct { const char *expr; uint32_t nparams; const char *params[2]; uint32_t mask; } tests[] = {
+    { "l < 3", 0, { NULL }, 0x007 },
+    { "c < 0 AND us >= 2000", 0, { NULL }, 0x01c },
+    { "NOT (l = 4) AND l2 > 60", 0, { NULL }, 0x380 },
+    { "ull > 18446744073709551612", 0, { NULL }, 0x007 },
+    { "d = 1.5 OR s = 's7'", 0, { NULL }, 0x088 },
+    { "l2 = %0 OR s = %1", 2, { "20", "s9" }, 0x204 },
+    { "l > -1 AND l2 <> 30", 0, { NULL }, 0x3f7 },
+    { "s >= 's5'", 0, { NULL }, 0x3e0 },
+    { "d < l", 0, { NULL }, 0x3fe },
+    { "l = 1 OR l = 2 AND l2 = 30", 0, { NULL }, 0x002 },
+    { "(l = 1 OR l = 2) AND l2 = 20", 0, { NULL }, 0x004 }
+  };
+  const size_t ntests = sizeof (tests) / sizeof (tests[0]);
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_content_filter", topicname, sizeof (topicname));
+  const dds_entity_t tp = dds_create_topic (pp, &cf_type_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  dds_entity_t rds[sizeof (tests) / sizeof (tests[0])];
+  for (size_t i = 0; i < ntests; i++)
+  {
+    rds[i] = create_filtered_reader (pp, tp, tests[i].expr, tests[i].nparams, (const char **) tests[i].params);
+    CU_ASSERT_FATAL (rds[i] > 0);
+  }
+  const dds_entity_t wr = dds_create_writer (pp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  for (int32_t i = 0; i < NSAMPLES; i++)
+  {
+    struct cf_type s;
+    char sbuf[16];
+    make_sample (&s, sbuf, sizeof (sbuf), i);
+    dds_return_t rc = dds_write (wr, &s);
+    CU_ASSERT_FATAL (rc == 0);
+  }
+  for (size_t i = 0; i < ntests; i++)
+  {
+    const uint32_t mask = take_mask (rds[i]);
+    if (mask != tests[i].mask)
+      printf ("expression \"%s\": got %03"PRIx32" expected %03"PRIx32"\n", tests[i].expr, mask, tests[i].mask);
+    CU_ASSERT (mask == tests[i].mask);
+  }
+  dds_delete (pp);
+}
+
+/* Locating a key that follows members of variable size means skipping over
+   them: an array of bounded strings, a sequence of bounded strings and a
+   sequence of structs that is empty in half the samples */
+struct cf_walk_elem {
+  int32_t x;
+};
+
+struct cf_walk_type {
+  char a[2][5];
+  dds_sequence_t bs;
+  dds_sequence_t ss;
+  int32_t k;
+  int32_t v;
+};
+
+#define CF_WALK_OPS \
+    DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_BST, offsetof (struct cf_walk_type, a), 2, 0, 5, \
+    DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_BST, offsetof (struct cf_walk_type, bs), 5, \
+    DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STU, offsetof (struct cf_walk_type, ss), sizeof (struct cf_walk_elem), (7u << 16u) + 4u, \
+    DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_SGN, offsetof (struct cf_walk_elem, x), \
+    DDS_OP_RTS, \
+    DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_SGN | DDS_OP_FLAG_KEY, offsetof (struct cf_walk_type, k), \
+    DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_SGN, offsetof (struct cf_walk_type, v), \
+    DDS_OP_RTS
+
+static const dds_key_descriptor_t cf_walk_type_keys[] = {
+  { "k", 15 }
+};
+
+static const dds_topic_descriptor_t cf_walk_type_desc = {
+  .m_size = sizeof (struct cf_walk_type),
+  .m_align = sizeof (void *),
+  .m_flagset = DDS_TOPIC_NO_OPTIMIZE | DDS_TOPIC_DISABLE_TYPECHECK,
+  .m_nkeys = (uint32_t) (sizeof (cf_walk_type_keys) / sizeof (cf_walk_type_keys[0])),
+  .m_typename = "content_filter_walk_type",
+  .m_keys = cf_walk_type_keys,
+  .m_nops = 8,
+  .m_ops = (const uint32_t[]) { CF_WALK_OPS },
+  .m_meta = ""
+};
+
+/* Same layout, but with "keys" the filter can't locate in the data: one in
+   the element type of the sequence and one beyond the end of the type */
+static const dds_key_descriptor_t cf_badkey_type_keys[] = {
+  { "k", 15 }, { "x", 12 }, { "far", 100 }
+};
+
+static const dds_topic_descriptor_t cf_badkey_type_desc = {
+  .m_size = sizeof (struct cf_walk_type),
+  .m_align = sizeof (void *),
+  .m_flagset = DDS_TOPIC_NO_OPTIMIZE | DDS_TOPIC_DISABLE_TYPECHECK,
+  .m_nkeys = (uint32_t) (sizeof (cf_badkey_type_keys) / sizeof (cf_badkey_type_keys[0])),
+  .m_typename = "content_filter_badkey_type",
+  .m_keys = cf_badkey_type_keys,
+  .m_nops = 8,
+  .m_ops = (const uint32_t[]) { CF_WALK_OPS },
+  .m_meta = ""
+};
+
+CU_Test (ddsc_content_filter, walk)
+{
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_content_filter", topicname, sizeof (topicname));
+  const dds_entity_t tp = dds_create_topic (pp, &cf_walk_type_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  const dds_entity_t rd = create_filtered_reader (pp, tp, "k >= 3 AND k < 7", 0, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  const dds_entity_t wr = dds_create_writer (pp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  for (int32_t i = 0; i < NSAMPLES; i++)
+  {
+    char bs[3][5] = { "x", "yy", "zzz" };
+    struct cf_walk_elem ss[1] = { { i } };
+    struct cf_walk_type s = {
+      .bs = { ._length = (uint32_t) (i % 3), ._maximum = 3, ._buffer = (uint8_t *) bs },
+      .ss = { ._length = (uint32_t) (i % 2), ._maximum = 1, ._buffer = (uint8_t *) ss },
+      .k = i, .v = i
+    };
+    (void) snprintf (s.a[0], sizeof (s.a[0]), "a%"PRId32, i);
+    (void) snprintf (s.a[1], sizeof (s.a[1]), "bb%"PRId32, i);
+    dds_return_t rc = dds_write (wr, &s);
+    CU_ASSERT_FATAL (rc == 0);
+  }
+
+  void *raw[NSAMPLES + 1] = { NULL };
+  dds_sample_info_t si[NSAMPLES + 1];
+  uint32_t mask = 0;
+  int32_t n = dds_take (rd, raw, si, NSAMPLES + 1, NSAMPLES + 1);
+  CU_ASSERT_FATAL (n >= 0);
+  for (int32_t i = 0; i < n; i++)
+  {
+    const struct cf_walk_type *s = raw[i];
+    CU_ASSERT_FATAL (si[i].valid_data);
+    CU_ASSERT_FATAL (s->k >= 0 && s->k < NSAMPLES);
+    mask |= 1u << s->k;
+  }
+  (void) dds_return_loan (rd, raw, n);
+  CU_ASSERT (mask == 0x078);
+  dds_delete (pp);
+}
+
+CU_Test (ddsc_content_filter, unreachable_key)
+{
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_content_filter", topicname, sizeof (topicname));
+  const dds_entity_t tp = dds_create_topic (pp, &cf_badkey_type_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  dds_entity_t rd;
+  rd = create_filtered_reader (pp, tp, "k = 1", 0, NULL);
+  CU_ASSERT (rd > 0);
+  rd = create_filtered_reader (pp, tp, "x = 1", 0, NULL);
+  CU_ASSERT (rd == DDS_RETCODE_BAD_PARAMETER);
+  rd = create_filtered_reader (pp, tp, "k = 1 OR far = 1", 0, NULL);
+  CU_ASSERT (rd == DDS_RETCODE_BAD_PARAMETER);
+  dds_delete (pp);
+}
+
+/* Domains for pub and sub use a different domain id, but the portgain setting
+ * in configuration is 0, so that both domains will map to the same port number.
+ * This allows to create two domains in a single test process. */
+static void create_domains (dds_entity_t dom[2], dds_entity_t pp[2])
+{
+  const char *config = "\
+${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}\
+<Discovery>\
+  <ExternalDomainId>0</ExternalDomainId>\
+  <Tag>\\${CYCLONEDDS_PID}</Tag>\
+</Discovery>";
+  for (int i = 0; i < 2; i++)
+  {
+    char *conf = ddsrt_expand_envvars (config, (uint32_t) i);
+    dom[i] = dds_create_domain ((dds_domainid_t) i, conf);
+    CU_ASSERT_FATAL (dom[i] > 0);
+    ddsrt_free (conf);
+    pp[i] = dds_create_participant ((dds_domainid_t) i, NULL, NULL);
+    CU_ASSERT_FATAL (pp[i] > 0);
+  }
+}
+
+CU_Test (ddsc_content_filter, remote, .timeout = 20)
+{
+  dds_entity_t dom[2], pp[2];
+  create_domains (dom, pp);
+  const dds_entity_t pub_dom = dom[0], sub_dom = dom[1];
+  const dds_entity_t pub_pp = pp[0], sub_pp = pp[1];
+  char topicname[100];
+  create_unique_topic_name ("ddsc_content_filter", topicname, sizeof (topicname));
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  const dds_entity_t pub_tp = dds_create_topic (pub_pp, &cf_type_desc, topicname, qos, NULL);
+  CU_ASSERT_FATAL (pub_tp > 0);
+  const dds_entity_t sub_tp = dds_create_topic (sub_pp, &cf_type_desc, topicname, qos, NULL);
+  CU_ASSERT_FATAL (sub_tp > 0);
+  const dds_entity_t wr = dds_create_writer (pub_pp, pub_tp, qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  // a filtered and an unfiltered reader on different participants, so that the
+  // filtered one gets its data addressed to it individually
+  const dds_entity_t rd_f = create_filtered_reader (sub_pp, sub_tp, "l < 2 OR l >= 8", 0, NULL);
+  CU_ASSERT_FATAL (rd_f > 0);
+  const dds_entity_t sub_pp2 = dds_create_participant (1, NULL, NULL);
+  CU_ASSERT_FATAL (sub_pp2 > 0);
+  const dds_entity_t sub_tp2 = dds_create_topic (sub_pp2, &cf_type_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (sub_tp2 > 0);
+  const dds_entity_t rd_u = dds_create_reader (sub_pp2, sub_tp2, NULL, NULL);
+  CU_ASSERT_FATAL (rd_u > 0);
+
+  dds_publication_matched_status_t pm;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &pm)) == 0 && pm.current_count < 2)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+  dds_subscription_matched_status_t sm;
+  while ((rc = dds_get_subscription_matched_status (rd_f, &sm)) == 0 && sm.current_count < 1)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+
+  for (int32_t i = 0; i < NSAMPLES; i++)
+  {
+    struct cf_type s;
+    char sbuf[16];
+    make_sample (&s, sbuf, sizeof (sbuf), i);
+    rc = dds_write (wr, &s);
+    CU_ASSERT_FATAL (rc == 0);
+  }
+
+  // the filtered reader must acknowledge everything, including the samples
+  // that were never sent to it
+  rc = dds_wait_for_acks (wr, DDS_SECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+  CU_ASSERT (wait_for_mask (rd_f, 0x303));
+  CU_ASSERT (wait_for_mask (rd_u, 0x3ff));
+
+  rc = dds_delete (pub_dom);
+  CU_ASSERT_FATAL (rc == 0);
+  rc = dds_delete (sub_dom);
+  CU_ASSERT_FATAL (rc == 0);
+}
+
+CU_Test (ddsc_content_filter, remote_filtered_only, .timeout = 30)
+{
+  /* Without an unfiltered reader, the writer's address set is empty and all
+     data goes out individually to the filtered readers.  Those still need
+     heartbeats to learn of samples they weren't sent (or that got lost), or
+     they never acknowledge them. */
+  dds_entity_t dom[2], pp[2];
+  create_domains (dom, pp);
+  char topicname[100];
+  create_unique_topic_name ("ddsc_content_filter", topicname, sizeof (topicname));
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  dds_entity_t tp[2];
+  for (int i = 0; i < 2; i++)
+  {
+    tp[i] = dds_create_topic (pp[i], &cf_type_desc, topicname, qos, NULL);
+    CU_ASSERT_FATAL (tp[i] > 0);
+  }
+  const dds_entity_t wr = dds_create_writer (pp[0], tp[0], qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  dds_delete_qos (qos);
+
+  // two filtered readers in different participants, neither accepting the
+  // last few samples, so those can only be acknowledged after a GAP
+  const dds_entity_t rd_a = create_filtered_reader (pp[1], tp[1], "l < 2", 0, NULL);
+  CU_ASSERT_FATAL (rd_a > 0);
+  const dds_entity_t sub_pp2 = dds_create_participant (1, NULL, NULL);
+  CU_ASSERT_FATAL (sub_pp2 > 0);
+  const dds_entity_t sub_tp2 = dds_create_topic (sub_pp2, &cf_type_desc, topicname, NULL, NULL);
+  CU_ASSERT_FATAL (sub_tp2 > 0);
+  const dds_entity_t rd_b = create_filtered_reader (sub_pp2, sub_tp2, "l >= 4 AND l < 6", 0, NULL);
+  CU_ASSERT_FATAL (rd_b > 0);
+
+  dds_publication_matched_status_t pm;
+  dds_return_t rc;
+  while ((rc = dds_get_publication_matched_status (wr, &pm)) == 0 && pm.current_count < 2)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+  const dds_entity_t rds[] = { rd_a, rd_b };
+  for (int i = 0; i < 2; i++)
+  {
+    dds_subscription_matched_status_t sm;
+    while ((rc = dds_get_subscription_matched_status (rds[i], &sm)) == 0 && sm.current_count < 1)
+      dds_sleepfor (DDS_MSECS (10));
+    CU_ASSERT_FATAL (rc == 0);
+  }
+
+  // samples accepted by neither reader are large, so that transmitting one of
+  // those would be clearly visible in the writer's statistics
+  const uint32_t accepted = 0x033;
+  char large[2000];
+  memset (large, 'x', sizeof (large) - 1);
+  large[sizeof (large) - 1] = 0;
+  // the second round starts when all has been acknowledged and no heartbeats
+  // are scheduled anymore; the final samples are accepted by neither reader,
+  // so they only learn of those from a heartbeat
+  for (int round = 0; round < 2; round++)
+  {
+    if (round > 0)
+      dds_sleepfor (DDS_MSECS (500));
+    for (int32_t i = 0; i < NSAMPLES; i++)
+    {
+      struct cf_type s;
+      char sbuf[16];
+      make_sample (&s, sbuf, sizeof (sbuf), i);
+      if (!(accepted & (1u << i)))
+        s.s = large;
+      rc = dds_write (wr, &s);
+      CU_ASSERT_FATAL (rc == 0);
+    }
+    rc = dds_wait_for_acks (wr, DDS_SECS (10));
+    CU_ASSERT_FATAL (rc == 0);
+    CU_ASSERT (wait_for_mask (rd_a, 0x003));
+    CU_ASSERT (wait_for_mask (rd_b, 0x030));
+  }
+
+  // the readers typically request samples they have not (yet) seen, all of
+  // them if the first heartbeat arrives before the data; only the accepted
+  // ones may be retransmitted, the others are covered by a GAP
+  struct dds_statistics *stat = dds_create_statistics (wr);
+  CU_ASSERT_FATAL (stat != NULL);
+  const struct dds_stat_keyvalue *rexmit_bytes = dds_lookup_statistic (stat, "rexmit_bytes");
+  CU_ASSERT_FATAL (rexmit_bytes != NULL);
+  CU_ASSERT (rexmit_bytes->u.u64 < sizeof (large));
+  dds_delete_statistics (stat);
+
+  for (int i = 0; i < 2; i++)
+  {
+    rc = dds_delete (dom[i]);
+    CU_ASSERT_FATAL (rc == 0);
+  }
+}
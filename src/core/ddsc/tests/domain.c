@@ -18,6 +18,8 @@
 #include "dds/ddsrt/environ.h"
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/string.h"
+#include "dds/ddsrt/process.h"
+#include "dds/ddsrt/bintrace.h"
 #include "dds/ddsi/ddsi_config.h"
 
 CU_Test(ddsc_domain, get_domainid)
@@ -387,3 +389,37 @@ CU_Test(ddsc_domain_create, raw_config)
   ddsrt_free (arg_raw.buf);
 }
 
+
+CU_Test(ddsc_domain_create, raw_config_binary_trace)
+{
+  /* no cfgst for a raw configuration, so deleting the domain must stop the
+     binary trace by itself: "Finis." is the very last thing traced */
+  char tracefile[100];
+  (void) snprintf (tracefile, sizeof (tracefile), "ddsc_domain_bintrace_%"PRIdPID".bin", ddsrt_getpid ());
+  struct ddsi_config config;
+  ddsi_config_init_default (&config);
+  config.tracemask = DDS_LC_CONFIG;
+  config.tracefile = tracefile;
+  config.trace_format = DDSI_TRACE_FORMAT_BINARY;
+  dds_entity_t domain = dds_create_domain_with_rawconfig (1, &config);
+  CU_ASSERT_FATAL (domain > 0);
+  dds_return_t rc = dds_delete (domain);
+  CU_ASSERT_FATAL (rc == 0);
+
+  FILE *bfp = fopen (tracefile, "rb");
+  CU_ASSERT_FATAL (bfp != NULL);
+  FILE *dfp = tmpfile ();
+  CU_ASSERT_FATAL (dfp != NULL);
+  rc = ddsrt_bintrace_decode (dfp, bfp);
+  CU_ASSERT (rc == DDS_RETCODE_OK);
+  rewind (dfp);
+  char line[512];
+  bool finis = false;
+  while (fgets (line, sizeof (line), dfp))
+    if (strstr (line, "Finis.") != NULL)
+      finis = true;
+  CU_ASSERT (finis);
+  fclose (dfp);
+  fclose (bfp);
+  (void) remove (tracefile);
+}
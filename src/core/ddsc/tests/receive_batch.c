@@ -0,0 +1,154 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/string.h"
+
+#include "test_common.h"
+
+#define NKEYS 50
+#define NPERKEY 100
+
+/* Domains for pub and sub use a different domain id, but the portgain setting
+   in configuration is 0, so that both domains will map to the same port number.
+   The receive buffers are kept small, so that a batch never has more than a
+   few slots and regularly doesn't fit in the remaining space of an rbuf, and
+   the receive thread has to switch to a new one with samples still referencing
+   the old one. */
+static const char *config = "\
+${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}\
+<Discovery>\
+  <ExternalDomainId>0</ExternalDomainId>\
+  <Tag>\\${CYCLONEDDS_PID}</Tag>\
+</Discovery>\
+<Sizing>\
+  <ReceiveBufferSize>128 KiB</ReceiveBufferSize>\
+  <ReceiveBufferChunkSize>16 KiB</ReceiveBufferChunkSize>\
+</Sizing>\
+<Compatibility>\
+  <ManySocketsMode>%s</ManySocketsMode>\
+</Compatibility>\
+<Internal>\
+  <ReceiveBatchSize>%d</ReceiveBatchSize>\
+</Internal>";
+
+static void do_exchange (int batch_size, const char *many_sockets_mode)
+{
+  dds_entity_t dom[2], pp[2], tp[2], wr, rd;
+  dds_qos_t *qos;
+  dds_return_t rc;
+  char topicname[100];
+
+  for (int i = 0; i < 2; i++)
+  {
+    char *xconf, *conf;
+    xconf = ddsrt_expand_envvars (config, (uint32_t) i);
+    (void) ddsrt_asprintf (&conf, xconf, many_sockets_mode, batch_size);
+    dom[i] = dds_create_domain ((dds_domainid_t) i, conf);
+    CU_ASSERT_FATAL (dom[i] > 0);
+    ddsrt_free (conf);
+    ddsrt_free (xconf);
+    pp[i] = dds_create_participant ((dds_domainid_t) i, NULL, NULL);
+    CU_ASSERT_FATAL (pp[i] > 0);
+  }
+
+  qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+  dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+  create_unique_topic_name ("ddsc_receive_batch", topicname, sizeof (topicname));
+  for (int i = 0; i < 2; i++)
+  {
+    tp[i] = dds_create_topic (pp[i], &Space_Type1_desc, topicname, qos, NULL);
+    CU_ASSERT_FATAL (tp[i] > 0);
+  }
+  wr = dds_create_writer (pp[0], tp[0], qos, NULL);
+  CU_ASSERT_FATAL (wr > 0);
+  rd = dds_create_reader (pp[1], tp[1], qos, NULL);
+  CU_ASSERT_FATAL (rd > 0);
+  dds_delete_qos (qos);
+
+  dds_publication_matched_status_t pm;
+  while ((rc = dds_get_publication_matched_status (wr, &pm)) == 0 && pm.current_count < 1)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+  dds_subscription_matched_status_t sm;
+  while ((rc = dds_get_subscription_matched_status (rd, &sm)) == 0 && sm.current_count < 1)
+    dds_sleepfor (DDS_MSECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+
+  /* keys interleaved, so that consecutive packets update different instances */
+  for (int32_t j = 0; j < NPERKEY; j++)
+  {
+    for (int32_t k = 0; k < NKEYS; k++)
+    {
+      const Space_Type1 s = { .long_1 = k, .long_2 = j, .long_3 = k * NPERKEY + j };
+      rc = dds_write (wr, &s);
+      CU_ASSERT_FATAL (rc == 0);
+    }
+  }
+  rc = dds_wait_for_acks (wr, DDS_SECS (10));
+  CU_ASSERT_FATAL (rc == 0);
+
+  /* acknowledgement doesn't imply it has been delivered yet */
+  int32_t next[NKEYS] = { 0 };
+  int32_t count = 0;
+  const dds_time_t tend = dds_time () + DDS_SECS (5);
+  while (count < NKEYS * NPERKEY && dds_time () < tend)
+  {
+    void *raw[100] = { NULL };
+    dds_sample_info_t si[100];
+    int32_t n;
+    while ((n = dds_take (rd, raw, si, 100, 100)) > 0)
+    {
+      for (int32_t i = 0; i < n; i++)
+      {
+        const Space_Type1 *s = raw[i];
+        CU_ASSERT_FATAL (si[i].valid_data);
+        CU_ASSERT_FATAL (s->long_1 >= 0 && s->long_1 < NKEYS);
+        CU_ASSERT_FATAL (s->long_2 == next[s->long_1]);
+        CU_ASSERT_FATAL (s->long_3 == s->long_1 * NPERKEY + s->long_2);
+        next[s->long_1]++;
+      }
+      count += n;
+      rc = dds_return_loan (rd, raw, n);
+      CU_ASSERT_FATAL (rc == 0);
+    }
+    CU_ASSERT_FATAL (n == 0);
+    if (count < NKEYS * NPERKEY)
+      dds_sleepfor (DDS_MSECS (10));
+  }
+  if (count != NKEYS * NPERKEY)
+    printf ("received %"PRId32" of %d samples\n", count, NKEYS * NPERKEY);
+  CU_ASSERT (count == NKEYS * NPERKEY);
+
+  for (int i = 0; i < 2; i++)
+  {
+    rc = dds_delete (dom[i]);
+    CU_ASSERT_FATAL (rc == 0);
+  }
+}
+
+CU_Test (ddsc_receive_batch, single_socket, .timeout = 30)
+{
+  do_exchange (16, "single");
+}
+
+CU_Test (ddsc_receive_batch, many_sockets, .timeout = 30)
+{
+  do_exchange (64, "many");
+}
@@ -1108,6 +1108,152 @@ CU_Test(ddsc_waitset_triggering, on_readcondition, .init=ddsc_waitset_attached_i
 
 
 
+/**************************************************************************************************
+ *
+ * These will check the edge-triggered wait.
+ *
+ *************************************************************************************************/
+/*************************************************************************************************/
+CU_Test(ddsc_waitset_wait_edge, invalid_params, .init=ddsc_waitset_basic_init, .fini=ddsc_waitset_basic_fini)
+{
+    dds_attach_t triggered;
+    dds_return_t ret;
+
+    /* unlike the level-triggered wait, the edge-triggered one needs an array to consume the events */
+    ret = dds_waitset_wait_edge(waitset, NULL, 0, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_BAD_PARAMETER);
+    ret = dds_waitset_wait_edge(waitset, &triggered, 0, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_BAD_PARAMETER);
+    ret = dds_waitset_wait_edge(waitset, &triggered, 1, -1);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_BAD_PARAMETER);
+    ret = dds_waitset_wait_edge_until(waitset, NULL, 0, dds_time());
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_BAD_PARAMETER);
+    ret = dds_waitset_wait_edge(participant, &triggered, 1, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_ILLEGAL_OPERATION);
+}
+/*************************************************************************************************/
+
+/*************************************************************************************************/
+CU_Test(ddsc_waitset_wait_edge, guardconditions, .init=ddsc_waitset_basic_init, .fini=ddsc_waitset_basic_fini)
+{
+#define N_GCONDS 100
+    dds_entity_t gconds[N_GCONDS];
+    dds_attach_t triggered[N_GCONDS];
+    dds_return_t ret;
+
+    for (int i = 0; i < N_GCONDS; i++)
+    {
+        gconds[i] = dds_create_guardcondition(participant);
+        CU_ASSERT_FATAL(gconds[i] > 0);
+        ret = dds_waitset_attach(waitset, gconds[i], i);
+        CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    }
+
+    /* nothing triggered yet */
+    ret = dds_waitset_wait_edge(waitset, triggered, N_GCONDS, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+    /* trigger every 10th: edge-triggered wait returns them once, level-triggered for as long
+       as they remain triggered */
+    for (int i = 0; i < N_GCONDS; i += 10)
+    {
+        ret = dds_set_guardcondition(gconds[i], true);
+        CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    }
+    ret = dds_waitset_wait_edge(waitset, triggered, N_GCONDS, DDS_SECS(1));
+    CU_ASSERT_EQUAL_FATAL(ret, N_GCONDS / 10);
+    for (int i = 0; i < ret; i++)
+        CU_ASSERT_FATAL((triggered[i] % 10) == 0);
+    ret = dds_waitset_wait_edge(waitset, triggered, N_GCONDS, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 0);
+    ret = dds_waitset_wait(waitset, triggered, N_GCONDS, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, N_GCONDS / 10);
+
+    /* resetting and setting a guard condition makes it trigger anew */
+    ret = dds_set_guardcondition(gconds[20], false);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    ret = dds_waitset_wait(waitset, triggered, N_GCONDS, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, N_GCONDS / 10 - 1);
+    ret = dds_set_guardcondition(gconds[20], true);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    ret = dds_waitset_wait_edge(waitset, triggered, N_GCONDS, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 1);
+    CU_ASSERT_EQUAL_FATAL(triggered[0], 20);
+
+    /* entities that don't fit in the array get returned by the next call */
+    for (int i = 0; i < N_GCONDS; i++)
+    {
+        ret = dds_set_guardcondition(gconds[i], false);
+        CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    }
+    ret = dds_waitset_wait(waitset, triggered, N_GCONDS, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 0);
+    for (int i = 0; i < 5; i++)
+    {
+        ret = dds_set_guardcondition(gconds[i], true);
+        CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    }
+    ret = dds_waitset_wait_edge(waitset, triggered, 3, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 3);
+    ret = dds_waitset_wait_edge(waitset, triggered + 3, 3, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 2);
+    uint32_t seen = 0;
+    for (int i = 0; i < 5; i++)
+        seen |= 1u << triggered[i];
+    CU_ASSERT_EQUAL_FATAL(seen, 0x1f);
+
+    /* detaching a triggered entity */
+    ret = dds_waitset_detach(waitset, gconds[0]);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    ret = dds_waitset_wait(waitset, triggered, N_GCONDS, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 4);
+
+    for (int i = 0; i < N_GCONDS; i++)
+    {
+        ret = dds_delete(gconds[i]);
+        CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    }
+    ret = dds_waitset_get_entities(waitset, NULL, 0);
+    CU_ASSERT_EQUAL_FATAL(ret, 0);
+#undef N_GCONDS
+}
+/*************************************************************************************************/
+
+/*************************************************************************************************/
+CU_Test(ddsc_waitset_wait_edge, reader, .init=ddsc_waitset_attached_init, .fini=ddsc_waitset_attached_fini)
+{
+    RoundTripModule_DataType sample;
+    dds_attach_t triggered;
+    dds_return_t ret;
+
+    memset(&sample, 0, sizeof(RoundTripModule_DataType));
+    ret = dds_set_status_mask(reader, DDS_DATA_AVAILABLE_STATUS);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+
+    ret = dds_write(writer, &sample);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    ret = dds_waitset_wait_edge(waitset, &triggered, 1, DDS_SECS(1));
+    CU_ASSERT_EQUAL_FATAL(ret, 1);
+    CU_ASSERT_EQUAL_FATAL(reader, (dds_entity_t)(intptr_t)triggered);
+
+    /* still triggered, but nothing new */
+    ret = dds_waitset_wait_edge(waitset, &triggered, 1, DDS_MSECS(10));
+    CU_ASSERT_EQUAL_FATAL(ret, 0);
+    ret = dds_triggered(reader);
+    CU_ASSERT_FATAL(ret > 0);
+
+    /* new data while the status is still set is a new event */
+    ret = dds_write(writer, &sample);
+    CU_ASSERT_EQUAL_FATAL(ret, DDS_RETCODE_OK);
+    ret = dds_waitset_wait_edge(waitset, &triggered, 1, DDS_SECS(1));
+    CU_ASSERT_EQUAL_FATAL(ret, 1);
+    CU_ASSERT_EQUAL_FATAL(reader, (dds_entity_t)(intptr_t)triggered);
+}
+/*************************************************************************************************/
+
+
+
+
 
 #endif
 
@@ -16,6 +16,12 @@
 #include "RoundTrip.h"
 #include "Space.h"
 #include "dds/ddsrt/misc.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/threads.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsi/q_thread.h"
 
 /* Tests in this file only concern themselves with very basic api tests of
    dds_write and dds_write_ts */
@@ -158,3 +164,211 @@ CU_Test(ddsc_write, simpletypes)
     dds_delete(top);
     dds_delete(par);
 }
+
+#define WRQ_NTHREADS 4
+#define WRQ_NSAMPLES 2000
+
+struct write_queue_arg {
+    dds_entity_t wr;
+    int32_t key;
+    dds_return_t rc;
+};
+
+static uint32_t write_queue_thread (void *varg)
+{
+    struct write_queue_arg *arg = varg;
+    Space_Type1 sample = { .long_1 = arg->key, .long_2 = 0, .long_3 = 0 };
+    arg->rc = DDS_RETCODE_OK;
+    for (int32_t i = 0; i < WRQ_NSAMPLES && arg->rc == DDS_RETCODE_OK; i++)
+    {
+        sample.long_2 = i;
+        arg->rc = dds_write (arg->wr, &sample);
+    }
+    return 0;
+}
+
+CU_Test(ddsc_write, write_queue_concurrent)
+{
+    /* a write queue smaller than the number of writing threads, so that
+       threads regularly have to wait for a slot */
+    const char *config = "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Internal><WriteQueueSize>2</WriteQueueSize></Internal>";
+    char *conf = ddsrt_expand_envvars (config, 0);
+    const dds_entity_t dom = dds_create_domain (0, conf);
+    CU_ASSERT_FATAL (dom > 0);
+    ddsrt_free (conf);
+    const dds_entity_t pp = dds_create_participant (0, NULL, NULL);
+    CU_ASSERT_FATAL (pp > 0);
+    dds_qos_t *qos = dds_create_qos ();
+    dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+    dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+    const dds_entity_t tp = dds_create_topic (pp, &Space_Type1_desc, "write_queue", qos, NULL);
+    CU_ASSERT_FATAL (tp > 0);
+    const dds_entity_t rd = dds_create_reader (pp, tp, qos, NULL);
+    CU_ASSERT_FATAL (rd > 0);
+    const dds_entity_t wr = dds_create_writer (pp, tp, qos, NULL);
+    CU_ASSERT_FATAL (wr > 0);
+    dds_delete_qos (qos);
+
+    struct write_queue_arg args[WRQ_NTHREADS];
+    ddsrt_thread_t tids[WRQ_NTHREADS];
+    ddsrt_threadattr_t tattr;
+    ddsrt_threadattr_init (&tattr);
+    for (int32_t i = 0; i < WRQ_NTHREADS; i++)
+    {
+        args[i].wr = wr;
+        args[i].key = i;
+        dds_return_t rc = ddsrt_thread_create (&tids[i], "wrq", &tattr, write_queue_thread, &args[i]);
+        CU_ASSERT_FATAL (rc == 0);
+    }
+    for (int32_t i = 0; i < WRQ_NTHREADS; i++)
+    {
+        (void) ddsrt_thread_join (tids[i], NULL);
+        CU_ASSERT_EQUAL (args[i].rc, DDS_RETCODE_OK);
+    }
+
+    /* every sample must have arrived, in the order each thread wrote them */
+    int32_t next[WRQ_NTHREADS] = { 0 };
+    Space_Type1 sample;
+    void *ptr = &sample;
+    dds_sample_info_t si;
+    dds_return_t n;
+    while ((n = dds_take (rd, &ptr, &si, 1, 1)) > 0)
+    {
+        CU_ASSERT_FATAL (sample.long_1 >= 0 && sample.long_1 < WRQ_NTHREADS);
+        CU_ASSERT_EQUAL (sample.long_2, next[sample.long_1]);
+        next[sample.long_1] = sample.long_2 + 1;
+    }
+    CU_ASSERT_EQUAL (n, 0);
+    for (int32_t i = 0; i < WRQ_NTHREADS; i++)
+        CU_ASSERT_EQUAL (next[i], WRQ_NSAMPLES);
+
+    dds_delete (dom);
+}
+
+CU_Test(ddsc_write, write_queue_size_limit)
+{
+    const char *config = "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Internal><WriteQueueSize>%u</WriteQueueSize></Internal>";
+    const uint32_t sizes[] = { 65536, 65537 };
+    for (size_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+        char *xconf, *conf;
+        xconf = ddsrt_expand_envvars (config, 0);
+        (void) ddsrt_asprintf (&conf, xconf, sizes[i]);
+        const dds_entity_t dom = dds_create_domain (0, conf);
+        ddsrt_free (conf);
+        ddsrt_free (xconf);
+        if (sizes[i] <= 65536)
+        {
+            CU_ASSERT_FATAL (dom > 0);
+            dds_delete (dom);
+        }
+        else
+        {
+            CU_ASSERT (dom < 0);
+        }
+    }
+}
+
+#define SLT_NTHREADS 10000
+#define SLT_WAVE 250
+
+struct short_lived_arg {
+    dds_entity_t wr;
+    int32_t key;
+    dds_return_t rc;
+    ddsrt_mutex_t *lock;
+    ddsrt_cond_t *cond;
+    uint32_t *nwritten;
+    bool *release;
+};
+
+static uint32_t short_lived_thread (void *varg)
+{
+    struct short_lived_arg *arg = varg;
+    Space_Type1 sample = { .long_1 = arg->key, .long_2 = 0, .long_3 = 0 };
+    arg->rc = dds_write (arg->wr, &sample);
+    /* stay around until all threads in this wave have written, so that
+       they all hold a thread state slot at the same time */
+    ddsrt_mutex_lock (arg->lock);
+    (*arg->nwritten)++;
+    ddsrt_cond_broadcast (arg->cond);
+    while (!*arg->release)
+        ddsrt_cond_wait (arg->cond, arg->lock);
+    ddsrt_mutex_unlock (arg->lock);
+    return 0;
+}
+
+CU_Test(ddsc_write, many_short_lived_threads, .timeout = 120)
+{
+    /* many more application threads than there used to be thread state
+       slots, in waves that are each larger than that as well; the slots
+       of threads that terminated must get reused */
+    const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+    CU_ASSERT_FATAL (pp > 0);
+    dds_qos_t *qos = dds_create_qos ();
+    dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_INFINITY);
+    dds_qset_history (qos, DDS_HISTORY_KEEP_ALL, 0);
+    const dds_entity_t tp = dds_create_topic (pp, &Space_Type1_desc, "short_lived_threads", qos, NULL);
+    CU_ASSERT_FATAL (tp > 0);
+    const dds_entity_t rd = dds_create_reader (pp, tp, qos, NULL);
+    CU_ASSERT_FATAL (rd > 0);
+    const dds_entity_t wr = dds_create_writer (pp, tp, qos, NULL);
+    CU_ASSERT_FATAL (wr > 0);
+    dds_delete_qos (qos);
+
+    ddsrt_mutex_t lock;
+    ddsrt_cond_t cond;
+    ddsrt_mutex_init (&lock);
+    ddsrt_cond_init (&cond);
+    struct short_lived_arg *args = ddsrt_malloc (SLT_WAVE * sizeof (*args));
+    ddsrt_thread_t tids[SLT_WAVE];
+    ddsrt_threadattr_t tattr;
+    ddsrt_threadattr_init (&tattr);
+    for (int32_t base = 0; base < SLT_NTHREADS; base += SLT_WAVE)
+    {
+        uint32_t nwritten = 0;
+        bool release = false;
+        for (int32_t i = 0; i < SLT_WAVE; i++)
+        {
+            args[i] = (struct short_lived_arg) {
+                .wr = wr, .key = base + i, .rc = DDS_RETCODE_ERROR,
+                .lock = &lock, .cond = &cond, .nwritten = &nwritten, .release = &release
+            };
+            dds_return_t rc = ddsrt_thread_create (&tids[i], "slt", &tattr, short_lived_thread, &args[i]);
+            CU_ASSERT_FATAL (rc == 0);
+        }
+        ddsrt_mutex_lock (&lock);
+        while (nwritten < SLT_WAVE)
+            ddsrt_cond_wait (&cond, &lock);
+        release = true;
+        ddsrt_cond_broadcast (&cond);
+        ddsrt_mutex_unlock (&lock);
+        for (int32_t i = 0; i < SLT_WAVE; i++)
+        {
+            (void) ddsrt_thread_join (tids[i], NULL);
+            CU_ASSERT_EQUAL (args[i].rc, DDS_RETCODE_OK);
+        }
+    }
+    ddsrt_free (args);
+    ddsrt_cond_destroy (&cond);
+    ddsrt_mutex_destroy (&lock);
+
+    /* slots get reused: one wave plus Cyclone's own threads, rounded up */
+    CU_ASSERT (ddsrt_atomic_ld32 (&thread_states.nthreads) <= SLT_WAVE + 2 * THREAD_STATE_BATCH);
+
+    /* every thread's sample must have arrived */
+    int32_t count = 0;
+    Space_Type1 sample;
+    void *ptr = &sample;
+    dds_sample_info_t si;
+    dds_return_t n;
+    while ((n = dds_take (rd, &ptr, &si, 1, 1)) > 0)
+    {
+        CU_ASSERT_FATAL (sample.long_1 >= 0 && sample.long_1 < SLT_NTHREADS);
+        count++;
+    }
+    CU_ASSERT_EQUAL (n, 0);
+    CU_ASSERT_EQUAL (count, SLT_NTHREADS);
+
+    dds_delete (pp);
+}
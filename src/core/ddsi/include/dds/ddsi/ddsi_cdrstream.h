@@ -12,6 +12,9 @@
 #ifndef DDSI_CDRSTREAM_H
 #define DDSI_CDRSTREAM_H
 
+#include <assert.h>
+#include <string.h>
+
 #include "dds/ddsi/ddsi_serdata.h"
 #include "dds/ddsi/ddsi_serdata_default.h"
 
@@ -39,9 +42,146 @@ DDS_EXPORT void dds_ostream_init (dds_ostream_t * __restrict st, uint32_t size);
 DDS_EXPORT void dds_ostream_fini (dds_ostream_t * __restrict st);
 DDS_EXPORT void dds_ostreamBE_init (dds_ostreamBE_t * __restrict st, uint32_t size);
 DDS_EXPORT void dds_ostreamBE_fini (dds_ostreamBE_t * __restrict st);
+DDS_EXPORT void dds_ostream_grow (dds_ostream_t * __restrict st, uint32_t size);
+
+/* Stream primitives, shared by the interpreter and the type-specific
+   (de)serializers that idlc optionally generates (see dds_topic_cdr_funcs_t) */
+
+DDS_EXPORT inline void dds_cdr_resize (dds_ostream_t * __restrict s, uint32_t l)
+{
+  if (s->m_size < l + s->m_index)
+    dds_ostream_grow (s, l);
+}
+
+DDS_EXPORT inline void dds_cdr_alignto (dds_istream_t * __restrict s, uint32_t a)
+{
+  s->m_index = (s->m_index + a - 1) & ~(a - 1);
+  assert (s->m_index < s->m_size);
+}
+
+DDS_EXPORT inline uint32_t dds_cdr_alignto_clear_and_resize (dds_ostream_t * __restrict s, uint32_t a, uint32_t extra)
+{
+  const uint32_t m = s->m_index % a;
+  if (m == 0)
+  {
+    dds_cdr_resize (s, extra);
+    return 0;
+  }
+  else
+  {
+    const uint32_t pad = a - m;
+    dds_cdr_resize (s, pad + extra);
+    for (uint32_t i = 0; i < pad; i++)
+      s->m_buffer[s->m_index++] = 0;
+    return pad;
+  }
+}
+
+DDS_EXPORT inline uint8_t dds_is_get1 (dds_istream_t * __restrict s)
+{
+  assert (s->m_index < s->m_size);
+  uint8_t v = *(s->m_buffer + s->m_index);
+  s->m_index++;
+  return v;
+}
+
+DDS_EXPORT inline uint16_t dds_is_get2 (dds_istream_t * __restrict s)
+{
+  dds_cdr_alignto (s, 2);
+  uint16_t v = * ((uint16_t *) (s->m_buffer + s->m_index));
+  s->m_index += 2;
+  return v;
+}
+
+DDS_EXPORT inline uint32_t dds_is_get4 (dds_istream_t * __restrict s)
+{
+  dds_cdr_alignto (s, 4);
+  uint32_t v = * ((uint32_t *) (s->m_buffer + s->m_index));
+  s->m_index += 4;
+  return v;
+}
+
+DDS_EXPORT inline uint64_t dds_is_get8 (dds_istream_t * __restrict s)
+{
+  dds_cdr_alignto (s, 8);
+  uint64_t v = * ((uint64_t *) (s->m_buffer + s->m_index));
+  s->m_index += 8;
+  return v;
+}
+
+DDS_EXPORT inline void dds_is_get_bytes (dds_istream_t * __restrict s, void * __restrict b, uint32_t num, uint32_t elem_size)
+{
+  dds_cdr_alignto (s, elem_size);
+  memcpy (b, s->m_buffer + s->m_index, num * elem_size);
+  s->m_index += num * elem_size;
+}
+
+DDS_EXPORT inline void dds_os_put1 (dds_ostream_t * __restrict s, uint8_t v)
+{
+  dds_cdr_resize (s, 1);
+  *((uint8_t *) (s->m_buffer + s->m_index)) = v;
+  s->m_index += 1;
+}
+
+DDS_EXPORT inline void dds_os_put2 (dds_ostream_t * __restrict s, uint16_t v)
+{
+  dds_cdr_alignto_clear_and_resize (s, 2, 2);
+  *((uint16_t *) (s->m_buffer + s->m_index)) = v;
+  s->m_index += 2;
+}
+
+DDS_EXPORT inline void dds_os_put4 (dds_ostream_t * __restrict s, uint32_t v)
+{
+  dds_cdr_alignto_clear_and_resize (s, 4, 4);
+  *((uint32_t *) (s->m_buffer + s->m_index)) = v;
+  s->m_index += 4;
+}
+
+DDS_EXPORT inline void dds_os_put8 (dds_ostream_t * __restrict s, uint64_t v)
+{
+  dds_cdr_alignto_clear_and_resize (s, 8, 8);
+  *((uint64_t *) (s->m_buffer + s->m_index)) = v;
+  s->m_index += 8;
+}
+
+DDS_EXPORT inline void dds_os_put_bytes (dds_ostream_t * __restrict s, const void * __restrict b, uint32_t l)
+{
+  dds_cdr_resize (s, l);
+  memcpy (s->m_buffer + s->m_index, b, l);
+  s->m_index += l;
+}
+
+DDS_EXPORT inline void dds_os_put_bytes_aligned (dds_ostream_t * __restrict s, const void * __restrict b, uint32_t n, uint32_t a)
+{
+  const uint32_t l = n * a;
+  dds_cdr_alignto_clear_and_resize (s, a, l);
+  memcpy (s->m_buffer + s->m_index, b, l);
+  s->m_index += l;
+}
+
+DDS_EXPORT void dds_stream_write_string (dds_ostream_t * __restrict os, const char * __restrict val);
+DDS_EXPORT char *dds_stream_reuse_string (dds_istream_t * __restrict is, char * __restrict str);
+DDS_EXPORT void dds_stream_reuse_string_bound (dds_istream_t * __restrict is, char * __restrict str, const uint32_t bound);
+DDS_EXPORT void dds_stream_skip_forward (dds_istream_t * __restrict is, uint32_t len, const uint32_t elem_size);
+DDS_EXPORT void dds_stream_skip_string (dds_istream_t * __restrict is);
+DDS_EXPORT void dds_stream_realloc_sequence_buffer_if_needed (dds_sequence_t * __restrict seq, uint32_t num, uint32_t elem_size, bool init);
+
+DDS_EXPORT bool dds_stream_normalize_uint8 (uint32_t *off, uint32_t size);
+DDS_EXPORT bool dds_stream_normalize_uint16 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap);
+DDS_EXPORT bool dds_stream_normalize_uint32 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap);
+DDS_EXPORT bool dds_stream_normalize_uint64 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap);
+DDS_EXPORT bool dds_stream_read_and_normalize_uint32 (uint32_t * __restrict val, char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap);
+DDS_EXPORT bool dds_stream_normalize_string (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, size_t maxsz);
+DDS_EXPORT bool dds_stream_normalize_primarray (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t num, enum dds_stream_typecode type);
+DDS_EXPORT bool dds_stream_normalize_uni_disc (uint32_t * __restrict val, char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, enum dds_stream_typecode disctype);
 
 bool dds_stream_normalize (void * __restrict data, uint32_t size, bool bswap, const struct ddsi_sertype_default * __restrict type, bool just_key);
 
+/* Validates native-endian CDR (the first "size" bytes of the concatenation of iov[0 .. niov-1],
+   not including the CDR header) exactly like dds_stream_normalize, but without touching the
+   input, and sets kh to the key hash dds_stream_extract_keyhash would compute for it */
+bool dds_stream_validate_iov_native (uint32_t niov, const ddsrt_iovec_t *iov, uint32_t size, dds_keyhash_t * __restrict kh, const struct ddsi_sertype_default * __restrict type);
+
 void dds_stream_write_sample (dds_ostream_t * __restrict os, const void * __restrict data, const struct ddsi_sertype_default * __restrict type);
 void dds_stream_read_sample (dds_istream_t * __restrict is, void * __restrict data, const struct ddsi_sertype_default * __restrict type);
 void dds_stream_free_sample (void *data, const uint32_t * ops);
@@ -56,6 +196,11 @@ void dds_ostreamBE_add_to_serdata_default (dds_ostreamBE_t * __restrict s, struc
 
 void dds_stream_write_key (dds_ostream_t * __restrict os, const char * __restrict sample, const struct ddsi_sertype_default * __restrict type);
 void dds_stream_write_keyBE (dds_ostreamBE_t * __restrict os, const char * __restrict sample, const struct ddsi_sertype_default * __restrict type);
+/* Skips the member described by the ADR instruction at ops, returns the next instruction */
+DDS_EXPORT const uint32_t *dds_stream_skip_adr (dds_istream_t * __restrict is, const uint32_t * __restrict ops);
+/* Returns the instruction following the ADR instruction at ops without looking at the data,
+   or a null pointer if it is not a member that can be skipped */
+const uint32_t *dds_stream_skip_adr_insns (const uint32_t * __restrict ops);
 void dds_stream_extract_key_from_data (dds_istream_t * __restrict is, dds_ostream_t * __restrict os, const struct ddsi_sertype_default * __restrict type);
 void dds_stream_extract_keyBE_from_data (dds_istream_t * __restrict is, dds_ostreamBE_t * __restrict os, const struct ddsi_sertype_default * __restrict type);
 void dds_stream_extract_keyhash (dds_istream_t * __restrict is, dds_keyhash_t * __restrict kh, const struct ddsi_sertype_default * __restrict type, const bool just_key);
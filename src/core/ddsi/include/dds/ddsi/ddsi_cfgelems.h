@@ -1022,6 +1022,19 @@ static struct cfgelem internal_cfgelems[] = {
       "expressed in samples. Once a delivery queue is full, incoming samples "
       "destined for that queue are dropped until space becomes available "
       "again.</p>")),
+  INT("DeliveryQueuePoolSize", NULL, 1, "1",
+    MEMBER(delivery_queue_pool_size),
+    FUNCTIONS(0, uf_delivery_queue_pool_size, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the number of delivery queues (and delivery "
+      "threads) for application data received from remote writers, with a "
+      "maximum of 32. Topics are assigned to a queue by hashing the topic "
+      "name, so that data for different topics can be delivered to the "
+      "readers in parallel while all data of a single writer is still "
+      "delivered in order. The first queue is handled by thread "
+      "<code>dq.user</code>, the others by <code>dq.user1</code>, "
+      "<code>dq.user2</code>, and so on.</p>"),
+    RANGE("1;32")),
   INT("PrimaryReorderMaxSamples", NULL, 1, "128",
     MEMBER(primary_reorder_maxsamples),
     FUNCTIONS(0, uf_uint, 0, pf_uint),
@@ -1254,6 +1267,22 @@ static struct cfgelem internal_cfgelems[] = {
       "scheduled exactly, whereas a value of 10ms would mean that events are "
       "rounded up to the nearest 10 milliseconds.</p>"),
     UNIT("duration")),
+  ENUM("EventQueue", NULL, 1, "heap",
+    MEMBER(xevent_queue_kind),
+    FUNCTIONS(0, uf_xevent_queue_kind, 0, pf_xevent_queue_kind),
+    DESCRIPTION(
+      "<p>This element selects the data structure used for keeping the "
+      "timed events (heartbeats, acknowledgements, discovery messages "
+      "and so on) of the event queues. Possible values are:</p>\n"
+      "<ul><li><i>heap</i>: a priority queue, events are handled at exactly "
+      "the scheduled time;</li>\n"
+      "<li><i>wheel</i>: a hierarchical timing wheel with constant-time "
+      "insertion and rescheduling, events are handled at the first tick of "
+      "the wheel at or after the scheduled time, the wheel has a "
+      "granularity of Internal/ScheduleTimeRounding or 1ms if that is "
+      "0.</li></ul>\n"
+      "<p>The default is <i>heap</i>.</p>"),
+    VALUES("heap","wheel")),
 #ifdef DDS_HAS_BANDWIDTH_LIMITING
   STRING("AuxiliaryBandwidthLimit", NULL, 1, "inf",
     MEMBER(auxiliary_bandwidth_limit),
@@ -1335,6 +1364,20 @@ static struct cfgelem internal_cfgelems[] = {
       "the application may have to use the dds_write_flush function to "
       "ensure that all samples are written.</p>"
     )),
+  INT("WriteQueueSize", NULL, 1, "0",
+    MEMBER(write_queue_size),
+    FUNCTIONS(0, uf_write_queue_size, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element enables a per-writer queue for application writes "
+      "with the given number of entries (rounded up to a power of two, at "
+      "most 65536). Threads writing concurrently to the same writer "
+      "serialize their samples in parallel and take a ticket in the queue "
+      "without locking, and whichever of them finds no other thread "
+      "draining the queue inserts all queued samples in the write cache in "
+      "ticket order and transmits them as a single batch. Sequence numbers "
+      "are still assigned by the writer one sample at a time. The value 0 "
+      "disables the queue.</p>"),
+    RANGE("0;65536")),
   BOOL("LivelinessMonitoring", liveliness_monitoring_attrs, 1, "false",
     MEMBER(liveliness_monitoring),
     FUNCTIONS(0, uf_boolean, 0, pf_boolean),
@@ -1402,6 +1445,31 @@ static struct cfgelem internal_cfgelems[] = {
     "transport (e.g., UDP) and ManySocketsMode not set to single (the "
     "default).</p>"),
     VALUES("false","true","default")),
+  INT("ReceiveBatchSize", NULL, 1, "1",
+    MEMBER(recv_batch_size),
+    FUNCTIONS(0, uf_recv_batch_size, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the maximum number of packets a receive thread "
+      "reads from a socket in a single system call, for transports that "
+      "support it (currently UDP on Linux). The packets are read directly "
+      "into consecutive blocks of the receive buffer, each the size of "
+      "Sizing/ReceiveBufferChunkSize, and so the effective batch size is "
+      "also limited by Sizing/ReceiveBufferSize. A value of 1 reads one "
+      "packet at a time.</p>"),
+    RANGE("1;64")),
+  INT("UnicastReceiveShards", NULL, 1, "1",
+    MEMBER(recv_shards),
+    FUNCTIONS(0, uf_recv_shards, 0, pf_uint),
+    DESCRIPTION(
+      "<p>This element sets the number of sockets, each with its own receive "
+      "thread, that share the unicast data port. Incoming packets are "
+      "distributed over the sockets based on the GUID prefix of the sending "
+      "participant, so the messages from any one participant are always "
+      "processed in order by the same thread. It only has an effect for UDP "
+      "on Linux with Compatibility/ManySocketsMode set to \"single\" and "
+      "Internal/MultipleReceiveThreads enabled; in other cases a single "
+      "socket is used.</p>"),
+    RANGE("1;8")),
   GROUP("ControlTopic", control_topic_cfgelems, control_topic_cfgattrs, 1,
     NOMEMBER,
     NOFUNCTIONS,
@@ -1457,6 +1525,28 @@ static struct cfgelem sizing_cfgelems[] = {
       "shrunk immediately after processing a message, or freed "
       "straightaway.</p>"),
     UNIT("memsize")),
+  STRING("ReceiveBufferReferenceThreshold", NULL, 1, "0 B",
+    MEMBER(rbuf_ref_threshold),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element specifies the minimum size of a received sample for "
+      "it to be kept in the receive buffers instead of being copied, in "
+      "which case the copy is deferred until the data is first accessed "
+      "(and avoided altogether if the sample is dropped before that). Only "
+      "data in the native byte order qualifies. A value of 0 disables "
+      "it.</p>"),
+    UNIT("memsize")),
+  STRING("ReceiveBufferReferenceMaxPinned", NULL, 1, "16 MiB",
+    MEMBER(rbuf_ref_max_pinned),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the maximum total size of the receive buffers "
+      "that may be kept alive by samples referencing them (see "
+      "Sizing/ReceiveBufferReferenceThreshold). A referenced sample, "
+      "however small, prevents the entire receive buffer it is in (of "
+      "Sizing/ReceiveBufferSize bytes) from being freed; beyond this limit "
+      "samples are copied.</p>"),
+    UNIT("memsize")),
   END_MARKER
 };
 
@@ -1909,6 +1999,34 @@ static struct cfgelem tracing_cfgelems[] = {
       "existing log file. The default is to create a new log file each time, "
       "which is generally the best option if a detailed log is generated.</p>"
     )),
+  ENUM("OutputFormat", NULL, 1, "text",
+    MEMBER(trace_format),
+    FUNCTIONS(0, uf_trace_format, 0, pf_trace_format),
+    DESCRIPTION(
+      "<p>This option specifies the format of the trace written to "
+      "Tracing/OutputFile:</p>\n"
+      "<ul><li><i>text</i>: each message is formatted and written to the "
+      "file immediately;</li>\n"
+      "<li><i>binary</i>: messages are stored unformatted in a buffer per "
+      "thread and written to the file periodically by a background thread. "
+      "This is much cheaper, but if a thread's buffer is full, messages are "
+      "dropped. The trace is converted to text using the "
+      "<i>decode-bintrace</i> tool on a machine with the same byte order. "
+      "Messages in the trace categories are never passed to a trace sink "
+      "installed by the application.</li></ul>\n"
+      "<p>The binary format can not be written to <i>stdout</i> or "
+      "<i>stderr</i>.</p>"),
+    VALUES("text","binary")),
+  STRING("BinaryBufferSize", NULL, 1, "256 KiB",
+    MEMBER(trace_binary_buffer_size),
+    FUNCTIONS(0, uf_memsize, 0, pf_memsize),
+    DESCRIPTION(
+      "<p>This element sets the size of the per-thread buffers used when "
+      "Tracing/OutputFormat is <i>binary</i>, rounded up to a power of two "
+      "and at least 8 KiB. The buffers are emptied every 10ms, if a thread "
+      "traces more than this amount of data in that time, messages will be "
+      "dropped.</p>"),
+    UNIT("memsize")),
   STRING("PacketCaptureFile", NULL, 1, "",
     MEMBER(pcap_file),
     FUNCTIONS(0, uf_string, ff_free, pf_string),
@@ -0,0 +1,74 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#ifndef DDSI_CFILTER_H
+#define DDSI_CFILTER_H
+
+#include <stdbool.h>
+
+#include "dds/export.h"
+#include "dds/ddsrt/retcode.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+struct ddsi_sertype;
+struct ddsi_serdata;
+
+/* Content filter compiled for a specific (default) sertype.  Filter
+   expressions are a subset of the SQL-like syntax of DDS content-filtered
+   topics:
+
+     expr    ::= expr OR expr | expr AND expr | NOT expr | '(' expr ')'
+               | operand relop operand
+     relop   ::= '=' | '<>' | '!=' | '<' | '<=' | '>' | '>='
+     operand ::= fieldname | integer | float | 'string' | TRUE | FALSE | %n
+
+   where field names are restricted to the key fields of the type and %n
+   refers to the n-th parameter, which itself is parsed as a literal (or
+   taken as a string if it isn't one).  The expression is translated into
+   a small stack program operating directly on the serialized data, which
+   allows the writer to evaluate it for each matched proxy reader without
+   deserializing samples. */
+struct ddsi_cfilter;
+
+/** @brief Compiles a content filter expression for a sertype
+ *
+ * @param[out] filter   compiled filter (only set on success)
+ * @param[in] type      sertype, must be a default sertype with key names
+ * @param[in] expr      filter expression
+ * @param[in] nparams   number of parameters
+ * @param[in] params    parameter values, referenced as %0 .. %(nparams-1)
+ *
+ * @returns a DDS_RETCODE_OK if successful, otherwise an error code
+ *
+ * @retval DDS_RETCODE_OK                 success
+ * @retval DDS_RETCODE_BAD_PARAMETER      syntax error, unknown field, type mismatch or
+ *                                        field that can't be located in the data
+ * @retval DDS_RETCODE_UNSUPPORTED        type or field not supported for filtering
+ */
+DDS_EXPORT dds_return_t ddsi_cfilter_compile (struct ddsi_cfilter **filter, const struct ddsi_sertype *type, const char *expr, uint32_t nparams, char * const *params);
+
+DDS_EXPORT void ddsi_cfilter_free (struct ddsi_cfilter *filter);
+
+/** @brief Evaluates a compiled filter on a sample
+ *
+ * Samples that do not carry data (dispose, unregister) and samples in a
+ * representation the filter can't interpret are always accepted.
+ */
+DDS_EXPORT bool ddsi_cfilter_accepts (const struct ddsi_cfilter *filter, const struct ddsi_serdata *sd);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSI_CFILTER_H */
@@ -54,6 +54,16 @@ enum ddsi_retransmit_merging {
   DDSI_REXMIT_MERGE_ALWAYS
 };
 
+enum ddsi_xevent_queue_kind {
+  DDSI_XEVQ_HEAP,
+  DDSI_XEVQ_WHEEL
+};
+
+enum ddsi_trace_format {
+  DDSI_TRACE_FORMAT_TEXT,
+  DDSI_TRACE_FORMAT_BINARY
+};
+
 enum ddsi_boolean_default {
   DDSI_BOOLDEF_DEFAULT,
   DDSI_BOOLDEF_FALSE,
@@ -75,6 +85,9 @@ enum ddsi_shm_loglevel {
 #define DDSI_PARTICIPANT_INDEX_AUTO -1
 #define DDSI_PARTICIPANT_INDEX_NONE -2
 
+#define DDSI_WRITE_QUEUE_SIZE_MAX 65536u
+#define DDSI_DELIVERY_QUEUE_POOL_SIZE_MAX 32u
+
 /* ddsi_config_listelem must be an overlay for all used listelem types */
 struct ddsi_config_listelem {
   struct ddsi_config_listelem *next;
@@ -235,6 +248,8 @@ struct ddsi_config_ssl_min_version {
 #define DDSI_XCHECK_RHC 2u
 #define DDSI_XCHECK_XEV 4u
 
+struct ddsrt_bintrace;
+
 struct ddsi_config
 {
   int valid;
@@ -247,8 +262,11 @@ struct ddsi_config
   char *externalAddressString;
   char *externalMaskString;
   FILE *tracefp;
+  struct ddsrt_bintrace *tracebin;
   char *tracefile;
   int tracingAppendToFile;
+  enum ddsi_trace_format trace_format;
+  uint32_t trace_binary_buffer_size;
   uint32_t allowMulticast;
   int prefer_multicast;
   enum ddsi_transport_selector transport_selector;
@@ -280,11 +298,14 @@ struct ddsi_config
   int prioritize_retransmit;
   enum ddsi_boolean_default multiple_recv_threads;
   unsigned recv_thread_stop_maxretries;
+  uint32_t recv_batch_size;
+  uint32_t recv_shards;
 
   unsigned primary_reorder_maxsamples;
   unsigned secondary_reorder_maxsamples;
 
   unsigned delivery_queue_maxsamples;
+  uint32_t delivery_queue_pool_size;
 
   uint16_t fragment_size;
   uint32_t max_msg_size;
@@ -337,6 +358,8 @@ struct ddsi_config
   int xmit_lossiness;           /**<< fraction of packets to drop on xmit, in units of 1e-3 */
   uint32_t rmsg_chunk_size;          /**<< size of a chunk in the receive buffer */
   uint32_t rbuf_size;                /* << size of a single receiver buffer */
+  uint32_t rbuf_ref_threshold;       /* << minimum sample size for referencing the receive buffer, 0 = never */
+  uint32_t rbuf_ref_max_pinned;      /* << maximum number of bytes pinned by samples referencing receive buffers */
   enum ddsi_besmode besmode;
   int meas_hb_to_ack_latency;
   int unicast_response_to_spdp_messages;
@@ -346,6 +369,7 @@ struct ddsi_config
   /* Write cache */
 
   int whc_batch;
+  uint32_t write_queue_size;
   uint32_t whc_lowwater_mark;
   uint32_t whc_highwater_mark;
   struct ddsi_config_maybe_uint32 whc_init_highwater_mark;
@@ -364,6 +388,7 @@ struct ddsi_config
   int64_t nack_delay;
   int64_t preemptive_ack_delay;
   int64_t schedule_time_rounding;
+  enum ddsi_xevent_queue_kind xevent_queue_kind;
   int64_t auto_resched_nack_delay;
   int64_t ds_grace_period;
 #ifdef DDS_HAS_BANDWIDTH_LIMITING
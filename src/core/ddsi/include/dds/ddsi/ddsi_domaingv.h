@@ -38,6 +38,7 @@ struct nn_dqueue;
 struct nn_reorder;
 struct nn_defrag;
 struct addrset;
+struct wraddrset_cache;
 struct xeventq;
 struct gcreq_queue;
 struct entity_index;
@@ -77,6 +78,7 @@ struct recv_thread_arg {
     struct {
       const ddsi_locator_t *loc;
       struct ddsi_tran_conn *conn;
+      uint32_t shard; /* index in data_conn_uc_shards if conn is one of them, else 0 */
     } single;
     struct {
       os_sockWaitset ws;
@@ -124,6 +126,13 @@ struct ddsi_domaingv {
   struct ddsi_tran_conn * disc_conn_uc;
   struct ddsi_tran_conn * data_conn_uc;
 
+  /* Unicast data sockets sharing data_conn_uc's port using SO_REUSEPORT,
+     each served by its own receive thread; data_conn_uc_shards[0] is an
+     alias for data_conn_uc, n_recv_shards = 1 if sharding is not in use. */
+#define MAX_RECV_SHARDS 8 /* = DDSI_TRAN_RECV_SHARDS_MAX */
+  uint32_t n_recv_shards;
+  struct ddsi_tran_conn * data_conn_uc_shards[MAX_RECV_SHARDS];
+
   /* Connection used for all output (for connectionless transports), this
      used to simply be data_conn_uc, but:
 
@@ -159,6 +168,10 @@ struct ddsi_domaingv {
      used to notify them. */
   ddsrt_atomic_uint32_t participant_set_generation;
 
+  /* Source of connection serial numbers, which the receive threads use to
+     tell new connections from old ones with the same socket. */
+  ddsrt_atomic_uint32_t conn_serial;
+
   /* nparticipants is used primarily for limiting the number of active
      participants, but also during shutdown to determine when it is
      safe to stop the GC thread. */
@@ -219,7 +232,7 @@ struct ddsi_domaingv {
      trigger socket.) Receive buffer pool is per receive thread,
      it is only a global variable because it needs to be freed way later
      than the receive thread itself terminates */
-#define MAX_RECV_THREADS 3
+#define MAX_RECV_THREADS (3 + MAX_RECV_SHARDS - 1)
   uint32_t n_recv_threads;
   struct recv_thread {
     const char *name;
@@ -282,8 +295,10 @@ struct ddsi_domaingv {
   uint32_t networkQueueId;
   struct thread_state1 *channel_reader_ts;
 
-  /* Application data gets its own delivery queue */
-  struct nn_dqueue *user_dqueue;
+  /* Application data gets its own delivery queues, topics are hashed
+     onto them (Internal/DeliveryQueuePoolSize) */
+  uint32_t n_user_dqueues;
+  struct nn_dqueue **user_dqueues;
 #endif
 
   /* Transmit side: pools for the serializer & transmit messages and a
@@ -318,6 +333,18 @@ struct ddsi_domaingv {
   bool sendq_running;
   ddsrt_mutex_t sendq_running_lock;
 
+  /* Packets sent to multiple destinations in a single system call
+     (sendmmsg) are counted here: xmit_batch_calls is the number of
+     such calls, xmit_batch_msgs the number of packets sent by them,
+     the difference is the number of system calls saved. */
+  ddsrt_atomic_uint64_t xmit_batch_calls;
+  ddsrt_atomic_uint64_t xmit_batch_msgs;
+
+  /* Total size of the receive buffers kept alive by serdatas that
+     reference their payload there rather than having it copied out,
+     bounded by config.rbuf_ref_max_pinned */
+  ddsrt_atomic_uint32_t rbuf_ref_pinned;
+
   /* File for dumping captured packets, NULL if disabled */
   FILE *pcap_fp;
   ddsrt_mutex_t pcap_lock;
@@ -329,6 +356,9 @@ struct ddsi_domaingv {
   ddsrt_mutex_t sertypes_lock;
   struct ddsrt_hh *sertypes;
 
+  /* Cache of writer address sets, see ddsi_wraddrset.c */
+  struct wraddrset_cache *wraddrset_cache;
+
 #ifdef DDS_HAS_TYPE_DISCOVERY
   ddsrt_mutex_t tl_admin_lock;
   struct ddsrt_hh *tl_admin;
@@ -50,6 +50,17 @@ struct entidx_enum
 #endif
 };
 
+struct entidx_enum_builtin
+{
+  struct entity_index *entidx;
+  enum entity_kind kind;
+  ddsi_entityid_t entityid;
+  struct entity_common *cur;
+#ifndef NDEBUG
+  vtime_t vtime;
+#endif
+};
+
 /* Readers & writers are both in a GUID- and in a GID-keyed table. If
    they are in the GID-based one, they are also in the GUID-based one,
    but not the way around, for two reasons:
@@ -122,6 +133,13 @@ void *entidx_enum_next_max (struct entidx_enum *st, const struct match_entities_
 void *entidx_enum_next (struct entidx_enum *st) ddsrt_nonnull_all;
 void entidx_enum_fini (struct entidx_enum *st) ddsrt_nonnull_all;
 
+/* Enumerates all endpoints of the specified kind with the specified builtin
+   entity id, i.e., the instances of that builtin endpoint in all (proxy)
+   participants that have it */
+void entidx_enum_builtin_init (struct entidx_enum_builtin *st, const struct entity_index *ei, enum entity_kind kind, ddsi_entityid_t entityid) ddsrt_nonnull_all;
+void *entidx_enum_builtin_next (struct entidx_enum_builtin *st) ddsrt_nonnull_all;
+void entidx_enum_builtin_fini (struct entidx_enum_builtin *st) ddsrt_nonnull_all;
+
 void entidx_enum_writer_init (struct entidx_enum_writer *st, const struct entity_index *ei) ddsrt_nonnull_all;
 void entidx_enum_reader_init (struct entidx_enum_reader *st, const struct entity_index *ei) ddsrt_nonnull_all;
 void entidx_enum_proxy_writer_init (struct entidx_enum_proxy_writer *st, const struct entity_index *ei) ddsrt_nonnull_all;
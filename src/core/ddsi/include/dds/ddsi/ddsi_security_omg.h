@@ -1069,6 +1069,61 @@ decode_SecPrefix(
  */
 nn_rtps_msg_state_t decode_rtps_message(struct thread_state1 * const ts1, struct ddsi_domaingv *gv, struct nn_rmsg **rmsg, Header_t **hdr, unsigned char **buff, ssize_t *sz, struct nn_rbufpool *rbpool, bool isstream);
 
+/**
+ * @brief Encode an RTPS message for secure sending.
+ *
+ * The encoded message does not depend on the connection or destination
+ * address unless dst_one is set, so it can be encoded once and then be
+ * sent to any number of addresses using secure_conn_write_encoded.
+ *
+ * @param[in]     niov          Number of io vectors.
+ * @param[in]     iov           Array of io vectors.
+ * @param[in]     stream        Is it for a stream connection (2nd iov is the MsgLen submessage)?
+ * @param[in]     dst_one       Is there only one specific destination?
+ * @param[in]     sec_info      Security information for handles.
+ * @param[out]    dst_buf       Encoded message, to be freed by the caller.
+ * @param[out]    dst_len       Size of the encoded message.
+ *
+ * @returns bool
+ * @retval true   Encoding succeeded.
+ * @retval false  Encoding failed.
+ */
+bool
+secure_conn_encode(
+    const struct ddsi_domaingv *gv,
+    size_t niov,
+    const ddsrt_iovec_t *iov,
+    bool stream,
+    bool dst_one,
+    const nn_msg_sec_info_t *sec_info,
+    unsigned char **dst_buf,
+    size_t *dst_len);
+
+/**
+ * @brief Send an RTPS message encoded by secure_conn_encode.
+ *
+ * @param[in]     conn          Connection to use.
+ * @param[in]     dst           Possible destination information.
+ * @param[in]     buf           Encoded message.
+ * @param[in]     len           Size of the encoded message.
+ * @param[in]     flags         Connection write flags.
+ * @param[in,out] msg_len       Submessage containing length.
+ * @param[in]     conn_write_cb Function to call to do the actual writing.
+ *
+ * @returns ssize_t
+ * @retval negative/zero    Something went wrong.
+ * @retval positive         Secure writing succeeded.
+ */
+ssize_t
+secure_conn_write_encoded(
+    ddsi_tran_conn_t conn,
+    const ddsi_locator_t *dst,
+    const unsigned char *buf,
+    size_t len,
+    uint32_t flags,
+    MsgLen_t *msg_len,
+    ddsi_tran_write_fn_t conn_write_cb);
+
 /**
  * @brief Send the RTPS message securely.
  *
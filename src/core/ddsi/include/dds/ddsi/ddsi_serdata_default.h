@@ -42,6 +42,10 @@ struct serdatapool {
   struct nn_freelist freelist;
 };
 
+/* Received payload not yet copied out of the receive buffers, see
+   Sizing/ReceiveBufferReferenceThreshold */
+struct serdata_default_pinned;
+
 typedef struct dds_keyhash {
   unsigned char m_hash [16]; /* Key hash value. Also possibly key. Suitably aligned for accessing as uint32_t's */
   unsigned m_set : 1;        /* has it been initialised? */
@@ -68,6 +72,7 @@ typedef struct dds_keyhash {
   DDSI_SERDATA_DEFAULT_DEBUG_FIELDS   \
   dds_keyhash_t keyhash;              \
   struct serdatapool *serpool;        \
+  struct serdata_default_pinned *pinned; \
   struct ddsi_serdata_default *next /* in pool->freelist */
 #define DDSI_SERDATA_DEFAULT_POSTPAD  \
   struct CDRHeader hdr;               \
@@ -117,6 +122,12 @@ struct ddsi_sertype_default_desc {
   uint32_t flagset; /* Flags */
   ddsi_sertype_default_desc_key_seq_t keys;
   ddsi_sertype_default_desc_op_seq_t ops;
+  /* Not part of the type definition (not serialized, ignored in comparisons),
+     optional generated (de)serialisers equivalent to ops, or NULL */
+  const struct dds_topic_cdr_funcs *cdr_funcs;
+  /* Not part of the type definition either: names of the key fields
+     (nkeys entries) for resolving content filter expressions, or NULL */
+  char **keynames;
 };
 
 struct ddsi_sertype_default {
@@ -148,6 +159,10 @@ extern DDS_EXPORT const struct ddsi_serdata_ops ddsi_serdata_ops_cdr_nokey;
 struct serdatapool * ddsi_serdatapool_new (void);
 void ddsi_serdatapool_free (struct serdatapool * pool);
 
+/* Returns d with the payload copied out of the receive buffers it may still
+   be referencing, for operations that interpret the data directly */
+const struct ddsi_serdata_default *ddsi_serdata_default_unpin (const struct ddsi_serdata *d);
+
 #if defined (__cplusplus)
 }
 #endif
@@ -20,9 +20,11 @@ extern "C" {
 
 struct reader;
 struct writer;
+struct ddsi_domaingv;
 
 void ddsi_get_writer_stats (struct writer *wr, uint64_t * __restrict rexmit_bytes, uint32_t * __restrict throttle_count, uint64_t * __restrict time_throttled, uint64_t * __restrict time_retransmit);
 void ddsi_get_reader_stats (struct reader *rd, uint64_t * __restrict discarded_bytes);
+void ddsi_get_xmit_batch_stats (const struct ddsi_domaingv *gv, uint64_t * __restrict calls, uint64_t * __restrict msgs);
 
 #if defined (__cplusplus)
 }
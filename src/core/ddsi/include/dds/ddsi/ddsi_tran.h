@@ -35,6 +35,14 @@ struct ddsi_domaingv;
 
 #define DDSI_TRAN_ON_CONNECT 0x0001
 
+/* Maximum number of messages in a single batched read */
+
+#define DDSI_TRAN_READ_BATCH_MAX 64
+#define DDSI_TRAN_WRITE_BATCH_MAX 64
+
+/* Maximum number of unicast sockets sharing a port (RECV_UC_SHARD) */
+#define DDSI_TRAN_RECV_SHARDS_MAX 8
+
 /* Core types */
 
 typedef struct ddsi_tran_base * ddsi_tran_base_t;
@@ -43,10 +51,21 @@ typedef struct ddsi_tran_listener * ddsi_tran_listener_t;
 typedef struct ddsi_tran_factory * ddsi_tran_factory_t;
 typedef struct ddsi_tran_qos ddsi_tran_qos_t;
 
+/* Descriptor for one message in a batched read: buf/len describe the buffer on input,
+   len is set to the number of bytes received and srcloc to the source address on output */
+
+struct ddsi_tran_read_batch_msg {
+  unsigned char *buf;
+  size_t len;
+  ddsi_locator_t srcloc;
+};
+
 /* Function pointer types */
 
 typedef ssize_t (*ddsi_tran_read_fn_t) (ddsi_tran_conn_t, unsigned char *, size_t, bool, ddsi_locator_t *);
+typedef ssize_t (*ddsi_tran_read_batch_fn_t) (ddsi_tran_conn_t, size_t, struct ddsi_tran_read_batch_msg *);
 typedef ssize_t (*ddsi_tran_write_fn_t) (ddsi_tran_conn_t, const ddsi_locator_t *, size_t, const ddsrt_iovec_t *, uint32_t);
+typedef ssize_t (*ddsi_tran_write_batch_fn_t) (ddsi_tran_conn_t, size_t, const ddsi_locator_t *, size_t, const ddsrt_iovec_t *, uint32_t);
 typedef int (*ddsi_tran_locator_fn_t) (ddsi_tran_factory_t, ddsi_tran_base_t, ddsi_locator_t *);
 typedef bool (*ddsi_tran_supports_fn_t) (const struct ddsi_tran_factory *, int32_t);
 typedef ddsrt_socket_t (*ddsi_tran_handle_fn_t) (ddsi_tran_base_t);
@@ -113,7 +132,11 @@ struct ddsi_tran_conn
   /* Functions */
 
   ddsi_tran_read_fn_t m_read_fn;
+  ddsi_tran_read_batch_fn_t m_read_batch_fn; /* optional, NULL if not supported */
   ddsi_tran_write_fn_t m_write_fn;
+  ddsi_tran_write_batch_fn_t m_write_batch_fn; /* optional, NULL if not supported; sends the same
+                                                  message to all destinations, returns the number of
+                                                  destinations it was sent to or -1 on failure */
   ddsi_tran_peer_locator_fn_t m_peer_locator_fn;
   ddsi_tran_disable_multiplexing_fn_t m_disable_multiplexing_fn;
   ddsi_tran_locator_fn_t m_locator_fn;
@@ -125,6 +148,7 @@ struct ddsi_tran_conn
   bool m_stream;
   bool m_closed;
   ddsrt_atomic_uint32_t m_count;
+  uint32_t m_serial; /* unlike the socket and the address, not reused after the connection is freed */
 
   /* Relationships */
 
@@ -216,7 +240,8 @@ struct ddsi_tran_factory
 enum ddsi_tran_qos_purpose {
   DDSI_TRAN_QOS_XMIT,
   DDSI_TRAN_QOS_RECV_UC,
-  DDSI_TRAN_QOS_RECV_MC
+  DDSI_TRAN_QOS_RECV_MC,
+  DDSI_TRAN_QOS_RECV_UC_SHARD /* one of m_nshards unicast sockets sharing a port, created in order */
 };
 
 struct ddsi_tran_qos
@@ -224,6 +249,7 @@ struct ddsi_tran_qos
   enum ddsi_tran_qos_purpose m_purpose;
   int m_diffserv;
   struct nn_interface *m_interface; // only for purpose = XMIT
+  uint32_t m_nshards; // only for purpose = RECV_UC_SHARD
 };
 
 void ddsi_tran_factories_fini (struct ddsi_domaingv *gv);
@@ -279,6 +305,18 @@ inline ssize_t ddsi_conn_write (ddsi_tran_conn_t conn, const ddsi_locator_t *dst
 inline ssize_t ddsi_conn_read (ddsi_tran_conn_t conn, unsigned char * buf, size_t len, bool allow_spurious, ddsi_locator_t *srcloc) {
   return conn->m_closed ? -1 : conn->m_read_fn (conn, buf, len, allow_spurious, srcloc);
 }
+inline bool ddsi_conn_supports_write_batch (const struct ddsi_tran_conn *conn) {
+  return conn->m_write_batch_fn != NULL;
+}
+inline ssize_t ddsi_conn_write_batch (ddsi_tran_conn_t conn, size_t ndst, const ddsi_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags) {
+  return conn->m_closed ? -1 : (conn->m_write_batch_fn) (conn, ndst, dst, niov, iov, flags);
+}
+inline bool ddsi_conn_supports_read_batch (const struct ddsi_tran_conn *conn) {
+  return conn->m_read_batch_fn != NULL;
+}
+inline ssize_t ddsi_conn_read_batch (ddsi_tran_conn_t conn, size_t nmsgs, struct ddsi_tran_read_batch_msg *msgs) {
+  return conn->m_closed ? -1 : conn->m_read_batch_fn (conn, nmsgs, msgs);
+}
 bool ddsi_conn_peer_locator (ddsi_tran_conn_t conn, ddsi_locator_t * loc);
 void ddsi_conn_disable_multiplexing (ddsi_tran_conn_t conn);
 void ddsi_conn_add_ref (ddsi_tran_conn_t conn);
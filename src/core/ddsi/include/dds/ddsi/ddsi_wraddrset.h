@@ -21,8 +21,23 @@ extern "C" {
 
 struct addrset;
 struct writer;
+struct proxy_reader;
+struct ddsi_domaingv;
 
-struct addrset *compute_writer_addrset (const struct writer *wr);
+void wraddrset_cache_init (struct ddsi_domaingv *gv);
+void wraddrset_cache_fini (struct ddsi_domaingv *gv);
+
+/* Computes the address set for the writer from scratch (but possibly taking
+   it from the cache) and sets up the state for incremental updates, the
+   writer lock must be held */
+struct addrset *compute_writer_addrset (struct writer *wr);
+
+/* Incremental updates for matching/unmatching a proxy reader, these return a
+   new reference to the updated address set, or NULL if a full recomputation
+   is required.  The writer lock must be held. */
+struct addrset *writer_addrset_add_reader (struct writer *wr, const struct proxy_reader *prd);
+struct addrset *writer_addrset_remove_reader (struct writer *wr, const struct proxy_reader *prd);
+void writer_addrset_state_free (struct writer *wr);
 
 #if defined (__cplusplus)
 }
@@ -205,6 +205,11 @@ typedef struct dds_subscription_keys_qospolicy {
   ddsi_stringseq_t key_list;
 } dds_subscription_keys_qospolicy_t;
 
+typedef struct dds_content_filter_qospolicy {
+  char *expression;
+  ddsi_stringseq_t parameters;
+} dds_content_filter_qospolicy_t;
+
 typedef struct dds_reader_lifespan_qospolicy {
   unsigned char use_lifespan;
   dds_duration_t duration;
@@ -264,6 +269,7 @@ typedef uint32_t dds_locator_mask_t;
 #define QP_TYPE_CONSISTENCY_ENFORCEMENT      ((uint64_t)1 << 32)
 #define QP_CYCLONE_TYPE_INFORMATION          ((uint64_t)1 << 33)
 #define QP_LOCATOR_MASK                      ((uint64_t)1 << 34)
+#define QP_CYCLONE_CONTENT_FILTER            ((uint64_t)1 << 35)
 
 /* Partition QoS is not RxO according to the specification (DDS 1.2,
    section 7.1.3), but communication will not take place unless it
@@ -321,6 +327,7 @@ struct dds_qos {
   /*xxx */dds_property_qospolicy_t property;
   /*xxxR*/dds_type_consistency_enforcement_qospolicy_t type_consistency;
   /*xxxX*/dds_locator_mask_t ignore_locator_type;
+  /*x xR*/dds_content_filter_qospolicy_t content_filter;
 };
 
 struct nn_xmsg;
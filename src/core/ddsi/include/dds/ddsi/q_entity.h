@@ -44,6 +44,7 @@ struct nn_dqueue;
 struct nn_rsample_info;
 struct nn_rdata;
 struct addrset;
+struct wraddrset_state;
 struct ddsi_sertype;
 struct whc;
 struct dds_qos;
@@ -144,6 +145,7 @@ struct wr_prd_match {
   ddsrt_wctime_t hb_to_ack_latency_tlastlog;
   uint32_t non_responsive_count;
   uint32_t rexmit_requests;
+  struct ddsi_cfilter *cfilter; /* reader's content filter if evaluated by the writer, else NULL */
 #ifdef DDS_HAS_SECURITY
   int64_t crypto_handle;
 #endif
@@ -208,6 +210,7 @@ struct entity_common {
   bool onlylocal;
   struct ddsi_domaingv *gv;
   ddsrt_avl_node_t all_entities_avlnode;
+  ddsrt_avl_node_t builtin_endpoints_avlnode; /* only used for builtin endpoints */
 
   /* QoS changes always lock the entity itself, and additionally
      (and within the scope of the entity lock) acquire qos_lock
@@ -335,6 +338,7 @@ struct writer
   const struct ddsi_sertype * type; /* type of the data written by this writer */
   struct addrset *as; /* set of addresses to publish to */
   struct addrset *as_group; /* alternate case, used for SPDP, when using Cloud with multiple bootstrap locators */
+  struct wraddrset_state *as_state; /* for incremental updates of as, NULL if a full recomputation is required; protected by e.lock */
   struct xevent *heartbeat_xevent; /* timed event for "periodically" publishing heartbeats when unack'd data present, NULL <=> unreliable */
   struct ldur_fhnode *lease_duration; /* fibheap node to keep lease duration for this writer, NULL in case of automatic liveliness with inifite duration  */
   struct whc *whc; /* WHC tracking history, T-L durability service history + samples by sequence number for retransmit */
@@ -347,6 +351,7 @@ struct writer
   uint32_t num_readers; /* total number of matching PROXY readers */
   uint32_t num_reliable_readers; /* number of matching reliable PROXY readers */
   uint32_t num_readers_requesting_keyhash; /* also +1 for protected keys and config override for generating keyhash */
+  uint32_t num_filtered_readers; /* number of matching PROXY readers with a content filter evaluated by the writer */
   ddsrt_avl_tree_t readers; /* all matching PROXY readers, see struct wr_prd_match */
   ddsrt_avl_tree_t local_readers; /* all matching LOCAL readers, see struct wr_rd_match */
 #ifdef DDS_HAS_NETWORK_PARTITIONS
@@ -30,18 +30,11 @@ struct proxy_reader;
 
 typedef void (*gcreq_cb_t) (struct gcreq *gcreq);
 
-struct idx_vtime {
-  uint32_t idx;
-  vtime_t vtime;
-};
-
 struct gcreq {
   struct gcreq *next;
   struct gcreq_queue *queue;
   gcreq_cb_t cb;
   void *arg;
-  uint32_t nvtimes;
-  struct idx_vtime vtimes[];
 };
 
 DDS_EXPORT struct gcreq_queue *gcreq_queue_new (struct ddsi_domaingv *gv);
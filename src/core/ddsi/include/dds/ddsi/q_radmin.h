@@ -221,9 +221,15 @@ void nn_rbufpool_setowner (struct nn_rbufpool *rbp, ddsrt_thread_t tid);
 void nn_rbufpool_free (struct nn_rbufpool *rbp);
 
 struct nn_rmsg *nn_rmsg_new (struct nn_rbufpool *rbufpool);
+uint32_t nn_rmsg_new_batch (struct nn_rbufpool *rbufpool, uint32_t n, struct nn_rmsg **rmsgs);
+void nn_rmsg_end_batch (struct nn_rbufpool *rbufpool);
 void nn_rmsg_setsize (struct nn_rmsg *rmsg, uint32_t size);
 void nn_rmsg_commit (struct nn_rmsg *rmsg);
 void nn_rmsg_free (struct nn_rmsg *rmsg);
+void nn_rmsg_addref (struct nn_rmsg *rmsg);
+void nn_rmsg_unref (struct nn_rmsg *rmsg);
+bool nn_rmsg_pin (struct nn_rmsg *rmsg, ddsrt_atomic_uint32_t *pinned, uint32_t max);
+void nn_rmsg_unpin (struct nn_rmsg *rmsg, ddsrt_atomic_uint32_t *pinned);
 void *nn_rmsg_alloc (struct nn_rmsg *rmsg, uint32_t size);
 
 struct nn_rdata *nn_rdata_new (struct nn_rmsg *rmsg, uint32_t start, uint32_t endp1, uint32_t submsg_offset, uint32_t payload_offset, uint32_t keyhash_offset);
@@ -267,6 +273,7 @@ void nn_dqueue_enqueue1 (struct nn_dqueue *q, const ddsi_guid_t *rdguid, struct
 void nn_dqueue_enqueue_callback (struct nn_dqueue *q, nn_dqueue_callback_t cb, void *arg);
 int  nn_dqueue_is_full (struct nn_dqueue *q);
 void nn_dqueue_wait_until_empty_if_full (struct nn_dqueue *q);
+void nn_dqueue_stats (struct nn_dqueue *q, uint64_t *count, uint64_t *latency_sum, uint64_t *latency_max);
 
 void nn_defrag_stats (struct nn_defrag *defrag, uint64_t *discarded_bytes);
 void nn_reorder_stats (struct nn_reorder *reorder, uint64_t *discarded_bytes);
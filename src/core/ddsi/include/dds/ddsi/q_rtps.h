@@ -87,6 +87,7 @@ struct cfgst;
 struct ddsi_domaingv;
 int rtps_config_prep (struct ddsi_domaingv *gv, struct cfgst *cfgst);
 int rtps_config_open_trace (struct ddsi_domaingv *gv);
+void rtps_config_close_bintrace (struct ddsi_domaingv *gv);
 int rtps_init (struct ddsi_domaingv *gv);
 int rtps_start (struct ddsi_domaingv *gv);
 void rtps_stop (struct ddsi_domaingv *gv);
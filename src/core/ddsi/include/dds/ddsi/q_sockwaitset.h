@@ -90,7 +90,8 @@ os_sockWaitsetCtx os_sockWaitsetWait (os_sockWaitset ws);
   Returns the index of the next triggered connection in the
   waitset contect ctx, or -1 if the set of available events has been
   exhausted. Index 0 is the first connection added to the waitset, index
-  1 the second, &c.
+  1 the second, &c. Once connections have been removed, the index of a
+  connection added later need not correspond to the order of adding.
 
   Following a call to os_sockWaitsetWait on waitset that returned
   a context, one MUST enumerate all available events before
@@ -89,11 +89,15 @@ void thread_vtime_trace (struct thread_state1 *ts1);
 #define thread_vtime_trace(ts1) do { } while (0)
 #endif /* Q_THREAD_DEBUG */
 
+struct thread_states_list;
+
 #define THREAD_BASE                             \
   ddsrt_atomic_uint32_t vtime;                  \
   enum thread_state state;                      \
   ddsrt_atomic_voidp_t gv;                      \
   ddsrt_thread_t tid;                           \
+  struct thread_states_list *list;              \
+  uint32_t idx;                                 \
   uint32_t (*f) (void *arg);                    \
   void *f_arg;                                  \
   Q_THREAD_BASE_DEBUG /* note: no semicolon! */ \
@@ -112,16 +116,35 @@ struct thread_state1 {
 };
 #undef THREAD_BASE
 
+/*
+ * Thread states are allocated in segments of THREAD_STATE_BATCH slots, that are
+ * only added (at the head of the list) and never moved or freed until all of it
+ * is torn down by thread_states_fini, so the address of a slot remains valid for
+ * as long as the thread using it exists.
+ *
+ * Each segment has a bitmap of the slots in use.  It is only modified while
+ * holding thread_states.lock, but it is updated atomically so that the garbage
+ * collector and the liveliness monitoring can touch only the slots in use without
+ * taking the lock.
+ */
+#define THREAD_STATE_BATCH 32
+
+struct thread_states_list {
+  struct thread_state1 thrst[THREAD_STATE_BATCH];
+  struct thread_states_list *next;
+  ddsrt_atomic_uint32_t active; /* bit i set iff thrst[i] is in use */
+};
+
 struct thread_states {
   ddsrt_mutex_t lock;
-  uint32_t nthreads;
-  struct thread_state1 *ts; /* [nthreads] */
+  ddsrt_atomic_voidp_t thread_states_head; /* struct thread_states_list */
+  ddsrt_atomic_uint32_t nthreads; /* number of slots in all segments, used or not */
 };
 
 extern DDS_EXPORT struct thread_states thread_states;
 extern ddsrt_thread_local struct thread_state1 *tsd_thread_state;
 
-DDS_EXPORT void thread_states_init (unsigned maxthreads);
+DDS_EXPORT void thread_states_init (void);
 DDS_EXPORT bool thread_states_fini (void);
 
 DDS_EXPORT const struct ddsi_config_thread_properties_listelem *lookup_thread_properties (const struct ddsi_config *config, const char *name);
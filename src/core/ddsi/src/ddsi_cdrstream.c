@@ -31,7 +31,22 @@
 static void dds_stream_write (dds_ostream_t * __restrict os, const char * __restrict data, const uint32_t * __restrict ops);
 static void dds_stream_read (dds_istream_t * __restrict is, char * __restrict data, const uint32_t * __restrict ops);
 
-static void dds_ostream_grow (dds_ostream_t * __restrict st, uint32_t size)
+extern inline void dds_cdr_resize (dds_ostream_t * __restrict s, uint32_t l);
+extern inline void dds_cdr_alignto (dds_istream_t * __restrict s, uint32_t a);
+extern inline uint32_t dds_cdr_alignto_clear_and_resize (dds_ostream_t * __restrict s, uint32_t a, uint32_t extra);
+extern inline uint8_t dds_is_get1 (dds_istream_t * __restrict s);
+extern inline uint16_t dds_is_get2 (dds_istream_t * __restrict s);
+extern inline uint32_t dds_is_get4 (dds_istream_t * __restrict s);
+extern inline uint64_t dds_is_get8 (dds_istream_t * __restrict s);
+extern inline void dds_is_get_bytes (dds_istream_t * __restrict s, void * __restrict b, uint32_t num, uint32_t elem_size);
+extern inline void dds_os_put1 (dds_ostream_t * __restrict s, uint8_t v);
+extern inline void dds_os_put2 (dds_ostream_t * __restrict s, uint16_t v);
+extern inline void dds_os_put4 (dds_ostream_t * __restrict s, uint32_t v);
+extern inline void dds_os_put8 (dds_ostream_t * __restrict s, uint64_t v);
+extern inline void dds_os_put_bytes (dds_ostream_t * __restrict s, const void * __restrict b, uint32_t l);
+extern inline void dds_os_put_bytes_aligned (dds_ostream_t * __restrict s, const void * __restrict b, uint32_t n, uint32_t a);
+
+void dds_ostream_grow (dds_ostream_t * __restrict st, uint32_t size)
 {
   uint32_t needed = size + st->m_index;
 
@@ -44,12 +59,6 @@ static void dds_ostream_grow (dds_ostream_t * __restrict st, uint32_t size)
   st->m_size = newSize;
 }
 
-static void dds_cdr_resize (dds_ostream_t * __restrict s, uint32_t l)
-{
-  if (s->m_size < l + s->m_index)
-    dds_ostream_grow (s, l);
-}
-
 void dds_ostream_init (dds_ostream_t * __restrict st, uint32_t size)
 {
   memset (st, 0, sizeof (*st));
@@ -73,102 +82,11 @@ void dds_ostreamBE_fini (dds_ostreamBE_t * __restrict st)
   dds_ostream_fini (&st->x);
 }
 
-static void dds_cdr_alignto (dds_istream_t * __restrict s, uint32_t a)
-{
-  s->m_index = (s->m_index + a - 1) & ~(a - 1);
-  assert (s->m_index < s->m_size);
-}
-
-static uint32_t dds_cdr_alignto_clear_and_resize (dds_ostream_t * __restrict s, uint32_t a, uint32_t extra)
-{
-  const uint32_t m = s->m_index % a;
-  if (m == 0)
-  {
-    dds_cdr_resize (s, extra);
-    return 0;
-  }
-  else
-  {
-    const uint32_t pad = a - m;
-    dds_cdr_resize (s, pad + extra);
-    for (uint32_t i = 0; i < pad; i++)
-      s->m_buffer[s->m_index++] = 0;
-    return pad;
-  }
-}
-
 static uint32_t dds_cdr_alignto_clear_and_resize_be (dds_ostreamBE_t * __restrict s, uint32_t a, uint32_t extra)
 {
   return dds_cdr_alignto_clear_and_resize (&s->x, a, extra);
 }
 
-static uint8_t dds_is_get1 (dds_istream_t * __restrict s)
-{
-  assert (s->m_index < s->m_size);
-  uint8_t v = *(s->m_buffer + s->m_index);
-  s->m_index++;
-  return v;
-}
-
-static uint16_t dds_is_get2 (dds_istream_t * __restrict s)
-{
-  dds_cdr_alignto (s, 2);
-  uint16_t v = * ((uint16_t *) (s->m_buffer + s->m_index));
-  s->m_index += 2;
-  return v;
-}
-
-static uint32_t dds_is_get4 (dds_istream_t * __restrict s)
-{
-  dds_cdr_alignto (s, 4);
-  uint32_t v = * ((uint32_t *) (s->m_buffer + s->m_index));
-  s->m_index += 4;
-  return v;
-}
-
-static uint64_t dds_is_get8 (dds_istream_t * __restrict s)
-{
-  dds_cdr_alignto (s, 8);
-  uint64_t v = * ((uint64_t *) (s->m_buffer + s->m_index));
-  s->m_index += 8;
-  return v;
-}
-
-static void dds_is_get_bytes (dds_istream_t * __restrict s, void * __restrict b, uint32_t num, uint32_t elem_size)
-{
-  dds_cdr_alignto (s, elem_size);
-  memcpy (b, s->m_buffer + s->m_index, num * elem_size);
-  s->m_index += num * elem_size;
-}
-
-static void dds_os_put1 (dds_ostream_t * __restrict s, uint8_t v)
-{
-  dds_cdr_resize (s, 1);
-  *((uint8_t *) (s->m_buffer + s->m_index)) = v;
-  s->m_index += 1;
-}
-
-static void dds_os_put2 (dds_ostream_t * __restrict s, uint16_t v)
-{
-  dds_cdr_alignto_clear_and_resize (s, 2, 2);
-  *((uint16_t *) (s->m_buffer + s->m_index)) = v;
-  s->m_index += 2;
-}
-
-static void dds_os_put4 (dds_ostream_t * __restrict s, uint32_t v)
-{
-  dds_cdr_alignto_clear_and_resize (s, 4, 4);
-  *((uint32_t *) (s->m_buffer + s->m_index)) = v;
-  s->m_index += 4;
-}
-
-static void dds_os_put8 (dds_ostream_t * __restrict s, uint64_t v)
-{
-  dds_cdr_alignto_clear_and_resize (s, 8, 8);
-  *((uint64_t *) (s->m_buffer + s->m_index)) = v;
-  s->m_index += 8;
-}
-
 static void dds_os_put1be (dds_ostreamBE_t * __restrict s, uint8_t v)
 {
   dds_os_put1 (&s->x, v);
@@ -189,21 +107,6 @@ static void dds_os_put8be (dds_ostreamBE_t * __restrict s, uint64_t v)
   dds_os_put8 (&s->x, ddsrt_toBE8u (v));
 }
 
-static void dds_os_put_bytes (dds_ostream_t * __restrict s, const void * __restrict b, uint32_t l)
-{
-  dds_cdr_resize (s, l);
-  memcpy (s->m_buffer + s->m_index, b, l);
-  s->m_index += l;
-}
-
-static void dds_os_put_bytes_aligned (dds_ostream_t * __restrict s, const void * __restrict b, uint32_t n, uint32_t a)
-{
-  const uint32_t l = n * a;
-  dds_cdr_alignto_clear_and_resize (s, a, l);
-  memcpy (s->m_buffer + s->m_index, b, l);
-  s->m_index += l;
-}
-
 static uint32_t get_type_size (enum dds_stream_typecode type)
 {
   DDSRT_STATIC_ASSERT (DDS_OP_VAL_1BY == 1 && DDS_OP_VAL_2BY == 2 && DDS_OP_VAL_4BY == 3 && DDS_OP_VAL_8BY == 4);
@@ -388,7 +291,7 @@ uint32_t dds_stream_countops (const uint32_t * __restrict ops)
   return (uint32_t) (ops_end - ops);
 }
 
-static void dds_stream_reuse_string_bound (dds_istream_t * __restrict is, char * __restrict str, const uint32_t bound)
+void dds_stream_reuse_string_bound (dds_istream_t * __restrict is, char * __restrict str, const uint32_t bound)
 {
   const uint32_t length = dds_is_get4 (is);
   const void *src = is->m_buffer + is->m_index;
@@ -400,7 +303,7 @@ static void dds_stream_reuse_string_bound (dds_istream_t * __restrict is, char *
   is->m_index += length;
 }
 
-static char *dds_stream_reuse_string (dds_istream_t * __restrict is, char * __restrict str)
+char *dds_stream_reuse_string (dds_istream_t * __restrict is, char * __restrict str)
 {
   const uint32_t length = dds_is_get4 (is);
   const void *src = is->m_buffer + is->m_index;
@@ -411,19 +314,19 @@ static char *dds_stream_reuse_string (dds_istream_t * __restrict is, char * __re
   return str;
 }
 
-static void dds_stream_skip_forward (dds_istream_t * __restrict is, uint32_t len, const uint32_t elem_size)
+void dds_stream_skip_forward (dds_istream_t * __restrict is, uint32_t len, const uint32_t elem_size)
 {
   if (elem_size && len)
     is->m_index += len * elem_size;
 }
 
-static void dds_stream_skip_string (dds_istream_t * __restrict is)
+void dds_stream_skip_string (dds_istream_t * __restrict is)
 {
   const uint32_t length = dds_is_get4 (is);
   dds_stream_skip_forward (is, length, 1);
 }
 
-static void dds_stream_write_string (dds_ostream_t * __restrict os, const char * __restrict val)
+void dds_stream_write_string (dds_ostream_t * __restrict os, const char * __restrict val)
 {
   uint32_t size = 1;
 
@@ -674,7 +577,7 @@ static void dds_stream_write (dds_ostream_t * __restrict os, const char * __rest
   }
 }
 
-static void realloc_sequence_buffer_if_needed (dds_sequence_t * __restrict seq, uint32_t num, uint32_t elem_size, bool init)
+void dds_stream_realloc_sequence_buffer_if_needed (dds_sequence_t * __restrict seq, uint32_t num, uint32_t elem_size, bool init)
 {
   const uint32_t size = num * elem_size;
 
@@ -717,7 +620,7 @@ static const uint32_t *dds_stream_read_seq (dds_istream_t * __restrict is, char
   {
     case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY: {
       const uint32_t elem_size = get_type_size (subtype);
-      realloc_sequence_buffer_if_needed (seq, num, elem_size, false);
+      dds_stream_realloc_sequence_buffer_if_needed (seq, num, elem_size, false);
       seq->_length = (num <= seq->_maximum) ? num : seq->_maximum;
       dds_is_get_bytes (is, seq->_buffer, seq->_length, elem_size);
       if (seq->_length < num)
@@ -725,7 +628,7 @@ static const uint32_t *dds_stream_read_seq (dds_istream_t * __restrict is, char
       return ops + 2;
     }
     case DDS_OP_VAL_STR: {
-      realloc_sequence_buffer_if_needed (seq, num, sizeof (char *), true);
+      dds_stream_realloc_sequence_buffer_if_needed (seq, num, sizeof (char *), true);
       seq->_length = (num <= seq->_maximum) ? num : seq->_maximum;
       char **ptr = (char **) seq->_buffer;
       for (uint32_t i = 0; i < seq->_length; i++)
@@ -736,7 +639,7 @@ static const uint32_t *dds_stream_read_seq (dds_istream_t * __restrict is, char
     }
     case DDS_OP_VAL_BST: {
       const uint32_t elem_size = ops[2];
-      realloc_sequence_buffer_if_needed (seq, num, elem_size, false);
+      dds_stream_realloc_sequence_buffer_if_needed (seq, num, elem_size, false);
       seq->_length = (num <= seq->_maximum) ? num : seq->_maximum;
       char *ptr = (char *) seq->_buffer;
       for (uint32_t i = 0; i < seq->_length; i++)
@@ -749,7 +652,7 @@ static const uint32_t *dds_stream_read_seq (dds_istream_t * __restrict is, char
       const uint32_t elem_size = ops[2];
       const uint32_t jmp = DDS_OP_ADR_JMP (ops[3]);
       uint32_t const * const jsr_ops = ops + DDS_OP_ADR_JSR (ops[3]);
-      realloc_sequence_buffer_if_needed (seq, num, elem_size, true);
+      dds_stream_realloc_sequence_buffer_if_needed (seq, num, elem_size, true);
       seq->_length = (num <= seq->_maximum) ? num : seq->_maximum;
       char *ptr = (char *) seq->_buffer;
       for (uint32_t i = 0; i < num; i++)
@@ -902,7 +805,7 @@ static uint32_t check_align_prim_many (uint32_t off, uint32_t size, uint32_t a_l
   return off1;
 }
 
-static bool normalize_uint8 (uint32_t *off, uint32_t size)
+bool dds_stream_normalize_uint8 (uint32_t *off, uint32_t size)
 {
   if (*off == size)
     return false;
@@ -910,7 +813,7 @@ static bool normalize_uint8 (uint32_t *off, uint32_t size)
   return true;
 }
 
-static bool normalize_uint16 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
+bool dds_stream_normalize_uint16 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
 {
   if ((*off = check_align_prim (*off, size, 1)) == UINT32_MAX)
     return false;
@@ -920,7 +823,7 @@ static bool normalize_uint16 (char * __restrict data, uint32_t * __restrict off,
   return true;
 }
 
-static bool normalize_uint32 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
+bool dds_stream_normalize_uint32 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
 {
   if ((*off = check_align_prim (*off, size, 2)) == UINT32_MAX)
     return false;
@@ -930,7 +833,7 @@ static bool normalize_uint32 (char * __restrict data, uint32_t * __restrict off,
   return true;
 }
 
-static bool read_and_normalize_uint32 (uint32_t * __restrict val, char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
+bool dds_stream_read_and_normalize_uint32 (uint32_t * __restrict val, char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
 {
   if ((*off = check_align_prim (*off, size, 2)) == UINT32_MAX)
     return false;
@@ -941,7 +844,7 @@ static bool read_and_normalize_uint32 (uint32_t * __restrict val, char * __restr
   return true;
 }
 
-static bool normalize_uint64 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
+bool dds_stream_normalize_uint64 (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap)
 {
   if ((*off = check_align_prim (*off, size, 3)) == UINT32_MAX)
     return false;
@@ -951,10 +854,10 @@ static bool normalize_uint64 (char * __restrict data, uint32_t * __restrict off,
   return true;
 }
 
-static bool normalize_string (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, size_t maxsz)
+bool dds_stream_normalize_string (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, size_t maxsz)
 {
   uint32_t sz;
-  if (!read_and_normalize_uint32 (&sz, data, off, size, bswap))
+  if (!dds_stream_read_and_normalize_uint32 (&sz, data, off, size, bswap))
     return false;
   if (sz == 0 || size - *off < sz || maxsz < sz)
     return false;
@@ -964,7 +867,7 @@ static bool normalize_string (char * __restrict data, uint32_t * __restrict off,
   return true;
 }
 
-static bool normalize_primarray (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t num, enum dds_stream_typecode type)
+bool dds_stream_normalize_primarray (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, uint32_t num, enum dds_stream_typecode type)
 {
   switch (type)
   {
@@ -977,33 +880,21 @@ static bool normalize_primarray (char * __restrict data, uint32_t * __restrict o
       if ((*off = check_align_prim_many (*off, size, 1, num)) == UINT32_MAX)
         return false;
       if (bswap)
-      {
-        uint16_t *xs = (uint16_t *) (data + *off);
-        for (uint32_t i = 0; i < num; i++)
-          xs[i] = ddsrt_bswap2u (xs[i]);
-      }
+        ddsrt_bswap2u_array (data + *off, num);
       *off += 2 * num;
       return true;
     case DDS_OP_VAL_4BY:
       if ((*off = check_align_prim_many (*off, size, 2, num)) == UINT32_MAX)
         return false;
       if (bswap)
-      {
-        uint32_t *xs = (uint32_t *) (data + *off);
-        for (uint32_t i = 0; i < num; i++)
-          xs[i] = ddsrt_bswap4u (xs[i]);
-      }
+        ddsrt_bswap4u_array (data + *off, num);
       *off += 4 * num;
       return true;
     case DDS_OP_VAL_8BY:
       if ((*off = check_align_prim_many (*off, size, 3, num)) == UINT32_MAX)
         return false;
       if (bswap)
-      {
-        uint64_t *xs = (uint64_t *) (data + *off);
-        for (uint32_t i = 0; i < num; i++)
-          xs[i] = ddsrt_bswap8u (xs[i]);
-      }
+        ddsrt_bswap8u_array (data + *off, num);
       *off += 8 * num;
       return true;
     default:
@@ -1017,20 +908,20 @@ static const uint32_t *normalize_seq (char * __restrict data, uint32_t * __restr
 {
   const enum dds_stream_typecode subtype = DDS_OP_SUBTYPE (insn);
   uint32_t num;
-  if (!read_and_normalize_uint32 (&num, data, off, size, bswap))
+  if (!dds_stream_read_and_normalize_uint32 (&num, data, off, size, bswap))
     return NULL;
   if (num == 0)
     return skip_sequence_insns (ops, insn);
   switch (subtype)
   {
     case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
-      if (!normalize_primarray (data, off, size, bswap, num, subtype))
+      if (!dds_stream_normalize_primarray (data, off, size, bswap, num, subtype))
         return NULL;
       return ops + 2;
     case DDS_OP_VAL_STR: case DDS_OP_VAL_BST: {
       const size_t maxsz = (subtype == DDS_OP_VAL_STR) ? SIZE_MAX : ops[2];
       for (uint32_t i = 0; i < num; i++)
-        if (!normalize_string (data, off, size, bswap, maxsz))
+        if (!dds_stream_normalize_string (data, off, size, bswap, maxsz))
           return NULL;
       return ops + (subtype == DDS_OP_VAL_STR ? 2 : 3);
     }
@@ -1053,13 +944,13 @@ static const uint32_t *normalize_arr (char * __restrict data, uint32_t * __restr
   switch (subtype)
   {
     case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
-      if (!normalize_primarray (data, off, size, bswap, num, subtype))
+      if (!dds_stream_normalize_primarray (data, off, size, bswap, num, subtype))
         return NULL;
       return ops + 3;
     case DDS_OP_VAL_STR: case DDS_OP_VAL_BST: {
       const size_t maxsz = (subtype == DDS_OP_VAL_STR) ? SIZE_MAX : ops[4];
       for (uint32_t i = 0; i < num; i++)
-        if (!normalize_string (data, off, size, bswap, maxsz))
+        if (!dds_stream_normalize_string (data, off, size, bswap, maxsz))
           return NULL;
       return ops + (subtype == DDS_OP_VAL_STR ? 3 : 5);
     }
@@ -1075,7 +966,7 @@ static const uint32_t *normalize_arr (char * __restrict data, uint32_t * __restr
   return NULL;
 }
 
-static bool normalize_uni_disc (uint32_t * __restrict val, char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, enum dds_stream_typecode disctype)
+bool dds_stream_normalize_uni_disc (uint32_t * __restrict val, char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, enum dds_stream_typecode disctype)
 {
   switch (disctype)
   {
@@ -1110,7 +1001,7 @@ static bool normalize_uni_disc (uint32_t * __restrict val, char * __restrict dat
 static const uint32_t *normalize_uni (char * __restrict data, uint32_t * __restrict off, uint32_t size, bool bswap, const uint32_t * __restrict ops, uint32_t insn)
 {
   uint32_t disc;
-  if (!normalize_uni_disc (&disc, data, off, size, bswap, DDS_OP_SUBTYPE (insn)))
+  if (!dds_stream_normalize_uni_disc (&disc, data, off, size, bswap, DDS_OP_SUBTYPE (insn)))
     return NULL;
   uint32_t const * const jeq_op = find_union_case (ops, disc);
   ops += DDS_OP_ADR_JMP (ops[3]);
@@ -1119,11 +1010,11 @@ static const uint32_t *normalize_uni (char * __restrict data, uint32_t * __restr
     const enum dds_stream_typecode valtype = DDS_JEQ_TYPE (jeq_op[0]);
     switch (valtype)
     {
-      case DDS_OP_VAL_1BY: if (!normalize_uint8 (off, size)) return NULL; break;
-      case DDS_OP_VAL_2BY: if (!normalize_uint16 (data, off, size, bswap)) return NULL; break;
-      case DDS_OP_VAL_4BY: if (!normalize_uint32 (data, off, size, bswap)) return NULL; break;
-      case DDS_OP_VAL_8BY: if (!normalize_uint64 (data, off, size, bswap)) return NULL; break;
-      case DDS_OP_VAL_STR: if (!normalize_string (data, off, size, bswap, SIZE_MAX)) return NULL; break;
+      case DDS_OP_VAL_1BY: if (!dds_stream_normalize_uint8 (off, size)) return NULL; break;
+      case DDS_OP_VAL_2BY: if (!dds_stream_normalize_uint16 (data, off, size, bswap)) return NULL; break;
+      case DDS_OP_VAL_4BY: if (!dds_stream_normalize_uint32 (data, off, size, bswap)) return NULL; break;
+      case DDS_OP_VAL_8BY: if (!dds_stream_normalize_uint64 (data, off, size, bswap)) return NULL; break;
+      case DDS_OP_VAL_STR: if (!dds_stream_normalize_string (data, off, size, bswap, SIZE_MAX)) return NULL; break;
       case DDS_OP_VAL_BST: case DDS_OP_VAL_SEQ: case DDS_OP_VAL_ARR: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU:
         if (!stream_normalize (data, off, size, bswap, jeq_op + DDS_OP_ADR_JSR (jeq_op[0])))
           return NULL;
@@ -1143,12 +1034,12 @@ static bool stream_normalize (char * __restrict data, uint32_t * __restrict off,
       case DDS_OP_ADR: {
         switch (DDS_OP_TYPE (insn))
         {
-          case DDS_OP_VAL_1BY: if (!normalize_uint8 (off, size)) return false; ops += 2; break;
-          case DDS_OP_VAL_2BY: if (!normalize_uint16 (data, off, size, bswap)) return false; ops += 2; break;
-          case DDS_OP_VAL_4BY: if (!normalize_uint32 (data, off, size, bswap)) return false; ops += 2; break;
-          case DDS_OP_VAL_8BY: if (!normalize_uint64 (data, off, size, bswap)) return false; ops += 2; break;
-          case DDS_OP_VAL_STR: if (!normalize_string (data, off, size, bswap, SIZE_MAX)) return false; ops += 2; break;
-          case DDS_OP_VAL_BST: if (!normalize_string (data, off, size, bswap, ops[2])) return false; ops += 3; break;
+          case DDS_OP_VAL_1BY: if (!dds_stream_normalize_uint8 (off, size)) return false; ops += 2; break;
+          case DDS_OP_VAL_2BY: if (!dds_stream_normalize_uint16 (data, off, size, bswap)) return false; ops += 2; break;
+          case DDS_OP_VAL_4BY: if (!dds_stream_normalize_uint32 (data, off, size, bswap)) return false; ops += 2; break;
+          case DDS_OP_VAL_8BY: if (!dds_stream_normalize_uint64 (data, off, size, bswap)) return false; ops += 2; break;
+          case DDS_OP_VAL_STR: if (!dds_stream_normalize_string (data, off, size, bswap, SIZE_MAX)) return false; ops += 2; break;
+          case DDS_OP_VAL_BST: if (!dds_stream_normalize_string (data, off, size, bswap, ops[2])) return false; ops += 3; break;
           case DDS_OP_VAL_SEQ: ops = normalize_seq (data, off, size, bswap, ops, insn); if (!ops) return false; break;
           case DDS_OP_VAL_ARR: ops = normalize_arr (data, off, size, bswap, ops, insn); if (!ops) return false; break;
           case DDS_OP_VAL_UNI: ops = normalize_uni (data, off, size, bswap, ops, insn); if (!ops) return false; break;
@@ -1180,12 +1071,12 @@ static bool stream_normalize_key (void * __restrict data, uint32_t size, bool bs
     assert (insn_key_ok_p (*op));
     switch (DDS_OP_TYPE (*op))
     {
-      case DDS_OP_VAL_1BY: if (!normalize_uint8 (&off, size)) return false; break;
-      case DDS_OP_VAL_2BY: if (!normalize_uint16 (data, &off, size, bswap)) return false; break;
-      case DDS_OP_VAL_4BY: if (!normalize_uint32 (data, &off, size, bswap)) return false; break;
-      case DDS_OP_VAL_8BY: if (!normalize_uint64 (data, &off, size, bswap)) return false; break;
-      case DDS_OP_VAL_STR: if (!normalize_string (data, &off, size, bswap, SIZE_MAX)) return false; break;
-      case DDS_OP_VAL_BST: if (!normalize_string (data, &off, size, bswap, op[2])) return false; break;
+      case DDS_OP_VAL_1BY: if (!dds_stream_normalize_uint8 (&off, size)) return false; break;
+      case DDS_OP_VAL_2BY: if (!dds_stream_normalize_uint16 (data, &off, size, bswap)) return false; break;
+      case DDS_OP_VAL_4BY: if (!dds_stream_normalize_uint32 (data, &off, size, bswap)) return false; break;
+      case DDS_OP_VAL_8BY: if (!dds_stream_normalize_uint64 (data, &off, size, bswap)) return false; break;
+      case DDS_OP_VAL_STR: if (!dds_stream_normalize_string (data, &off, size, bswap, SIZE_MAX)) return false; break;
+      case DDS_OP_VAL_BST: if (!dds_stream_normalize_string (data, &off, size, bswap, op[2])) return false; break;
       case DDS_OP_VAL_ARR: if (!normalize_arr (data, &off, size, bswap, op, *op)) return false; break;
       case DDS_OP_VAL_SEQ: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU:
         abort ();
@@ -1204,10 +1095,352 @@ bool dds_stream_normalize (void * __restrict data, uint32_t size, bool bswap, co
   else
   {
     uint32_t off = 0;
+    if (topic->type.cdr_funcs)
+      return topic->type.cdr_funcs->normalize (data, &off, size, bswap);
     return stream_normalize (data, &off, size, bswap, topic->type.ops.ops);
   }
 }
 
+/* Validation of native-endian CDR spread over a list of buffers, e.g. the fragments of
+   a large sample still in the receive buffers. It accepts exactly what stream_normalize
+   accepts when no byte swapping is needed, but never writes to the input, and computes the
+   key hash on the fly in the way dds_stream_extract_keyhash does. */
+
+struct iov_stream {
+  const ddsrt_iovec_t *iov;
+  uint32_t size;        /* Size of the CDR (excluding padding) */
+  uint32_t seg;         /* Index of the buffer last accessed */
+  uint32_t segoff;      /* Offset in the CDR of the first byte of buffer seg */
+  dds_ostreamBE_t *key; /* Key extracted so far or NULL if the type has no key */
+  uint32_t keys_remaining;
+};
+
+static void iov_stream_copy (struct iov_stream * __restrict s, void * __restrict dst, uint32_t off, uint32_t n)
+{
+  unsigned char *d = dst;
+  assert (off + n <= s->size);
+  if (off < s->segoff)
+  {
+    s->seg = 0;
+    s->segoff = 0;
+  }
+  while (n > 0)
+  {
+    while (off - s->segoff >= (uint32_t) s->iov[s->seg].iov_len)
+      s->segoff += (uint32_t) s->iov[s->seg++].iov_len;
+    const uint32_t o = off - s->segoff;
+    const uint32_t m = ((uint32_t) s->iov[s->seg].iov_len - o < n) ? (uint32_t) s->iov[s->seg].iov_len - o : n;
+    memcpy (d, (const unsigned char *) s->iov[s->seg].iov_base + o, m);
+    d += m; off += m; n -= m;
+  }
+}
+
+static bool validate_iov_uint32 (uint32_t * __restrict val, struct iov_stream * __restrict s, uint32_t * __restrict off)
+{
+  if ((*off = check_align_prim (*off, s->size, 2)) == UINT32_MAX)
+    return false;
+  iov_stream_copy (s, val, *off, 4);
+  (*off) += 4;
+  return true;
+}
+
+static bool validate_iov_prim (struct iov_stream * __restrict s, uint32_t * __restrict off, enum dds_stream_typecode type)
+{
+  const uint32_t a_lg2 = (uint32_t) type - 1;
+  if ((*off = check_align_prim (*off, s->size, a_lg2)) == UINT32_MAX)
+    return false;
+  (*off) += 1u << a_lg2;
+  return true;
+}
+
+static bool validate_iov_primarray (struct iov_stream * __restrict s, uint32_t * __restrict off, uint32_t num, enum dds_stream_typecode type)
+{
+  const uint32_t a_lg2 = (uint32_t) type - 1;
+  if ((*off = check_align_prim_many (*off, s->size, a_lg2, num)) == UINT32_MAX)
+    return false;
+  (*off) += num << a_lg2;
+  return true;
+}
+
+static bool validate_iov_string (struct iov_stream * __restrict s, uint32_t * __restrict off, size_t maxsz)
+{
+  uint32_t sz;
+  char term;
+  if (!validate_iov_uint32 (&sz, s, off))
+    return false;
+  if (sz == 0 || s->size - *off < sz || maxsz < sz)
+    return false;
+  iov_stream_copy (s, &term, *off + sz - 1, 1);
+  if (term != 0)
+    return false;
+  *off += sz;
+  return true;
+}
+
+static bool validate_iov_uni_disc (uint32_t * __restrict val, struct iov_stream * __restrict s, uint32_t * __restrict off, enum dds_stream_typecode disctype)
+{
+  const uint32_t a_lg2 = (uint32_t) disctype - 1;
+  if ((*off = check_align_prim (*off, s->size, a_lg2)) == UINT32_MAX)
+    return false;
+  switch (disctype)
+  {
+    case DDS_OP_VAL_1BY: { uint8_t v; iov_stream_copy (s, &v, *off, 1); *val = v; break; }
+    case DDS_OP_VAL_2BY: { uint16_t v; iov_stream_copy (s, &v, *off, 2); *val = v; break; }
+    case DDS_OP_VAL_4BY: { iov_stream_copy (s, val, *off, 4); break; }
+    default: abort ();
+  }
+  (*off) += 1u << a_lg2;
+  return true;
+}
+
+static void extract_keyBE_from_iov (struct iov_stream * __restrict s, uint32_t off, const uint32_t * __restrict op)
+{
+  /* off is the offset of the (already validated) key field prior to alignment */
+  dds_ostreamBE_t * const os = s->key;
+  switch (DDS_OP_TYPE (*op))
+  {
+    case DDS_OP_VAL_1BY: { uint8_t v; iov_stream_copy (s, &v, off, 1); dds_os_put1be (os, v); break; }
+    case DDS_OP_VAL_2BY: { uint16_t v; off = check_align_prim (off, s->size, 1); iov_stream_copy (s, &v, off, 2); dds_os_put2be (os, v); break; }
+    case DDS_OP_VAL_4BY: { uint32_t v; off = check_align_prim (off, s->size, 2); iov_stream_copy (s, &v, off, 4); dds_os_put4be (os, v); break; }
+    case DDS_OP_VAL_8BY: { uint64_t v; off = check_align_prim (off, s->size, 3); iov_stream_copy (s, &v, off, 8); dds_os_put8be (os, v); break; }
+    case DDS_OP_VAL_STR: case DDS_OP_VAL_BST: {
+      uint32_t sz;
+      (void) validate_iov_uint32 (&sz, s, &off);
+      dds_os_put4be (os, sz);
+      dds_cdr_resize (&os->x, sz);
+      iov_stream_copy (s, os->x.m_buffer + os->x.m_index, off, sz);
+      os->x.m_index += sz;
+      break;
+    }
+    case DDS_OP_VAL_ARR: {
+      const enum dds_stream_typecode subtype = DDS_OP_SUBTYPE (*op);
+      const uint32_t align = get_type_size (subtype);
+      const uint32_t num = op[2];
+      off = check_align_prim_many (off, s->size, (uint32_t) subtype - 1, num);
+      dds_cdr_alignto_clear_and_resize_be (os, align, num * align);
+      void * const dst = os->x.m_buffer + os->x.m_index;
+      iov_stream_copy (s, dst, off, num * align);
+#if DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN
+      switch (subtype)
+      {
+        case DDS_OP_VAL_2BY: ddsrt_bswap2u_array (dst, num); break;
+        case DDS_OP_VAL_4BY: ddsrt_bswap4u_array (dst, num); break;
+        case DDS_OP_VAL_8BY: ddsrt_bswap8u_array (dst, num); break;
+        default: break;
+      }
+#endif
+      os->x.m_index += num * align;
+      break;
+    }
+    case DDS_OP_VAL_SEQ: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU: {
+      abort ();
+      break;
+    }
+  }
+}
+
+static bool stream_validate_iov (struct iov_stream * __restrict s, uint32_t * __restrict off, const uint32_t * __restrict ops, bool extract_key);
+
+static const uint32_t *validate_iov_seq (struct iov_stream * __restrict s, uint32_t * __restrict off, const uint32_t * __restrict ops, uint32_t insn)
+{
+  const enum dds_stream_typecode subtype = DDS_OP_SUBTYPE (insn);
+  uint32_t num;
+  if (!validate_iov_uint32 (&num, s, off))
+    return NULL;
+  if (num == 0)
+    return skip_sequence_insns (ops, insn);
+  switch (subtype)
+  {
+    case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+      if (!validate_iov_primarray (s, off, num, subtype))
+        return NULL;
+      return ops + 2;
+    case DDS_OP_VAL_STR: case DDS_OP_VAL_BST: {
+      const size_t maxsz = (subtype == DDS_OP_VAL_STR) ? SIZE_MAX : ops[2];
+      for (uint32_t i = 0; i < num; i++)
+        if (!validate_iov_string (s, off, maxsz))
+          return NULL;
+      return ops + (subtype == DDS_OP_VAL_STR ? 2 : 3);
+    }
+    case DDS_OP_VAL_SEQ: case DDS_OP_VAL_ARR: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU: {
+      const uint32_t jmp = DDS_OP_ADR_JMP (ops[3]);
+      uint32_t const * const jsr_ops = ops + DDS_OP_ADR_JSR (ops[3]);
+      for (uint32_t i = 0; i < num; i++)
+        if (!stream_validate_iov (s, off, jsr_ops, false))
+          return NULL;
+      return ops + (jmp ? jmp : 4); /* FIXME: why would jmp be 0? */
+    }
+  }
+  return NULL;
+}
+
+static const uint32_t *validate_iov_arr (struct iov_stream * __restrict s, uint32_t * __restrict off, const uint32_t * __restrict ops, uint32_t insn)
+{
+  const enum dds_stream_typecode subtype = DDS_OP_SUBTYPE (insn);
+  const uint32_t num = ops[2];
+  switch (subtype)
+  {
+    case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+      if (!validate_iov_primarray (s, off, num, subtype))
+        return NULL;
+      return ops + 3;
+    case DDS_OP_VAL_STR: case DDS_OP_VAL_BST: {
+      const size_t maxsz = (subtype == DDS_OP_VAL_STR) ? SIZE_MAX : ops[4];
+      for (uint32_t i = 0; i < num; i++)
+        if (!validate_iov_string (s, off, maxsz))
+          return NULL;
+      return ops + (subtype == DDS_OP_VAL_STR ? 3 : 5);
+    }
+    case DDS_OP_VAL_SEQ: case DDS_OP_VAL_ARR: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU: {
+      const uint32_t *jsr_ops = ops + DDS_OP_ADR_JSR (ops[3]);
+      const uint32_t jmp = DDS_OP_ADR_JMP (ops[3]);
+      for (uint32_t i = 0; i < num; i++)
+        if (!stream_validate_iov (s, off, jsr_ops, false))
+          return NULL;
+      return ops + (jmp ? jmp : 5);
+    }
+  }
+  return NULL;
+}
+
+static const uint32_t *validate_iov_uni (struct iov_stream * __restrict s, uint32_t * __restrict off, const uint32_t * __restrict ops, uint32_t insn)
+{
+  uint32_t disc;
+  if (!validate_iov_uni_disc (&disc, s, off, DDS_OP_SUBTYPE (insn)))
+    return NULL;
+  uint32_t const * const jeq_op = find_union_case (ops, disc);
+  ops += DDS_OP_ADR_JMP (ops[3]);
+  if (jeq_op)
+  {
+    const enum dds_stream_typecode valtype = DDS_JEQ_TYPE (jeq_op[0]);
+    switch (valtype)
+    {
+      case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+        if (!validate_iov_prim (s, off, valtype)) return NULL;
+        break;
+      case DDS_OP_VAL_STR: if (!validate_iov_string (s, off, SIZE_MAX)) return NULL; break;
+      case DDS_OP_VAL_BST: case DDS_OP_VAL_SEQ: case DDS_OP_VAL_ARR: case DDS_OP_VAL_UNI: case DDS_OP_VAL_STU:
+        if (!stream_validate_iov (s, off, jeq_op + DDS_OP_ADR_JSR (jeq_op[0]), false))
+          return NULL;
+        break;
+    }
+  }
+  return ops;
+}
+
+static bool stream_validate_iov (struct iov_stream * __restrict s, uint32_t * __restrict off, const uint32_t * __restrict ops, bool extract_key)
+{
+  /* extract_key mirrors the walk done by dds_stream_extract_keyBE_from_data1: keys are taken
+     in the order they are encountered (not descending into sequences, arrays and unions) and
+     nothing is taken from the remainder of the current level once keys_remaining hits 0 */
+  uint32_t insn;
+  while ((insn = *ops) != DDS_OP_RTS)
+  {
+    switch (DDS_OP (insn))
+    {
+      case DDS_OP_ADR: {
+        const uint32_t off0 = *off;
+        const enum dds_stream_typecode type = DDS_OP_TYPE (insn);
+        const uint32_t * const ops0 = ops;
+        switch (type)
+        {
+          case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+            if (!validate_iov_prim (s, off, type)) return false;
+            ops += 2;
+            break;
+          case DDS_OP_VAL_STR: if (!validate_iov_string (s, off, SIZE_MAX)) return false; ops += 2; break;
+          case DDS_OP_VAL_BST: if (!validate_iov_string (s, off, ops[2])) return false; ops += 3; break;
+          case DDS_OP_VAL_SEQ: ops = validate_iov_seq (s, off, ops, insn); if (!ops) return false; break;
+          case DDS_OP_VAL_ARR: ops = validate_iov_arr (s, off, ops, insn); if (!ops) return false; break;
+          case DDS_OP_VAL_UNI: ops = validate_iov_uni (s, off, ops, insn); if (!ops) return false; break;
+          case DDS_OP_VAL_STU: abort (); break;
+        }
+        if (extract_key && (insn & DDS_OP_FLAG_KEY))
+        {
+          extract_keyBE_from_iov (s, off0, ops0);
+          if (--s->keys_remaining == 0)
+            extract_key = false;
+        }
+        break;
+      }
+      case DDS_OP_JSR: {
+        if (!stream_validate_iov (s, off, ops + DDS_OP_JUMP (insn), extract_key))
+          return false;
+        if (extract_key && --s->keys_remaining == 0)
+          extract_key = false;
+        ops++;
+        break;
+      }
+      case DDS_OP_RTS: case DDS_OP_JEQ: {
+        abort ();
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+bool dds_stream_validate_iov_native (uint32_t niov, const ddsrt_iovec_t *iov, uint32_t size, dds_keyhash_t * __restrict kh, const struct ddsi_sertype_default * __restrict type)
+{
+  const struct ddsi_sertype_default_desc *desc = &type->type;
+  struct iov_stream s;
+  dds_ostreamBE_t os;
+  uint32_t off = 0;
+  bool ok;
+#ifndef NDEBUG
+  size_t total = 0;
+  for (uint32_t i = 0; i < niov; i++)
+    total += iov[i].iov_len;
+  assert (total >= size);
+#else
+  (void) niov;
+#endif
+  if (size > CDR_SIZE_MAX)
+    return false;
+
+  s.iov = iov;
+  s.size = size;
+  s.seg = 0;
+  s.segoff = 0;
+  s.keys_remaining = desc->keys.nkeys;
+  s.key = (desc->keys.nkeys > 0) ? &os : NULL;
+  dds_ostreamBE_init (&os, 0);
+  if (desc->flagset & DDS_TOPIC_FIXED_KEY)
+  {
+    os.x.m_buffer = kh->m_hash;
+    os.x.m_size = 16;
+  }
+  memset (kh->m_hash, 0, sizeof (kh->m_hash));
+
+  if ((ok = stream_validate_iov (&s, &off, desc->ops.ops, s.key != NULL)))
+  {
+    kh->m_set = 1;
+    if (desc->keys.nkeys == 0)
+    {
+      kh->m_iskey = 1;
+      kh->m_keysize = 0;
+    }
+    else if (desc->flagset & DDS_TOPIC_FIXED_KEY)
+    {
+      assert (os.x.m_index <= 16);
+      kh->m_iskey = 1;
+      kh->m_keysize = (unsigned) os.x.m_index & 0x1f;
+    }
+    else
+    {
+      ddsrt_md5_state_t md5st;
+      kh->m_iskey = 0;
+      kh->m_keysize = 16;
+      ddsrt_md5_init (&md5st);
+      ddsrt_md5_append (&md5st, os.x.m_buffer, os.x.m_index);
+      ddsrt_md5_finish (&md5st, kh->m_hash);
+    }
+  }
+  if (!(desc->flagset & DDS_TOPIC_FIXED_KEY))
+    dds_ostreamBE_fini (&os);
+  return ok;
+}
+
 /*******************************************************************************************
  **
  **  Freeing samples
@@ -1429,7 +1662,10 @@ void dds_stream_read_sample (dds_istream_t * __restrict is, void * __restrict da
       dds_stream_free_sample (data, desc->ops.ops);
       memset (data, 0, desc->size);
     }
-    dds_stream_read (is, data, desc->ops.ops);
+    if (desc->cdr_funcs)
+      desc->cdr_funcs->read (is, data);
+    else
+      dds_stream_read (is, data, desc->ops.ops);
   }
 }
 
@@ -1438,6 +1674,8 @@ void dds_stream_write_sample (dds_ostream_t * __restrict os, const void * __rest
   const struct ddsi_sertype_default_desc *desc = &type->type;
   if (type->opt_size && desc->align && (os->m_index % desc->align) == 0)
     dds_os_put_bytes (os, data, desc->size);
+  else if (desc->cdr_funcs)
+    desc->cdr_funcs->write (os, data);
   else
     dds_stream_write (os, data, desc->ops.ops);
 }
@@ -1471,6 +1709,11 @@ void dds_stream_read_key (dds_istream_t * __restrict is, char * __restrict sampl
 void dds_stream_write_key (dds_ostream_t * __restrict os, const char * __restrict sample, const struct ddsi_sertype_default * __restrict type)
 {
   const struct ddsi_sertype_default_desc *desc = &type->type;
+  if (desc->cdr_funcs)
+  {
+    desc->cdr_funcs->write_key (os, sample);
+    return;
+  }
   for (uint32_t i = 0; i < desc->keys.nkeys; i++)
   {
     const uint32_t *insnp = desc->ops.ops + desc->keys.keys[i];
@@ -1505,26 +1748,10 @@ static void dds_stream_swap_insitu (void * __restrict vbuf, uint32_t size, uint3
   assert (size == 1 || size == 2 || size == 4 || size == 8);
   switch (size)
   {
-    case 1:
-      break;
-    case 2: {
-      uint16_t *buf = vbuf;
-      for (uint32_t i = 0; i < num; i++)
-        buf[i] = ddsrt_bswap2u (buf[i]);
-      break;
-    }
-    case 4: {
-      uint32_t *buf = vbuf;
-      for (uint32_t i = 0; i < num; i++)
-        buf[i] = ddsrt_bswap4u (buf[i]);
-      break;
-    }
-    case 8: {
-      uint64_t *buf = vbuf;
-      for (uint32_t i = 0; i < num; i++)
-        buf[i] = ddsrt_bswap8u (buf[i]);
-      break;
-    }
+    case 1: break;
+    case 2: ddsrt_bswap2u_array (vbuf, num); break;
+    case 4: ddsrt_bswap4u_array (vbuf, num); break;
+    case 8: ddsrt_bswap8u_array (vbuf, num); break;
   }
 }
 
@@ -1742,31 +1969,22 @@ static const uint32_t *dds_stream_extract_key_from_data_skip_array (dds_istream_
   else
   {
     dds_stream_extract_key_from_data_skip_subtype (is, num, subtype, NULL);
-    return ops + 3;
+    return ops + (subtype == DDS_OP_VAL_BST ? 5 : 3);
   }
 }
 
 static const uint32_t *dds_stream_extract_key_from_data_skip_sequence (dds_istream_t * __restrict is, const uint32_t * __restrict ops)
 {
   const uint32_t op = *ops;
-  const enum dds_stream_typecode type = DDS_OP_TYPE (op);
-  assert (type == DDS_OP_VAL_SEQ);
+  assert (DDS_OP_TYPE (op) == DDS_OP_VAL_SEQ);
   const uint32_t subtype = DDS_OP_SUBTYPE (op);
   const uint32_t num = dds_is_get4 (is);
-  if (num == 0)
-    return ops + 2 + (type == DDS_OP_VAL_BST || type == DDS_OP_VAL_ARR);
-  else if (subtype > DDS_OP_VAL_BST)
+  if (num > 0)
   {
-    const uint32_t * jsr_ops = ops + DDS_OP_ADR_JSR (ops[3]);
-    const uint32_t jmp = DDS_OP_ADR_JMP (ops[3]);
+    const uint32_t *jsr_ops = (subtype > DDS_OP_VAL_BST) ? ops + DDS_OP_ADR_JSR (ops[3]) : NULL;
     dds_stream_extract_key_from_data_skip_subtype (is, num, subtype, jsr_ops);
-    return ops + (jmp ? jmp : 4);
-  }
-  else
-  {
-    dds_stream_extract_key_from_data_skip_subtype (is, num, subtype, NULL);
-    return ops + 2 + (type == DDS_OP_VAL_BST || type == DDS_OP_VAL_ARR);
   }
+  return skip_sequence_insns (ops, op);
 }
 
 static const uint32_t *dds_stream_extract_key_from_data_skip_union (dds_istream_t * __restrict is, const uint32_t * __restrict ops)
@@ -1780,6 +1998,56 @@ static const uint32_t *dds_stream_extract_key_from_data_skip_union (dds_istream_
   return ops + DDS_OP_ADR_JMP (ops[3]);
 }
 
+const uint32_t *dds_stream_skip_adr (dds_istream_t * __restrict is, const uint32_t * __restrict ops)
+{
+  const uint32_t type = DDS_OP_TYPE (ops[0]);
+  assert (DDS_OP (ops[0]) == DDS_OP_ADR);
+  switch (type)
+  {
+    case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY: case DDS_OP_VAL_STR: case DDS_OP_VAL_BST:
+      dds_stream_extract_key_from_data_skip_subtype (is, 1, type, NULL);
+      return ops + 2 + (type == DDS_OP_VAL_BST || type == DDS_OP_VAL_ARR);
+    case DDS_OP_VAL_SEQ:
+      return dds_stream_extract_key_from_data_skip_sequence (is, ops);
+    case DDS_OP_VAL_ARR:
+      return dds_stream_extract_key_from_data_skip_array (is, ops);
+    case DDS_OP_VAL_UNI:
+      return dds_stream_extract_key_from_data_skip_union (is, ops);
+    case DDS_OP_VAL_STU:
+      abort ();
+  }
+  return NULL;
+}
+
+const uint32_t *dds_stream_skip_adr_insns (const uint32_t * __restrict ops)
+{
+  const uint32_t insn = ops[0];
+  assert (DDS_OP (insn) == DDS_OP_ADR);
+  switch (DDS_OP_TYPE (insn))
+  {
+    case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY: case DDS_OP_VAL_STR:
+      return ops + 2;
+    case DDS_OP_VAL_BST:
+      return ops + 3;
+    case DDS_OP_VAL_SEQ:
+      return skip_sequence_insns (ops, insn);
+    case DDS_OP_VAL_ARR: {
+      const uint32_t subtype = DDS_OP_SUBTYPE (insn);
+      if (subtype > DDS_OP_VAL_BST)
+      {
+        const uint32_t jmp = DDS_OP_ADR_JMP (ops[3]);
+        return ops + (jmp ? jmp : 5);
+      }
+      return ops + (subtype == DDS_OP_VAL_BST ? 5 : 3);
+    }
+    case DDS_OP_VAL_UNI:
+      return ops + DDS_OP_ADR_JMP (ops[3]);
+    case DDS_OP_VAL_STU:
+      break;
+  }
+  return NULL;
+}
+
 static void dds_stream_extract_key_from_data1 (dds_istream_t * __restrict is, dds_ostream_t * __restrict os, const uint32_t * __restrict ops, uint32_t * __restrict keys_remaining)
 {
   uint32_t op;
@@ -1799,24 +2067,7 @@ static void dds_stream_extract_key_from_data1 (dds_istream_t * __restrict is, dd
         }
         else
         {
-          switch (type)
-          {
-            case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY: case DDS_OP_VAL_STR: case DDS_OP_VAL_BST:
-              dds_stream_extract_key_from_data_skip_subtype (is, 1, type, NULL);
-              ops += 2 + (type == DDS_OP_VAL_BST || type == DDS_OP_VAL_ARR);
-              break;
-            case DDS_OP_VAL_SEQ:
-              ops = dds_stream_extract_key_from_data_skip_sequence (is, ops);
-              break;
-            case DDS_OP_VAL_ARR:
-              ops = dds_stream_extract_key_from_data_skip_array (is, ops);
-              break;
-            case DDS_OP_VAL_UNI:
-              ops = dds_stream_extract_key_from_data_skip_union (is, ops);
-              break;
-            case DDS_OP_VAL_STU:
-              abort ();
-          }
+          ops = dds_stream_skip_adr (is, ops);
         }
         break;
       }
@@ -1855,24 +2106,7 @@ static void dds_stream_extract_keyBE_from_data1 (dds_istream_t * __restrict is,
         }
         else
         {
-          switch (type)
-          {
-            case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY: case DDS_OP_VAL_STR: case DDS_OP_VAL_BST:
-              dds_stream_extract_key_from_data_skip_subtype (is, 1, type, NULL);
-              ops += 2 + (type == DDS_OP_VAL_BST || type == DDS_OP_VAL_ARR);
-              break;
-            case DDS_OP_VAL_SEQ:
-              ops = dds_stream_extract_key_from_data_skip_sequence (is, ops);
-              break;
-            case DDS_OP_VAL_ARR:
-              ops = dds_stream_extract_key_from_data_skip_array (is, ops);
-              break;
-            case DDS_OP_VAL_UNI:
-              ops = dds_stream_extract_key_from_data_skip_union (is, ops);
-              break;
-            case DDS_OP_VAL_STU:
-              abort ();
-          }
+          ops = dds_stream_skip_adr (is, ops);
         }
         break;
       }
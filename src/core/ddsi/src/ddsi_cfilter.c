@@ -0,0 +1,792 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/strtol.h"
+#include "dds/ddsrt/strtod.h"
+#include "dds/ddsi/ddsi_sertype.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_serdata_default.h"
+#include "dds/ddsi/ddsi_cdrstream.h"
+#include "dds/ddsi/ddsi_cfilter.h"
+
+/* Limits on the complexity of an expression: number of distinct fields,
+   depth of the evaluation stack and nesting of parentheses/NOTs */
+#define CF_MAX_FIELDS 16
+#define CF_MAX_DEPTH 32
+#define CF_MAX_NESTING 64
+
+/* Operand indices with this bit set refer to constants, others to fields */
+#define CF_CONST 0x8000u
+#define CF_MAX_CONSTS 0x7fffu
+
+enum cf_vkind { CFV_SIGNED, CFV_UNSIGNED, CFV_DOUBLE, CFV_STRING };
+
+struct cf_value {
+  enum cf_vkind kind;
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char *s;
+  } v;
+};
+
+enum cf_relop { CFR_EQ, CFR_NE, CFR_LT, CFR_LE, CFR_GT, CFR_GE };
+enum cf_opcode { CFI_CMP, CFI_AND, CFI_OR, CFI_NOT };
+
+struct cf_insn {
+  uint8_t opcode;  /* enum cf_opcode */
+  uint8_t relop;   /* enum cf_relop, for CFI_CMP */
+  uint16_t a, b;   /* operands, for CFI_CMP */
+};
+
+struct cf_field {
+  uint32_t op;      /* index of the ADR instruction */
+  uint32_t offset;  /* offset in payload if at a fixed position, else UINT32_MAX */
+  uint32_t size;    /* 1, 2, 4, 8 for numbers, 0 for strings */
+  enum cf_vkind kind;
+};
+
+struct ddsi_cfilter {
+  const uint32_t *ops;
+  uint32_t nfields;
+  struct cf_field fields[CF_MAX_FIELDS];
+  uint32_t order[CF_MAX_FIELDS]; /* field indices in order of occurrence in the data */
+  uint32_t walk_op;              /* first instruction not at a fixed offset */
+  uint32_t walk_offset;          /* payload offset at which walk_op starts (unaligned) */
+  uint32_t nconsts;
+  struct cf_value *consts;
+  uint32_t ninsns;
+  struct cf_insn *insns;
+};
+
+enum cf_tokkind {
+  CFT_END, CFT_ERROR, CFT_LPAREN, CFT_RPAREN, CFT_AND, CFT_OR, CFT_NOT, CFT_TRUE, CFT_FALSE,
+  CFT_RELOP, CFT_IDENT, CFT_INT, CFT_FLOAT, CFT_STRING, CFT_PARAM
+};
+
+struct cf_token {
+  enum cf_tokkind kind;
+  enum cf_relop relop;
+  const char *s;
+  size_t n;
+};
+
+struct cf_parser {
+  const char *p;
+  struct cf_token tok;
+  const struct ddsi_sertype_default_desc *desc;
+  uint32_t nparams;
+  char * const *params;
+  struct ddsi_cfilter *f;
+  uint32_t maxinsns, maxconsts;
+  uint32_t depth, nesting;
+};
+
+static const char *cf_lex (const char *p, struct cf_token *t)
+{
+  static const struct { const char *kw; enum cf_tokkind kind; } keywords[] = {
+    { "AND", CFT_AND }, { "OR", CFT_OR }, { "NOT", CFT_NOT }, { "TRUE", CFT_TRUE }, { "FALSE", CFT_FALSE }
+  };
+  while (isspace ((unsigned char) *p))
+    p++;
+  const char *q = p;
+  t->s = p;
+  if (*q == 0)
+    t->kind = CFT_END;
+  else if (isalpha ((unsigned char) *q) || *q == '_')
+  {
+    while (isalnum ((unsigned char) *q) || *q == '_' || *q == '.')
+      q++;
+    t->kind = CFT_IDENT;
+    for (size_t i = 0; i < sizeof (keywords) / sizeof (keywords[0]); i++)
+      if ((size_t) (q - p) == strlen (keywords[i].kw) && ddsrt_strncasecmp (p, keywords[i].kw, (size_t) (q - p)) == 0)
+        t->kind = keywords[i].kind;
+  }
+  else if (isdigit ((unsigned char) *q) ||
+           ((*q == '-' || *q == '+') && (isdigit ((unsigned char) q[1]) || (q[1] == '.' && isdigit ((unsigned char) q[2])))) ||
+           (*q == '.' && isdigit ((unsigned char) q[1])))
+  {
+    bool isfloat = false;
+    if (*q == '-' || *q == '+')
+      q++;
+    while (isdigit ((unsigned char) *q))
+      q++;
+    if (*q == '.')
+    {
+      isfloat = true;
+      for (q++; isdigit ((unsigned char) *q); q++)
+        ;
+    }
+    if ((*q == 'e' || *q == 'E') && (isdigit ((unsigned char) q[1]) || ((q[1] == '-' || q[1] == '+') && isdigit ((unsigned char) q[2]))))
+    {
+      isfloat = true;
+      for (q += 2; isdigit ((unsigned char) *q); q++)
+        ;
+    }
+    t->kind = isfloat ? CFT_FLOAT : CFT_INT;
+  }
+  else if (*q == '\'')
+  {
+    t->kind = CFT_STRING;
+    for (q++; t->kind == CFT_STRING; )
+    {
+      if (*q == 0)
+        t->kind = CFT_ERROR;
+      else if (*q == '\'' && q[1] == '\'')
+        q += 2;
+      else if (*q++ == '\'')
+        break;
+    }
+  }
+  else if (*q == '%' && isdigit ((unsigned char) q[1]))
+  {
+    for (q++; isdigit ((unsigned char) *q); q++)
+      ;
+    t->kind = CFT_PARAM;
+  }
+  else
+  {
+    t->kind = CFT_RELOP;
+    switch (*q++)
+    {
+      case '(': t->kind = CFT_LPAREN; break;
+      case ')': t->kind = CFT_RPAREN; break;
+      case '=': t->relop = CFR_EQ; break;
+      case '<':
+        if (*q == '>') { t->relop = CFR_NE; q++; }
+        else if (*q == '=') { t->relop = CFR_LE; q++; }
+        else t->relop = CFR_LT;
+        break;
+      case '>':
+        if (*q == '=') { t->relop = CFR_GE; q++; }
+        else t->relop = CFR_GT;
+        break;
+      case '!':
+        if (*q == '=') { t->relop = CFR_NE; q++; }
+        else t->kind = CFT_ERROR;
+        break;
+      default:
+        t->kind = CFT_ERROR;
+        break;
+    }
+  }
+  t->n = (size_t) (q - p);
+  return q;
+}
+
+static void cf_next (struct cf_parser *ps)
+{
+  ps->p = cf_lex (ps->p, &ps->tok);
+}
+
+static dds_return_t cf_literal (const struct cf_token *t, struct cf_value *v)
+{
+  dds_return_t rc = DDS_RETCODE_OK;
+  switch (t->kind)
+  {
+    case CFT_TRUE: case CFT_FALSE:
+      v->kind = CFV_UNSIGNED;
+      v->v.u = (t->kind == CFT_TRUE);
+      break;
+    case CFT_INT: {
+      char *s = ddsrt_strndup (t->s, t->n);
+      long long ll;
+      unsigned long long ull;
+      if (ddsrt_strtoll (s, NULL, 10, &ll) == DDS_RETCODE_OK)
+      {
+        v->kind = CFV_SIGNED;
+        v->v.i = ll;
+      }
+      else if (s[0] != '-' && ddsrt_strtoull (s, NULL, 10, &ull) == DDS_RETCODE_OK)
+      {
+        v->kind = CFV_UNSIGNED;
+        v->v.u = ull;
+      }
+      else
+      {
+        rc = DDS_RETCODE_BAD_PARAMETER;
+      }
+      ddsrt_free (s);
+      break;
+    }
+    case CFT_FLOAT: {
+      char *s = ddsrt_strndup (t->s, t->n);
+      v->kind = CFV_DOUBLE;
+      rc = ddsrt_strtod (s, NULL, &v->v.d);
+      ddsrt_free (s);
+      break;
+    }
+    case CFT_STRING: {
+      /* strip quotes and collapse '' into ' */
+      char *s = ddsrt_malloc (t->n - 1), *d = s;
+      for (size_t i = 1; i < t->n - 1; i++)
+      {
+        *d++ = t->s[i];
+        if (t->s[i] == '\'')
+          i++;
+      }
+      *d = 0;
+      v->kind = CFV_STRING;
+      v->v.s = s;
+      break;
+    }
+    default:
+      rc = DDS_RETCODE_BAD_PARAMETER;
+      break;
+  }
+  return rc;
+}
+
+static dds_return_t cf_add_const (struct cf_parser *ps, const struct cf_value *v, uint16_t *idx)
+{
+  struct ddsi_cfilter * const f = ps->f;
+  if (f->nconsts == CF_MAX_CONSTS)
+  {
+    if (v->kind == CFV_STRING)
+      ddsrt_free ((char *) v->v.s);
+    return DDS_RETCODE_BAD_PARAMETER;
+  }
+  if (f->nconsts == ps->maxconsts)
+  {
+    ps->maxconsts = ps->maxconsts ? 2 * ps->maxconsts : 4;
+    f->consts = ddsrt_realloc (f->consts, ps->maxconsts * sizeof (*f->consts));
+  }
+  f->consts[f->nconsts] = *v;
+  *idx = (uint16_t) (CF_CONST | f->nconsts++);
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t cf_param (struct cf_parser *ps, struct cf_value *v)
+{
+  unsigned long long n;
+  char *s = ddsrt_strndup (ps->tok.s + 1, ps->tok.n - 1);
+  dds_return_t rc = ddsrt_strtoull (s, NULL, 10, &n);
+  ddsrt_free (s);
+  if (rc != DDS_RETCODE_OK || n >= ps->nparams || ps->params[n] == NULL)
+    return DDS_RETCODE_BAD_PARAMETER;
+
+  /* Parameters are literals, but a parameter that isn't one is taken as a
+     string; this saves quoting the value of a string parameter */
+  const char *param = ps->params[n];
+  struct cf_token t;
+  const char *end = cf_lex (param, &t);
+  while (isspace ((unsigned char) *end))
+    end++;
+  switch (t.kind)
+  {
+    case CFT_TRUE: case CFT_FALSE: case CFT_INT: case CFT_FLOAT: case CFT_STRING:
+      if (*end == 0)
+        return cf_literal (&t, v);
+      break;
+    default:
+      break;
+  }
+  v->kind = CFV_STRING;
+  v->v.s = ddsrt_strdup (param);
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t cf_field (struct cf_parser *ps, uint16_t *idx, bool *isstr)
+{
+  const struct ddsi_sertype_default_desc * const desc = ps->desc;
+  struct ddsi_cfilter * const f = ps->f;
+  uint32_t k;
+  for (k = 0; k < desc->keys.nkeys; k++)
+    if (strlen (desc->keynames[k]) == ps->tok.n && memcmp (desc->keynames[k], ps->tok.s, ps->tok.n) == 0)
+      break;
+  if (k == desc->keys.nkeys)
+    return DDS_RETCODE_BAD_PARAMETER;
+
+  struct cf_field fd = { .op = desc->keys.keys[k], .offset = UINT32_MAX };
+  if (fd.op >= desc->ops.nops)
+    return DDS_RETCODE_BAD_PARAMETER;
+  const uint32_t insn = desc->ops.ops[fd.op];
+  if (DDS_OP (insn) != DDS_OP_ADR)
+    return DDS_RETCODE_UNSUPPORTED;
+  switch (DDS_OP_TYPE (insn))
+  {
+    case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+      fd.size = 1u << (DDS_OP_TYPE (insn) - DDS_OP_VAL_1BY);
+      if ((insn & DDS_OP_FLAG_FP) && fd.size >= 4)
+        fd.kind = CFV_DOUBLE;
+      else
+        fd.kind = (insn & DDS_OP_FLAG_SGN) ? CFV_SIGNED : CFV_UNSIGNED;
+      break;
+    case DDS_OP_VAL_STR: case DDS_OP_VAL_BST:
+      fd.size = 0;
+      fd.kind = CFV_STRING;
+      break;
+    default:
+      return DDS_RETCODE_UNSUPPORTED;
+  }
+  *isstr = (fd.kind == CFV_STRING);
+
+  uint32_t i;
+  for (i = 0; i < f->nfields; i++)
+    if (f->fields[i].op == fd.op)
+      break;
+  if (i == f->nfields)
+  {
+    if (f->nfields == CF_MAX_FIELDS)
+      return DDS_RETCODE_UNSUPPORTED;
+    f->fields[f->nfields++] = fd;
+  }
+  *idx = (uint16_t) i;
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t cf_operand (struct cf_parser *ps, uint16_t *idx, bool *isstr)
+{
+  struct cf_value v;
+  dds_return_t rc;
+  switch (ps->tok.kind)
+  {
+    case CFT_IDENT:
+      rc = cf_field (ps, idx, isstr);
+      break;
+    case CFT_TRUE: case CFT_FALSE: case CFT_INT: case CFT_FLOAT: case CFT_STRING:
+      if ((rc = cf_literal (&ps->tok, &v)) == DDS_RETCODE_OK)
+      {
+        *isstr = (v.kind == CFV_STRING);
+        rc = cf_add_const (ps, &v, idx);
+      }
+      break;
+    case CFT_PARAM:
+      if ((rc = cf_param (ps, &v)) == DDS_RETCODE_OK)
+      {
+        *isstr = (v.kind == CFV_STRING);
+        rc = cf_add_const (ps, &v, idx);
+      }
+      break;
+    default:
+      rc = DDS_RETCODE_BAD_PARAMETER;
+      break;
+  }
+  if (rc == DDS_RETCODE_OK)
+    cf_next (ps);
+  return rc;
+}
+
+static dds_return_t cf_emit (struct cf_parser *ps, enum cf_opcode opcode, enum cf_relop relop, uint16_t a, uint16_t b)
+{
+  struct ddsi_cfilter * const f = ps->f;
+  if (opcode == CFI_CMP && ++ps->depth > CF_MAX_DEPTH)
+    return DDS_RETCODE_BAD_PARAMETER;
+  else if (opcode == CFI_AND || opcode == CFI_OR)
+    ps->depth--;
+  if (f->ninsns == ps->maxinsns)
+  {
+    ps->maxinsns = ps->maxinsns ? 2 * ps->maxinsns : 8;
+    f->insns = ddsrt_realloc (f->insns, ps->maxinsns * sizeof (*f->insns));
+  }
+  f->insns[f->ninsns++] = (struct cf_insn) { .opcode = (uint8_t) opcode, .relop = (uint8_t) relop, .a = a, .b = b };
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t cf_parse_or (struct cf_parser *ps);
+
+static dds_return_t cf_parse_cmp (struct cf_parser *ps)
+{
+  uint16_t a, b;
+  bool astr, bstr;
+  dds_return_t rc;
+  if ((rc = cf_operand (ps, &a, &astr)) != DDS_RETCODE_OK)
+    return rc;
+  if (ps->tok.kind != CFT_RELOP)
+    return DDS_RETCODE_BAD_PARAMETER;
+  const enum cf_relop relop = ps->tok.relop;
+  cf_next (ps);
+  if ((rc = cf_operand (ps, &b, &bstr)) != DDS_RETCODE_OK)
+    return rc;
+  if (astr != bstr)
+    return DDS_RETCODE_BAD_PARAMETER;
+  return cf_emit (ps, CFI_CMP, relop, a, b);
+}
+
+static dds_return_t cf_parse_not (struct cf_parser *ps)
+{
+  dds_return_t rc;
+  if (ps->tok.kind != CFT_NOT && ps->tok.kind != CFT_LPAREN)
+    return cf_parse_cmp (ps);
+  if (++ps->nesting > CF_MAX_NESTING)
+    return DDS_RETCODE_BAD_PARAMETER;
+  if (ps->tok.kind == CFT_NOT)
+  {
+    cf_next (ps);
+    if ((rc = cf_parse_not (ps)) == DDS_RETCODE_OK)
+      rc = cf_emit (ps, CFI_NOT, CFR_EQ, 0, 0);
+  }
+  else
+  {
+    cf_next (ps);
+    if ((rc = cf_parse_or (ps)) == DDS_RETCODE_OK)
+    {
+      if (ps->tok.kind == CFT_RPAREN)
+        cf_next (ps);
+      else
+        rc = DDS_RETCODE_BAD_PARAMETER;
+    }
+  }
+  ps->nesting--;
+  return rc;
+}
+
+static dds_return_t cf_parse_and (struct cf_parser *ps)
+{
+  dds_return_t rc;
+  if ((rc = cf_parse_not (ps)) != DDS_RETCODE_OK)
+    return rc;
+  while (ps->tok.kind == CFT_AND)
+  {
+    cf_next (ps);
+    if ((rc = cf_parse_not (ps)) != DDS_RETCODE_OK || (rc = cf_emit (ps, CFI_AND, CFR_EQ, 0, 0)) != DDS_RETCODE_OK)
+      return rc;
+  }
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t cf_parse_or (struct cf_parser *ps)
+{
+  dds_return_t rc;
+  if ((rc = cf_parse_and (ps)) != DDS_RETCODE_OK)
+    return rc;
+  while (ps->tok.kind == CFT_OR)
+  {
+    cf_next (ps);
+    if ((rc = cf_parse_and (ps)) != DDS_RETCODE_OK || (rc = cf_emit (ps, CFI_OR, CFR_EQ, 0, 0)) != DDS_RETCODE_OK)
+      return rc;
+  }
+  return DDS_RETCODE_OK;
+}
+
+static dds_return_t cf_layout (struct ddsi_cfilter *f)
+{
+  /* Members of fixed size preceding the first variable-size one are at a
+     fixed offset in the payload; anything following it requires walking the
+     data.  Key fields are always in the top-level instruction stream. */
+  const uint32_t *ops = f->ops;
+  uint32_t i = 0, off = 0;
+  bool fixed = true;
+  while (fixed && DDS_OP (ops[i]) == DDS_OP_ADR)
+  {
+    const uint32_t insn = ops[i];
+    uint32_t size = 0, num = 1, next = i;
+    switch (DDS_OP_TYPE (insn))
+    {
+      case DDS_OP_VAL_1BY: case DDS_OP_VAL_2BY: case DDS_OP_VAL_4BY: case DDS_OP_VAL_8BY:
+        size = 1u << (DDS_OP_TYPE (insn) - DDS_OP_VAL_1BY);
+        next = i + 2;
+        break;
+      case DDS_OP_VAL_ARR:
+        if (DDS_OP_SUBTYPE (insn) >= DDS_OP_VAL_1BY && DDS_OP_SUBTYPE (insn) <= DDS_OP_VAL_8BY)
+        {
+          size = 1u << (DDS_OP_SUBTYPE (insn) - DDS_OP_VAL_1BY);
+          num = ops[i + 2];
+          next = i + 3;
+        }
+        break;
+      default:
+        break;
+    }
+    if (size == 0)
+      fixed = false;
+    else
+    {
+      off = (off + size - 1) & ~(size - 1);
+      for (uint32_t j = 0; j < f->nfields; j++)
+        if (f->fields[j].op == i)
+          f->fields[j].offset = off;
+      off += num * size;
+      i = next;
+    }
+  }
+  f->walk_op = i;
+  f->walk_offset = off;
+
+  /* The others are found by skipping members from walk_op onwards, which only
+     reaches fields that start an instruction in the top-level stream: keys in
+     a nested one (e.g., the element type of a sequence) or beyond the end of
+     the instructions can't be extracted */
+  for (uint32_t j = 0; j < f->nfields; j++)
+  {
+    if (f->fields[j].offset != UINT32_MAX)
+      continue;
+    const uint32_t *op = ops + i, * const target = ops + f->fields[j].op;
+    while (op != NULL && op < target && DDS_OP (*op) == DDS_OP_ADR)
+      op = dds_stream_skip_adr_insns (op);
+    if (op != target)
+      return DDS_RETCODE_BAD_PARAMETER;
+  }
+
+  /* Fields are extracted in a single pass, so order them by position */
+  for (uint32_t j = 0; j < f->nfields; j++)
+  {
+    uint32_t k = j;
+    while (k > 0 && f->fields[f->order[k - 1]].op > f->fields[j].op)
+    {
+      f->order[k] = f->order[k - 1];
+      k--;
+    }
+    f->order[k] = j;
+  }
+  return DDS_RETCODE_OK;
+}
+
+dds_return_t ddsi_cfilter_compile (struct ddsi_cfilter **filter, const struct ddsi_sertype *type, const char *expr, uint32_t nparams, char * const *params)
+{
+  if (type->ops != &ddsi_sertype_ops_default)
+    return DDS_RETCODE_UNSUPPORTED;
+  const struct ddsi_sertype_default *st = (const struct ddsi_sertype_default *) type;
+  if (st->type.keys.nkeys > 0 && st->type.keynames == NULL)
+    return DDS_RETCODE_UNSUPPORTED;
+  if (expr == NULL || (nparams > 0 && params == NULL))
+    return DDS_RETCODE_BAD_PARAMETER;
+
+  struct ddsi_cfilter *f = ddsrt_malloc (sizeof (*f));
+  f->ops = st->type.ops.ops;
+  f->nfields = 0;
+  f->nconsts = 0;
+  f->consts = NULL;
+  f->ninsns = 0;
+  f->insns = NULL;
+
+  struct cf_parser ps = {
+    .p = expr, .desc = &st->type, .nparams = nparams, .params = params, .f = f,
+    .maxinsns = 0, .maxconsts = 0, .depth = 0, .nesting = 0
+  };
+  dds_return_t rc;
+  cf_next (&ps);
+  if ((rc = cf_parse_or (&ps)) == DDS_RETCODE_OK && ps.tok.kind != CFT_END)
+    rc = DDS_RETCODE_BAD_PARAMETER;
+  if (rc == DDS_RETCODE_OK)
+    rc = cf_layout (f);
+  if (rc != DDS_RETCODE_OK)
+  {
+    ddsi_cfilter_free (f);
+    return rc;
+  }
+  assert (ps.depth == 1);
+  *filter = f;
+  return DDS_RETCODE_OK;
+}
+
+void ddsi_cfilter_free (struct ddsi_cfilter *filter)
+{
+  if (filter == NULL)
+    return;
+  for (uint32_t i = 0; i < filter->nconsts; i++)
+    if (filter->consts[i].kind == CFV_STRING)
+      ddsrt_free ((char *) filter->consts[i].v.s);
+  ddsrt_free (filter->consts);
+  ddsrt_free (filter->insns);
+  ddsrt_free (filter);
+}
+
+static void cf_load (const struct cf_field *fd, const unsigned char *p, struct cf_value *v)
+{
+  v->kind = fd->kind;
+  switch (fd->size)
+  {
+    case 0:
+      v->v.s = (const char *) p + 4;
+      break;
+    case 1:
+      if (fd->kind == CFV_SIGNED) v->v.i = (int8_t) *p; else v->v.u = *p;
+      break;
+    case 2: {
+      uint16_t x;
+      memcpy (&x, p, sizeof (x));
+      if (fd->kind == CFV_SIGNED) v->v.i = (int16_t) x; else v->v.u = x;
+      break;
+    }
+    case 4: {
+      uint32_t x;
+      memcpy (&x, p, sizeof (x));
+      if (fd->kind == CFV_DOUBLE) {
+        float fx;
+        memcpy (&fx, &x, sizeof (fx));
+        v->v.d = fx;
+      }
+      else if (fd->kind == CFV_SIGNED) v->v.i = (int32_t) x;
+      else v->v.u = x;
+      break;
+    }
+    case 8: {
+      uint64_t x;
+      memcpy (&x, p, sizeof (x));
+      if (fd->kind == CFV_DOUBLE) memcpy (&v->v.d, &x, sizeof (v->v.d));
+      else if (fd->kind == CFV_SIGNED) v->v.i = (int64_t) x;
+      else v->v.u = x;
+      break;
+    }
+  }
+}
+
+static bool cf_load_fields (const struct ddsi_cfilter *f, const struct ddsi_serdata_default *d, struct cf_value *fv)
+{
+  const unsigned char *data = (const unsigned char *) d->data;
+  uint32_t j;
+  for (j = 0; j < f->nfields && f->fields[f->order[j]].offset != UINT32_MAX; j++)
+  {
+    const struct cf_field *fd = &f->fields[f->order[j]];
+    assert (fd->size > 0);
+    if (fd->offset + fd->size > d->pos)
+      return false;
+    cf_load (fd, data + fd->offset, &fv[f->order[j]]);
+  }
+  if (j == f->nfields)
+    return true;
+
+  dds_istream_t is;
+  dds_istream_from_serdata_default (&is, d);
+  const uint32_t limit = is.m_index + d->pos;
+  const uint32_t *ops = f->ops + f->walk_op;
+  is.m_index += f->walk_offset;
+  for (; j < f->nfields; j++)
+  {
+    const struct cf_field *fd = &f->fields[f->order[j]];
+    const uint32_t *target = f->ops + fd->op;
+    while (ops < target)
+    {
+      assert (DDS_OP (*ops) == DDS_OP_ADR);
+      if (is.m_index > limit)
+        return false;
+      ops = dds_stream_skip_adr (&is, ops);
+    }
+    assert (ops == target);
+    const uint32_t align = fd->size ? fd->size : 4;
+    is.m_index = (is.m_index + align - 1) & ~(align - 1);
+    if (is.m_index + align > limit)
+      return false;
+    const unsigned char *p = is.m_buffer + is.m_index;
+    if (fd->size > 0)
+      is.m_index += fd->size;
+    else
+    {
+      uint32_t len;
+      memcpy (&len, p, sizeof (len));
+      if (len == 0 || len > limit - is.m_index - 4)
+        return false;
+      is.m_index += 4 + len;
+    }
+    cf_load (fd, p, &fv[f->order[j]]);
+    ops += 2 + (DDS_OP_TYPE (*ops) == DDS_OP_VAL_BST);
+  }
+  return true;
+}
+
+static double cf_todouble (const struct cf_value *v)
+{
+  switch (v->kind)
+  {
+    case CFV_SIGNED: return (double) v->v.i;
+    case CFV_UNSIGNED: return (double) v->v.u;
+    case CFV_DOUBLE: return v->v.d;
+    case CFV_STRING: break;
+  }
+  assert (0);
+  return 0.0;
+}
+
+/* -1, 0, 1 for a < b, a = b, a > b; 2 if unordered (NaN) */
+static int cf_compare (const struct cf_value *a, const struct cf_value *b)
+{
+  if (a->kind == CFV_STRING)
+  {
+    assert (b->kind == CFV_STRING);
+    const int c = strcmp (a->v.s, b->v.s);
+    return (c < 0) ? -1 : (c > 0);
+  }
+  else if (a->kind == CFV_DOUBLE || b->kind == CFV_DOUBLE)
+  {
+    const double x = cf_todouble (a), y = cf_todouble (b);
+    return (x < y) ? -1 : (x > y) ? 1 : (x == y) ? 0 : 2;
+  }
+  else if (a->kind == CFV_SIGNED && b->kind == CFV_SIGNED)
+    return (a->v.i < b->v.i) ? -1 : (a->v.i > b->v.i);
+  else if (a->kind == CFV_SIGNED && a->v.i < 0)
+    return -1;
+  else if (b->kind == CFV_SIGNED && b->v.i < 0)
+    return 1;
+  else
+  {
+    /* both non-negative, so both representable as unsigned */
+    const uint64_t x = (a->kind == CFV_SIGNED) ? (uint64_t) a->v.i : a->v.u;
+    const uint64_t y = (b->kind == CFV_SIGNED) ? (uint64_t) b->v.i : b->v.u;
+    return (x < y) ? -1 : (x > y);
+  }
+}
+
+static bool cf_relop_holds (enum cf_relop relop, int c)
+{
+  if (c == 2)
+    return relop == CFR_NE;
+  switch (relop)
+  {
+    case CFR_EQ: return c == 0;
+    case CFR_NE: return c != 0;
+    case CFR_LT: return c < 0;
+    case CFR_LE: return c <= 0;
+    case CFR_GT: return c > 0;
+    case CFR_GE: return c >= 0;
+  }
+  return false;
+}
+
+bool ddsi_cfilter_accepts (const struct ddsi_cfilter *filter, const struct ddsi_serdata *sd)
+{
+  if (sd->kind != SDK_DATA || (sd->ops != &ddsi_serdata_ops_cdr && sd->ops != &ddsi_serdata_ops_cdr_nokey))
+    return true;
+  const struct ddsi_serdata_default *d = ddsi_serdata_default_unpin (sd);
+  struct cf_value fv[CF_MAX_FIELDS];
+  if (!cf_load_fields (filter, d, fv))
+    return true;
+
+  bool stk[CF_MAX_DEPTH];
+  uint32_t sp = 0;
+  for (uint32_t i = 0; i < filter->ninsns; i++)
+  {
+    const struct cf_insn *insn = &filter->insns[i];
+    switch ((enum cf_opcode) insn->opcode)
+    {
+      case CFI_CMP: {
+        const struct cf_value *a = (insn->a & CF_CONST) ? &filter->consts[insn->a & ~CF_CONST] : &fv[insn->a];
+        const struct cf_value *b = (insn->b & CF_CONST) ? &filter->consts[insn->b & ~CF_CONST] : &fv[insn->b];
+        assert (sp < CF_MAX_DEPTH);
+        stk[sp++] = cf_relop_holds ((enum cf_relop) insn->relop, cf_compare (a, b));
+        break;
+      }
+      case CFI_AND:
+        assert (sp >= 2);
+        sp--;
+        stk[sp - 1] = stk[sp - 1] && stk[sp];
+        break;
+      case CFI_OR:
+        assert (sp >= 2);
+        sp--;
+        stk[sp - 1] = stk[sp - 1] || stk[sp];
+        break;
+      case CFI_NOT:
+        assert (sp >= 1);
+        stk[sp - 1] = !stk[sp - 1];
+        break;
+    }
+  }
+  assert (sp == 1);
+  return stk[0];
+}
@@ -30,6 +30,7 @@ struct entity_index {
   struct ddsrt_chh *guid_hash;
   ddsrt_mutex_t all_entities_lock;
   ddsrt_avl_tree_t all_entities;
+  ddsrt_avl_tree_t builtin_endpoints; /* protected by all_entities_lock */
 };
 
 static const uint64_t unihashconsts[] = {
@@ -43,6 +44,13 @@ static int all_entities_compare (const void *va, const void *vb);
 static const ddsrt_avl_treedef_t all_entities_treedef =
   DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct entity_common, all_entities_avlnode), 0, all_entities_compare, 0);
 
+/* Builtin endpoints are matched on entity id rather than on topic name, this
+   index allows enumerating all (proxy) endpoints with a specific builtin
+   entity id without having to visit all (proxy) participants */
+static int builtin_endpoints_compare (const void *va, const void *vb);
+static const ddsrt_avl_treedef_t builtin_endpoints_treedef =
+  DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct entity_common, builtin_endpoints_avlnode), 0, builtin_endpoints_compare, 0);
+
 static uint32_t hash_entity_guid (const struct entity_common *c)
 {
   return
@@ -137,6 +145,33 @@ static int all_entities_compare (const void *va, const void *vb)
     return memcmp (&a->guid, &b->guid, sizeof (a->guid));
 }
 
+static int builtin_endpoints_compare (const void *va, const void *vb)
+{
+  const struct entity_common *a = va;
+  const struct entity_common *b = vb;
+  if (a->kind != b->kind)
+    return (int) a->kind - (int) b->kind;
+  else if (a->guid.entityid.u != b->guid.entityid.u)
+    return (a->guid.entityid.u < b->guid.entityid.u) ? -1 : 1;
+  else
+    return memcmp (&a->guid.prefix, &b->guid.prefix, sizeof (a->guid.prefix));
+}
+
+static bool in_builtin_endpoints (const struct entity_common *e)
+{
+  switch (e->kind)
+  {
+    case EK_WRITER:
+    case EK_READER:
+    case EK_PROXY_WRITER:
+    case EK_PROXY_READER:
+      /* same test as used for matching */
+      return is_builtin_entityid (e->guid.entityid, NN_VENDORID_ECLIPSE) && !is_local_orphan_endpoint (e);
+    default:
+      return false;
+  }
+}
+
 static void match_endpoint_range (enum entity_kind kind, const char *tp, struct match_entities_range_key *min, struct match_entities_range_key *max)
 {
   /* looking for entities of kind KIND; initialize fake entities such that they are
@@ -240,12 +275,14 @@ struct entity_index *entity_index_new (struct ddsi_domaingv *gv)
   } else {
     ddsrt_mutex_init (&entidx->all_entities_lock);
     ddsrt_avl_init (&all_entities_treedef, &entidx->all_entities);
+    ddsrt_avl_init (&builtin_endpoints_treedef, &entidx->builtin_endpoints);
     return entidx;
   }
 }
 
 void entity_index_free (struct entity_index *entidx)
 {
+  ddsrt_avl_free (&builtin_endpoints_treedef, &entidx->builtin_endpoints, 0);
   ddsrt_avl_free (&all_entities_treedef, &entidx->all_entities, 0);
   ddsrt_mutex_destroy (&entidx->all_entities_lock);
   ddsrt_chh_free (entidx->guid_hash);
@@ -258,6 +295,8 @@ static void add_to_all_entities (struct entity_index *ei, struct entity_common *
   ddsrt_mutex_lock (&ei->all_entities_lock);
   assert (ddsrt_avl_lookup (&all_entities_treedef, &ei->all_entities, e) == NULL);
   ddsrt_avl_insert (&all_entities_treedef, &ei->all_entities, e);
+  if (in_builtin_endpoints (e))
+    ddsrt_avl_insert (&builtin_endpoints_treedef, &ei->builtin_endpoints, e);
   ddsrt_mutex_unlock (&ei->all_entities_lock);
 }
 
@@ -266,6 +305,8 @@ static void remove_from_all_entities (struct entity_index *ei, struct entity_com
   ddsrt_mutex_lock (&ei->all_entities_lock);
   assert (ddsrt_avl_lookup (&all_entities_treedef, &ei->all_entities, e) != NULL);
   ddsrt_avl_delete (&all_entities_treedef, &ei->all_entities, e);
+  if (in_builtin_endpoints (e))
+    ddsrt_avl_delete (&builtin_endpoints_treedef, &ei->builtin_endpoints, e);
   ddsrt_mutex_unlock (&ei->all_entities_lock);
 }
 
@@ -520,6 +561,50 @@ void *entidx_enum_next_max (struct entidx_enum *st, const struct match_entities_
   return res;
 }
 
+void entidx_enum_builtin_init (struct entidx_enum_builtin *st, const struct entity_index *ei, enum entity_kind kind, ddsi_entityid_t entityid)
+{
+  /* same reasoning as entidx_enum_init_minmax_int */
+  struct entity_common min;
+#ifndef NDEBUG
+  assert (thread_is_awake ());
+  st->vtime = ddsrt_atomic_ld32 (&lookup_thread_state ()->vtime);
+#endif
+  assert (kind == EK_READER || kind == EK_WRITER || kind == EK_PROXY_READER || kind == EK_PROXY_WRITER);
+  st->entidx = (struct entity_index *) ei;
+  st->kind = kind;
+  st->entityid = entityid;
+  min.kind = kind;
+  memset (&min.guid.prefix, 0, sizeof (min.guid.prefix));
+  min.guid.entityid = entityid;
+  ddsrt_mutex_lock (&st->entidx->all_entities_lock);
+  st->cur = ddsrt_avl_lookup_succ_eq (&builtin_endpoints_treedef, &st->entidx->builtin_endpoints, &min);
+  ddsrt_mutex_unlock (&st->entidx->all_entities_lock);
+  if (st->cur && (st->cur->kind != kind || st->cur->guid.entityid.u != entityid.u))
+    st->cur = NULL;
+}
+
+void *entidx_enum_builtin_next (struct entidx_enum_builtin *st)
+{
+  /* st->cur can not have been freed yet, but it may have been removed from the index */
+  assert (ddsrt_atomic_ld32 (&lookup_thread_state ()->vtime) == st->vtime);
+  void *res = st->cur;
+  if (st->cur)
+  {
+    ddsrt_mutex_lock (&st->entidx->all_entities_lock);
+    st->cur = ddsrt_avl_lookup_succ (&builtin_endpoints_treedef, &st->entidx->builtin_endpoints, st->cur);
+    ddsrt_mutex_unlock (&st->entidx->all_entities_lock);
+    if (st->cur && (st->cur->kind != st->kind || st->cur->guid.entityid.u != st->entityid.u))
+      st->cur = NULL;
+  }
+  return res;
+}
+
+void entidx_enum_builtin_fini (struct entidx_enum_builtin *st)
+{
+  assert (ddsrt_atomic_ld32 (&lookup_thread_state ()->vtime) == st->vtime);
+  (void) st;
+}
+
 struct writer *entidx_enum_writer_next (struct entidx_enum_writer *st)
 {
   DDSRT_STATIC_ASSERT (offsetof (struct writer, e) == 0);
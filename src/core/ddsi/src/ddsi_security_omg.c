@@ -3771,39 +3771,36 @@ decode_rtps_message (
   return ret;
 }
 
-ssize_t
-secure_conn_write(
+bool
+secure_conn_encode(
     const struct ddsi_domaingv *gv,
-    ddsi_tran_conn_t conn,
-    const ddsi_locator_t *dst,
     size_t niov,
     const ddsrt_iovec_t *iov,
-    uint32_t flags,
-    MsgLen_t *msg_len,
+    bool stream,
     bool dst_one,
-    nn_msg_sec_info_t *sec_info,
-    ddsi_tran_write_fn_t conn_write_cb)
+    const nn_msg_sec_info_t *sec_info,
+    unsigned char **dst_buf,
+    size_t *dst_len)
 {
   Header_t *hdr;
   ddsi_guid_t guid;
   unsigned char stbuf[2048];
   unsigned char *srcbuf;
-  unsigned char *dstbuf;
-  size_t srclen, dstlen;
+  size_t srclen;
   int64_t dst_handle = 0;
+  bool result;
 
   assert(iov);
-  assert(conn);
-  assert(msg_len);
   assert(sec_info);
   assert(niov > 0);
-  assert(conn_write_cb);
+  assert(dst_buf);
+  assert(dst_len);
 
   if (dst_one)
   {
     dst_handle = sec_info->dst_pp_handle;
     if (dst_handle == 0) {
-      return -1;
+      return false;
     }
   }
 
@@ -3818,7 +3815,7 @@ secure_conn_write(
   for (size_t i = 0; i < niov; i++)
   {
     /* Do not copy MsgLen submessage in case of a stream connection */
-    if (i != 1 || !conn->m_stream)
+    if (i != 1 || !stream)
       srclen += iov[i].iov_len;
   }
   if (srclen <= sizeof (stbuf))
@@ -3830,50 +3827,90 @@ secure_conn_write(
   srclen = 0;
   for (size_t i = 0; i < niov; i++)
   {
-    if (i != 1 || !conn->m_stream)
+    if (i != 1 || !stream)
     {
       memcpy (srcbuf + srclen, iov[i].iov_base, iov[i].iov_len);
       srclen += iov[i].iov_len;
     }
   }
 
-  ssize_t ret = -1;
-  if (!q_omg_security_encode_rtps_message (gv, sec_info->src_pp_handle, &guid, srcbuf, srclen, &dstbuf, &dstlen, dst_handle))
-    ret = -1;
+  result = q_omg_security_encode_rtps_message (gv, sec_info->src_pp_handle, &guid, srcbuf, srclen, dst_buf, dst_len, dst_handle);
+
+  if (srcbuf != stbuf)
+    ddsrt_free (srcbuf);
+  return result;
+}
+
+ssize_t
+secure_conn_write_encoded(
+    ddsi_tran_conn_t conn,
+    const ddsi_locator_t *dst,
+    const unsigned char *buf,
+    size_t len,
+    uint32_t flags,
+    MsgLen_t *msg_len,
+    ddsi_tran_write_fn_t conn_write_cb)
+{
+  ddsrt_iovec_t tmp_iov[3];
+  size_t tmp_niov;
+
+  assert(conn);
+  assert(buf);
+  assert(msg_len);
+  assert(conn_write_cb);
+
+  if (conn->m_stream)
+  {
+    /* Add MsgLen submessage after Header */
+    assert (len <= UINT32_MAX - sizeof (*msg_len));
+    msg_len->length = (uint32_t) (len + sizeof (*msg_len));
+
+    tmp_iov[0].iov_base = (void *) buf;
+    tmp_iov[0].iov_len = RTPS_MESSAGE_HEADER_SIZE;
+    tmp_iov[1].iov_base = (void *) msg_len;
+    tmp_iov[1].iov_len = sizeof (*msg_len);
+    tmp_iov[2].iov_base = (void *) (buf + RTPS_MESSAGE_HEADER_SIZE);
+    tmp_iov[2].iov_len = (ddsrt_iov_len_t) (len - RTPS_MESSAGE_HEADER_SIZE);
+    tmp_niov = 3;
+  }
   else
   {
-    ddsrt_iovec_t tmp_iov[3];
-    size_t tmp_niov;
+    assert (len <= UINT32_MAX);
+    msg_len->length = (uint32_t) len;
 
-    if (conn->m_stream)
-    {
-      /* Add MsgLen submessage after Header */
-      assert (dstlen <= UINT32_MAX - sizeof (*msg_len));
-      msg_len->length = (uint32_t) (dstlen + sizeof (*msg_len));
-
-      tmp_iov[0].iov_base = dstbuf;
-      tmp_iov[0].iov_len = RTPS_MESSAGE_HEADER_SIZE;
-      tmp_iov[1].iov_base = (void *) msg_len;
-      tmp_iov[1].iov_len = sizeof (*msg_len);
-      tmp_iov[2].iov_base = dstbuf + RTPS_MESSAGE_HEADER_SIZE;
-      tmp_iov[2].iov_len = (ddsrt_iov_len_t) (dstlen - RTPS_MESSAGE_HEADER_SIZE);
-      tmp_niov = 3;
-    }
-    else
-    {
-      assert (dstlen <= UINT32_MAX);
-      msg_len->length = (uint32_t) dstlen;
+    tmp_iov[0].iov_base = (void *) buf;
+    tmp_iov[0].iov_len = (ddsrt_iov_len_t) len;
+    tmp_niov = 1;
+  }
+  return conn_write_cb (conn, dst, tmp_niov, tmp_iov, flags);
+}
 
-      tmp_iov[0].iov_base = dstbuf;
-      tmp_iov[0].iov_len = (ddsrt_iov_len_t) dstlen;
-      tmp_niov = 1;
-    }
-    ret = conn_write_cb (conn, dst, tmp_niov, tmp_iov, flags);
+ssize_t
+secure_conn_write(
+    const struct ddsi_domaingv *gv,
+    ddsi_tran_conn_t conn,
+    const ddsi_locator_t *dst,
+    size_t niov,
+    const ddsrt_iovec_t *iov,
+    uint32_t flags,
+    MsgLen_t *msg_len,
+    bool dst_one,
+    nn_msg_sec_info_t *sec_info,
+    ddsi_tran_write_fn_t conn_write_cb)
+{
+  unsigned char *dstbuf;
+  size_t dstlen;
+  ssize_t ret;
+
+  assert(conn);
+
+  if (!secure_conn_encode (gv, niov, iov, conn->m_stream, dst_one, sec_info, &dstbuf, &dstlen))
+    ret = -1;
+  else
+  {
+    ret = secure_conn_write_encoded (conn, dst, dstbuf, dstlen, flags, msg_len, conn_write_cb);
     ddsrt_free (dstbuf);
   }
-
-  if (srcbuf != stbuf)
-    ddsrt_free (srcbuf);
   return ret;
 }
 
@@ -110,6 +110,55 @@ static void serdata_default_append_blob (struct ddsi_serdata_default **d, size_t
   memcpy (p, data, sz);
 }
 
+/* Large samples received in the native byte order can be validated in the
+   receive buffers and left there, holding a reference to the rmsgs containing
+   the fragments. The payload then gets copied into the (already allocated)
+   data on first use, at which point the rmsgs are released. Samples that are
+   dropped before anyone looks at them (e.g., because they were pushed out of a
+   KEEP_LAST history) are thus never copied. A pinned rmsg keeps the entire
+   receive buffer it is in alive, so the total size of the receive buffers with
+   pinned rmsgs is limited to Sizing/ReceiveBufferReferenceMaxPinned and beyond
+   that samples get copied immediately. */
+struct serdata_default_pinned {
+  ddsrt_mutex_t lock;
+  struct ddsi_domaingv *gv;
+  uint32_t nsegs; /* 0 once copied into data */
+  struct nn_rmsg **rmsgs;
+  ddsrt_iovec_t iov[];
+};
+
+static void serdata_default_pinned_release (struct serdata_default_pinned *p)
+{
+  for (uint32_t i = 0; i < p->nsegs; i++)
+    nn_rmsg_unpin (p->rmsgs[i], &p->gv->rbuf_ref_pinned);
+  p->nsegs = 0;
+}
+
+const struct ddsi_serdata_default *ddsi_serdata_default_unpin (const struct ddsi_serdata *dcmn)
+{
+  /* Operations needing the payload take the serdata as const, but the copying
+     is invisible to the outside and serialised by the lock */
+  struct ddsi_serdata_default * const d = (struct ddsi_serdata_default *) dcmn;
+  struct serdata_default_pinned * const p = d->pinned;
+  if (p != NULL)
+  {
+    ddsrt_mutex_lock (&p->lock);
+    if (p->nsegs > 0)
+    {
+      char *dst = d->data;
+      for (uint32_t i = 0; i < p->nsegs; i++)
+      {
+        memcpy (dst, p->iov[i].iov_base, p->iov[i].iov_len);
+        dst += p->iov[i].iov_len;
+      }
+      assert (dst == d->data + d->pos);
+      serdata_default_pinned_release (p);
+    }
+    ddsrt_mutex_unlock (&p->lock);
+  }
+  return d;
+}
+
 static struct ddsi_serdata *fix_serdata_default(struct ddsi_serdata_default *d, uint32_t basehash)
 {
   if (d->keyhash.m_iskey)
@@ -174,6 +223,15 @@ static void serdata_default_free(struct ddsi_serdata *dcmn)
   }
 #endif
 
+  if (d->pinned)
+  {
+    if (d->pinned->nsegs > 0)
+      serdata_default_pinned_release (d->pinned);
+    ddsrt_mutex_destroy (&d->pinned->lock);
+    ddsrt_free (d->pinned);
+    d->pinned = NULL;
+  }
+
   if (d->size > MAX_SIZE_FOR_POOL || !nn_freelist_push (&d->serpool->freelist, d))
     dds_free (d);
 }
@@ -182,6 +240,7 @@ static void serdata_default_init(struct ddsi_serdata_default *d, const struct dd
 {
   ddsi_serdata_init (&d->c, &tp->c, kind);
   d->pos = 0;
+  d->pinned = NULL;
 #ifndef NDEBUG
   d->fixed = false;
 #endif
@@ -217,10 +276,84 @@ static struct ddsi_serdata_default *serdata_default_new (const struct ddsi_serty
   return serdata_default_new_size (tp, kind, DEFAULT_NEW_SIZE);
 }
 
+/* Construct a serdata referencing the payload in the receive buffers, see
+   struct serdata_default_pinned.  Returns false if that isn't possible because
+   of the limit on the receive buffers kept alive this way, true otherwise, with
+   *dout set to the new serdata or to a null pointer if the data is invalid */
+static bool serdata_default_from_ser_pinned (const struct ddsi_sertype_default *tp, struct ddsi_domaingv *gv, const struct nn_rdata *fragchain, uint32_t size, struct ddsi_serdata_default **dout)
+{
+  struct ddsi_serdata_default *d;
+  struct serdata_default_pinned *p;
+  uint32_t nsegs = 0, off = 4; /* must skip the CDR header */
+  for (const struct nn_rdata *frag = fragchain; frag; frag = frag->nextfrag)
+  {
+    if (frag->maxp1 > off)
+    {
+      nsegs++;
+      off = frag->maxp1;
+    }
+  }
+
+  p = ddsrt_malloc (sizeof (*p) + nsegs * (sizeof (p->iov[0]) + sizeof (p->rmsgs[0])));
+  p->gv = gv;
+  p->nsegs = nsegs;
+  p->rmsgs = (struct nn_rmsg **) &p->iov[nsegs];
+  nsegs = 0;
+  off = 4;
+  for (const struct nn_rdata *frag = fragchain; frag; frag = frag->nextfrag)
+  {
+    assert (frag->min <= off);
+    assert (frag->maxp1 <= size);
+    if (frag->maxp1 > off)
+    {
+      const unsigned char *payload = NN_RMSG_PAYLOADOFF (frag->rmsg, NN_RDATA_PAYLOAD_OFF (frag));
+      p->iov[nsegs].iov_base = (void *) (payload + off - frag->min);
+      p->iov[nsegs].iov_len = (ddsrt_iov_len_t) (frag->maxp1 - off);
+      p->rmsgs[nsegs] = frag->rmsg;
+      if (!nn_rmsg_pin (frag->rmsg, &gv->rbuf_ref_pinned, gv->config.rbuf_ref_max_pinned))
+      {
+        p->nsegs = nsegs;
+        serdata_default_pinned_release (p);
+        ddsrt_free (p);
+        return false;
+      }
+      nsegs++;
+      off = frag->maxp1;
+    }
+  }
+  assert (off == size);
+  ddsrt_mutex_init (&p->lock);
+
+  if ((d = serdata_default_allocnew (tp->serpool, size)) == NULL)
+    goto fail;
+  serdata_default_init (d, tp, SDK_DATA);
+  memcpy (&d->hdr, NN_RMSG_PAYLOADOFF (fragchain->rmsg, NN_RDATA_PAYLOAD_OFF (fragchain)), sizeof (d->hdr));
+  assert (d->hdr.identifier == NATIVE_ENCODING);
+  d->pos = size - 4;
+  d->pinned = p;
+
+  const uint32_t pad = ddsrt_fromBE2u (d->hdr.options) & 2;
+  if (d->pos < pad || !dds_stream_validate_iov_native (p->nsegs, p->iov, d->pos - pad, &d->keyhash, tp))
+  {
+    ddsi_serdata_unref (&d->c);
+    d = NULL;
+  }
+  *dout = d;
+  return true;
+
+fail:
+  serdata_default_pinned_release (p);
+  ddsrt_mutex_destroy (&p->lock);
+  ddsrt_free (p);
+  *dout = NULL;
+  return true;
+}
+
 /* Construct a serdata from a fragchain received over the network */
 static struct ddsi_serdata_default *serdata_default_from_ser_common (const struct ddsi_sertype *tpcmn, enum ddsi_serdata_kind kind, const struct nn_rdata *fragchain, size_t size)
 {
   const struct ddsi_sertype_default *tp = (const struct ddsi_sertype_default *)tpcmn;
+  struct ddsi_domaingv * const gv = ddsrt_atomic_ldvoidp (&tpcmn->gv);
 
   /* FIXME: check whether this really is the correct maximum: offsets are relative
      to the CDR header, but there are also some places that use a serdata as-if it
@@ -228,15 +361,24 @@ static struct ddsi_serdata_default *serdata_default_from_ser_common (const struc
      serdata */
   if (size > UINT32_MAX - offsetof (struct ddsi_serdata_default, hdr))
     return NULL;
-  struct ddsi_serdata_default *d = serdata_default_new_size (tp, kind, (uint32_t) size);
-  if (d == NULL)
-    return NULL;
 
   uint32_t off = 4; /* must skip the CDR header */
 
   assert (fragchain->min == 0);
   assert (fragchain->maxp1 >= off); /* CDR header must be in first fragment */
 
+  if (kind == SDK_DATA && gv != NULL && gv->config.rbuf_ref_threshold > 0 && size >= gv->config.rbuf_ref_threshold)
+  {
+    const struct CDRHeader *hdr = (const struct CDRHeader *) NN_RMSG_PAYLOADOFF (fragchain->rmsg, NN_RDATA_PAYLOAD_OFF (fragchain));
+    struct ddsi_serdata_default *d;
+    if (hdr->identifier == NATIVE_ENCODING && serdata_default_from_ser_pinned (tp, gv, fragchain, (uint32_t) size, &d))
+      return d;
+  }
+
+  struct ddsi_serdata_default *d = serdata_default_new_size (tp, kind, (uint32_t) size);
+  if (d == NULL)
+    return NULL;
+
   memcpy (&d->hdr, NN_RMSG_PAYLOADOFF (fragchain->rmsg, NN_RDATA_PAYLOAD_OFF (fragchain)), sizeof (d->hdr));
   assert (d->hdr.identifier == CDR_LE || d->hdr.identifier == CDR_BE);
 
@@ -496,7 +638,7 @@ static struct ddsi_serdata *serdata_default_from_sample_cdr_nokey (const struct
 
 static struct ddsi_serdata *serdata_default_to_untyped (const struct ddsi_serdata *serdata_common)
 {
-  const struct ddsi_serdata_default *d = (const struct ddsi_serdata_default *)serdata_common;
+  const struct ddsi_serdata_default *d = ddsi_serdata_default_unpin (serdata_common);
   const struct ddsi_sertype_default *tp = (const struct ddsi_sertype_default *)d->c.type;
   assert (d->hdr.identifier == NATIVE_ENCODING || d->hdr.identifier == NATIVE_ENCODING_PL);
   struct ddsi_serdata_default *d_tl = serdata_default_new(tp, SDK_KEY);
@@ -544,7 +686,7 @@ static struct ddsi_serdata *serdata_default_to_untyped (const struct ddsi_serdat
 /* Fill buffer with 'size' bytes of serialised data, starting from 'off'; 0 <= off < off+sz <= alignup4(size(d)) */
 static void serdata_default_to_ser (const struct ddsi_serdata *serdata_common, size_t off, size_t sz, void *buf)
 {
-  const struct ddsi_serdata_default *d = (const struct ddsi_serdata_default *)serdata_common;
+  const struct ddsi_serdata_default *d = ddsi_serdata_default_unpin (serdata_common);
   assert (off < d->pos + sizeof(struct CDRHeader));
   assert (sz <= alignup_size (d->pos + sizeof(struct CDRHeader), 4) - off);
   memcpy (buf, (char *)&d->hdr + off, sz);
@@ -552,7 +694,7 @@ static void serdata_default_to_ser (const struct ddsi_serdata *serdata_common, s
 
 static struct ddsi_serdata *serdata_default_to_ser_ref (const struct ddsi_serdata *serdata_common, size_t off, size_t sz, ddsrt_iovec_t *ref)
 {
-  const struct ddsi_serdata_default *d = (const struct ddsi_serdata_default *)serdata_common;
+  const struct ddsi_serdata_default *d = ddsi_serdata_default_unpin (serdata_common);
   assert (off < d->pos + sizeof(struct CDRHeader));
   assert (sz <= alignup_size (d->pos + sizeof(struct CDRHeader), 4) - off);
   ref->iov_base = (char *)&d->hdr + off;
@@ -568,7 +710,7 @@ static void serdata_default_to_ser_unref (struct ddsi_serdata *serdata_common, c
 
 static bool serdata_default_to_sample_cdr (const struct ddsi_serdata *serdata_common, void *sample, void **bufptr, void *buflim)
 {
-  const struct ddsi_serdata_default *d = (const struct ddsi_serdata_default *)serdata_common;
+  const struct ddsi_serdata_default *d = ddsi_serdata_default_unpin (serdata_common);
   const struct ddsi_sertype_default *tp = (const struct ddsi_sertype_default *) d->c.type;
 #ifdef DDS_HAS_SHM
   if (d->c.iox_chunk)
@@ -614,7 +756,7 @@ static bool serdata_default_untyped_to_sample_cdr_nokey (const struct ddsi_serty
 
 static size_t serdata_default_print_cdr (const struct ddsi_sertype *sertype_common, const struct ddsi_serdata *serdata_common, char *buf, size_t size)
 {
-  const struct ddsi_serdata_default *d = (const struct ddsi_serdata_default *)serdata_common;
+  const struct ddsi_serdata_default *d = ddsi_serdata_default_unpin (serdata_common);
   const struct ddsi_sertype_default *tp = (const struct ddsi_sertype_default *)sertype_common;
   dds_istream_t is;
   dds_istream_from_serdata_default (&is, d);
@@ -83,6 +83,12 @@ static uint32_t sertype_default_hash (const struct ddsi_sertype *tpcmn)
 static void sertype_default_free (struct ddsi_sertype *tpcmn)
 {
   struct ddsi_sertype_default *tp = (struct ddsi_sertype_default *) tpcmn;
+  if (tp->type.keynames)
+  {
+    for (uint32_t i = 0; i < tp->type.keys.nkeys; i++)
+      ddsrt_free (tp->type.keynames[i]);
+    ddsrt_free (tp->type.keynames);
+  }
   ddsrt_free (tp->type.keys.keys);
   ddsrt_free (tp->type.ops.ops);
   ddsi_sertype_fini (&tp->c);
@@ -160,6 +166,8 @@ static bool sertype_default_deserialize (struct ddsi_domaingv *gv, struct ddsi_s
   if (plist_deser_generic_srcoff (&st->type, src_data, src_sz, src_offset, DDSRT_ENDIAN != DDSRT_LITTLE_ENDIAN, ddsi_sertype_default_desc_ops) < 0)
     return false;
   DDSRT_WARNING_MSVC_ON(6326)
+  st->type.cdr_funcs = NULL;
+  st->type.keynames = NULL;
   st->opt_size = (st->type.flagset & DDS_TOPIC_NO_OPTIMIZE) ? 0 : dds_stream_check_optimize (&st->type);
   return true;
 }
@@ -63,3 +63,9 @@ void ddsi_get_reader_stats (struct reader *rd, uint64_t * __restrict discarded_b
   }
   ddsrt_mutex_unlock (&rd->e.lock);
 }
+
+void ddsi_get_xmit_batch_stats (const struct ddsi_domaingv *gv, uint64_t * __restrict calls, uint64_t * __restrict msgs)
+{
+  *calls = ddsrt_atomic_ld64 (&gv->xmit_batch_calls);
+  *msgs = ddsrt_atomic_ld64 (&gv->xmit_batch_msgs);
+}
@@ -39,6 +39,7 @@ struct threadmon_domain {
 
 struct ddsi_threadmon {
   int keepgoing;
+  uint32_t av_ary_size;
   struct alive_vt *av_ary;
   void (*renew_cb) (void *arg);
   void *renew_arg;
@@ -58,6 +59,23 @@ static struct threadmon_domain *find_domain (struct ddsi_threadmon *sl, const st
   return ddsrt_hh_lookup (sl->domains, &dummy);
 }
 
+static void av_ary_ensure_size (struct ddsi_threadmon *sl)
+{
+  /* thread_states.nthreads only ever grows while the threadmon exists and it is updated
+     before a new segment is published, hence it covers all slots reachable at the time */
+  const uint32_t nthreads = ddsrt_atomic_ld32 (&thread_states.nthreads);
+  if (nthreads > sl->av_ary_size)
+  {
+    sl->av_ary = ddsrt_realloc (sl->av_ary, nthreads * sizeof (*sl->av_ary));
+    for (uint32_t i = sl->av_ary_size; i < nthreads; i++)
+    {
+      sl->av_ary[i].alive = true;
+      sl->av_ary[i].vt = 0;
+    }
+    sl->av_ary_size = nthreads;
+  }
+}
+
 static uint32_t threadmon_thread (struct ddsi_threadmon *sl)
 {
   /* Do not check more often than once every 100ms (no particular
@@ -66,11 +84,6 @@ static uint32_t threadmon_thread (struct ddsi_threadmon *sl)
      assignment. */
   ddsrt_mtime_t tlast = { 0 };
   bool was_alive = true;
-  for (uint32_t i = 0; i < thread_states.nthreads; i++)
-  {
-    sl->av_ary[i].alive = true;
-    sl->av_ary[i].vt = 0;
-  }
   ddsrt_mutex_lock (&sl->lock);
   while (sl->keepgoing)
   {
@@ -94,42 +107,55 @@ static uint32_t threadmon_thread (struct ddsi_threadmon *sl)
        is a similar argument to that used for the GC). */
     unsigned n_not_alive = 0;
     tlast = tnow;
-    for (uint32_t i = 0; i < thread_states.nthreads; i++)
+    for (struct thread_states_list *cur = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head); cur; cur = cur->next)
     {
-      if (thread_states.ts[i].state == THREAD_STATE_ZERO)
-        continue;
-
-      vtime_t vt = ddsrt_atomic_ld32 (&thread_states.ts[i].vtime);
-      ddsrt_atomic_fence_ldld ();
-      struct ddsi_domaingv const * const gv = ddsrt_atomic_ldvoidp (&thread_states.ts[i].gv);
-      struct threadmon_domain *tmdom = find_domain (sl, gv);
-      if (tmdom == NULL)
-        continue;
-
-      bool alive = vtime_asleep_p (vt) || vtime_asleep_p (sl->av_ary[i].vt) || vtime_gt (vt, sl->av_ary[i].vt);
-      n_not_alive += (unsigned) !alive;
-      tmdom->n_not_alive += (unsigned) !alive;
-
-      /* Construct a detailed trace line for domains that have tracing enabled, domains that don't
-         only get "failed to make progress"/"once again made progress" messages */
-      if (tmdom->msgpos < sizeof (tmdom->msg) && (gv->logconfig.c.mask & DDS_LC_TRACE))
+      uint32_t active = ddsrt_atomic_ld32 (&cur->active);
+      for (uint32_t j = 0; active; j++, active >>= 1)
       {
-        tmdom->msgpos +=
-          (size_t) snprintf (tmdom->msg + tmdom->msgpos, sizeof (tmdom->msg) - tmdom->msgpos,
-                             " %"PRIu32"(%s):%c:%"PRIx32"->%"PRIx32, i, thread_states.ts[i].name, alive ? 'a' : 'd', sl->av_ary[i].vt, vt);
-      }
+        struct thread_state1 * const thrst = &cur->thrst[j];
+        if (!(active & 1) || thrst->state == THREAD_STATE_ZERO)
+          continue;
 
-      sl->av_ary[i].vt = vt;
-      if (sl->av_ary[i].alive != alive)
-      {
-        const char *name = thread_states.ts[i].name;
-        const char *msg;
-        if (!alive)
-          msg = "failed to make progress";
-        else
-          msg = "once again made progress";
-        DDS_CLOG (alive ? DDS_LC_INFO : DDS_LC_WARNING, &gv->logconfig, "thread %s %s\n", name ? name : "(anon)", msg);
-        sl->av_ary[i].alive = alive;
+        const uint32_t i = thrst->idx;
+        if (i >= sl->av_ary_size)
+        {
+          /* segment was added after the last check */
+          ddsrt_atomic_fence_ldld ();
+          av_ary_ensure_size (sl);
+          assert (i < sl->av_ary_size);
+        }
+        vtime_t vt = ddsrt_atomic_ld32 (&thrst->vtime);
+        ddsrt_atomic_fence_ldld ();
+        struct ddsi_domaingv const * const gv = ddsrt_atomic_ldvoidp (&thrst->gv);
+        struct threadmon_domain *tmdom = find_domain (sl, gv);
+        if (tmdom == NULL)
+          continue;
+
+        bool alive = vtime_asleep_p (vt) || vtime_asleep_p (sl->av_ary[i].vt) || vtime_gt (vt, sl->av_ary[i].vt);
+        n_not_alive += (unsigned) !alive;
+        tmdom->n_not_alive += (unsigned) !alive;
+
+        /* Construct a detailed trace line for domains that have tracing enabled, domains that don't
+           only get "failed to make progress"/"once again made progress" messages */
+        if (tmdom->msgpos < sizeof (tmdom->msg) && (gv->logconfig.c.mask & DDS_LC_TRACE))
+        {
+          tmdom->msgpos +=
+            (size_t) snprintf (tmdom->msg + tmdom->msgpos, sizeof (tmdom->msg) - tmdom->msgpos,
+                               " %"PRIu32"(%s):%c:%"PRIx32"->%"PRIx32, i, thrst->name, alive ? 'a' : 'd', sl->av_ary[i].vt, vt);
+        }
+
+        sl->av_ary[i].vt = vt;
+        if (sl->av_ary[i].alive != alive)
+        {
+          const char *name = thrst->name;
+          const char *msg;
+          if (!alive)
+            msg = "failed to make progress";
+          else
+            msg = "once again made progress";
+          DDS_CLOG (alive ? DDS_LC_INFO : DDS_LC_WARNING, &gv->logconfig, "thread %s %s\n", name ? name : "(anon)", msg);
+          sl->av_ary[i].alive = alive;
+        }
       }
     }
 
@@ -208,17 +234,13 @@ struct ddsi_threadmon *ddsi_threadmon_new (int64_t liveliness_monitoring_interva
   sl->noprogress_log_stacktraces = noprogress_log_stacktraces;
   sl->domains = ddsrt_hh_new (1, threadmon_domain_hash, threadmon_domain_eq);
 
-  if ((sl->av_ary = ddsrt_malloc (thread_states.nthreads * sizeof (*sl->av_ary))) == NULL)
-    goto fail_vtimes;
-  /* service lease update thread initializes av_ary */
+  /* service lease update thread allocates and initializes av_ary */
+  sl->av_ary_size = 0;
+  sl->av_ary = NULL;
 
   ddsrt_mutex_init (&sl->lock);
   ddsrt_cond_init (&sl->cond);
   return sl;
-
- fail_vtimes:
-  ddsrt_free (sl);
-  return NULL;
 }
 
 dds_return_t ddsi_threadmon_start (struct ddsi_threadmon *sl, const char *name)
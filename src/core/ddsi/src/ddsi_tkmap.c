@@ -32,6 +32,7 @@
 struct ddsi_tkmap
 {
   struct ddsrt_chh *m_hh;
+  struct ddsrt_chh *m_iid_hh; /* same instances, indexed on m_iid */
   struct ddsi_domaingv *gv;
   ddsrt_mutex_t m_lock;
   ddsrt_cond_t m_cond;
@@ -86,10 +87,24 @@ static int dds_tk_equals_void (const void *a, const void *b)
   return dds_tk_equals (a, b);
 }
 
+static uint32_t dds_tk_iid_hash (const void *va)
+{
+  const struct ddsi_tkmap_instance *a = va;
+  return (uint32_t) a->m_iid;
+}
+
+static int dds_tk_iid_equals (const void *va, const void *vb)
+{
+  const struct ddsi_tkmap_instance *a = va;
+  const struct ddsi_tkmap_instance *b = vb;
+  return (a->m_iid == b->m_iid);
+}
+
 struct ddsi_tkmap *ddsi_tkmap_new (struct ddsi_domaingv *gv)
 {
   struct ddsi_tkmap *tkmap = dds_alloc (sizeof (*tkmap));
   tkmap->m_hh = ddsrt_chh_new (1, dds_tk_hash_void, dds_tk_equals_void, gc_buckets, tkmap);
+  tkmap->m_iid_hh = ddsrt_chh_new (1, dds_tk_iid_hash, dds_tk_iid_equals, gc_buckets, tkmap);
   tkmap->gv = gv;
   ddsrt_mutex_init (&tkmap->m_lock);
   ddsrt_cond_init (&tkmap->m_cond);
@@ -107,6 +122,7 @@ void ddsi_tkmap_free (struct ddsi_tkmap * map)
 {
   ddsrt_chh_enum_unsafe (map->m_hh, free_tkmap_instance, NULL);
   ddsrt_chh_free (map->m_hh);
+  ddsrt_chh_free (map->m_iid_hh);
   ddsrt_cond_destroy (&map->m_cond);
   ddsrt_mutex_destroy (&map->m_lock);
   dds_free (map);
@@ -124,23 +140,20 @@ uint64_t ddsi_tkmap_lookup (struct ddsi_tkmap * map, const struct ddsi_serdata *
 
 struct ddsi_tkmap_instance *ddsi_tkmap_find_by_id (struct ddsi_tkmap *map, uint64_t iid)
 {
-  /* This is not a function that should be used liberally, as it linearly scans the key-to-iid map. */
-  struct ddsrt_chh_iter it;
+  struct ddsi_tkmap_instance dummy;
   struct ddsi_tkmap_instance *tk;
   uint32_t refc;
   assert (thread_is_awake ());
-  for (tk = ddsrt_chh_iter_first (map->m_hh, &it); tk; tk = ddsrt_chh_iter_next (&it))
-    if (tk->m_iid == iid)
-      break;
-  if (tk == NULL)
-    /* Common case of it not existing at all */
-    return NULL;
-  else if (!((refc = ddsrt_atomic_ld32 (&tk->m_refc)) & REFC_DELETE) && ddsrt_atomic_cas32 (&tk->m_refc, refc, refc+1))
-    /* Common case of it existing, not in the process of being deleted and no one else concurrently modifying the refcount */
-    return tk;
-  else
-    /* Let key value lookup handle the possible CAS loop and the complicated cases */
-    return ddsi_tkmap_find (map, tk->m_sample, false);
+  dummy.m_iid = iid;
+  do {
+    if ((tk = ddsrt_chh_lookup (map->m_iid_hh, &dummy)) == NULL)
+      return NULL;
+    /* An instance in the process of being deleted no longer exists as far as
+       its handle is concerned: a new one for the same key gets a new iid */
+    if ((refc = ddsrt_atomic_ld32 (&tk->m_refc)) & REFC_DELETE)
+      return NULL;
+  } while (!ddsrt_atomic_cas32 (&tk->m_refc, refc, refc + 1));
+  return tk;
 }
 
 /* Debug keyhash generation for debug and coverage builds */
@@ -190,9 +203,16 @@ retry:
     tk->m_sample = ddsi_serdata_to_untyped (sd);
     ddsrt_atomic_st32 (&tk->m_refc, 1);
     tk->m_iid = ddsi_iid_gen ();
+    /* Add to the iid index first: once it is in m_hh, other threads can
+       find it and pass the iid to find_by_id.  The iid is fresh, so no one
+       can look for it before that. */
+    int added = ddsrt_chh_add (map->m_iid_hh, tk);
+    assert (added);
+    (void) added;
     if (!ddsrt_chh_add (map->m_hh, tk))
     {
       /* Lost a race from another thread, retry */
+      (void) ddsrt_chh_remove (map->m_iid_hh, tk);
       ddsi_serdata_unref (tk->m_sample);
       dds_free (tk);
       goto retry;
@@ -230,6 +250,8 @@ void ddsi_tkmap_instance_unref (struct ddsi_tkmap *map, struct ddsi_tkmap_instan
     /* Remove from hash table */
     int removed = ddsrt_chh_remove(map->m_hh, tk);
     assert (removed);
+    removed = ddsrt_chh_remove(map->m_iid_hh, tk);
+    assert (removed);
     (void)removed;
 
     /* Signal any threads blocked in their retry loops in lookup */
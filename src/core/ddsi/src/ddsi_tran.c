@@ -37,6 +37,10 @@ extern inline int ddsi_listener_locator (ddsi_tran_listener_t listener, ddsi_loc
 extern inline int ddsi_listener_listen (ddsi_tran_listener_t listener);
 extern inline ddsi_tran_conn_t ddsi_listener_accept (ddsi_tran_listener_t listener);
 extern inline ssize_t ddsi_conn_read (ddsi_tran_conn_t conn, unsigned char * buf, size_t len, bool allow_spurious, ddsi_locator_t *srcloc);
+extern inline bool ddsi_conn_supports_write_batch (const struct ddsi_tran_conn *conn);
+extern inline ssize_t ddsi_conn_write_batch (ddsi_tran_conn_t conn, size_t ndst, const ddsi_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags);
+extern inline bool ddsi_conn_supports_read_batch (const struct ddsi_tran_conn *conn);
+extern inline ssize_t ddsi_conn_read_batch (ddsi_tran_conn_t conn, size_t nmsgs, struct ddsi_tran_read_batch_msg *msgs);
 extern inline ssize_t ddsi_conn_write (ddsi_tran_conn_t conn, const ddsi_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags);
 
 void ddsi_factory_add (struct ddsi_domaingv *gv, ddsi_tran_factory_t factory)
@@ -170,10 +174,13 @@ void ddsi_conn_add_ref (ddsi_tran_conn_t conn)
 void ddsi_factory_conn_init (const struct ddsi_tran_factory *factory, const struct nn_interface *interf, ddsi_tran_conn_t conn)
 {
   ddsrt_atomic_st32 (&conn->m_count, 1);
+  conn->m_serial = ddsrt_atomic_inc32_nv (&factory->gv->conn_serial);
   conn->m_connless = factory->m_connless;
   conn->m_stream = factory->m_stream;
   conn->m_factory = (struct ddsi_tran_factory *) factory;
   conn->m_interf = interf;
+  conn->m_read_batch_fn = NULL;
+  conn->m_write_batch_fn = NULL;
   conn->m_base.gv = factory->gv;
 }
 
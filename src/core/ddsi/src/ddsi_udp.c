@@ -28,6 +28,13 @@
 #include "dds/ddsi/q_pcap.h"
 #include "dds/ddsi/ddsi_domaingv.h"
 
+#if defined __linux && defined SO_ATTACH_REUSEPORT_CBPF && !LWIP_SOCKET
+#include <linux/filter.h>
+#define DDSI_UDP_HAVE_SHARDS 1
+#else
+#define DDSI_UDP_HAVE_SHARDS 0
+#endif
+
 union addr {
   struct sockaddr_storage x;
   struct sockaddr a;
@@ -61,6 +68,29 @@ static void addr_to_loc (const struct ddsi_tran_factory *tran, ddsi_locator_t *d
   ddsi_ipaddr_to_loc (dst, &src->a, (src->a.sa_family == AF_INET) ? NN_LOCATOR_KIND_UDPv4 : NN_LOCATOR_KIND_UDPv6);
 }
 
+static void ddsi_udp_conn_read_done (ddsi_udp_conn_t conn, const union addr *src, unsigned char *buf, size_t len, size_t sz, bool trunc_flag)
+{
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  if (gv->pcap_fp)
+  {
+    union addr dest;
+    socklen_t dest_len = sizeof (dest);
+    if (ddsrt_getsockname (conn->m_sock, &dest.a, &dest_len) != DDS_RETCODE_OK)
+      memset (&dest, 0, sizeof (dest));
+    write_pcap_received (gv, ddsrt_time_wallclock (), &src->x, &dest.x, buf, sz);
+  }
+
+  /* Check for udp packet truncation */
+  if (sz > len || trunc_flag)
+  {
+    char addrbuf[DDSI_LOCSTRLEN];
+    ddsi_locator_t tmp;
+    addr_to_loc (conn->m_base.m_factory, &tmp, src);
+    ddsi_locator_to_string (addrbuf, sizeof (addrbuf), &tmp);
+    GVWARNING ("%s => %d truncated to %d\n", addrbuf, (int) sz, (int) len);
+  }
+}
+
 static ssize_t ddsi_udp_conn_read (ddsi_tran_conn_t conn_cmn, unsigned char * buf, size_t len, bool allow_spurious, ddsi_locator_t *srcloc)
 {
   ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
@@ -96,30 +126,12 @@ static ssize_t ddsi_udp_conn_read (ddsi_tran_conn_t conn_cmn, unsigned char * bu
   {
     if (srcloc)
       addr_to_loc (conn->m_base.m_factory, srcloc, &src);
-
-    if (gv->pcap_fp)
-    {
-      union addr dest;
-      socklen_t dest_len = sizeof (dest);
-      if (ddsrt_getsockname (conn->m_sock, &dest.a, &dest_len) != DDS_RETCODE_OK)
-        memset (&dest, 0, sizeof (dest));
-      write_pcap_received (gv, ddsrt_time_wallclock (), &src.x, &dest.x, buf, (size_t) ret);
-    }
-
-    /* Check for udp packet truncation */
 #if DDSRT_MSGHDR_FLAGS
     const bool trunc_flag = (msghdr.msg_flags & MSG_TRUNC) != 0;
 #else
     const bool trunc_flag = false;
 #endif
-    if ((size_t) ret > len || trunc_flag)
-    {
-      char addrbuf[DDSI_LOCSTRLEN];
-      ddsi_locator_t tmp;
-      addr_to_loc (conn->m_base.m_factory, &tmp, &src);
-      ddsi_locator_to_string (addrbuf, sizeof (addrbuf), &tmp);
-      GVWARNING ("%s => %d truncated to %d\n", addrbuf, (int) ret, (int) len);
-    }
+    ddsi_udp_conn_read_done (conn, &src, buf, len, (size_t) ret, trunc_flag);
   }
   else if (rc != DDS_RETCODE_BAD_PARAMETER && rc != DDS_RETCODE_NO_CONNECTION)
   {
@@ -129,6 +141,57 @@ static ssize_t ddsi_udp_conn_read (ddsi_tran_conn_t conn_cmn, unsigned char * bu
   return ret;
 }
 
+#if DDSRT_HAVE_MMSG
+static ssize_t ddsi_udp_conn_read_batch (ddsi_tran_conn_t conn_cmn, size_t nmsgs, struct ddsi_tran_read_batch_msg *msgs)
+{
+  ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  ddsrt_mmsghdr_t mmsghdrs[DDSI_TRAN_READ_BATCH_MAX];
+  ddsrt_iovec_t msg_iovs[DDSI_TRAN_READ_BATCH_MAX];
+  union addr srcs[DDSI_TRAN_READ_BATCH_MAX];
+  dds_return_t rc;
+  size_t nrcvd = 0;
+
+  assert (nmsgs > 0 && nmsgs <= DDSI_TRAN_READ_BATCH_MAX);
+  for (size_t i = 0; i < nmsgs; i++)
+  {
+    msg_iovs[i].iov_base = (void *) msgs[i].buf;
+    msg_iovs[i].iov_len = (ddsrt_iov_len_t) msgs[i].len;
+    mmsghdrs[i].msg_hdr.msg_name = &srcs[i].x;
+    mmsghdrs[i].msg_hdr.msg_namelen = (socklen_t) sizeof (srcs[i]);
+    mmsghdrs[i].msg_hdr.msg_iov = &msg_iovs[i];
+    mmsghdrs[i].msg_hdr.msg_iovlen = 1;
+    mmsghdrs[i].msg_hdr.msg_control = NULL;
+    mmsghdrs[i].msg_hdr.msg_controllen = 0;
+    mmsghdrs[i].msg_hdr.msg_flags = 0;
+    mmsghdrs[i].msg_len = 0;
+  }
+
+  do {
+    rc = ddsrt_recvmmsg (conn->m_sock, mmsghdrs, nmsgs, 0, &nrcvd);
+  } while (rc == DDS_RETCODE_INTERRUPTED);
+
+  if (rc != DDS_RETCODE_OK)
+  {
+    if (rc == DDS_RETCODE_BAD_PARAMETER || rc == DDS_RETCODE_NO_CONNECTION)
+      return 0;
+    GVERROR ("UDP recvmmsg sock %d: retcode %"PRId32"\n", (int) conn->m_sock, rc);
+    return -1;
+  }
+
+  for (size_t i = 0; i < nrcvd; i++)
+  {
+    const size_t len = msgs[i].len;
+    const bool trunc_flag = (mmsghdrs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    msgs[i].len = mmsghdrs[i].msg_len;
+    addr_to_loc (conn->m_base.m_factory, &msgs[i].srcloc, &srcs[i]);
+    if (msgs[i].len > 0)
+      ddsi_udp_conn_read_done (conn, &srcs[i], msgs[i].buf, len, msgs[i].len, trunc_flag);
+  }
+  return (ssize_t) nrcvd;
+}
+#endif
+
 static void set_msghdr_iov (ddsrt_msghdr_t *mhdr, const ddsrt_iovec_t *iov, size_t iovlen)
 {
   mhdr->msg_iov = (ddsrt_iovec_t *) iov;
@@ -192,6 +255,75 @@ static ssize_t ddsi_udp_conn_write (ddsi_tran_conn_t conn_cmn, const ddsi_locato
   return (rc == DDS_RETCODE_OK) ? ret : -1;
 }
 
+#if DDSRT_HAVE_MMSG
+static ssize_t ddsi_udp_conn_write_batch (ddsi_tran_conn_t conn_cmn, size_t ndst, const ddsi_locator_t *dst, size_t niov, const ddsrt_iovec_t *iov, uint32_t flags)
+{
+  ddsi_udp_conn_t conn = (ddsi_udp_conn_t) conn_cmn;
+  struct ddsi_domaingv * const gv = conn->m_base.m_base.gv;
+  ddsrt_mmsghdr_t mmsghdrs[DDSI_TRAN_WRITE_BATCH_MAX];
+  union addr dstaddrs[DDSI_TRAN_WRITE_BATCH_MAX];
+  dds_return_t rc;
+  size_t i = 0, nsent = 0;
+  unsigned retry = 2;
+  int sendflags = 0;
+  assert (niov <= INT_MAX);
+  assert (ndst > 0 && ndst <= DDSI_TRAN_WRITE_BATCH_MAX);
+  DDSRT_UNUSED_ARG (flags);
+  for (size_t k = 0; k < ndst; k++)
+  {
+    ddsi_ipaddr_from_loc (&dstaddrs[k].x, &dst[k]);
+    set_msghdr_iov (&mmsghdrs[k].msg_hdr, iov, niov);
+    mmsghdrs[k].msg_hdr.msg_name = &dstaddrs[k].x;
+    mmsghdrs[k].msg_hdr.msg_namelen = (socklen_t) ddsrt_sockaddr_get_size (&dstaddrs[k].a);
+    mmsghdrs[k].msg_hdr.msg_control = NULL;
+    mmsghdrs[k].msg_hdr.msg_controllen = 0;
+    mmsghdrs[k].msg_hdr.msg_flags = 0;
+    mmsghdrs[k].msg_len = 0;
+  }
+#if MSG_NOSIGNAL && !LWIP_SOCKET
+  sendflags |= MSG_NOSIGNAL;
+#endif
+  while (i < ndst)
+  {
+    size_t n = 0;
+    rc = ddsrt_sendmmsg (conn->m_sock, &mmsghdrs[i], ndst - i, sendflags, &n);
+    if (rc == DDS_RETCODE_OK)
+    {
+      /* sendmmsg only reports an error if the first message couldn't be sent,
+         the next call will start with the one that failed, if any */
+      if (gv->pcap_fp)
+      {
+        union addr sa;
+        socklen_t alen = sizeof (sa);
+        if (ddsrt_getsockname (conn->m_sock, &sa.a, &alen) != DDS_RETCODE_OK)
+          memset(&sa, 0, sizeof(sa));
+        for (size_t k = i; k < i + n; k++)
+          write_pcap_sent (gv, ddsrt_time_wallclock (), &sa.x, &mmsghdrs[k].msg_hdr, mmsghdrs[k].msg_len);
+      }
+      i += n;
+      nsent += n;
+      retry = 2;
+    }
+    else if (rc == DDS_RETCODE_INTERRUPTED || rc == DDS_RETCODE_TRY_AGAIN || (rc == DDS_RETCODE_NOT_ALLOWED && retry-- > 0))
+    {
+      /* same as ddsi_udp_conn_write: try again */
+    }
+    else
+    {
+      /* skip the destination that failed, like ddsi_udp_conn_write would */
+      if (rc != DDS_RETCODE_NOT_ALLOWED && rc != DDS_RETCODE_NO_CONNECTION)
+      {
+        char locbuf[DDSI_LOCSTRLEN];
+        GVERROR ("ddsi_udp_conn_write_batch to %s failed with retcode %"PRId32"\n", ddsi_locator_to_string (locbuf, sizeof (locbuf), &dst[i]), rc);
+      }
+      i++;
+      retry = 2;
+    }
+  }
+  return (nsent > 0) ? (ssize_t) nsent : -1;
+}
+#endif
+
 static void ddsi_udp_disable_multiplexing (ddsi_tran_conn_t conn_cmn)
 {
 #if defined _WIN32 && !defined WINCE
@@ -442,6 +574,43 @@ static dds_return_t set_mc_options_transmit_ipv4 (struct ddsi_domaingv const * c
   return DDS_RETCODE_OK;
 }
 
+#if DDSI_UDP_HAVE_SHARDS
+static dds_return_t set_shard_steering (struct ddsi_domaingv const * const gv, ddsrt_socket_t sock, uint32_t nshards)
+{
+  /* Selects the socket in the SO_REUSEPORT group based on the GUID prefix in
+     the RTPS header (the program gets to see the UDP payload), so that all
+     traffic from one participant ends up in the same receive thread, and
+     hence the processing order of its messages is the same as with a single
+     socket.  Packets too short to be RTPS messages go to socket 0, except
+     2-byte packets, which go to the socket indexed by the second byte: that
+     is what trigger_recv_threads uses to wake up a specific thread.  An
+     index out of range makes the kernel fall back to its default selection
+     based on addresses and ports. */
+  struct sock_filter code[] = {
+    BPF_STMT (BPF_LD | BPF_W | BPF_LEN, 0),
+    BPF_JUMP (BPF_JMP | BPF_JGE | BPF_K, 20, 4, 0),
+    BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K, 2, 0, 2),
+    BPF_STMT (BPF_LD | BPF_B | BPF_ABS, 1),
+    BPF_STMT (BPF_RET | BPF_A, 0),
+    BPF_STMT (BPF_RET | BPF_K, 0),
+    BPF_STMT (BPF_LD | BPF_W | BPF_ABS, 8),
+    BPF_STMT (BPF_MISC | BPF_TAX, 0),
+    BPF_STMT (BPF_LD | BPF_W | BPF_ABS, 12),
+    BPF_STMT (BPF_ALU | BPF_XOR | BPF_X, 0),
+    BPF_STMT (BPF_MISC | BPF_TAX, 0),
+    BPF_STMT (BPF_LD | BPF_W | BPF_ABS, 16),
+    BPF_STMT (BPF_ALU | BPF_XOR | BPF_X, 0),
+    BPF_STMT (BPF_ALU | BPF_MOD | BPF_K, nshards),
+    BPF_STMT (BPF_RET | BPF_A, 0)
+  };
+  struct sock_fprog prog = { .len = (unsigned short) (sizeof (code) / sizeof (code[0])), .filter = code };
+  dds_return_t rc;
+  if ((rc = ddsrt_setsockopt (sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof (prog))) != DDS_RETCODE_OK)
+    GVERROR ("ddsi_udp_create_conn: failed to attach receive shard steering program: %s\n", dds_strretcode (rc));
+  return rc;
+}
+#endif
+
 static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_factory_t fact_cmn, uint32_t port, const ddsi_tran_qos_t *qos)
 {
   struct ddsi_udp_tran_factory *fact = (struct ddsi_udp_tran_factory *) fact_cmn;
@@ -452,7 +621,7 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
 
   dds_return_t rc;
   ddsrt_socket_t sock;
-  bool reuse_addr = false, bind_to_any = false, ipv6 = false;
+  bool reuse_addr = false, reuse_port = false, bind_to_any = false, ipv6 = false;
   const char *purpose_str = NULL;
 
   switch (qos->m_purpose)
@@ -472,6 +641,15 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
       bind_to_any = true;
       purpose_str = "multicast";
       break;
+    case DDSI_TRAN_QOS_RECV_UC_SHARD:
+#if DDSI_UDP_HAVE_SHARDS
+      reuse_port = true;
+      bind_to_any = true;
+      purpose_str = "unicast shard";
+      break;
+#else
+      return DDS_RETCODE_UNSUPPORTED;
+#endif
   }
   assert (purpose_str != NULL);
 
@@ -518,6 +696,14 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
     }
   }
 
+#if DDSI_UDP_HAVE_SHARDS
+  if (reuse_port && (rc = ddsrt_setsockopt (sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof (one))) != DDS_RETCODE_OK)
+  {
+    GVERROR ("ddsi_udp_create_conn: failed to enable port reuse: %s\n", dds_strretcode (rc));
+    goto fail_w_socket;
+  }
+#endif
+
   if ((rc = set_rcvbuf (gv, sock, &gv->config.socket_min_rcvbuf_size)) < 0)
     goto fail_w_socket;
   if (rc > 0) {
@@ -552,6 +738,11 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
     goto fail_w_socket;
   }
 
+#if DDSI_UDP_HAVE_SHARDS
+  if (reuse_port && set_shard_steering (gv, sock, qos->m_nshards) != DDS_RETCODE_OK)
+    goto fail_w_socket;
+#endif
+
   rc = ipv6 ? set_mc_options_transmit_ipv6 (gv, intf, sock) : set_mc_options_transmit_ipv4 (gv, intf, sock);
   if (rc != DDS_RETCODE_OK)
     goto fail_w_socket;
@@ -584,7 +775,13 @@ static dds_return_t ddsi_udp_create_conn (ddsi_tran_conn_t *conn_out, ddsi_tran_
   conn->m_base.m_base.m_handle_fn = ddsi_udp_conn_handle;
 
   conn->m_base.m_read_fn = ddsi_udp_conn_read;
+#if DDSRT_HAVE_MMSG
+  conn->m_base.m_read_batch_fn = ddsi_udp_conn_read_batch;
+#endif
   conn->m_base.m_write_fn = ddsi_udp_conn_write;
+#if DDSRT_HAVE_MMSG
+  conn->m_base.m_write_batch_fn = ddsi_udp_conn_write_batch;
+#endif
   conn->m_base.m_disable_multiplexing_fn = ddsi_udp_disable_multiplexing;
   conn->m_base.m_locator_fn = ddsi_udp_conn_locator;
 
@@ -14,6 +14,9 @@
 #include <assert.h>
 
 #include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/avl.h"
+#include "dds/ddsrt/mh3.h"
 #include "dds/ddsrt/static_assert.h"
 #include "dds/ddsi/q_entity.h"
 #include "dds/ddsi/q_addrset.h"
@@ -187,63 +190,119 @@ static void locset_free (struct locset *ls)
   ddsrt_free (ls);
 }
 
-static struct addrset *wras_collect_all_locs (const struct writer *wr)
+// Snapshot of the locators of a proxy reader, the set cover is computed from
+// these so that the proxy reader's address set changing while the computation
+// is in progress doesn't matter, and so that it can be retained for updating
+// the writer's address set incrementally.
+struct wras_row {
+  ddsi_guid_t prd_guid;
+  bool redundant_networking;
+  int nlocs; // number of locators of the reader
+  int nssm;  // number of SSM locators of the writer following those if the reader favours SSM
+  ddsi_xlocator_t *locs;
+};
+
+struct wras_flatten_locs_helper_arg {
+  ddsi_xlocator_t *locs;
+  int n, size;
+};
+
+static void wras_flatten_locs_helper (const ddsi_xlocator_t *loc, void *varg)
 {
-  struct entity_index * const gh = wr->e.gv->entity_index;
-  struct addrset *all_addrs = new_addrset ();
-  struct wr_prd_match *m;
-  ddsrt_avl_iter_t it;
-  for (m = ddsrt_avl_iter_first (&wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  struct wras_flatten_locs_helper_arg *arg = varg;
+  if (arg->n == arg->size)
   {
-    struct proxy_reader *prd;
-    if ((prd = entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
-      continue;
-    copy_addrset_into_addrset (wr->e.gv, all_addrs, prd->c.as);
+    arg->size = (arg->size == 0) ? 4 : 2 * arg->size;
+    arg->locs = ddsrt_realloc (arg->locs, (size_t) arg->size * sizeof (*arg->locs));
   }
-  if (!addrset_empty (all_addrs))
-  {
+  arg->locs[arg->n++] = *loc;
+}
+
+static int wras_compare_xlocators_vwrap (const void *va, const void *vb)
+{
+  return compare_xlocators (va, vb);
+}
+
+static void wras_make_row (const struct writer *wr, const struct proxy_reader *prd, struct wras_row *row)
+{
+  struct wras_flatten_locs_helper_arg arg = { .locs = NULL, .n = 0, .size = 0 };
+  row->prd_guid = prd->e.guid;
+  row->redundant_networking = prd->redundant_networking;
+  addrset_forall (prd->c.as, wras_flatten_locs_helper, &arg);
+  row->nlocs = arg.n;
 #ifdef DDS_HAS_SSM
-    if (wr->supports_ssm && wr->ssm_as)
-      copy_addrset_into_addrset_mc (wr->e.gv, all_addrs, wr->ssm_as);
+  if (prd->favours_ssm && wr->supports_ssm && wr->ssm_as)
+    addrset_forall (wr->ssm_as, wras_flatten_locs_helper, &arg);
+#else
+  (void) wr;
 #endif
-  }
-  return all_addrs;
+  row->nssm = arg.n - row->nlocs;
+  row->locs = arg.locs;
+  // canonical order so rows can be compared
+  if (row->nlocs > 1)
+    qsort (row->locs, (size_t) row->nlocs, sizeof (*row->locs), wras_compare_xlocators_vwrap);
+  if (row->nssm > 1)
+    qsort (row->locs + row->nlocs, (size_t) row->nssm, sizeof (*row->locs), wras_compare_xlocators_vwrap);
 }
 
-struct rebuild_flatten_locs_helper_arg {
-  ddsi_xlocator_t *locs;
-  int idx;
-#ifndef NDEBUG
-  int size;
-#endif
-};
+static void wras_free_rows (struct wras_row *rows, int nrows)
+{
+  for (int i = 0; i < nrows; i++)
+    ddsrt_free (rows[i].locs);
+  ddsrt_free (rows);
+}
 
-static void wras_flatten_locs_helper (const ddsi_xlocator_t *loc, void *varg)
+static struct wras_row *wras_collect_rows (const struct writer *wr, int *nrows)
 {
-  struct rebuild_flatten_locs_helper_arg *arg = varg;
-  assert(arg->idx < arg->size);
-  arg->locs[arg->idx++] = *loc;
+  struct entity_index * const gh = wr->e.gv->entity_index;
+  struct wras_row *rows = ddsrt_malloc ((wr->num_readers > 0 ? wr->num_readers : 1) * sizeof (*rows));
+  struct wr_prd_match *m;
+  ddsrt_avl_iter_t it;
+  int n = 0;
+  for (m = ddsrt_avl_iter_first (&wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  {
+    struct proxy_reader *prd;
+    // readers with a content filter get samples addressed to them individually
+    if (m->cfilter || (prd = entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
+      continue;
+    assert ((uint32_t) n < wr->num_readers);
+    wras_make_row (wr, prd, &rows[n++]);
+  }
+  *nrows = n;
+  return rows;
 }
 
-static void wras_flatten_locs_prealloc (struct locset *ls, struct addrset *addrs)
+static int wras_compare_rows (const void *va, const void *vb)
 {
-  struct rebuild_flatten_locs_helper_arg flarg;
-  flarg.locs = ls->locs;
-  flarg.idx = 0;
-#ifndef NDEBUG
-  flarg.size = ls->nlocs;
-#endif
-  addrset_forall (addrs, wras_flatten_locs_helper, &flarg);
-  ls->nlocs = flarg.idx;
+  // Ordering of rows ignoring the reader GUID: the cover doesn't depend on
+  // it and so this gives a canonical ordering of the input
+  const struct wras_row *a = va;
+  const struct wras_row *b = vb;
+  if (a->redundant_networking != b->redundant_networking)
+    return a->redundant_networking ? 1 : -1;
+  else if (a->nlocs != b->nlocs)
+    return (a->nlocs < b->nlocs) ? -1 : 1;
+  else if (a->nssm != b->nssm)
+    return (a->nssm < b->nssm) ? -1 : 1;
+  for (int i = 0; i < a->nlocs + a->nssm; i++)
+  {
+    int c;
+    if ((c = compare_xlocators (&a->locs[i], &b->locs[i])) != 0)
+      return c;
+  }
+  return 0;
 }
 
-static struct locset *wras_flatten_locs (struct addrset *all_addrs)
+static bool wras_row_is_simple (const struct wras_row *row)
 {
-  const int nin = (int) addrset_count (all_addrs);
-  struct locset *ls = locset_new (nin);
-  wras_flatten_locs_prealloc (ls, all_addrs);
-  assert (ls->nlocs == nin);
-  return ls;
+  // Rows that map one-to-one to a row in the cover matrix and have only locators
+  // that end up unchanged in the address set can be handled incrementally
+  if (row->redundant_networking || row->nssm > 0)
+    return false;
+  for (int i = 0; i < row->nlocs; i++)
+    if (row->locs[i].c.kind == NN_LOCATOR_KIND_UDPv4MCGEN || row->locs[i].c.kind == NN_LOCATOR_KIND_SHEM)
+      return false;
+  return true;
 }
 
 static int wras_compare_locs (const void *va, const void *vb)
@@ -267,10 +326,18 @@ static int wras_compare_locs (const void *va, const void *vb)
   }
 }
 
-static struct locset *wras_calc_locators (const struct ddsrt_log_cfg *logcfg, struct addrset *all_addrs)
+static struct locset *wras_calc_locators (const struct ddsrt_log_cfg *logcfg, const struct wras_row *rows, int nrows)
 {
-  struct locset *ls = wras_flatten_locs (all_addrs);
-  int i, j;
+  int i, j, n = 0;
+  for (i = 0; i < nrows; i++)
+    n += rows[i].nlocs + rows[i].nssm;
+  struct locset *ls = locset_new (n);
+  n = 0;
+  for (i = 0; i < nrows; i++)
+    for (j = 0; j < rows[i].nlocs + rows[i].nssm; j++)
+      ls->locs[n++] = rows[i].locs[j];
+  if (ls->nlocs == 0)
+    return ls;
   /* We want MC gens just once for each IP,BASE,COUNT pair, not once for each node */
   i = 0; j = 1;
   qsort (ls->locs, (size_t) ls->nlocs, sizeof (*ls->locs), wras_compare_locs);
@@ -323,11 +390,21 @@ static cost_t sat_cost_add (cost_t x, int32_t a)
     return (x < INT32_MIN - a) ? INT32_MIN : x + a;
 }
 
+struct locator_base_cost {
+  int32_t uc, mc, ssm;
+};
+
+static struct locator_base_cost get_locator_base_cost (bool prefer_multicast)
+{
+  if (prefer_multicast)
+    return (struct locator_base_cost) { .uc = 1000000, .mc = 1, .ssm = 0 };
+  else
+    return (struct locator_base_cost) { .uc = 2, .mc = 3, .ssm = 2 };
+}
+
 static readercount_cost_t calc_locator_cost (const struct cover *c, int lidx, bool prefer_multicast, dds_locator_mask_t ignore)
 {
-  const int32_t cost_uc  = prefer_multicast ? 1000000 : 2;
-  const int32_t cost_mc  = prefer_multicast ? 1 : 3;
-  const int32_t cost_ssm = prefer_multicast ? 0 : 2;
+  const struct locator_base_cost base = get_locator_base_cost (prefer_multicast);
   const int32_t cost_non_loopback = 2;
   readercount_cost_t x = { .nrds = 0, .cost = 0 };
 
@@ -355,11 +432,11 @@ static readercount_cost_t calc_locator_cost (const struct cover *c, int lidx, bo
       goto no_readers;
   }
   else if ((ci & CI_MULTICAST_MASK) == 0)
-    x.cost += cost_uc;
+    x.cost += base.uc;
   else if (((ci & CI_MULTICAST_MASK) >> CI_MULTICAST_SHIFT) == CI_MULTICAST_SSM)
-    x.cost += cost_ssm;
+    x.cost += base.ssm;
   else
-    x.cost += cost_mc;
+    x.cost += base.mc;
   if (!(ci & CI_LOOPBACK))
     x.cost += cost_non_loopback;
 
@@ -457,17 +534,13 @@ static bool locator_is_iceoryx (const ddsi_xlocator_t *l)
 #endif
 }
 
-static bool wras_cover_locatorset (struct ddsi_domaingv const * const gv, struct cover *cov, const struct locset *locs, const struct locset *work_locs, int rdidx, int nloopback, int first, int last) ddsrt_attribute_warn_unused_result;
-
-static bool wras_cover_locatorset (struct ddsi_domaingv const * const gv, struct cover *cov, const struct locset *locs, const struct locset *work_locs, int rdidx, int nloopback, int first, int last)
+static void wras_cover_locatorset (struct ddsi_domaingv const * const gv, struct cover *cov, const struct locset *locs, const struct locset *work_locs, int rdidx, int nloopback, int first, int last)
 {
   for (int j = first; j <= last; j++)
   {
-    /* all addresses should be in the combined set of addresses, unless the address sets change on the fly:
-       in that case, restart */
+    /* all addresses are in the combined set of addresses because both derive from the same rows */
     const ddsi_xlocator_t *l = bsearch (&work_locs->locs[j], locs->locs, (size_t) locs->nlocs, sizeof (*locs->locs), wras_compare_locs);
-    if (l == NULL)
-      return false;
+    assert (l != NULL);
     cover_info_t x;
     int lidx = (int) (l - locs->locs);
     if (locator_is_iceoryx (l)) // FIXME: a gross hack
@@ -493,49 +566,45 @@ static bool wras_cover_locatorset (struct ddsi_domaingv const * const gv, struct
     assert (cover_get (cov, rdidx, lidx) == 0xff);
     cover_set (cov, rdidx, lidx, x);
   }
-  return true;
 }
 
-static bool wras_calc_cover (const struct writer *wr, const struct locset *locs, struct cover **pcov) ddsrt_attribute_warn_unused_result;
-
-static bool wras_calc_cover (const struct writer *wr, const struct locset *locs, struct cover **pcov)
+static struct cover *wras_calc_cover (const struct writer *wr, const struct locset *locs, const struct wras_row *rows, int nrows)
 {
   struct ddsi_domaingv * const gv = wr->e.gv;
-  struct entity_index * const gh = gv->entity_index;
-  ddsrt_avl_iter_t it;
   const bool want_rdnames = true;
   // allocate cover matrix, it needs to be grow if there are readers requesting redundant delivery
   // (but that's rare enough to be ok with reallocating it for now)
-  struct cover *cov = cover_new ((int) wr->num_readers, locs->nlocs, want_rdnames);
-  struct locset *work_locs = locset_new (locs->nlocs);
+  struct cover *cov = cover_new (nrows, locs->nlocs, want_rdnames);
+  int maxrowlocs = 0;
+  for (int r = 0; r < nrows; r++)
+  {
+    if (rows[r].nlocs > maxrowlocs)
+      maxrowlocs = rows[r].nlocs;
+    if (rows[r].nssm > maxrowlocs)
+      maxrowlocs = rows[r].nssm;
+  }
+  struct locset *work_locs = locset_new (maxrowlocs);
   int rdidx = 0;
   char rdletter = 'a', rddigit = '0';
-  for (struct wr_prd_match *m = ddsrt_avl_iter_first (&wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  for (int r = 0; r < nrows; r++)
   {
-    struct proxy_reader *prd;
-    struct addrset *ass[] = { NULL, NULL, NULL };
+    const struct wras_row * const row = &rows[r];
+    const ddsi_xlocator_t * const parts[] = { row->locs, row->locs + row->nlocs };
+    const int nparts[] = { row->nlocs, row->nssm };
     bool increment_rdidx = true;
-    if ((prd = entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
-      continue;
-    ass[0] = prd->c.as;
-#ifdef DDS_HAS_SSM
-    if (prd->favours_ssm && wr->supports_ssm)
-      ass[1] = wr->ssm_as;
-#endif
-    for (int i = 0; ass[i]; i++)
+    for (int i = 0; i < 2; i++)
     {
-      work_locs->nlocs = locs->nlocs;
-      wras_flatten_locs_prealloc (work_locs, ass[i]);
+      if (nparts[i] == 0)
+        continue;
+      work_locs->nlocs = nparts[i];
+      memcpy (work_locs->locs, parts[i], (size_t) nparts[i] * sizeof (*work_locs->locs));
       const int nloopback = move_loopback_forward (gv, work_locs);
-      GVTRACE ("nloopback = %d, nlocs = %d, redundant_networking = %d\n", nloopback, work_locs->nlocs, prd->redundant_networking);
-      if (!prd->redundant_networking || nloopback == work_locs->nlocs)
+      GVTRACE ("nloopback = %d, nlocs = %d, redundant_networking = %d\n", nloopback, work_locs->nlocs, row->redundant_networking);
+      if (!row->redundant_networking || nloopback == work_locs->nlocs)
       {
         cover_makeroom (&cov, rdidx);
         for (int j = 0; j < work_locs->nlocs; j++)
-        {
-          if (!wras_cover_locatorset (gv, cov, locs, work_locs, rdidx, nloopback, j, j))
-            goto addrset_changed;
-        }
+          wras_cover_locatorset (gv, cov, locs, work_locs, rdidx, nloopback, j, j);
       }
       else
       {
@@ -544,16 +613,12 @@ static bool wras_calc_cover (const struct writer *wr, const struct locset *locs,
         {
           cover_makeroom (&cov, rdidx);
           if (nloopback > 0)
-          {
-            if (!wras_cover_locatorset (gv, cov, locs, work_locs, rdidx, nloopback, 0, nloopback - 1))
-              goto addrset_changed;
-          }
+            wras_cover_locatorset (gv, cov, locs, work_locs, rdidx, nloopback, 0, nloopback - 1);
           int k = j + 1;
           while (k < work_locs->nlocs && work_locs->locs[j].conn == work_locs->locs[k].conn)
             k++;
           GVTRACE ("j = %d, k = %d\n", j, k);
-          if (!wras_cover_locatorset (gv, cov, locs, work_locs, rdidx, nloopback, j, k - 1))
-            goto addrset_changed;
+          wras_cover_locatorset (gv, cov, locs, work_locs, rdidx, nloopback, j, k - 1);
           j = k;
           for (int l = 0; l < cov->nlocs; l++)
             if (cover_get (cov, rdidx, l) == 0xff)
@@ -584,19 +649,13 @@ static bool wras_calc_cover (const struct writer *wr, const struct locset *locs,
   if (rdidx == 0)
   {
     cover_free (cov);
-    *pcov = NULL;
+    return NULL;
   }
   else
   {
     cover_update_nreaders (cov, rdidx);
-    *pcov = cov;
+    return cov;
   }
-  return true;
-
-addrset_changed:
-  locset_free (work_locs);
-  cover_free (cov);
-  return false;
 }
 
 static struct costmap *wras_calc_costmap (const struct cover *covered, bool prefer_multicast, dds_locator_mask_t ignore)
@@ -756,46 +815,20 @@ static void wras_drop_covered_readers (int locidx, struct costmap *wm, struct co
 #endif
 }
 
-struct addrset *compute_writer_addrset (const struct writer *wr)
+static struct addrset *wras_calc_addrset (const struct writer *wr, const struct wras_row *rows, int nrows)
 {
   struct ddsi_domaingv * const gv = wr->e.gv;
   const bool prefer_multicast = gv->config.prefer_multicast;
-  struct locset *locs;
+  struct addrset *newas = new_addrset ();
+  struct locset *locs = wras_calc_locators (&gv->logconfig, rows, nrows);
   struct cover *covered;
-  struct addrset *newas;
-
-  // Gather all addresses, using an addrset means no need to worry about
-  // duplicates. If no addresses found it is trivial.
-  {
-    struct addrset *all_addrs = wras_collect_all_locs (wr);
-    if (addrset_empty (all_addrs))
-      return all_addrs;
-    nn_log_addrset (gv, DDS_LC_DISCOVERY, "setcover: all_addrs", all_addrs);
-    ELOGDISC (wr, "\n");
-    locs = wras_calc_locators (&gv->logconfig, all_addrs);
-    unref_addrset (all_addrs);
-  }
 
-  if (!wras_calc_cover (wr, locs, &covered))
-  {
-    // Addrset computation fails when some proxy reader's address can't be found in all_addrs,
-    // which means its address set changed while we were working.  In that case, the change
-    // will trigger a recalculation and we can just return the old one.
-    //
-    // FIXME: copying it is a bit excessive (a little rework and refcount manipulation suffices)
-    newas = ref_addrset (wr->as);
-  }
-  else if (covered == NULL)
-  {
-    // No readers, no need to do anything else
-    newas = new_addrset ();
-  }
-  else
+  // No readers or no addresses: no need to do anything else
+  if (locs->nlocs > 0 && (covered = wras_calc_cover (wr, locs, rows, nrows)) != NULL)
   {
     assert(wr->xqos->present & QP_LOCATOR_MASK);
     struct costmap *wm = wras_calc_costmap (covered, prefer_multicast, wr->xqos->ignore_locator_type);
     int best;
-    newas = new_addrset ();
     while ((best = wras_choose_locator (locs, wm)) >= 0)
     {
       wras_trace_cover (gv, locs, wm, covered);
@@ -809,3 +842,476 @@ struct addrset *compute_writer_addrset (const struct writer *wr)
   locset_free (locs);
   return newas;
 }
+
+// Cache of recently computed address sets, keyed by the (canonically ordered)
+// locators of the readers: writers matching the same set of readers, or sets
+// of readers that are reachable in exactly the same way, then don't need to
+// redo the set cover computation.  The cached address sets are never modified,
+// updates always make a copy.
+#define WRAS_CACHE_SIZE 32
+
+struct wras_cache_entry {
+  uint32_t hash;
+  dds_locator_mask_t ignore_locator_type;
+  int nrows;
+  struct wras_row *rows;
+  struct addrset *as; // NULL iff entry unused
+  uint64_t tlastuse;
+};
+
+struct wraddrset_cache {
+  ddsrt_mutex_t lock;
+  uint64_t tnow;
+  struct wras_cache_entry entries[WRAS_CACHE_SIZE];
+};
+
+void wraddrset_cache_init (struct ddsi_domaingv *gv)
+{
+  struct wraddrset_cache *c = ddsrt_malloc (sizeof (*c));
+  ddsrt_mutex_init (&c->lock);
+  c->tnow = 0;
+  for (int i = 0; i < WRAS_CACHE_SIZE; i++)
+  {
+    c->entries[i].rows = NULL;
+    c->entries[i].as = NULL;
+  }
+  gv->wraddrset_cache = c;
+}
+
+static void wras_cache_entry_fini (struct wras_cache_entry *e)
+{
+  if (e->as)
+  {
+    unref_addrset (e->as);
+    wras_free_rows (e->rows, e->nrows);
+    e->as = NULL;
+    e->rows = NULL;
+  }
+}
+
+void wraddrset_cache_fini (struct ddsi_domaingv *gv)
+{
+  struct wraddrset_cache *c = gv->wraddrset_cache;
+  for (int i = 0; i < WRAS_CACHE_SIZE; i++)
+    wras_cache_entry_fini (&c->entries[i]);
+  ddsrt_mutex_destroy (&c->lock);
+  ddsrt_free (c);
+  gv->wraddrset_cache = NULL;
+}
+
+static bool wras_cacheable (const struct writer *wr)
+{
+  // the writer's SSM address set isn't part of the key
+#ifdef DDS_HAS_SSM
+  return !(wr->supports_ssm && wr->ssm_as);
+#else
+  (void) wr;
+  return true;
+#endif
+}
+
+static uint32_t wras_hash_rows (const struct wras_row *rows, int nrows, dds_locator_mask_t ignore_locator_type)
+{
+  uint32_t h = ddsrt_mh3 (&ignore_locator_type, sizeof (ignore_locator_type), 0);
+  for (int i = 0; i < nrows; i++)
+  {
+    const uint32_t hdr[3] = { rows[i].redundant_networking, (uint32_t) rows[i].nlocs, (uint32_t) rows[i].nssm };
+    h = ddsrt_mh3 (hdr, sizeof (hdr), h);
+    for (int j = 0; j < rows[i].nlocs + rows[i].nssm; j++)
+    {
+      const ddsi_xlocator_t *l = &rows[i].locs[j];
+      const uintptr_t conn = (uintptr_t) l->conn;
+      h = ddsrt_mh3 (&l->c.kind, sizeof (l->c.kind), h);
+      h = ddsrt_mh3 (&l->c.port, sizeof (l->c.port), h);
+      h = ddsrt_mh3 (l->c.address, sizeof (l->c.address), h);
+      h = ddsrt_mh3 (&conn, sizeof (conn), h);
+    }
+  }
+  return h;
+}
+
+static struct addrset *wras_cache_lookup (struct ddsi_domaingv *gv, const struct writer *wr, uint32_t hash, const struct wras_row *rows, int nrows)
+{
+  struct wraddrset_cache * const c = gv->wraddrset_cache;
+  struct addrset *as = NULL;
+  ddsrt_mutex_lock (&c->lock);
+  for (int i = 0; i < WRAS_CACHE_SIZE && as == NULL; i++)
+  {
+    struct wras_cache_entry * const e = &c->entries[i];
+    if (e->as == NULL || e->hash != hash || e->nrows != nrows || e->ignore_locator_type != wr->xqos->ignore_locator_type)
+      continue;
+    int j;
+    for (j = 0; j < nrows; j++)
+      if (wras_compare_rows (&e->rows[j], &rows[j]) != 0)
+        break;
+    if (j == nrows)
+    {
+      e->tlastuse = ++c->tnow;
+      as = ref_addrset (e->as);
+    }
+  }
+  ddsrt_mutex_unlock (&c->lock);
+  return as;
+}
+
+static void wras_cache_insert (struct ddsi_domaingv *gv, const struct writer *wr, uint32_t hash, const struct wras_row *rows, int nrows, struct addrset *as)
+{
+  struct wraddrset_cache * const c = gv->wraddrset_cache;
+  struct wras_row *rows_copy = ddsrt_malloc ((size_t) nrows * sizeof (*rows_copy));
+  for (int i = 0; i < nrows; i++)
+  {
+    const size_t sz = (size_t) (rows[i].nlocs + rows[i].nssm) * sizeof (*rows[i].locs);
+    rows_copy[i] = rows[i];
+    rows_copy[i].locs = ddsrt_malloc (sz > 0 ? sz : 1);
+    if (sz > 0)
+      memcpy (rows_copy[i].locs, rows[i].locs, sz);
+  }
+  ddsrt_mutex_lock (&c->lock);
+  // an unused entry if there is one, else the least recently used one
+  struct wras_cache_entry *e = &c->entries[0];
+  for (int i = 1; i < WRAS_CACHE_SIZE && e->as != NULL; i++)
+    if (c->entries[i].as == NULL || c->entries[i].tlastuse < e->tlastuse)
+      e = &c->entries[i];
+  wras_cache_entry_fini (e);
+  e->hash = hash;
+  e->ignore_locator_type = wr->xqos->ignore_locator_type;
+  e->nrows = nrows;
+  e->rows = rows_copy;
+  e->as = ref_addrset (as);
+  e->tlastuse = ++c->tnow;
+  ddsrt_mutex_unlock (&c->lock);
+}
+
+// Bookkeeping for incremental updates: for each proxy reader the locators at
+// the time it was added, for each locator the number of readers reachable
+// via it, how many of those can also be reached via another locator, and
+// whether it is in the writer's address set.
+//
+// Incremental updates must give the same result as a full recompute, and
+// so are limited to the cases where the outcome of the set cover for the
+// other readers is known not to change:
+// - a locator for which "nmulti" is 0 is the only way of reaching its
+//   readers and therefore part of any cover, and the locators of those
+//   readers don't reach any other reader;
+// - a locator reaching only one reader doesn't affect any other reader;
+// - if there is only one locator reaching multiple readers and it is
+//   cheaper than any locator reaching a single reader can be, the cover
+//   consists of that one and, for the other readers, whatever would be
+//   chosen for each individually.
+// That covers readers with their own unicast locators, readers sharing a
+// single unicast locator and readers with their own unicast locator plus a
+// multicast locator shared by all of them.
+struct wras_reader {
+  ddsrt_avl_node_t avlnode;
+  struct wras_row row;
+};
+
+struct wras_loc {
+  ddsrt_avl_node_t avlnode;
+  ddsi_xlocator_t loc;
+  uint32_t nrds;
+  uint32_t nmulti;
+  bool selected;
+};
+
+struct wraddrset_state {
+  ddsrt_avl_tree_t readers;
+  ddsrt_avl_tree_t locs;
+  uint32_t nshared; // number of locators reaching more than one reader
+};
+
+static int wras_compare_guid (const void *va, const void *vb)
+{
+  return memcmp (va, vb, sizeof (ddsi_guid_t));
+}
+
+static const ddsrt_avl_treedef_t wras_readers_treedef =
+  DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct wras_reader, avlnode), offsetof (struct wras_reader, row.prd_guid), wras_compare_guid, 0);
+static const ddsrt_avl_treedef_t wras_locs_treedef =
+  DDSRT_AVL_TREEDEF_INITIALIZER (offsetof (struct wras_loc, avlnode), offsetof (struct wras_loc, loc), wras_compare_xlocators_vwrap, 0);
+
+static void wras_free_reader (void *vrd)
+{
+  struct wras_reader *rd = vrd;
+  ddsrt_free (rd->row.locs);
+  ddsrt_free (rd);
+}
+
+void writer_addrset_state_free (struct writer *wr)
+{
+  struct wraddrset_state * const st = wr->as_state;
+  if (st == NULL)
+    return;
+  ddsrt_avl_free (&wras_readers_treedef, &st->readers, wras_free_reader);
+  ddsrt_avl_free (&wras_locs_treedef, &st->locs, ddsrt_free);
+  ddsrt_free (st);
+  wr->as_state = NULL;
+}
+
+static void wras_state_add_row (struct wraddrset_state *st, const struct wras_row *row)
+{
+  struct wras_reader *rd = ddsrt_malloc (sizeof (*rd));
+  rd->row = *row;
+  ddsrt_avl_insert (&wras_readers_treedef, &st->readers, rd);
+  for (int i = 0; i < row->nlocs; i++)
+  {
+    ddsrt_avl_ipath_t path;
+    struct wras_loc *l;
+    if ((l = ddsrt_avl_lookup_ipath (&wras_locs_treedef, &st->locs, &row->locs[i], &path)) == NULL)
+    {
+      l = ddsrt_malloc (sizeof (*l));
+      l->loc = row->locs[i];
+      l->nrds = 0;
+      l->nmulti = 0;
+      l->selected = false;
+      ddsrt_avl_insert_ipath (&wras_locs_treedef, &st->locs, l, &path);
+    }
+    if (++l->nrds == 2)
+      st->nshared++;
+    if (row->nlocs > 1)
+      l->nmulti++;
+  }
+}
+
+struct wras_state_select_arg {
+  struct wraddrset_state *st;
+  bool ok;
+};
+
+static void wras_state_select (const ddsi_xlocator_t *loc, void *varg)
+{
+  struct wras_state_select_arg *arg = varg;
+  struct wras_loc *l;
+  if ((l = ddsrt_avl_lookup (&wras_locs_treedef, &arg->st->locs, loc)) == NULL)
+    arg->ok = false;
+  else
+    l->selected = true;
+}
+
+static bool wras_state_select_addrset (struct wraddrset_state *st, struct addrset *as)
+{
+  struct wras_state_select_arg arg = { .st = st, .ok = true };
+  addrset_forall (as, wras_state_select, &arg);
+  return arg.ok;
+}
+
+static void wras_init_state (struct writer *wr, struct wras_row *rows, int nrows, struct addrset *as)
+{
+  // takes ownership of the locators in rows
+  int i;
+  for (i = 0; i < nrows; i++)
+    if (!wras_row_is_simple (&rows[i]))
+      break;
+  if (i < nrows || !wras_cacheable (wr))
+  {
+    for (i = 0; i < nrows; i++)
+      ddsrt_free (rows[i].locs);
+    return;
+  }
+  struct wraddrset_state *st = ddsrt_malloc (sizeof (*st));
+  ddsrt_avl_init (&wras_readers_treedef, &st->readers);
+  ddsrt_avl_init (&wras_locs_treedef, &st->locs);
+  st->nshared = 0;
+  wr->as_state = st;
+  for (i = 0; i < nrows; i++)
+    wras_state_add_row (st, &rows[i]);
+  if (!wras_state_select_addrset (st, as))
+    writer_addrset_state_free (wr);
+}
+
+struct addrset *compute_writer_addrset (struct writer *wr)
+{
+  struct ddsi_domaingv * const gv = wr->e.gv;
+  struct addrset *newas;
+  struct wras_row *rows;
+  int nrows;
+
+  writer_addrset_state_free (wr);
+  rows = wras_collect_rows (wr, &nrows);
+  if (nrows == 0)
+    newas = new_addrset ();
+  else if (!wras_cacheable (wr))
+    newas = wras_calc_addrset (wr, rows, nrows);
+  else
+  {
+    qsort (rows, (size_t) nrows, sizeof (*rows), wras_compare_rows);
+    const uint32_t hash = wras_hash_rows (rows, nrows, wr->xqos->ignore_locator_type);
+    if ((newas = wras_cache_lookup (gv, wr, hash, rows, nrows)) != NULL)
+      ELOGDISC (wr, "setcover: cached\n");
+    else
+    {
+      newas = wras_calc_addrset (wr, rows, nrows);
+      wras_cache_insert (gv, wr, hash, rows, nrows, newas);
+    }
+  }
+  wras_init_state (wr, rows, nrows, newas);
+  ddsrt_free (rows);
+  return newas;
+}
+
+static bool wras_dominates (const struct writer *wr, const ddsi_xlocator_t *loc, uint32_t nrds)
+{
+  // Whether the set cover computation chooses "loc" reaching "nrds" readers
+  // before any locator reaching a single one of them.  The costs depend only
+  // on the kind of locator, whether it is a loopback one and the number of
+  // readers, and a locator reaching a single reader can't be cheaper than a
+  // loopback unicast or multicast one.
+  const bool prefer_multicast = wr->e.gv->config.prefer_multicast;
+  const struct wras_row row = {
+    .redundant_networking = false, .nlocs = 1, .nssm = 0, .locs = (ddsi_xlocator_t *) loc
+  };
+  struct locset *locs = wras_calc_locators (&wr->e.gv->logconfig, &row, 1);
+  struct cover *covered = wras_calc_cover (wr, locs, &row, 1);
+  cost_t cost = INT32_MAX;
+  if (covered != NULL)
+  {
+    cost = calc_locator_cost (covered, 0, prefer_multicast, wr->xqos->ignore_locator_type).cost;
+    cover_free (covered);
+  }
+  locset_free (locs);
+  if (cost == INT32_MAX)
+    return false;
+  cost = sat_cost_add (cost, (int32_t) (nrds - 1) * cost_delivered);
+
+  const struct locator_base_cost base = get_locator_base_cost (prefer_multicast);
+  cost_t min_cost = (base.uc < base.mc) ? base.uc : base.mc;
+  if (base.ssm < min_cost)
+    min_cost = base.ssm;
+  min_cost += cost_delivered;
+  return cost < min_cost || (cost == min_cost && nrds > 1);
+}
+
+static struct addrset *wras_modifiable_addrset (struct writer *wr)
+{
+  // Returns a new reference to an address set with the same contents as the
+  // writer's that may be modified: the writer's own one if it is referenced
+  // only by the writer (it can't gain references without the writer lock),
+  // else a copy, because it may be in the cache or in a queued message.
+  if (ddsrt_atomic_ld32 (&wr->as->refc) == 1)
+    return ref_addrset (wr->as);
+  else
+  {
+    struct addrset *as = new_addrset ();
+    copy_addrset_into_addrset (wr->e.gv, as, wr->as);
+    return as;
+  }
+}
+
+struct addrset *writer_addrset_add_reader (struct writer *wr, const struct proxy_reader *prd)
+{
+  struct wraddrset_state * const st = wr->as_state;
+  struct addrset *newas;
+  struct wras_row row;
+  if (st == NULL)
+    return NULL;
+  wras_make_row (wr, prd, &row);
+  if (!wras_row_is_simple (&row) || ddsrt_avl_lookup (&wras_readers_treedef, &st->readers, &row.prd_guid) != NULL)
+    goto full;
+
+  const struct wras_loc *known = NULL;
+  int nknown = 0, nforced = 0;
+  for (int i = 0; i < row.nlocs; i++)
+  {
+    const struct wras_loc *l;
+    if ((l = ddsrt_avl_lookup (&wras_locs_treedef, &st->locs, &row.locs[i])) != NULL)
+    {
+      // a locator shared with other readers that is not currently selected
+      // may well be a better choice than the ones selected for those readers
+      if (!l->selected)
+        goto full;
+      known = l;
+      nknown++;
+      if (l->nmulti == 0)
+        nforced++;
+    }
+  }
+  if (nknown > 0 && nforced == row.nlocs)
+  {
+    // already reached via locators that are in any cover
+    newas = ref_addrset (wr->as);
+    wras_state_add_row (st, &row);
+  }
+  else if (nknown == 1 && st->nshared + (known->nrds == 1 ? 1 : 0) == 1 &&
+           wras_dominates (wr, &known->loc, (known->nrds == 1) ? 2 : known->nrds))
+  {
+    // the only locator reaching multiple readers was chosen for all of them
+    // and remains the best choice when it reaches this reader, too
+    newas = ref_addrset (wr->as);
+    wras_state_add_row (st, &row);
+  }
+  else if (nknown > 0)
+  {
+    goto full;
+  }
+  else
+  {
+    // no other reader can be reached through any of the locators, so the
+    // cover for the other readers is unaffected and the best choice for this
+    // reader is what it would be if it were the only one
+    struct addrset *rdas = wras_calc_addrset (wr, &row, 1);
+    newas = wras_modifiable_addrset (wr);
+    copy_addrset_into_addrset (wr->e.gv, newas, rdas);
+    wras_state_add_row (st, &row);
+    const bool ok = wras_state_select_addrset (st, rdas);
+    assert (ok);
+    (void) ok;
+    unref_addrset (rdas);
+  }
+  ELOGDISC (wr, "setcover: incremental add "PGUIDFMT"\n", PGUID (prd->e.guid));
+  return newas;
+
+full:
+  ddsrt_free (row.locs);
+  return NULL;
+}
+
+struct addrset *writer_addrset_remove_reader (struct writer *wr, const struct proxy_reader *prd)
+{
+  struct wraddrset_state * const st = wr->as_state;
+  struct addrset *newas = NULL;
+  struct wras_reader *rd;
+  ddsrt_avl_dpath_t dpath;
+  if (st == NULL || (rd = ddsrt_avl_lookup_dpath (&wras_readers_treedef, &st->readers, &prd->e.guid, &dpath)) == NULL)
+    return NULL;
+  // the remaining readers reachable via one of this reader's locators must
+  // have no alternatives, or, if there is one locator reaching multiple
+  // readers, it must remain the best choice for the remaining ones, else the
+  // cover for them may well change
+  const uint32_t multi = (rd->row.nlocs > 1) ? 1 : 0;
+  const struct wras_loc *shared = NULL;
+  int nshared = 0;
+  for (int i = 0; i < rd->row.nlocs; i++)
+  {
+    const struct wras_loc *l = ddsrt_avl_lookup (&wras_locs_treedef, &st->locs, &rd->row.locs[i]);
+    assert (l != NULL && l->nrds > 0 && l->nmulti >= multi);
+    if (l->nrds > 1 && l->nmulti > multi)
+      shared = l;
+    if (l->nrds > 1)
+      nshared++;
+  }
+  if (shared != NULL && !(nshared == 1 && st->nshared == 1 && shared->nrds > 2 && wras_dominates (wr, &shared->loc, shared->nrds - 1)))
+    return NULL;
+  ddsrt_avl_delete_dpath (&wras_readers_treedef, &st->readers, rd, &dpath);
+  // locators through which no reader can be reached anymore can be dropped,
+  // the remaining readers all remain covered
+  for (int i = 0; i < rd->row.nlocs; i++)
+  {
+    struct wras_loc *l = ddsrt_avl_lookup_dpath (&wras_locs_treedef, &st->locs, &rd->row.locs[i], &dpath);
+    l->nmulti -= multi;
+    if (--l->nrds == 1)
+      st->nshared--;
+    if (l->nrds > 0)
+      continue;
+    if (l->selected)
+    {
+      if (newas == NULL)
+        newas = wras_modifiable_addrset (wr);
+      remove_from_addrset (wr->e.gv, newas, &l->loc);
+    }
+    ddsrt_avl_delete_dpath (&wras_locs_treedef, &st->locs, l, &dpath);
+    ddsrt_free (l);
+  }
+  wras_free_reader (rd);
+  ELOGDISC (wr, "setcover: incremental remove "PGUIDFMT"\n", PGUID (prd->e.guid));
+  return newas ? newas : ref_addrset (wr->as);
+}
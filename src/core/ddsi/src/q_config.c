@@ -20,6 +20,7 @@
 
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/log.h"
+#include "dds/ddsrt/bintrace.h"
 #include "dds/ddsrt/string.h"
 #include "dds/ddsrt/strtod.h"
 #include "dds/ddsrt/misc.h"
@@ -30,6 +31,7 @@
 #include "dds/ddsi/q_unused.h"
 #include "dds/ddsi/q_misc.h"
 #include "dds/ddsi/q_addrset.h"
+#include "dds/ddsi/ddsi_tran.h"
 
 #include "dds/ddsrt/xmlparser.h"
 
@@ -161,6 +163,10 @@ DUPF(uint32);
 #endif
 DU(natint);
 DU(natint_255);
+DU(recv_batch_size);
+DU(recv_shards);
+DU(write_queue_size);
+DU(delivery_queue_pool_size);
 DUPF(participantIndex);
 DU(dyn_port);
 DUPF(memsize);
@@ -174,6 +180,8 @@ PF(duration);
 DUPF(standards_conformance);
 DUPF(besmode);
 DUPF(retransmit_merging);
+DUPF(xevent_queue_kind);
+DUPF(trace_format);
 DUPF(sched_class);
 DUPF(maybe_memsize);
 DUPF(maybe_int32);
@@ -926,6 +934,14 @@ static const char *en_retransmit_merging_vs[] = { "never", "adaptive", "always",
 static const enum ddsi_retransmit_merging en_retransmit_merging_ms[] = { DDSI_REXMIT_MERGE_NEVER, DDSI_REXMIT_MERGE_ADAPTIVE, DDSI_REXMIT_MERGE_ALWAYS, 0 };
 GENERIC_ENUM_CTYPE (retransmit_merging, enum ddsi_retransmit_merging)
 
+static const char *en_xevent_queue_kind_vs[] = { "heap", "wheel", NULL };
+static const enum ddsi_xevent_queue_kind en_xevent_queue_kind_ms[] = { DDSI_XEVQ_HEAP, DDSI_XEVQ_WHEEL, 0 };
+GENERIC_ENUM_CTYPE (xevent_queue_kind, enum ddsi_xevent_queue_kind)
+
+static const char *en_trace_format_vs[] = { "text", "binary", NULL };
+static const enum ddsi_trace_format en_trace_format_ms[] = { DDSI_TRACE_FORMAT_TEXT, DDSI_TRACE_FORMAT_BINARY, 0 };
+GENERIC_ENUM_CTYPE (trace_format, enum ddsi_trace_format)
+
 static const char *en_sched_class_vs[] = { "realtime", "timeshare", "default", NULL };
 static const ddsrt_sched_t en_sched_class_ms[] = { DDSRT_SCHED_REALTIME, DDSRT_SCHED_TIMESHARE, DDSRT_SCHED_DEFAULT, 0 };
 GENERIC_ENUM_CTYPE (sched_class, ddsrt_sched_t)
@@ -1368,6 +1384,50 @@ static enum update_result uf_natint_255(struct cfgst *cfgst, void *parent, struc
   return uf_int_min_max(cfgst, parent, cfgelem, first, value, 0, 255);
 }
 
+static enum update_result uf_recv_batch_size (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, int first, const char *value)
+{
+  uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
+  if (uf_uint (cfgst, parent, cfgelem, first, value) != URES_SUCCESS)
+    return URES_ERROR;
+  else if (*elem < 1 || *elem > DDSI_TRAN_READ_BATCH_MAX)
+    return cfg_error (cfgst, "%s: out of range", value);
+  else
+    return URES_SUCCESS;
+}
+
+static enum update_result uf_recv_shards (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, int first, const char *value)
+{
+  uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
+  if (uf_uint (cfgst, parent, cfgelem, first, value) != URES_SUCCESS)
+    return URES_ERROR;
+  else if (*elem < 1 || *elem > DDSI_TRAN_RECV_SHARDS_MAX)
+    return cfg_error (cfgst, "%s: out of range", value);
+  else
+    return URES_SUCCESS;
+}
+
+static enum update_result uf_write_queue_size (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, int first, const char *value)
+{
+  uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
+  if (uf_uint (cfgst, parent, cfgelem, first, value) != URES_SUCCESS)
+    return URES_ERROR;
+  else if (*elem > DDSI_WRITE_QUEUE_SIZE_MAX)
+    return cfg_error (cfgst, "%s: out of range", value);
+  else
+    return URES_SUCCESS;
+}
+
+static enum update_result uf_delivery_queue_pool_size (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, int first, const char *value)
+{
+  uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
+  if (uf_uint (cfgst, parent, cfgelem, first, value) != URES_SUCCESS)
+    return URES_ERROR;
+  else if (*elem < 1 || *elem > DDSI_DELIVERY_QUEUE_POOL_SIZE_MAX)
+    return cfg_error (cfgst, "%s: out of range", value);
+  else
+    return URES_SUCCESS;
+}
+
 static enum update_result uf_uint (struct cfgst *cfgst, void *parent, struct cfgelem const * const cfgelem, UNUSED_ARG (int first), const char *value)
 {
   uint32_t * const elem = cfg_address (cfgst, parent, cfgelem);
@@ -2390,6 +2450,9 @@ void config_fini (struct cfgst *cfgst)
   free_all_elements (cfgst, cfgst->cfg, root_cfgelems);
   dds_set_log_file (stderr);
   dds_set_trace_file (stderr);
+  if (cfgst->cfg->tracebin) {
+    ddsrt_bintrace_free (cfgst->cfg->tracebin);
+  }
   if (cfgst->cfg->tracefp && cfgst->cfg->tracefp != stdout && cfgst->cfg->tracefp != stderr) {
     fclose(cfgst->cfg->tracefp);
   }
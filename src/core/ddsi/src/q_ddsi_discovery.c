@@ -19,6 +19,7 @@
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/log.h"
 #include "dds/ddsrt/md5.h"
+#include "dds/ddsrt/mh3.h"
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsrt/string.h"
@@ -1535,6 +1536,18 @@ static void addrset_from_locatorlists_collect_interfaces (const ddsi_xlocator_t
   }
 }
 
+#ifndef DDS_HAS_NETWORK_CHANNELS
+static struct nn_dqueue *user_dqueue_for_topic (const struct ddsi_domaingv *gv, const char *topic_name)
+{
+  /* All writers of a topic map to the same queue: that preserves the order
+     per writer and avoids delivery threads contending for the same readers */
+  if (gv->n_user_dqueues == 1)
+    return gv->user_dqueues[0];
+  const uint32_t h = ddsrt_mh3 (topic_name, strlen (topic_name), 0);
+  return gv->user_dqueues[h % gv->n_user_dqueues];
+}
+#endif
+
 static void handle_sedp_alive_endpoint (const struct receiver_state *rst, seqno_t seq, ddsi_plist_t *datap /* note: potentially modifies datap */, ddsi_sedp_kind_t sedp_kind, const ddsi_guid_prefix_t *src_guid_prefix, nn_vendorid_t vendorid, ddsrt_wctime_t timestamp)
 {
 #define E(msg, lbl) do { GVLOGDISC (msg); goto lbl; } while (0)
@@ -1640,24 +1653,35 @@ static void handle_sedp_alive_endpoint (const struct receiver_state *rst, seqno_
       srcloc = rst->srcloc;
     }
 
-    // any interface that works for the participant is presumed ok
-    interface_set_t intfs;
-    interface_set_init (&intfs);
-    addrset_forall (proxypp->as_default, addrset_from_locatorlists_collect_interfaces, &(struct addrset_from_locatorlists_collect_interfaces_arg){
-      .gv = gv, .intfs = &intfs
-    });
-    //GVTRACE(" {%d%d%d%d}", intfs.xs[0], intfs.xs[1], intfs.xs[2], intfs.xs[3]);
-    as = addrset_from_locatorlists (gv, uc, mc, &srcloc, &intfs);
-    // if SEDP gives:
-    // - no addresses, use ppant uni- and multicast addresses
-    // - only multicast, use those for multicast and use ppant address for unicast
-    // - only unicast, use only those (i.e., disable multicast for this reader)
-    // - both, use only those
-    // FIXME: then you can't do a specific unicast address + SSM ... oh well
-    if (addrset_empty (as))
-      copy_addrset_into_addrset_mc (gv, as, proxypp->as_default);
-    if (addrset_empty_uc (as))
-      copy_addrset_into_addrset_uc (gv, as, proxypp->as_default);
+    if (uc->n == 0 && mc->n == 0 && is_unspec_locator (&srcloc))
+    {
+      // No addresses at all is the common case (Cyclone only includes them if
+      // they differ from the participant's), and then the endpoint's address
+      // set would be a copy of the participant's.  That one never changes, so
+      // share it instead of allocating a copy for each proxy endpoint.
+      as = ref_addrset (proxypp->as_default);
+    }
+    else
+    {
+      // any interface that works for the participant is presumed ok
+      interface_set_t intfs;
+      interface_set_init (&intfs);
+      addrset_forall (proxypp->as_default, addrset_from_locatorlists_collect_interfaces, &(struct addrset_from_locatorlists_collect_interfaces_arg){
+        .gv = gv, .intfs = &intfs
+      });
+      //GVTRACE(" {%d%d%d%d}", intfs.xs[0], intfs.xs[1], intfs.xs[2], intfs.xs[3]);
+      as = addrset_from_locatorlists (gv, uc, mc, &srcloc, &intfs);
+      // if SEDP gives:
+      // - no addresses, use ppant uni- and multicast addresses
+      // - only multicast, use those for multicast and use ppant address for unicast
+      // - only unicast, use only those (i.e., disable multicast for this reader)
+      // - both, use only those
+      // FIXME: then you can't do a specific unicast address + SSM ... oh well
+      if (addrset_empty (as))
+        copy_addrset_into_addrset_mc (gv, as, proxypp->as_default);
+      if (addrset_empty_uc (as))
+        copy_addrset_into_addrset_uc (gv, as, proxypp->as_default);
+    }
   }
   if (addrset_empty (as))
   {
@@ -1698,7 +1722,7 @@ static void handle_sedp_alive_endpoint (const struct receiver_state *rst, seqno_
           new_proxy_writer (gv, &ppguid, &datap->endpoint_guid, as, datap, channel->dqueue, channel->evq ? channel->evq : gv->xevents, timestamp, seq);
         }
 #else
-        new_proxy_writer (gv, &ppguid, &datap->endpoint_guid, as, datap, gv->user_dqueue, gv->xevents, timestamp, seq);
+        new_proxy_writer (gv, &ppguid, &datap->endpoint_guid, as, datap, user_dqueue_for_topic (gv, xqos->topic_name), gv->xevents, timestamp, seq);
 #endif
       }
     }
@@ -55,6 +55,7 @@
 #include "dds/ddsi/ddsi_typelookup.h"
 #include "dds/ddsi/ddsi_list_tmpl.h"
 #include "dds/ddsi/ddsi_builtin_topic_if.h"
+#include "dds/ddsi/ddsi_cfilter.h"
 
 #ifdef DDS_HAS_SECURITY
 #include "dds/ddsi/ddsi_security_msg.h"
@@ -606,6 +607,7 @@ static void force_as_disc_address(struct ddsi_domaingv *gv, const ddsi_guid_t *s
   struct writer *wr = entidx_lookup_writer_guid (gv->entity_index, subguid);
   assert (wr != NULL);
   ddsrt_mutex_lock (&wr->e.lock);
+  writer_addrset_state_free (wr);
   unref_addrset (wr->as);
   unref_addrset (wr->as_group);
   wr->as = ref_addrset (gv->as_disc);
@@ -1595,22 +1597,8 @@ static uint32_t get_min_receive_buffer_size (struct writer *wr)
   return min_receive_buffer_size;
 }
 
-static void rebuild_writer_addrset (struct writer *wr)
+static void calc_burst_size_limits (const struct ddsi_domaingv *gv, uint32_t min_receive_buffer_size, uint32_t *init_burst_size_limit, uint32_t *rexmit_burst_size_limit)
 {
-  /* FIXME: way too inefficient in this form:
-     - it gets computed for every change
-     - in many cases the set of addresses from the readers
-       is identical, so we could cache the results */
-
-  /* only one operation at a time */
-  ASSERT_MUTEX_HELD (&wr->e.lock);
-
-  /* swap in new address set; this simple procedure is ok as long as
-     wr->as is never accessed without the wr->e.lock held */
-  struct addrset * const oldas = wr->as;
-  wr->as = compute_writer_addrset (wr);
-  unref_addrset (oldas);
-
   /* Computing burst size limit here is a bit of a hack; but anyway ...
      try to limit bursts of retransmits to 67% of the smallest receive
      buffer, and those of initial transmissions to that + overshoot%.
@@ -1620,29 +1608,89 @@ static void rebuild_writer_addrset (struct writer *wr)
        only small batches
      - the way things are now: the retransmits will be sent unicast,
        so if there are multiple receivers, that'll blow up things by
-       a non-trivial amount */
-  const uint32_t min_receive_buffer_size = get_min_receive_buffer_size (wr);
-  wr->rexmit_burst_size_limit = min_receive_buffer_size - min_receive_buffer_size / 3;
-  if (wr->rexmit_burst_size_limit < 1024)
-    wr->rexmit_burst_size_limit = 1024;
-  if (wr->rexmit_burst_size_limit > wr->e.gv->config.max_rexmit_burst_size)
-    wr->rexmit_burst_size_limit = wr->e.gv->config.max_rexmit_burst_size;
-  if (wr->rexmit_burst_size_limit > UINT32_MAX - UINT16_MAX)
-    wr->rexmit_burst_size_limit = UINT32_MAX - UINT16_MAX;
-
-  const uint64_t limit64 = (uint64_t) wr->e.gv->config.init_transmit_extra_pct * (uint64_t) min_receive_buffer_size / 100;
+       a non-trivial amount
+
+     Both limits are non-decreasing functions of min_receive_buffer_size. */
+  uint32_t rexmit = min_receive_buffer_size - min_receive_buffer_size / 3;
+  if (rexmit < 1024)
+    rexmit = 1024;
+  if (rexmit > gv->config.max_rexmit_burst_size)
+    rexmit = gv->config.max_rexmit_burst_size;
+  if (rexmit > UINT32_MAX - UINT16_MAX)
+    rexmit = UINT32_MAX - UINT16_MAX;
+  *rexmit_burst_size_limit = rexmit;
+
+  const uint64_t limit64 = (uint64_t) gv->config.init_transmit_extra_pct * (uint64_t) min_receive_buffer_size / 100;
   if (limit64 > UINT32_MAX - UINT16_MAX)
-    wr->init_burst_size_limit = UINT32_MAX - UINT16_MAX;
-  else if (limit64 < wr->rexmit_burst_size_limit)
-    wr->init_burst_size_limit = wr->rexmit_burst_size_limit;
+    *init_burst_size_limit = UINT32_MAX - UINT16_MAX;
+  else if (limit64 < rexmit)
+    *init_burst_size_limit = rexmit;
   else
-    wr->init_burst_size_limit = (uint32_t) limit64;
+    *init_burst_size_limit = (uint32_t) limit64;
+}
 
-  ELOGDISC (wr, "rebuild_writer_addrset("PGUIDFMT"):", PGUID (wr->e.guid));
+static void log_writer_addrset (struct writer *wr, const char *what)
+{
+  ELOGDISC (wr, "%s("PGUIDFMT"):", what, PGUID (wr->e.guid));
   nn_log_addrset(wr->e.gv, DDS_LC_DISCOVERY, "", wr->as);
   ELOGDISC (wr, " (burst size %"PRIu32" rexmit %"PRIu32")\n", wr->init_burst_size_limit, wr->rexmit_burst_size_limit);
 }
 
+static void rebuild_writer_addrset (struct writer *wr)
+{
+  /* only one operation at a time */
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+
+  /* swap in new address set; this simple procedure is ok as long as
+     wr->as is never accessed without the wr->e.lock held */
+  struct addrset * const oldas = wr->as;
+  wr->as = compute_writer_addrset (wr);
+  unref_addrset (oldas);
+
+  calc_burst_size_limits (wr->e.gv, get_min_receive_buffer_size (wr), &wr->init_burst_size_limit, &wr->rexmit_burst_size_limit);
+  log_writer_addrset (wr, "rebuild_writer_addrset");
+}
+
+static void update_writer_addrset (struct writer *wr, const struct proxy_reader *prd, bool add, bool filtered)
+{
+  /* Matching or unmatching a single proxy reader: most of the time the
+     address set can be updated without redoing the set cover for all
+     readers, in which case ddsi_wraddrset takes care of it.  Readers with
+     a content filter are always addressed directly and so never affect
+     the address set. */
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  struct addrset *newas = NULL;
+  if (filtered)
+    newas = ref_addrset (wr->as);
+  else if (add)
+    newas = writer_addrset_add_reader (wr, prd);
+  else
+    newas = writer_addrset_remove_reader (wr, prd);
+  if (newas == NULL)
+  {
+    rebuild_writer_addrset (wr);
+    return;
+  }
+
+  struct addrset * const oldas = wr->as;
+  wr->as = newas;
+  unref_addrset (oldas);
+
+  /* the limits can only go down when adding a reader; on removing one,
+     leaving them unchanged errs on the safe side, and they get updated on
+     the next full rebuild */
+  if (add)
+  {
+    uint32_t init_limit, rexmit_limit;
+    calc_burst_size_limits (wr->e.gv, prd->receive_buffer_size, &init_limit, &rexmit_limit);
+    if (init_limit < wr->init_burst_size_limit)
+      wr->init_burst_size_limit = init_limit;
+    if (rexmit_limit < wr->rexmit_burst_size_limit)
+      wr->rexmit_burst_size_limit = rexmit_limit;
+  }
+  log_writer_addrset (wr, "update_writer_addrset");
+}
+
 void rebuild_or_clear_writer_addrsets (struct ddsi_domaingv *gv, int rebuild)
 {
   struct entidx_enum_writer est;
@@ -1658,7 +1706,13 @@ void rebuild_or_clear_writer_addrsets (struct ddsi_domaingv *gv, int rebuild)
       if (rebuild)
         rebuild_writer_addrset(wr);
       else
-        addrset_purge(wr->as);
+      {
+        /* address sets may be shared via the cache, so replace it rather
+           than purging it */
+        writer_addrset_state_free (wr);
+        unref_addrset (wr->as);
+        wr->as = ref_addrset (empty);
+      }
     }
     else
     {
@@ -1689,6 +1743,7 @@ static void free_wr_prd_match (const struct ddsi_domaingv *gv, const ddsi_guid_t
     (void) wr_guid;
 #endif
     nn_lat_estim_fini (&m->hb_to_ack_latency);
+    ddsi_cfilter_free (m->cfilter);
     ddsrt_free (m);
   }
 }
@@ -1785,7 +1840,8 @@ static void writer_drop_connection (const struct ddsi_guid *wr_guid, const struc
       wr->num_readers--;
       wr->num_reliable_readers -= m->is_reliable;
       wr->num_readers_requesting_keyhash -= prd->requests_keyhash ? 1 : 0;
-      rebuild_writer_addrset (wr);
+      wr->num_filtered_readers -= (m->cfilter != NULL);
+      update_writer_addrset (wr, prd, false, m->cfilter != NULL);
       remove_acked_messages (wr, &whcst, &deferred_free_list);
     }
 
@@ -2108,6 +2164,7 @@ static void writer_add_connection (struct writer *wr, struct proxy_reader *prd,
   m->all_have_replied_to_hb = 0;
   m->non_responsive_count = 0;
   m->rexmit_requests = 0;
+  m->cfilter = NULL;
 #ifdef DDS_HAS_SECURITY
   m->crypto_handle = crypto_handle;
 #else
@@ -2139,6 +2196,18 @@ static void writer_add_connection (struct writer *wr, struct proxy_reader *prd,
   m->t_acknack_accepted.v = 0;
   m->t_nackfrag_accepted.v = 0;
 
+  /* Evaluating the reader's content filter here means samples it doesn't
+     want are never sent to it; the reader doesn't depend on it, so failure
+     to compile it merely means everything gets sent */
+  if ((prd->c.xqos->present & QP_CYCLONE_CONTENT_FILTER) && !use_iceoryx)
+  {
+    const dds_content_filter_qospolicy_t *cf = &prd->c.xqos->content_filter;
+    dds_return_t rc;
+    if ((rc = ddsi_cfilter_compile (&m->cfilter, wr->type, cf->expression, cf->parameters.n, cf->parameters.strs)) != DDS_RETCODE_OK)
+      ELOGDISC (wr, "  writer_add_connection(wr "PGUIDFMT" prd "PGUIDFMT") - content filter not applied: %s\n",
+                PGUID (wr->e.guid), PGUID (prd->e.guid), dds_strretcode (rc));
+  }
+
   ddsrt_mutex_lock (&wr->e.lock);
 #ifdef DDS_HAS_SHM
   if (pretend_everything_acked || prd->is_iceoryx)
@@ -2155,6 +2224,7 @@ static void writer_add_connection (struct writer *wr, struct proxy_reader *prd,
               PGUID (wr->e.guid), PGUID (prd->e.guid));
     ddsrt_mutex_unlock (&wr->e.lock);
     nn_lat_estim_fini (&m->hb_to_ack_latency);
+    ddsi_cfilter_free (m->cfilter);
     ddsrt_free (m);
   }
   else
@@ -2165,7 +2235,8 @@ static void writer_add_connection (struct writer *wr, struct proxy_reader *prd,
     wr->num_readers++;
     wr->num_reliable_readers += m->is_reliable;
     wr->num_readers_requesting_keyhash += prd->requests_keyhash ? 1 : 0;
-    rebuild_writer_addrset (wr);
+    wr->num_filtered_readers += (m->cfilter != NULL);
+    update_writer_addrset (wr, prd, true, m->cfilter != NULL);
     ddsrt_mutex_unlock (&wr->e.lock);
 
     if (wr->status_cb)
@@ -3078,27 +3149,22 @@ static void generic_do_match (struct entity_common *e, ddsrt_mtime_t tnow, bool
   else if (!local)
   {
     /* Built-ins have fixed QoS and a known entity id to use, so instead of
-       looking for the right topic, just probe the matching GUIDs for all
-       (proxy) participants.  Local matching never needs to look at the
-       discovery endpoints */
+       looking for the right topic, just enumerate the (proxy) endpoints with
+       the matching entity id, which only visits the (proxy) participants
+       that actually have the counterpart.  Local matching never needs to
+       look at the discovery endpoints */
     const ddsi_entityid_t tgt_ent = builtin_entityid_match (e->guid.entityid);
-    const bool isproxy = (e->kind == EK_PROXY_WRITER || e->kind == EK_PROXY_READER || e->kind == EK_PROXY_PARTICIPANT);
-    enum entity_kind pkind = isproxy ? EK_PARTICIPANT : EK_PROXY_PARTICIPANT;
-    EELOGDISC (e, "match_%s_with_%ss(%s "PGUIDFMT") scanning %sparticipants tgt=%"PRIx32"\n",
+    EELOGDISC (e, "match_%s_with_%ss(%s "PGUIDFMT") scanning %ss tgt=%"PRIx32"\n",
                kindstr[e->kind].full_us, kindstr[mkind].full_us,
                kindstr[e->kind].abbrev, PGUID (e->guid),
-               isproxy ? "" : "proxy ", tgt_ent.u);
+               kindstr[mkind].abbrev, tgt_ent.u);
     if (tgt_ent.u != NN_ENTITYID_UNKNOWN)
     {
-      entidx_enum_init (&it, entidx, pkind);
-      while ((em = entidx_enum_next (&it)) != NULL)
-      {
-        const ddsi_guid_t tgt_guid = { em->guid.prefix, tgt_ent };
-        struct entity_common *ep;
-        if ((ep = entidx_lookup_guid (entidx, &tgt_guid, mkind)) != NULL)
-          generic_do_match_connect (e, ep, tnow, local);
-      }
-      entidx_enum_fini (&it);
+      struct entidx_enum_builtin itb;
+      entidx_enum_builtin_init (&itb, entidx, mkind, tgt_ent);
+      while ((em = entidx_enum_builtin_next (&itb)) != NULL)
+        generic_do_match_connect (e, em, tnow, local);
+      entidx_enum_builtin_fini (&itb);
     }
   }
 }
@@ -3659,6 +3725,7 @@ static void new_writer_guid_common_init (struct writer *wr, const char *topic_na
   wr->num_readers = 0;
   wr->num_reliable_readers = 0;
   wr->num_readers_requesting_keyhash = 0;
+  wr->num_filtered_readers = 0;
   wr->num_acks_received = 0;
   wr->num_nacks_received = 0;
   wr->throttle_count = 0;
@@ -3720,6 +3787,7 @@ static void new_writer_guid_common_init (struct writer *wr, const char *topic_na
   wr->type = ddsi_sertype_ref (type);
   wr->as = new_addrset ();
   wr->as_group = NULL;
+  wr->as_state = NULL;
 
 #ifdef DDS_HAS_NETWORK_PARTITIONS
   /* This is an open issue how to encrypt mesages send for various
@@ -4035,6 +4103,7 @@ static void gc_delete_writer (struct gcreq *gcreq)
   if (wr->ssm_as)
     unref_addrset (wr->ssm_as);
 #endif
+  writer_addrset_state_free (wr);
   unref_addrset (wr->as); /* must remain until readers gone (rebuilding of addrset) */
   ddsi_xqos_fini (wr->xqos);
   ddsrt_free (wr->xqos);
@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <inttypes.h>
 
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/log.h"
@@ -26,37 +27,68 @@
 #include "dds/ddsi/ddsi_domaingv.h" /* for mattr, cattr */
 #include "dds/ddsi/q_receive.h" /* for trigger_receive_threads */
 
+/* Requests are reclaimed in batches, one batch per epoch.  Enqueueing a
+   request appends it to the list for the current epoch; the gc thread
+   closes the epoch by taking that entire list and then takes a single
+   snapshot of the virtual clocks of the threads awake in this domain.
+   Every thread announces its progress by advancing its vtime on each
+   sleep/wake transition, so once all threads in the snapshot have advanced
+   none of them can still hold a reference to anything unpublished before
+   the epoch was closed and all callbacks in the batch can be invoked.
+   Requests (re)queued in the meantime end up in the next epoch.
+
+   Compared to snapshotting all threads for every individual request, this
+   makes creating a request independent of the number of threads and means
+   the gc thread waits for (at most) one grace period per batch instead of
+   one per request. */
 struct gcreq_queue {
-  struct gcreq *first;
+  struct gcreq *first; /* requests enqueued in the current epoch */
   struct gcreq *last;
   ddsrt_mutex_t lock;
   ddsrt_cond_t cond;
   int terminate;
   int32_t count;
+  uint32_t epoch;
   struct ddsi_domaingv *gv;
   struct thread_state1 *ts;
 };
 
-static void threads_vtime_gather_for_wait (const struct ddsi_domaingv *gv, uint32_t *nivs, struct idx_vtime *ivs)
+struct idx_vtime {
+  struct thread_state1 *thrst;
+  vtime_t vtime;
+};
+
+static void threads_vtime_gather_for_wait (const struct ddsi_domaingv *gv, uint32_t *nivs, uint32_t *sizeivs, struct idx_vtime **ivs)
 {
   /* copy vtimes of threads, skipping those that are sleeping */
-  uint32_t i, j;
-  for (i = j = 0; i < thread_states.nthreads; i++)
+  uint32_t j = 0;
+  for (struct thread_states_list *cur = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head); cur; cur = cur->next)
   {
-    vtime_t vtime = ddsrt_atomic_ld32 (&thread_states.ts[i].vtime);
-    if (vtime_awake_p (vtime))
+    uint32_t active = ddsrt_atomic_ld32 (&cur->active);
+    for (uint32_t i = 0; active; i++, active >>= 1)
     {
-      ddsrt_atomic_fence_ldld ();
-      /* ts[i].gv is set before ts[i].vtime indicates the thread is awake, so if the thread hasn't
-         gone through another sleep/wake cycle since loading ts[i].vtime, ts[i].gv is correct; if
-         instead it has gone through another cycle since loading ts[i].vtime, then the thread will
-         be dropped from the live threads on the next check.  So it won't ever wait with unknown
-         duration for progres of threads stuck in another domain */
-      if (gv == ddsrt_atomic_ldvoidp (&thread_states.ts[i].gv))
+      if (!(active & 1))
+        continue;
+      vtime_t vtime = ddsrt_atomic_ld32 (&cur->thrst[i].vtime);
+      if (vtime_awake_p (vtime))
       {
-        ivs[j].idx = i;
-        ivs[j].vtime = vtime;
-        ++j;
+        ddsrt_atomic_fence_ldld ();
+        /* thrst[i].gv is set before thrst[i].vtime indicates the thread is awake, so if the thread hasn't
+           gone through another sleep/wake cycle since loading thrst[i].vtime, thrst[i].gv is correct; if
+           instead it has gone through another cycle since loading thrst[i].vtime, then the thread will
+           be dropped from the live threads on the next check.  So it won't ever wait with unknown
+           duration for progres of threads stuck in another domain */
+        if (gv == ddsrt_atomic_ldvoidp (&cur->thrst[i].gv))
+        {
+          if (j == *sizeivs)
+          {
+            *sizeivs = (*sizeivs == 0) ? THREAD_STATE_BATCH : 2 * *sizeivs;
+            *ivs = ddsrt_realloc (*ivs, *sizeivs * sizeof (**ivs));
+          }
+          (*ivs)[j].thrst = &cur->thrst[i];
+          (*ivs)[j].vtime = vtime;
+          ++j;
+        }
       }
     }
   }
@@ -70,10 +102,10 @@ static int threads_vtime_check (const struct ddsi_domaingv *gv, uint32_t *nivs,
   uint32_t i = 0;
   while (i < *nivs)
   {
-    uint32_t thridx = ivs[i].idx;
-    vtime_t vtime = ddsrt_atomic_ld32 (&thread_states.ts[thridx].vtime);
+    struct thread_state1 * const thrst = ivs[i].thrst;
+    vtime_t vtime = ddsrt_atomic_ld32 (&thrst->vtime);
     assert (vtime_awake_p (ivs[i].vtime));
-    if (!vtime_gt (vtime, ivs[i].vtime) && ddsrt_atomic_ldvoidp (&thread_states.ts[thridx].gv) == gv)
+    if (!vtime_gt (vtime, ivs[i].vtime) && ddsrt_atomic_ldvoidp (&thrst->gv) == gv)
       ++i;
     else
     {
@@ -92,7 +124,10 @@ static uint32_t gcreq_queue_thread (struct gcreq_queue *q)
   ddsrt_mtime_t t_trigger_recv_threads = { 0 };
   int64_t shortsleep = DDS_MSECS (1);
   int64_t delay = DDS_MSECS (1); /* force evaluation after startup */
-  struct gcreq *gcreq = NULL;
+  struct gcreq *batch = NULL;
+  uint32_t batch_epoch = 0;
+  struct idx_vtime *ivs = NULL;
+  uint32_t nivs = 0, sizeivs = 0;
   int trace_shortsleep = 1;
   ddsrt_mutex_lock (&q->lock);
   while (!(q->terminate && q->count == 0))
@@ -112,11 +147,12 @@ static uint32_t gcreq_queue_thread (struct gcreq_queue *q)
       }
     }
 
-    /* If we are waiting for a gcreq to become ready, don't bother
+    /* If we are waiting for a batch to become ready, don't bother
        looking at the queue; if we aren't, wait for a request to come
        in.  We can't really wait until something came in because we're
        also checking lease expirations. */
-    if (gcreq == NULL)
+    bool new_batch = false;
+    if (batch == NULL)
     {
       assert (trace_shortsleep);
       if (q->first == NULL)
@@ -134,12 +170,21 @@ static uint32_t gcreq_queue_thread (struct gcreq_queue *q)
       }
       if (q->first)
       {
-        gcreq = q->first;
-        q->first = q->first->next;
+        /* Close the current epoch: everything enqueued so far forms the
+           batch, anything enqueued from now on goes into the next one */
+        batch = q->first;
+        q->first = q->last = NULL;
+        batch_epoch = q->epoch++;
+        new_batch = true;
       }
     }
     ddsrt_mutex_unlock (&q->lock);
 
+    /* All requests in the batch were enqueued before this snapshot was
+       taken, hence after whatever they protect was made unreachable */
+    if (new_batch)
+      threads_vtime_gather_for_wait (q->gv, &nivs, &sizeivs, &ivs);
+
     /* Cleanup dead proxy entities. One can argue this should be an
        independent thread, but one can also easily argue that an
        expired lease is just another form of a request for
@@ -151,18 +196,18 @@ static uint32_t gcreq_queue_thread (struct gcreq_queue *q)
     delay = check_and_handle_lease_expiration (q->gv, ddsrt_time_elapsed ());
     thread_state_asleep (ts1);
 
-    if (gcreq)
+    if (batch)
     {
-      if (!threads_vtime_check (q->gv, &gcreq->nvtimes, gcreq->vtimes))
+      if (!threads_vtime_check (q->gv, &nivs, ivs))
       {
-        /* Not all threads made enough progress => gcreq is not ready
+        /* Not all threads made enough progress => batch is not ready
            yet => sleep for a bit and retry.  Note that we can't even
-           terminate while this gcreq is waiting and that there is no
+           terminate while this batch is waiting and that there is no
            condition on which to wait, so a plain sleep is quite
            reasonable. */
         if (trace_shortsleep)
         {
-          DDS_CTRACE (&q->gv->logconfig, "gc %p: not yet, shortsleep\n", (void *) gcreq);
+          DDS_CTRACE (&q->gv->logconfig, "gc epoch %"PRIu32": not yet, shortsleep\n", batch_epoch);
           trace_shortsleep = 0;
         }
         dds_sleepfor (shortsleep);
@@ -170,14 +215,19 @@ static uint32_t gcreq_queue_thread (struct gcreq_queue *q)
       else
       {
         /* Sufficient progress has been made: may now continue deleting
-           it; the callback is responsible for requeueing (if complex
-           multi-phase delete) or freeing the delete request.  Reset
-           the current gcreq as this one obviously is no more.  */
-        DDS_CTRACE (&q->gv->logconfig, "gc %p: deleting\n", (void *) gcreq);
-        thread_state_awake_fixed_domain (ts1);
-        gcreq->cb (gcreq);
-        thread_state_asleep (ts1);
-        gcreq = NULL;
+           everything in the batch; the callbacks are responsible for
+           requeueing (if complex multi-phase delete) or freeing the
+           delete requests, so the link to the next one must be read
+           first.  Requeued requests go into a later epoch. */
+        DDS_CTRACE (&q->gv->logconfig, "gc epoch %"PRIu32": deleting\n", batch_epoch);
+        while (batch)
+        {
+          struct gcreq *gcreq = batch;
+          batch = gcreq->next;
+          thread_state_awake_fixed_domain (ts1);
+          gcreq->cb (gcreq);
+          thread_state_asleep (ts1);
+        }
         trace_shortsleep = 1;
       }
     }
@@ -185,6 +235,7 @@ static uint32_t gcreq_queue_thread (struct gcreq_queue *q)
     ddsrt_mutex_lock (&q->lock);
   }
   ddsrt_mutex_unlock (&q->lock);
+  ddsrt_free (ivs);
   return 0;
 }
 
@@ -195,6 +246,7 @@ struct gcreq_queue *gcreq_queue_new (struct ddsi_domaingv *gv)
   q->first = q->last = NULL;
   q->terminate = 0;
   q->count = 0;
+  q->epoch = 0;
   q->gv = gv;
   ddsrt_mutex_init (&q->lock);
   ddsrt_cond_init (&q->cond);
@@ -219,27 +271,17 @@ void gcreq_queue_drain (struct gcreq_queue *q)
 
 void gcreq_queue_free (struct gcreq_queue *q)
 {
-  struct gcreq *gcreq;
-
-  /* Create a no-op not dependent on any thread */
-  gcreq = gcreq_new (q, gcreq_free);
-  gcreq->nvtimes = 0;
-
+  /* Wait until all requests have been processed, then the gc system
+     is quiet.  The gc thread terminates once it observes the terminate
+     flag with no requests outstanding; the broadcast forces it to wake
+     up if it is waiting for requests to come in. */
   ddsrt_mutex_lock (&q->lock);
   q->terminate = 1;
-  /* Wait until there is only request in existence, the one we just
-     allocated (this is also why we can't use "drain" here). Then
-     we know the gc system is quiet. */
-  while (q->count != 1)
+  ddsrt_cond_broadcast (&q->cond);
+  while (q->count != 0)
     ddsrt_cond_wait (&q->cond, &q->lock);
   ddsrt_mutex_unlock (&q->lock);
 
-  /* Force the gc thread to wake up by enqueueing our no-op. The
-     callback, gcreq_free, will be called immediately, which causes
-     q->count to 0 before the loop condition is evaluated again, at
-     which point the thread terminates. */
-  gcreq_enqueue (gcreq);
-
   join_thread (q->ts);
   assert (q->first == NULL);
   ddsrt_cond_destroy (&q->cond);
@@ -250,10 +292,9 @@ void gcreq_queue_free (struct gcreq_queue *q)
 struct gcreq *gcreq_new (struct gcreq_queue *q, gcreq_cb_t cb)
 {
   struct gcreq *gcreq;
-  gcreq = ddsrt_malloc (offsetof (struct gcreq, vtimes) + thread_states.nthreads * sizeof (*gcreq->vtimes));
+  gcreq = ddsrt_malloc (sizeof (*gcreq));
   gcreq->cb = cb;
   gcreq->queue = q;
-  threads_vtime_gather_for_wait (q->gv, &gcreq->nvtimes, gcreq->vtimes);
   ddsrt_mutex_lock (&q->lock);
   q->count++;
   ddsrt_mutex_unlock (&q->lock);
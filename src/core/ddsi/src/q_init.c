@@ -20,6 +20,7 @@
 #include "dds/ddsrt/sync.h"
 
 #include "dds/ddsrt/avl.h"
+#include "dds/ddsrt/bintrace.h"
 
 #include "dds/ddsi/q_protocol.h"
 #include "dds/ddsi/q_rtps.h"
@@ -66,6 +67,7 @@
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds__whc.h"
 #include "dds/ddsi/ddsi_iid.h"
+#include "dds/ddsi/ddsi_wraddrset.h"
 
 #include "dds/ddsi/ddsi_security_omg.h"
 
@@ -91,6 +93,83 @@ enum make_uc_sockets_ret {
   MUSRET_ERROR          /* generic error, no use continuing */
 };
 
+static bool use_multiple_receive_threads (const struct ddsi_config *cfg)
+{
+  /* Under some unknown circumstances Windows (at least Windows 10) exhibits
+     the interesting behaviour of losing its ability to let us send packets
+     to our own sockets. When that happens, dedicated receive threads can no
+     longer be stopped and Cyclone hangs in shutdown.  So until someone
+     figures out why this happens, it is probably best have a different
+     default on Windows. */
+#if _WIN32
+  const bool def = false;
+#else
+  const bool def = true;
+#endif
+  switch (cfg->multiple_recv_threads)
+  {
+    case DDSI_BOOLDEF_FALSE:
+      return false;
+    case DDSI_BOOLDEF_TRUE:
+      return true;
+    case DDSI_BOOLDEF_DEFAULT:
+      return def;
+  }
+  assert (0);
+  return false;
+}
+
+static uint32_t get_recv_shards (struct ddsi_domaingv *gv)
+{
+  DDSRT_STATIC_ASSERT (MAX_RECV_SHARDS == DDSI_TRAN_RECV_SHARDS_MAX);
+  if (gv->config.recv_shards <= 1)
+    return 1;
+  else if ((gv->config.transport_selector != DDSI_TRANS_UDP && gv->config.transport_selector != DDSI_TRANS_UDP6) ||
+           gv->config.many_sockets_mode != DDSI_MSM_SINGLE_UNICAST ||
+           !use_multiple_receive_threads (&gv->config))
+  {
+    GVWARNING ("Internal/UnicastReceiveShards ignored: requires UDP, ManySocketsMode single and multiple receive threads\n");
+    return 1;
+  }
+  return gv->config.recv_shards;
+}
+
+static dds_return_t make_uc_data_shards (struct ddsi_domaingv *gv, uint32_t port, uint32_t nshards)
+{
+  /* data_conn_uc was created with an exclusive bind, so we know no-one else
+     is using the port; replace it with sockets that share the port, stopping
+     at the first failure because the steering program indexes them by the
+     order in which they were bound */
+  const ddsi_tran_qos_t qos = { .m_purpose = DDSI_TRAN_QOS_RECV_UC_SHARD, .m_diffserv = 0, .m_interface = NULL, .m_nshards = nshards };
+  dds_return_t rc = DDS_RETCODE_OK;
+  uint32_t i;
+  ddsi_conn_free (gv->data_conn_uc);
+  gv->data_conn_uc = NULL;
+  for (i = 0; i < nshards; i++)
+  {
+    if ((rc = ddsi_factory_create_conn (&gv->data_conn_uc_shards[i], gv->m_factory, port, &qos)) != DDS_RETCODE_OK)
+      break;
+  }
+  if (rc == DDS_RETCODE_OK)
+  {
+    gv->data_conn_uc = gv->data_conn_uc_shards[0];
+    gv->n_recv_shards = nshards;
+    return DDS_RETCODE_OK;
+  }
+  while (i-- > 0)
+  {
+    ddsi_conn_free (gv->data_conn_uc_shards[i]);
+    gv->data_conn_uc_shards[i] = NULL;
+  }
+  if (rc == DDS_RETCODE_UNSUPPORTED)
+  {
+    GVWARNING ("Internal/UnicastReceiveShards ignored: not supported on this platform\n");
+    const ddsi_tran_qos_t qos_uc = { .m_purpose = DDSI_TRAN_QOS_RECV_UC, .m_diffserv = 0, .m_interface = NULL };
+    rc = ddsi_factory_create_conn (&gv->data_conn_uc, gv->m_factory, port, &qos_uc);
+  }
+  return rc;
+}
+
 static enum make_uc_sockets_ret make_uc_sockets (struct ddsi_domaingv *gv, uint32_t * pdisc, uint32_t * pdata, int ppid)
 {
   dds_return_t rc;
@@ -124,7 +203,11 @@ static enum make_uc_sockets_ret make_uc_sockets (struct ddsi_domaingv *gv, uint3
     rc = ddsi_factory_create_conn (&gv->data_conn_uc, gv->m_factory, *pdata, &qos);
     if (rc != DDS_RETCODE_OK)
       goto fail_data;
+    const uint32_t nshards = get_recv_shards (gv);
+    if (nshards > 1 && (rc = make_uc_data_shards (gv, *pdata, nshards)) != DDS_RETCODE_OK)
+      goto fail_data;
   }
+  gv->data_conn_uc_shards[0] = gv->data_conn_uc;
   ddsi_conn_locator (gv->disc_conn_uc, &gv->loc_meta_uc);
   ddsi_conn_locator (gv->data_conn_uc, &gv->loc_default_uc);
   return MUSRET_SUCCESS;
@@ -460,6 +543,12 @@ static int check_thread_properties (const struct ddsi_domaingv *gv)
         ok = 0;
       }
 #else
+      /* Additional user delivery queues are named dq.user1, dq.user2, ... */
+      unsigned long idx;
+      char *endp;
+      if (strncmp (e->name, "dq.user", 7) == 0 && e->name[7] >= '1' && e->name[7] <= '9' &&
+          (idx = strtoul (e->name + 7, &endp, 10)) < gv->config.delivery_queue_pool_size && *endp == 0)
+        continue;
       DDS_ILOG (DDS_LC_ERROR, gv->config.domainId, "config: DDSI2Service/Threads/Thread[@name=\"%s\"]: unknown thread\n", e->name);
       ok = 0;
 #endif /* DDS_HAS_NETWORK_CHANNELS */
@@ -471,6 +560,7 @@ static int check_thread_properties (const struct ddsi_domaingv *gv)
 int rtps_config_open_trace (struct ddsi_domaingv *gv)
 {
   DDSRT_WARNING_MSVC_OFF(4996);
+  const bool binary = (gv->config.trace_format == DDSI_TRACE_FORMAT_BINARY);
   int status;
 
   if (gv->config.tracefile == NULL || *gv->config.tracefile == 0 || gv->config.tracemask == 0)
@@ -479,6 +569,12 @@ int rtps_config_open_trace (struct ddsi_domaingv *gv)
     gv->config.tracefp = NULL;
     status = 1;
   }
+  else if (binary && (ddsrt_strcasecmp (gv->config.tracefile, "stdout") == 0 || ddsrt_strcasecmp (gv->config.tracefile, "stderr") == 0))
+  {
+    DDS_ILOG (DDS_LC_ERROR, gv->config.domainId, "%s: binary trace requires a file\n", gv->config.tracefile);
+    gv->config.tracefp = NULL;
+    status = 0;
+  }
   else if (ddsrt_strcasecmp (gv->config.tracefile, "stdout") == 0)
   {
     gv->config.tracefp = stdout;
@@ -489,7 +585,7 @@ int rtps_config_open_trace (struct ddsi_domaingv *gv)
     gv->config.tracefp = stderr;
     status = 1;
   }
-  else if ((gv->config.tracefp = fopen (gv->config.tracefile, gv->config.tracingAppendToFile ? "a" : "w")) == NULL)
+  else if ((gv->config.tracefp = fopen (gv->config.tracefile, binary ? (gv->config.tracingAppendToFile ? "ab" : "wb") : (gv->config.tracingAppendToFile ? "a" : "w"))) == NULL)
   {
     DDS_ILOG (DDS_LC_ERROR, gv->config.domainId, "%s: cannot open for writing\n", gv->config.tracefile);
     status = 0;
@@ -500,10 +596,33 @@ int rtps_config_open_trace (struct ddsi_domaingv *gv)
   }
 
   dds_log_cfg_init (&gv->logconfig, gv->config.domainId, gv->config.tracemask, stderr, gv->config.tracefp);
+  if (status && binary && gv->config.tracefp)
+  {
+    if ((gv->config.tracebin = ddsrt_bintrace_new (gv->config.tracefp, gv->config.domainId, gv->config.trace_binary_buffer_size)) != NULL)
+      dds_log_cfg_set_bintrace (&gv->logconfig, gv->config.tracebin);
+    else
+    {
+      DDS_ILOG (DDS_LC_ERROR, gv->config.domainId, "%s: failed to initialize binary trace\n", gv->config.tracefile);
+      status = 0;
+    }
+  }
   return status;
   DDSRT_WARNING_MSVC_ON(4996);
 }
 
+void rtps_config_close_bintrace (struct ddsi_domaingv *gv)
+{
+  /* Not left to config_fini because there is no cfgst for a raw configuration,
+     and the flusher thread must be gone once the domain has been deleted.  The
+     trace file itself is still closed by config_fini. */
+  if (gv->config.tracebin)
+  {
+    dds_log_cfg_set_bintrace (&gv->logconfig, NULL);
+    ddsrt_bintrace_free (gv->config.tracebin);
+    gv->config.tracebin = NULL;
+  }
+}
+
 int rtps_config_prep (struct ddsi_domaingv *gv, struct cfgst *cfgst)
 {
 #ifdef DDS_HAS_NETWORK_CHANNELS
@@ -928,32 +1047,6 @@ static void make_special_types (struct ddsi_domaingv *gv)
   free_special_types (gv);
 }
 
-static bool use_multiple_receive_threads (const struct ddsi_config *cfg)
-{
-  /* Under some unknown circumstances Windows (at least Windows 10) exhibits
-     the interesting behaviour of losing its ability to let us send packets
-     to our own sockets. When that happens, dedicated receive threads can no
-     longer be stopped and Cyclone hangs in shutdown.  So until someone
-     figures out why this happens, it is probably best have a different
-     default on Windows. */
-#if _WIN32
-  const bool def = false;
-#else
-  const bool def = true;
-#endif
-  switch (cfg->multiple_recv_threads)
-  {
-    case DDSI_BOOLDEF_FALSE:
-      return false;
-    case DDSI_BOOLDEF_TRUE:
-      return true;
-    case DDSI_BOOLDEF_DEFAULT:
-      return def;
-  }
-  assert (0);
-  return false;
-}
-
 static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
 {
   const bool multi_recv_thr = use_multiple_receive_threads (&gv->config);
@@ -966,6 +1059,7 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
     gv->recv_threads[i].arg.gv = gv;
     gv->recv_threads[i].arg.u.single.loc = NULL;
     gv->recv_threads[i].arg.u.single.conn = NULL;
+    gv->recv_threads[i].arg.u.single.shard = 0;
   }
 
   /* First thread always uses a waitset and gobbles up all sockets not handled by dedicated threads - FIXME: DDSI_MSM_NO_UNICAST mode with UDP probably doesn't even need this one to use a waitset */
@@ -993,6 +1087,18 @@ static int setup_and_start_recv_threads (struct ddsi_domaingv *gv)
       gv->recv_threads[gv->n_recv_threads].arg.u.single.loc = &gv->loc_default_uc;
       ddsi_conn_disable_multiplexing (gv->data_conn_uc);
       gv->n_recv_threads++;
+      /* Additional sockets sharing the unicast data port get a thread each */
+      static const char *shard_names[MAX_RECV_SHARDS] = { "recvUC", "recvUC1", "recvUC2", "recvUC3", "recvUC4", "recvUC5", "recvUC6", "recvUC7" };
+      for (uint32_t k = 1; k < gv->n_recv_shards; k++)
+      {
+        gv->recv_threads[gv->n_recv_threads].name = shard_names[k];
+        gv->recv_threads[gv->n_recv_threads].arg.mode = RTM_SINGLE;
+        gv->recv_threads[gv->n_recv_threads].arg.u.single.conn = gv->data_conn_uc_shards[k];
+        gv->recv_threads[gv->n_recv_threads].arg.u.single.loc = &gv->loc_default_uc;
+        gv->recv_threads[gv->n_recv_threads].arg.u.single.shard = k;
+        ddsi_conn_disable_multiplexing (gv->data_conn_uc_shards[k]);
+        gv->n_recv_threads++;
+      }
     }
   }
   assert (gv->n_recv_threads <= MAX_RECV_THREADS);
@@ -1097,9 +1203,11 @@ static void free_conns (struct ddsi_domaingv *gv)
 {
   // Depending on settings, various "conn"s can alias others, this makes sure we free each one only once
   // FIXME: perhaps store them in a table instead?
-  ddsi_tran_conn_t cs[4 + MAX_XMIT_CONNS] = { gv->disc_conn_mc, gv->data_conn_mc, gv->disc_conn_uc, gv->data_conn_uc };
+  ddsi_tran_conn_t cs[4 + MAX_XMIT_CONNS + MAX_RECV_SHARDS] = { gv->disc_conn_mc, gv->data_conn_mc, gv->disc_conn_uc, gv->data_conn_uc };
   for (size_t i = 0; i < MAX_XMIT_CONNS; i++)
     cs[4 + i] = gv->xmit_conns[i];
+  for (size_t i = 0; i < MAX_RECV_SHARDS; i++)
+    cs[4 + MAX_XMIT_CONNS + i] = gv->data_conn_uc_shards[i];
   for (size_t i = 0; i < sizeof (cs) / sizeof (cs[0]); i++)
   {
     if (cs[i] == NULL)
@@ -1326,6 +1434,9 @@ int rtps_init (struct ddsi_domaingv *gv)
 
   gv->disc_conn_uc = NULL;
   gv->data_conn_uc = NULL;
+  gv->n_recv_shards = 1;
+  for (size_t i = 0; i < MAX_RECV_SHARDS; i++)
+    gv->data_conn_uc_shards[i] = NULL;
   gv->disc_conn_mc = NULL;
   gv->data_conn_mc = NULL;
   for (size_t i = 0; i < MAX_XMIT_CONNS; i++)
@@ -1501,6 +1612,7 @@ int rtps_init (struct ddsi_domaingv *gv)
 
   ddsrt_mutex_init (&gv->sertypes_lock);
   gv->sertypes = ddsrt_hh_new (1, ddsi_sertype_hash_wrap, ddsi_sertype_equal_wrap);
+  wraddrset_cache_init (gv);
 
 #ifdef DDS_HAS_TYPE_DISCOVERY
   ddsrt_mutex_init (&gv->tl_admin_lock);
@@ -1842,13 +1954,26 @@ int rtps_init (struct ddsi_domaingv *gv)
   // sendq thread is started if a DW is created with non-zero latency
   gv->sendq_running = false;
   ddsrt_mutex_init (&gv->sendq_running_lock);
+  ddsrt_atomic_st64 (&gv->xmit_batch_calls, 0);
+  ddsrt_atomic_st64 (&gv->xmit_batch_msgs, 0);
+  ddsrt_atomic_st32 (&gv->rbuf_ref_pinned, 0);
 
   gv->builtins_dqueue = nn_dqueue_new ("builtins", gv, gv->config.delivery_queue_maxsamples, builtins_dqueue_handler, NULL);
 #ifdef DDS_HAS_NETWORK_CHANNELS
   for (struct ddsi_config_channel_listelem *chptr = gv->config.channels; chptr; chptr = chptr->next)
     chptr->dqueue = nn_dqueue_new (chptr->name, &gv->config, gv->config.delivery_queue_maxsamples, user_dqueue_handler, NULL);
 #else
-  gv->user_dqueue = nn_dqueue_new ("user", gv, gv->config.delivery_queue_maxsamples, user_dqueue_handler, NULL);
+  gv->n_user_dqueues = gv->config.delivery_queue_pool_size;
+  gv->user_dqueues = ddsrt_malloc (gv->n_user_dqueues * sizeof (*gv->user_dqueues));
+  for (uint32_t i = 0; i < gv->n_user_dqueues; i++)
+  {
+    char name[16];
+    if (i == 0)
+      (void) snprintf (name, sizeof (name), "user");
+    else
+      (void) snprintf (name, sizeof (name), "user%"PRIu32, i);
+    gv->user_dqueues[i] = nn_dqueue_new (name, gv, gv->config.delivery_queue_maxsamples, user_dqueue_handler, NULL);
+  }
 #endif
 
   if (reset_deaf_mute_time.v < DDS_NEVER)
@@ -1897,6 +2022,7 @@ err_unicast_sockets:
 #endif
   ddsrt_hh_free (gv->sertypes);
   ddsrt_mutex_destroy (&gv->sertypes_lock);
+  wraddrset_cache_fini (gv);
 #ifdef DDS_HAS_TOPIC_DISCOVERY
   ddsrt_hh_free (gv->topic_defs);
   ddsrt_mutex_destroy (&gv->topic_defs_lock);
@@ -2190,7 +2316,9 @@ void rtps_fini (struct ddsi_domaingv *gv)
     chptr = chptr->next;
   }
 #else
-  nn_dqueue_free (gv->user_dqueue);
+  for (uint32_t i = 0; i < gv->n_user_dqueues; i++)
+    nn_dqueue_free (gv->user_dqueues[i]);
+  ddsrt_free (gv->user_dqueues);
 #endif
 
 #ifdef DDS_HAS_SECURITY
@@ -2282,6 +2410,7 @@ void rtps_fini (struct ddsi_domaingv *gv)
 #endif
   ddsrt_hh_free (gv->sertypes);
   ddsrt_mutex_destroy (&gv->sertypes_lock);
+  wraddrset_cache_fini (gv);
 #ifdef DDS_HAS_TYPE_DISCOVERY
 #ifndef NDEBUG
   {
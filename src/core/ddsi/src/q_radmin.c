@@ -196,6 +196,14 @@
    simply discards it and new() returns the same address next time
    round.
 
+   A transport that can receive multiple packets in a single call can
+   use new_batch(rbpool, n) to get n consecutive rmsgs, each large
+   enough for a maximum-size message, read the packets into those and
+   then process and commit them one by one in order, followed by
+   end_batch().  Memory in slots that have not been committed yet is
+   reserved, any allocation that doesn't fit in the free space before
+   the first reserved slot ends up in a new rbuf.
+
    Processing of a single message in process() is roughly as follows:
 
      for rdata in each Data/DataFrag submessage in rmsg
@@ -284,6 +292,18 @@ struct nn_rbufpool {
   struct nn_rbuf *current;
   uint32_t rbuf_size;
   uint32_t max_rmsg_size;
+
+  /* A batch of rmsgs allocated by nn_rmsg_new_batch occupies
+     consecutive slots of batch_stride bytes in batch_rbuf, starting at
+     batch_start.  The memory in [batch_limit, batch_end) is reserved
+     for slots that have not been committed yet and must not be
+     handed out by rbuf_alloc.  batch_rbuf is NULL if no batch is in
+     progress. */
+  struct nn_rbuf *batch_rbuf;
+  unsigned char *batch_start;
+  unsigned char *batch_limit;
+  unsigned char *batch_end;
+  uint32_t batch_stride;
   const struct ddsrt_log_cfg *logcfg;
   bool trace;
 #ifndef NDEBUG
@@ -359,6 +379,9 @@ struct nn_rbufpool *nn_rbufpool_new (const struct ddsrt_log_cfg *logcfg, uint32_
 
   rbp->rbuf_size = rbuf_size;
   rbp->max_rmsg_size = max_rmsg_size;
+  rbp->batch_rbuf = NULL;
+  rbp->batch_start = rbp->batch_limit = rbp->batch_end = NULL;
+  rbp->batch_stride = 0;
   rbp->logcfg = logcfg;
   rbp->trace = (logcfg->c.mask & DDS_LC_RADMIN) != 0;
 
@@ -408,6 +431,7 @@ void nn_rbufpool_free (struct nn_rbufpool *rbp)
 
 struct nn_rbuf {
   ddsrt_atomic_uint32_t n_live_rmsg_chunks;
+  ddsrt_atomic_uint32_t n_pins; /* see nn_rmsg_pin */
   uint32_t size;
   uint32_t max_rmsg_size;
   struct nn_rbufpool *rbufpool;
@@ -443,6 +467,7 @@ static struct nn_rbuf *nn_rbuf_alloc_new (struct nn_rbufpool *rbp)
 
   rb->rbufpool = rbp;
   ddsrt_atomic_st32 (&rb->n_live_rmsg_chunks, 1);
+  ddsrt_atomic_st32 (&rb->n_pins, 0);
   rb->size = rbp->rbuf_size;
   rb->max_rmsg_size = rbp->max_rmsg_size;
   rb->freeptr = rb->raw;
@@ -506,9 +531,11 @@ static void *nn_rbuf_alloc (struct nn_rbufpool *rbp)
   assert (rb->freeptr >= rb->raw);
   assert (rb->freeptr <= rb->raw + rb->size);
 
-  if ((uint32_t) (rb->raw + rb->size - rb->freeptr) < asize)
+  if ((uint32_t) (rb->raw + rb->size - rb->freeptr) < asize ||
+      (rb == rbp->batch_rbuf && rb->freeptr + asize > rbp->batch_limit))
   {
-    /* not enough space left for new rmsg */
+    /* not enough space left for new rmsg, or the space is reserved for
+       the remainder of a batch */
     if ((rb = nn_rbuf_new (rbp)) == NULL)
       return NULL;
 
@@ -531,6 +558,16 @@ static void init_rmsg_chunk (struct nn_rmsg_chunk *chunk, struct nn_rbuf *rbuf)
   ddsrt_atomic_inc32 (&rbuf->n_live_rmsg_chunks);
 }
 
+static void init_rmsg (struct nn_rbufpool *rbp, struct nn_rmsg *rmsg, struct nn_rbuf *rbuf)
+{
+  /* Reference to this rmsg, undone by rmsg_commit(). */
+  ddsrt_atomic_st32 (&rmsg->refcount, RMSG_REFCOUNT_UNCOMMITTED_BIAS);
+  /* Initial chunk */
+  init_rmsg_chunk (&rmsg->chunk, rbuf);
+  rmsg->trace = rbp->trace;
+  rmsg->lastchunk = &rmsg->chunk;
+}
+
 struct nn_rmsg *nn_rmsg_new (struct nn_rbufpool *rbp)
 {
   /* Note: only one thread calls nn_rmsg_new on a pool */
@@ -540,19 +577,79 @@ struct nn_rmsg *nn_rmsg_new (struct nn_rbufpool *rbp)
   rmsg = nn_rbuf_alloc (rbp);
   if (rmsg == NULL)
     return NULL;
-
-  /* Reference to this rmsg, undone by rmsg_commit(). */
-  ddsrt_atomic_st32 (&rmsg->refcount, RMSG_REFCOUNT_UNCOMMITTED_BIAS);
-  /* Initial chunk */
-  init_rmsg_chunk (&rmsg->chunk, rbp->current);
-  rmsg->trace = rbp->trace;
-  rmsg->lastchunk = &rmsg->chunk;
+  init_rmsg (rbp, rmsg, rbp->current);
   /* Incrementing freeptr happens in commit(), so that discarding the
      message is really simple. */
   RBPTRACE ("rmsg_new(%p) = %p\n", (void *) rbp, (void *) rmsg);
   return rmsg;
 }
 
+uint32_t nn_rmsg_new_batch (struct nn_rbufpool *rbp, uint32_t n, struct nn_rmsg **rmsgs)
+{
+  /* Note: only one thread calls nn_rmsg_new_batch on a pool
+
+     The rmsgs are laid out consecutively in the current rbuf, each
+     with room for a maximum-size message, and so the number of rmsgs
+     in a batch is limited by what fits in a single rbuf. */
+  const uint32_t asize = max_rmsg_size_w_hdr (rbp->max_rmsg_size);
+  const uint32_t stride = align_rmsg (asize);
+  const uint32_t nmax = (rbp->rbuf_size - asize) / stride + 1;
+  struct nn_rbuf *rb;
+  RBPTRACE ("rmsg_new_batch(%p, %"PRIu32")\n", (void *) rbp, n);
+  ASSERT_RBUFPOOL_OWNER (rbp);
+  assert (rbp->batch_rbuf == NULL);
+  assert (n > 0);
+  if (n > nmax)
+    n = nmax;
+
+  rb = rbp->current;
+  if ((uint32_t) (rb->raw + rb->size - rb->freeptr) < (n - 1) * stride + asize)
+  {
+    if ((rb = nn_rbuf_new (rbp)) == NULL)
+      return 0;
+    assert ((uint32_t) (rb->raw + rb->size - rb->freeptr) >= (n - 1) * stride + asize);
+  }
+
+  rbp->batch_rbuf = rb;
+  rbp->batch_start = rbp->batch_limit = rb->freeptr;
+  rbp->batch_end = rb->freeptr + (n - 1) * stride + asize;
+  rbp->batch_stride = stride;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    rmsgs[i] = (struct nn_rmsg *) (rb->freeptr + i * stride);
+#if USE_VALGRIND
+    VALGRIND_MEMPOOL_ALLOC (rbp, rmsgs[i], asize);
+#endif
+    init_rmsg (rbp, rmsgs[i], rb);
+  }
+  RBPTRACE ("rmsg_new_batch(%p) = %"PRIu32" @ %p\n", (void *) rbp, n, (void *) rbp->batch_start);
+  return n;
+}
+
+void nn_rmsg_end_batch (struct nn_rbufpool *rbp)
+{
+  RBPTRACE ("rmsg_end_batch(%p)\n", (void *) rbp);
+  ASSERT_RBUFPOOL_OWNER (rbp);
+  assert (rbp->batch_rbuf != NULL);
+  rbp->batch_rbuf = NULL;
+  rbp->batch_start = rbp->batch_limit = rbp->batch_end = NULL;
+}
+
+static void batch_note_commit (struct nn_rbufpool *rbp, const struct nn_rmsg *rmsg)
+{
+  /* The rmsgs in a batch are committed in order, so once one is
+     committed, its slot is no longer reserved */
+  const unsigned char *p = (const unsigned char *) rmsg;
+  if (rmsg->chunk.rbuf == rbp->batch_rbuf && p >= rbp->batch_start && p < rbp->batch_end)
+  {
+    const size_t slot = (size_t) (p - rbp->batch_start) / rbp->batch_stride;
+    const size_t nslots = (size_t) (rbp->batch_end - rbp->batch_start + rbp->batch_stride - 1) / rbp->batch_stride;
+    unsigned char *next = (slot + 1 < nslots) ? rbp->batch_start + (slot + 1) * rbp->batch_stride : rbp->batch_end;
+    if (next > rbp->batch_limit)
+      rbp->batch_limit = next;
+  }
+}
+
 void nn_rmsg_setsize (struct nn_rmsg *rmsg, uint32_t size)
 {
   uint32_t size8P = align_rmsg (size);
@@ -626,7 +723,9 @@ void nn_rmsg_commit (struct nn_rmsg *rmsg)
   assert (ddsrt_atomic_ld32 (&rmsg->refcount) >= RMSG_REFCOUNT_UNCOMMITTED_BIAS);
   assert (ddsrt_atomic_ld32 (&rmsg->chunk.rbuf->n_live_rmsg_chunks) > 0);
   assert (ddsrt_atomic_ld32 (&chunk->rbuf->n_live_rmsg_chunks) > 0);
-  assert (chunk->rbuf->rbufpool->current == chunk->rbuf);
+  assert (chunk->rbuf->rbufpool->current == chunk->rbuf || chunk->rbuf->rbufpool->batch_rbuf == chunk->rbuf);
+  if (chunk->rbuf->rbufpool->batch_rbuf != NULL)
+    batch_note_commit (chunk->rbuf->rbufpool, rmsg);
   if (ddsrt_atomic_sub32_nv (&rmsg->refcount, RMSG_REFCOUNT_UNCOMMITTED_BIAS) == 0)
     nn_rmsg_free (rmsg);
   else
@@ -667,7 +766,17 @@ static void nn_rmsg_rmbias_and_adjust (struct nn_rmsg *rmsg, int adjust)
     nn_rmsg_free (rmsg);
 }
 
-static void nn_rmsg_unref (struct nn_rmsg *rmsg)
+void nn_rmsg_addref (struct nn_rmsg *rmsg)
+{
+  /* Note: any thread may add a reference, provided it already holds
+     one (e.g., via an rdata that has not been delivered yet) so the
+     reference count can't drop to 0 concurrently. */
+  RMSGTRACE ("rmsg_addref(%p)\n", (void *) rmsg);
+  assert (ddsrt_atomic_ld32 (&rmsg->refcount) > 0);
+  ddsrt_atomic_inc32 (&rmsg->refcount);
+}
+
+void nn_rmsg_unref (struct nn_rmsg *rmsg)
 {
   RMSGTRACE ("rmsg_unref(%p)\n", (void *) rmsg);
   assert (ddsrt_atomic_ld32 (&rmsg->refcount) > 0);
@@ -675,6 +784,52 @@ static void nn_rmsg_unref (struct nn_rmsg *rmsg)
     nn_rmsg_free (rmsg);
 }
 
+bool nn_rmsg_pin (struct nn_rmsg *rmsg, ddsrt_atomic_uint32_t *pinned, uint32_t max)
+{
+  /* Like addref, but for a reference that may be held for a long time,
+     keeping the entire rbuf containing the message alive.  The first pin
+     on an rbuf charges its size to *pinned, the last unpin refunds it.
+     An unpin racing with a pin may cause the rbuf to be charged twice
+     for a little while, but never not at all. */
+  struct nn_rbuf * const rbuf = rmsg->chunk.rbuf;
+  uint32_t n;
+  RMSGTRACE ("rmsg_pin(%p)\n", (void *) rmsg);
+  while (1)
+  {
+    if ((n = ddsrt_atomic_ld32 (&rbuf->n_pins)) > 0)
+    {
+      if (ddsrt_atomic_cas32 (&rbuf->n_pins, n, n + 1))
+        break;
+    }
+    else
+    {
+      uint32_t cur;
+      do {
+        cur = ddsrt_atomic_ld32 (pinned);
+        if (rbuf->size > max || cur > max - rbuf->size)
+          return false;
+      } while (!ddsrt_atomic_cas32 (pinned, cur, cur + rbuf->size));
+      if (ddsrt_atomic_cas32 (&rbuf->n_pins, 0, 1))
+        break;
+      ddsrt_atomic_sub32 (pinned, rbuf->size);
+    }
+  }
+  nn_rmsg_addref (rmsg);
+  return true;
+}
+
+void nn_rmsg_unpin (struct nn_rmsg *rmsg, ddsrt_atomic_uint32_t *pinned)
+{
+  /* the reference to rmsg keeps the rbuf alive, so the refund must happen
+     before dropping it */
+  struct nn_rbuf * const rbuf = rmsg->chunk.rbuf;
+  RMSGTRACE ("rmsg_unpin(%p)\n", (void *) rmsg);
+  assert (ddsrt_atomic_ld32 (&rbuf->n_pins) > 0);
+  if (ddsrt_atomic_dec32_ov (&rbuf->n_pins) == 1)
+    ddsrt_atomic_sub32 (pinned, rbuf->size);
+  nn_rmsg_unref (rmsg);
+}
+
 void *nn_rmsg_alloc (struct nn_rmsg *rmsg, uint32_t size)
 {
   struct nn_rmsg_chunk *chunk = rmsg->lastchunk;
@@ -2463,12 +2618,26 @@ struct nn_dqueue {
   nn_dqueue_handler_t handler;
   void *handler_arg;
 
-  struct nn_rsample_chain sc;
+  /* Queued elements form a lock-free LIFO: producers push their sample
+     chains in reverse order with a CAS on head and the delivery thread
+     takes all of it at once, reversing it again to get the original
+     order.  The lock and condition variable are only used for blocking,
+     when the delivery thread is waiting for work or some thread waits
+     for the queue to drain. */
+  ddsrt_atomic_voidp_t head;
+  ddsrt_atomic_uint32_t sleeping;
+  ddsrt_atomic_uint32_t nof_drain_waiters;
 
   struct thread_state1 *ts;
   char *name;
   uint32_t max_samples;
   ddsrt_atomic_uint32_t nof_samples;
+
+  /* Time between reception and the delivery thread picking up the
+     sample, only written by the delivery thread */
+  ddsrt_atomic_uint64_t lat_count;
+  ddsrt_atomic_uint64_t lat_sum;
+  ddsrt_atomic_uint64_t lat_max;
 };
 
 enum dqueue_elem_kind {
@@ -2512,38 +2681,117 @@ static enum dqueue_elem_kind dqueue_elem_kind (const struct nn_rsample_chain_ele
     return DQEK_BUBBLE;
 }
 
+static struct nn_rsample_chain_elem *reverse_chain (struct nn_rsample_chain_elem *e)
+{
+  struct nn_rsample_chain_elem *r = NULL;
+  while (e)
+  {
+    struct nn_rsample_chain_elem *n = e->next;
+    e->next = r;
+    r = e;
+    e = n;
+  }
+  return r;
+}
+
+static struct nn_rsample_chain_elem *dqueue_take_all (struct nn_dqueue *q)
+{
+  void *h;
+  do {
+    h = ddsrt_atomic_ldvoidp (&q->head);
+  } while (h != NULL && !ddsrt_atomic_casvoidp (&q->head, h, NULL));
+  return reverse_chain (h);
+}
+
+static void dqueue_wait_for_work (struct nn_dqueue *q)
+{
+  /* Setting "sleeping" before checking head pairs with the producers
+     updating head before checking "sleeping": either the producer sees
+     the delivery thread is (about to go) to sleep and signals it, or we
+     see the new data */
+  ddsrt_mutex_lock (&q->lock);
+  ddsrt_atomic_st32 (&q->sleeping, 1);
+  ddsrt_atomic_fence ();
+  while (ddsrt_atomic_ldvoidp (&q->head) == NULL)
+    ddsrt_cond_wait (&q->cond, &q->lock);
+  ddsrt_atomic_st32 (&q->sleeping, 0);
+  ddsrt_mutex_unlock (&q->lock);
+}
+
+static void dqueue_signal (struct nn_dqueue *q)
+{
+  ddsrt_mutex_lock (&q->lock);
+  ddsrt_cond_broadcast (&q->cond);
+  ddsrt_mutex_unlock (&q->lock);
+}
+
+static void dqueue_update_latency_stats (struct nn_dqueue *q, const struct nn_rsample_chain_elem *e, ddsrt_wctime_t tnow)
+{
+  uint64_t count = 0, sum = 0, max = ddsrt_atomic_ld64 (&q->lat_max);
+  for (; e; e = e->next)
+  {
+    if (dqueue_elem_kind (e) != DQEK_DATA || e->sampleinfo->reception_timestamp.v > tnow.v)
+      continue;
+    const uint64_t lat = (uint64_t) (tnow.v - e->sampleinfo->reception_timestamp.v);
+    count++;
+    sum += lat;
+    if (lat > max)
+      max = lat;
+  }
+  ddsrt_atomic_st64 (&q->lat_count, ddsrt_atomic_ld64 (&q->lat_count) + count);
+  ddsrt_atomic_st64 (&q->lat_sum, ddsrt_atomic_ld64 (&q->lat_sum) + sum);
+  ddsrt_atomic_st64 (&q->lat_max, max);
+}
+
 static uint32_t dqueue_thread (struct nn_dqueue *q)
 {
   struct thread_state1 * const ts1 = lookup_thread_state ();
-#if DDSRT_HAVE_RUSAGE
   struct ddsi_domaingv const * const gv = ddsrt_atomic_ldvoidp (&ts1->gv);
-#endif
   ddsrt_mtime_t next_thread_cputime = { 0 };
+  ddsrt_mtime_t next_latency_log = { 0 };
+  uint64_t logged_count = 0, logged_sum = 0;
   int keepgoing = 1;
   ddsi_guid_t rdguid, *prdguid = NULL;
   uint32_t rdguid_count = 0;
 
-  ddsrt_mutex_lock (&q->lock);
   while (keepgoing)
   {
-    struct nn_rsample_chain sc;
+    struct nn_rsample_chain_elem *first;
 
     LOG_THREAD_CPUTIME (&gv->logconfig, next_thread_cputime);
+    if (gv->logconfig.c.mask & DDS_LC_TIMING)
+    {
+      ddsrt_mtime_t tnowlt = ddsrt_time_monotonic ();
+      if (tnowlt.v >= next_latency_log.v)
+      {
+        const uint64_t count = ddsrt_atomic_ld64 (&q->lat_count), sum = ddsrt_atomic_ld64 (&q->lat_sum);
+        if (count > logged_count)
+          GVLOG (DDS_LC_TIMING, "dqueue %s latency count %"PRIu64" avg %"PRIu64"ns max %"PRIu64"ns\n",
+                 q->name, count - logged_count, (sum - logged_sum) / (count - logged_count), ddsrt_atomic_ld64 (&q->lat_max));
+        logged_count = count;
+        logged_sum = sum;
+        next_latency_log.v = tnowlt.v + DDS_NSECS_IN_SEC;
+      }
+    }
 
-    if (q->sc.first == NULL)
-      ddsrt_cond_wait (&q->cond, &q->lock);
-    sc = q->sc;
-    q->sc.first = q->sc.last = NULL;
-    ddsrt_mutex_unlock (&q->lock);
+    if ((first = dqueue_take_all (q)) == NULL)
+    {
+      dqueue_wait_for_work (q);
+      first = dqueue_take_all (q);
+    }
+    dqueue_update_latency_stats (q, first, ddsrt_time_wallclock ());
 
     thread_state_awake_fixed_domain (ts1);
-    while (sc.first)
+    while (first)
     {
-      struct nn_rsample_chain_elem *e = sc.first;
+      struct nn_rsample_chain_elem *e = first;
       int ret;
-      sc.first = e->next;
-      if (ddsrt_atomic_dec32_ov (&q->nof_samples) == 1) {
-        ddsrt_cond_broadcast (&q->cond);
+      first = e->next;
+      if (ddsrt_atomic_dec32_ov (&q->nof_samples) == 1)
+      {
+        ddsrt_atomic_fence ();
+        if (ddsrt_atomic_ld32 (&q->nof_drain_waiters) > 0)
+          dqueue_signal (q);
       }
       thread_state_awake_to_awake_no_nest (ts1);
       switch (dqueue_elem_kind (e))
@@ -2570,7 +2818,7 @@ static uint32_t dqueue_thread (struct nn_dqueue *q)
               /* Stuff enqueued behind the bubble will still be
                  processed, we do want to drain the queue.  Nothing
                  may be queued anymore once we queue the stop bubble,
-                 so q->sc.first should be empty.  If it isn't
+                 so q->head should be empty.  If it isn't
                  ... dqueue_free fail an assertion.  STOP bubble
                  doesn't get malloced, and hence not freed. */
               keepgoing = 0;
@@ -2598,9 +2846,7 @@ static uint32_t dqueue_thread (struct nn_dqueue *q)
     }
 
     thread_state_asleep (ts1);
-    ddsrt_mutex_lock (&q->lock);
   }
-  ddsrt_mutex_unlock (&q->lock);
   return 0;
 }
 
@@ -2618,7 +2864,12 @@ struct nn_dqueue *nn_dqueue_new (const char *name, const struct ddsi_domaingv *g
   ddsrt_atomic_st32 (&q->nof_samples, 0);
   q->handler = handler;
   q->handler_arg = arg;
-  q->sc.first = q->sc.last = NULL;
+  ddsrt_atomic_stvoidp (&q->head, NULL);
+  ddsrt_atomic_st32 (&q->sleeping, 0);
+  ddsrt_atomic_st32 (&q->nof_drain_waiters, 0);
+  ddsrt_atomic_st64 (&q->lat_count, 0);
+  ddsrt_atomic_st64 (&q->lat_sum, 0);
+  ddsrt_atomic_st64 (&q->lat_max, 0);
 
   ddsrt_mutex_init (&q->lock);
   ddsrt_cond_init (&q->cond);
@@ -2644,41 +2895,39 @@ struct nn_dqueue *nn_dqueue_new (const char *name, const struct ddsi_domaingv *g
   return NULL;
 }
 
-static int nn_dqueue_enqueue_locked (struct nn_dqueue *q, struct nn_rsample_chain *sc)
+static bool dqueue_push (struct nn_dqueue *q, struct nn_rsample_chain *sc)
 {
-  int must_signal;
-  if (q->sc.first == NULL)
-  {
-    must_signal = 1;
-    q->sc = *sc;
-  }
-  else
-  {
-    must_signal = 0;
-    q->sc.last->next = sc->first;
-    q->sc.last = sc->last;
-  }
-  return must_signal;
+  /* Returns true if the queue was empty, i.e., if the delivery thread may
+     need waking up */
+  struct nn_rsample_chain_elem * const rfirst = reverse_chain (sc->first);
+  struct nn_rsample_chain_elem * const rlast = sc->first;
+  void *old;
+  do {
+    old = ddsrt_atomic_ldvoidp (&q->head);
+    rlast->next = old;
+  } while (!ddsrt_atomic_casvoidp (&q->head, old, rfirst));
+  return old == NULL;
+}
+
+static void dqueue_wakeup (struct nn_dqueue *q)
+{
+  ddsrt_atomic_fence ();
+  if (ddsrt_atomic_ld32 (&q->sleeping))
+    dqueue_signal (q);
 }
 
 bool nn_dqueue_enqueue_deferred_wakeup (struct nn_dqueue *q, struct nn_rsample_chain *sc, nn_reorder_result_t rres)
 {
-  bool signal;
   assert (rres > 0);
   assert (sc->first);
   assert (sc->last->next == NULL);
-  ddsrt_mutex_lock (&q->lock);
   ddsrt_atomic_add32 (&q->nof_samples, (uint32_t) rres);
-  signal = nn_dqueue_enqueue_locked (q, sc);
-  ddsrt_mutex_unlock (&q->lock);
-  return signal;
+  return dqueue_push (q, sc);
 }
 
 void dd_dqueue_enqueue_trigger (struct nn_dqueue *q)
 {
-  ddsrt_mutex_lock (&q->lock);
-  ddsrt_cond_broadcast (&q->cond);
-  ddsrt_mutex_unlock (&q->lock);
+  dqueue_wakeup (q);
 }
 
 void nn_dqueue_enqueue (struct nn_dqueue *q, struct nn_rsample_chain *sc, nn_reorder_result_t rres)
@@ -2686,30 +2935,26 @@ void nn_dqueue_enqueue (struct nn_dqueue *q, struct nn_rsample_chain *sc, nn_reo
   assert (rres > 0);
   assert (sc->first);
   assert (sc->last->next == NULL);
-  ddsrt_mutex_lock (&q->lock);
   ddsrt_atomic_add32 (&q->nof_samples, (uint32_t) rres);
-  if (nn_dqueue_enqueue_locked (q, sc))
-    ddsrt_cond_broadcast (&q->cond);
-  ddsrt_mutex_unlock (&q->lock);
+  if (dqueue_push (q, sc))
+    dqueue_wakeup (q);
 }
 
-static int nn_dqueue_enqueue_bubble_locked (struct nn_dqueue *q, struct nn_dqueue_bubble *b)
+static void nn_dqueue_init_bubble (struct nn_dqueue_bubble *b)
 {
-  struct nn_rsample_chain sc;
   b->sce.next = NULL;
   b->sce.fragchain = NULL;
   b->sce.sampleinfo = (struct nn_rsample_info *) b;
-  sc.first = sc.last = &b->sce;
-  return nn_dqueue_enqueue_locked (q, &sc);
 }
 
 static void nn_dqueue_enqueue_bubble (struct nn_dqueue *q, struct nn_dqueue_bubble *b)
 {
-  ddsrt_mutex_lock (&q->lock);
+  struct nn_rsample_chain sc;
+  nn_dqueue_init_bubble (b);
+  sc.first = sc.last = &b->sce;
   ddsrt_atomic_inc32 (&q->nof_samples);
-  if (nn_dqueue_enqueue_bubble_locked (q, b))
-    ddsrt_cond_broadcast (&q->cond);
-  ddsrt_mutex_unlock (&q->lock);
+  if (dqueue_push (q, &sc))
+    dqueue_wakeup (q);
 }
 
 void nn_dqueue_enqueue_callback (struct nn_dqueue *q, nn_dqueue_callback_t cb, void *arg)
@@ -2725,6 +2970,7 @@ void nn_dqueue_enqueue_callback (struct nn_dqueue *q, nn_dqueue_callback_t cb, v
 void nn_dqueue_enqueue1 (struct nn_dqueue *q, const ddsi_guid_t *rdguid, struct nn_rsample_chain *sc, nn_reorder_result_t rres)
 {
   struct nn_dqueue_bubble *b;
+  struct nn_rsample_chain sc1;
 
   b = ddsrt_malloc (sizeof (*b));
   b->kind = NN_DQBK_RDGUID;
@@ -2735,12 +2981,14 @@ void nn_dqueue_enqueue1 (struct nn_dqueue *q, const ddsi_guid_t *rdguid, struct
   assert (rdguid != NULL);
   assert (sc->first);
   assert (sc->last->next == NULL);
-  ddsrt_mutex_lock (&q->lock);
+  /* bubble and samples must be enqueued as a single chain */
+  nn_dqueue_init_bubble (b);
+  b->sce.next = sc->first;
+  sc1.first = &b->sce;
+  sc1.last = sc->last;
   ddsrt_atomic_add32 (&q->nof_samples, 1 + (uint32_t) rres);
-  if (nn_dqueue_enqueue_bubble_locked (q, b))
-    ddsrt_cond_broadcast (&q->cond);
-  (void) nn_dqueue_enqueue_locked (q, sc);
-  ddsrt_mutex_unlock (&q->lock);
+  if (dqueue_push (q, &sc1))
+    dqueue_wakeup (q);
 }
 
 int nn_dqueue_is_full (struct nn_dqueue *q)
@@ -2762,14 +3010,24 @@ void nn_dqueue_wait_until_empty_if_full (struct nn_dqueue *q)
   if (count >= q->max_samples)
   {
     ddsrt_mutex_lock (&q->lock);
+    ddsrt_atomic_inc32 (&q->nof_drain_waiters);
+    ddsrt_atomic_fence ();
     /* In case the wakeups are were all deferred */
     ddsrt_cond_broadcast (&q->cond);
     while (ddsrt_atomic_ld32 (&q->nof_samples) > 0)
       ddsrt_cond_wait (&q->cond, &q->lock);
+    ddsrt_atomic_dec32 (&q->nof_drain_waiters);
     ddsrt_mutex_unlock (&q->lock);
   }
 }
 
+void nn_dqueue_stats (struct nn_dqueue *q, uint64_t *count, uint64_t *latency_sum, uint64_t *latency_max)
+{
+  *count = ddsrt_atomic_ld64 (&q->lat_count);
+  *latency_sum = ddsrt_atomic_ld64 (&q->lat_sum);
+  *latency_max = ddsrt_atomic_ld64 (&q->lat_max);
+}
+
 void nn_dqueue_free (struct nn_dqueue *q)
 {
   /* There must not be any thread enqueueing things anymore at this
@@ -2782,7 +3040,7 @@ void nn_dqueue_free (struct nn_dqueue *q)
   nn_dqueue_enqueue_bubble (q, &b);
 
   join_thread (q->ts);
-  assert (q->sc.first == NULL);
+  assert (ddsrt_atomic_ldvoidp (&q->head) == NULL);
   ddsrt_cond_destroy (&q->cond);
   ddsrt_mutex_destroy (&q->lock);
   ddsrt_free (q->name);
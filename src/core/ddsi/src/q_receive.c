@@ -56,6 +56,7 @@
 #include "dds/ddsi/ddsi_serdata_default.h" /* FIXME: get rid of this */
 #include "dds/ddsi/ddsi_security_omg.h"
 #include "dds/ddsi/ddsi_acknack.h"
+#include "dds/ddsi/ddsi_cfilter.h"
 
 #include "dds/ddsi/sysdeps.h"
 #include "dds__whc.h"
@@ -969,7 +970,7 @@ static int handle_AckNack (struct receiver_state *rst, ddsrt_etime_t tnow, const
         if (!wr->retransmitting && sample.unacked)
           writer_set_retransmitting (wr);
 
-        if (rst->gv->config.retransmit_merging != DDSI_REXMIT_MERGE_NEVER && rn->assumed_in_sync && !prd->filter)
+        if (rst->gv->config.retransmit_merging != DDSI_REXMIT_MERGE_NEVER && rn->assumed_in_sync && !prd->filter && !rn->cfilter)
         {
           /* send retransmit to all receivers, but skip if recently done */
           ddsrt_mtime_t tstamp = ddsrt_time_monotonic ();
@@ -999,9 +1000,10 @@ static int handle_AckNack (struct receiver_state *rst, ddsrt_etime_t tnow, const
         }
         else
         {
-          /* Is this a volatile reader with a filter?
+          /* Is this a volatile reader with a filter, or a reader with a content filter?
            * If so, call the filter to see if we should re-arrange the sequence gap when needed. */
-          if (prd->filter && !prd->filter (wr, prd, sample.serdata))
+          if ((prd->filter && !prd->filter (wr, prd, sample.serdata)) ||
+              (rn->cfilter && !ddsi_cfilter_accepts (rn->cfilter, sample.serdata)))
             nn_gap_info_update (rst->gv, &gi, seqbase + i);
           else
           {
@@ -1743,7 +1745,9 @@ static int handle_one_gap (struct proxy_writer *pwr, struct pwr_rd_match *wn, se
         assert(0);
         break;
       case PRMSS_TLCATCHUP:
-        break;
+        /* Data still goes through the reader's own reorder admin, and a
+           GAP addressed to just this reader (as for a content-filtered
+           one) isn't necessarily matched by one for the proxy writer */
       case PRMSS_OUT_OF_SYNC:
         if ((res = nn_reorder_gap (&sc, wn->u.not_in_sync.reorder, gap, a, b, refc_adjust)) > 0)
         {
@@ -3177,6 +3181,47 @@ malformed_asleep:
   return -1;
 }
 
+static void handle_rtps_message (struct thread_state1 * const ts1, struct ddsi_domaingv *gv, ddsi_tran_conn_t conn, const ddsi_guid_prefix_t *guidprefix, struct nn_rbufpool *rbpool, struct nn_rmsg *rmsg, size_t sz, unsigned char *msg, const ddsi_locator_t *srcloc)
+{
+  Header_t *hdr = (Header_t *) msg;
+  assert (thread_is_asleep ());
+  if (sz < RTPS_MESSAGE_HEADER_SIZE || *(uint32_t *)msg != NN_PROTOCOLID_AS_UINT32)
+  {
+    /* discard packets that are really too small or don't have magic cookie */
+  }
+  else if (hdr->version.major != RTPS_MAJOR || (hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
+  {
+    if ((hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
+      GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu\n, version mismatch: %d.%d\n",
+               PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, hdr->version.major, hdr->version.minor);
+    if (DDSI_SC_PEDANTIC_P (gv->config))
+      malformed_packet_received_nosubmsg (gv, msg, (ssize_t) sz, "header", hdr->vendorid);
+  }
+  else
+  {
+    hdr->guid_prefix = nn_ntoh_guid_prefix (hdr->guid_prefix);
+
+    if (gv->logconfig.c.mask & DDS_LC_TRACE)
+    {
+      char addrstr[DDSI_LOCSTRLEN];
+      ddsi_locator_to_string(addrstr, sizeof(addrstr), srcloc);
+      GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu from %s\n",
+               PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, addrstr);
+    }
+    ssize_t ssz = (ssize_t) sz;
+    nn_rtps_msg_state_t res = decode_rtps_message (ts1, gv, &rmsg, &hdr, &msg, &ssz, rbpool, conn->m_stream);
+    if (res != NN_RTPS_MSG_STATE_ERROR)
+    {
+      handle_submsg_sequence (ts1, gv, conn, srcloc, ddsrt_time_wallclock (), ddsrt_time_elapsed (), &hdr->guid_prefix, guidprefix, msg, (size_t) ssz, msg + RTPS_MESSAGE_HEADER_SIZE, rmsg, res == NN_RTPS_MSG_STATE_ENCODED);
+    }
+    else
+    {
+      /* drop message */
+    }
+  }
+  nn_rmsg_commit (rmsg);
+}
+
 static bool do_packet (struct thread_state1 * const ts1, struct ddsi_domaingv *gv, ddsi_tran_conn_t conn, const ddsi_guid_prefix_t *guidprefix, struct nn_rbufpool *rbpool)
 {
   /* UDP max packet size is 64kB */
@@ -3265,50 +3310,65 @@ static bool do_packet (struct thread_state1 * const ts1, struct ddsi_domaingv *g
   if (sz > 0 && !gv->deaf)
   {
     nn_rmsg_setsize (rmsg, (uint32_t) sz);
-    assert (thread_is_asleep ());
+    handle_rtps_message (ts1, gv, conn, guidprefix, rbpool, rmsg, (size_t) sz, buff, &srcloc);
+  }
+  else
+  {
+    nn_rmsg_commit (rmsg);
+  }
+  return (sz > 0);
+}
 
-    if ((size_t)sz < RTPS_MESSAGE_HEADER_SIZE || *(uint32_t *)buff != NN_PROTOCOLID_AS_UINT32)
-    {
-      /* discard packets that are really too small or don't have magic cookie */
-    }
-    else if (hdr->version.major != RTPS_MAJOR || (hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
+static bool do_packet_batch (struct thread_state1 * const ts1, struct ddsi_domaingv *gv, ddsi_tran_conn_t conn, const ddsi_guid_prefix_t *guidprefix, struct nn_rbufpool *rbpool)
+{
+  /* Reads up to ReceiveBatchSize packets in one go into consecutive rmsgs
+     in the receive buffer, then processes them in order of arrival */
+  const size_t maxsz = gv->config.rmsg_chunk_size < 65536 ? gv->config.rmsg_chunk_size : 65536;
+  struct nn_rmsg *rmsgs[DDSI_TRAN_READ_BATCH_MAX];
+  struct ddsi_tran_read_batch_msg msgs[DDSI_TRAN_READ_BATCH_MAX];
+  uint32_t n;
+  ssize_t nrcvd;
+
+  assert (!conn->m_stream);
+  assert (gv->config.recv_batch_size > 1 && gv->config.recv_batch_size <= DDSI_TRAN_READ_BATCH_MAX);
+  if ((n = nn_rmsg_new_batch (rbpool, gv->config.recv_batch_size, rmsgs)) == 0)
+    return false;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    msgs[i].buf = (unsigned char *) NN_RMSG_PAYLOAD (rmsgs[i]);
+    msgs[i].len = maxsz;
+  }
+
+  nrcvd = ddsi_conn_read_batch (conn, n, msgs);
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if ((ssize_t) i < nrcvd && msgs[i].len > 0 && !gv->deaf)
     {
-      if ((hdr->version.major == RTPS_MAJOR && hdr->version.minor < RTPS_MINOR_MINIMUM))
-        GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu\n, version mismatch: %d.%d\n",
-                 PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, hdr->version.major, hdr->version.minor);
-      if (DDSI_SC_PEDANTIC_P (gv->config))
-        malformed_packet_received_nosubmsg (gv, buff, sz, "header", hdr->vendorid);
+      nn_rmsg_setsize (rmsgs[i], (uint32_t) msgs[i].len);
+      handle_rtps_message (ts1, gv, conn, guidprefix, rbpool, rmsgs[i], msgs[i].len, msgs[i].buf, &msgs[i].srcloc);
     }
     else
     {
-      hdr->guid_prefix = nn_ntoh_guid_prefix (hdr->guid_prefix);
-
-      if (gv->logconfig.c.mask & DDS_LC_TRACE)
-      {
-        char addrstr[DDSI_LOCSTRLEN];
-        ddsi_locator_to_string(addrstr, sizeof(addrstr), &srcloc);
-        GVTRACE ("HDR(%"PRIx32":%"PRIx32":%"PRIx32" vendor %d.%d) len %lu from %s\n",
-                 PGUIDPREFIX (hdr->guid_prefix), hdr->vendorid.id[0], hdr->vendorid.id[1], (unsigned long) sz, addrstr);
-      }
-      nn_rtps_msg_state_t res = decode_rtps_message (ts1, gv, &rmsg, &hdr, &buff, &sz, rbpool, conn->m_stream);
-      if (res != NN_RTPS_MSG_STATE_ERROR)
-      {
-        handle_submsg_sequence (ts1, gv, conn, &srcloc, ddsrt_time_wallclock (), ddsrt_time_elapsed (), &hdr->guid_prefix, guidprefix, buff, (size_t) sz, buff + RTPS_MESSAGE_HEADER_SIZE, rmsg, res == NN_RTPS_MSG_STATE_ENCODED);
-      }
-      else
-      {
-        /* drop message */
-        sz = 1;
-      }
+      nn_rmsg_commit (rmsgs[i]);
     }
   }
-  nn_rmsg_commit (rmsg);
-  return (sz > 0);
+  nn_rmsg_end_batch (rbpool);
+  return (nrcvd > 0);
+}
+
+static bool do_packets (struct thread_state1 * const ts1, struct ddsi_domaingv *gv, ddsi_tran_conn_t conn, const ddsi_guid_prefix_t *guidprefix, struct nn_rbufpool *rbpool)
+{
+  if (gv->config.recv_batch_size > 1 && ddsi_conn_supports_read_batch (conn))
+    return do_packet_batch (ts1, gv, conn, guidprefix, rbpool);
+  else
+    return do_packet (ts1, gv, conn, guidprefix, rbpool);
 }
 
 struct local_participant_desc
 {
   ddsi_tran_conn_t m_conn;
+  ddsrt_socket_t m_handle;
+  uint32_t m_serial;
   ddsi_guid_prefix_t guid_prefix;
 };
 
@@ -3316,8 +3376,8 @@ static int local_participant_cmp (const void *va, const void *vb)
 {
   const struct local_participant_desc *a = va;
   const struct local_participant_desc *b = vb;
-  ddsrt_socket_t h1 = ddsi_conn_handle (a->m_conn);
-  ddsrt_socket_t h2 = ddsi_conn_handle (b->m_conn);
+  ddsrt_socket_t h1 = a->m_handle;
+  ddsrt_socket_t h2 = b->m_handle;
   return (h1 == h2) ? 0 : (h1 < h2) ? -1 : 1;
 }
 
@@ -3396,6 +3456,8 @@ static void rebuild_local_participant_set (struct thread_state1 * const ts1, str
     else
     {
       lps->ps[lps->nps].m_conn = pp->m_conn;
+      lps->ps[lps->nps].m_handle = pp->m_conn ? ddsi_conn_handle (pp->m_conn) : DDSRT_INVALID_SOCKET;
+      lps->ps[lps->nps].m_serial = pp->m_conn ? pp->m_conn->m_serial : 0;
       lps->ps[lps->nps].guid_prefix = pp->e.guid.prefix;
       GVTRACE ("  pp "PGUIDFMT" handle %"PRIdSOCK"\n", PGUID (pp->e.guid), ddsi_conn_handle (pp->m_conn));
       lps->nps++;
@@ -3430,6 +3492,41 @@ static void rebuild_local_participant_set (struct thread_state1 * const ts1, str
   GVTRACE ("  nparticipants %"PRIu32"\n", lps->nps);
 }
 
+static const ddsi_guid_prefix_t *lookup_local_participant_guid_prefix (const struct local_participant_set *lps, ddsi_tran_conn_t conn)
+{
+  /* the set is sorted on socket, connections get added to and removed from
+     the waitset incrementally, and so the waitset index is of no use */
+  struct local_participant_desc key;
+  const struct local_participant_desc *p;
+  key.m_handle = ddsi_conn_handle (conn);
+  if (lps->nps == 0 || (p = bsearch (&key, lps->ps, lps->nps, sizeof (*lps->ps), local_participant_cmp)) == NULL || p->m_conn != conn)
+    return NULL;
+  return &p->guid_prefix;
+}
+
+static void update_waitset_local_participants (os_sockWaitset ws, const struct local_participant_set *old, const struct local_participant_set *new)
+{
+  /* Both sets are sorted on socket, so a merge gives the connections that
+     need to be added.  Connections of deleted participants have already
+     been removed from the waitset when they were closed (ddsi_conn_free),
+     which also means they can't be touched here anymore, and it is also why
+     the socket is cached in the set.  A new connection may have the same
+     socket and even the same address as one that was freed in the meantime,
+     so connections are compared on their serial number instead. */
+  uint32_t i = 0, j = 0;
+  while (j < new->nps)
+  {
+    if (i < old->nps && old->ps[i].m_handle < new->ps[j].m_handle)
+      i++;
+    else
+    {
+      if (new->ps[j].m_conn && !(i < old->nps && old->ps[i].m_handle == new->ps[j].m_handle && old->ps[i].m_serial == new->ps[j].m_serial))
+        os_sockWaitsetAdd (ws, new->ps[j].m_conn);
+      j++;
+    }
+  }
+}
+
 uint32_t listen_thread (struct ddsi_tran_listener *listener)
 {
   struct ddsi_domaingv *gv = listener->m_base.gv;
@@ -3473,11 +3570,12 @@ void trigger_recv_threads (const struct ddsi_domaingv *gv)
     {
       case RTM_SINGLE: {
         char buf[DDSI_LOCSTRLEN];
-        char dummy = 0;
+        // a 2-byte packet {0, k} is steered to the k-th socket sharing the unicast data port
+        const unsigned char dummy[2] = { 0, (unsigned char) gv->recv_threads[i].arg.u.single.shard };
         const ddsi_locator_t *dst = gv->recv_threads[i].arg.u.single.loc;
         ddsrt_iovec_t iov;
-        iov.iov_base = &dummy;
-        iov.iov_len = 1;
+        iov.iov_base = (void *) dummy;
+        iov.iov_len = (dummy[1] == 0) ? 1 : 2;
         GVTRACE ("trigger_recv_threads: %"PRIu32" single %s\n", i, ddsi_locator_to_string (buf, sizeof (buf), dst));
         // all sockets listen on at least the interfaces used for transmitting (at least for now)
         ddsi_conn_write (gv->xmit_conns[0], dst, 1, &iov, 0);
@@ -3508,7 +3606,7 @@ uint32_t recv_thread (void *vrecv_thread_arg)
     while (ddsrt_atomic_ld32 (&gv->rtps_keepgoing))
     {
       LOG_THREAD_CPUTIME (&gv->logconfig, next_thread_cputime);
-      (void) do_packet (ts1, gv, conn, NULL, rbpool);
+      (void) do_packets (ts1, gv, conn, NULL, rbpool);
     }
   }
   else
@@ -3552,13 +3650,12 @@ uint32_t recv_thread (void *vrecv_thread_arg)
       {
         /* first rebuild local participant set - unless someone's toggling "deafness", this
          only happens when the participant set has changed, so might as well rebuild it */
+        struct local_participant_set old_lps = lps;
+        lps.ps = NULL;
+        lps.nps = 0;
         rebuild_local_participant_set (ts1, gv, &lps);
-        os_sockWaitsetPurge (waitset, num_fixed);
-        for (uint32_t i = 0; i < lps.nps; i++)
-        {
-          if (lps.ps[i].m_conn)
-            os_sockWaitsetAdd (waitset, lps.ps[i].m_conn);
-        }
+        update_waitset_local_participants (waitset, &old_lps, &lps);
+        local_participant_set_fini (&old_lps);
       }
 
       if ((ctx = os_sockWaitsetWait (waitset)) != NULL)
@@ -3571,9 +3668,9 @@ uint32_t recv_thread (void *vrecv_thread_arg)
           if (((unsigned)idx < num_fixed) || gv->config.many_sockets_mode != DDSI_MSM_MANY_UNICAST)
             guid_prefix = NULL;
           else
-            guid_prefix = &lps.ps[(unsigned)idx - num_fixed].guid_prefix;
+            guid_prefix = lookup_local_participant_guid_prefix (&lps, conn);
           /* Process message and clean out connection if failed or closed */
-          if (!do_packet (ts1, gv, conn, guid_prefix, rbpool) && !conn->m_connless)
+          if (!do_packets (ts1, gv, conn, guid_prefix, rbpool) && !conn->m_connless)
             ddsi_conn_free (conn);
         }
       }
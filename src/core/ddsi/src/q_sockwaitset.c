@@ -27,9 +27,12 @@
 #define MODE_KQUEUE 1
 #define MODE_SELECT 2
 #define MODE_WFMEVS 3
+#define MODE_EPOLL 4
 
 #if defined __APPLE__
 #define MODE_SEL MODE_KQUEUE
+#elif defined __linux && !LWIP_SOCKET
+#define MODE_SEL MODE_EPOLL
 #elif defined WINCE
 #define MODE_SEL MODE_WFMEVS
 #else
@@ -281,6 +284,362 @@ int os_sockWaitsetNextEvent (os_sockWaitsetCtx ctx, ddsi_tran_conn_t *conn)
   return -1;
 }
 
+#elif MODE_SEL == MODE_EPOLL
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+
+#include "dds/ddsrt/hopscotch.h"
+#include "dds/ddsrt/mh3.h"
+
+/* Entries are identified in the epoll set by their slot in the entries
+   array and a generation counter, so that an event for a connection that
+   is removed (and whose slot is reused) while the receive thread is
+   blocked in epoll_wait can be recognised and ignored.  Slot 0 is the
+   trigger pipe.  Free slots are kept in a free list and the slot of a
+   connection is found through a hash table, so add and remove don't scale
+   with the size of the set.  The order of the slots is irrelevant, other
+   than that the fixed connections are added first and never removed, and
+   so always have the lowest indices. */
+
+#define EPOLL_NO_SLOT UINT32_MAX
+
+struct entry {
+  int fd;
+  uint32_t gen;
+  uint32_t next_free;
+  ddsi_tran_conn_t conn;
+};
+
+struct conn_slot {
+  ddsi_tran_conn_t conn;
+  uint32_t slot;
+};
+
+struct event {
+  int index;
+  ddsi_tran_conn_t conn;
+};
+
+struct os_sockWaitsetCtx
+{
+  struct epoll_event *evs;
+  struct event *ready;
+  uint32_t nready;
+  uint32_t evs_sz;
+  uint32_t index; /* cursor for enumerating */
+};
+
+struct os_sockWaitset
+{
+  int epoll;
+  int pipe[2]; /* pipe used for triggering */
+  ddsrt_atomic_uint32_t sz;
+  uint32_t free_head;
+  struct entry *entries;
+  struct ddsrt_hh *slots; /* conn -> slot */
+  struct os_sockWaitsetCtx ctx; /* set of descriptors being handled */
+  ddsrt_mutex_t lock; /* for add/delete */
+};
+
+static uint32_t conn_slot_hash (const void *va)
+{
+  const struct conn_slot *a = va;
+  return ddsrt_mh3 (&a->conn, sizeof (a->conn), 0);
+}
+
+static int conn_slot_eq (const void *va, const void *vb)
+{
+  const struct conn_slot *a = va;
+  const struct conn_slot *b = vb;
+  return a->conn == b->conn;
+}
+
+static void conn_slot_free (void *vnode, void *varg)
+{
+  (void) varg;
+  ddsrt_free (vnode);
+}
+
+static uint64_t epoll_data_for_slot (const os_sockWaitset ws, uint32_t slot)
+{
+  return ((uint64_t) ws->entries[slot].gen << 32) | slot;
+}
+
+static int epoll_add_slot (const os_sockWaitset ws, uint32_t slot)
+{
+  struct epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.u64 = epoll_data_for_slot (ws, slot);
+  return epoll_ctl (ws->epoll, EPOLL_CTL_ADD, ws->entries[slot].fd, &ev);
+}
+
+static void grow_entries_locked (os_sockWaitset ws)
+{
+  const uint32_t sz = ddsrt_atomic_ld32 (&ws->sz);
+  const uint32_t newsz = sz + WAITSET_DELTA;
+  assert (ws->free_head == EPOLL_NO_SLOT);
+  ws->entries = ddsrt_realloc (ws->entries, newsz * sizeof (*ws->entries));
+  for (uint32_t idx = sz; idx < newsz; idx++)
+  {
+    ws->entries[idx].fd = -1;
+    ws->entries[idx].gen = 0;
+    ws->entries[idx].conn = NULL;
+    ws->entries[idx].next_free = (idx + 1 < newsz) ? idx + 1 : EPOLL_NO_SLOT;
+  }
+  ws->free_head = sz;
+  ddsrt_atomic_st32 (&ws->sz, newsz);
+}
+
+static void free_slot_locked (os_sockWaitset ws, uint32_t slot)
+{
+  if (ws->entries[slot].conn != NULL)
+  {
+    struct conn_slot template = { .conn = ws->entries[slot].conn };
+    struct conn_slot *node = ddsrt_hh_lookup (ws->slots, &template);
+    if (node != NULL && node->slot == slot)
+    {
+      ddsrt_hh_remove (ws->slots, node);
+      ddsrt_free (node);
+    }
+  }
+  ws->entries[slot].fd = -1;
+  ws->entries[slot].conn = NULL;
+  ws->entries[slot].next_free = ws->free_head;
+  ws->free_head = slot;
+}
+
+static int add_entry_locked (os_sockWaitset ws, ddsi_tran_conn_t conn, int fd)
+{
+  uint32_t slot;
+  assert (fd >= 0);
+  if (ws->free_head == EPOLL_NO_SLOT)
+    grow_entries_locked (ws);
+  slot = ws->free_head;
+  ws->entries[slot].fd = fd;
+  ws->entries[slot].conn = conn;
+  ws->entries[slot].gen++;
+  if (epoll_add_slot (ws, slot) == -1)
+  {
+    const int err = errno;
+    ws->entries[slot].fd = -1;
+    ws->entries[slot].conn = NULL;
+    /* the epoll set ensures a file descriptor is present at most once */
+    return (err == EEXIST) ? 0 : -1;
+  }
+  ws->free_head = ws->entries[slot].next_free;
+  if (conn != NULL)
+  {
+    struct conn_slot *node = ddsrt_malloc (sizeof (*node));
+    node->conn = conn;
+    node->slot = slot;
+    if (!ddsrt_hh_add (ws->slots, node))
+    {
+      /* can't happen: a connection has a single socket, and so can't be
+         in the set already if adding it to the epoll set succeeded */
+      assert (0);
+      ddsrt_free (node);
+    }
+  }
+  return 1;
+}
+
+os_sockWaitset os_sockWaitsetNew (void)
+{
+  os_sockWaitset ws;
+  if ((ws = ddsrt_malloc (sizeof (*ws))) == NULL)
+    goto fail_waitset;
+  ddsrt_atomic_st32 (&ws->sz, 0);
+  ws->entries = NULL;
+  ws->free_head = EPOLL_NO_SLOT;
+  ws->slots = ddsrt_hh_new (WAITSET_DELTA, conn_slot_hash, conn_slot_eq);
+  grow_entries_locked (ws);
+  ws->ctx.nready = 0;
+  ws->ctx.index = 0;
+  ws->ctx.evs_sz = WAITSET_DELTA;
+  if ((ws->ctx.evs = ddsrt_malloc (ws->ctx.evs_sz * sizeof (*ws->ctx.evs))) == NULL)
+    goto fail_ctx_evs;
+  if ((ws->ctx.ready = ddsrt_malloc (ws->ctx.evs_sz * sizeof (*ws->ctx.ready))) == NULL)
+    goto fail_ctx_ready;
+  if ((ws->epoll = epoll_create1 (EPOLL_CLOEXEC)) == -1)
+    goto fail_epoll;
+  if (pipe (ws->pipe) == -1)
+    goto fail_pipe;
+  if (fcntl (ws->pipe[0], F_SETFD, fcntl (ws->pipe[0], F_GETFD) | FD_CLOEXEC) == -1)
+    goto fail_fcntl;
+  if (fcntl (ws->pipe[1], F_SETFD, fcntl (ws->pipe[1], F_GETFD) | FD_CLOEXEC) == -1)
+    goto fail_fcntl;
+  if (add_entry_locked (ws, NULL, ws->pipe[0]) <= 0)
+    goto fail_add_trigger;
+  assert (ws->entries[0].fd == ws->pipe[0]);
+  ddsrt_mutex_init (&ws->lock);
+  return ws;
+
+fail_add_trigger:
+fail_fcntl:
+  close (ws->pipe[0]);
+  close (ws->pipe[1]);
+fail_pipe:
+  close (ws->epoll);
+fail_epoll:
+  ddsrt_free (ws->ctx.ready);
+fail_ctx_ready:
+  ddsrt_free (ws->ctx.evs);
+fail_ctx_evs:
+  ddsrt_hh_free (ws->slots);
+  ddsrt_free (ws->entries);
+  ddsrt_free (ws);
+fail_waitset:
+  return NULL;
+}
+
+void os_sockWaitsetFree (os_sockWaitset ws)
+{
+  ddsrt_mutex_destroy (&ws->lock);
+  close (ws->pipe[0]);
+  close (ws->pipe[1]);
+  close (ws->epoll);
+  ddsrt_hh_enum (ws->slots, conn_slot_free, NULL);
+  ddsrt_hh_free (ws->slots);
+  ddsrt_free (ws->entries);
+  ddsrt_free (ws->ctx.evs);
+  ddsrt_free (ws->ctx.ready);
+  ddsrt_free (ws);
+}
+
+void os_sockWaitsetTrigger (os_sockWaitset ws)
+{
+  char buf = 0;
+  int n;
+  n = (int) write (ws->pipe[1], &buf, 1);
+  if (n != 1)
+  {
+    DDS_WARNING("os_sockWaitsetTrigger: write failed on trigger pipe, errno = %d\n", errno);
+  }
+}
+
+int os_sockWaitsetAdd (os_sockWaitset ws, ddsi_tran_conn_t conn)
+{
+  int ret;
+  ddsrt_mutex_lock (&ws->lock);
+  ret = add_entry_locked (ws, conn, ddsi_conn_handle (conn));
+  ddsrt_mutex_unlock (&ws->lock);
+  return ret;
+}
+
+void os_sockWaitsetPurge (os_sockWaitset ws, unsigned index)
+{
+  /* Sockets may have been closed by the time Purge is called, and closed
+     sockets are automatically removed from the epoll set, but their file
+     descriptors may be reused in the meantime.  So, like for kqueue, it
+     seems wiser to replace the epoll set than to delete entries */
+  uint32_t i, sz;
+  ddsrt_mutex_lock (&ws->lock);
+  sz = ddsrt_atomic_ld32 (&ws->sz);
+  close (ws->epoll);
+  if ((ws->epoll = epoll_create1 (EPOLL_CLOEXEC)) == -1)
+    abort (); /* FIXME */
+  ws->free_head = EPOLL_NO_SLOT;
+  for (i = sz; i > 0; i--)
+  {
+    const uint32_t slot = i - 1;
+    if (slot <= index && ws->entries[slot].fd >= 0)
+    {
+      if (epoll_add_slot (ws, slot) == -1)
+        abort (); /* FIXME */
+    }
+    else
+    {
+      free_slot_locked (ws, slot);
+    }
+  }
+  ddsrt_mutex_unlock (&ws->lock);
+}
+
+void os_sockWaitsetRemove (os_sockWaitset ws, ddsi_tran_conn_t conn)
+{
+  struct conn_slot template = { .conn = conn };
+  struct conn_slot *node;
+  ddsrt_mutex_lock (&ws->lock);
+  if ((node = ddsrt_hh_lookup (ws->slots, &template)) != NULL)
+  {
+    /* the socket is still open when it is removed (ddsi_conn_free removes
+       it before closing it), so this is expected to succeed */
+    assert (ws->entries[node->slot].conn == conn && ws->entries[node->slot].fd >= 0);
+    if (epoll_ctl (ws->epoll, EPOLL_CTL_DEL, ws->entries[node->slot].fd, NULL) == -1)
+      DDS_WARNING("os_sockWaitsetRemove: epoll_ctl failed, errno = %d\n", errno);
+    free_slot_locked (ws, node->slot);
+  }
+  ddsrt_mutex_unlock (&ws->lock);
+}
+
+os_sockWaitsetCtx os_sockWaitsetWait (os_sockWaitset ws)
+{
+  /* if the array of events is smaller than the number of file descriptors in the
+     epoll set, things will still work fine, as the kernel will just return what
+     can be stored, and the set will be grown on the next call */
+  uint32_t ws_sz = ddsrt_atomic_ld32 (&ws->sz);
+  int nevs;
+  if (ws->ctx.evs_sz < ws_sz)
+  {
+    ws->ctx.evs_sz = ws_sz;
+    ws->ctx.evs = ddsrt_realloc (ws->ctx.evs, ws_sz * sizeof (*ws->ctx.evs));
+    ws->ctx.ready = ddsrt_realloc (ws->ctx.ready, ws_sz * sizeof (*ws->ctx.ready));
+  }
+  nevs = epoll_wait (ws->epoll, ws->ctx.evs, (int) ws->ctx.evs_sz, -1);
+  if (nevs < 0)
+  {
+    if (errno == EINTR)
+      nevs = 0;
+    else
+    {
+      DDS_WARNING("os_sockWaitsetWait: epoll_wait failed, errno = %d\n", errno);
+      return NULL;
+    }
+  }
+
+  /* Map events to connections while holding the lock, so that connections
+     removed in the meantime are skipped */
+  ws->ctx.nready = 0;
+  ws->ctx.index = 0;
+  ddsrt_mutex_lock (&ws->lock);
+  ws_sz = ddsrt_atomic_ld32 (&ws->sz);
+  for (uint32_t i = 0; i < (uint32_t) nevs; i++)
+  {
+    const uint32_t slot = (uint32_t) ws->ctx.evs[i].data.u64;
+    const uint32_t gen = (uint32_t) (ws->ctx.evs[i].data.u64 >> 32);
+    if (slot == 0)
+    {
+      /* trigger pipe, read & ignore */
+      char dummy;
+      if (read (ws->pipe[0], &dummy, 1) != 1)
+        DDS_WARNING("os_sockWaitsetWait: read failed on trigger pipe, errno = %d\n", errno);
+    }
+    else if (slot < ws_sz && ws->entries[slot].fd >= 0 && ws->entries[slot].gen == gen)
+    {
+      ws->ctx.ready[ws->ctx.nready].index = (int) (slot - 1);
+      ws->ctx.ready[ws->ctx.nready].conn = ws->entries[slot].conn;
+      ws->ctx.nready++;
+    }
+  }
+  ddsrt_mutex_unlock (&ws->lock);
+  return &ws->ctx;
+}
+
+int os_sockWaitsetNextEvent (os_sockWaitsetCtx ctx, ddsi_tran_conn_t *conn)
+{
+  if (ctx->index < ctx->nready)
+  {
+    const struct event *ev = &ctx->ready[ctx->index++];
+    *conn = ev->conn;
+    return ev->index;
+  }
+  return -1;
+}
+
 #elif MODE_SEL == MODE_WFMEVS
 
 struct os_sockWaitsetCtx
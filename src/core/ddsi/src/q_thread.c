@@ -53,6 +53,9 @@ DDSRT_STATIC_ASSERT(THREAD_STATE_ZERO == 0 &&
                     THREAD_STATE_INIT < THREAD_STATE_LAZILY_CREATED &&
                     THREAD_STATE_INIT < THREAD_STATE_ALIVE);
 
+/* the "active" bitmap of a segment is a uint32_t */
+DDSRT_STATIC_ASSERT(THREAD_STATE_BATCH == 32);
+
 #if Q_THREAD_DEBUG
 #include <execinfo.h>
 
@@ -91,17 +94,38 @@ static void ddsrt_free_aligned (void *ptr)
   }
 }
 
-void thread_states_init (unsigned maxthreads)
+static struct thread_states_list *thread_states_grow (void)
+{
+  /* Called with thread_states.lock held; the new segment is fully initialized before
+     it is published, so that those that walk the list without holding the lock only
+     ever observe valid slots */
+  struct thread_states_list *cur = ddsrt_malloc_aligned_cacheline (sizeof (*cur));
+  const uint32_t base = ddsrt_atomic_ld32 (&thread_states.nthreads);
+  memset (cur, 0, sizeof (*cur));
+  for (uint32_t i = 0; i < THREAD_STATE_BATCH; i++)
+  {
+    cur->thrst[i].list = cur;
+    cur->thrst[i].idx = base + i;
+  }
+  cur->next = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head);
+  ddsrt_atomic_st32 (&thread_states.nthreads, base + THREAD_STATE_BATCH);
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_stvoidp (&thread_states.thread_states_head, cur);
+  return cur;
+}
+
+void thread_states_init (void)
 {
   /* Called with ddsrt's singleton mutex held (see dds_init/fini).  Application threads
      remaining alive can result in thread_states remaining alive, and as those thread
-     cache the address, we must then re-use the old array. */
-  if (thread_states.ts == NULL)
+     cache the address, we must then re-use the old segments. */
+  if (ddsrt_atomic_ldvoidp (&thread_states.thread_states_head) == NULL)
   {
     ddsrt_mutex_init (&thread_states.lock);
-    thread_states.nthreads = maxthreads;
-    thread_states.ts = ddsrt_malloc_aligned_cacheline (maxthreads * sizeof (*thread_states.ts));
-    memset (thread_states.ts, 0, maxthreads * sizeof (*thread_states.ts));
+    ddsrt_atomic_st32 (&thread_states.nthreads, 0);
+    ddsrt_mutex_lock (&thread_states.lock);
+    (void) thread_states_grow ();
+    ddsrt_mutex_unlock (&thread_states.lock);
   }
 
   /* This thread should be at the same address as before, or never have had a slot
@@ -133,27 +157,37 @@ bool thread_states_fini (void)
      if there are still users. */
   uint32_t others = 0;
   ddsrt_mutex_lock (&thread_states.lock);
-  for (uint32_t i = 0; i < thread_states.nthreads; i++)
+  for (struct thread_states_list *cur = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head); cur; cur = cur->next)
   {
-    switch (thread_states.ts[i].state)
+    for (uint32_t i = 0; i < THREAD_STATE_BATCH; i++)
     {
-      case THREAD_STATE_ZERO:
-        break;
-      case THREAD_STATE_LAZILY_CREATED:
-        others++;
-        break;
-      case THREAD_STATE_STOPPED:
-      case THREAD_STATE_INIT:
-      case THREAD_STATE_ALIVE:
-        assert (0);
+      switch (cur->thrst[i].state)
+      {
+        case THREAD_STATE_ZERO:
+          break;
+        case THREAD_STATE_LAZILY_CREATED:
+          others++;
+          break;
+        case THREAD_STATE_STOPPED:
+        case THREAD_STATE_INIT:
+        case THREAD_STATE_ALIVE:
+          assert (0);
+      }
     }
   }
   ddsrt_mutex_unlock (&thread_states.lock);
   if (others == 0)
   {
+    struct thread_states_list *cur = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head);
+    ddsrt_atomic_stvoidp (&thread_states.thread_states_head, NULL);
+    while (cur)
+    {
+      struct thread_states_list *next = cur->next;
+      assert (ddsrt_atomic_ld32 (&cur->active) == 0);
+      ddsrt_free_aligned (cur);
+      cur = next;
+    }
     ddsrt_mutex_destroy (&thread_states.lock);
-    ddsrt_free_aligned (thread_states.ts);
-    thread_states.ts = NULL;
     return true;
   }
   else
@@ -164,15 +198,19 @@ bool thread_states_fini (void)
 
 static struct thread_state1 *find_thread_state (ddsrt_thread_t tid)
 {
-  if (thread_states.ts)
+  if (ddsrt_atomic_ldvoidp (&thread_states.thread_states_head))
   {
     ddsrt_mutex_lock (&thread_states.lock);
-    for (uint32_t i = 0; i < thread_states.nthreads; i++)
+    for (struct thread_states_list *cur = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head); cur; cur = cur->next)
     {
-      if (thread_states.ts[i].state > THREAD_STATE_INIT && ddsrt_thread_equal (thread_states.ts[i].tid, tid))
+      uint32_t active = ddsrt_atomic_ld32 (&cur->active);
+      for (uint32_t i = 0; active; i++, active >>= 1)
       {
-        ddsrt_mutex_unlock (&thread_states.lock);
-        return &thread_states.ts[i];
+        if ((active & 1) && cur->thrst[i].state > THREAD_STATE_INIT && ddsrt_thread_equal (cur->thrst[i].tid, tid))
+        {
+          ddsrt_mutex_unlock (&thread_states.lock);
+          return &cur->thrst[i];
+        }
       }
     }
     ddsrt_mutex_unlock (&thread_states.lock);
@@ -255,19 +293,38 @@ const struct ddsi_config_thread_properties_listelem *lookup_thread_properties (c
   return e;
 }
 
-static struct thread_state1 *init_thread_state (const char *tname, const struct ddsi_domaingv *gv, enum thread_state state)
+static struct thread_state1 *claim_thread_state (struct thread_states_list *cur)
 {
+  const uint32_t active = ddsrt_atomic_ld32 (&cur->active);
   uint32_t i;
-  for (i = 0; i < thread_states.nthreads; i++)
-    if (thread_states.ts[i].state == THREAD_STATE_ZERO)
-      break;
-  if (i == thread_states.nthreads)
-  {
-    DDS_FATAL ("create_thread: %s: no free slot\n", tname ? tname : "(anon)");
+  if (active == UINT32_MAX)
     return NULL;
+  for (i = 0; active & (1u << i); i++)
+    ;
+  ddsrt_atomic_or32 (&cur->active, 1u << i);
+  return &cur->thrst[i];
+}
+
+static void release_thread_state (struct thread_state1 *ts1)
+{
+  /* the indices of the slots in a segment start at a multiple of THREAD_STATE_BATCH */
+  ts1->state = THREAD_STATE_ZERO;
+  ddsrt_atomic_and32 (&ts1->list->active, ~(1u << (ts1->idx % THREAD_STATE_BATCH)));
+}
+
+static struct thread_state1 *init_thread_state (const char *tname, const struct ddsi_domaingv *gv, enum thread_state state)
+{
+  struct thread_states_list *cur;
+  struct thread_state1 *ts1 = NULL;
+  for (cur = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head); cur && ts1 == NULL; cur = cur->next)
+    ts1 = claim_thread_state (cur);
+  if (ts1 == NULL)
+  {
+    cur = thread_states_grow ();
+    ts1 = claim_thread_state (cur);
   }
 
-  struct thread_state1 * const ts1 = &thread_states.ts[i];
+  assert (ts1->state == THREAD_STATE_ZERO);
   assert (vtime_asleep_p (ddsrt_atomic_ld32 (&ts1->vtime)));
   ddsrt_atomic_stvoidp (&ts1->gv, (struct ddsi_domaingv *) gv);
   (void) ddsrt_strlcpy (ts1->name, tname, sizeof (ts1->name));
@@ -303,7 +360,7 @@ static dds_return_t create_thread_int (struct thread_state1 **ts1_out, const str
 
   if (ddsrt_thread_create (&ts1->tid, name, &tattr, &create_thread_wrapper, ts1) != DDS_RETCODE_OK)
   {
-    ts1->state = THREAD_STATE_ZERO;
+    release_thread_state (ts1);
     DDS_FATAL ("create_thread: %s: ddsrt_thread_create failed\n", name);
     goto fatal;
   }
@@ -335,7 +392,7 @@ static void reap_thread_state (struct thread_state1 *ts1, bool in_thread_states_
     case THREAD_STATE_INIT:
     case THREAD_STATE_STOPPED:
     case THREAD_STATE_LAZILY_CREATED:
-      ts1->state = THREAD_STATE_ZERO;
+      release_thread_state (ts1);
       break;
     case THREAD_STATE_ZERO:
       // Trying to reap a deceased thread twice is not a good thing and it
@@ -385,17 +442,20 @@ dds_return_t join_thread (struct thread_state1 *ts1)
 
 void log_stack_traces (const struct ddsrt_log_cfg *logcfg, const struct ddsi_domaingv *gv)
 {
-  for (uint32_t i = 0; i < thread_states.nthreads; i++)
+  for (struct thread_states_list *cur = ddsrt_atomic_ldvoidp (&thread_states.thread_states_head); cur; cur = cur->next)
   {
-    struct thread_state1 * const ts1 = &thread_states.ts[i];
-    if (ts1->state > THREAD_STATE_INIT && (gv == NULL || ddsrt_atomic_ldvoidp (&ts1->gv) == gv))
+    uint32_t active = ddsrt_atomic_ld32 (&cur->active);
+    for (uint32_t i = 0; active; i++, active >>= 1)
     {
-      /* There's a race condition here that may cause us to call log_stacktrace with an invalid
-         thread id (or even with a thread id mapping to a newly created thread that isn't really
-         relevant in this context!) but this is an optional debug feature, so it's not worth the
-         bother to avoid it. */
-      log_stacktrace (logcfg, ts1->name, ts1->tid);
+      struct thread_state1 * const ts1 = &cur->thrst[i];
+      if ((active & 1) && ts1->state > THREAD_STATE_INIT && (gv == NULL || ddsrt_atomic_ldvoidp (&ts1->gv) == gv))
+      {
+        /* There's a race condition here that may cause us to call log_stacktrace with an invalid
+           thread id (or even with a thread id mapping to a newly created thread that isn't really
+           relevant in this context!) but this is an optional debug feature, so it's not worth the
+           bother to avoid it. */
+        log_stacktrace (logcfg, ts1->name, ts1->tid);
+      }
     }
   }
 }
-
@@ -37,6 +37,7 @@
 #include "dds/ddsi/ddsi_tkmap.h"
 #include "dds/ddsi/ddsi_serdata.h"
 #include "dds/ddsi/ddsi_sertype.h"
+#include "dds/ddsi/ddsi_cfilter.h"
 #include "dds/ddsi/ddsi_security_omg.h"
 
 #include "dds/ddsi/sysdeps.h"
@@ -323,7 +324,6 @@ struct nn_xmsg *writer_hbcontrol_piggyback (struct writer *wr, const struct whc_
   return msg;
 }
 
-#ifdef DDS_HAS_SECURITY
 struct nn_xmsg *writer_hbcontrol_p2p(struct writer *wr, const struct whc_state *whcst, int hbansreq, struct proxy_reader *prd)
 {
   struct ddsi_domaingv const * const gv = wr->e.gv;
@@ -355,7 +355,6 @@ struct nn_xmsg *writer_hbcontrol_p2p(struct writer *wr, const struct whc_state *
 
   return msg;
 }
-#endif
 
 void add_Heartbeat (struct nn_xmsg *msg, struct writer *wr, const struct whc_state *whcst, int hbansreq, int hbliveliness, ddsi_entityid_t dst, int issync)
 {
@@ -904,6 +903,38 @@ int enqueue_sample_wrlock_held (struct writer *wr, seqno_t seq, const struct dds
   return enqueued ? 0 : -1;
 }
 
+static void enqueue_sample_filtered_wrlock_held (struct writer *wr, seqno_t seq, const struct ddsi_plist *plist, struct ddsi_serdata *serdata)
+{
+  /* Readers with a content filter evaluated by the writer are not part of
+     the writer's address set: samples that pass the filter get sent to them
+     individually, preceded by a GAP covering those that were filtered out
+     since the previous one so the reader needn't request them */
+  struct entity_index * const gh = wr->e.gv->entity_index;
+  struct wr_prd_match *m;
+  ddsrt_avl_iter_t it;
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  for (m = ddsrt_avl_iter_first (&wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  {
+    struct proxy_reader *prd;
+    if (m->cfilter == NULL || !ddsi_cfilter_accepts (m->cfilter, serdata))
+      continue;
+    if ((prd = entidx_lookup_proxy_reader_guid (gh, &m->prd_guid)) == NULL)
+      continue;
+    if (m->is_reliable && m->last_seq < seq - 1)
+    {
+      struct nn_gap_info gi;
+      struct nn_xmsg *gap;
+      nn_gap_info_init (&gi);
+      gi.gapstart = m->last_seq + 1;
+      gi.gapend = seq;
+      if ((gap = nn_gap_info_create_gap (wr, prd, &gi)) != NULL)
+        qxev_msg (wr->evq, gap);
+    }
+    enqueue_sample_wrlock_held (wr, seq, plist, serdata, prd, 1);
+    m->last_seq = seq;
+  }
+}
+
 static int insert_sample_in_whc (struct writer *wr, seqno_t seq, struct ddsi_plist *plist, struct ddsi_serdata *serdata, struct ddsi_tkmap_instance *tk)
 {
   /* returns: < 0 on error, 0 if no need to insert in whc, > 0 if inserted */
@@ -1295,6 +1326,14 @@ static int write_sample_eot (struct thread_state1 * const ts1, struct nn_xpack *
       (Note that no network destination is very nearly the same as no
       matching proxy readers.  The exception is the SPDP writer.) */
     writer_update_seq_xmit (wr, seq);
+    if (wr->num_filtered_readers > 0)
+    {
+      /* Readers with a content filter aren't in the address set, but do
+         need the heartbeats to recover lost DATA and GAP messages */
+      enqueue_sample_filtered_wrlock_held (wr, seq, plist, serdata);
+      if (wr->heartbeat_xevent)
+        writer_hbcontrol_note_asyncwrite (wr, tnow);
+    }
     ddsrt_mutex_unlock (&wr->e.lock);
     if (plist != NULL)
     {
@@ -1304,6 +1343,8 @@ static int write_sample_eot (struct thread_state1 * const ts1, struct nn_xpack *
   }
   else
   {
+    if (wr->num_filtered_readers > 0)
+      enqueue_sample_filtered_wrlock_held (wr, seq, plist, serdata);
     /* Note the subtlety of enqueueing with the lock held but
        transmitting without holding the lock. Still working on
        cleaning that up. */
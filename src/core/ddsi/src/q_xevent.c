@@ -11,6 +11,7 @@
  */
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/heap.h"
@@ -63,9 +64,22 @@ enum xeventkind
   XEVK_CALLBACK
 };
 
+/* Timing wheel: XEVQ_WHEEL_LEVELS levels of XEVQ_WHEEL_SLOTS slots, an
+   event lives at the lowest level at which its tick and the current tick
+   of the wheel differ only in the bits indexing that level.  Events too far
+   in the future for the highest level go into the heap. */
+#define XEVQ_WHEEL_BITS 8
+#define XEVQ_WHEEL_SLOTS (1u << XEVQ_WHEEL_BITS)
+#define XEVQ_WHEEL_MASK (XEVQ_WHEEL_SLOTS - 1)
+#define XEVQ_WHEEL_LEVELS 4
+#define XEVQ_WHEEL_IN_HEAP XEVQ_WHEEL_LEVELS
+
 struct xevent
 {
   ddsrt_fibheap_node_t heapnode;
+  struct xevent *wheel_next, *wheel_prev;
+  uint8_t wheel_level; /* XEVQ_WHEEL_IN_HEAP if in the heap */
+  uint8_t wheel_slot;
   struct xeventq *evq;
   ddsrt_mtime_t tsched;
   enum xeventkind kind;
@@ -140,8 +154,16 @@ struct xevent_nt
   } u;
 };
 
+struct xevent_wheel {
+  int64_t granularity; /* ns per tick */
+  uint64_t now; /* current tick, events for earlier ticks are in slot "now" of level 0 */
+  uint64_t occupied[XEVQ_WHEEL_LEVELS][XEVQ_WHEEL_SLOTS / 64];
+  struct xevent *slots[XEVQ_WHEEL_LEVELS][XEVQ_WHEEL_SLOTS];
+};
+
 struct xeventq {
-  ddsrt_fibheap_t xevents;
+  ddsrt_fibheap_t xevents; /* all timed events, or only those beyond the wheel's range */
+  struct xevent_wheel *wheel; /* NULL if Internal/EventQueue = heap */
   ddsrt_avl_tree_t msg_xevents;
   struct xevent_nt *non_timed_xmit_list_oldest;
   struct xevent_nt *non_timed_xmit_list_newest; /* undefined if ..._oldest == NULL */
@@ -316,6 +338,235 @@ static int nontimed_xevent_in_queue (struct xeventq *evq, struct xevent_nt *ev)
 }
 #endif
 
+static uint64_t wheel_tick (const struct xevent_wheel *w, ddsrt_mtime_t t)
+{
+  /* round up, so an event never fires before its scheduled time */
+  if (t.v <= 0)
+    return 0;
+  return (uint64_t) (t.v / w->granularity) + ((t.v % w->granularity) != 0);
+}
+
+static int wheel_first_occupied (const uint64_t *occ, uint32_t from)
+{
+  /* index of first occupied slot >= from, or -1 */
+  for (uint32_t i = from / 64; i < XEVQ_WHEEL_SLOTS / 64; i++)
+  {
+    uint64_t m = occ[i];
+    if (i == from / 64)
+      m &= ~(uint64_t) 0 << (from % 64);
+    if (m != 0)
+    {
+      int b = 0;
+#if defined __GNUC__
+      b = __builtin_ctzll (m);
+#else
+      while (!(m & 1)) { m >>= 1; b++; }
+#endif
+      return (int) (64 * i) + b;
+    }
+  }
+  return -1;
+}
+
+static uint32_t wheel_position (const struct xevent_wheel *w, ddsrt_mtime_t tsched, uint32_t *slot)
+{
+  /* returns the level, XEVQ_WHEEL_IN_HEAP if beyond the range of the wheel */
+  uint64_t t = wheel_tick (w, tsched);
+  uint32_t lvl;
+  if (t < w->now)
+    t = w->now;
+  for (lvl = 0; lvl < XEVQ_WHEEL_LEVELS; lvl++)
+    if ((t >> (XEVQ_WHEEL_BITS * (lvl + 1))) == (w->now >> (XEVQ_WHEEL_BITS * (lvl + 1))))
+      break;
+  *slot = (lvl == XEVQ_WHEEL_IN_HEAP) ? 0 : (uint32_t) (t >> (XEVQ_WHEEL_BITS * lvl)) & XEVQ_WHEEL_MASK;
+  return lvl;
+}
+
+static void wheel_link (struct xeventq *evq, struct xevent *ev, uint32_t lvl, uint32_t slot)
+{
+  struct xevent_wheel * const w = evq->wheel;
+  ev->wheel_level = (uint8_t) lvl;
+  if (lvl == XEVQ_WHEEL_IN_HEAP)
+  {
+    ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+    return;
+  }
+  ev->wheel_slot = (uint8_t) slot;
+  ev->wheel_prev = NULL;
+  if ((ev->wheel_next = w->slots[lvl][slot]) != NULL)
+    ev->wheel_next->wheel_prev = ev;
+  w->slots[lvl][slot] = ev;
+  w->occupied[lvl][slot / 64] |= (uint64_t) 1 << (slot % 64);
+}
+
+static void wheel_insert (struct xeventq *evq, struct xevent *ev)
+{
+  uint32_t lvl, slot;
+  lvl = wheel_position (evq->wheel, ev->tsched, &slot);
+  wheel_link (evq, ev, lvl, slot);
+}
+
+static void wheel_remove (struct xeventq *evq, struct xevent *ev)
+{
+  struct xevent_wheel * const w = evq->wheel;
+  const uint32_t lvl = ev->wheel_level, slot = ev->wheel_slot;
+  if (lvl == XEVQ_WHEEL_IN_HEAP)
+  {
+    ddsrt_fibheap_delete (&evq_xevents_fhdef, &evq->xevents, ev);
+    return;
+  }
+  if (ev->wheel_next)
+    ev->wheel_next->wheel_prev = ev->wheel_prev;
+  if (ev->wheel_prev)
+    ev->wheel_prev->wheel_next = ev->wheel_next;
+  else if ((w->slots[lvl][slot] = ev->wheel_next) == NULL)
+    w->occupied[lvl][slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+}
+
+static uint64_t wheel_next_tick (const struct xevent_wheel *w, bool include_now)
+{
+  /* Lower bound on the tick of the first event in the wheel (exact if it is in
+     level 0): the start of the first occupied slot. By construction, the slot
+     at the current position is empty for all levels but 0. */
+  for (uint32_t lvl = 0; lvl < XEVQ_WHEEL_LEVELS; lvl++)
+  {
+    const uint32_t shift = XEVQ_WHEEL_BITS * lvl;
+    const uint32_t cur = (uint32_t) (w->now >> shift) & XEVQ_WHEEL_MASK;
+    const uint32_t from = (lvl == 0 && include_now) ? cur : cur + 1;
+    int idx;
+    if (from < XEVQ_WHEEL_SLOTS && (idx = wheel_first_occupied (w->occupied[lvl], from)) >= 0)
+    {
+      const uint64_t base = w->now & ~(((uint64_t) 1 << (shift + XEVQ_WHEEL_BITS)) - 1);
+      return base | ((uint64_t) idx << shift);
+    }
+  }
+  return UINT64_MAX;
+}
+
+static void wheel_cascade (struct xeventq *evq)
+{
+  /* Moves the events in the slots that start at the current tick down a level
+     (or more); higher levels first, as those may move events into a lower
+     level slot that needs to be cascaded as well */
+  struct xevent_wheel * const w = evq->wheel;
+  for (uint32_t lvl = XEVQ_WHEEL_LEVELS - 1; lvl > 0; lvl--)
+  {
+    const uint32_t shift = XEVQ_WHEEL_BITS * lvl;
+    if ((w->now & (((uint64_t) 1 << shift) - 1)) != 0)
+      continue;
+    const uint32_t slot = (uint32_t) (w->now >> shift) & XEVQ_WHEEL_MASK;
+    struct xevent *ev = w->slots[lvl][slot];
+    w->slots[lvl][slot] = NULL;
+    w->occupied[lvl][slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+    while (ev)
+    {
+      struct xevent *next = ev->wheel_next;
+      wheel_insert (evq, ev);
+      assert (ev->wheel_level < lvl);
+      ev = next;
+    }
+  }
+}
+
+static struct xevent *wheel_extract_due (struct xeventq *evq, ddsrt_mtime_t tnow)
+{
+  struct xevent_wheel * const w = evq->wheel;
+  const uint64_t target = (tnow.v <= 0) ? 0 : (uint64_t) (tnow.v / w->granularity);
+  struct xevent *ev;
+  while ((ev = w->slots[0][w->now & XEVQ_WHEEL_MASK]) == NULL)
+  {
+    uint64_t next;
+    if (w->now >= target)
+      return NULL;
+    /* skip empty slots, but never beyond tnow: that would make events
+       scheduled later for a time before the new "now" fire early */
+    if ((next = wheel_next_tick (w, false)) > target)
+    {
+      w->now = target;
+      return NULL;
+    }
+    w->now = next;
+    wheel_cascade (evq);
+  }
+  wheel_remove (evq, ev);
+  return ev;
+}
+
+static void xeventq_tq_insert (struct xeventq *evq, struct xevent *ev)
+{
+  ASSERT_MUTEX_HELD (&evq->lock);
+  assert (ev->tsched.v != DDS_NEVER);
+  if (evq->wheel)
+    wheel_insert (evq, ev);
+  else
+    ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+}
+
+static void xeventq_tq_remove (struct xeventq *evq, struct xevent *ev)
+{
+  ASSERT_MUTEX_HELD (&evq->lock);
+  if (evq->wheel)
+    wheel_remove (evq, ev);
+  else
+    ddsrt_fibheap_delete (&evq_xevents_fhdef, &evq->xevents, ev);
+}
+
+static void xeventq_tq_decrease (struct xeventq *evq, struct xevent *ev)
+{
+  /* ev->tsched has been lowered while it was in the queue */
+  ASSERT_MUTEX_HELD (&evq->lock);
+  if (evq->wheel == NULL)
+    ddsrt_fibheap_decrease_key (&evq_xevents_fhdef, &evq->xevents, ev);
+  else if (ev->wheel_level == XEVQ_WHEEL_IN_HEAP)
+  {
+    /* may well fit in the wheel now */
+    ddsrt_fibheap_delete (&evq_xevents_fhdef, &evq->xevents, ev);
+    wheel_insert (evq, ev);
+  }
+  else
+  {
+    /* it often stays in the same slot, and then there is nothing to do */
+    uint32_t lvl, slot;
+    lvl = wheel_position (evq->wheel, ev->tsched, &slot);
+    if (lvl != ev->wheel_level || slot != ev->wheel_slot)
+    {
+      wheel_remove (evq, ev);
+      wheel_link (evq, ev, lvl, slot);
+    }
+  }
+}
+
+static struct xevent *xeventq_tq_extract_due (struct xeventq *evq, ddsrt_mtime_t tnow)
+{
+  /* returns an event scheduled at or before tnow, NULL if there is none */
+  struct xevent *min;
+  ASSERT_MUTEX_HELD (&evq->lock);
+  if ((min = ddsrt_fibheap_min (&evq_xevents_fhdef, &evq->xevents)) != NULL && min->tsched.v <= tnow.v)
+    return ddsrt_fibheap_extract_min (&evq_xevents_fhdef, &evq->xevents);
+  else if (evq->wheel)
+    return wheel_extract_due (evq, tnow);
+  else
+    return NULL;
+}
+
+static struct xevent *xeventq_tq_extract_any (struct xeventq *evq)
+{
+  struct xevent *ev;
+  if ((ev = ddsrt_fibheap_extract_min (&evq_xevents_fhdef, &evq->xevents)) != NULL || evq->wheel == NULL)
+    return ev;
+  for (uint32_t lvl = 0; lvl < XEVQ_WHEEL_LEVELS; lvl++)
+  {
+    int idx;
+    if ((idx = wheel_first_occupied (evq->wheel->occupied[lvl], 0)) >= 0)
+    {
+      ev = evq->wheel->slots[lvl][idx];
+      wheel_remove (evq, ev);
+      return ev;
+    }
+  }
+  return NULL;
+}
+
 static void free_xevent (struct xeventq *evq, struct xevent *ev)
 {
   (void) evq;
@@ -346,12 +597,12 @@ void delete_xevent (struct xevent *ev)
   if (ev->tsched.v != DDS_NEVER)
   {
     ev->tsched.v = TSCHED_DELETE;
-    ddsrt_fibheap_decrease_key (&evq_xevents_fhdef, &evq->xevents, ev);
+    xeventq_tq_decrease (evq, ev);
   }
   else
   {
     ev->tsched.v = TSCHED_DELETE;
-    ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+    xeventq_tq_insert (evq, ev);
   }
   /* TSCHED_DELETE is absolute minimum time, so chances are we need to
      wake up the thread.  The superfluous signal is harmless. */
@@ -370,7 +621,7 @@ void delete_xevent_callback (struct xevent *ev)
     if (ev->tsched.v != DDS_NEVER)
     {
       assert (ev->tsched.v != TSCHED_DELETE);
-      ddsrt_fibheap_delete (&evq_xevents_fhdef, &evq->xevents, ev);
+      xeventq_tq_remove (evq, ev);
       ev->tsched.v = DDS_NEVER;
     }
     if (ev->u.callback.executing)
@@ -402,12 +653,12 @@ int resched_xevent_if_earlier (struct xevent *ev, ddsrt_mtime_t tsched)
     if (ev->tsched.v != DDS_NEVER)
     {
       ev->tsched = tsched;
-      ddsrt_fibheap_decrease_key (&evq_xevents_fhdef, &evq->xevents, ev);
+      xeventq_tq_decrease (evq, ev);
     }
     else
     {
       ev->tsched = tsched;
-      ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+      xeventq_tq_insert (evq, ev);
     }
     is_resched = 1;
     if (tsched.v < tbefore.v)
@@ -469,9 +720,19 @@ static struct xevent_nt *qxev_common_nt (struct xeventq *evq, enum xeventkind_nt
 
 static ddsrt_mtime_t earliest_in_xeventq (struct xeventq *evq)
 {
+  /* with the timing wheel, this may be earlier than the first event, but
+     never later */
   struct xevent *min;
+  ddsrt_mtime_t t;
   ASSERT_MUTEX_HELD (&evq->lock);
-  return ((min = ddsrt_fibheap_min (&evq_xevents_fhdef, &evq->xevents)) != NULL) ? min->tsched : DDSRT_MTIME_NEVER;
+  t = ((min = ddsrt_fibheap_min (&evq_xevents_fhdef, &evq->xevents)) != NULL) ? min->tsched : DDSRT_MTIME_NEVER;
+  if (evq->wheel)
+  {
+    const uint64_t tick = wheel_next_tick (evq->wheel, true);
+    if (tick < (uint64_t) INT64_MAX / (uint64_t) evq->wheel->granularity && (int64_t) tick * evq->wheel->granularity < t.v)
+      t.v = (int64_t) tick * evq->wheel->granularity;
+  }
+  return t;
 }
 
 static void qxev_insert (struct xevent *ev)
@@ -483,7 +744,7 @@ static void qxev_insert (struct xevent *ev)
   if (ev->tsched.v != DDS_NEVER)
   {
     ddsrt_mtime_t tbefore = earliest_in_xeventq (evq);
-    ddsrt_fibheap_insert (&evq_xevents_fhdef, &evq->xevents, ev);
+    xeventq_tq_insert (evq, ev);
     if (ev->tsched.v < tbefore.v)
       ddsrt_cond_broadcast (&evq->cond);
   }
@@ -510,6 +771,16 @@ struct xeventq * xeventq_new (struct ddsi_domaingv *gv, size_t max_queued_rexmit
   if (max_queued_rexmit_bytes > 2147483648u)
     max_queued_rexmit_bytes = 2147483648u;
   ddsrt_fibheap_init (&evq_xevents_fhdef, &evq->xevents);
+  if (gv->config.xevent_queue_kind != DDSI_XEVQ_WHEEL)
+    evq->wheel = NULL;
+  else
+  {
+    evq->wheel = ddsrt_malloc (sizeof (*evq->wheel));
+    memset (evq->wheel, 0, sizeof (*evq->wheel));
+    /* ScheduleTimeRounding already rounds up to a multiple of it */
+    evq->wheel->granularity = (gv->config.schedule_time_rounding > 0) ? gv->config.schedule_time_rounding : DDS_MSECS (1);
+    evq->wheel->now = (uint64_t) ddsrt_time_monotonic ().v / (uint64_t) evq->wheel->granularity;
+  }
   ddsrt_avl_init (&msg_xevents_treedef, &evq->msg_xevents);
   evq->non_timed_xmit_list_oldest = NULL;
   evq->non_timed_xmit_list_newest = NULL;
@@ -566,8 +837,9 @@ void xeventq_free (struct xeventq *evq)
 {
   struct xevent *ev;
   assert (evq->ts == NULL);
-  while ((ev = ddsrt_fibheap_extract_min (&evq_xevents_fhdef, &evq->xevents)) != NULL)
+  while ((ev = xeventq_tq_extract_any (evq)) != NULL)
     free_xevent (evq, ev);
+  ddsrt_free (evq->wheel);
 
   {
     struct nn_xpack *xp = nn_xpack_new (evq->gv, evq->auxiliary_bandwidth_limit, false);
@@ -706,6 +978,33 @@ static void send_heartbeat_to_all_readers (struct nn_xpack *xp, struct xevent *e
 }
 #endif
 
+static struct nn_xmsg **make_heartbeats_for_filtered_readers (struct writer *wr, const struct whc_state *whcst, int hbansreq, uint32_t *nmsgs)
+{
+  /* Readers with a content filter evaluated by the writer aren't in the
+     writer's address set, so they don't get the regular heartbeats and
+     need one of their own for as long as they haven't acknowledged all */
+  struct nn_xmsg **msgs = ddsrt_malloc (wr->num_filtered_readers * sizeof (*msgs));
+  struct wr_prd_match *m;
+  ddsrt_avl_iter_t it;
+  ASSERT_MUTEX_HELD (&wr->e.lock);
+  *nmsgs = 0;
+  for (m = ddsrt_avl_iter_first (&wr_readers_treedef, &wr->readers, &it); m; m = ddsrt_avl_iter_next (&it))
+  {
+    struct proxy_reader *prd;
+    struct nn_xmsg *msg;
+    if (m->cfilter == NULL || !m->is_reliable || m->seq >= wr->seq)
+      continue;
+    if ((prd = entidx_lookup_proxy_reader_guid (wr->e.gv->entity_index, &m->prd_guid)) == NULL)
+      continue;
+    if ((msg = writer_hbcontrol_p2p (wr, whcst, hbansreq, prd)) != NULL)
+    {
+      assert (*nmsgs < wr->num_filtered_readers);
+      msgs[(*nmsgs)++] = msg;
+    }
+  }
+  return msgs;
+}
+
 static void handle_xevk_heartbeat (struct nn_xpack *xp, struct xevent *ev, ddsrt_mtime_t tnow)
 {
   struct ddsi_domaingv const * const gv = ev->evq->gv;
@@ -714,6 +1013,8 @@ static void handle_xevk_heartbeat (struct nn_xpack *xp, struct xevent *ev, ddsrt
   ddsrt_mtime_t t_next;
   int hbansreq = 0;
   struct whc_state whcst;
+  struct nn_xmsg **p2p_msgs = NULL;
+  uint32_t n_p2p_msgs = 0;
 
   if ((wr = entidx_lookup_writer_guid (gv->entity_index, &ev->u.heartbeat.wr_guid)) == NULL)
   {
@@ -748,6 +1049,8 @@ static void handle_xevk_heartbeat (struct nn_xpack *xp, struct xevent *ev, ddsrt
   {
     hbansreq = writer_hbcontrol_ack_required (wr, &whcst, tnow);
     msg = writer_hbcontrol_create_heartbeat (wr, &whcst, tnow, hbansreq, 0);
+    if (wr->num_filtered_readers > 0)
+      p2p_msgs = make_heartbeats_for_filtered_readers (wr, &whcst, hbansreq, &n_p2p_msgs);
     t_next.v = tnow.v + writer_hbcontrol_intv (wr, &whcst, tnow);
   }
 
@@ -778,6 +1081,14 @@ static void handle_xevk_heartbeat (struct nn_xpack *xp, struct xevent *ev, ddsrt
       nn_xmsg_free (msg);
     }
   }
+  for (uint32_t i = 0; i < n_p2p_msgs; i++)
+  {
+    if (!wr->test_suppress_heartbeat)
+      nn_xpack_addmsg (xp, p2p_msgs[i], 0);
+    else
+      nn_xmsg_free (p2p_msgs[i]);
+  }
+  ddsrt_free (p2p_msgs);
 }
 
 static dds_duration_t preemptive_acknack_interval (const struct pwr_rd_match *rwn)
@@ -1193,9 +1504,9 @@ static void handle_xevents (struct thread_state1 * const ts1, struct xeventq *xe
 
   while (xeventsToProcess)
   {
-    while (earliest_in_xeventq(xevq).v <= tnow.v)
+    struct xevent *xev;
+    while ((xev = xeventq_tq_extract_due (xevq, tnow)) != NULL)
     {
-      struct xevent *xev = ddsrt_fibheap_extract_min (&evq_xevents_fhdef, &xevq->xevents);
       if (xev->tsched.v == TSCHED_DELETE)
       {
         free_xevent (xevq, xev);
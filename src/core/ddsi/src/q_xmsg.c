@@ -189,6 +189,11 @@ struct nn_xpack
 #endif /* DDS_HAS_NETWORK_PARTITIONS */
 #ifdef DDS_HAS_SECURITY
   nn_msg_sec_info_t sec_info;
+  /* RTPS-protected message, encoded lazily on the first send to a
+     destination and shared by all destinations (if not destination-specific) */
+  unsigned char *sec_encoded;
+  size_t sec_encoded_len;
+  bool sec_encode_done;
 #endif
 };
 
@@ -1128,6 +1133,10 @@ static void nn_xpack_reinit (struct nn_xpack *xp)
   xp->maxdelay = DDS_INFINITY;
 #ifdef DDS_HAS_SECURITY
   xp->sec_info.use_rtps_encoding = 0;
+  ddsrt_free (xp->sec_encoded);
+  xp->sec_encoded = NULL;
+  xp->sec_encoded_len = 0;
+  xp->sec_encode_done = false;
 #endif
 #ifdef DDS_HAS_NETWORK_PARTITIONS
   xp->encoderId = 0;
@@ -1178,6 +1187,28 @@ void nn_xpack_free (struct nn_xpack *xp)
   ddsrt_free (xp);
 }
 
+#ifdef DDS_HAS_SECURITY
+static bool nn_xpack_sec_dst_specific (const struct nn_xpack *xp)
+{
+  return (xp->dstmode == NN_XMSG_DST_ONE || xp->dstmode == NN_XMSG_DST_ALL_UC);
+}
+
+static bool nn_xpack_sec_encode_once (struct nn_xpack *xp, bool stream)
+{
+  /* The encoded message depends only on the contents of the xpack and on
+     whether the transport is stream-based, which is the same for all
+     connections of a domain, so a single encoding serves all destinations */
+  assert (xp->sec_info.use_rtps_encoding && !nn_xpack_sec_dst_specific (xp));
+  if (!xp->sec_encode_done)
+  {
+    xp->sec_encode_done = true;
+    if (!secure_conn_encode (xp->gv, xp->niov, xp->iov, stream, false, &xp->sec_info, &xp->sec_encoded, &xp->sec_encoded_len))
+      xp->sec_encoded = NULL;
+  }
+  return xp->sec_encoded != NULL;
+}
+#endif
+
 static ssize_t nn_xpack_send_rtps(struct nn_xpack * xp, const ddsi_xlocator_t *loc)
 {
   ssize_t ret = -1;
@@ -1186,17 +1217,24 @@ static ssize_t nn_xpack_send_rtps(struct nn_xpack * xp, const ddsi_xlocator_t *l
   /* Only encode when needed. */
   if (xp->sec_info.use_rtps_encoding)
   {
-    ret = secure_conn_write(
-                      xp->gv,
-                      loc->conn,
-                      &loc->c,
-                      xp->niov,
-                      xp->iov,
-                      xp->call_flags,
-                      &(xp->msg_len),
-                      (xp->dstmode == NN_XMSG_DST_ONE || xp->dstmode == NN_XMSG_DST_ALL_UC),
-                      &(xp->sec_info),
-                      ddsi_conn_write);
+    if (nn_xpack_sec_dst_specific (xp))
+    {
+      ret = secure_conn_write(
+                        xp->gv,
+                        loc->conn,
+                        &loc->c,
+                        xp->niov,
+                        xp->iov,
+                        xp->call_flags,
+                        &(xp->msg_len),
+                        true,
+                        &(xp->sec_info),
+                        ddsi_conn_write);
+    }
+    else if (nn_xpack_sec_encode_once (xp, loc->conn->m_stream))
+    {
+      ret = secure_conn_write_encoded (loc->conn, &loc->c, xp->sec_encoded, xp->sec_encoded_len, xp->call_flags, &(xp->msg_len), ddsi_conn_write);
+    }
   }
   else
 #endif /* DDS_HAS_SECURITY */
@@ -1277,6 +1315,102 @@ static void nn_xpack_send1v (const ddsi_xlocator_t *loc, void * varg)
   (void) nn_xpack_send1 (loc, varg);
 }
 
+/* Sending the same packet to many destinations: destinations are collected
+   in a batch as long as they use the same connection, and the batch is then
+   handed to the transport in one go.  Only used for plain sends (no dropping
+   of packets for testing, no RTPS message encoding, ...) on connections that
+   support it, anything else goes through nn_xpack_send1. */
+struct nn_xpack_dstbatch {
+  struct nn_xpack *xp;
+  ddsi_tran_conn_t conn;
+  size_t ndst;
+  ddsi_locator_t dst[DDSI_TRAN_WRITE_BATCH_MAX];
+};
+
+static bool nn_xpack_may_batch (const struct nn_xpack *xp)
+{
+  struct ddsi_domaingv const * const gv = xp->gv;
+  if (gv->mute || gv->config.xmit_lossiness > 0)
+    return false;
+#ifdef DDS_HAS_SECURITY
+  if (xp->sec_info.use_rtps_encoding && nn_xpack_sec_dst_specific (xp))
+    return false;
+#endif
+  return true;
+}
+
+static void nn_xpack_dstbatch_flush (struct nn_xpack_dstbatch *b)
+{
+  struct nn_xpack * const xp = b->xp;
+  struct ddsi_domaingv * const gv = xp->gv;
+  size_t niov = xp->niov;
+  const ddsrt_iovec_t *iov = xp->iov;
+  ssize_t nsent;
+  if (b->ndst == 0)
+    return;
+#ifdef DDS_HAS_SECURITY
+  ddsrt_iovec_t sec_iov;
+  if (xp->sec_info.use_rtps_encoding)
+  {
+    assert (!b->conn->m_stream);
+    if (!nn_xpack_sec_encode_once (xp, false))
+    {
+      xp->call_flags = 0;
+      b->ndst = 0;
+      return;
+    }
+    sec_iov.iov_base = xp->sec_encoded;
+    sec_iov.iov_len = (ddsrt_iov_len_t) xp->sec_encoded_len;
+    xp->msg_len.length = (uint32_t) xp->sec_encoded_len;
+    niov = 1;
+    iov = &sec_iov;
+  }
+#endif
+  if (b->ndst == 1)
+    nsent = (ddsi_conn_write (b->conn, &b->dst[0], niov, iov, xp->call_flags) < 0) ? -1 : 1;
+  else
+  {
+    nsent = ddsi_conn_write_batch (b->conn, b->ndst, b->dst, niov, iov, xp->call_flags);
+    ddsrt_atomic_inc64 (&gv->xmit_batch_calls);
+    if (nsent > 0)
+      ddsrt_atomic_add64 (&gv->xmit_batch_msgs, (uint64_t) nsent);
+  }
+  xp->call_flags = 0;
+#ifdef DDS_HAS_BANDWIDTH_LIMITING
+  if (nsent > 0)
+  {
+    nn_bw_limit_sleep_if_needed (gv, &xp->limiter, nsent * (ssize_t) xp->msg_len.length);
+  }
+#endif
+  b->ndst = 0;
+}
+
+static void nn_xpack_dstbatch_add (const ddsi_xlocator_t *loc, void *varg)
+{
+  struct nn_xpack_dstbatch * const b = varg;
+  struct ddsi_domaingv const * const gv = b->xp->gv;
+#ifdef DDS_HAS_SHM
+  if (!ddsi_conn_supports_write_batch (loc->conn) || loc->c.kind == NN_LOCATOR_KIND_SHEM)
+#else
+  if (!ddsi_conn_supports_write_batch (loc->conn))
+#endif
+  {
+    (void) nn_xpack_send1 (loc, b->xp);
+    return;
+  }
+  if (gv->logconfig.c.mask & DDS_LC_TRACE)
+  {
+    char buf[DDSI_LOCSTRLEN];
+    GVTRACE (" %s", ddsi_xlocator_to_string (buf, sizeof(buf), loc));
+  }
+  if (b->ndst > 0 && b->conn != loc->conn)
+    nn_xpack_dstbatch_flush (b);
+  b->conn = loc->conn;
+  b->dst[b->ndst++] = loc->c;
+  if (b->ndst == DDSI_TRAN_WRITE_BATCH_MAX)
+    nn_xpack_dstbatch_flush (b);
+}
+
 static void nn_xpack_send_real (struct nn_xpack *xp)
 {
   struct ddsi_domaingv const * const gv = xp->gv;
@@ -1315,7 +1449,17 @@ static void nn_xpack_send_real (struct nn_xpack *xp)
     calls = 0;
     if (xp->dstaddr.all.as)
     {
-      calls = addrset_forall_count (xp->dstaddr.all.as, nn_xpack_send1v, xp);
+      if (!nn_xpack_may_batch (xp))
+        calls = addrset_forall_count (xp->dstaddr.all.as, nn_xpack_send1v, xp);
+      else
+      {
+        struct nn_xpack_dstbatch b;
+        b.xp = xp;
+        b.conn = NULL;
+        b.ndst = 0;
+        calls = addrset_forall_count (xp->dstaddr.all.as, nn_xpack_dstbatch_add, &b);
+        nn_xpack_dstbatch_flush (&b);
+      }
       unref_addrset (xp->dstaddr.all.as);
     }
 
@@ -0,0 +1,328 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stddef.h>
+#include <string.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/endian.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_serdata_default.h"
+#include "dds/ddsi/q_radmin.h"
+#include "dds/ddsi/q_rtps.h"
+#include "dds/ddsc/dds_opcodes.h"
+#include "CUnit/Test.h"
+
+/* Received samples at least as large as the threshold are left in the
+   receive buffers until first used, but only as long as the total size of
+   the receive buffers kept alive that way stays within the limit */
+#define RBUF_SIZE 65536
+#define MAX_RMSG_SIZE 8192
+#define THRESHOLD 1000
+
+static const uint32_t seq_octet_ops[] = {
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_1BY, 0,
+  DDS_OP_RTS
+};
+
+/* keyed type with the key fields following a large payload, so that the keys
+   are in a later fragment and the key string can straddle a fragment boundary */
+struct keyed {
+  dds_sequence_t data;
+  int32_t id;
+  char *name;
+};
+
+static const uint32_t keyed_ops[] = {
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_1BY, offsetof (struct keyed, data),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_KEY, offsetof (struct keyed, id),
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (struct keyed, name),
+  DDS_OP_RTS
+};
+
+static const uint32_t keyed_keys[] = { 2, 4 };
+
+static struct ddsi_domaingv gv;
+static struct ddsi_sertype_default *type, *keyed_type;
+static struct nn_rbufpool *rbp[2];
+
+static struct ddsi_sertype_default *make_type (const char *name, const struct ddsi_serdata_ops *serdata_ops, uint32_t size, uint32_t nops, const uint32_t *ops, uint32_t nkeys, const uint32_t *keys)
+{
+  struct ddsi_sertype_default *tp = ddsrt_malloc (sizeof (*tp));
+  memset (tp, 0, sizeof (*tp));
+  ddsi_sertype_init (&tp->c, name, &ddsi_sertype_ops_default, serdata_ops, nkeys == 0);
+  tp->native_encoding_identifier = (DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN ? CDR_LE : CDR_BE);
+  tp->serpool = gv.serpool;
+  tp->type.size = size;
+  tp->type.align = sizeof (void *);
+  tp->type.flagset = DDS_TOPIC_NO_OPTIMIZE;
+  tp->type.keys.nkeys = nkeys;
+  tp->type.keys.keys = (nkeys == 0) ? NULL : ddsrt_memdup (keys, nkeys * sizeof (*keys));
+  tp->type.ops.nops = nops;
+  tp->type.ops.ops = ddsrt_memdup (ops, nops * sizeof (*ops));
+  ddsrt_atomic_stvoidp (&tp->c.gv, &gv);
+  return tp;
+}
+
+static void setup (uint32_t max_pinned)
+{
+  memset (&gv, 0, sizeof (gv));
+  gv.config.rbuf_ref_threshold = THRESHOLD;
+  gv.config.rbuf_ref_max_pinned = max_pinned;
+  ddsrt_atomic_st32 (&gv.rbuf_ref_pinned, 0);
+  gv.serpool = ddsi_serdatapool_new ();
+
+  type = make_type ("pinned", &ddsi_serdata_ops_cdr_nokey, sizeof (dds_sequence_t),
+                    (uint32_t) (sizeof (seq_octet_ops) / sizeof (seq_octet_ops[0])), seq_octet_ops, 0, NULL);
+  keyed_type = make_type ("pinned_keyed", &ddsi_serdata_ops_cdr, sizeof (struct keyed),
+                          (uint32_t) (sizeof (keyed_ops) / sizeof (keyed_ops[0])), keyed_ops,
+                          (uint32_t) (sizeof (keyed_keys) / sizeof (keyed_keys[0])), keyed_keys);
+
+  /* distinct pools so that samples can be put in distinct receive buffers */
+  for (int i = 0; i < 2; i++)
+    rbp[i] = nn_rbufpool_new (&gv.logconfig, RBUF_SIZE, MAX_RMSG_SIZE);
+}
+
+static void teardown (void)
+{
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  for (int i = 0; i < 2; i++)
+    nn_rbufpool_free (rbp[i]);
+  ddsi_sertype_unref (&type->c);
+  ddsi_sertype_unref (&keyed_type->c);
+  ddsi_serdatapool_free (gv.serpool);
+}
+
+/* "receives" the serialized data in blob as fragments [bounds[i],bounds[i+1])
+   for 0 <= i < nfrags, each in a separate message in pool.  Like the
+   defragmenter, it holds a reference to each message while collecting the
+   fragments and commits them as it goes, leaving only the references held by
+   the serdata once it has been constructed */
+static struct ddsi_serdata *receive_frags (struct nn_rbufpool *pool, const struct ddsi_sertype_default *tp, const unsigned char *blob, uint32_t nfrags, const uint32_t *bounds)
+{
+  struct nn_rmsg *rmsgs[8];
+  struct nn_rdata *fragchain = NULL, **nextp = &fragchain;
+  CU_ASSERT_FATAL (nfrags <= sizeof (rmsgs) / sizeof (rmsgs[0]));
+  for (uint32_t i = 0; i < nfrags; i++)
+  {
+    const uint32_t len = bounds[i + 1] - bounds[i];
+    CU_ASSERT_FATAL (len <= MAX_RMSG_SIZE);
+    struct nn_rmsg *rmsg = nn_rmsg_new (pool);
+    CU_ASSERT_FATAL (rmsg != NULL);
+    memcpy (NN_RMSG_PAYLOAD (rmsg), blob + bounds[i], len);
+    nn_rmsg_setsize (rmsg, len);
+    struct nn_rdata *rdata = nn_rdata_new (rmsg, bounds[i], bounds[i + 1], 0, 0, 0);
+    CU_ASSERT_FATAL (rdata != NULL);
+    *nextp = rdata;
+    nextp = &rdata->nextfrag;
+    nn_rmsg_addref (rmsg);
+    nn_rmsg_commit (rmsg);
+    rmsgs[i] = rmsg;
+  }
+  struct ddsi_serdata *sd = ddsi_serdata_from_ser (&tp->c, SDK_DATA, fragchain, bounds[nfrags]);
+  for (uint32_t i = 0; i < nfrags; i++)
+    nn_rmsg_unref (rmsgs[i]);
+  CU_ASSERT_FATAL (sd != NULL);
+  return sd;
+}
+
+/* serialized sequence of n octets with value v, returns the size */
+static uint32_t make_seq_octet (unsigned char *blob, uint32_t n, unsigned char v)
+{
+  const struct CDRHeader hdr = { .identifier = type->native_encoding_identifier, .options = 0 };
+  const uint32_t size = (uint32_t) (sizeof (hdr) + sizeof (n) + n);
+  memcpy (blob, &hdr, sizeof (hdr));
+  memcpy (blob + sizeof (hdr), &n, sizeof (n));
+  memset (blob + sizeof (hdr) + sizeof (n), v, n);
+  return size;
+}
+
+/* "receives" a sequence of n octets with value v in a single message in pool */
+static struct ddsi_serdata *receive (struct nn_rbufpool *pool, uint32_t n, unsigned char v)
+{
+  static unsigned char blob[MAX_RMSG_SIZE];
+  CU_ASSERT_FATAL (sizeof (struct CDRHeader) + sizeof (n) + n <= sizeof (blob));
+  const uint32_t bounds[] = { 0, make_seq_octet (blob, n, v) };
+  return receive_frags (pool, type, blob, 1, bounds);
+}
+
+static bool is_pinned (const struct ddsi_serdata *sd)
+{
+  /* the pinned state is retained after the data has been copied, so this
+     says whether the serdata was constructed referencing the receive buffer */
+  return ((const struct ddsi_serdata_default *) sd)->pinned != NULL;
+}
+
+static void check_contents (const struct ddsi_serdata *sd, uint32_t n, unsigned char v)
+{
+  dds_sequence_t s;
+  memset (&s, 0, sizeof (s));
+  CU_ASSERT_FATAL (ddsi_serdata_to_sample (sd, &s, NULL, NULL));
+  CU_ASSERT (s._length == n);
+  for (uint32_t i = 0; i < s._length; i++)
+    CU_ASSERT_FATAL (s._buffer[i] == v);
+  ddsi_sertype_free_sample (&type->c, &s, DDS_FREE_CONTENTS);
+}
+
+/* serdata constructed from a keyed sample, serialized into blob, for use as
+   a reference for what is received */
+static struct ddsi_serdata *make_keyed (unsigned char *blob, uint32_t bloblen, uint32_t *size, uint32_t n, unsigned char v, int32_t id, const char *name)
+{
+  struct keyed k = { .id = id, .name = (char *) name };
+  k.data._length = k.data._maximum = n;
+  k.data._buffer = ddsrt_malloc (n);
+  memset (k.data._buffer, v, n);
+  struct ddsi_serdata *sd = ddsi_serdata_from_sample (&keyed_type->c, SDK_DATA, &k);
+  ddsrt_free (k.data._buffer);
+  CU_ASSERT_FATAL (sd != NULL);
+  *size = ddsi_serdata_size (sd);
+  CU_ASSERT_FATAL (*size <= bloblen);
+  ddsi_serdata_to_ser (sd, 0, *size, blob);
+  return sd;
+}
+
+static void check_keyed_contents (const struct ddsi_serdata *sd, uint32_t n, unsigned char v, int32_t id, const char *name)
+{
+  struct keyed k;
+  memset (&k, 0, sizeof (k));
+  CU_ASSERT_FATAL (ddsi_serdata_to_sample (sd, &k, NULL, NULL));
+  CU_ASSERT (k.data._length == n);
+  for (uint32_t i = 0; i < k.data._length; i++)
+    CU_ASSERT_FATAL (k.data._buffer[i] == v);
+  CU_ASSERT (k.id == id);
+  CU_ASSERT_FATAL (k.name != NULL);
+  CU_ASSERT (strcmp (k.name, name) == 0);
+  ddsi_sertype_free_sample (&keyed_type->c, &k, DDS_FREE_CONTENTS);
+}
+
+CU_Test (ddsi_pinned_serdata, threshold)
+{
+  setup (4 * RBUF_SIZE);
+  struct ddsi_serdata *small = receive (rbp[0], THRESHOLD / 2, 1);
+  CU_ASSERT (!is_pinned (small));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  check_contents (small, THRESHOLD / 2, 1);
+  ddsi_serdata_unref (small);
+  teardown ();
+}
+
+CU_Test (ddsi_pinned_serdata, pin_unpin)
+{
+  setup (4 * RBUF_SIZE);
+  /* the first pin of a receive buffer charges its full size, further ones
+     in the same receive buffer are free */
+  struct ddsi_serdata *a = receive (rbp[0], 2 * THRESHOLD, 2);
+  CU_ASSERT (is_pinned (a));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  struct ddsi_serdata *b = receive (rbp[0], 3 * THRESHOLD, 3);
+  CU_ASSERT (is_pinned (b));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+
+  /* first use copies the data and releases the receive buffer */
+  check_contents (a, 2 * THRESHOLD, 2);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  check_contents (b, 3 * THRESHOLD, 3);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  check_contents (b, 3 * THRESHOLD, 3);
+  ddsi_serdata_unref (a);
+  ddsi_serdata_unref (b);
+
+  /* dropping a sample that was never used releases it, too */
+  struct ddsi_serdata *c = receive (rbp[0], 2 * THRESHOLD, 4);
+  CU_ASSERT (is_pinned (c));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  ddsi_serdata_unref (c);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  teardown ();
+}
+
+CU_Test (ddsi_pinned_serdata, limit)
+{
+  /* room for a single receive buffer: small samples in a second one must be
+     copied even though their total size is far below the limit */
+  setup (RBUF_SIZE);
+  struct ddsi_serdata *a = receive (rbp[0], THRESHOLD, 5);
+  CU_ASSERT (is_pinned (a));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  struct ddsi_serdata *b = receive (rbp[1], THRESHOLD, 6);
+  CU_ASSERT (!is_pinned (b));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  check_contents (b, THRESHOLD, 6);
+
+  /* once the first receive buffer is no longer pinned, the second one can be */
+  ddsi_serdata_unref (a);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  struct ddsi_serdata *c = receive (rbp[1], THRESHOLD, 7);
+  CU_ASSERT (is_pinned (c));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  check_contents (c, THRESHOLD, 7);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  ddsi_serdata_unref (b);
+  ddsi_serdata_unref (c);
+  teardown ();
+}
+
+CU_Test (ddsi_pinned_serdata, keyed)
+{
+  static unsigned char blob[MAX_RMSG_SIZE];
+  const char *name = "the key string of a pinned sample";
+  uint32_t size;
+  setup (4 * RBUF_SIZE);
+  struct ddsi_serdata *ref = make_keyed (blob, sizeof (blob), &size, 2 * THRESHOLD, 9, 123, name);
+  const uint32_t bounds[] = { 0, size };
+  struct ddsi_serdata *a = receive_frags (rbp[0], keyed_type, blob, 1, bounds);
+  CU_ASSERT (is_pinned (a));
+
+  /* the key is extracted while validating, without copying the payload */
+  CU_ASSERT (a->hash == ref->hash);
+  CU_ASSERT (ddsi_serdata_eqkey (a, ref));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  check_keyed_contents (a, 2 * THRESHOLD, 9, 123, name);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  ddsi_serdata_unref (a);
+  ddsi_serdata_unref (ref);
+  teardown ();
+}
+
+CU_Test (ddsi_pinned_serdata, fragments)
+{
+  static unsigned char blob[MAX_RMSG_SIZE];
+  const char *name = "a key string spanning two fragments";
+  const uint32_t n = 2 * THRESHOLD;
+  uint32_t size;
+  setup (4 * RBUF_SIZE);
+
+  /* sequence length split over the first two fragments */
+  size = make_seq_octet (blob, n, 10);
+  const uint32_t seq_bounds[] = { 0, 6, THRESHOLD, size };
+  struct ddsi_serdata *a = receive_frags (rbp[0], type, blob, 3, seq_bounds);
+  CU_ASSERT (is_pinned (a));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  check_contents (a, n, 10);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  ddsi_serdata_unref (a);
+
+  /* CDR header, sequence length and octets take 8 + n bytes, followed by the
+     id and the string length and characters; split each of the keys */
+  struct ddsi_serdata *ref = make_keyed (blob, sizeof (blob), &size, n, 11, 456, name);
+  const uint32_t keyed_bounds[] = { 0, THRESHOLD, n + 10, n + 14, n + 23, size };
+  struct ddsi_serdata *b = receive_frags (rbp[0], keyed_type, blob, 5, keyed_bounds);
+  CU_ASSERT (is_pinned (b));
+  CU_ASSERT (b->hash == ref->hash);
+  CU_ASSERT (ddsi_serdata_eqkey (b, ref));
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == RBUF_SIZE);
+  check_keyed_contents (b, n, 11, 456, name);
+  CU_ASSERT (ddsrt_atomic_ld32 (&gv.rbuf_ref_pinned) == 0);
+  ddsi_serdata_unref (b);
+  ddsi_serdata_unref (ref);
+  teardown ();
+}
@@ -0,0 +1,384 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsi/q_thread.h"
+#include "dds/ddsi/q_gc.h"
+#include "dds/ddsi/q_entity.h"
+#include "dds/ddsi/q_addrset.h"
+#include "dds/ddsi/q_rtps.h"
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds/ddsi/ddsi_vendor.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_entity_index.h"
+#include "dds/ddsi/ddsi_wraddrset.h"
+#include "dds__entity.h"
+#include "CUnit/Test.h"
+
+/* Matching and unmatching proxy readers updates the writer's address set
+   incrementally where possible; after every step the result must be what a
+   full recomputation gives, with and without the cache, and every matched
+   reader must be reachable through it */
+
+struct wras_type {
+  int32_t k;
+};
+
+static const dds_key_descriptor_t wras_type_keys[] = {
+  { "k", 0 }
+};
+
+static const dds_topic_descriptor_t wras_type_desc = {
+  .m_size = sizeof (struct wras_type),
+  .m_align = 4u,
+  .m_flagset = DDS_TOPIC_FIXED_KEY | DDS_TOPIC_DISABLE_TYPECHECK,
+  .m_nkeys = 1,
+  .m_typename = "wraddrset_type",
+  .m_keys = wras_type_keys,
+  .m_nops = 2,
+  .m_ops = (const uint32_t[]) {
+    DDS_OP_ADR | DDS_OP_TYPE_4BY | DDS_OP_FLAG_SGN | DDS_OP_FLAG_KEY, offsetof (struct wras_type, k),
+    DDS_OP_RTS
+  },
+  .m_meta = ""
+};
+
+#define MAX_READERS 16
+
+/* Locators of a proxy reader: a unicast locator of its own, one shared with
+   other readers, a multicast locator shared with other readers, or a unicast
+   locator of its own plus the shared multicast one */
+enum rdlocs { RL_UNIQUE, RL_SHARED, RL_MULTICAST, RL_UNIQUE_MULTICAST };
+
+static dds_entity_t pp, wrh;
+static struct ddsi_domaingv *gv;
+static ddsi_guid_t wrguid, ppguid;
+static ddsi_plist_t rd_plist;
+static struct addrset *rdas[MAX_READERS];
+
+static void setup (void)
+{
+  pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  CU_ASSERT_FATAL (pp > 0);
+  const dds_entity_t tp = dds_create_topic (pp, &wras_type_desc, "ddsi_wraddrset", NULL, NULL);
+  CU_ASSERT_FATAL (tp > 0);
+  wrh = dds_create_writer (pp, tp, NULL, NULL);
+  CU_ASSERT_FATAL (wrh > 0);
+
+  dds_entity *x;
+  CU_ASSERT_FATAL (dds_entity_pin (wrh, &x) == 0);
+  gv = &x->m_domain->gv;
+  wrguid = x->m_guid;
+  dds_entity_unpin (x);
+
+  ppguid.prefix.u[0] = ddsrt_random ();
+  ppguid.prefix.u[1] = ddsrt_random ();
+  ppguid.prefix.u[2] = ddsrt_random ();
+  ppguid.entityid.u = NN_ENTITYID_PARTICIPANT;
+  struct addrset *ppas = new_addrset ();
+  ddsi_plist_t pp_plist;
+  ddsi_plist_init_empty (&pp_plist);
+  thread_state_awake (lookup_thread_state (), gv);
+  new_proxy_participant (gv, &ppguid, 0, NULL, ref_addrset (ppas), ref_addrset (ppas), &pp_plist, DDS_INFINITY, NN_VENDORID_ECLIPSE, CF_PROXYPP_NO_SPDP, ddsrt_time_wallclock (), 1);
+  thread_state_asleep (lookup_thread_state ());
+  ddsi_plist_fini (&pp_plist);
+  unref_addrset (ppas);
+
+  ddsi_plist_init_empty (&rd_plist);
+  rd_plist.qos.present |= QP_TOPIC_NAME | QP_TYPE_NAME;
+  rd_plist.qos.topic_name = ddsrt_strdup ("ddsi_wraddrset");
+  rd_plist.qos.type_name = ddsrt_strdup ("wraddrset_type");
+  ddsi_xqos_mergein_missing (&rd_plist.qos, &gv->default_xqos_rd, ~(uint64_t)0);
+  for (int i = 0; i < MAX_READERS; i++)
+    rdas[i] = NULL;
+}
+
+static void teardown (void)
+{
+  thread_state_awake (lookup_thread_state (), gv);
+  delete_proxy_participant_by_guid (gv, &ppguid, ddsrt_time_wallclock (), 0);
+  thread_state_asleep (lookup_thread_state ());
+  gcreq_queue_drain (gv->gcreq_queue);
+  for (int i = 0; i < MAX_READERS; i++)
+    if (rdas[i])
+      unref_addrset (rdas[i]);
+  ddsi_plist_fini (&rd_plist);
+  dds_delete (pp);
+}
+
+static ddsi_guid_t rdguid (int i)
+{
+  ddsi_guid_t guid = { .prefix = ppguid.prefix };
+  guid.entityid.u = ((uint32_t) (i + 1) << 8) | NN_ENTITYID_SOURCE_USER | NN_ENTITYID_KIND_READER_WITH_KEY;
+  return guid;
+}
+
+static void add_loc (struct addrset *as, int32_t kind, uint8_t a0, uint8_t a3, uint32_t port)
+{
+  ddsi_locator_t loc;
+  memset (&loc, 0, sizeof (loc));
+  loc.kind = kind;
+  loc.address[12] = a0;
+  loc.address[13] = (a0 == 127) ? 0 : 255;
+  loc.address[14] = 0;
+  loc.address[15] = a3;
+  loc.port = port;
+  add_locator_to_addrset (gv, as, &loc);
+}
+
+static void add_reader (int i, enum rdlocs locs)
+{
+  struct addrset *as = new_addrset ();
+  if (locs == RL_UNIQUE || locs == RL_UNIQUE_MULTICAST)
+    add_loc (as, NN_LOCATOR_KIND_UDPv4, 127, 1, 7500 + (uint32_t) i);
+  if (locs == RL_SHARED)
+    add_loc (as, NN_LOCATOR_KIND_UDPv4, 127, 1, 7499);
+  if (locs == RL_MULTICAST || locs == RL_UNIQUE_MULTICAST)
+    add_loc (as, NN_LOCATOR_KIND_UDPv4, 239, 77, 7498);
+  const ddsi_guid_t guid = rdguid (i);
+  thread_state_awake (lookup_thread_state (), gv);
+#ifdef DDS_HAS_SSM
+  new_proxy_reader (gv, &ppguid, &guid, as, &rd_plist, ddsrt_time_wallclock (), 1, 0);
+#else
+  new_proxy_reader (gv, &ppguid, &guid, as, &rd_plist, ddsrt_time_wallclock (), 1);
+#endif
+  thread_state_asleep (lookup_thread_state ());
+  CU_ASSERT_FATAL (rdas[i] == NULL);
+  rdas[i] = as;
+}
+
+static uint32_t get_num_readers (void)
+{
+  thread_state_awake (lookup_thread_state (), gv);
+  struct writer * const wr = entidx_lookup_writer_guid (gv->entity_index, &wrguid);
+  CU_ASSERT_FATAL (wr != NULL);
+  ddsrt_mutex_lock (&wr->e.lock);
+  const uint32_t n = wr->num_readers;
+  ddsrt_mutex_unlock (&wr->e.lock);
+  thread_state_asleep (lookup_thread_state ());
+  return n;
+}
+
+static void remove_reader (int i)
+{
+  const ddsi_guid_t guid = rdguid (i);
+  thread_state_awake (lookup_thread_state (), gv);
+  delete_proxy_reader (gv, &guid, ddsrt_time_wallclock (), 0);
+  thread_state_asleep (lookup_thread_state ());
+  CU_ASSERT_FATAL (rdas[i] != NULL);
+  unref_addrset (rdas[i]);
+  rdas[i] = NULL;
+
+  // unmatching happens when the proxy reader is garbage collected, and the
+  // request is dequeued before that is done, so draining the queue isn't
+  // quite enough
+  uint32_t nrds = 0;
+  for (int j = 0; j < MAX_READERS; j++)
+    if (rdas[j] != NULL)
+      nrds++;
+  gcreq_queue_drain (gv->gcreq_queue);
+  const dds_time_t tend = dds_time () + DDS_SECS (10);
+  while (get_num_readers () != nrds && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (1));
+}
+
+struct locs {
+  int n;
+  ddsi_xlocator_t l[2 * MAX_READERS];
+};
+
+static void get_locs_helper (const ddsi_xlocator_t *loc, void *varg)
+{
+  struct locs *ls = varg;
+  CU_ASSERT_FATAL (ls->n < (int) (sizeof (ls->l) / sizeof (ls->l[0])));
+  ls->l[ls->n++] = *loc;
+}
+
+static int compare_xlocators_vwrap (const void *va, const void *vb)
+{
+  return compare_xlocators (va, vb);
+}
+
+static void get_locs (struct addrset *as, struct locs *ls)
+{
+  ls->n = 0;
+  addrset_forall (as, get_locs_helper, ls);
+  qsort (ls->l, (size_t) ls->n, sizeof (ls->l[0]), compare_xlocators_vwrap);
+}
+
+static bool locs_equal (const struct locs *a, const struct locs *b)
+{
+  if (a->n != b->n)
+    return false;
+  for (int i = 0; i < a->n; i++)
+    if (compare_xlocators (&a->l[i], &b->l[i]) != 0)
+      return false;
+  return true;
+}
+
+struct covered_arg {
+  const struct locs *wrlocs;
+  bool covered;
+};
+
+static void covered_helper (const ddsi_xlocator_t *loc, void *varg)
+{
+  struct covered_arg *arg = varg;
+  if (bsearch (loc, arg->wrlocs->l, (size_t) arg->wrlocs->n, sizeof (arg->wrlocs->l[0]), compare_xlocators_vwrap))
+    arg->covered = true;
+}
+
+static struct addrset *full_writer_addrset (struct writer *wr, bool use_cache)
+{
+  // compute_writer_addrset replaces the state for incremental updates, but
+  // that of the writer must be retained for the next step.  Temporarily
+  // swapping in an empty cache is fine because all discovery is done by the
+  // test itself.
+  struct wraddrset_state * const st = wr->as_state;
+  struct wraddrset_cache * const cache = gv->wraddrset_cache;
+  wr->as_state = NULL;
+  if (!use_cache)
+    wraddrset_cache_init (gv);
+  struct addrset *as = compute_writer_addrset (wr);
+  if (!use_cache)
+  {
+    wraddrset_cache_fini (gv);
+    gv->wraddrset_cache = cache;
+  }
+  writer_addrset_state_free (wr);
+  wr->as_state = st;
+  return as;
+}
+
+static void check (void)
+{
+  thread_state_awake (lookup_thread_state (), gv);
+  struct writer * const wr = entidx_lookup_writer_guid (gv->entity_index, &wrguid);
+  CU_ASSERT_FATAL (wr != NULL);
+  ddsrt_mutex_lock (&wr->e.lock);
+  // all readers have only unicast and multicast UDP locators and so the
+  // writer should always retain the state for incremental updates
+  CU_ASSERT (wr->as_state != NULL);
+
+  struct locs cur, full, cached;
+  get_locs (wr->as, &cur);
+  struct addrset *as = full_writer_addrset (wr, false);
+  get_locs (as, &full);
+  unref_addrset (as);
+  CU_ASSERT (locs_equal (&cur, &full));
+  // first lookup may be a miss that adds it, the second is certainly a hit
+  for (int i = 0; i < 2; i++)
+  {
+    as = full_writer_addrset (wr, true);
+    get_locs (as, &cached);
+    unref_addrset (as);
+    CU_ASSERT (locs_equal (&cached, &full));
+  }
+
+  int nrds = 0;
+  for (int i = 0; i < MAX_READERS; i++)
+  {
+    if (rdas[i] == NULL)
+      continue;
+    struct covered_arg arg = { .wrlocs = &cur, .covered = false };
+    addrset_forall (rdas[i], covered_helper, &arg);
+    CU_ASSERT (arg.covered);
+    nrds++;
+  }
+  CU_ASSERT (wr->num_readers == (uint32_t) nrds);
+  CU_ASSERT ((nrds == 0) == (cur.n == 0));
+  ddsrt_mutex_unlock (&wr->e.lock);
+  thread_state_asleep (lookup_thread_state ());
+}
+
+struct step {
+  bool add;
+  int rd;
+  enum rdlocs locs;
+};
+
+static void run_steps (const struct step *steps, size_t nsteps)
+{
+  for (size_t i = 0; i < nsteps; i++)
+  {
+    if (steps[i].add)
+      add_reader (steps[i].rd, steps[i].locs);
+    else
+      remove_reader (steps[i].rd);
+    check ();
+  }
+}
+
+CU_Test (ddsi_wraddrset, incremental, .init = setup, .fini = teardown)
+{
+  static const struct step steps[] = {
+    { true, 0, RL_UNIQUE },
+    { true, 1, RL_UNIQUE },
+    { true, 2, RL_SHARED },
+    { true, 3, RL_SHARED },
+    { true, 4, RL_UNIQUE_MULTICAST },
+    { true, 5, RL_MULTICAST },
+    { true, 6, RL_UNIQUE_MULTICAST },
+    { false, 2, 0 },
+    { true, 7, RL_UNIQUE },
+    { false, 5, 0 },
+    { false, 0, 0 },
+    { true, 8, RL_SHARED },
+    { false, 3, 0 },
+    { false, 4, 0 },
+    { true, 9, RL_MULTICAST },
+    { false, 6, 0 },
+    { false, 1, 0 },
+    { false, 8, 0 },
+    { false, 9, 0 },
+    { false, 7, 0 }
+  };
+  run_steps (steps, sizeof (steps) / sizeof (steps[0]));
+}
+
+CU_Test (ddsi_wraddrset, multicast, .init = setup, .fini = teardown)
+{
+  /* Readers that all share the multicast locator: whether it is worth using
+     depends on the number of readers, and so these cross the point where the
+     writer switches between unicast and multicast in both directions */
+  static const struct step steps[] = {
+    { true, 0, RL_UNIQUE_MULTICAST },
+    { true, 1, RL_UNIQUE },
+    { true, 2, RL_UNIQUE_MULTICAST },
+    { true, 3, RL_UNIQUE_MULTICAST },
+    { true, 4, RL_UNIQUE_MULTICAST },
+    { true, 5, RL_UNIQUE_MULTICAST },
+    { true, 6, RL_MULTICAST },
+    { true, 7, RL_UNIQUE_MULTICAST },
+    { false, 0, 0 },
+    { false, 2, 0 },
+    { false, 6, 0 },
+    { false, 3, 0 },
+    { false, 4, 0 },
+    { true, 8, RL_UNIQUE_MULTICAST },
+    { false, 5, 0 },
+    { false, 8, 0 },
+    { true, 9, RL_UNIQUE_MULTICAST },
+    { true, 10, RL_UNIQUE_MULTICAST },
+    { false, 7, 0 },
+    { false, 1, 0 },
+    { false, 9, 0 },
+    { false, 10, 0 }
+  };
+  run_steps (steps, sizeof (steps) / sizeof (steps[0]));
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_serdata_default.h"
+#include "dds__topic.h"
+
+#include "CdrBenchTypes.h"
+
+/* Compares the type-specific (de)serializers generated by idlc with the
+   opcode interpreter: both must produce identical CDR, accept and reject the
+   same input and deserialize to the same sample. The time taken for each is
+   printed per operation. Usage: cdrbench [ITERATIONS] */
+
+enum mode { INTERPRETER, GENERATED };
+static const char *mode_names[] = { "interpreter", "generated" };
+
+struct result {
+  unsigned char *cdr;
+  size_t cdrsize;
+  double ns_write, ns_normalize, ns_read;
+};
+
+static char *mkstring (const char *prefix, int i)
+{
+  char buf[32];
+  (void) snprintf (buf, sizeof (buf), "%s%d", prefix, i);
+  return ddsrt_strdup (buf);
+}
+
+static void init_small (CdrBench_Small *s)
+{
+  memset (s, 0, sizeof (*s));
+  s->id = 42;
+  s->flags = 0x5a;
+  s->stamp = UINT64_C (0x0123456789abcdef);
+  s->v = 3.14159;
+}
+
+static void init_big (CdrBench_Big *s)
+{
+  static const char *codes[] = { "alpha", "beta", "gamma" };
+  memset (s, 0, sizeof (*s));
+  s->id = 4242;
+  ddsrt_strlcpy (s->tag, "big-tag", sizeof (s->tag));
+  s->name = ddsrt_strdup ("a somewhat longer name for the big sample");
+  s->origin.x = 1.0; s->origin.y = 2.0; s->origin.z = 3.0;
+  for (int i = 0; i < 4; i++)
+  {
+    s->corners[i].x = i; s->corners[i].y = -i; s->corners[i].z = 2 * i;
+  }
+  for (int i = 0; i < 8; i++)
+    s->counters[i] = (int64_t) i * 1000003;
+  s->payload._length = s->payload._maximum = 256;
+  s->payload._buffer = ddsrt_malloc (s->payload._length);
+  s->payload._release = true;
+  for (uint32_t i = 0; i < s->payload._length; i++)
+    s->payload._buffer[i] = (uint8_t) i;
+  s->labels._length = s->labels._maximum = 5;
+  s->labels._buffer = ddsrt_malloc (s->labels._length * sizeof (*s->labels._buffer));
+  s->labels._release = true;
+  for (uint32_t i = 0; i < s->labels._length; i++)
+    s->labels._buffer[i] = mkstring ("label-", (int) i);
+  s->path._length = s->path._maximum = 16;
+  s->path._buffer = ddsrt_malloc (s->path._length * sizeof (*s->path._buffer));
+  s->path._release = true;
+  for (uint32_t i = 0; i < s->path._length; i++)
+  {
+    s->path._buffer[i].x = 0.5 * i; s->path._buffer[i].y = 0.25 * i; s->path._buffer[i].z = 0.125 * i;
+  }
+  s->codes._length = s->codes._maximum = 3;
+  s->codes._buffer = ddsrt_malloc (s->codes._length * sizeof (*s->codes._buffer));
+  s->codes._release = true;
+  for (uint32_t i = 0; i < s->codes._length; i++)
+    ddsrt_strlcpy (s->codes._buffer[i], codes[i], sizeof (s->codes._buffer[i]));
+  s->names[0] = ddsrt_strdup ("first");
+  s->names[1] = ddsrt_strdup ("second");
+  s->value._d = CdrBench_K_POINT;
+  s->value._u.p.x = 7.0; s->value._u.p.y = 8.0; s->value._u.p.z = 9.0;
+  s->s = -3;
+  s->b = true;
+}
+
+static double ns_per_op (dds_time_t t0, dds_time_t t1, uint32_t n)
+{
+  return (double) (t1 - t0) / (double) n;
+}
+
+static bool run (struct result *res, struct ddsi_sertype *type, const void *sample, uint32_t iterations)
+{
+  struct ddsi_serdata *sd;
+  void *copy;
+  dds_time_t t0, t1;
+  ddsrt_iovec_t iov;
+
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < iterations; i++)
+    ddsi_serdata_unref (ddsi_serdata_from_sample (type, SDK_DATA, sample));
+  t1 = dds_time ();
+  res->ns_write = ns_per_op (t0, t1, iterations);
+
+  sd = ddsi_serdata_from_sample (type, SDK_DATA, sample);
+  res->cdrsize = ddsi_serdata_size (sd);
+  res->cdr = ddsrt_malloc (res->cdrsize);
+  ddsi_serdata_to_ser (sd, 0, res->cdrsize, res->cdr);
+  ddsi_serdata_unref (sd);
+
+  iov.iov_base = res->cdr;
+  iov.iov_len = (ddsrt_iov_len_t) res->cdrsize;
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    if ((sd = ddsi_serdata_from_ser_iov (type, SDK_DATA, 1, &iov, res->cdrsize)) == NULL)
+      return false;
+    ddsi_serdata_unref (sd);
+  }
+  t1 = dds_time ();
+  res->ns_normalize = ns_per_op (t0, t1, iterations);
+
+  /* truncated input must be rejected */
+  for (size_t sz = 4; sz < res->cdrsize; sz += (res->cdrsize / 16) + 1)
+  {
+    iov.iov_len = (ddsrt_iov_len_t) sz;
+    if ((sd = ddsi_serdata_from_ser_iov (type, SDK_DATA, 1, &iov, sz)) != NULL)
+    {
+      ddsi_serdata_unref (sd);
+      return false;
+    }
+  }
+
+  iov.iov_len = (ddsrt_iov_len_t) res->cdrsize;
+  sd = ddsi_serdata_from_ser_iov (type, SDK_DATA, 1, &iov, res->cdrsize);
+  copy = ddsi_sertype_alloc_sample (type);
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < iterations; i++)
+    (void) ddsi_serdata_to_sample (sd, copy, NULL, NULL);
+  t1 = dds_time ();
+  res->ns_read = ns_per_op (t0, t1, iterations);
+  ddsi_serdata_unref (sd);
+
+  /* the deserialized copy must serialize to the same bytes */
+  sd = ddsi_serdata_from_sample (type, SDK_DATA, copy);
+  if (ddsi_serdata_size (sd) != res->cdrsize)
+    res->cdrsize = 0;
+  else
+  {
+    unsigned char *cdr = ddsrt_malloc (res->cdrsize);
+    ddsi_serdata_to_ser (sd, 0, res->cdrsize, cdr);
+    if (memcmp (cdr, res->cdr, res->cdrsize) != 0)
+      res->cdrsize = 0;
+    ddsrt_free (cdr);
+  }
+  ddsi_serdata_unref (sd);
+  ddsi_sertype_free_sample (type, copy, DDS_FREE_ALL);
+  return res->cdrsize > 0;
+}
+
+static bool bench (dds_entity_t pp, const char *name, const dds_topic_descriptor_t *desc, const void *sample, uint32_t iterations)
+{
+  struct result res[2];
+  struct dds_topic *tp;
+  struct ddsi_sertype_default *st;
+  const struct dds_topic_cdr_funcs *cdr_funcs;
+  bool ok = true;
+  dds_entity_t topic;
+
+  if ((topic = dds_create_topic (pp, desc, name, NULL, NULL)) < 0)
+  {
+    fprintf (stderr, "dds_create_topic: %s\n", dds_strretcode (topic));
+    return false;
+  }
+  if (dds_topic_pin (topic, &tp) < 0)
+    return false;
+  st = (struct ddsi_sertype_default *) tp->m_stype;
+  if ((cdr_funcs = st->type.cdr_funcs) == NULL)
+  {
+    printf ("%s: no generated (de)serializers\n", desc->m_typename);
+    ok = false;
+  }
+
+  memset (res, 0, sizeof (res));
+  for (enum mode m = INTERPRETER; ok && m <= GENERATED; m++)
+  {
+    st->type.cdr_funcs = (m == GENERATED) ? cdr_funcs : NULL;
+    if (!run (&res[m], &st->c, sample, iterations))
+    {
+      printf ("%s: %s: round-trip failed\n", desc->m_typename, mode_names[m]);
+      ok = false;
+    }
+  }
+  st->type.cdr_funcs = cdr_funcs;
+  dds_topic_unpin (tp);
+
+  if (ok && (res[INTERPRETER].cdrsize != res[GENERATED].cdrsize ||
+             memcmp (res[INTERPRETER].cdr, res[GENERATED].cdr, res[GENERATED].cdrsize) != 0))
+  {
+    printf ("%s: serialized data differs\n", desc->m_typename);
+    ok = false;
+  }
+  if (ok)
+  {
+    printf ("%s (%zu bytes): ns/op write / normalize / read\n", desc->m_typename, res[GENERATED].cdrsize);
+    for (enum mode m = INTERPRETER; m <= GENERATED; m++)
+      printf ("  %-12s %8.1f %8.1f %8.1f\n", mode_names[m], res[m].ns_write, res[m].ns_normalize, res[m].ns_read);
+  }
+  ddsrt_free (res[INTERPRETER].cdr);
+  ddsrt_free (res[GENERATED].cdr);
+  return ok;
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t iterations = 100000;
+  CdrBench_Small small;
+  CdrBench_Big big;
+  dds_entity_t pp;
+  bool ok;
+
+  if (argc > 1)
+    iterations = (uint32_t) strtoul (argv[1], NULL, 0);
+  if (iterations == 0)
+    iterations = 1;
+
+  if ((pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL)) < 0)
+  {
+    fprintf (stderr, "dds_create_participant: %s\n", dds_strretcode (pp));
+    return 1;
+  }
+
+  init_small (&small);
+  init_big (&big);
+  ok = bench (pp, "cdrbench_small", &CdrBench_Small_desc, &small, iterations);
+  ok = bench (pp, "cdrbench_big", &CdrBench_Big_desc, &big, iterations) && ok;
+  dds_sample_free (&big, &CdrBench_Big_desc, DDS_FREE_CONTENTS);
+
+  dds_delete (pp);
+  return ok ? 0 : 1;
+}
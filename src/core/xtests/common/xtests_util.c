@@ -0,0 +1,143 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/endian.h"
+#include "dds/ddsi/q_rtps.h"
+#include "dds/ddsi/q_bswap.h"
+#include "dds/ddsi/q_misc.h"
+#include "dds/ddsi/ddsi_serdata.h"
+#include "dds/ddsi/ddsi_tran.h"
+#include "dds__types.h"
+#include "dds__entity.h"
+#include "xtests_util.h"
+
+struct ddsi_domaingv *get_domaingv (dds_entity_t e)
+{
+  struct ddsi_domaingv *gv;
+  dds_entity *x;
+  if (dds_entity_pin (e, &x) < 0)
+    abort ();
+  gv = &x->m_domain->gv;
+  dds_entity_unpin (x);
+  return gv;
+}
+
+ddsi_guid_t get_entity_guid (dds_entity_t e)
+{
+  ddsi_guid_t guid;
+  dds_entity *x;
+  if (dds_entity_pin (e, &x) < 0)
+    abort ();
+  guid = x->m_guid;
+  dds_entity_unpin (x);
+  return guid;
+}
+
+void make_endpoint_plist (ddsi_plist_t *plist, const char *topic_name, const char *type_name, const struct dds_qos *defqos)
+{
+  ddsi_plist_init_empty (plist);
+  plist->qos.present |= QP_TOPIC_NAME | QP_TYPE_NAME;
+  plist->qos.topic_name = ddsrt_strdup (topic_name);
+  plist->qos.type_name = ddsrt_strdup (type_name);
+  ddsi_xqos_mergein_missing (&plist->qos, defqos, ~(uint64_t)0);
+}
+
+ddsi_guid_t make_endpoint_guid (const ddsi_guid_prefix_t *prefix, uint32_t i, bool writer)
+{
+  ddsi_guid_t guid;
+  guid.prefix = *prefix;
+  guid.entityid.u = ((i + 1) << 8) | NN_ENTITYID_SOURCE_USER | (writer ? NN_ENTITYID_KIND_WRITER_WITH_KEY : NN_ENTITYID_KIND_READER_WITH_KEY);
+  return guid;
+}
+
+void set_loopback_locator (nn_locators_t *ls, struct nn_locators_one *one, uint32_t port)
+{
+  memset (&one->loc, 0, sizeof (one->loc));
+  one->loc.kind = NN_LOCATOR_KIND_UDPv4;
+  one->loc.address[12] = 127;
+  one->loc.address[15] = 1;
+  one->loc.port = port;
+  one->next = NULL;
+  ls->n = 1;
+  ls->first = ls->last = one;
+}
+
+void make_spdp_plist (ddsi_plist_t *ps, struct nn_locators_one locs[2], const ddsi_guid_prefix_t *prefix, uint32_t port)
+{
+  ddsi_plist_init_empty (ps);
+  ps->present |= PP_PARTICIPANT_GUID | PP_BUILTIN_ENDPOINT_SET | PP_PROTOCOL_VERSION | PP_VENDORID |
+    PP_METATRAFFIC_UNICAST_LOCATOR | PP_DEFAULT_UNICAST_LOCATOR | PP_PARTICIPANT_LEASE_DURATION;
+  ps->aliased |= PP_METATRAFFIC_UNICAST_LOCATOR | PP_DEFAULT_UNICAST_LOCATOR;
+  ps->participant_guid.prefix = *prefix;
+  ps->participant_guid.entityid.u = NN_ENTITYID_PARTICIPANT;
+  ps->builtin_endpoint_set =
+    NN_DISC_BUILTIN_ENDPOINT_PARTICIPANT_ANNOUNCER | NN_DISC_BUILTIN_ENDPOINT_PARTICIPANT_DETECTOR |
+    NN_DISC_BUILTIN_ENDPOINT_PUBLICATION_ANNOUNCER | NN_DISC_BUILTIN_ENDPOINT_PUBLICATION_DETECTOR |
+    NN_DISC_BUILTIN_ENDPOINT_SUBSCRIPTION_ANNOUNCER | NN_DISC_BUILTIN_ENDPOINT_SUBSCRIPTION_DETECTOR |
+    NN_BUILTIN_ENDPOINT_PARTICIPANT_MESSAGE_DATA_WRITER | NN_BUILTIN_ENDPOINT_PARTICIPANT_MESSAGE_DATA_READER;
+  ps->protocol_version.major = RTPS_MAJOR;
+  ps->protocol_version.minor = RTPS_MINOR;
+  ps->vendorid = NN_VENDORID_ECLIPSE;
+  set_loopback_locator (&ps->metatraffic_unicast_locators, &locs[0], port);
+  set_loopback_locator (&ps->default_unicast_locators, &locs[1], port);
+  ps->participant_lease_duration = DDS_SECS (300);
+}
+
+void init_rtps_message (unsigned char *buf, uint32_t *size, const ddsi_guid_prefix_t *prefix)
+{
+  Header_t hdr;
+  memcpy (hdr.protocol.id, "RTPS", 4);
+  hdr.version.major = RTPS_MAJOR;
+  hdr.version.minor = RTPS_MINOR;
+  hdr.vendorid = NN_VENDORID_ECLIPSE;
+  hdr.guid_prefix = nn_hton_guid_prefix (*prefix);
+  memcpy (buf, &hdr, sizeof (hdr));
+  *size = (uint32_t) sizeof (hdr);
+}
+
+bool append_data_submsg (unsigned char *buf, uint32_t *size, uint32_t bufsize, const struct ddsi_sertype *type, uint32_t wrid, uint32_t rdid, seqno_t seq, const ddsi_plist_t *ps)
+{
+  struct ddsi_serdata *sd = ddsi_serdata_from_sample (type, SDK_DATA, ps);
+  const uint32_t sz = ddsi_serdata_size (sd);
+  const uint32_t sz4 = (sz + 3) & ~(uint32_t)3;
+  if (*size + sizeof (Data_t) + sz4 > bufsize)
+  {
+    ddsi_serdata_unref (sd);
+    return false;
+  }
+  Data_t data;
+  data.x.smhdr.submessageId = SMID_DATA;
+  data.x.smhdr.flags = DATA_FLAG_DATAFLAG | ((DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN) ? SMFLAG_ENDIANNESS : 0);
+  data.x.smhdr.octetsToNextHeader = (uint16_t) (sizeof (data) - RTPS_SUBMESSAGE_HEADER_SIZE + sz4);
+  data.x.extraFlags = 0;
+  data.x.octetsToInlineQos = (uint16_t) (sizeof (data) - offsetof (Data_t, x.readerId));
+  data.x.readerId = nn_hton_entityid ((ddsi_entityid_t) { rdid });
+  data.x.writerId = nn_hton_entityid ((ddsi_entityid_t) { wrid });
+  data.x.writerSN = toSN (seq);
+  memcpy (buf + *size, &data, sizeof (data));
+  *size += (uint32_t) sizeof (data);
+  memset (buf + *size, 0, sz4);
+  ddsi_serdata_to_ser (sd, 0, sz, buf + *size);
+  *size += sz4;
+  ddsi_serdata_unref (sd);
+  return true;
+}
+
+void send_rtps_message (struct ddsi_domaingv *gv, const ddsi_locator_t *dst, const unsigned char *buf, uint32_t size)
+{
+  const ddsrt_iovec_t iov = { .iov_base = (void *) buf, .iov_len = size };
+  (void) ddsi_conn_write (gv->xmit_conns[0], dst, 1, &iov, 0);
+}
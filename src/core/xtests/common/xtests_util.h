@@ -0,0 +1,54 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#ifndef _XTESTS_UTIL_H_
+#define _XTESTS_UTIL_H_
+
+#include "dds/dds.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/ddsi/ddsi_guid.h"
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds/ddsi/ddsi_sertype.h"
+#include "dds/ddsi/q_protocol.h"
+
+/* Domain globals of the domain containing entity e, aborts on error */
+struct ddsi_domaingv *get_domaingv (dds_entity_t e);
+
+/* GUID of entity e, aborts on error */
+ddsi_guid_t get_entity_guid (dds_entity_t e);
+
+/* Initializes plist for an endpoint with the given topic and type names and
+   all other QoS settings taken from defqos, free with ddsi_plist_fini */
+void make_endpoint_plist (ddsi_plist_t *plist, const char *topic_name, const char *type_name, const struct dds_qos *defqos);
+
+/* GUID of the i'th application (keyed) reader or writer with prefix */
+ddsi_guid_t make_endpoint_guid (const ddsi_guid_prefix_t *prefix, uint32_t i, bool writer);
+
+/* Sets ls to a list containing only a UDPv4 locator for the loopback
+   interface and the given port, stored in *one */
+void set_loopback_locator (nn_locators_t *ls, struct nn_locators_one *one, uint32_t port);
+
+/* Initializes ps as an SPDP message for a participant with the given GUID
+   prefix with all the usual builtin endpoints and unicast locators on the
+   loopback interface at the given port, locs provides the storage for the
+   locators and must live as long as ps; free with ddsi_plist_fini */
+void make_spdp_plist (ddsi_plist_t *ps, struct nn_locators_one locs[2], const ddsi_guid_prefix_t *prefix, uint32_t port);
+
+/* Building RTPS messages in buf: initializing it with just the header,
+   appending a DATA submessage containing the serialized form of ps (returns
+   false without appending anything if the result would exceed bufsize) */
+void init_rtps_message (unsigned char *buf, uint32_t *size, const ddsi_guid_prefix_t *prefix);
+bool append_data_submsg (unsigned char *buf, uint32_t *size, uint32_t bufsize, const struct ddsi_sertype *type, uint32_t wrid, uint32_t rdid, seqno_t seq, const ddsi_plist_t *ps);
+
+/* Sends the RTPS message in buf to dst */
+void send_rtps_message (struct ddsi_domaingv *gv, const ddsi_locator_t *dst, const unsigned char *buf, uint32_t size);
+
+#endif /* _XTESTS_UTIL_H_ */
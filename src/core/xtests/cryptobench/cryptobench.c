@@ -0,0 +1,299 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/endian.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/time.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds/security/dds_security_api.h"
+#include "dds/security/core/dds_security_utils.h"
+#include "dds/security/core/shared_secret.h"
+#include "cryptography.h"
+#include "crypto_objects.h"
+
+/* Benchmark for the builtin crypto plugin: runs a number of encode/decode
+   round trips of a serialized payload for AES-GCM and GMAC, forcing a new
+   session key halfway through, and prints the time per sample for encoding
+   and decoding.  Every decoded payload is checked against the input.  It
+   then signs a data submessage for NREADERS origin-authenticated readers,
+   i.e., with a receiver-specific MAC for each of them, and prints the time
+   per sample for that.  Usage: cryptobench [ROUNDS [NREADERS]] */
+
+#define SHARED_SECRET_SIZE 32
+
+static dds_security_cryptography *crypto;
+static DDS_Security_ParticipantCryptoHandle local_participant_handle;
+static DDS_Security_ParticipantCryptoHandle remote_participant_handle;
+static DDS_Security_SharedSecretHandle shared_secret_handle;
+
+static const char *sample_test_data =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789abcdefghijklmnopqrstuvwxyz"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789abcdefghijklmnopqrstuvwxyz"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789abcdefghijklmnopqrstuvwxyz"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789abcdefghijklmnopqrstuvwxy";
+
+static void check (bool ok, const char *what, DDS_Security_SecurityException *ex)
+{
+  if (!ok)
+  {
+    fprintf (stderr, "%s failed: %s\n", what, (ex && ex->message) ? ex->message : "(no message)");
+    exit (2);
+  }
+  if (ex)
+    DDS_Security_Exception_reset (ex);
+}
+
+static void setup (void)
+{
+  static struct ddsi_domaingv gv;
+  DDS_Security_SecurityException ex = {NULL, 0, 0};
+  DDS_Security_SharedSecretHandleImpl *ss;
+  DDS_Security_PropertySeq props;
+  DDS_Security_ParticipantSecurityAttributes attrs;
+  void *context;
+
+  check (init_crypto ("", &context, &gv) == DDS_SECURITY_SUCCESS, "init_crypto", NULL);
+  crypto = context;
+
+  ss = ddsrt_malloc (sizeof (*ss));
+  ss->shared_secret = ddsrt_malloc (SHARED_SECRET_SIZE);
+  ss->shared_secret_size = SHARED_SECRET_SIZE;
+  for (int32_t i = 0; i < ss->shared_secret_size; i++)
+    ss->shared_secret[i] = (unsigned char) (i % 20);
+  for (int32_t i = 0; i < 32; i++)
+  {
+    ss->challenge1[i] = (unsigned char) (i % 15);
+    ss->challenge2[i] = (unsigned char) (i % 12);
+  }
+  shared_secret_handle = (DDS_Security_SharedSecretHandle) ss;
+
+  memset (&props, 0, sizeof (props));
+  memset (&attrs, 0, sizeof (attrs));
+  attrs.is_rtps_protected = true;
+  attrs.plugin_participant_attributes = DDS_SECURITY_PARTICIPANT_ATTRIBUTES_FLAG_IS_VALID | DDS_SECURITY_PLUGIN_PARTICIPANT_ATTRIBUTES_FLAG_IS_RTPS_ENCRYPTED;
+  local_participant_handle = crypto->crypto_key_factory->register_local_participant (crypto->crypto_key_factory, 1, 3, &props, &attrs, &ex);
+  check (local_participant_handle != DDS_SECURITY_HANDLE_NIL, "register_local_participant", &ex);
+  remote_participant_handle = crypto->crypto_key_factory->register_matched_remote_participant (crypto->crypto_key_factory, local_participant_handle, 2, 5, shared_secret_handle, &ex);
+  check (remote_participant_handle != DDS_SECURITY_HANDLE_NIL, "register_matched_remote_participant", &ex);
+}
+
+static void teardown (void)
+{
+  DDS_Security_SecurityException ex = {NULL, 0, 0};
+  DDS_Security_SharedSecretHandleImpl *ss = (DDS_Security_SharedSecretHandleImpl *) shared_secret_handle;
+  (void) crypto->crypto_key_factory->unregister_participant (crypto->crypto_key_factory, remote_participant_handle, &ex);
+  DDS_Security_Exception_reset (&ex);
+  (void) crypto->crypto_key_factory->unregister_participant (crypto->crypto_key_factory, local_participant_handle, &ex);
+  DDS_Security_Exception_reset (&ex);
+  ddsrt_free (ss->shared_secret);
+  ddsrt_free (ss);
+  (void) finalize_crypto (crypto);
+}
+
+static void unregister_datawriter (DDS_Security_DatawriterCryptoHandle h)
+{
+  DDS_Security_SecurityException ex = {NULL, 0, 0};
+  (void) crypto->crypto_key_factory->unregister_datawriter (crypto->crypto_key_factory, h, &ex);
+  DDS_Security_Exception_reset (&ex);
+}
+
+static void unregister_datareader (DDS_Security_DatareaderCryptoHandle h)
+{
+  DDS_Security_SecurityException ex = {NULL, 0, 0};
+  (void) crypto->crypto_key_factory->unregister_datareader (crypto->crypto_key_factory, h, &ex);
+  DDS_Security_Exception_reset (&ex);
+}
+
+static void exchange_datawriter_tokens (DDS_Security_DatawriterCryptoHandle local_writer, DDS_Security_DatareaderCryptoHandle remote_reader, DDS_Security_DatareaderCryptoHandle local_reader, DDS_Security_DatawriterCryptoHandle remote_writer)
+{
+  DDS_Security_SecurityException ex = {NULL, 0, 0};
+  DDS_Security_DatawriterCryptoTokenSeq tokens;
+  memset (&tokens, 0, sizeof (tokens));
+  check (crypto->crypto_key_exchange->create_local_datawriter_crypto_tokens (crypto->crypto_key_exchange, &tokens, local_writer, remote_reader, &ex), "create_local_datawriter_crypto_tokens", &ex);
+  check (crypto->crypto_key_exchange->set_remote_datawriter_crypto_tokens (crypto->crypto_key_exchange, local_reader, remote_writer, &tokens, &ex), "set_remote_datawriter_crypto_tokens", &ex);
+  (void) crypto->crypto_key_exchange->return_crypto_tokens (crypto->crypto_key_exchange, &tokens, &ex);
+  DDS_Security_Exception_reset (&ex);
+}
+
+static uint32_t get_transformation_kind (uint32_t key_size, bool encrypted)
+{
+  if (key_size == 128)
+    return encrypted ? CRYPTO_TRANSFORMATION_KIND_AES128_GCM : CRYPTO_TRANSFORMATION_KIND_AES128_GMAC;
+  else
+    return encrypted ? CRYPTO_TRANSFORMATION_KIND_AES256_GCM : CRYPTO_TRANSFORMATION_KIND_AES256_GMAC;
+}
+
+static void payload_throughput (uint32_t rounds, uint32_t key_size, bool encrypted)
+{
+  DDS_Security_SecurityException ex = {NULL, 0, 0};
+  DDS_Security_PropertySeq props;
+  DDS_Security_EndpointSecurityAttributes attrs;
+  DDS_Security_OctetSeq extra_inline_qos, plain_buffer;
+  dds_duration_t tencode = 0, tdecode = 0;
+
+  memset (&props, 0, sizeof (props));
+  memset (&extra_inline_qos, 0, sizeof (extra_inline_qos));
+  plain_buffer._length = plain_buffer._maximum = (uint32_t) strlen (sample_test_data) + 1;
+  plain_buffer._buffer = (unsigned char *) ddsrt_strdup (sample_test_data);
+
+  memset (&attrs, 0, sizeof (attrs));
+  attrs.is_discovery_protected = true;
+  attrs.is_submessage_protected = true;
+  attrs.is_payload_protected = true;
+  attrs.plugin_endpoint_attributes = DDS_SECURITY_PLUGIN_ENDPOINT_ATTRIBUTES_FLAG_IS_SUBMESSAGE_ENCRYPTED;
+  if (encrypted)
+    attrs.plugin_endpoint_attributes |= DDS_SECURITY_PLUGIN_ENDPOINT_ATTRIBUTES_FLAG_IS_PAYLOAD_ENCRYPTED;
+  const DDS_Security_DatawriterCryptoHandle local_writer = crypto->crypto_key_factory->register_local_datawriter (crypto->crypto_key_factory, local_participant_handle, &props, &attrs, &ex);
+  check (local_writer != 0, "register_local_datawriter", &ex);
+  session_key_material * const session_keys = ((local_datawriter_crypto *) local_writer)->writer_session_payload;
+  session_keys->master_key_material->transformation_kind = get_transformation_kind (key_size, encrypted);
+  session_keys->key_size = key_size;
+
+  memset (&attrs, 0, sizeof (attrs));
+  attrs.is_payload_protected = true;
+  if (encrypted)
+    attrs.plugin_endpoint_attributes = DDS_SECURITY_PLUGIN_ENDPOINT_ATTRIBUTES_FLAG_IS_PAYLOAD_ENCRYPTED;
+  const DDS_Security_DatareaderCryptoHandle local_reader = crypto->crypto_key_factory->register_local_datareader (crypto->crypto_key_factory, local_participant_handle, &props, &attrs, &ex);
+  check (local_reader != 0, "register_local_datareader", &ex);
+  const DDS_Security_DatareaderCryptoHandle remote_reader = crypto->crypto_key_factory->register_matched_remote_datareader (crypto->crypto_key_factory, local_writer, remote_participant_handle, shared_secret_handle, true, &ex);
+  check (remote_reader != 0, "register_matched_remote_datareader", &ex);
+  const DDS_Security_DatawriterCryptoHandle remote_writer = crypto->crypto_key_factory->register_matched_remote_datawriter (crypto->crypto_key_factory, local_reader, remote_participant_handle, shared_secret_handle, &ex);
+  check (remote_writer != 0, "register_matched_remote_datawriter", &ex);
+  exchange_datawriter_tokens (local_writer, remote_reader, local_reader, remote_writer);
+
+  const uint32_t session_id = session_keys->id;
+  for (uint32_t i = 0; i < rounds; i++)
+  {
+    DDS_Security_OctetSeq encoded_buffer = {0, 0, NULL};
+    DDS_Security_OctetSeq decoded_buffer = {0, 0, NULL};
+
+    /* force a new session key halfway through, the cached cipher contexts
+       on both sides must follow it */
+    if (i == rounds / 2)
+      session_keys->block_counter = session_keys->max_blocks_per_session;
+
+    const ddsrt_mtime_t t0 = ddsrt_time_monotonic ();
+    check (crypto->crypto_transform->encode_serialized_payload (crypto->crypto_transform, &encoded_buffer, &extra_inline_qos, &plain_buffer, local_writer, &ex), "encode_serialized_payload", &ex);
+    const ddsrt_mtime_t t1 = ddsrt_time_monotonic ();
+    check (crypto->crypto_transform->decode_serialized_payload (crypto->crypto_transform, &decoded_buffer, &encoded_buffer, &extra_inline_qos, local_reader, remote_writer, &ex), "decode_serialized_payload", &ex);
+    const ddsrt_mtime_t t2 = ddsrt_time_monotonic ();
+    check (decoded_buffer._length == plain_buffer._length && memcmp (decoded_buffer._buffer, plain_buffer._buffer, plain_buffer._length) == 0, "payload comparison", NULL);
+
+    tencode += t1.v - t0.v;
+    tdecode += t2.v - t1.v;
+    DDS_Security_OctetSeq_deinit (&encoded_buffer);
+    DDS_Security_OctetSeq_deinit (&decoded_buffer);
+  }
+  check (rounds < 2 || session_keys->id != session_id, "rekey", NULL);
+
+  printf ("payload %s %"PRIu32": %"PRIu32" x %"PRIu32" bytes: encode %.0f ns/sample, decode %.0f ns/sample\n",
+          encrypted ? "encrypt" : "sign", key_size, rounds, plain_buffer._length,
+          (double) tencode / rounds, (double) tdecode / rounds);
+
+  unregister_datareader (remote_reader);
+  unregister_datawriter (remote_writer);
+  unregister_datareader (local_reader);
+  unregister_datawriter (local_writer);
+  DDS_Security_OctetSeq_deinit (&plain_buffer);
+}
+
+static void submessage_sign_throughput (uint32_t rounds, uint32_t nreaders)
+{
+  DDS_Security_SecurityException ex = {NULL, 0, 0};
+  DDS_Security_PropertySeq props;
+  DDS_Security_EndpointSecurityAttributes attrs;
+  DDS_Security_DatareaderCryptoHandleSeq reader_list;
+  DDS_Security_OctetSeq plain_buffer;
+  dds_duration_t tencode = 0;
+  uint32_t ncalls = 0;
+
+  /* a DATA submessage (id 0x15) in native byte order carrying the test data */
+  const uint16_t length = (uint16_t) (strlen (sample_test_data) + 1);
+  plain_buffer._length = plain_buffer._maximum = 4u + length;
+  plain_buffer._buffer = ddsrt_malloc (plain_buffer._length);
+  plain_buffer._buffer[0] = 0x15;
+  plain_buffer._buffer[1] = (DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN) ? 1 : 0;
+  memcpy (plain_buffer._buffer + 2, &length, sizeof (length));
+  memcpy (plain_buffer._buffer + 4, sample_test_data, length);
+
+  props._length = props._maximum = 1;
+  props._buffer = DDS_Security_PropertySeq_allocbuf (1);
+  props._buffer[0].name = ddsrt_strdup ("dds.sec.crypto.keysize");
+  props._buffer[0].value = ddsrt_strdup ("256");
+  props._buffer[0].propagate = false;
+  memset (&attrs, 0, sizeof (attrs));
+  attrs.is_discovery_protected = true;
+  attrs.is_submessage_protected = true;
+  attrs.plugin_endpoint_attributes = DDS_SECURITY_PLUGIN_ENDPOINT_ATTRIBUTES_FLAG_IS_SUBMESSAGE_ORIGIN_AUTHENTICATED;
+  const DDS_Security_DatawriterCryptoHandle local_writer = crypto->crypto_key_factory->register_local_datawriter (crypto->crypto_key_factory, local_participant_handle, &props, &attrs, &ex);
+  check (local_writer != 0, "register_local_datawriter", &ex);
+
+  reader_list._length = reader_list._maximum = nreaders;
+  reader_list._buffer = DDS_Security_DatareaderCryptoHandleSeq_allocbuf (nreaders);
+  for (uint32_t i = 0; i < nreaders; i++)
+  {
+    reader_list._buffer[i] = crypto->crypto_key_factory->register_matched_remote_datareader (crypto->crypto_key_factory, local_writer, remote_participant_handle, shared_secret_handle, true, &ex);
+    check (reader_list._buffer[i] != 0, "register_matched_remote_datareader", &ex);
+  }
+
+  for (uint32_t r = 0; r < rounds; r++)
+  {
+    DDS_Security_OctetSeq encoded_buffer = {0, 0, NULL};
+    DDS_Security_OctetSeq *buffer = &plain_buffer;
+    int32_t index = 0;
+    const ddsrt_mtime_t t0 = ddsrt_time_monotonic ();
+    while (index != (int32_t) nreaders)
+    {
+      check (crypto->crypto_transform->encode_datawriter_submessage (crypto->crypto_transform, &encoded_buffer, buffer, local_writer, &reader_list, &index, &ex), "encode_datawriter_submessage", &ex);
+      buffer = NULL;
+      ncalls++;
+    }
+    const ddsrt_mtime_t t1 = ddsrt_time_monotonic ();
+    tencode += t1.v - t0.v;
+    DDS_Security_OctetSeq_deinit (&encoded_buffer);
+  }
+
+  printf ("submessage sign 256: %"PRIu32" readers: %"PRIu32" samples: %.1f calls/sample, encode %.0f ns/sample\n",
+          nreaders, rounds, (double) ncalls / rounds, (double) tencode / rounds);
+
+  for (uint32_t i = 0; i < nreaders; i++)
+    unregister_datareader (reader_list._buffer[i]);
+  unregister_datawriter (local_writer);
+  DDS_Security_DatareaderCryptoHandleSeq_deinit (&reader_list);
+  DDS_Security_PropertySeq_deinit (&props);
+  DDS_Security_OctetSeq_deinit (&plain_buffer);
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t rounds = 20000, nreaders = 100;
+  if (argc > 1)
+    rounds = (uint32_t) strtoul (argv[1], NULL, 0);
+  if (argc > 2)
+    nreaders = (uint32_t) strtoul (argv[2], NULL, 0);
+  if (rounds == 0)
+    rounds = 1;
+
+  setup ();
+  payload_throughput (rounds, 128, true);
+  payload_throughput (rounds, 256, true);
+  payload_throughput (rounds, 256, false);
+  /* a MAC per reader makes this much more expensive per sample */
+  submessage_sign_throughput ((rounds + 9) / 10, nreaders);
+  teardown ();
+  return 0;
+}
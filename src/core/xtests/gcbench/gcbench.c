@@ -0,0 +1,190 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/threads.h"
+#include "dds/ddsi/q_thread.h"
+#include "dds/ddsi/q_gc.h"
+#include "dds/ddsi/q_entity.h"
+#include "dds/ddsi/q_addrset.h"
+#include "dds/ddsi/q_rtps.h"
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds/ddsi/ddsi_vendor.h"
+#include "dds/ddsi/ddsi_entity_index.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "xtests_util.h"
+
+/* Benchmark for the garbage collector: creates a proxy participant with
+   many proxy endpoints, then deletes all endpoints while a number of
+   application threads keep going in and out of the "awake" state, and
+   measures how long it takes before they have all been reclaimed.  A
+   marker request is enqueued every so often to measure the latency of
+   individual requests.  Usage: gcbench [NENDPOINTS [NTHREADS]] */
+
+#define NMARKERS 100
+
+struct marker {
+  dds_time_t tenq;
+  dds_time_t tdone;
+};
+
+struct appthread_arg {
+  struct ddsi_domaingv *gv;
+  ddsi_guid_t ppguid;
+  ddsrt_atomic_uint32_t *stop;
+};
+
+static uint32_t appthread (void *varg)
+{
+  struct appthread_arg * const arg = varg;
+  struct thread_state1 * const ts1 = lookup_thread_state ();
+  while (!ddsrt_atomic_ld32 (arg->stop))
+  {
+    thread_state_awake (ts1, arg->gv);
+    (void) entidx_lookup_proxy_participant_guid (arg->gv->entity_index, &arg->ppguid);
+    thread_state_asleep (ts1);
+    dds_sleepfor (DDS_USECS (100));
+  }
+  return 0;
+}
+
+static void marker_cb (struct gcreq *gcreq)
+{
+  struct marker *m = gcreq->arg;
+  m->tdone = dds_time ();
+  gcreq_free (gcreq);
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t nendpoints = 100000, nthreads = 64;
+  if (argc > 1)
+    nendpoints = (uint32_t) strtoul (argv[1], NULL, 0);
+  if (argc > 2)
+    nthreads = (uint32_t) strtoul (argv[2], NULL, 0);
+  if (nendpoints == 0)
+    nendpoints = 1;
+
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  if (pp < 0)
+    return 1;
+  struct ddsi_domaingv * const gv = get_domaingv (pp);
+  struct thread_state1 * const ts1 = lookup_thread_state ();
+  const ddsrt_wctime_t tnow = ddsrt_time_wallclock ();
+
+  ddsi_guid_t ppguid;
+  ppguid.prefix.u[0] = ddsrt_random ();
+  ppguid.prefix.u[1] = ddsrt_random ();
+  ppguid.prefix.u[2] = ddsrt_random ();
+  ppguid.entityid.u = NN_ENTITYID_PARTICIPANT;
+
+  struct addrset *as = new_addrset ();
+  ddsi_plist_t pp_plist, wr_plist, rd_plist;
+  ddsi_plist_init_empty (&pp_plist);
+  make_endpoint_plist (&wr_plist, "gcbench", "gcbench::T", &gv->default_xqos_wr);
+  make_endpoint_plist (&rd_plist, "gcbench", "gcbench::T", &gv->default_xqos_rd);
+
+  thread_state_awake (ts1, gv);
+  new_proxy_participant (gv, &ppguid, 0, NULL, ref_addrset (as), ref_addrset (as), &pp_plist, DDS_INFINITY, NN_VENDORID_ECLIPSE, CF_PROXYPP_NO_SPDP, tnow, 1);
+  thread_state_asleep (ts1);
+  for (uint32_t i = 0; i < nendpoints; i++)
+  {
+    const ddsi_guid_t guid = make_endpoint_guid (&ppguid.prefix, i, (i % 2) == 0);
+    thread_state_awake (ts1, gv);
+    if (i % 2)
+    {
+#ifdef DDS_HAS_SSM
+      new_proxy_reader (gv, &ppguid, &guid, as, &rd_plist, tnow, 1, 0);
+#else
+      new_proxy_reader (gv, &ppguid, &guid, as, &rd_plist, tnow, 1);
+#endif
+    }
+    else
+    {
+      new_proxy_writer (gv, &ppguid, &guid, as, &wr_plist, gv->builtins_dqueue, gv->xevents, tnow, 1);
+    }
+    thread_state_asleep (ts1);
+  }
+
+  ddsrt_atomic_uint32_t stop = DDSRT_ATOMIC_UINT32_INIT (0);
+  struct appthread_arg aarg = { .gv = gv, .ppguid = ppguid, .stop = &stop };
+  ddsrt_thread_t *tids = ddsrt_malloc (nthreads * sizeof (*tids));
+  ddsrt_threadattr_t tattr;
+  ddsrt_threadattr_init (&tattr);
+  for (uint32_t i = 0; i < nthreads; i++)
+  {
+    if (ddsrt_thread_create (&tids[i], "app", &tattr, appthread, &aarg) != DDS_RETCODE_OK)
+    {
+      nthreads = i;
+      break;
+    }
+  }
+
+  struct marker markers[NMARKERS];
+  const uint32_t marker_interval = (nendpoints + NMARKERS - 1) / NMARKERS;
+  uint32_t nmarkers = 0;
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < nendpoints; i++)
+  {
+    const ddsi_guid_t guid = make_endpoint_guid (&ppguid.prefix, i, (i % 2) == 0);
+    thread_state_awake (ts1, gv);
+    if (i % 2)
+      delete_proxy_reader (gv, &guid, tnow, 0);
+    else
+      delete_proxy_writer (gv, &guid, tnow, 0);
+    if ((i % marker_interval) == 0 && nmarkers < NMARKERS)
+    {
+      struct gcreq *gcreq = gcreq_new (gv->gcreq_queue, marker_cb);
+      markers[nmarkers].tenq = dds_time ();
+      gcreq->arg = &markers[nmarkers++];
+      gcreq_enqueue (gcreq);
+    }
+    thread_state_asleep (ts1);
+  }
+  const dds_time_t t1 = dds_time ();
+  gcreq_queue_drain (gv->gcreq_queue);
+  const dds_time_t t2 = dds_time ();
+
+  ddsrt_atomic_st32 (&stop, 1);
+  for (uint32_t i = 0; i < nthreads; i++)
+    ddsrt_thread_join (tids[i], NULL);
+  ddsrt_free (tids);
+
+  dds_duration_t sumlat = 0, maxlat = 0;
+  for (uint32_t i = 0; i < nmarkers; i++)
+  {
+    const dds_duration_t lat = markers[i].tdone - markers[i].tenq;
+    sumlat += lat;
+    if (lat > maxlat)
+      maxlat = lat;
+  }
+  printf ("%"PRIu32" endpoints, %"PRIu32" threads: delete %.2f us/op, reclaimed %.1f ms after last delete, request latency mean %.1f ms max %.1f ms\n",
+          nendpoints, nthreads, (double) (t1 - t0) / 1e3 / nendpoints, (double) (t2 - t1) / 1e6,
+          (double) sumlat / 1e6 / (nmarkers ? nmarkers : 1), (double) maxlat / 1e6);
+
+  thread_state_awake (ts1, gv);
+  delete_proxy_participant_by_guid (gv, &ppguid, tnow, 0);
+  thread_state_asleep (ts1);
+  ddsi_plist_fini (&rd_plist);
+  ddsi_plist_fini (&wr_plist);
+  ddsi_plist_fini (&pp_plist);
+  unref_addrset (as);
+  dds_delete (pp);
+  return 0;
+}
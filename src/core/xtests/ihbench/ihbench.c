@@ -0,0 +1,119 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "IhBenchTypes.h"
+
+/* Measures the cost of operations addressing an instance by its handle
+   (dds_instance_get_key, dds_dispose_ih, dds_unregister_instance_ih) as a
+   function of the number of instances, which should be independent of it.
+   Usage: ihbench [MAXINSTANCES] */
+
+static double ns_per_op (dds_time_t t0, dds_time_t t1, uint32_t n)
+{
+  return (double) (t1 - t0) / (double) n;
+}
+
+static int run (dds_entity_t pp, dds_entity_t tp, uint32_t n)
+{
+  dds_instance_handle_t *ihs = ddsrt_malloc (n * sizeof (*ihs));
+  dds_entity_t wr;
+  dds_time_t t0, t1, t2, t3;
+  dds_return_t rc;
+  int result = 0;
+
+  if ((wr = dds_create_writer (pp, tp, NULL, NULL)) < 0)
+  {
+    fprintf (stderr, "dds_create_writer: %s\n", dds_strretcode (wr));
+    ddsrt_free (ihs);
+    return 1;
+  }
+  for (uint32_t i = 0; i < n; i++)
+  {
+    IhBench_Inst s = { .k = i, .v = 0 };
+    if ((rc = dds_register_instance (wr, &ihs[i], &s)) < 0)
+    {
+      fprintf (stderr, "dds_register_instance: %s\n", dds_strretcode (rc));
+      result = 1;
+      goto out;
+    }
+  }
+
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    IhBench_Inst s;
+    if ((rc = dds_instance_get_key (wr, ihs[i], &s)) < 0 || s.k != i)
+    {
+      fprintf (stderr, "dds_instance_get_key: %s (key %"PRIu32")\n", dds_strretcode (rc), i);
+      result = 1;
+      goto out;
+    }
+  }
+  t1 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if ((rc = dds_dispose_ih (wr, ihs[i])) < 0)
+    {
+      fprintf (stderr, "dds_dispose_ih: %s\n", dds_strretcode (rc));
+      result = 1;
+      goto out;
+    }
+  }
+  t2 = dds_time ();
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if ((rc = dds_unregister_instance_ih (wr, ihs[i])) < 0)
+    {
+      fprintf (stderr, "dds_unregister_instance_ih: %s\n", dds_strretcode (rc));
+      result = 1;
+      goto out;
+    }
+  }
+  t3 = dds_time ();
+  printf ("%8"PRIu32" instances: get_key %8.1f ns  dispose_ih %8.1f ns  unregister_ih %8.1f ns\n",
+          n, ns_per_op (t0, t1, n), ns_per_op (t1, t2, n), ns_per_op (t2, t3, n));
+
+out:
+  (void) dds_delete (wr);
+  ddsrt_free (ihs);
+  return result;
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t maxn = 100000;
+  dds_entity_t pp, tp;
+  int result = 0;
+
+  if (argc > 1)
+    maxn = (uint32_t) strtoul (argv[1], NULL, 0);
+  if ((pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL)) < 0)
+  {
+    fprintf (stderr, "dds_create_participant: %s\n", dds_strretcode (pp));
+    return 1;
+  }
+  if ((tp = dds_create_topic (pp, &IhBench_Inst_desc, "ihbench", NULL, NULL)) < 0)
+  {
+    fprintf (stderr, "dds_create_topic: %s\n", dds_strretcode (tp));
+    (void) dds_delete (pp);
+    return 1;
+  }
+  for (uint32_t n = 1000; n <= maxn && result == 0; n *= 10)
+    result = run (pp, tp, n);
+  (void) dds_delete (pp);
+  return result;
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/endian.h"
+#include "dds/ddsi/q_thread.h"
+#include "dds/ddsi/q_entity.h"
+#include "dds/ddsi/q_protocol.h"
+#include "dds/ddsi/q_bswap.h"
+#include "dds/ddsi/q_misc.h"
+#include "dds/ddsi/q_rtps.h"
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds/ddsi/ddsi_entity_index.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "xtests_util.h"
+#include "SedpBenchTypes.h"
+
+/* Benchmark for processing SEDP messages: makes a local participant with
+   NLOCAL readers (or writers) discover a fake remote participant through
+   an SPDP message and then sends it NREMOTE SEDP publications (or
+   subscriptions), packed many to a packet, for endpoints that all match
+   the local ones.  It measures the time from sending the first SEDP
+   message until all proxy endpoints exist.  The fake participant
+   advertises an unused port on the loopback interface, so anything sent
+   to it is discarded.  Usage: sedpbench [NREMOTE [NLOCAL [writers|readers]]] */
+
+#define MAX_PACKET_SIZE 8192
+
+struct packet {
+  uint32_t size;
+  uint32_t firstidx; /* index of first endpoint in packet */
+  unsigned char buf[MAX_PACKET_SIZE];
+};
+
+static void make_spdp (struct packet *p, struct ddsi_domaingv *gv, const ddsi_guid_prefix_t *prefix)
+{
+  struct nn_locators_one locs[2];
+  ddsi_plist_t ps;
+  make_spdp_plist (&ps, locs, prefix, 39999);
+  init_rtps_message (p->buf, &p->size, prefix);
+  (void) append_data_submsg (p->buf, &p->size, (uint32_t) sizeof (p->buf), gv->spdp_type, NN_ENTITYID_SPDP_BUILTIN_PARTICIPANT_WRITER, NN_ENTITYID_SPDP_BUILTIN_PARTICIPANT_READER, 1, &ps);
+  ddsi_plist_fini (&ps);
+}
+
+static uint32_t make_sedp (struct packet **packets, struct ddsi_domaingv *gv, const ddsi_guid_prefix_t *prefix, bool remote_writers, uint32_t nremote)
+{
+  const struct ddsi_sertype *type = remote_writers ? gv->sedp_writer_type : gv->sedp_reader_type;
+  const uint32_t wrid = remote_writers ? NN_ENTITYID_SEDP_BUILTIN_PUBLICATIONS_WRITER : NN_ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_WRITER;
+  const uint32_t rdid = remote_writers ? NN_ENTITYID_SEDP_BUILTIN_PUBLICATIONS_READER : NN_ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_READER;
+  uint32_t npackets = 0, maxpackets = 16;
+  *packets = ddsrt_malloc (maxpackets * sizeof (**packets));
+  for (uint32_t i = 0; i < nremote; )
+  {
+    if (npackets == maxpackets)
+    {
+      maxpackets *= 2;
+      *packets = ddsrt_realloc (*packets, maxpackets * sizeof (**packets));
+    }
+    struct packet * const p = &(*packets)[npackets++];
+    init_rtps_message (p->buf, &p->size, prefix);
+    p->firstidx = i;
+    while (i < nremote)
+    {
+      ddsi_plist_t ps;
+      ddsi_plist_init_empty (&ps);
+      ps.present |= PP_ENDPOINT_GUID | PP_PROTOCOL_VERSION | PP_VENDORID;
+      ps.endpoint_guid = make_endpoint_guid (prefix, i, remote_writers);
+      ps.protocol_version.major = RTPS_MAJOR;
+      ps.protocol_version.minor = RTPS_MINOR;
+      ps.vendorid = NN_VENDORID_ECLIPSE;
+      ps.qos.present |= QP_TOPIC_NAME | QP_TYPE_NAME | QP_RELIABILITY;
+      ps.qos.aliased |= QP_TOPIC_NAME | QP_TYPE_NAME;
+      ps.qos.topic_name = "sedpbench";
+      ps.qos.type_name = "SedpBench::Msg";
+      ps.qos.reliability.kind = DDS_RELIABILITY_RELIABLE;
+      ps.qos.reliability.max_blocking_time = DDS_MSECS (100);
+      const bool ok = append_data_submsg (p->buf, &p->size, (uint32_t) sizeof (p->buf), type, wrid, rdid, i + 1, &ps);
+      ddsi_plist_fini (&ps);
+      if (!ok)
+        break;
+      i++;
+    }
+  }
+  return npackets;
+}
+
+static bool known (struct ddsi_domaingv *gv, const ddsi_guid_t *guid, bool remote_writers)
+{
+  struct thread_state1 * const ts1 = lookup_thread_state ();
+  bool res;
+  thread_state_awake (ts1, gv);
+  if (remote_writers)
+    res = (entidx_lookup_proxy_writer_guid (gv->entity_index, guid) != NULL);
+  else
+    res = (entidx_lookup_proxy_reader_guid (gv->entity_index, guid) != NULL);
+  thread_state_asleep (ts1);
+  return res;
+}
+
+static void send_heartbeat (struct ddsi_domaingv *gv, const ddsi_locator_t *dst, const ddsi_guid_prefix_t *prefix, bool remote_writers, seqno_t lastseq, nn_count_t count)
+{
+  unsigned char buf[sizeof (Header_t) + sizeof (Heartbeat_t)];
+  uint32_t size;
+  Heartbeat_t hb;
+  init_rtps_message (buf, &size, prefix);
+  hb.smhdr.submessageId = SMID_HEARTBEAT;
+  hb.smhdr.flags = HEARTBEAT_FLAG_FINAL | ((DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN) ? SMFLAG_ENDIANNESS : 0);
+  hb.smhdr.octetsToNextHeader = (uint16_t) (sizeof (hb) - RTPS_SUBMESSAGE_HEADER_SIZE);
+  hb.readerId = nn_hton_entityid ((ddsi_entityid_t) { remote_writers ? NN_ENTITYID_SEDP_BUILTIN_PUBLICATIONS_READER : NN_ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_READER });
+  hb.writerId = nn_hton_entityid ((ddsi_entityid_t) { remote_writers ? NN_ENTITYID_SEDP_BUILTIN_PUBLICATIONS_WRITER : NN_ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_WRITER });
+  hb.firstSN = toSN (1);
+  hb.lastSN = toSN (lastseq);
+  hb.count = count;
+  memcpy (buf + size, &hb, sizeof (hb));
+  size += (uint32_t) sizeof (hb);
+  send_rtps_message (gv, dst, buf, size);
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t nremote = 5000, nlocal = 4;
+  bool remote_writers = false;
+  if (argc > 1)
+    nremote = (uint32_t) strtoul (argv[1], NULL, 0);
+  if (argc > 2)
+    nlocal = (uint32_t) strtoul (argv[2], NULL, 0);
+  if (argc > 3)
+  {
+    if (strcmp (argv[3], "writers") == 0)
+      remote_writers = true;
+    else if (strcmp (argv[3], "readers") == 0)
+      remote_writers = false;
+    else
+    {
+      fprintf (stderr, "%s: invalid kind\n", argv[3]);
+      return 1;
+    }
+  }
+  if (nremote == 0 || nremote > 1000000)
+    nremote = 1;
+
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  if (pp < 0)
+    return 1;
+  const dds_entity_t tp = dds_create_topic (pp, &SedpBench_Msg_desc, "sedpbench", NULL, NULL);
+  if (tp < 0)
+  {
+    fprintf (stderr, "dds_create_topic: %s\n", dds_strretcode (tp));
+    return 1;
+  }
+  dds_entity_t *eps = ddsrt_malloc ((nlocal > 0 ? nlocal : 1) * sizeof (*eps));
+  for (uint32_t i = 0; i < nlocal; i++)
+  {
+    eps[i] = remote_writers ? dds_create_reader (pp, tp, NULL, NULL) : dds_create_writer (pp, tp, NULL, NULL);
+    if (eps[i] < 0)
+    {
+      fprintf (stderr, "dds_create_%s: %s\n", remote_writers ? "reader" : "writer", dds_strretcode (eps[i]));
+      return 1;
+    }
+  }
+
+  struct ddsi_domaingv * const gv = get_domaingv (pp);
+  ddsi_locator_t dst = gv->interfaces[0].extloc;
+  dst.port = gv->loc_meta_uc.port;
+
+  ddsi_guid_prefix_t prefix;
+  prefix.u[0] = ddsrt_random ();
+  prefix.u[1] = ddsrt_random ();
+  prefix.u[2] = ddsrt_random ();
+  const ddsi_guid_t sedp_wr_guid = {
+    .prefix = prefix,
+    .entityid = { remote_writers ? NN_ENTITYID_SEDP_BUILTIN_PUBLICATIONS_WRITER : NN_ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_WRITER }
+  };
+
+  /* discovery of the fake participant, which has to have progressed to the
+     point where the proxy writer for its SEDP writer exists and is matched,
+     or the SEDP messages would be dropped */
+  struct packet *spdp = ddsrt_malloc (sizeof (*spdp));
+  make_spdp (spdp, gv, &prefix);
+  const dds_time_t tend = dds_time () + DDS_SECS (60);
+  bool ready = false;
+  while (!ready && dds_time () < tend)
+  {
+    struct thread_state1 * const ts1 = lookup_thread_state ();
+    struct proxy_writer *pwr;
+    thread_state_awake (ts1, gv);
+    if ((pwr = entidx_lookup_proxy_writer_guid (gv->entity_index, &sedp_wr_guid)) != NULL)
+    {
+      ddsrt_mutex_lock (&pwr->e.lock);
+      ready = !ddsrt_avl_is_empty (&pwr->readers);
+      ddsrt_mutex_unlock (&pwr->e.lock);
+    }
+    thread_state_asleep (ts1);
+    if (!ready)
+    {
+      send_rtps_message (gv, &dst, spdp->buf, spdp->size);
+      dds_sleepfor (DDS_MSECS (10));
+    }
+  }
+  ddsrt_free (spdp);
+
+  struct packet *packets;
+  const uint32_t npackets = make_sedp (&packets, gv, &prefix, remote_writers, nremote);
+
+  /* SEDP is reliable and samples are delivered in order, so after a packet
+     loss nothing gets delivered until the missing one is resent.  The
+     acknowledgements go to the fake participant's locator and are lost, so
+     instead the progress is tracked by looking up the proxy endpoints and
+     at most WINDOW packets are outstanding, which is typically well within
+     the socket receive buffer.  If there is no progress for a while,
+     everything not yet processed is resent.  A heartbeat precedes the data
+     because a reliable proxy writer only delivers data once it has seen a
+     heartbeat. */
+#define WINDOW 16
+  const dds_time_t t0 = dds_time ();
+  uint32_t next = 0, done = 0, resends = 0;
+  nn_count_t hbcount = 1;
+  dds_time_t tprogress = t0;
+  send_heartbeat (gv, &dst, &prefix, remote_writers, (seqno_t) nremote, hbcount++);
+  while (done < npackets && dds_time () < tend)
+  {
+    for (; next < npackets && next < done + WINDOW; next++)
+      send_rtps_message (gv, &dst, packets[next].buf, packets[next].size);
+    dds_sleepfor (DDS_USECS (100));
+    /* all of packet "done" has been processed if the first endpoint of the
+       next one (or the last endpoint, for the final packet) is known */
+    const uint32_t done0 = done;
+    while (done < npackets)
+    {
+      const uint32_t idx = (done + 1 < npackets) ? packets[done + 1].firstidx : nremote - 1;
+      const ddsi_guid_t guid = make_endpoint_guid (&prefix, idx, remote_writers);
+      if (!known (gv, &guid, remote_writers))
+        break;
+      done++;
+    }
+    const dds_time_t tnow = dds_time ();
+    if (done > done0)
+      tprogress = tnow;
+    else if (tnow - tprogress > DDS_MSECS (100))
+    {
+      send_heartbeat (gv, &dst, &prefix, remote_writers, (seqno_t) nremote, hbcount++);
+      next = done;
+      tprogress = tnow;
+      resends++;
+    }
+  }
+  const dds_time_t t1 = dds_time ();
+
+  uint32_t ndiscovered = 0;
+  for (uint32_t i = 0; i < nremote; i++)
+  {
+    const ddsi_guid_t guid = make_endpoint_guid (&prefix, i, remote_writers);
+    if (known (gv, &guid, remote_writers))
+      ndiscovered++;
+  }
+
+  /* every local endpoint must have been matched with all remote ones */
+  uint32_t nmatched = 0;
+  for (uint32_t i = 0; i < nlocal; i++)
+  {
+    uint32_t count = 0;
+    if (remote_writers)
+    {
+      dds_subscription_matched_status_t st;
+      if (dds_get_subscription_matched_status (eps[i], &st) == 0)
+        count = st.current_count;
+    }
+    else
+    {
+      dds_publication_matched_status_t st;
+      if (dds_get_publication_matched_status (eps[i], &st) == 0)
+        count = st.current_count;
+    }
+    if (count == nremote)
+      nmatched++;
+  }
+
+  printf ("%"PRIu32" remote %s in %"PRIu32" packets, %"PRIu32" local: %.2f us/endpoint (%"PRIu32" resends)\n",
+          nremote, remote_writers ? "writers" : "readers", npackets, nlocal,
+          (double) (t1 - t0) / 1e3 / nremote, resends);
+
+  ddsrt_free (packets);
+  ddsrt_free (eps);
+  dds_delete (DDS_CYCLONEDDS_HANDLE);
+  return (ndiscovered == nremote && nmatched == nlocal) ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsi/q_thread.h"
+#include "dds/ddsi/q_entity.h"
+#include "dds/ddsi/q_protocol.h"
+#include "dds/ddsi/q_rtps.h"
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds/ddsi/ddsi_entity_index.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "xtests_util.h"
+
+/* Benchmark for discovery of many participants: injects SPDP messages for
+   NPROXYPP fake remote participants into a local participant and measures
+   the time it takes until all of them have been discovered and matched
+   with the local participant's builtin writers.  Then it creates NLOCALPP
+   additional local participants and measures how long that takes, as
+   their builtin endpoints have to be matched with those of all remote
+   participants.  The fake participants advertise locators that refer to
+   unused ports on the loopback interface, so any traffic to them is simply
+   discarded.  Usage: spdpbench [NPROXYPP [NLOCALPP]] */
+
+static void send_spdp (struct ddsi_domaingv *gv, const ddsi_locator_t *dst, const ddsi_guid_prefix_t *prefix, uint32_t port)
+{
+  struct nn_locators_one locs[2];
+  ddsi_plist_t ps;
+  unsigned char buf[1024];
+  uint32_t size;
+  make_spdp_plist (&ps, locs, prefix, port);
+  init_rtps_message (buf, &size, prefix);
+  if (append_data_submsg (buf, &size, (uint32_t) sizeof (buf), gv->spdp_type, NN_ENTITYID_SPDP_BUILTIN_PARTICIPANT_WRITER, NN_ENTITYID_SPDP_BUILTIN_PARTICIPANT_READER, 1, &ps))
+    send_rtps_message (gv, dst, buf, size);
+  ddsi_plist_fini (&ps);
+}
+
+static uint32_t num_matched (struct ddsi_domaingv *gv, const ddsi_guid_t *ppguid, uint32_t entityid)
+{
+  const ddsi_guid_t guid = { .prefix = ppguid->prefix, .entityid = { entityid } };
+  struct writer *wr;
+  uint32_t n = 0;
+  if ((wr = entidx_lookup_writer_guid (gv->entity_index, &guid)) != NULL)
+  {
+    ddsrt_mutex_lock (&wr->e.lock);
+    n = (uint32_t) wr->num_readers;
+    ddsrt_mutex_unlock (&wr->e.lock);
+  }
+  return n;
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t nproxypp = 500, nlocalpp = 10;
+  if (argc > 1)
+    nproxypp = (uint32_t) strtoul (argv[1], NULL, 0);
+  if (argc > 2)
+    nlocalpp = (uint32_t) strtoul (argv[2], NULL, 0);
+  if (nproxypp > 20000)
+    nproxypp = 20000;
+
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  if (pp < 0)
+    return 1;
+  struct ddsi_domaingv * const gv = get_domaingv (pp);
+  struct thread_state1 * const ts1 = lookup_thread_state ();
+  const ddsi_guid_t ppguid = get_entity_guid (pp);
+  ddsi_locator_t dst = gv->interfaces[0].extloc;
+  dst.port = gv->loc_meta_uc.port;
+
+  ddsi_guid_prefix_t *prefixes = ddsrt_malloc ((nproxypp > 0 ? nproxypp : 1) * sizeof (*prefixes));
+  for (uint32_t i = 0; i < nproxypp; i++)
+  {
+    prefixes[i].u[0] = ddsrt_random ();
+    prefixes[i].u[1] = ddsrt_random ();
+    prefixes[i].u[2] = i;
+  }
+
+  /* UDP over loopback may well drop some packets if we send them all at
+     once, so keep sending SPDP messages for the ones not yet discovered,
+     just like a real remote participant would */
+  const dds_time_t t0 = dds_time ();
+  const dds_time_t tend = t0 + DDS_SECS (60);
+  uint32_t ndiscovered = 0;
+  while (ndiscovered < nproxypp && dds_time () < tend)
+  {
+    ndiscovered = 0;
+    for (uint32_t i = 0; i < nproxypp; i++)
+    {
+      const ddsi_guid_t guid = { .prefix = prefixes[i], .entityid = { NN_ENTITYID_PARTICIPANT } };
+      thread_state_awake (ts1, gv);
+      const bool known = (entidx_lookup_proxy_participant_guid (gv->entity_index, &guid) != NULL);
+      thread_state_asleep (ts1);
+      if (known)
+        ndiscovered++;
+      else
+      {
+        send_spdp (gv, &dst, &prefixes[i], 30000 + (i % 20000));
+        if ((i % 64) == 63)
+          dds_sleepfor (DDS_MSECS (1));
+      }
+    }
+    if (ndiscovered < nproxypp)
+      dds_sleepfor (DDS_MSECS (10));
+  }
+  const dds_time_t t1 = dds_time ();
+  bool matched = false;
+  while (!matched && dds_time () < tend)
+  {
+    thread_state_awake (ts1, gv);
+    matched =
+      num_matched (gv, &ppguid, NN_ENTITYID_SEDP_BUILTIN_PUBLICATIONS_WRITER) == nproxypp &&
+      num_matched (gv, &ppguid, NN_ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_WRITER) == nproxypp &&
+      num_matched (gv, &ppguid, NN_ENTITYID_P2P_BUILTIN_PARTICIPANT_MESSAGE_WRITER) == nproxypp;
+    thread_state_asleep (ts1);
+    if (!matched)
+      dds_sleepfor (DDS_MSECS (1));
+  }
+  const dds_time_t t2 = dds_time ();
+
+  dds_entity_t *pps = ddsrt_malloc ((nlocalpp > 0 ? nlocalpp : 1) * sizeof (*pps));
+  for (uint32_t i = 0; i < nlocalpp; i++)
+  {
+    if ((pps[i] = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL)) < 0)
+    {
+      fprintf (stderr, "dds_create_participant: %s\n", dds_strretcode (pps[i]));
+      return 1;
+    }
+  }
+  const dds_time_t t3 = dds_time ();
+
+  printf ("%"PRIu32" proxy participants: discovered %"PRIu32" in %.1f ms, fully matched after %.1f ms; %"PRIu32" local participants: %.2f ms/participant\n",
+          nproxypp, ndiscovered, (double) (t1 - t0) / 1e6, (double) (t2 - t0) / 1e6,
+          nlocalpp, (double) (t3 - t2) / 1e6 / (nlocalpp ? nlocalpp : 1));
+
+  ddsrt_free (pps);
+  ddsrt_free (prefixes);
+  dds_delete (DDS_CYCLONEDDS_HANDLE);
+  return (ndiscovered == nproxypp && matched) ? 0 : 1;
+}
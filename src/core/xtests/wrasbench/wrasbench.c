@@ -0,0 +1,200 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsi/q_thread.h"
+#include "dds/ddsi/q_gc.h"
+#include "dds/ddsi/q_entity.h"
+#include "dds/ddsi/q_addrset.h"
+#include "dds/ddsi/q_rtps.h"
+#include "dds/ddsi/ddsi_plist.h"
+#include "dds/ddsi/ddsi_vendor.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "dds__writer.h"
+#include "xtests_util.h"
+#include "WrasBenchTypes.h"
+
+/* Benchmark for maintaining writer address sets during a discovery storm:
+   creates a number of local writers and then a proxy participant with many
+   proxy readers that all match those writers, followed by deleting the
+   proxy readers again, and measures the time it takes.  In "unique" mode
+   each proxy reader has its own unicast locator, in "shared" mode they all
+   also have the same multicast locator, and in "same" mode all proxy
+   readers have the same unicast locator.  Packets only go to unused ports
+   on the loopback interface.  Usage: wrasbench [NREADERS [NWRITERS [MODE]]] */
+
+enum mode { M_UNIQUE, M_SHARED, M_SAME };
+
+static void get_addrset_counts (dds_entity_t wrh, size_t *nuc, size_t *nmc)
+{
+  dds_writer *wr;
+  if (dds_writer_lock (wrh, &wr) < 0)
+    abort ();
+  ddsrt_mutex_lock (&wr->m_wr->e.lock);
+  *nuc = addrset_count_uc (wr->m_wr->as);
+  *nmc = addrset_count_mc (wr->m_wr->as);
+  ddsrt_mutex_unlock (&wr->m_wr->e.lock);
+  dds_writer_unlock (wr);
+}
+
+static struct addrset *mkaddrset (const struct ddsi_domaingv *gv, enum mode mode, uint32_t i)
+{
+  struct addrset *as = new_addrset ();
+  ddsi_locator_t loc;
+  memset (&loc, 0, sizeof (loc));
+  loc.kind = NN_LOCATOR_KIND_UDPv4;
+  loc.address[12] = 127;
+  loc.address[15] = 1;
+  loc.port = 20000 + ((mode == M_SAME) ? 0 : (i % 40000));
+  add_locator_to_addrset (gv, as, &loc);
+  if (mode == M_SHARED)
+  {
+    loc.address[12] = 239;
+    loc.address[13] = 255;
+    loc.address[14] = 0;
+    loc.address[15] = 77;
+    loc.port = 7777;
+    add_locator_to_addrset (gv, as, &loc);
+  }
+  return as;
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t nreaders = 2000, nwriters = 10;
+  enum mode mode = M_UNIQUE;
+  if (argc > 1)
+    nreaders = (uint32_t) strtoul (argv[1], NULL, 0);
+  if (argc > 2)
+    nwriters = (uint32_t) strtoul (argv[2], NULL, 0);
+  if (argc > 3)
+  {
+    if (strcmp (argv[3], "unique") == 0)
+      mode = M_UNIQUE;
+    else if (strcmp (argv[3], "shared") == 0)
+      mode = M_SHARED;
+    else if (strcmp (argv[3], "same") == 0)
+      mode = M_SAME;
+    else
+    {
+      fprintf (stderr, "%s: invalid mode\n", argv[3]);
+      return 1;
+    }
+  }
+  if (nreaders > 40000)
+    nreaders = 40000;
+
+  const dds_entity_t pp = dds_create_participant (DDS_DOMAIN_DEFAULT, NULL, NULL);
+  if (pp < 0)
+    return 1;
+  const dds_entity_t tp = dds_create_topic (pp, &WrasBench_Msg_desc, "wrasbench", NULL, NULL);
+  if (tp < 0)
+  {
+    fprintf (stderr, "dds_create_topic: %s\n", dds_strretcode (tp));
+    return 1;
+  }
+  dds_entity_t *wrs = ddsrt_malloc ((nwriters > 0 ? nwriters : 1) * sizeof (*wrs));
+  for (uint32_t i = 0; i < nwriters; i++)
+  {
+    if ((wrs[i] = dds_create_writer (pp, tp, NULL, NULL)) < 0)
+    {
+      fprintf (stderr, "dds_create_writer: %s\n", dds_strretcode (wrs[i]));
+      return 1;
+    }
+  }
+
+  struct ddsi_domaingv * const gv = get_domaingv (pp);
+  struct thread_state1 * const ts1 = lookup_thread_state ();
+  const ddsrt_wctime_t tnow = ddsrt_time_wallclock ();
+
+  ddsi_guid_t ppguid;
+  ppguid.prefix.u[0] = ddsrt_random ();
+  ppguid.prefix.u[1] = ddsrt_random ();
+  ppguid.prefix.u[2] = ddsrt_random ();
+  ppguid.entityid.u = NN_ENTITYID_PARTICIPANT;
+
+  struct addrset *ppas = new_addrset ();
+  ddsi_plist_t pp_plist, rd_plist;
+  ddsi_plist_init_empty (&pp_plist);
+  make_endpoint_plist (&rd_plist, "wrasbench", "WrasBench::Msg", &gv->default_xqos_rd);
+
+  thread_state_awake (ts1, gv);
+  new_proxy_participant (gv, &ppguid, 0, NULL, ref_addrset (ppas), ref_addrset (ppas), &pp_plist, DDS_INFINITY, NN_VENDORID_ECLIPSE, CF_PROXYPP_NO_SPDP, tnow, 1);
+  thread_state_asleep (ts1);
+
+  const dds_time_t t0 = dds_time ();
+  for (uint32_t i = 0; i < nreaders; i++)
+  {
+    const ddsi_guid_t guid = make_endpoint_guid (&ppguid.prefix, i, false);
+    struct addrset *as = mkaddrset (gv, mode, i);
+    thread_state_awake (ts1, gv);
+#ifdef DDS_HAS_SSM
+    new_proxy_reader (gv, &ppguid, &guid, as, &rd_plist, tnow, 1, 0);
+#else
+    new_proxy_reader (gv, &ppguid, &guid, as, &rd_plist, tnow, 1);
+#endif
+    thread_state_asleep (ts1);
+    unref_addrset (as);
+  }
+  const dds_time_t t1 = dds_time ();
+
+  dds_publication_matched_status_t st;
+  size_t nuc = 0, nmc = 0;
+  if (nwriters > 0)
+  {
+    (void) dds_get_publication_matched_status (wrs[0], &st);
+    get_addrset_counts (wrs[0], &nuc, &nmc);
+  }
+
+  const dds_time_t t2 = dds_time ();
+  for (uint32_t i = 0; i < nreaders; i++)
+  {
+    const ddsi_guid_t guid = make_endpoint_guid (&ppguid.prefix, i, false);
+    thread_state_awake (ts1, gv);
+    delete_proxy_reader (gv, &guid, tnow, 0);
+    thread_state_asleep (ts1);
+  }
+  gcreq_queue_drain (gv->gcreq_queue);
+  const dds_time_t t3 = dds_time ();
+
+  printf ("%s: %"PRIu32" readers, %"PRIu32" writers: match %.2f us/reader, unmatch %.2f us/reader; matched %"PRIu32" addrset %zu uc %zu mc\n",
+          (mode == M_UNIQUE) ? "unique" : (mode == M_SHARED) ? "shared" : "same",
+          nreaders, nwriters, (double) (t1 - t0) / 1e3 / (nreaders ? nreaders : 1),
+          (double) (t3 - t2) / 1e3 / (nreaders ? nreaders : 1),
+          (nwriters > 0) ? st.current_count : 0, nuc, nmc);
+
+  thread_state_awake (ts1, gv);
+  delete_proxy_participant_by_guid (gv, &ppguid, tnow, 0);
+  thread_state_asleep (ts1);
+  ddsi_plist_fini (&rd_plist);
+  ddsi_plist_fini (&pp_plist);
+  unref_addrset (ppas);
+  ddsrt_free (wrs);
+  dds_delete (pp);
+
+  /* every reader must have been matched and reachable via the address set */
+  if (nwriters > 0 && st.current_count != nreaders)
+    return 1;
+  switch (mode)
+  {
+    case M_UNIQUE: return (nreaders > 0 && nuc != nreaders) ? 1 : 0;
+    case M_SHARED: return (nreaders > 0 && nuc + nmc == 0) ? 1 : 0;
+    case M_SAME: return (nreaders > 0 && nuc != 1) ? 1 : 0;
+  }
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/dds.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/random.h"
+#include "dds/ddsrt/environ.h"
+#include "dds/ddsrt/io.h"
+#include "dds/ddsi/q_xevent.h"
+#include "dds/ddsi/ddsi_domaingv.h"
+#include "xtests_util.h"
+
+/* Stress test for the timed event queue, run once with the heap and once
+   with the timing wheel (Internal/EventQueue): schedules many callback
+   events, reschedules them to earlier times a few times over, deletes them,
+   and finally lets them all fire in a short interval checking none fires
+   early or is lost. Usage: xevbench [NEVENTS] */
+
+#define NRESCHED 4
+
+struct evarg {
+  ddsrt_mtime_t tsched;
+  ddsrt_mtime_t tfired;
+  ddsrt_atomic_uint32_t *nfired;
+};
+
+static void evcb (struct xevent *xev, void *varg, ddsrt_mtime_t tnow)
+{
+  struct evarg *arg = varg;
+  (void) xev;
+  if (tnow.v == DDS_NEVER)
+    return;
+  arg->tfired = tnow;
+  ddsrt_atomic_inc32 (arg->nfired);
+}
+
+static double ns_per_op (dds_time_t t0, dds_time_t t1, uint32_t n)
+{
+  return (double) (t1 - t0) / (double) n;
+}
+
+static bool run (const char *kind, dds_domainid_t domid, uint32_t nevents)
+{
+  const char *config = "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}<Internal><EventQueue>%s</EventQueue></Internal>";
+  char *conf1, *conf;
+  ddsrt_prng_t prng;
+  dds_time_t t0, t1;
+  double ns_insert, ns_resched, ns_delete;
+  ddsrt_atomic_uint32_t nfired = DDSRT_ATOMIC_UINT32_INIT (0);
+  bool ok = true;
+
+  if (ddsrt_asprintf (&conf1, config, kind) < 0)
+    return false;
+  conf = ddsrt_expand_envvars (conf1, domid);
+  ddsrt_free (conf1);
+  const dds_entity_t dom = dds_create_domain (domid, conf);
+  ddsrt_free (conf);
+  if (dom < 0)
+  {
+    fprintf (stderr, "dds_create_domain: %s\n", dds_strretcode (dom));
+    return false;
+  }
+  struct ddsi_domaingv * const gv = get_domaingv (dom);
+
+  ddsrt_prng_init_simple (&prng, 314159265);
+  struct evarg *args = ddsrt_malloc (nevents * sizeof (*args));
+  struct xevent **evs = ddsrt_malloc (nevents * sizeof (*evs));
+  struct xeventq *evq = xeventq_new (gv, 0, 0, 0);
+  ddsrt_mtime_t tnow = ddsrt_time_monotonic ();
+
+  /* events scheduled 10s - 20s in the future so none fire during the first
+     part, the event thread isn't even running yet */
+  for (uint32_t i = 0; i < nevents; i++)
+  {
+    args[i].tsched = ddsrt_mtime_add_duration (tnow, DDS_SECS (10) + (int64_t) (ddsrt_prng_random (&prng) % DDS_SECS (10)));
+    args[i].tfired.v = 0;
+    args[i].nfired = &nfired;
+  }
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < nevents; i++)
+    evs[i] = qxev_callback (evq, args[i].tsched, evcb, &args[i]);
+  t1 = dds_time ();
+  ns_insert = ns_per_op (t0, t1, nevents);
+
+  t0 = dds_time ();
+  for (int r = 0; r < NRESCHED; r++)
+  {
+    for (uint32_t i = 0; i < nevents; i++)
+    {
+      args[i].tsched.v -= (int64_t) (ddsrt_prng_random (&prng) % DDS_MSECS (500));
+      if (!resched_xevent_if_earlier (evs[i], args[i].tsched))
+        ok = false;
+    }
+  }
+  t1 = dds_time ();
+  ns_resched = ns_per_op (t0, t1, NRESCHED * nevents);
+
+  t0 = dds_time ();
+  for (uint32_t i = 0; i < nevents; i++)
+    delete_xevent_callback (evs[i]);
+  t1 = dds_time ();
+  ns_delete = ns_per_op (t0, t1, nevents);
+
+  /* let them all fire within 200ms */
+  xeventq_start (evq, "xevbench");
+  tnow = ddsrt_time_monotonic ();
+  for (uint32_t i = 0; i < nevents; i++)
+  {
+    args[i].tsched = ddsrt_mtime_add_duration (tnow, DDS_MSECS (10) + (int64_t) (ddsrt_prng_random (&prng) % DDS_MSECS (200)));
+    evs[i] = qxev_callback (evq, args[i].tsched, evcb, &args[i]);
+  }
+  const dds_time_t tend = dds_time () + DDS_SECS (5);
+  while (ddsrt_atomic_ld32 (&nfired) < nevents && dds_time () < tend)
+    dds_sleepfor (DDS_MSECS (10));
+  xeventq_stop (evq);
+
+  int64_t maxlate = 0, sumlate = 0;
+  uint32_t early = 0;
+  for (uint32_t i = 0; i < nevents; i++)
+  {
+    const int64_t late = args[i].tfired.v - args[i].tsched.v;
+    if (late < 0)
+      early++;
+    if (late > maxlate)
+      maxlate = late;
+    sumlate += late;
+    delete_xevent_callback (evs[i]);
+  }
+  xeventq_free (evq);
+
+  if (ddsrt_atomic_ld32 (&nfired) != nevents || early > 0)
+  {
+    printf ("%s: %"PRIu32" of %"PRIu32" events fired, %"PRIu32" early\n", kind, ddsrt_atomic_ld32 (&nfired), nevents, early);
+    ok = false;
+  }
+  else if (!ok)
+  {
+    printf ("%s: rescheduling to an earlier time failed\n", kind);
+  }
+  else
+  {
+    printf ("%-6s %8.1f %8.1f %8.1f %10.1f %10.1f\n", kind, ns_insert, ns_resched, ns_delete,
+            (double) sumlate / nevents / 1e3, (double) maxlate / 1e3);
+  }
+  ddsrt_free (evs);
+  ddsrt_free (args);
+  dds_delete (dom);
+  return ok;
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t nevents = 50000;
+  bool ok;
+  if (argc > 1)
+    nevents = (uint32_t) strtoul (argv[1], NULL, 0);
+  if (nevents == 0)
+    nevents = 1;
+  printf ("%"PRIu32" events: ns/op insert / resched / delete, us lateness mean / max\n", nevents);
+  ok = run ("heap", 0, nevents);
+  ok = run ("wheel", 1, nevents) && ok;
+  return ok ? 0 : 1;
+}
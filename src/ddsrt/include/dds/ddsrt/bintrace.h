@@ -0,0 +1,104 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#ifndef DDSRT_BINTRACE_H
+#define DDSRT_BINTRACE_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dds/export.h"
+#include "dds/ddsrt/retcode.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Binary trace writer
+ *
+ * Trace messages are stored in a lock-free single-producer/single-consumer
+ * ring buffer per thread as the format string's id, a timestamp and the raw
+ * arguments, without formatting them.  A background thread periodically
+ * moves the contents of the ring buffers to the output file, together with
+ * the definitions of the format strings and the names of the threads.  The
+ * text is reconstructed offline using #ddsrt_bintrace_decode.
+ *
+ * Format strings are identified by their address and so must be string
+ * literals (or at least immutable for the lifetime of the writer).  If the
+ * ring buffer of a thread is full, messages are dropped and the number of
+ * dropped messages is recorded in the file.
+ */
+struct ddsrt_bintrace;
+
+/**
+ * @brief Create a binary trace writer
+ *
+ * @param[in] fp        File to write to, must be opened in binary mode and
+ *                      remains owned by the caller
+ * @param[in] domid     Domain id to use when reconstructing the text
+ * @param[in] ringsize  Size of the per-thread ring buffers in bytes
+ *
+ * @returns the trace writer, or a null pointer on failure
+ */
+DDS_EXPORT struct ddsrt_bintrace *
+ddsrt_bintrace_new(
+    FILE *fp,
+    uint32_t domid,
+    uint32_t ringsize);
+
+/**
+ * @brief Flush all buffered messages and free a binary trace writer
+ *
+ * No thread may be using the writer concurrently.  The file is not closed.
+ */
+DDS_EXPORT void
+ddsrt_bintrace_free(
+    struct ddsrt_bintrace *bt);
+
+/**
+ * @brief Append a message to the calling thread's ring buffer
+ *
+ * Messages are split into lines in the same way as the text-based logging
+ * does, by the decoder: a line ends with a format string that ends in a
+ * newline.
+ */
+DDS_EXPORT void
+ddsrt_bintrace_vlog(
+    struct ddsrt_bintrace *bt,
+    const char *fmt,
+    va_list ap);
+
+/**
+ * @brief Convert a binary trace to text
+ *
+ * The output is formatted the same way as the text-based trace, so it can
+ * be processed with the usual tools.  The trace must have been written on a
+ * machine with the same byte order.
+ *
+ * @param[in] out  File to write the text to
+ * @param[in] in   Binary trace file
+ *
+ * @returns DDS_RETCODE_OK if the input was read completely,
+ *          DDS_RETCODE_BAD_PARAMETER if it is not a binary trace or is
+ *          malformed.
+ */
+DDS_EXPORT dds_return_t
+ddsrt_bintrace_decode(
+    FILE *out,
+    FILE *in);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* DDSRT_BINTRACE_H */
@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "dds/export.h"
 #include "dds/ddsrt/endian.h"
 
 #if defined (__cplusplus)
@@ -59,6 +60,20 @@ inline int64_t ddsrt_bswap8 (int64_t x)
   return (int64_t) ddsrt_bswap8u ((uint64_t) x);
 }
 
+/**
+ * @brief Byte swap an array of 2, 4 or 8-byte values in place
+ *
+ * Equivalent to applying ddsrt_bswap2u, ddsrt_bswap4u or ddsrt_bswap8u to
+ * each element, but uses vector instructions where available (SSE2 or NEON,
+ * and AVX2 if the CPU supports it).
+ *
+ * @param[in,out] xs  array, need not be aligned
+ * @param[in]     n   number of elements in xs
+ */
+DDS_EXPORT void ddsrt_bswap2u_array (void *xs, uint32_t n);
+DDS_EXPORT void ddsrt_bswap4u_array (void *xs, uint32_t n);
+DDS_EXPORT void ddsrt_bswap8u_array (void *xs, uint32_t n);
+
 #if DDSRT_ENDIAN == DDSRT_LITTLE_ENDIAN
 #define ddsrt_toBE2(x) ddsrt_bswap2 (x)
 #define ddsrt_toBE2u(x) ddsrt_bswap2u (x)
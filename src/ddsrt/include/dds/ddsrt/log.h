@@ -252,6 +252,23 @@ dds_log_cfg_init(
     FILE *log_fp,
     FILE *trace_fp);
 
+struct ddsrt_bintrace;
+
+/**
+ * @brief Direct the trace output of a log configuration to a binary trace
+ *
+ * Trace messages for cfg are written to bt instead of the trace file, and
+ * messages in the trace categories are no longer passed to the trace sink.
+ * Log messages are still written to the log sink as well.
+ *
+ * @param[in,out] cfg  Log configuration initialised with #dds_log_cfg_init
+ * @param[in]     bt   Binary trace writer, see dds/ddsrt/bintrace.h
+ */
+DDS_EXPORT void
+dds_log_cfg_set_bintrace(
+    struct ddsrt_log_cfg *cfg,
+    struct ddsrt_bintrace *bt);
+
 /**
  * @brief Write a log or trace message for a specific logging configuraiton
  * (categories, id, sinks).
@@ -109,6 +109,54 @@ ddsrt_recvmsg(
   int flags,
   ssize_t *rcvd);
 
+#if DDSRT_HAVE_MMSG
+/**
+ * @brief Receive multiple messages from a socket in a single call.
+ *
+ * Blocks until at least one message is available (unless the socket is
+ * non-blocking), then returns whatever is available without waiting for
+ * the remaining entries to be filled.
+ *
+ * @param[in]     sock   Socket to receive from.
+ * @param[in,out] msgs   Message headers, msg_len is set to the number of
+ *                       bytes received for each message.
+ * @param[in]     vlen   Number of entries in @msgs.
+ * @param[in]     flags  Flags passed to the underlying system call.
+ * @param[out]    rcvd   Number of messages received.
+ *
+ * @returns A dds_return_t indicating success or failure.
+ */
+DDS_EXPORT dds_return_t
+ddsrt_recvmmsg(
+  ddsrt_socket_t sock,
+  ddsrt_mmsghdr_t *msgs,
+  size_t vlen,
+  int flags,
+  size_t *rcvd);
+
+/**
+ * @brief Send multiple messages on a socket in a single call.
+ *
+ * @param[in]     sock   Socket to send on.
+ * @param[in,out] msgs   Message headers, msg_len is set to the number of
+ *                       bytes sent for each message.
+ * @param[in]     vlen   Number of entries in @msgs.
+ * @param[in]     flags  Flags passed to the underlying system call.
+ * @param[out]    sent   Number of messages sent, this may be less than
+ *                       @vlen.
+ *
+ * @returns A dds_return_t indicating success or failure. Failure is only
+ *          reported if the first message could not be sent.
+ */
+DDS_EXPORT dds_return_t
+ddsrt_sendmmsg(
+  ddsrt_socket_t sock,
+  ddsrt_mmsghdr_t *msgs,
+  size_t vlen,
+  int flags,
+  size_t *sent);
+#endif
+
 DDS_EXPORT dds_return_t
 ddsrt_getsockopt(
   ddsrt_socket_t sock,
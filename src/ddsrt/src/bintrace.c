@@ -0,0 +1,1256 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "dds/ddsrt/bintrace.h"
+#include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/hopscotch.h"
+#include "dds/ddsrt/misc.h"
+#include "dds/ddsrt/static_assert.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/sync.h"
+#include "dds/ddsrt/threads.h"
+#include "dds/ddsrt/time.h"
+
+/* File layout, all in host byte order:
+
+   - header: "CDDSBTR1", uint32_t byte order mark, uint32_t domain id
+   - a sequence of chunks, each a uint32_t kind and a uint32_t length,
+     followed by that many bytes:
+     . FMT: uint32_t id, uint32_t flags, the format string
+     . THREAD: uint32_t id, the thread name
+     . EVENTS: uint32_t thread id, a sequence of records as stored in the
+       ring buffer of that thread
+
+   Records are 8-byte aligned and start with a uint32_t size (excluding the
+   padding) and a uint32_t format id.  Padding records (fill up the end of
+   the ring buffer) have nothing else.  Normal records have an int64_t
+   timestamp and then the arguments in the order of the format string,
+   packed without alignment: "int" as 4 bytes, all other integers, pointers
+   and floating-point numbers as 8 bytes and strings as a uint32_t length
+   (UINT32_MAX for a null pointer) followed by that many bytes.  Records for
+   dropped messages have a timestamp and a uint32_t count.
+
+   The flusher writes the definitions of the format strings and the
+   threads before the events referring to them, so the decoder can do a
+   single pass over the file. */
+
+#define BT_MAGIC "CDDSBTR1"
+#define BT_BOM 0x01020304u
+
+#define BT_CHUNK_FMT 1u
+#define BT_CHUNK_THREAD 2u
+#define BT_CHUNK_EVENTS 3u
+
+#define BT_FMTID_PAD UINT32_MAX
+#define BT_FMTID_DROPPED (UINT32_MAX - 1)
+
+/* arguments that can't be captured (e.g., %ls) or that don't fit in a
+   record cause the message to be formatted when it is logged, these are
+   stored as a single string */
+#define BT_FMTFLAG_PREFORMATTED 1u
+
+/* a record never exceeds the size of a line in the text-based trace, and
+   every time a message is added there must be this much space available */
+#define BT_MAXREC 2048u
+#define BT_RECHDR 16u
+#define BT_DROPPED_RECSIZE (BT_RECHDR + 4u)
+
+/* must match the text-based trace (log.c) */
+#define BT_MAX_TID_LEN 10
+#define BT_LINE_MAX (2048 - (10 + 1 + 6 + 2 + 10 + 2 + BT_MAX_TID_LEN + 2))
+
+#define BT_FMTCACHE_SIZE_LG2 6
+#define BT_FMTCACHE_SIZE (1u << BT_FMTCACHE_SIZE_LG2)
+#define BT_FLUSH_INTERVAL DDS_MSECS (10)
+
+enum bt_argkind {
+  BTA_INT,
+  BTA_LONG,
+  BTA_LLONG,
+  BTA_SIZE,
+  BTA_INTMAX,
+  BTA_PTRDIFF,
+  BTA_DOUBLE,
+  BTA_LDOUBLE,
+  BTA_PTR,
+  BTA_STR
+};
+
+#define BT_PREC_NONE (-1)
+#define BT_PREC_ARG (-2)
+
+struct bt_arg {
+  uint8_t kind; /* enum bt_argkind */
+  uint8_t is_unsigned;
+  int32_t prec; /* strings only: BT_PREC_NONE, BT_PREC_ARG (preceding int) or a literal precision */
+};
+
+struct bt_fmt {
+  const char *fmt;
+  uint32_t id;
+  uint32_t flags;
+  uint32_t fixedsize; /* bytes needed for the arguments excluding string contents */
+  uint32_t nargs;
+  struct bt_arg args[];
+};
+
+struct bt_fmtcache_entry {
+  const char *fmt;
+  const struct bt_fmt *f;
+};
+
+struct bt_ring {
+  /* producer side */
+  ddsrt_atomic_uint32_t head;
+  uint32_t wpos;
+  uint32_t tail_cache;
+  uint32_t ndropped;
+  struct ddsrt_bintrace *bt;
+  struct bt_ring *tnext;
+  struct bt_fmtcache_entry fmtcache[BT_FMTCACHE_SIZE];
+
+  /* consumer side */
+  ddsrt_atomic_uint32_t tail;
+  uint32_t flush_head;
+  bool flush_orphaned;
+  bool announced;
+  struct bt_ring *next;
+
+  /* shared */
+  ddsrt_atomic_uint32_t refc;
+  ddsrt_atomic_uint32_t orphaned; /* owning thread has terminated */
+  ddsrt_atomic_uint32_t detached; /* writer has been freed */
+  uint32_t id;
+  uint32_t size;
+  unsigned char *buf;
+  char name[32];
+};
+
+struct ddsrt_bintrace {
+  FILE *fp;
+  uint32_t ringsize;
+  ddsrt_thread_t flusher_tid;
+
+  ddsrt_mutex_t lock;
+  ddsrt_cond_t cond;
+  bool terminate;
+  struct ddsrt_hh *fmttab;
+  struct bt_fmt **fmts;
+  uint32_t nfmts, maxfmts;
+  uint32_t nfmts_written;
+  uint32_t nrings_created;
+  struct bt_ring *rings;
+};
+
+struct bt_conv {
+  const char *flags, *width, *prec;
+  size_t nflags, nwidth, nprec;
+  bool width_arg, has_prec, prec_arg;
+  int32_t precval;
+  enum {
+    BTL_NONE, BTL_HH, BTL_H, BTL_L, BTL_LL, BTL_J, BTL_Z, BTL_T, BTL_BIGL,
+    BTL_I32, BTL_I64, BTL_I
+  } lenmod;
+  const char *lenstr;
+  size_t nlenstr;
+  char conv;
+  const char *end;
+};
+
+static ddsrt_thread_local struct bt_ring *thread_rings;
+static ddsrt_thread_local bool thread_cleanup_registered;
+
+static bool is_digit (char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+/* Parses the conversion specification starting at p (pointing to the '%'),
+   returns false for anything not supported by C99 printf */
+static bool bt_parse_conv (const char *p, struct bt_conv *c)
+{
+  assert (*p == '%');
+  memset (c, 0, sizeof (*c));
+  p++;
+  c->flags = p;
+  while (*p && strchr ("-+ #0'", *p))
+    p++;
+  c->nflags = (size_t) (p - c->flags);
+  c->width = p;
+  if (*p == '*')
+  {
+    c->width_arg = true;
+    p++;
+  }
+  else
+  {
+    while (is_digit (*p))
+      p++;
+    c->nwidth = (size_t) (p - c->width);
+  }
+  if (*p == '.')
+  {
+    c->has_prec = true;
+    p++;
+    c->prec = p;
+    if (*p == '*')
+    {
+      c->prec_arg = true;
+      p++;
+    }
+    else
+    {
+      while (is_digit (*p))
+      {
+        if (c->precval < INT32_MAX / 10)
+          c->precval = 10 * c->precval + (*p - '0');
+        p++;
+      }
+      c->nprec = (size_t) (p - c->prec);
+    }
+  }
+  c->lenstr = p;
+  switch (*p)
+  {
+    case 'h':
+      c->lenmod = (p[1] == 'h') ? BTL_HH : BTL_H;
+      p += (p[1] == 'h') ? 2 : 1;
+      break;
+    case 'l':
+      c->lenmod = (p[1] == 'l') ? BTL_LL : BTL_L;
+      p += (p[1] == 'l') ? 2 : 1;
+      break;
+    case 'q': c->lenmod = BTL_LL; p++; break;
+    case 'j': c->lenmod = BTL_J; p++; break;
+    case 'z': c->lenmod = BTL_Z; p++; break;
+    case 't': c->lenmod = BTL_T; p++; break;
+    case 'L': c->lenmod = BTL_BIGL; p++; break;
+#ifdef _WIN32
+    case 'I':
+      if (p[1] == '6' && p[2] == '4') { c->lenmod = BTL_I64; p += 3; }
+      else if (p[1] == '3' && p[2] == '2') { c->lenmod = BTL_I32; p += 3; }
+      else { c->lenmod = BTL_I; p++; }
+      break;
+#endif
+    default:
+      break;
+  }
+  c->nlenstr = (size_t) (p - c->lenstr);
+  c->conv = *p;
+  if (*p == 0)
+    return false;
+  c->end = p + 1;
+  return true;
+}
+
+static bool bt_conv_argkind (const struct bt_conv *c, struct bt_arg *a)
+{
+  a->is_unsigned = 0;
+  a->prec = BT_PREC_NONE;
+  switch (c->conv)
+  {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+      a->is_unsigned = (c->conv != 'd' && c->conv != 'i');
+      switch (c->lenmod)
+      {
+        case BTL_NONE: case BTL_HH: case BTL_H: case BTL_I32: a->kind = BTA_INT; return true;
+        case BTL_L: a->kind = BTA_LONG; return true;
+        case BTL_LL: case BTL_I64: a->kind = BTA_LLONG; return true;
+        case BTL_J: a->kind = BTA_INTMAX; return true;
+        case BTL_Z: case BTL_I: a->kind = BTA_SIZE; return true;
+        case BTL_T: a->kind = BTA_PTRDIFF; return true;
+        case BTL_BIGL: return false;
+      }
+      return false;
+    case 'c':
+      a->kind = BTA_INT;
+      return (c->lenmod == BTL_NONE);
+    case 's':
+      a->kind = BTA_STR;
+      a->prec = c->prec_arg ? BT_PREC_ARG : c->has_prec ? c->precval : BT_PREC_NONE;
+      return (c->lenmod == BTL_NONE);
+    case 'p':
+      a->kind = BTA_PTR;
+      return (c->lenmod == BTL_NONE);
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      a->kind = (c->lenmod == BTL_BIGL) ? BTA_LDOUBLE : BTA_DOUBLE;
+      return (c->lenmod == BTL_NONE || c->lenmod == BTL_L || c->lenmod == BTL_BIGL);
+    default:
+      return false;
+  }
+}
+
+static uint32_t bt_argsize (enum bt_argkind kind)
+{
+  switch (kind)
+  {
+    case BTA_INT: case BTA_STR: return 4;
+    default: return 8;
+  }
+}
+
+/* Returns the number of arguments needed for fmt, or UINT32_MAX if fmt can't
+   be handled; fills args if it is non-null */
+static uint32_t bt_scan_fmt (const char *fmt, struct bt_arg *args)
+{
+  uint32_t n = 0;
+  const char *p = fmt;
+  while ((p = strchr (p, '%')) != NULL)
+  {
+    struct bt_conv c;
+    struct bt_arg a;
+    if (!bt_parse_conv (p, &c))
+      return UINT32_MAX;
+    p = c.end;
+    if (c.conv == '%')
+      continue;
+    if (!bt_conv_argkind (&c, &a))
+      return UINT32_MAX;
+    if (c.width_arg)
+    {
+      if (args)
+        args[n] = (struct bt_arg) { .kind = BTA_INT, .prec = BT_PREC_NONE };
+      n++;
+    }
+    if (c.prec_arg)
+    {
+      if (args)
+        args[n] = (struct bt_arg) { .kind = BTA_INT, .prec = BT_PREC_NONE };
+      n++;
+    }
+    if (args)
+      args[n] = a;
+    n++;
+  }
+  return n;
+}
+
+static struct bt_fmt *bt_fmt_new (const char *fmt, uint32_t id)
+{
+  uint32_t nargs = bt_scan_fmt (fmt, NULL);
+  uint32_t flags = 0, fixedsize = 0;
+  if (nargs > (BT_MAXREC - BT_RECHDR) / 4)
+    flags = BT_FMTFLAG_PREFORMATTED;
+  struct bt_fmt *f = ddsrt_malloc (sizeof (*f) + ((flags & BT_FMTFLAG_PREFORMATTED) ? 0 : nargs) * sizeof (f->args[0]));
+  if (flags & BT_FMTFLAG_PREFORMATTED)
+    nargs = 0;
+  else
+  {
+    (void) bt_scan_fmt (fmt, f->args);
+    for (uint32_t i = 0; i < nargs; i++)
+      fixedsize += bt_argsize (f->args[i].kind);
+    if (fixedsize > BT_MAXREC - BT_RECHDR)
+    {
+      flags = BT_FMTFLAG_PREFORMATTED;
+      nargs = 0;
+      fixedsize = 0;
+    }
+  }
+  f->fmt = fmt;
+  f->id = id;
+  f->flags = flags;
+  f->fixedsize = fixedsize;
+  f->nargs = nargs;
+  return f;
+}
+
+static uint32_t bt_fmt_hash (const void *va)
+{
+  const struct bt_fmt *a = va;
+  return (uint32_t) (((uint64_t) (uintptr_t) a->fmt * UINT64_C (16292676669999574021)) >> 32);
+}
+
+static int bt_fmt_equal (const void *va, const void *vb)
+{
+  const struct bt_fmt *a = va;
+  const struct bt_fmt *b = vb;
+  return a->fmt == b->fmt;
+}
+
+static void bt_ring_unref (struct bt_ring *r)
+{
+  if (ddsrt_atomic_dec32_nv (&r->refc) == 0)
+  {
+    ddsrt_free (r->buf);
+    ddsrt_free (r);
+  }
+}
+
+static void bt_thread_cleanup (void *arg)
+{
+  (void) arg;
+  struct bt_ring *r = thread_rings;
+  thread_rings = NULL;
+  thread_cleanup_registered = false;
+  while (r)
+  {
+    struct bt_ring * const tnext = r->tnext;
+    /* publishing everything written so far: the flusher reads "orphaned"
+       before the head, so it will have drained the ring once it sees it */
+    ddsrt_atomic_fence_rel ();
+    ddsrt_atomic_st32 (&r->orphaned, 1);
+    bt_ring_unref (r);
+    r = tnext;
+  }
+}
+
+static struct bt_ring *bt_ring_new (struct ddsrt_bintrace *bt)
+{
+  struct bt_ring *r, **pr;
+
+  /* drop references to rings of writers that no longer exist */
+  pr = &thread_rings;
+  while ((r = *pr) != NULL)
+  {
+    if (!ddsrt_atomic_ld32 (&r->detached))
+      pr = &r->tnext;
+    else
+    {
+      *pr = r->tnext;
+      bt_ring_unref (r);
+    }
+  }
+
+  if (!thread_cleanup_registered)
+  {
+    if (ddsrt_thread_cleanup_push (bt_thread_cleanup, NULL) != DDS_RETCODE_OK)
+      return NULL;
+    thread_cleanup_registered = true;
+  }
+
+  if ((r = ddsrt_malloc_s (sizeof (*r))) == NULL)
+    return NULL;
+  memset (r, 0, sizeof (*r));
+  if ((r->buf = ddsrt_malloc_s (bt->ringsize)) == NULL)
+  {
+    ddsrt_free (r);
+    return NULL;
+  }
+  r->size = bt->ringsize;
+  r->bt = bt;
+  ddsrt_atomic_st32 (&r->refc, 2);
+  (void) ddsrt_thread_getname (r->name, sizeof (r->name));
+  if (r->name[0] == 0)
+    (void) ddsrt_strlcpy (r->name, "(anon)", sizeof (r->name));
+
+  ddsrt_mutex_lock (&bt->lock);
+  r->id = bt->nrings_created++;
+  r->next = bt->rings;
+  bt->rings = r;
+  ddsrt_mutex_unlock (&bt->lock);
+
+  r->tnext = thread_rings;
+  thread_rings = r;
+  return r;
+}
+
+static const struct bt_fmt *bt_lookup_fmt (struct bt_ring *r, const char *fmt)
+{
+  struct bt_fmtcache_entry * const ce = &r->fmtcache[((uint32_t) (uintptr_t) fmt * 2654435761u) >> (32 - BT_FMTCACHE_SIZE_LG2)];
+  if (ce->fmt == fmt)
+    return ce->f;
+
+  struct ddsrt_bintrace * const bt = r->bt;
+  const struct bt_fmt template = { .fmt = fmt };
+  struct bt_fmt *f;
+  ddsrt_mutex_lock (&bt->lock);
+  if ((f = ddsrt_hh_lookup (bt->fmttab, &template)) == NULL)
+  {
+    if (bt->nfmts == bt->maxfmts)
+    {
+      bt->maxfmts = (bt->maxfmts == 0) ? 256 : 2 * bt->maxfmts;
+      bt->fmts = ddsrt_realloc (bt->fmts, bt->maxfmts * sizeof (*bt->fmts));
+    }
+    f = bt_fmt_new (fmt, bt->nfmts);
+    bt->fmts[bt->nfmts++] = f;
+    (void) ddsrt_hh_add (bt->fmttab, f);
+  }
+  ddsrt_mutex_unlock (&bt->lock);
+  ce->fmt = fmt;
+  ce->f = f;
+  return f;
+}
+
+/* Returns a pointer to space for a record of up to "need" bytes, or a null
+   pointer if the ring is full; records never wrap around, instead the end
+   of the buffer is filled with a padding record */
+static unsigned char *bt_reserve (struct bt_ring *r, uint32_t need)
+{
+  const uint32_t head = ddsrt_atomic_ld32 (&r->head);
+  const uint32_t off = head & (r->size - 1);
+  const uint32_t contig = r->size - off;
+  const uint32_t req = (contig >= need) ? need : contig + need;
+  if (r->size - (head - r->tail_cache) < req)
+  {
+    r->tail_cache = ddsrt_atomic_ld32 (&r->tail);
+    ddsrt_atomic_fence_acq ();
+    if (r->size - (head - r->tail_cache) < req)
+      return NULL;
+  }
+  if (contig >= need)
+  {
+    r->wpos = head;
+    return r->buf + off;
+  }
+  else
+  {
+    const uint32_t pad[2] = { contig, BT_FMTID_PAD };
+    memcpy (r->buf + off, pad, sizeof (pad));
+    r->wpos = head + contig;
+    return r->buf;
+  }
+}
+
+static void bt_commit (struct bt_ring *r, unsigned char *rec, uint32_t fmtid, dds_time_t t, uint32_t size)
+{
+  memcpy (rec, &size, 4);
+  memcpy (rec + 4, &fmtid, 4);
+  memcpy (rec + 8, &t, 8);
+  ddsrt_atomic_fence_rel ();
+  ddsrt_atomic_st32 (&r->head, r->wpos + ((size + 7) & ~7u));
+}
+
+static uint32_t bt_encode_str (unsigned char *p, const char *s, int32_t prec, uint32_t room)
+{
+  uint32_t n;
+  if (s == NULL)
+  {
+    n = UINT32_MAX;
+    memcpy (p, &n, 4);
+    return 4;
+  }
+  size_t max = room - 4;
+  if (prec >= 0 && (size_t) prec < max)
+    max = (size_t) prec;
+  const char *z = memchr (s, 0, max);
+  n = (uint32_t) (z ? (size_t) (z - s) : max);
+  memcpy (p, &n, 4);
+  memcpy (p + 4, s, n);
+  return 4 + n;
+}
+
+static uint32_t bt_encode (unsigned char *dst, uint32_t room, const struct bt_fmt *f, va_list ap)
+{
+  unsigned char *p = dst;
+  uint32_t fixed = f->fixedsize;
+  int lastint = 0;
+  for (uint32_t i = 0; i < f->nargs; i++)
+  {
+    const struct bt_arg *a = &f->args[i];
+    uint64_t u = 0;
+    switch ((enum bt_argkind) a->kind)
+    {
+      case BTA_INT: {
+        const int32_t v = (int32_t) (lastint = va_arg (ap, int));
+        memcpy (p, &v, 4);
+        p += 4;
+        fixed -= 4;
+        continue;
+      }
+      case BTA_STR: {
+        /* strings get whatever is not needed for the remaining arguments */
+        fixed -= 4;
+        const int32_t prec = (a->prec == BT_PREC_ARG) ? (int32_t) lastint : a->prec;
+        p += bt_encode_str (p, va_arg (ap, const char *), prec, room - (uint32_t) (p - dst) - fixed);
+        continue;
+      }
+      case BTA_LONG: {
+        const long v = va_arg (ap, long);
+        u = a->is_unsigned ? (uint64_t) (unsigned long) v : (uint64_t) (int64_t) v;
+        break;
+      }
+      case BTA_LLONG: {
+        const long long v = va_arg (ap, long long);
+        u = a->is_unsigned ? (uint64_t) (unsigned long long) v : (uint64_t) (int64_t) v;
+        break;
+      }
+      case BTA_SIZE:
+        u = (uint64_t) va_arg (ap, size_t);
+        break;
+      case BTA_INTMAX: {
+        const intmax_t v = va_arg (ap, intmax_t);
+        u = a->is_unsigned ? (uint64_t) (uintmax_t) v : (uint64_t) (int64_t) v;
+        break;
+      }
+      case BTA_PTRDIFF: {
+        const ptrdiff_t v = va_arg (ap, ptrdiff_t);
+        u = a->is_unsigned ? (uint64_t) (size_t) v : (uint64_t) (int64_t) v;
+        break;
+      }
+      case BTA_DOUBLE: {
+        const double v = va_arg (ap, double);
+        memcpy (&u, &v, 8);
+        break;
+      }
+      case BTA_LDOUBLE: {
+        const double v = (double) va_arg (ap, long double);
+        memcpy (&u, &v, 8);
+        break;
+      }
+      case BTA_PTR:
+        u = (uint64_t) (uintptr_t) va_arg (ap, void *);
+        break;
+    }
+    memcpy (p, &u, 8);
+    p += 8;
+    fixed -= 8;
+  }
+  return (uint32_t) (p - dst);
+}
+
+static uint32_t bt_encode_preformatted (unsigned char *dst, uint32_t room, const char *fmt, va_list ap)
+{
+  int n = vsnprintf ((char *) dst + 4, room - 4, fmt, ap);
+  uint32_t len;
+  if (n < 0)
+    len = 0;
+  else if ((uint32_t) n < room - 4)
+    len = (uint32_t) n;
+  else
+    len = room - 5;
+  memcpy (dst, &len, 4);
+  return 4 + len;
+}
+
+void ddsrt_bintrace_vlog (struct ddsrt_bintrace *bt, const char *fmt, va_list ap)
+{
+  struct bt_ring *r = thread_rings;
+  unsigned char *rec;
+  uint32_t size;
+
+  while (r && (r->bt != bt || ddsrt_atomic_ld32 (&r->detached)))
+    r = r->tnext;
+  if (r == NULL && (r = bt_ring_new (bt)) == NULL)
+    return;
+
+  const struct bt_fmt *f = bt_lookup_fmt (r, fmt);
+  const dds_time_t t = dds_time ();
+  if (r->ndropped > 0)
+  {
+    if ((rec = bt_reserve (r, BT_DROPPED_RECSIZE)) == NULL)
+    {
+      r->ndropped++;
+      return;
+    }
+    memcpy (rec + BT_RECHDR, &r->ndropped, 4);
+    bt_commit (r, rec, BT_FMTID_DROPPED, t, BT_DROPPED_RECSIZE);
+    r->ndropped = 0;
+  }
+  if ((rec = bt_reserve (r, BT_MAXREC)) == NULL)
+  {
+    r->ndropped++;
+    return;
+  }
+  if (f->flags & BT_FMTFLAG_PREFORMATTED)
+    size = bt_encode_preformatted (rec + BT_RECHDR, BT_MAXREC - BT_RECHDR, fmt, ap);
+  else
+    size = bt_encode (rec + BT_RECHDR, BT_MAXREC - BT_RECHDR, f, ap);
+  bt_commit (r, rec, f->id, t, BT_RECHDR + size);
+}
+
+static void bt_write_chunk (struct ddsrt_bintrace *bt, uint32_t kind, uint32_t id, uint32_t flags, bool with_flags, const void *data, size_t size)
+{
+  const uint32_t hdr[4] = { kind, (uint32_t) (size + (with_flags ? 8 : 4)), id, flags };
+  (void) fwrite (hdr, 1, with_flags ? 16 : 12, bt->fp);
+  (void) fwrite (data, 1, size, bt->fp);
+}
+
+static void bt_write_dropped (struct ddsrt_bintrace *bt, struct bt_ring *r)
+{
+  unsigned char rec[(BT_DROPPED_RECSIZE + 7) & ~7u];
+  const uint32_t hdr[2] = { BT_DROPPED_RECSIZE, BT_FMTID_DROPPED };
+  const dds_time_t t = dds_time ();
+  memset (rec, 0, sizeof (rec));
+  memcpy (rec, hdr, sizeof (hdr));
+  memcpy (rec + 8, &t, 8);
+  memcpy (rec + BT_RECHDR, &r->ndropped, 4);
+  bt_write_chunk (bt, BT_CHUNK_EVENTS, r->id, 0, false, rec, sizeof (rec));
+  r->ndropped = 0;
+}
+
+static void bt_flush (struct ddsrt_bintrace *bt, bool final)
+{
+  struct bt_ring *rings, *r, **pr;
+
+  /* new format strings and threads must precede the events that reference
+     them: snapshot the heads first, anything registered until then is
+     needed and nothing registered later can be referenced */
+  ddsrt_mutex_lock (&bt->lock);
+  rings = bt->rings;
+  for (r = rings; r; r = r->next)
+  {
+    r->flush_orphaned = ddsrt_atomic_ld32 (&r->orphaned);
+    ddsrt_atomic_fence_acq ();
+    r->flush_head = ddsrt_atomic_ld32 (&r->head);
+  }
+  ddsrt_atomic_fence_acq ();
+  for (; bt->nfmts_written < bt->nfmts; bt->nfmts_written++)
+  {
+    const struct bt_fmt *f = bt->fmts[bt->nfmts_written];
+    bt_write_chunk (bt, BT_CHUNK_FMT, f->id, f->flags, true, f->fmt, strlen (f->fmt));
+  }
+  for (r = rings; r; r = r->next)
+  {
+    if (!r->announced)
+    {
+      bt_write_chunk (bt, BT_CHUNK_THREAD, r->id, 0, false, r->name, strlen (r->name));
+      r->announced = true;
+    }
+  }
+  ddsrt_mutex_unlock (&bt->lock);
+
+  /* rings are only ever removed by the flusher, so this part of the list is
+     stable even when new rings get added */
+  for (r = rings; r; r = r->next)
+  {
+    const uint32_t tail = ddsrt_atomic_ld32 (&r->tail);
+    const uint32_t n = r->flush_head - tail;
+    if (n == 0)
+      continue;
+    const uint32_t off = tail & (r->size - 1);
+    if (off + n <= r->size)
+      bt_write_chunk (bt, BT_CHUNK_EVENTS, r->id, 0, false, r->buf + off, n);
+    else
+    {
+      bt_write_chunk (bt, BT_CHUNK_EVENTS, r->id, 0, false, r->buf + off, r->size - off);
+      bt_write_chunk (bt, BT_CHUNK_EVENTS, r->id, 0, false, r->buf, n - (r->size - off));
+    }
+    ddsrt_atomic_fence_rel ();
+    ddsrt_atomic_st32 (&r->tail, r->flush_head);
+  }
+
+  /* a thread that stopped after dropping messages never reports it, but
+     once it is gone (or everything is stopped) the count may be read */
+  for (r = rings; r; r = r->next)
+  {
+    if ((r->flush_orphaned || final) && r->ndropped > 0)
+      bt_write_dropped (bt, r);
+  }
+
+  ddsrt_mutex_lock (&bt->lock);
+  pr = &bt->rings;
+  while ((r = *pr) != NULL)
+  {
+    if (!r->flush_orphaned)
+      pr = &r->next;
+    else
+    {
+      *pr = r->next;
+      bt_ring_unref (r);
+    }
+  }
+  ddsrt_mutex_unlock (&bt->lock);
+}
+
+static uint32_t bt_flusher (void *varg)
+{
+  struct ddsrt_bintrace * const bt = varg;
+  ddsrt_mutex_lock (&bt->lock);
+  while (!bt->terminate)
+  {
+    ddsrt_mutex_unlock (&bt->lock);
+    bt_flush (bt, false);
+    (void) fflush (bt->fp);
+    ddsrt_mutex_lock (&bt->lock);
+    if (!bt->terminate)
+      (void) ddsrt_cond_waitfor (&bt->cond, &bt->lock, BT_FLUSH_INTERVAL);
+  }
+  ddsrt_mutex_unlock (&bt->lock);
+  return 0;
+}
+
+struct ddsrt_bintrace *ddsrt_bintrace_new (FILE *fp, uint32_t domid, uint32_t ringsize)
+{
+  struct ddsrt_bintrace *bt;
+  ddsrt_threadattr_t tattr;
+  uint32_t size = 4 * BT_MAXREC;
+  const uint32_t hdr[2] = { BT_BOM, domid };
+
+  while (size < ringsize && size < (UINT32_C (1) << 30))
+    size *= 2;
+  if (fwrite (BT_MAGIC, 1, 8, fp) != 8 || fwrite (hdr, 1, sizeof (hdr), fp) != sizeof (hdr))
+    return NULL;
+
+  bt = ddsrt_malloc (sizeof (*bt));
+  memset (bt, 0, sizeof (*bt));
+  bt->fp = fp;
+  bt->ringsize = size;
+  bt->fmttab = ddsrt_hh_new (256, bt_fmt_hash, bt_fmt_equal);
+  ddsrt_mutex_init (&bt->lock);
+  ddsrt_cond_init (&bt->cond);
+  ddsrt_threadattr_init (&tattr);
+  if (ddsrt_thread_create (&bt->flusher_tid, "bintrace", &tattr, bt_flusher, bt) != DDS_RETCODE_OK)
+  {
+    ddsrt_cond_destroy (&bt->cond);
+    ddsrt_mutex_destroy (&bt->lock);
+    ddsrt_hh_free (bt->fmttab);
+    ddsrt_free (bt);
+    return NULL;
+  }
+  return bt;
+}
+
+void ddsrt_bintrace_free (struct ddsrt_bintrace *bt)
+{
+  struct bt_ring *r;
+
+  ddsrt_mutex_lock (&bt->lock);
+  bt->terminate = true;
+  ddsrt_cond_broadcast (&bt->cond);
+  ddsrt_mutex_unlock (&bt->lock);
+  (void) ddsrt_thread_join (bt->flusher_tid, NULL);
+
+  bt_flush (bt, true);
+  (void) fflush (bt->fp);
+  while ((r = bt->rings) != NULL)
+  {
+    bt->rings = r->next;
+    ddsrt_free (r->buf);
+    r->buf = NULL;
+    ddsrt_atomic_st32 (&r->detached, 1);
+    bt_ring_unref (r);
+  }
+  for (uint32_t i = 0; i < bt->nfmts; i++)
+    ddsrt_free (bt->fmts[i]);
+  ddsrt_free (bt->fmts);
+  ddsrt_hh_free (bt->fmttab);
+  ddsrt_cond_destroy (&bt->cond);
+  ddsrt_mutex_destroy (&bt->lock);
+  ddsrt_free (bt);
+}
+
+/* Decoder */
+
+struct bt_dec_fmt {
+  char *fmt;
+  uint32_t flags;
+};
+
+struct bt_dec_thread {
+  char *name;
+  size_t len;
+  char line[BT_LINE_MAX];
+};
+
+struct bt_dec {
+  FILE *out;
+  uint32_t domid;
+  uint32_t nfmts, nthreads;
+  struct bt_dec_fmt *fmts;
+  struct bt_dec_thread **threads;
+  char *tmp;
+  size_t tmpsize, tmppos;
+};
+
+static void bt_dec_tmp_append (struct bt_dec *d, const char *s, size_t n)
+{
+  if (d->tmppos + n + 1 > d->tmpsize)
+  {
+    while (d->tmppos + n + 1 > d->tmpsize)
+      d->tmpsize = (d->tmpsize == 0) ? 4096 : 2 * d->tmpsize;
+    d->tmp = ddsrt_realloc (d->tmp, d->tmpsize);
+  }
+  memcpy (d->tmp + d->tmppos, s, n);
+  d->tmppos += n;
+  d->tmp[d->tmppos] = 0;
+}
+
+DDSRT_WARNING_GNUC_OFF (format-nonliteral)
+DDSRT_WARNING_CLANG_OFF (format-nonliteral)
+
+static void bt_dec_tmp_printf (struct bt_dec *d, const char *fmt, ...)
+{
+  char buf[256];
+  va_list ap;
+  int n;
+  va_start (ap, fmt);
+  n = vsnprintf (buf, sizeof (buf), fmt, ap);
+  va_end (ap);
+  if (n < 0)
+    return;
+  else if ((size_t) n < sizeof (buf))
+    bt_dec_tmp_append (d, buf, (size_t) n);
+  else
+  {
+    char *xbuf = ddsrt_malloc ((size_t) n + 1);
+    va_start (ap, fmt);
+    (void) vsnprintf (xbuf, (size_t) n + 1, fmt, ap);
+    va_end (ap);
+    bt_dec_tmp_append (d, xbuf, (size_t) n);
+    ddsrt_free (xbuf);
+  }
+}
+
+DDSRT_WARNING_CLANG_ON (format-nonliteral)
+DDSRT_WARNING_GNUC_ON (format-nonliteral)
+
+static bool bt_dec_get (const unsigned char **p, const unsigned char *end, void *dst, size_t n)
+{
+  if ((size_t) (end - *p) < n)
+    return false;
+  memcpy (dst, *p, n);
+  *p += n;
+  return true;
+}
+
+/* Formats the arguments in [p,end) according to fmt into d->tmp */
+static bool bt_dec_format (struct bt_dec *d, const char *fmt, const unsigned char *p, const unsigned char *end)
+{
+  const char *q;
+  while ((q = strchr (fmt, '%')) != NULL)
+  {
+    struct bt_conv c;
+    struct bt_arg a;
+    char spec[80], *s = spec;
+    int32_t width = 0, prec = 0;
+    bt_dec_tmp_append (d, fmt, (size_t) (q - fmt));
+    if (!bt_parse_conv (q, &c))
+      return false;
+    fmt = c.end;
+    if (c.conv == '%')
+    {
+      bt_dec_tmp_append (d, "%", 1);
+      continue;
+    }
+    if (!bt_conv_argkind (&c, &a) || c.nflags + c.nwidth + c.nprec + c.nlenstr > sizeof (spec) - 32)
+      return false;
+    if (c.width_arg && !bt_dec_get (&p, end, &width, 4))
+      return false;
+    if (c.prec_arg && !bt_dec_get (&p, end, &prec, 4))
+      return false;
+
+    /* reconstruct the conversion with '*' replaced by the actual values and
+       with the length modifier adjusted to the stored representation */
+    *s++ = '%';
+    memcpy (s, c.flags, c.nflags); s += c.nflags;
+    if (c.width_arg)
+      s += snprintf (s, 12, "%"PRId32, width);
+    else
+    {
+      memcpy (s, c.width, c.nwidth); s += c.nwidth;
+    }
+    if (c.has_prec && !(c.prec_arg && prec < 0))
+    {
+      *s++ = '.';
+      if (c.prec_arg)
+        s += snprintf (s, 12, "%"PRId32, prec);
+      else
+      {
+        memcpy (s, c.prec, c.nprec); s += c.nprec;
+      }
+    }
+    switch ((enum bt_argkind) a.kind)
+    {
+      case BTA_INT:
+        memcpy (s, c.lenstr, c.nlenstr); s += c.nlenstr;
+        break;
+      case BTA_LONG: case BTA_LLONG: case BTA_SIZE: case BTA_INTMAX: case BTA_PTRDIFF:
+        *s++ = 'l'; *s++ = 'l';
+        break;
+      case BTA_DOUBLE: case BTA_LDOUBLE: case BTA_PTR: case BTA_STR:
+        break;
+    }
+    *s++ = c.conv;
+    *s = 0;
+
+    switch ((enum bt_argkind) a.kind)
+    {
+      case BTA_INT: {
+        int32_t v;
+        if (!bt_dec_get (&p, end, &v, 4))
+          return false;
+        bt_dec_tmp_printf (d, spec, (int) v);
+        break;
+      }
+      case BTA_LONG: case BTA_LLONG: case BTA_SIZE: case BTA_INTMAX: case BTA_PTRDIFF: {
+        uint64_t v;
+        if (!bt_dec_get (&p, end, &v, 8))
+          return false;
+        if (a.is_unsigned)
+          bt_dec_tmp_printf (d, spec, (unsigned long long) v);
+        else
+          bt_dec_tmp_printf (d, spec, (long long) (int64_t) v);
+        break;
+      }
+      case BTA_DOUBLE: case BTA_LDOUBLE: {
+        double v;
+        if (!bt_dec_get (&p, end, &v, 8))
+          return false;
+        bt_dec_tmp_printf (d, spec, v);
+        break;
+      }
+      case BTA_PTR: {
+        uint64_t v;
+        if (!bt_dec_get (&p, end, &v, 8))
+          return false;
+        bt_dec_tmp_printf (d, spec, (void *) (uintptr_t) v);
+        break;
+      }
+      case BTA_STR: {
+        uint32_t n;
+        if (!bt_dec_get (&p, end, &n, 4))
+          return false;
+        if (n == UINT32_MAX)
+          bt_dec_tmp_printf (d, spec, (const char *) NULL);
+        else if ((size_t) (end - p) < n)
+          return false;
+        else
+        {
+          char *str = ddsrt_malloc (n + 1);
+          memcpy (str, p, n);
+          str[n] = 0;
+          p += n;
+          bt_dec_tmp_printf (d, spec, str);
+          ddsrt_free (str);
+        }
+        break;
+      }
+    }
+  }
+  bt_dec_tmp_append (d, fmt, strlen (fmt));
+  return true;
+}
+
+static void bt_dec_emit_line (struct bt_dec *d, struct bt_dec_thread *th, dds_time_t t)
+{
+  const unsigned sec = (unsigned) (t / DDS_NSECS_IN_SEC);
+  const int usec = (int) ((t % DDS_NSECS_IN_SEC) / DDS_NSECS_IN_USEC);
+  if (d->domid == UINT32_MAX)
+    fprintf (d->out, "%10u.%06d [] %*.*s: ", sec, usec, BT_MAX_TID_LEN, BT_MAX_TID_LEN, th->name);
+  else
+    fprintf (d->out, "%10u.%06d [%"PRIu32"] %*.*s: ", sec, usec, d->domid, BT_MAX_TID_LEN, BT_MAX_TID_LEN, th->name);
+  (void) fwrite (th->line, 1, th->len, d->out);
+  th->len = 0;
+}
+
+/* Appends d->tmp to the thread's line the way vlog1 in log.c does, including
+   truncation of overlong lines */
+static void bt_dec_append_line (struct bt_dec *d, struct bt_dec_thread *th)
+{
+  static const char trunc[] = "(trunc)\n";
+  const size_t nrem = BT_LINE_MAX - th->len;
+  if (nrem == 0)
+    return;
+  else if (d->tmppos < nrem)
+  {
+    memcpy (th->line + th->len, d->tmp, d->tmppos);
+    th->len += d->tmppos;
+  }
+  else
+  {
+    memcpy (th->line + th->len, d->tmp, nrem - 1);
+    th->len = BT_LINE_MAX;
+    memcpy (th->line + th->len - (sizeof (trunc) - 1), trunc, sizeof (trunc) - 1);
+  }
+}
+
+static bool bt_dec_record (struct bt_dec *d, struct bt_dec_thread *th, uint32_t fmtid, const unsigned char *p, const unsigned char *end)
+{
+  dds_time_t t;
+  if (!bt_dec_get (&p, end, &t, 8))
+    return false;
+  d->tmppos = 0;
+  bt_dec_tmp_append (d, "", 0);
+  if (fmtid == BT_FMTID_DROPPED)
+  {
+    uint32_t n;
+    if (!bt_dec_get (&p, end, &n, 4))
+      return false;
+    bt_dec_tmp_printf (d, "(%"PRIu32" trace messages dropped)\n", n);
+    bt_dec_append_line (d, th);
+    bt_dec_emit_line (d, th, t);
+    return true;
+  }
+  if (fmtid >= d->nfmts || d->fmts[fmtid].fmt == NULL)
+    return false;
+
+  const char *fmt = d->fmts[fmtid].fmt;
+  if (th->len == 0)
+  {
+    while (*fmt == '\n')
+      fmt++;
+  }
+  if (*fmt == 0)
+    return true;
+  if (!(d->fmts[fmtid].flags & BT_FMTFLAG_PREFORMATTED))
+  {
+    if (!bt_dec_format (d, fmt, p, end))
+      return false;
+  }
+  else
+  {
+    uint32_t n;
+    if (!bt_dec_get (&p, end, &n, 4) || (size_t) (end - p) < n)
+      return false;
+    bt_dec_tmp_append (d, (const char *) p, n);
+  }
+  bt_dec_append_line (d, th);
+  if (fmt[strlen (fmt) - 1] == '\n' && th->len > 1)
+    bt_dec_emit_line (d, th, t);
+  return true;
+}
+
+static bool bt_dec_events (struct bt_dec *d, const unsigned char *p, const unsigned char *end)
+{
+  uint32_t thid;
+  if (!bt_dec_get (&p, end, &thid, 4) || thid >= d->nthreads || d->threads[thid] == NULL)
+    return false;
+  struct bt_dec_thread * const th = d->threads[thid];
+  while (p < end)
+  {
+    uint32_t hdr[2];
+    if ((size_t) (end - p) < sizeof (hdr))
+      return false;
+    memcpy (hdr, p, sizeof (hdr));
+    if (hdr[0] < sizeof (hdr) || hdr[0] > (size_t) (end - p))
+      return false;
+    if (hdr[1] != BT_FMTID_PAD && !bt_dec_record (d, th, hdr[1], p + sizeof (hdr), p + hdr[0]))
+      return false;
+    p += (hdr[0] + 7) & ~(size_t) 7;
+  }
+  return true;
+}
+
+static char *bt_dec_strdup (const unsigned char *p, const unsigned char *end)
+{
+  const size_t n = (size_t) (end - p);
+  char *s = ddsrt_malloc (n + 1);
+  memcpy (s, p, n);
+  s[n] = 0;
+  return s;
+}
+
+static bool bt_dec_chunk (struct bt_dec *d, uint32_t kind, const unsigned char *p, const unsigned char *end)
+{
+  uint32_t id, flags;
+  switch (kind)
+  {
+    case BT_CHUNK_FMT:
+      if (!bt_dec_get (&p, end, &id, 4) || !bt_dec_get (&p, end, &flags, 4) || id == UINT32_MAX)
+        return false;
+      if (id >= d->nfmts)
+      {
+        d->fmts = ddsrt_realloc (d->fmts, (id + 1) * sizeof (*d->fmts));
+        memset (d->fmts + d->nfmts, 0, (id + 1 - d->nfmts) * sizeof (*d->fmts));
+        d->nfmts = id + 1;
+      }
+      ddsrt_free (d->fmts[id].fmt);
+      d->fmts[id].fmt = bt_dec_strdup (p, end);
+      d->fmts[id].flags = flags;
+      return true;
+    case BT_CHUNK_THREAD:
+      if (!bt_dec_get (&p, end, &id, 4) || id == UINT32_MAX)
+        return false;
+      if (id >= d->nthreads)
+      {
+        d->threads = ddsrt_realloc (d->threads, (id + 1) * sizeof (*d->threads));
+        memset (d->threads + d->nthreads, 0, (id + 1 - d->nthreads) * sizeof (*d->threads));
+        d->nthreads = id + 1;
+      }
+      if (d->threads[id] == NULL)
+      {
+        d->threads[id] = ddsrt_malloc (sizeof (*d->threads[id]));
+        d->threads[id]->len = 0;
+      }
+      else
+      {
+        ddsrt_free (d->threads[id]->name);
+      }
+      d->threads[id]->name = bt_dec_strdup (p, end);
+      return true;
+    case BT_CHUNK_EVENTS:
+      return bt_dec_events (d, p, end);
+    default:
+      /* skip unknown chunks */
+      return true;
+  }
+}
+
+static void bt_dec_reset (struct bt_dec *d)
+{
+  for (uint32_t i = 0; i < d->nfmts; i++)
+    ddsrt_free (d->fmts[i].fmt);
+  for (uint32_t i = 0; i < d->nthreads; i++)
+  {
+    if (d->threads[i])
+    {
+      ddsrt_free (d->threads[i]->name);
+      ddsrt_free (d->threads[i]);
+    }
+  }
+  ddsrt_free (d->fmts);
+  ddsrt_free (d->threads);
+  d->fmts = NULL;
+  d->threads = NULL;
+  d->nfmts = d->nthreads = 0;
+}
+
+static bool bt_dec_header (struct bt_dec *d, FILE *in)
+{
+  uint32_t hdr[2];
+  if (fread (hdr, 1, sizeof (hdr), in) != sizeof (hdr) || hdr[0] != BT_BOM)
+    return false;
+  d->domid = hdr[1];
+  return true;
+}
+
+dds_return_t ddsrt_bintrace_decode (FILE *out, FILE *in)
+{
+  struct bt_dec d;
+  char magic[8];
+  uint32_t hdr[2];
+  unsigned char *buf = NULL;
+  size_t bufsize = 0;
+  dds_return_t rc = DDS_RETCODE_OK;
+
+  DDSRT_STATIC_ASSERT_CODE (sizeof (hdr) == sizeof (magic));
+  memset (&d, 0, sizeof (d));
+  d.out = out;
+  if (fread (magic, 1, sizeof (magic), in) != sizeof (magic) || memcmp (magic, BT_MAGIC, sizeof (magic)) != 0 || !bt_dec_header (&d, in))
+    return DDS_RETCODE_BAD_PARAMETER;
+  while (fread (hdr, 1, sizeof (hdr), in) == sizeof (hdr))
+  {
+    if (memcmp (hdr, BT_MAGIC, sizeof (hdr)) == 0)
+    {
+      /* Tracing/AppendToFile: a new trace starts */
+      bt_dec_reset (&d);
+      if (!bt_dec_header (&d, in))
+      {
+        rc = DDS_RETCODE_BAD_PARAMETER;
+        break;
+      }
+      continue;
+    }
+    if (hdr[1] > bufsize)
+    {
+      bufsize = hdr[1];
+      buf = ddsrt_realloc (buf, bufsize);
+    }
+    if (fread (buf, 1, hdr[1], in) != hdr[1] || !bt_dec_chunk (&d, hdr[0], buf, buf + hdr[1]))
+    {
+      rc = DDS_RETCODE_BAD_PARAMETER;
+      break;
+    }
+  }
+
+  bt_dec_reset (&d);
+  ddsrt_free (d.tmp);
+  ddsrt_free (buf);
+  return rc;
+}
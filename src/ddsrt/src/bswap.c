@@ -9,6 +9,9 @@
  *
  * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
  */
+#include <assert.h>
+#include <string.h>
+
 #include "dds/ddsrt/bswap.h"
 
 extern inline uint16_t ddsrt_bswap2u (uint16_t x);
@@ -17,3 +20,158 @@ extern inline uint64_t ddsrt_bswap8u (uint64_t x);
 extern inline int16_t ddsrt_bswap2 (int16_t x);
 extern inline int32_t ddsrt_bswap4 (int32_t x);
 extern inline int64_t ddsrt_bswap8 (int64_t x);
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BSWAP_SSE2 1
+#if (defined (__GNUC__) || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+#include <immintrin.h>
+#define BSWAP_AVX2 1
+#endif
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#define BSWAP_NEON 1
+#endif
+
+/* The vector kernels handle as many whole vectors as fit in nbytes and
+   return the number of bytes they processed, leaving the remainder to the
+   scalar loop. All loads and stores are unaligned: an array in a CDR stream
+   is only aligned relative to the start of the stream. */
+
+#ifdef BSWAP_AVX2
+__attribute__ ((target ("avx2")))
+static uint32_t bswap_avx2 (unsigned char *p, uint32_t nbytes, uint32_t size)
+{
+  __m256i mask;
+  switch (size)
+  {
+    case 2:
+      mask = _mm256_setr_epi8 (1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                               1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+      break;
+    case 4:
+      mask = _mm256_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                               3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+      break;
+    default:
+      mask = _mm256_setr_epi8 (7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                               7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+      break;
+  }
+  uint32_t i;
+  for (i = 0; nbytes - i >= 32; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256 ((const __m256i *) (p + i));
+    _mm256_storeu_si256 ((__m256i *) (p + i), _mm256_shuffle_epi8 (v, mask));
+  }
+  return i;
+}
+
+static int have_avx2 (void)
+{
+  /* __builtin_cpu_supports reads a table initialised by a constructor in
+     libgcc, so a plain call is cheap */
+  return __builtin_cpu_supports ("avx2");
+}
+#endif
+
+#ifdef BSWAP_SSE2
+static uint32_t bswap_sse2 (unsigned char *p, uint32_t nbytes, uint32_t size)
+{
+  /* SSE2 has no byte shuffle: swap the bytes in each 16-bit word with
+     shifts, then reorder 16-bit words for the wider types */
+  uint32_t i;
+  for (i = 0; nbytes - i >= 16; i += 16)
+  {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (p + i));
+    v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+    if (size == 4)
+    {
+      v = _mm_shufflelo_epi16 (v, _MM_SHUFFLE (2, 3, 0, 1));
+      v = _mm_shufflehi_epi16 (v, _MM_SHUFFLE (2, 3, 0, 1));
+    }
+    else if (size == 8)
+    {
+      v = _mm_shufflelo_epi16 (v, _MM_SHUFFLE (0, 1, 2, 3));
+      v = _mm_shufflehi_epi16 (v, _MM_SHUFFLE (0, 1, 2, 3));
+    }
+    _mm_storeu_si128 ((__m128i *) (p + i), v);
+  }
+  return i;
+}
+#endif
+
+#ifdef BSWAP_NEON
+static uint32_t bswap_neon (unsigned char *p, uint32_t nbytes, uint32_t size)
+{
+  uint32_t i;
+  for (i = 0; nbytes - i >= 16; i += 16)
+  {
+    uint8x16_t v = vld1q_u8 (p + i);
+    switch (size)
+    {
+      case 2: v = vrev16q_u8 (v); break;
+      case 4: v = vrev32q_u8 (v); break;
+      default: v = vrev64q_u8 (v); break;
+    }
+    vst1q_u8 (p + i, v);
+  }
+  return i;
+}
+#endif
+
+static uint32_t bswap_vector (unsigned char *p, uint32_t nbytes, uint32_t size)
+{
+  uint32_t done = 0;
+#ifdef BSWAP_AVX2
+  if (nbytes >= 64 && have_avx2 ())
+    done = bswap_avx2 (p, nbytes, size);
+#endif
+#ifdef BSWAP_SSE2
+  done += bswap_sse2 (p + done, nbytes - done, size);
+#elif defined BSWAP_NEON
+  done += bswap_neon (p + done, nbytes - done, size);
+#else
+  (void) p; (void) nbytes; (void) size;
+#endif
+  return done;
+}
+
+void ddsrt_bswap2u_array (void *xs, uint32_t n)
+{
+  unsigned char *p = xs;
+  assert (n <= UINT32_MAX / 2);
+  for (uint32_t i = bswap_vector (p, 2 * n, 2); i < 2 * n; i += 2)
+  {
+    uint16_t x;
+    memcpy (&x, p + i, sizeof (x));
+    x = ddsrt_bswap2u (x);
+    memcpy (p + i, &x, sizeof (x));
+  }
+}
+
+void ddsrt_bswap4u_array (void *xs, uint32_t n)
+{
+  unsigned char *p = xs;
+  assert (n <= UINT32_MAX / 4);
+  for (uint32_t i = bswap_vector (p, 4 * n, 4); i < 4 * n; i += 4)
+  {
+    uint32_t x;
+    memcpy (&x, p + i, sizeof (x));
+    x = ddsrt_bswap4u (x);
+    memcpy (p + i, &x, sizeof (x));
+  }
+}
+
+void ddsrt_bswap8u_array (void *xs, uint32_t n)
+{
+  unsigned char *p = xs;
+  assert (n <= UINT32_MAX / 8);
+  for (uint32_t i = bswap_vector (p, 8 * n, 8); i < 8 * n; i += 8)
+  {
+    uint64_t x;
+    memcpy (&x, p + i, sizeof (x));
+    x = ddsrt_bswap8u (x);
+    memcpy (p + i, &x, sizeof (x));
+  }
+}
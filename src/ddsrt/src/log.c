@@ -16,6 +16,7 @@
 #include <string.h>
 
 #include "dds/ddsrt/log.h"
+#include "dds/ddsrt/bintrace.h"
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/threads.h"
 #include "dds/ddsrt/static_assert.h"
@@ -46,6 +47,7 @@ static ddsrt_rwlock_t lock;
 struct ddsrt_log_cfg_impl {
   struct ddsrt_log_cfg_common c;
   FILE *sink_fps[2];
+  struct ddsrt_bintrace *bintrace;
 };
 
 DDSRT_STATIC_ASSERT (sizeof (struct ddsrt_log_cfg_impl) <= sizeof (struct ddsrt_log_cfg));
@@ -168,6 +170,14 @@ void dds_log_cfg_init (struct ddsrt_log_cfg *cfg, uint32_t domid, uint32_t trace
   cfgimpl->sink_fps[TRACE] = trace_fp;
 }
 
+void dds_log_cfg_set_bintrace (struct ddsrt_log_cfg *cfg, struct ddsrt_bintrace *bt)
+{
+  struct ddsrt_log_cfg_impl *cfgimpl = (struct ddsrt_log_cfg_impl *) cfg;
+  cfgimpl->bintrace = bt;
+  /* only the log sink remains for the text output */
+  cfgimpl->sink_fps[TRACE] = NULL;
+}
+
 static size_t print_header (char *str, uint32_t id)
 {
   int cnt, off;
@@ -310,6 +320,15 @@ void dds_log_cfg (const struct ddsrt_log_cfg *cfg, uint32_t cat, const char *fil
      and have to keep them synchronized */
   if ((cfgimpl->c.mask & cat) && ((dds_get_log_mask () | cfgimpl->c.tracemask) & cat)) {
     va_list ap;
+    if (cfgimpl->bintrace) {
+      /* everything that would go into the text trace goes into the binary
+         one, without taking the lock; only log messages need formatting */
+      va_start (ap, fmt);
+      ddsrt_bintrace_vlog (cfgimpl->bintrace, fmt, ap);
+      va_end (ap);
+      if (!(cat & DDS_LOG_MASK))
+        return;
+    }
     va_start (ap, fmt);
     vlog (cfgimpl, cat, cfgimpl->c.domid, file, line, func, fmt, ap);
     va_end (ap);
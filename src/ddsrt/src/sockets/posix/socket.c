@@ -9,12 +9,17 @@
  *
  * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
  */
+#if defined(__linux) && !LWIP_SOCKET
+#define _GNU_SOURCE /* Required for recvmmsg, sendmmsg and struct mmsghdr */
+#endif
 #include <assert.h>
+#include <limits.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "dds/ddsrt/log.h"
 #include "dds/ddsrt/misc.h"
+#include "dds/ddsrt/static_assert.h"
 #include "dds/ddsrt/sockets_priv.h"
 
 #if !LWIP_SOCKET
@@ -461,6 +466,30 @@ ddsrt_recvmsg(
   return recv_error_to_retcode(errno);
 }
 
+#if DDSRT_HAVE_MMSG
+dds_return_t
+ddsrt_recvmmsg(
+  ddsrt_socket_t sock,
+  ddsrt_mmsghdr_t *msgs,
+  size_t vlen,
+  int flags,
+  size_t *rcvd)
+{
+  int n;
+
+  DDSRT_STATIC_ASSERT (sizeof (ddsrt_mmsghdr_t) == sizeof (struct mmsghdr));
+  DDSRT_STATIC_ASSERT (offsetof (ddsrt_mmsghdr_t, msg_len) == offsetof (struct mmsghdr, msg_len));
+  assert(vlen <= UINT_MAX);
+  if ((n = recvmmsg(sock, (struct mmsghdr *) msgs, (unsigned int) vlen, flags | MSG_WAITFORONE, NULL)) != -1) {
+    assert(n >= 0);
+    *rcvd = (size_t) n;
+    return DDS_RETCODE_OK;
+  }
+
+  return recv_error_to_retcode(errno);
+}
+#endif
+
 static inline dds_return_t
 send_error_to_retcode(int errnum)
 {
@@ -541,6 +570,28 @@ ddsrt_sendmsg(
   return send_error_to_retcode(errno);
 }
 
+#if DDSRT_HAVE_MMSG
+dds_return_t
+ddsrt_sendmmsg(
+  ddsrt_socket_t sock,
+  ddsrt_mmsghdr_t *msgs,
+  size_t vlen,
+  int flags,
+  size_t *sent)
+{
+  int n;
+
+  assert(vlen <= UINT_MAX);
+  if ((n = sendmmsg(sock, (struct mmsghdr *) msgs, (unsigned int) vlen, flags)) != -1) {
+    assert(n >= 0);
+    *sent = (size_t) n;
+    return DDS_RETCODE_OK;
+  }
+
+  return send_error_to_retcode(errno);
+}
+#endif
+
 dds_return_t
 ddsrt_select(
   int32_t nfds,
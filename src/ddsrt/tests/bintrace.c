@@ -0,0 +1,214 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <wchar.h>
+
+#include "CUnit/Test.h"
+#include "dds/ddsrt/bintrace.h"
+#include "dds/ddsrt/heap.h"
+#include "dds/ddsrt/log.h"
+#include "dds/ddsrt/string.h"
+#include "dds/ddsrt/threads.h"
+
+/* length of the timestamp at the start of each line, the only part that
+   differs between the text trace and the decoded binary one */
+#define TSLEN 17
+
+static const int some_object = 0;
+
+static void log_all (const struct ddsrt_log_cfg *cfg)
+{
+  char longstr[3000];
+  memset (longstr, 'x', sizeof (longstr) - 1);
+  longstr[sizeof (longstr) - 1] = 0;
+
+  DDS_CLOG (DDS_LC_TRACE, cfg, "int %d %i %u %x %X %o %5d|%-5d|%05d %hd %hhu %c %%\n", -1, 2, 3u, 0xabcu, 0xabcu, 8u, 42, 42, 42, (short) -3, (unsigned char) 255, 'q');
+  DDS_CLOG (DDS_LC_TRACE, cfg, "long %ld %lu %lld %llx %"PRId64" %"PRIx64" %zu %td %jd\n", -5l, 5ul, -6ll, 0x1234567890abcdefull, INT64_MIN, UINT64_MAX, (size_t) 7, (ptrdiff_t) -8, (intmax_t) 9);
+  DDS_CLOG (DDS_LC_TRACE, cfg, "float %f %.3e %g %10.2f %Lf\n", 1.5, 12345.678, 0.0001, -3.25, (long double) 2.5);
+  DDS_CLOG (DDS_LC_TRACE, cfg, "str %s|%10s|%-10s|%.3s|%.*s|%*d|%s\n", "abc", "right", "left", "truncated", 2, "precision", -6, 17, "");
+  DDS_CLOG (DDS_LC_TRACE, cfg, "ptr %p\n", (const void *) &some_object);
+  /* line built from several calls, with leading newlines skipped */
+  DDS_CLOG (DDS_LC_TRACE, cfg, "\n\nmulti");
+  DDS_CLOG (DDS_LC_TRACE, cfg, " part %d", 1);
+  DDS_CLOG (DDS_LC_TRACE, cfg, "%s", "");
+  DDS_CLOG (DDS_LC_TRACE, cfg, " line\n");
+  DDS_CLOG (DDS_LC_TRACE, cfg, "\n");
+  /* overlong line gets truncated */
+  DDS_CLOG (DDS_LC_TRACE, cfg, "long line %s\n", longstr);
+  DDS_CLOG (DDS_LC_TRACE, cfg, "long %s", longstr);
+  DDS_CLOG (DDS_LC_TRACE, cfg, " continued\n");
+  /* can't be captured, must be formatted at the time of logging */
+  DDS_CLOG (DDS_LC_TRACE, cfg, "wide %lc\n", (wint_t) 'w');
+  DDS_CLOG (DDS_LC_TRACE, cfg, "done\n");
+}
+
+static char *read_all (FILE *fp)
+{
+  size_t size = 0, n;
+  char *buf = NULL, tmp[1024];
+  rewind (fp);
+  while ((n = fread (tmp, 1, sizeof (tmp), fp)) > 0)
+  {
+    buf = ddsrt_realloc (buf, size + n + 1);
+    memcpy (buf + size, tmp, n);
+    size += n;
+  }
+  if (buf == NULL)
+    buf = ddsrt_malloc (1);
+  buf[size] = 0;
+  return buf;
+}
+
+static char *next_line (char **cursor)
+{
+  char *l;
+  while ((l = ddsrt_strsep (cursor, "\n")) != NULL && *l == 0)
+    ;
+  return l;
+}
+
+static void compare_ignoring_timestamps (char *text, char *decoded, int expected_nlines)
+{
+  char *tl, *dl;
+  int nlines = 0;
+  while ((tl = next_line (&text)) != NULL && (dl = next_line (&decoded)) != NULL)
+  {
+    CU_ASSERT_FATAL (strlen (tl) > TSLEN && strlen (dl) > TSLEN);
+    CU_ASSERT_STRING_EQUAL (tl + TSLEN, dl + TSLEN);
+    nlines++;
+  }
+  CU_ASSERT (tl == NULL && next_line (&decoded) == NULL);
+  CU_ASSERT (nlines == expected_nlines);
+}
+
+CU_Test(ddsrt_bintrace, decode_matches_text)
+{
+  struct ddsrt_log_cfg tcfg, bcfg;
+  struct ddsrt_bintrace *bt;
+  FILE *tfp, *bfp, *dfp;
+  char *text, *decoded;
+
+  tfp = tmpfile ();
+  bfp = tmpfile ();
+  dfp = tmpfile ();
+  CU_ASSERT_FATAL (tfp != NULL && bfp != NULL && dfp != NULL);
+  ddsrt_thread_setname ("bttest");
+
+  dds_log_cfg_init (&tcfg, 3, DDS_LC_TRACE, NULL, tfp);
+  log_all (&tcfg);
+  fflush (tfp);
+
+  bt = ddsrt_bintrace_new (bfp, 3, 0);
+  CU_ASSERT_FATAL (bt != NULL);
+  dds_log_cfg_init (&bcfg, 3, DDS_LC_TRACE, NULL, NULL);
+  dds_log_cfg_set_bintrace (&bcfg, bt);
+  log_all (&bcfg);
+  ddsrt_bintrace_free (bt);
+
+  rewind (bfp);
+  CU_ASSERT_FATAL (ddsrt_bintrace_decode (dfp, bfp) == DDS_RETCODE_OK);
+  fflush (dfp);
+
+  text = read_all (tfp);
+  decoded = read_all (dfp);
+  compare_ignoring_timestamps (text, decoded, 10);
+  ddsrt_free (text);
+  ddsrt_free (decoded);
+  fclose (tfp);
+  fclose (bfp);
+  fclose (dfp);
+}
+
+#define NTHREADS 4
+#define NLINES 20000
+
+struct logger_arg {
+  const struct ddsrt_log_cfg *cfg;
+  int id;
+};
+
+static uint32_t logger (void *varg)
+{
+  struct logger_arg * const arg = varg;
+  for (int i = 0; i < NLINES; i++)
+    DDS_CLOG (DDS_LC_TRACE, arg->cfg, "thread %d line %d\n", arg->id, i);
+  return 0;
+}
+
+CU_Test(ddsrt_bintrace, concurrent)
+{
+  struct ddsrt_log_cfg cfg;
+  struct ddsrt_bintrace *bt;
+  struct logger_arg args[NTHREADS];
+  ddsrt_thread_t tids[NTHREADS];
+  ddsrt_threadattr_t tattr;
+  int next[NTHREADS];
+  FILE *bfp, *dfp;
+  char *decoded, *cursor, *l;
+
+  bfp = tmpfile ();
+  dfp = tmpfile ();
+  CU_ASSERT_FATAL (bfp != NULL && dfp != NULL);
+  /* smallest possible buffers, so that some messages are likely dropped */
+  bt = ddsrt_bintrace_new (bfp, 0, 0);
+  CU_ASSERT_FATAL (bt != NULL);
+  dds_log_cfg_init (&cfg, 0, DDS_LC_TRACE, NULL, NULL);
+  dds_log_cfg_set_bintrace (&cfg, bt);
+
+  ddsrt_threadattr_init (&tattr);
+  for (int i = 0; i < NTHREADS; i++)
+  {
+    char name[16];
+    snprintf (name, sizeof (name), "logger%d", i);
+    args[i].cfg = &cfg;
+    args[i].id = i;
+    CU_ASSERT_FATAL (ddsrt_thread_create (&tids[i], name, &tattr, logger, &args[i]) == DDS_RETCODE_OK);
+  }
+  for (int i = 0; i < NTHREADS; i++)
+    CU_ASSERT_FATAL (ddsrt_thread_join (tids[i], NULL) == DDS_RETCODE_OK);
+  ddsrt_bintrace_free (bt);
+
+  rewind (bfp);
+  CU_ASSERT_FATAL (ddsrt_bintrace_decode (dfp, bfp) == DDS_RETCODE_OK);
+  fflush (dfp);
+  decoded = read_all (dfp);
+
+  /* every thread's lines must be in order, with gaps accounted for by
+     notices of dropped messages */
+  memset (next, 0, sizeof (next));
+  cursor = decoded;
+  while ((l = next_line (&cursor)) != NULL)
+  {
+    int thr, id, line, n, pos;
+    CU_ASSERT_FATAL (sscanf (l, "%*u.%*d [0] logger%d: %n", &thr, &pos) == 1);
+    CU_ASSERT_FATAL (thr >= 0 && thr < NTHREADS);
+    if (sscanf (l + pos, "thread %d line %d", &id, &line) == 2)
+    {
+      CU_ASSERT_FATAL (id == thr && line == next[thr]);
+      next[thr] = line + 1;
+    }
+    else
+    {
+      CU_ASSERT_FATAL (sscanf (l + pos, "(%d trace messages dropped)", &n) == 1);
+      next[thr] += n;
+    }
+  }
+  for (int i = 0; i < NTHREADS; i++)
+    CU_ASSERT (next[i] == NLINES);
+  ddsrt_free (decoded);
+  fclose (bfp);
+  fclose (dfp);
+}
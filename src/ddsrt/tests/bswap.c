@@ -0,0 +1,73 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "CUnit/Test.h"
+#include "dds/ddsrt/bswap.h"
+
+#define MAXN 200 /* enough for several iterations of the widest vector loop */
+#define GUARD 16
+
+static void reference (unsigned char *dst, const unsigned char *src, uint32_t size, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    switch (size)
+    {
+      case 2: {
+        uint16_t x; memcpy (&x, src + 2 * i, 2); x = ddsrt_bswap2u (x); memcpy (dst + 2 * i, &x, 2);
+        break;
+      }
+      case 4: {
+        uint32_t x; memcpy (&x, src + 4 * i, 4); x = ddsrt_bswap4u (x); memcpy (dst + 4 * i, &x, 4);
+        break;
+      }
+      case 8: {
+        uint64_t x; memcpy (&x, src + 8 * i, 8); x = ddsrt_bswap8u (x); memcpy (dst + 8 * i, &x, 8);
+        break;
+      }
+    }
+  }
+}
+
+CU_Test(ddsrt_bswap, array)
+{
+  static const uint32_t sizes[] = { 2, 4, 8 };
+  static unsigned char src[2 * GUARD + 8 * MAXN + 8], exp[sizeof (src)], act[sizeof (src)];
+
+  for (size_t i = 0; i < sizeof (src); i++)
+    src[i] = (unsigned char) (i * 37 + 11);
+
+  for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+  {
+    const uint32_t size = sizes[s];
+    for (uint32_t misalign = 0; misalign < 8; misalign++)
+    {
+      for (uint32_t n = 0; n <= MAXN; n++)
+      {
+        unsigned char * const p = act + GUARD + misalign;
+        memcpy (exp, src, sizeof (src));
+        memcpy (act, src, sizeof (src));
+        reference (exp + GUARD + misalign, src + GUARD + misalign, size, n);
+        switch (size)
+        {
+          case 2: ddsrt_bswap2u_array (p, n); break;
+          case 4: ddsrt_bswap4u_array (p, n); break;
+          case 8: ddsrt_bswap8u_array (p, n); break;
+        }
+        /* bytes outside the array must not be touched either */
+        CU_ASSERT_FATAL (memcmp (exp, act, sizeof (act)) == 0);
+      }
+    }
+  }
+}
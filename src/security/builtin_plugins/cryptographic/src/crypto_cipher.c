@@ -11,6 +11,7 @@
  */
 #include <assert.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "dds/ddsrt/heap.h"
 #include "dds/ddsrt/types.h"
@@ -55,7 +56,153 @@ static bool trusted_check_buffer_sizes (const size_t num, const trusted_crypto_d
 }
 #endif
 
-bool crypto_cipher_encrypt_data (const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const size_t num_inp, const trusted_crypto_data_t *inpdata, trusted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
+void crypto_cipher_ctx_cache_init (crypto_cipher_ctx_cache *cache)
+{
+  ddsrt_mutex_init (&cache->lock);
+  cache->key_size = 0;
+  memset (cache->key.data, 0, sizeof (cache->key.data));
+  cache->has_derivation = false;
+  cache->nctx = 0;
+}
+
+static void free_cipher_ctxs (uint32_t n, EVP_CIPHER_CTX **ctxs)
+{
+  for (uint32_t i = 0; i < n; i++)
+    EVP_CIPHER_CTX_free (ctxs[i]);
+}
+
+void crypto_cipher_ctx_cache_fini (crypto_cipher_ctx_cache *cache)
+{
+  free_cipher_ctxs (cache->nctx, cache->ctx);
+  memset (cache->key.data, 0, sizeof (cache->key.data));
+  memset (cache->master_salt, 0, sizeof (cache->master_salt));
+  memset (cache->master_key, 0, sizeof (cache->master_key));
+  ddsrt_mutex_destroy (&cache->lock);
+}
+
+static bool cache_key_matches_locked (const crypto_cipher_ctx_cache *cache, const crypto_session_key_t *key, uint32_t key_size)
+{
+  return cache->key_size == key_size && memcmp (cache->key.data, key->data, key_size / 8) == 0;
+}
+
+static uint32_t cache_set_key_locked (crypto_cipher_ctx_cache *cache, const crypto_session_key_t *key, uint32_t key_size, EVP_CIPHER_CTX **stale)
+{
+  /* contexts in the pool are initialised with the old key, the caller must free them
+     after releasing the lock */
+  const uint32_t n = cache->nctx;
+  memcpy (stale, cache->ctx, n * sizeof (*stale));
+  cache->nctx = 0;
+  cache->key = *key;
+  cache->key_size = key_size;
+  cache->has_derivation = false;
+  return n;
+}
+
+typedef bool (*derive_key_fn_t) (crypto_session_key_t *session_key, uint32_t session_id, const unsigned char *master_salt, const unsigned char *master_key, DDS_Security_CryptoTransformKind_Enum transformation_kind, DDS_Security_SecurityException *ex);
+
+static bool cache_derivation_matches_locked (const crypto_cipher_ctx_cache *cache, uint32_t session_id, const master_key_material *keymat, const unsigned char *master_key, uint32_t key_bytes)
+{
+  return (cache->has_derivation &&
+          cache->session_id == session_id &&
+          cache->transformation_kind == keymat->transformation_kind &&
+          memcmp (cache->master_salt, keymat->master_salt, key_bytes) == 0 &&
+          memcmp (cache->master_key, master_key, key_bytes) == 0);
+}
+
+static bool cached_derived_key (crypto_cipher_ctx_cache *cache, uint32_t session_id, const master_key_material *keymat, const unsigned char *master_key, derive_key_fn_t derive, remote_session_info *info, DDS_Security_SecurityException *ex)
+{
+  info->key_size = crypto_get_key_size (keymat->transformation_kind);
+  info->id = session_id;
+  if (!CRYPTO_TRANSFORM_HAS_KEYS (keymat->transformation_kind))
+    return derive (&info->key, info->id, keymat->master_salt, master_key, keymat->transformation_kind, ex);
+
+  const uint32_t key_bytes = CRYPTO_KEY_SIZE_BYTES (keymat->transformation_kind);
+  bool found;
+  ddsrt_mutex_lock (&cache->lock);
+  if ((found = cache_derivation_matches_locked (cache, session_id, keymat, master_key, key_bytes)))
+    info->key = cache->key;
+  ddsrt_mutex_unlock (&cache->lock);
+  if (found)
+    return true;
+
+  if (!derive (&info->key, info->id, keymat->master_salt, master_key, keymat->transformation_kind, ex))
+    return false;
+
+  EVP_CIPHER_CTX *stale[CRYPTO_CIPHER_CTX_CACHE_SIZE];
+  uint32_t nstale = 0;
+  ddsrt_mutex_lock (&cache->lock);
+  if (!cache_key_matches_locked (cache, &info->key, info->key_size))
+    nstale = cache_set_key_locked (cache, &info->key, info->key_size, stale);
+  cache->has_derivation = true;
+  cache->transformation_kind = keymat->transformation_kind;
+  cache->session_id = session_id;
+  memcpy (cache->master_salt, keymat->master_salt, key_bytes);
+  memcpy (cache->master_key, master_key, key_bytes);
+  ddsrt_mutex_unlock (&cache->lock);
+  free_cipher_ctxs (nstale, stale);
+  return true;
+}
+
+bool crypto_cipher_remote_session_key (crypto_cipher_ctx_cache *cache, uint32_t session_id, const master_key_material *keymat, remote_session_info *info, DDS_Security_SecurityException *ex)
+{
+  return cached_derived_key (cache, session_id, keymat, keymat->master_sender_key, crypto_calculate_session_key, info, ex);
+}
+
+bool crypto_cipher_receiver_specific_key (crypto_cipher_ctx_cache *cache, uint32_t session_id, const master_key_material *keymat, remote_session_info *info, DDS_Security_SecurityException *ex)
+{
+  return cached_derived_key (cache, session_id, keymat, keymat->master_receiver_specific_key, crypto_calculate_receiver_specific_key, info, ex);
+}
+
+static EVP_CIPHER_CTX *cipher_ctx_get (crypto_cipher_ctx_cache *cache, const crypto_session_key_t *key, uint32_t key_size, DDS_Security_SecurityException *ex)
+{
+  EVP_CIPHER_CTX *ctx = NULL;
+  if (cache)
+  {
+    EVP_CIPHER_CTX *stale[CRYPTO_CIPHER_CTX_CACHE_SIZE];
+    uint32_t nstale = 0;
+    ddsrt_mutex_lock (&cache->lock);
+    if (!cache_key_matches_locked (cache, key, key_size))
+      nstale = cache_set_key_locked (cache, key, key_size, stale);
+    else if (cache->nctx > 0)
+      ctx = cache->ctx[--cache->nctx];
+    ddsrt_mutex_unlock (&cache->lock);
+    free_cipher_ctxs (nstale, stale);
+    if (ctx)
+      return ctx;
+  }
+
+  /* GCM only uses the encryption direction of AES, so the direction doesn't matter
+     here: that gets set together with the IV for each message */
+  EVP_CIPHER const * const evp = (key_size != 256) ? EVP_aes_128_gcm () : EVP_aes_256_gcm ();
+  if ((ctx = EVP_CIPHER_CTX_new ()) == NULL)
+    SSLERROR (fail_context_new, "EVP_CIPHER_CTX_new");
+  if (!EVP_CipherInit_ex (ctx, evp, NULL, key->data, NULL, 1))
+    SSLERROR (fail_init, "EVP_CipherInit_ex to set aes_128_gcm/aes_256_gcm and key");
+  return ctx;
+
+fail_init:
+  EVP_CIPHER_CTX_free (ctx);
+fail_context_new:
+  return NULL;
+}
+
+static void cipher_ctx_put (crypto_cipher_ctx_cache *cache, const crypto_session_key_t *key, uint32_t key_size, EVP_CIPHER_CTX *ctx)
+{
+  if (cache)
+  {
+    ddsrt_mutex_lock (&cache->lock);
+    if (cache->nctx < CRYPTO_CIPHER_CTX_CACHE_SIZE && cache_key_matches_locked (cache, key, key_size))
+    {
+      cache->ctx[cache->nctx++] = ctx;
+      ctx = NULL;
+    }
+    ddsrt_mutex_unlock (&cache->lock);
+  }
+  if (ctx)
+    EVP_CIPHER_CTX_free (ctx);
+}
+
+bool crypto_cipher_encrypt_data (crypto_cipher_ctx_cache *cache, const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const size_t num_inp, const trusted_crypto_data_t *inpdata, trusted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
 {
   assert (session_key);
   assert (iv);
@@ -64,16 +211,13 @@ bool crypto_cipher_encrypt_data (const crypto_session_key_t *session_key, uint32
   assert (key_size == 128 || key_size == 256);
   assert (trusted_check_buffer_sizes (num_inp, inpdata, outpdata));
 
-  EVP_CIPHER const * const evp = (key_size != 256) ? EVP_aes_128_gcm () : EVP_aes_256_gcm ();
   EVP_CIPHER_CTX *ctx;
   unsigned char *ptr = outpdata ? outpdata->x.base : NULL;
 
-  if ((ctx = EVP_CIPHER_CTX_new ()) == NULL)
-    SSLERROR (fail_context_new, "EVP_CIPHER_CTX_new");
-  if (!EVP_EncryptInit_ex (ctx, evp, NULL, NULL, NULL))
-    SSLERROR (fail_encrypt, "EVP_EncryptInit_ex to set aes_128_gcm/aes_256_gcm");
-  if (!EVP_EncryptInit_ex (ctx, NULL, NULL, session_key->data, iv->u))
-    SSLERROR (fail_encrypt, "EVP_EncryptInit_ex to set key and IV");
+  if ((ctx = cipher_ctx_get (cache, session_key, key_size, ex)) == NULL)
+    goto fail_context_new;
+  if (!EVP_EncryptInit_ex (ctx, NULL, NULL, NULL, iv->u))
+    SSLERROR (fail_encrypt, "EVP_EncryptInit_ex to set IV");
 
   for (size_t i = 0; i < num_inp; i++)
   {
@@ -106,7 +250,7 @@ bool crypto_cipher_encrypt_data (const crypto_session_key_t *session_key, uint32
   if (!EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_GET_TAG, CRYPTO_HMAC_SIZE, tag->data))
     SSLERROR (fail_encrypt, "EVP_CIPHER_CTX_ctrl to get the tag");
 
-  EVP_CIPHER_CTX_free (ctx);
+  cipher_ctx_put (cache, session_key, key_size, ctx);
   return true;
 
 fail_encrypt:
@@ -115,7 +259,7 @@ fail_context_new:
   return false;
 }
 
-bool crypto_cipher_calc_hmac (const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const tainted_crypto_data_t *inpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
+bool crypto_cipher_calc_hmac (crypto_cipher_ctx_cache *cache, const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const tainted_crypto_data_t *inpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
 {
   const trusted_crypto_data_t inpdata_wrapper = { *inpdata };
   if (inpdata_wrapper.x.length > INT_MAX)
@@ -123,10 +267,10 @@ bool crypto_cipher_calc_hmac (const crypto_session_key_t *session_key, uint32_t
     DDS_Security_Exception_set (ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0, "oversize data fragment");
     return false;
   }
-  return crypto_cipher_encrypt_data (session_key, key_size, iv, 1, &inpdata_wrapper, NULL, tag, ex);
+  return crypto_cipher_encrypt_data (cache, session_key, key_size, iv, 1, &inpdata_wrapper, NULL, tag, ex);
 }
 
-bool crypto_cipher_decrypt_data (const remote_session_info *session, const struct init_vector *iv, const size_t num_inp, const const_tainted_crypto_data_t *inpdata, tainted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
+bool crypto_cipher_decrypt_data (crypto_cipher_ctx_cache *cache, const remote_session_info *session, const struct init_vector *iv, const size_t num_inp, const const_tainted_crypto_data_t *inpdata, tainted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
 {
   assert (session);
   assert (iv);
@@ -135,16 +279,13 @@ bool crypto_cipher_decrypt_data (const remote_session_info *session, const struc
   assert (session->key_size == 128 || session->key_size == 256);
   assert (check_buffer_sizes (num_inp, inpdata, outpdata));
 
-  EVP_CIPHER const * const evp = (session->key_size != 256) ? EVP_aes_128_gcm () : EVP_aes_256_gcm ();
   unsigned char *ptr = outpdata ? outpdata->base : NULL;
   EVP_CIPHER_CTX *ctx;
 
-  if ((ctx = EVP_CIPHER_CTX_new ()) == NULL)
-    SSLERROR (fail_context_new, "EVP_CIPHER_CTX_new");
-  if (!EVP_DecryptInit_ex (ctx, evp, NULL, NULL, NULL))
-    SSLERROR (fail_decrypt, "EVP_DecryptInit_ex to set aes_128_gcm/aes_256_gcm");
-  if (!EVP_DecryptInit_ex (ctx, NULL, NULL, session->key.data, iv->u))
-    SSLERROR (fail_decrypt, "EVP_DecryptInit_ex to set key and IV");
+  if ((ctx = cipher_ctx_get (cache, &session->key, session->key_size, ex)) == NULL)
+    goto fail_context_new;
+  if (!EVP_DecryptInit_ex (ctx, NULL, NULL, NULL, iv->u))
+    SSLERROR (fail_decrypt, "EVP_DecryptInit_ex to set IV");
 
   /* Set expected tag value. */
   if (!EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_SET_TAG, CRYPTO_HMAC_SIZE, tag->data))
@@ -182,7 +323,7 @@ bool crypto_cipher_decrypt_data (const remote_session_info *session, const struc
       SSLERROR (fail_decrypt, "EVP_EncryptFinal_ex to finalize signature check");
   }
 
-  EVP_CIPHER_CTX_free(ctx);
+  cipher_ctx_put (cache, &session->key, session->key_size, ctx);
   return true;
 
 fail_decrypt:
@@ -15,6 +15,50 @@
 #include "dds/ddsrt/types.h"
 #include "crypto_objects.h"
 
+/**
+ * @brief Initializes an (empty) cache of cipher contexts
+ */
+void crypto_cipher_ctx_cache_init (crypto_cipher_ctx_cache *cache)
+  ddsrt_nonnull_all;
+
+/**
+ * @brief Frees the cached cipher contexts and erases the cached key material
+ */
+void crypto_cipher_ctx_cache_fini (crypto_cipher_ctx_cache *cache)
+  ddsrt_nonnull_all;
+
+/**
+ * @brief Derives the session key for decoding data from a remote sender
+ *
+ * The session key is derived from the session id and the master key material
+ * of the sender. The result is remembered in the cache so that subsequent
+ * messages of the same session don't need the key derivation.
+ *
+ * @param[in,out] cache         Cache associated with the master key material
+ * @param[in]     session_id    The session id in the received crypto header
+ * @param[in]     keymat        The master key material of the remote sender
+ * @param[out]    info          Contains the session key and key size on return
+ * @param[in,out] ex            Security exception
+ */
+bool crypto_cipher_remote_session_key (crypto_cipher_ctx_cache *cache, uint32_t session_id, const master_key_material *keymat, remote_session_info *info, DDS_Security_SecurityException *ex)
+  ddsrt_nonnull((1, 3, 4, 5)) ddsrt_attribute_warn_unused_result;
+
+/**
+ * @brief Derives the receiver-specific key for a session
+ *
+ * Same as crypto_cipher_remote_session_key, but derives the key used for the
+ * receiver-specific MAC from the master receiver-specific key instead. It is
+ * used on both the sending and the receiving side.
+ *
+ * @param[in,out] cache         Cache associated with the master key material
+ * @param[in]     session_id    The session id in the crypto header
+ * @param[in]     keymat        The master key material containing the receiver-specific key
+ * @param[out]    info          Contains the receiver-specific key and key size on return
+ * @param[in,out] ex            Security exception
+ */
+bool crypto_cipher_receiver_specific_key (crypto_cipher_ctx_cache *cache, uint32_t session_id, const master_key_material *keymat, remote_session_info *info, DDS_Security_SecurityException *ex)
+  ddsrt_nonnull((1, 3, 4, 5)) ddsrt_attribute_warn_unused_result;
+
 /**
  * @brief Encodes the provide data using the provided key
  *
@@ -33,6 +77,7 @@
  * which the common_mac has to be computed. The encryped parameter is not relevant
  * in this case.
  *
+ * @param[in,out] cache         Cache of cipher contexts for the session key (optional)
  * @param[in]     session_key   The session key used to encode the provided data
  * @param[in]     key_size      The size of the session key (128 or 256 bit)
  * @param[in]     iv            The init vector used by the encoding
@@ -42,11 +87,22 @@
  * @param[in,out] tag           Contains on return the mac value calculated over the provided data
  * @param[in,out] ex            Security exception
  */
-bool crypto_cipher_encrypt_data(const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const size_t num_inp, const trusted_crypto_data_t *inpdata, trusted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
-  ddsrt_nonnull((1, 3, 5, 7, 8)) ddsrt_attribute_warn_unused_result;
+bool crypto_cipher_encrypt_data(crypto_cipher_ctx_cache *cache, const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const size_t num_inp, const trusted_crypto_data_t *inpdata, trusted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
+  ddsrt_nonnull((2, 4, 6, 8, 9)) ddsrt_attribute_warn_unused_result;
 
-bool crypto_cipher_calc_hmac (const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const tainted_crypto_data_t *inpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
-  ddsrt_nonnull((1, 3, 4, 5, 6)) ddsrt_attribute_warn_unused_result;
+/**
+ * @brief Computes the mac over (untrusted) input data, see crypto_cipher_encrypt_data
+ *
+ * @param[in,out] cache         Cache of cipher contexts for the session key (optional)
+ * @param[in]     session_key   The session key used to compute the mac
+ * @param[in]     key_size      The size of the session key (128 or 256 bit)
+ * @param[in]     iv            The init vector
+ * @param[in]     inpdata       The input data
+ * @param[in,out] tag           Contains on return the mac value calculated over the provided data
+ * @param[in,out] ex            Security exception
+ */
+bool crypto_cipher_calc_hmac (crypto_cipher_ctx_cache *cache, const crypto_session_key_t *session_key, uint32_t key_size, const struct init_vector *iv, const tainted_crypto_data_t *inpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
+  ddsrt_nonnull((2, 4, 5, 6, 7)) ddsrt_attribute_warn_unused_result;
 
 /**
  * @brief Decodes the provided data using the session key and key_size
@@ -63,6 +119,7 @@ bool crypto_cipher_calc_hmac (const crypto_session_key_t *session_key, uint32_t
  * data and the encrypted parameter should be NULL and the aad parameter should point to
  * the data for which the common_mac has to be verified.
  *
+ * @param[in,out] cache         Cache of cipher contexts for the session key (optional)
  * @param[in]     session       Contains the session key and key size used of the decoding
  * @param[in]     iv            The init vector used by the decoding
  * @param[in]     num_inp       The number of input data segments
@@ -71,7 +128,7 @@ bool crypto_cipher_calc_hmac (const crypto_session_key_t *session_key, uint32_t
  * @param[in,out] tag           The mac value which has to be verified
  * @param[in,out] ex            Security exception
  */
-bool crypto_cipher_decrypt_data(const remote_session_info *session, const struct init_vector *iv, const size_t num_inp, const const_tainted_crypto_data_t *inpdata, tainted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
-  ddsrt_nonnull((1, 2, 4, 6, 7)) ddsrt_attribute_warn_unused_result;
+bool crypto_cipher_decrypt_data(crypto_cipher_ctx_cache *cache, const remote_session_info *session, const struct init_vector *iv, const size_t num_inp, const const_tainted_crypto_data_t *inpdata, tainted_crypto_data_t *outpdata, crypto_hmac_t *tag, DDS_Security_SecurityException *ex)
+  ddsrt_nonnull((2, 3, 5, 7, 8)) ddsrt_attribute_warn_unused_result;
 
 #endif /* CRYPTO_CIPHER_H */
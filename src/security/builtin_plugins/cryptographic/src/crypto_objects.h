@@ -13,6 +13,7 @@
 #define CRYPTO_OBJECTS_H
 
 #include <openssl/rand.h>
+#include <openssl/evp.h>
 #include "dds/ddsrt/atomics.h"
 #include "dds/ddsrt/sync.h"
 #include "dds/ddsrt/types.h"
@@ -75,6 +76,27 @@ struct local_datareader_crypto;
 struct remote_datawriter_crypto;
 struct remote_datareader_crypto;
 
+#define CRYPTO_CIPHER_CTX_CACHE_SIZE 4
+
+/* Pool of OpenSSL cipher contexts that have been initialised with the cipher
+ * and (the key schedule of) one session key, so that encoding and decoding only
+ * need to set the IV. The pool is flushed when the session key changes. On the
+ * receiving side it also remembers which session id and master key material
+ * the key was derived from, so the key derivation can be skipped as well. */
+typedef struct crypto_cipher_ctx_cache
+{
+  ddsrt_mutex_t lock;
+  uint32_t key_size; /* 0: no key */
+  crypto_session_key_t key;
+  bool has_derivation;
+  DDS_Security_CryptoTransformKind_Enum transformation_kind;
+  uint32_t session_id;
+  unsigned char master_salt[CRYPTO_KEY_SIZE_MAX];
+  unsigned char master_key[CRYPTO_KEY_SIZE_MAX];
+  uint32_t nctx;
+  EVP_CIPHER_CTX *ctx[CRYPTO_CIPHER_CTX_CACHE_SIZE];
+} crypto_cipher_ctx_cache;
+
 typedef struct master_key_material
 {
   CryptoObject _parent;
@@ -84,6 +106,8 @@ typedef struct master_key_material
   unsigned char *master_sender_key;
   uint32_t receiver_specific_key_id;
   unsigned char *master_receiver_specific_key;
+  crypto_cipher_ctx_cache cipher_cache; /* for decoding data protected with this key material */
+  crypto_cipher_ctx_cache receiver_specific_cipher_cache; /* for receiver-specific MACs with this key material */
 } master_key_material;
 
 typedef struct session_key_material
@@ -97,6 +121,7 @@ typedef struct session_key_material
   uint64_t max_blocks_per_session;
   uint64_t init_vector_suffix;
   master_key_material *master_key_material;
+  crypto_cipher_ctx_cache cipher_cache; /* for encoding with this session key */
 } session_key_material;
 
 typedef struct remote_session_info
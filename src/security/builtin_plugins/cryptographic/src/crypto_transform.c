@@ -292,11 +292,9 @@ static tainted_input_buffer_t tainted_input_buffer_from_OctetSeq (const DDS_Secu
   };
 }
 
-static bool initialize_remote_session_info (remote_session_info *info, const struct const_tainted_secure_prefix *prefix, const unsigned char *master_salt, const unsigned char *master_key, DDS_Security_CryptoTransformKind_Enum transformation_kind, DDS_Security_SecurityException *ex)
+static bool initialize_remote_session_info (remote_session_info *info, const struct const_tainted_secure_prefix *prefix, master_key_material *keymat, DDS_Security_SecurityException *ex)
 {
-  info->key_size = crypto_get_key_size (transformation_kind);
-  info->id = prefix->session_id;
-  return crypto_calculate_session_key (&info->key, info->id, master_salt, master_key, transformation_kind, ex);
+  return crypto_cipher_remote_session_key (&keymat->cipher_cache, prefix->session_id, keymat, info, ex);
 }
 
 static bool read_submsg_header (tainted_input_buffer_t *input, uint8_t smid, SubmessageHeader_t *hdr, bool *bswap, tainted_input_buffer_t *submsg_view)
@@ -677,14 +675,14 @@ encode_serialized_payload(
     encrypted_data.x.base = content->data;
     encrypted_data.x.length = plain_buffer->_length;
 
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, &prefix->iv, 1, &plain_data, &encrypted_data, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->cipher_cache, &session->key, session->key_size, &prefix->iv, 1, &plain_data, &encrypted_data, &hmac, ex))
       goto fail_encrypt;
     content->length = ddsrt_toBE4u((uint32_t)encrypted_data.x.length);
   }
   else if (is_authentication_required(transform_kind))
   {
     /* the transformation_kind indicates only indicates authentication the determine HMAC */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, &prefix->iv, 1, &plain_data, NULL, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->cipher_cache, &session->key, session->key_size, &prefix->iv, 1, &plain_data, NULL, &hmac, ex))
       goto fail_encrypt;
     unsigned char *ptr = trusted_crypto_buffer_append(&buffer,  plain_buffer->_length);
     memcpy(ptr, plain_buffer->_buffer, plain_buffer->_length);
@@ -743,33 +741,56 @@ static bool add_specific_mac_find_offsets (trusted_crypto_buffer_t *buffer, bool
 }
 
 static bool
-add_specific_mac(
-    trusted_crypto_buffer_t *buffer,
+calc_specific_mac(
+    const trusted_crypto_buffer_t *buffer,
+    size_t header_offset,
+    size_t footer_offset,
     master_key_material *keymat,
     session_key_material *session,
-    bool is_rtps,
+    struct receiver_specific_mac *rcvmac,
     DDS_Security_SecurityException *ex)
 {
-  size_t header_offset, footer_offset;
-  if (!add_specific_mac_find_offsets (buffer, is_rtps, &header_offset, &footer_offset))
+  struct trusted_crypto_header const * const h = (struct trusted_crypto_header const *) (buffer->contents + header_offset);
+  struct trusted_crypto_footer const * const f = (struct trusted_crypto_footer const *) (buffer->contents + footer_offset);
+  remote_session_info key;
+  const trusted_crypto_data_t data = { {
+    .base = (unsigned char *) f->postfix.common_mac.data,
+    .length = CRYPTO_HMAC_SIZE
+  } };
+  // the receiver-specific key only changes with the session, deriving it and setting up
+  // the cipher context for it is much more expensive than computing the MAC itself
+  if (!crypto_cipher_receiver_specific_key (&keymat->receiver_specific_cipher_cache, session->id, keymat, &key, ex) ||
+      !crypto_cipher_encrypt_data (&keymat->receiver_specific_cipher_cache, &key.key, session->key_size, &h->prefix.iv, 1, &data, NULL, &rcvmac->receiver_mac, ex))
     return false;
+  const uint32_t key_id = ddsrt_toBE4u (keymat->receiver_specific_key_id);
+  memcpy (rcvmac->receiver_mac_key_id, &key_id, sizeof(key_id));
+  return true;
+}
 
-  crypto_hmac_t hmac;
+static bool
+append_specific_macs(
+    trusted_crypto_buffer_t *buffer,
+    size_t footer_offset,
+    uint32_t nmacs,
+    const struct receiver_specific_mac *macs,
+    DDS_Security_SecurityException *ex)
+{
+  if (nmacs == 0)
+    return true;
+
+  const size_t size = nmacs * sizeof (struct receiver_specific_mac);
   {
-    struct trusted_crypto_header const * const h = (struct trusted_crypto_header const *) (buffer->contents + header_offset);
     struct trusted_crypto_footer const * const f = (struct trusted_crypto_footer const *) (buffer->contents + footer_offset);
-    crypto_session_key_t key;
-    const trusted_crypto_data_t data = { {
-      .base = (unsigned char *) f->postfix.common_mac.data,
-      .length = CRYPTO_HMAC_SIZE
-    } };
-    if (!crypto_calculate_receiver_specific_key (&key, session->id, keymat->master_salt, keymat->master_receiver_specific_key, keymat->transformation_kind, ex) ||
-        !crypto_cipher_encrypt_data (&key, session->key_size, &h->prefix.iv, 1, &data, NULL, &hmac, ex))
+    if (size > (size_t) (UINT16_MAX - f->header.octetsToNextHeader))
+    {
+      DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_CIPHER_ERROR, 0,
+          "adding receiver specific macs failed: too many receivers");
       return false;
+    }
   }
 
   // appending may force reallocation
-  trusted_crypto_buffer_append (buffer, sizeof (struct receiver_specific_mac));
+  trusted_crypto_buffer_append (buffer, size);
   struct trusted_crypto_footer * const footer = (struct trusted_crypto_footer *) (buffer->contents + footer_offset);
   const uint32_t length = ddsrt_fromBE4u (footer->postfix.receiver_specific_macs._length);
 
@@ -779,98 +800,136 @@ add_specific_mac(
   if (length > (footer->header.octetsToNextHeader - receiver_specific_macs_offset) / sizeof (struct receiver_specific_mac))
     return false; // no worries that we already reallocated: this can't happen and it'll be freed if it does happen anyway
 
-  // there must now be room to append another MAC
-  assert (buffer->length - footer_offset >= sizeof (SubmessageHeader_t) + footer->header.octetsToNextHeader + sizeof (struct receiver_specific_mac));
-  DDSRT_STATIC_ASSERT (sizeof (struct receiver_specific_mac) <= UINT16_MAX);
+  // there must now be room to append the MACs
+  assert (buffer->length - footer_offset >= sizeof (SubmessageHeader_t) + footer->header.octetsToNextHeader + size);
   // octetsToNextHeader += (uint16_t) sizeof ... triggers a conversion warning for int to uint16_t from gcc
-  footer->header.octetsToNextHeader = (uint16_t) (footer->header.octetsToNextHeader + sizeof (struct receiver_specific_mac));
-  footer->postfix.receiver_specific_macs._length = ddsrt_toBE4u (length + 1);
-  struct receiver_specific_mac * const rcvmac = &footer->postfix.receiver_specific_macs._buffer[length];
-  rcvmac->receiver_mac = hmac;
-  const uint32_t key_id = ddsrt_toBE4u (keymat->receiver_specific_key_id);
-  memcpy (rcvmac->receiver_mac_key_id, &key_id, sizeof(key_id));
+  footer->header.octetsToNextHeader = (uint16_t) (footer->header.octetsToNextHeader + size);
+  footer->postfix.receiver_specific_macs._length = ddsrt_toBE4u (length + nmacs);
+  memcpy (&footer->postfix.receiver_specific_macs._buffer[length], macs, size);
   return true;
 }
 
+/* Number of receiver-specific MACs computed in one pass without allocating memory */
+#define SPECIFIC_MACS_ON_STACK 32
+
+typedef bool (*get_sign_key_material_fn_t) (const dds_security_crypto_key_factory *factory, const DDS_Security_CryptoHandle handle, master_key_material **key_material, session_key_material **session_key, DDS_Security_ProtectionKind *protection_kind, DDS_Security_SecurityException *ex);
+
+/* Adds the endpoint-specific MACs for all remote endpoints in crypto_list from
+ * first onwards in one pass over the list: the crypto header and footer are
+ * located once, each MAC is computed using the cached key and cipher context
+ * of the remote endpoint and the footer is extended only once at the end. */
 static bool
-add_reader_specific_mac(
+add_endpoint_specific_macs(
     dds_security_crypto_key_factory *factory,
     trusted_crypto_buffer_t *buffer,
-    DDS_Security_DatareaderCryptoHandle reader_crypto,
+    const DDS_Security_CryptoHandleSeq *crypto_list,
+    uint32_t first,
+    get_sign_key_material_fn_t get_sign_key_material,
     DDS_Security_SecurityException *ex)
 {
-  master_key_material *keymat = NULL;
-  session_key_material *session = NULL;
-  DDS_Security_ProtectionKind protection_kind;
-
-  if (!crypto_factory_get_remote_reader_sign_key_material(factory, reader_crypto, &keymat, &session, &protection_kind, ex))
-      return false;
+  struct receiver_specific_mac macs_on_stack[SPECIFIC_MACS_ON_STACK], *macs;
+  size_t header_offset, footer_offset;
+  uint32_t nmacs = 0;
+  bool result = true;
 
-  bool result;
-  if (!has_origin_authentication(protection_kind))
-    result = true;
-  else
-    result = add_specific_mac(buffer, keymat, session, false, ex);
-  CRYPTO_OBJECT_RELEASE(session);
-  CRYPTO_OBJECT_RELEASE(keymat);
+  assert (first <= crypto_list->_length);
+  if (!add_specific_mac_find_offsets (buffer, false, &header_offset, &footer_offset))
+    return false;
+  const uint32_t n = crypto_list->_length - first;
+  macs = (n <= SPECIFIC_MACS_ON_STACK) ? macs_on_stack : ddsrt_malloc (n * sizeof (*macs));
+  for (uint32_t i = first; result && i < crypto_list->_length; i++)
+  {
+    master_key_material *keymat = NULL;
+    session_key_material *session = NULL;
+    DDS_Security_ProtectionKind protection_kind;
+    if (!get_sign_key_material (factory, crypto_list->_buffer[i], &keymat, &session, &protection_kind, ex))
+      result = false;
+    else
+    {
+      if (has_origin_authentication (protection_kind))
+        result = calc_specific_mac (buffer, header_offset, footer_offset, keymat, session, &macs[nmacs++], ex);
+      CRYPTO_OBJECT_RELEASE(session);
+      CRYPTO_OBJECT_RELEASE(keymat);
+    }
+  }
+  if (result)
+    result = append_specific_macs (buffer, footer_offset, nmacs, macs, ex);
+  if (macs != macs_on_stack)
+    ddsrt_free (macs);
   return result;
 }
 
 static bool
-add_writer_specific_mac(
+add_reader_specific_macs(
     dds_security_crypto_key_factory *factory,
     trusted_crypto_buffer_t *buffer,
-    DDS_Security_DatawriterCryptoHandle writer_crypto,
+    const DDS_Security_DatareaderCryptoHandleSeq *reader_crypto_list,
+    int32_t *index,
     DDS_Security_SecurityException *ex)
 {
-  master_key_material *keymat = NULL;
-  session_key_material *session = NULL;
-  DDS_Security_ProtectionKind protection_kind;
-
-  if (!crypto_factory_get_remote_writer_sign_key_material(factory, writer_crypto, &keymat, &session, &protection_kind, ex))
+  assert (*index >= 0);
+  if (!add_endpoint_specific_macs (factory, buffer, reader_crypto_list, (uint32_t) *index, crypto_factory_get_remote_reader_sign_key_material, ex))
     return false;
+  *index = (int32_t) reader_crypto_list->_length;
+  return true;
+}
 
-  bool result;
-  if (!has_origin_authentication(protection_kind))
-    result = true;
-  else
-    result = add_specific_mac(buffer, keymat, session, false, ex);
-  CRYPTO_OBJECT_RELEASE(session);
-  CRYPTO_OBJECT_RELEASE(keymat);
-  return result;
+static bool
+add_writer_specific_macs(
+    dds_security_crypto_key_factory *factory,
+    trusted_crypto_buffer_t *buffer,
+    const DDS_Security_DatawriterCryptoHandleSeq *writer_crypto_list,
+    DDS_Security_SecurityException *ex)
+{
+  return add_endpoint_specific_macs (factory, buffer, writer_crypto_list, 0, crypto_factory_get_remote_writer_sign_key_material, ex);
 }
 
 static bool
-add_receiver_specific_mac(
+add_receiver_specific_macs(
     dds_security_crypto_key_factory *factory,
     trusted_crypto_buffer_t *buffer,
-    DDS_Security_DatareaderCryptoHandle sending_participant_crypto,
-    DDS_Security_DatareaderCryptoHandle receiving_participant_crypto,
+    DDS_Security_ParticipantCryptoHandle sending_participant_crypto,
+    const DDS_Security_ParticipantCryptoHandleSeq *receiving_participant_crypto_list,
+    int32_t *index,
     DDS_Security_SecurityException *ex)
 {
+  struct receiver_specific_mac macs_on_stack[SPECIFIC_MACS_ON_STACK], *macs;
   session_key_material *session = NULL;
   DDS_Security_ProtectionKind local_protection_kind;
-  DDS_Security_ProtectionKind remote_protection_kind;
-  participant_key_material *keymat;
+  size_t header_offset, footer_offset;
+  uint32_t nmacs = 0;
+  bool result = true;
+
+  assert (*index >= 0 && (uint32_t) *index <= receiving_participant_crypto_list->_length);
+  if (!add_specific_mac_find_offsets (buffer, true, &header_offset, &footer_offset))
+    return false;
 
   /* get local crypto and session*/
   if (!crypto_factory_get_local_participant_data_key_material(factory, sending_participant_crypto, &session, &local_protection_kind, ex))
     return false;
 
-  /* get remote crypto tokens */
-  if (!crypto_factory_get_participant_crypto_tokens(factory, sending_participant_crypto, receiving_participant_crypto, &keymat, NULL, &remote_protection_kind, ex))
+  const uint32_t n = receiving_participant_crypto_list->_length - (uint32_t) *index;
+  macs = (n <= SPECIFIC_MACS_ON_STACK) ? macs_on_stack : ddsrt_malloc (n * sizeof (*macs));
+  for (uint32_t i = (uint32_t) *index; result && i < receiving_participant_crypto_list->_length; i++)
   {
-    CRYPTO_OBJECT_RELEASE(session);
-    return false;
-  }
+    DDS_Security_ProtectionKind remote_protection_kind;
+    participant_key_material *keymat;
 
-  bool result;
-  if (!has_origin_authentication(remote_protection_kind))
-    result = true;
-  else
-    result = add_specific_mac(buffer, keymat->local_P2P_key_material, session, true, ex);
-  CRYPTO_OBJECT_RELEASE(keymat);
+    /* get remote crypto tokens */
+    if (!crypto_factory_get_participant_crypto_tokens(factory, sending_participant_crypto, receiving_participant_crypto_list->_buffer[i], &keymat, NULL, &remote_protection_kind, ex))
+      result = false;
+    else
+    {
+      if (has_origin_authentication(remote_protection_kind))
+        result = calc_specific_mac (buffer, header_offset, footer_offset, keymat->local_P2P_key_material, session, &macs[nmacs++], ex);
+      CRYPTO_OBJECT_RELEASE(keymat);
+    }
+  }
   CRYPTO_OBJECT_RELEASE(session);
+  if (result && (result = append_specific_macs (buffer, footer_offset, nmacs, macs, ex)))
+    *index = (int32_t) receiving_participant_crypto_list->_length;
+  if (macs != macs_on_stack)
+    ddsrt_free (macs);
   return result;
 }
 
@@ -948,7 +1007,7 @@ encode_submmessage_encrypt(
     trusted_crypto_data_t encrypted_data = {{ .base = body->content.data, .length = plain_submsg->_length }};
 
     /* encrypt submessage */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, &header->prefix.iv, 1, &plain_data, &encrypted_data, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->cipher_cache, &session->key, session->key_size, &header->prefix.iv, 1, &plain_data, &encrypted_data, &hmac, ex))
       goto enc_submsg_fail;
 
     /* adjust the length of the body submessage when needed */
@@ -964,7 +1023,7 @@ encode_submmessage_encrypt(
   {
     unsigned char *ptr = trusted_crypto_buffer_append(&buffer, plain_submsg->_length);
     /* the transformation_kind indicates only indicates authentication the determine HMAC */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, &header->prefix.iv, 1, &plain_data, NULL, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->cipher_cache, &session->key, session->key_size, &header->prefix.iv, 1, &plain_data, NULL, &hmac, ex))
       goto enc_submsg_fail;
 
     /* copy submessage */
@@ -986,22 +1045,13 @@ encode_submmessage_encrypt(
   {
     if (!has_origin_authentication(protection_kind))
       *index = (int32_t) crypto_list->_length;
-    else
-    {
-      DDS_Security_CryptoHandle remote_crypto = crypto_list->_buffer[0];
-
-      if (!add_reader_specific_mac(factory, &buffer, remote_crypto, ex))
-        goto enc_submsg_fail;
-      (*index)++;
-    }
+    else if (!add_reader_specific_macs(factory, &buffer, crypto_list, index, ex))
+      goto enc_submsg_fail;
   }
   else
   {
-    for (uint32_t i = 0; i < crypto_list->_length; i++)
-    {
-      if (!add_writer_specific_mac(factory, &buffer, crypto_list->_buffer[i], ex))
-        goto enc_submsg_fail;
-    }
+    if (!add_writer_specific_macs(factory, &buffer, crypto_list, ex))
+      goto enc_submsg_fail;
   }
 
   trusted_crypto_buffer_to_seq(&buffer, encoded_submsg);
@@ -1069,16 +1119,13 @@ encode_datawriter_submessage(
   }
   else
   {
-    /* When the index is not 0 then add a signature for the specific reader */
     trusted_crypto_buffer_t buffer;
-    DDS_Security_DatareaderCryptoHandle reader_crypto = reader_crypto_list->_buffer[*index];
 
     trusted_crypto_buffer_from_seq(&buffer, encoded_submsg);
-    /* When the receiving_participant_crypto_list_index is not 0 then add a signature for the specific reader */
-    if (!add_reader_specific_mac(factory, &buffer, reader_crypto, ex))
+    /* When the receiving_participant_crypto_list_index is not 0 then add the signatures for the remaining readers */
+    if (!add_reader_specific_macs(factory, &buffer, reader_crypto_list, index, ex))
       return false;
     trusted_crypto_buffer_to_seq(&buffer, encoded_submsg);
-    (*index)++;
     return true;
   }
 }
@@ -1125,7 +1172,7 @@ check_reader_specific_mac(
   master_key_material *keymat = NULL;
   tainted_crypto_data_t data = { .base = postfix->common_mac.data, .length = CRYPTO_HMAC_SIZE };
   uint32_t index;
-  crypto_session_key_t key;
+  remote_session_info key;
   const crypto_hmac_t *href = NULL;
   crypto_hmac_t hmac;
 
@@ -1152,14 +1199,14 @@ check_reader_specific_mac(
     goto check_failed;
   }
 
-  if (!crypto_calculate_receiver_specific_key(&key, prefix->session_id, keymat->master_salt, keymat->master_receiver_specific_key, keymat->transformation_kind, ex))
+  if (!crypto_cipher_receiver_specific_key(&keymat->receiver_specific_cipher_cache, prefix->session_id, keymat, &key, ex))
   {
     DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_INVALID_CRYPTO_RECEIVER_SIGN_CODE, 0,
         "%s: failed to calculate receiver specific session key", context);
     goto check_failed;
   }
 
-  if (!crypto_cipher_calc_hmac(&key, crypto_get_key_size(keymat->transformation_kind), &prefix->iv, &data, &hmac, ex))
+  if (!crypto_cipher_calc_hmac(&keymat->receiver_specific_cipher_cache, &key.key, key.key_size, &prefix->iv, &data, &hmac, ex))
   {
     DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_INVALID_CRYPTO_RECEIVER_SIGN_CODE, 0,
         "%s: failed to calculate receiver specific hmac", context);
@@ -1198,7 +1245,6 @@ static DDS_Security_boolean encode_rtps_message_encrypt (
     const DDS_Security_ParticipantCryptoHandle sending_participant_crypto,
     const DDS_Security_ParticipantCryptoHandleSeq *receiving_participant_crypto_list,
     int32_t *receiving_participant_crypto_list_index,
-    DDS_Security_ParticipantCryptoHandle remote_id,
     DDS_Security_SecurityException *ex)
 {
   session_key_material *session = NULL;
@@ -1292,7 +1338,7 @@ static DDS_Security_boolean encode_rtps_message_encrypt (
     encrypted_data.x.length = secure_body_plain_size;
 
     /* encrypt message */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, &header->prefix.iv, num_segs, plain_data, &encrypted_data, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->cipher_cache, &session->key, session->key_size, &header->prefix.iv, num_segs, plain_data, &encrypted_data, &hmac, ex))
       goto enc_rtps_fail_data;
 
     body->content.length = ddsrt_toBE4u((uint32_t)encrypted_data.x.length);
@@ -1307,7 +1353,7 @@ static DDS_Security_boolean encode_rtps_message_encrypt (
   {
     unsigned char *ptr = trusted_crypto_buffer_append(&buffer, secure_body_plain_size);
     /* the transformation_kind indicates only indicates authentication the determine HMAC */
-    if (!crypto_cipher_encrypt_data(&session->key, session->key_size, &header->prefix.iv, num_segs, plain_data, NULL, &hmac, ex))
+    if (!crypto_cipher_encrypt_data(&session->cipher_cache, &session->key, session->key_size, &header->prefix.iv, num_segs, plain_data, NULL, &hmac, ex))
       goto enc_rtps_fail_data;
 
     /* copy submessage */
@@ -1329,9 +1375,8 @@ static DDS_Security_boolean encode_rtps_message_encrypt (
   {
     if (receiving_participant_crypto_list->_length != 0)
     {
-      if (!add_receiver_specific_mac(factory, &buffer, sending_participant_crypto, remote_id, ex))
+      if (!add_receiver_specific_macs(factory, &buffer, sending_participant_crypto, receiving_participant_crypto_list, receiving_participant_crypto_list_index, ex))
         goto enc_rtps_fail_data;
-      (*receiving_participant_crypto_list_index)++;
     }
   }
   else
@@ -1364,32 +1409,24 @@ encode_rtps_message(dds_security_crypto_transform *instance,
 {
   dds_security_crypto_transform_impl *impl = (dds_security_crypto_transform_impl *)instance;
   dds_security_crypto_key_factory *factory = cryptography_get_crypto_key_factory(impl->crypto);
-  DDS_Security_ParticipantCryptoHandle remote_id = 0;
   DDS_Security_boolean result = false;
 
   assert(encoded_message);
   assert((plain_message && plain_message->_length > 0 && plain_message->_buffer) || *index > 0);
   assert(encoded_message->_length > 0 || *index == 0);
 
-  /* get remote participant handle */
-  if (local_crypto_list->_length > 0)
-    remote_id = local_crypto_list->_buffer[*index];
-
   /* When the receiving_participant_crypto_list_index is 0 then retrieve the key material of the writer */
   if (*index == 0)
-    result = encode_rtps_message_encrypt (factory, encoded_message, plain_message, remote_crypto, local_crypto_list, index, remote_id, ex);
+    result = encode_rtps_message_encrypt (factory, encoded_message, plain_message, remote_crypto, local_crypto_list, index, ex);
   else
   {
     trusted_crypto_buffer_t buffer;
 
     trusted_crypto_buffer_from_seq(&buffer, encoded_message);
-    /* When the receiving_participant_crypto_list_index is not 0 then add a signature for the specific reader */
-    result = add_receiver_specific_mac(factory, &buffer, remote_crypto, remote_id, ex);
+    /* When the receiving_participant_crypto_list_index is not 0 then add the signatures for the remaining receivers */
+    result = add_receiver_specific_macs(factory, &buffer, remote_crypto, local_crypto_list, index, ex);
     if (result)
-    {
-       (*index)++;
        trusted_crypto_buffer_to_seq(&buffer, encoded_message);
-    }
   }
 
   return result;
@@ -1449,7 +1486,7 @@ decode_rtps_message(dds_security_crypto_transform *instance,
   }
 
   /* calculate the session key */
-  if (!initialize_remote_session_info(&remote_session, &estate.prefix, remote_key_material->master_salt, remote_key_material->master_sender_key, remote_key_material->transformation_kind, ex))
+  if (!initialize_remote_session_info(&remote_session, &estate.prefix, remote_key_material, ex))
   {
     DDS_Security_Exception_set(ex, DDS_CRYPTO_PLUGIN_CONTEXT, DDS_SECURITY_ERR_INVALID_CRYPTO_ARGUMENT_CODE, 0,
         "%s: " DDS_SECURITY_ERR_INVALID_CRYPTO_ARGUMENT_MESSAGE, context);
@@ -1481,7 +1518,7 @@ decode_rtps_message(dds_security_crypto_transform *instance,
       goto fail_decrypt;
     }
 
-    if (!crypto_cipher_decrypt_data(&remote_session, &estate.prefix.iv, 1, &estate.body.data, &decoded_body, &estate.postfix.common_mac, ex))
+    if (!crypto_cipher_decrypt_data(&remote_key_material->cipher_cache, &remote_session, &estate.prefix.iv, 1, &estate.body.data, &decoded_body, &estate.postfix.common_mac, ex))
       goto fail_decrypt;
   }
   else if (is_authentication_required(estate.prefix.transform_kind))
@@ -1493,7 +1530,7 @@ decode_rtps_message(dds_security_crypto_transform *instance,
       goto fail_decrypt;
     }
     /* When the CryptoHeader indicates that authentication is performed then calculate the HMAC */
-    if (!crypto_cipher_decrypt_data(&remote_session, &estate.prefix.iv, 1, &estate.body.data, NULL, &estate.postfix.common_mac, ex))
+    if (!crypto_cipher_decrypt_data(&remote_key_material->cipher_cache, &remote_session, &estate.prefix.iv, 1, &estate.body.data, NULL, &estate.postfix.common_mac, ex))
       goto fail_decrypt;
     memcpy(decoded_body.base, estate.body.data.base, estate.body.data.length);
   }
@@ -1617,7 +1654,7 @@ decode_submessage(
     goto fail_mac;
 
   /* calculate the session key */
-  if (!initialize_remote_session_info(&remote_session, &est.prefix, keymat->master_salt, keymat->master_sender_key, keymat->transformation_kind, ex))
+  if (!initialize_remote_session_info(&remote_session, &est.prefix, keymat, ex))
     goto fail_mac;
 
   plain_data.base = ddsrt_malloc(est.body.data.length);
@@ -1641,7 +1678,7 @@ decode_submessage(
       goto fail_decrypt;
     }
 
-    if (!crypto_cipher_decrypt_data(&remote_session, &est.prefix.iv, 1, &est.body.data, &plain_data, &est.postfix.common_mac, ex))
+    if (!crypto_cipher_decrypt_data(&keymat->cipher_cache, &remote_session, &est.prefix.iv, 1, &est.body.data, &plain_data, &est.postfix.common_mac, ex))
       goto fail_decrypt;
   }
   else if (is_authentication_required(est.prefix.transform_kind))
@@ -1654,7 +1691,7 @@ decode_submessage(
     }
     assert(est.prefix.transform_id != 0);
     /* When the CryptoHeader indicates that authentication is performed then calculate the HMAC */
-    if (!crypto_cipher_decrypt_data(&remote_session, &est.prefix.iv, 1, &est.body.data, NULL, &est.postfix.common_mac, ex))
+    if (!crypto_cipher_decrypt_data(&keymat->cipher_cache, &remote_session, &est.prefix.iv, 1, &est.body.data, NULL, &est.postfix.common_mac, ex))
       goto fail_decrypt;
 
     memcpy(plain_data.base, est.body.data.base, est.body.data.length);
@@ -1761,7 +1798,7 @@ decode_serialized_payload(
   plain_data.length = estate.body.data.length;
 
   /* calculate the session key */
-  if (!initialize_remote_session_info(&remote_session, &estate.prefix, writer_master_key->master_salt, writer_master_key->master_sender_key, writer_master_key->transformation_kind, ex))
+  if (!initialize_remote_session_info(&remote_session, &estate.prefix, writer_master_key, ex))
     goto fail_decrypt;
 
   /*
@@ -1779,7 +1816,7 @@ decode_serialized_payload(
       goto fail_decrypt;
     }
 
-    if (!crypto_cipher_decrypt_data(&remote_session, &estate.prefix.iv, 1, &estate.body.data, &plain_data, &estate.postfix.common_mac, ex))
+    if (!crypto_cipher_decrypt_data(&writer_master_key->cipher_cache, &remote_session, &estate.prefix.iv, 1, &estate.body.data, &plain_data, &estate.postfix.common_mac, ex))
       goto fail_decrypt;
   }
   else if (is_authentication_required(estate.prefix.transform_kind))
@@ -1792,7 +1829,7 @@ decode_serialized_payload(
       goto fail_decrypt;
     }
     /* When the CryptoHeader indicates that authentication is performed then calculate the HMAC */
-    if (!crypto_cipher_decrypt_data(&remote_session, &estate.prefix.iv, 1, &estate.body.data, NULL, &estate.postfix.common_mac, ex))
+    if (!crypto_cipher_decrypt_data(&writer_master_key->cipher_cache, &remote_session, &estate.prefix.iv, 1, &estate.body.data, NULL, &estate.postfix.common_mac, ex))
       goto fail_decrypt;
     memcpy(plain_data.base, estate.body.data.base,  estate.body.data.length);
   }
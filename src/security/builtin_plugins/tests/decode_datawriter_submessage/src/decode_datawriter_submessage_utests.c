@@ -791,6 +791,176 @@ CU_Test(ddssec_builtin_decode_datawriter_submessage, only_signed_128, .init = su
   decode_datawriter_submessage_signed(CRYPTO_TRANSFORMATION_KIND_AES128_GMAC);
 }
 
+static bool decode_for_reader(DDS_Security_OctetSeq *encoded_buffer, const DDS_Security_OctetSeq *plain_buffer, DDS_Security_DatareaderCryptoHandle local_reader_crypto, DDS_Security_DatawriterCryptoHandle remote_writer_crypto)
+{
+  DDS_Security_SecurityException exception = {NULL, 0, 0};
+  DDS_Security_OctetSeq decoded_buffer = {0, 0, NULL};
+  bool result;
+
+  result = crypto->crypto_transform->decode_datawriter_submessage(
+      crypto->crypto_transform,
+      &decoded_buffer,
+      encoded_buffer,
+      local_reader_crypto,
+      remote_writer_crypto,
+      &exception);
+  if (result)
+  {
+    CU_ASSERT(decoded_buffer._length == plain_buffer->_length);
+    CU_ASSERT(decoded_buffer._length == plain_buffer->_length && memcmp(decoded_buffer._buffer, plain_buffer->_buffer, plain_buffer->_length) == 0);
+  }
+  reset_exception(&exception);
+  DDS_Security_OctetSeq_deinit(&decoded_buffer);
+  return result;
+}
+
+/* The receiver-specific keys and their cipher contexts are cached per key material on both
+   sides. Encodes a number of samples for more readers than fit in the plugin's on-stack MAC
+   array, with a new session key halfway, and checks that every MAC is valid. */
+static void decode_datawriter_submessage_receiver_specific_macs(DDS_Security_CryptoTransformKind_Enum transformation_kind)
+{
+  const uint32_t LIST_SIZE = 40u;
+  const uint32_t ROUNDS = 4u;
+  DDS_Security_boolean result;
+  DDS_Security_SecurityException exception = {NULL, 0, 0};
+  DDS_Security_DatawriterCryptoHandle local_writer_crypto;
+  DDS_Security_DatareaderCryptoHandleSeq local_reader_list;
+  DDS_Security_DatawriterCryptoHandleSeq remote_writer_list;
+  DDS_Security_DatareaderCryptoHandleSeq remote_reader_list;
+  DDS_Security_OctetSeq plain_buffer = {0, 0, NULL};
+  DDS_Security_EndpointSecurityAttributes datawriter_security_attributes;
+  DDS_Security_PropertySeq datawriter_properties;
+  DDS_Security_EndpointSecurityAttributes datareader_security_attributes;
+  DDS_Security_PropertySeq datareader_properties;
+  session_key_material *session_keys;
+  uint32_t session_id, i, r;
+
+  CU_ASSERT_FATAL(crypto != NULL);
+  assert(crypto != NULL);
+
+  prepare_endpoint_security_attributes_and_properties(&datareader_security_attributes, &datareader_properties, transformation_kind, true);
+  prepare_endpoint_security_attributes_and_properties(&datawriter_security_attributes, &datawriter_properties, transformation_kind, true);
+
+  initialize_data_submessage(&plain_buffer, DDSRT_BOSEL_NATIVE);
+
+  local_writer_crypto = register_local_datawriter(&datawriter_security_attributes, &datawriter_properties);
+  CU_ASSERT_FATAL(local_writer_crypto != 0);
+  session_keys = ((local_datawriter_crypto *)local_writer_crypto)->writer_session_message;
+
+  local_reader_list._length = local_reader_list._maximum = LIST_SIZE;
+  local_reader_list._buffer = DDS_Security_DatareaderCryptoHandleSeq_allocbuf(LIST_SIZE);
+  remote_writer_list._length = remote_writer_list._maximum = LIST_SIZE;
+  remote_writer_list._buffer = DDS_Security_DatawriterCryptoHandleSeq_allocbuf(LIST_SIZE);
+  remote_reader_list._length = remote_reader_list._maximum = LIST_SIZE;
+  remote_reader_list._buffer = DDS_Security_DatareaderCryptoHandleSeq_allocbuf(LIST_SIZE);
+
+  for (i = 0; i < LIST_SIZE; i++)
+  {
+    local_reader_list._buffer[i] = register_local_datareader(&datareader_security_attributes, &datareader_properties);
+    CU_ASSERT_FATAL(local_reader_list._buffer[i] != 0);
+    remote_reader_list._buffer[i] = register_remote_datareader(local_writer_crypto);
+    CU_ASSERT_FATAL(remote_reader_list._buffer[i] != 0);
+    remote_writer_list._buffer[i] = register_remote_datawriter(local_reader_list._buffer[i]);
+    CU_ASSERT_FATAL(remote_writer_list._buffer[i] != 0);
+    result = set_remote_datawriter_tokens(local_writer_crypto, remote_reader_list._buffer[i], local_reader_list._buffer[i], remote_writer_list._buffer[i]);
+    CU_ASSERT_FATAL(result);
+  }
+
+  session_id = session_keys->id;
+  for (r = 0; r < ROUNDS; r++)
+  {
+    DDS_Security_OctetSeq encoded_buffer = {0, 0, NULL};
+    DDS_Security_OctetSeq *buffer = &plain_buffer;
+    struct crypto_footer *footer;
+    struct receiver_specific_mac *rmac;
+    int32_t index = 0;
+
+    if (r == ROUNDS / 2)
+      session_keys->block_counter = session_keys->max_blocks_per_session;
+
+    while ((uint32_t)index != LIST_SIZE)
+    {
+      result = crypto->crypto_transform->encode_datawriter_submessage(
+          crypto->crypto_transform,
+          &encoded_buffer,
+          buffer,
+          local_writer_crypto,
+          &remote_reader_list,
+          &index,
+          &exception);
+      if (!result)
+      {
+        printf("encode_datawriter_submessage: %s\n", exception.message ? exception.message : "Error message missing");
+      }
+      CU_ASSERT_FATAL(result);
+      reset_exception(&exception);
+      buffer = NULL;
+    }
+
+    footer = get_crypto_footer(encoded_buffer._buffer);
+    CU_ASSERT_FATAL(ddsrt_fromBE4u(*(uint32_t *)footer->length) == LIST_SIZE);
+
+    for (i = 0; i < LIST_SIZE; i++)
+      CU_ASSERT(decode_for_reader(&encoded_buffer, &plain_buffer, local_reader_list._buffer[i], remote_writer_list._buffer[i]));
+
+    /* all readers are in the same remote participant, so the receiving side accepts the
+       first MAC with a known key: check each one separately by leaving only that one in the
+       footer, and check that a modified MAC is rejected */
+    rmac = (struct receiver_specific_mac *)(footer + 1);
+    for (i = 0; i < LIST_SIZE; i++)
+    {
+      DDS_Security_OctetSeq copy = {0, 0, NULL};
+      struct crypto_footer *copy_footer;
+      struct receiver_specific_mac *copy_rmac;
+      uint32_t j;
+
+      for (j = 0; j < i; j++)
+        CU_ASSERT(memcmp(rmac[j].receiver_mac_key_id, rmac[i].receiver_mac_key_id, sizeof(rmac[i].receiver_mac_key_id)) != 0);
+
+      DDS_Security_OctetSeq_copy(&copy, &encoded_buffer);
+      copy_footer = get_crypto_footer(copy._buffer);
+      copy_rmac = (struct receiver_specific_mac *)(copy_footer + 1);
+      *(uint32_t *)copy_footer->length = ddsrt_toBE4u(1);
+      copy_rmac[0] = rmac[i];
+      CU_ASSERT(decode_for_reader(&copy, &plain_buffer, local_reader_list._buffer[i], remote_writer_list._buffer[i]));
+      copy_rmac[0].receiver_mac.data[0] = (unsigned char)(copy_rmac[0].receiver_mac.data[0] + 1);
+      CU_ASSERT(!decode_for_reader(&copy, &plain_buffer, local_reader_list._buffer[i], remote_writer_list._buffer[i]));
+      DDS_Security_OctetSeq_deinit(&copy);
+    }
+
+    DDS_Security_OctetSeq_deinit(&encoded_buffer);
+  }
+  CU_ASSERT(session_keys->id != session_id);
+
+  for (i = 0; i < LIST_SIZE; i++)
+  {
+    unregister_datareader(remote_reader_list._buffer[i]);
+    unregister_datawriter(remote_writer_list._buffer[i]);
+    unregister_datareader(local_reader_list._buffer[i]);
+    local_reader_list._buffer[i] = 0;
+    remote_reader_list._buffer[i] = 0;
+    remote_writer_list._buffer[i] = 0;
+  }
+  unregister_datawriter(local_writer_crypto);
+
+  DDS_Security_DatareaderCryptoHandleSeq_deinit(&local_reader_list);
+  DDS_Security_DatareaderCryptoHandleSeq_deinit(&remote_reader_list);
+  DDS_Security_DatawriterCryptoHandleSeq_deinit(&remote_writer_list);
+  DDS_Security_OctetSeq_deinit(&plain_buffer);
+  DDS_Security_PropertySeq_deinit(&datareader_properties);
+  DDS_Security_PropertySeq_deinit(&datawriter_properties);
+}
+
+CU_Test(ddssec_builtin_decode_datawriter_submessage, receiver_specific_macs_256, .init = suite_decode_datawriter_submessage_init, .fini = suite_decode_datawriter_submessage_fini)
+{
+  decode_datawriter_submessage_receiver_specific_macs(CRYPTO_TRANSFORMATION_KIND_AES256_GCM);
+}
+
+CU_Test(ddssec_builtin_decode_datawriter_submessage, receiver_specific_macs_only_signed_128, .init = suite_decode_datawriter_submessage_init, .fini = suite_decode_datawriter_submessage_fini)
+{
+  decode_datawriter_submessage_receiver_specific_macs(CRYPTO_TRANSFORMATION_KIND_AES128_GMAC);
+}
+
 CU_Test(ddssec_builtin_decode_datawriter_submessage, invalid_args, .init = suite_decode_datawriter_submessage_init, .fini = suite_decode_datawriter_submessage_fini)
 {
   DDS_Security_boolean result;
@@ -555,6 +555,111 @@ CU_Test(ddssec_builtin_decode_serialized_payload, signcheck_256, .init = suite_d
   decode_serialized_payload_check(256, false);
 }
 
+/* The cipher contexts are cached per session key, so they must be replaced when
+   the session key changes (the throughput is measured by xtests/cryptobench). */
+static void decode_serialized_payload_rekey(uint32_t key_size, bool encrypted)
+{
+  const uint32_t rounds = 8;
+  DDS_Security_boolean result;
+  DDS_Security_SecurityException exception = {NULL, 0, 0};
+  DDS_Security_DatawriterCryptoHandle local_writer_crypto;
+  DDS_Security_DatareaderCryptoHandle local_reader_crypto;
+  DDS_Security_DatawriterCryptoHandle remote_writer_crypto;
+  DDS_Security_DatareaderCryptoHandle remote_reader_crypto;
+  DDS_Security_OctetSeq extra_inline_qos;
+  DDS_Security_OctetSeq plain_buffer;
+  session_key_material *session_keys;
+  uint32_t session_id;
+  size_t length;
+
+  CU_ASSERT_FATAL(crypto != NULL);
+  CU_ASSERT_FATAL(crypto->crypto_transform != NULL);
+  CU_ASSERT_FATAL(crypto->crypto_transform->encode_serialized_payload != NULL);
+  CU_ASSERT_FATAL(crypto->crypto_transform->decode_serialized_payload != NULL);
+
+  memset(&extra_inline_qos, 0, sizeof(extra_inline_qos));
+
+  length = strlen(sample_test_data) + 1;
+  plain_buffer._length = plain_buffer._maximum = (uint32_t) length;
+  plain_buffer._buffer = DDS_Security_OctetSeq_allocbuf((uint32_t)length);
+  memcpy((char *)plain_buffer._buffer, sample_test_data, length);
+
+  local_writer_crypto = register_local_datawriter(encrypted);
+  CU_ASSERT_FATAL(local_writer_crypto != 0);
+  session_keys = ((local_datawriter_crypto *)local_writer_crypto)->writer_session_payload;
+  session_keys->master_key_material->transformation_kind = get_transformation_kind(key_size, encrypted);
+  session_keys->key_size = key_size;
+
+  local_reader_crypto = register_local_datareader(encrypted);
+  CU_ASSERT_FATAL(local_reader_crypto != 0);
+  remote_reader_crypto = register_remote_datareader(local_writer_crypto);
+  CU_ASSERT_FATAL(remote_reader_crypto != 0);
+  remote_writer_crypto = register_remote_datawriter(local_reader_crypto);
+  CU_ASSERT_FATAL(remote_writer_crypto != 0);
+  result = set_remote_datawriter_tokens(local_writer_crypto, remote_reader_crypto, local_reader_crypto, remote_writer_crypto);
+  CU_ASSERT_FATAL(result);
+
+  session_id = session_keys->id;
+  for (uint32_t i = 0; i < rounds; i++)
+  {
+    DDS_Security_OctetSeq encoded_buffer = {0, 0, NULL};
+    DDS_Security_OctetSeq decoded_buffer = {0, 0, NULL};
+
+    /* Force a new session key halfway through, the cached cipher contexts
+       on both sides must follow it. */
+    if (i == rounds / 2)
+      session_keys->block_counter = session_keys->max_blocks_per_session;
+
+    result = crypto->crypto_transform->encode_serialized_payload(
+        crypto->crypto_transform,
+        &encoded_buffer,
+        &extra_inline_qos,
+        &plain_buffer,
+        local_writer_crypto,
+        &exception);
+    if (!result)
+      printf("encode_serialized_payload: %s\n", exception.message ? exception.message : "Error message missing");
+    CU_ASSERT_FATAL(result);
+
+    result = crypto->crypto_transform->decode_serialized_payload(
+        crypto->crypto_transform,
+        &decoded_buffer,
+        &encoded_buffer,
+        &extra_inline_qos,
+        local_reader_crypto,
+        remote_writer_crypto,
+        &exception);
+    if (!result)
+      printf("decode_serialized_payload: %s\n", exception.message ? exception.message : "Error message missing");
+    CU_ASSERT_FATAL(result);
+    CU_ASSERT_FATAL(decoded_buffer._length == plain_buffer._length);
+    CU_ASSERT_FATAL(memcmp(decoded_buffer._buffer, plain_buffer._buffer, plain_buffer._length) == 0);
+
+    DDS_Security_OctetSeq_deinit(&encoded_buffer);
+    DDS_Security_OctetSeq_deinit(&decoded_buffer);
+  }
+  CU_ASSERT(session_keys->id != session_id);
+
+  unregister_datareader(remote_reader_crypto);
+  unregister_datawriter(remote_writer_crypto);
+  unregister_datareader(local_reader_crypto);
+  unregister_datawriter(local_writer_crypto);
+
+  DDS_Security_OctetSeq_deinit(&plain_buffer);
+
+  reset_exception(&exception);
+}
+
+CU_Test(ddssec_builtin_decode_serialized_payload, rekey_decrypt_256, .init = suite_decode_serialized_payload_init, .fini = suite_decode_serialized_payload_fini)
+{
+  decode_serialized_payload_rekey(256, true);
+}
+
+CU_Test(ddssec_builtin_decode_serialized_payload, rekey_signcheck_128, .init = suite_decode_serialized_payload_init, .fini = suite_decode_serialized_payload_fini)
+{
+  decode_serialized_payload_rekey(128, false);
+}
+
 CU_Test(ddssec_builtin_decode_serialized_payload, invalid_args, .init = suite_decode_serialized_payload_init, .fini = suite_decode_serialized_payload_fini)
 {
   DDS_Security_boolean result;
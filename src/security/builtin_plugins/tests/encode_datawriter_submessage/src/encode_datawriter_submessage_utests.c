@@ -913,9 +913,8 @@ CU_Test(ddssec_builtin_encode_datawriter_submessage, no_encode_128, .init = suit
   encode_datawriter_submessage_not_signed(CRYPTO_TRANSFORMATION_KIND_AES128_GMAC);
 }
 
-static void encode_datawriter_submessage_sign(DDS_Security_CryptoTransformKind_Enum transformation_kind)
+static void encode_datawriter_submessage_sign(DDS_Security_CryptoTransformKind_Enum transformation_kind, const uint32_t READERS_CNT)
 {
-  const uint32_t READERS_CNT = 4u;
   DDS_Security_boolean result;
   DDS_Security_DatawriterCryptoHandle writer_crypto;
   DDS_Security_DatareaderCryptoHandle reader_crypto;
@@ -963,7 +962,7 @@ static void encode_datawriter_submessage_sign(DDS_Security_CryptoTransformKind_E
   session_keys = get_datawriter_session(writer_crypto);
 
   reader_list._length = reader_list._maximum = READERS_CNT;
-  reader_list._buffer = DDS_Security_DatareaderCryptoHandleSeq_allocbuf(4);
+  reader_list._buffer = DDS_Security_DatareaderCryptoHandleSeq_allocbuf(READERS_CNT);
   for (i = 0; i < READERS_CNT; i++)
   {
     reader_crypto = register_remote_datareader(writer_crypto);
@@ -1067,22 +1066,28 @@ static void encode_datawriter_submessage_sign(DDS_Security_CryptoTransformKind_E
 
 CU_Test(ddssec_builtin_encode_datawriter_submessage, encode_sign_256, .init = suite_encode_datawriter_submessage_init, .fini = suite_encode_datawriter_submessage_fini)
 {
-  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES256_GCM);
+  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES256_GCM, 4);
 }
 
 CU_Test(ddssec_builtin_encode_datawriter_submessage, encode_sign_128, .init = suite_encode_datawriter_submessage_init, .fini = suite_encode_datawriter_submessage_fini)
 {
-  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES128_GCM);
+  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES128_GCM, 4);
 }
 
 CU_Test(ddssec_builtin_encode_datawriter_submessage, no_encode_sign_256, .init = suite_encode_datawriter_submessage_init, .fini = suite_encode_datawriter_submessage_fini)
 {
-  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES256_GMAC);
+  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES256_GMAC, 4);
 }
 
 CU_Test(ddssec_builtin_encode_datawriter_submessage, no_encode_sign_128, .init = suite_encode_datawriter_submessage_init, .fini = suite_encode_datawriter_submessage_fini)
 {
-  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES128_GMAC);
+  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES128_GMAC, 4);
+}
+
+/* more readers than the plugin computes reader specific macs for without allocating memory */
+CU_Test(ddssec_builtin_encode_datawriter_submessage, encode_sign_many_readers_256, .init = suite_encode_datawriter_submessage_init, .fini = suite_encode_datawriter_submessage_fini)
+{
+  encode_datawriter_submessage_sign(CRYPTO_TRANSFORMATION_KIND_AES256_GCM, 100);
 }
 
 CU_Test(ddssec_builtin_encode_datawriter_submessage, invalid_args, .init = suite_encode_datawriter_submessage_init, .fini = suite_encode_datawriter_submessage_fini)
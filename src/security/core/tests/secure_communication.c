@@ -40,6 +40,9 @@
 static const char *config =
     "${CYCLONEDDS_URI}${CYCLONEDDS_URI:+,}"
     "<Domain id=\"any\">"
+    "  <General>"
+    "    <AllowMulticast>${ALLOW_MULTICAST:-default}</AllowMulticast>"
+    "  </General>"
     "  <Discovery>"
     "    <ExternalDomainId>0</ExternalDomainId>"
     "    <Tag>\\${CYCLONEDDS_PID}</Tag>"
@@ -96,6 +99,7 @@ struct domain_sec_config {
   const char * pp_userdata_secret;
   const char * groupdata_secret;
   const char * ep_userdata_secret;
+  const char * allow_multicast;
 };
 
 typedef void (*set_crypto_params_fn)(struct dds_security_cryptography_impl *, const struct domain_sec_config *);
@@ -164,6 +168,7 @@ static void test_init(const struct domain_sec_config * domain_config, size_t n_s
 
   struct kvp config_vars[] = {
     { "GOVERNANCE_DATA", gov_config_signed, 1 },
+    { "ALLOW_MULTICAST", domain_config->allow_multicast, 1 },
     { NULL, NULL, 0 }
   };
 
@@ -339,6 +344,14 @@ static void test_multiple_readers(size_t n_dom, size_t n_pp, size_t n_rd, DDS_Se
   test_write_read (&domain_config, n_dom, n_pp, n_rd, 1, 1, 1, set_encryption_parameters_basic);
 }
 
+static void test_rtps_protection_multiple_locators(size_t n_dom, DDS_Security_ProtectionKind rtps_pk)
+{
+  /* Without multicast for data, every reader domain has its own locator and
+     the writer sends the same RTPS-protected message to each of them */
+  struct domain_sec_config domain_config = { PK_N, PK_N, rtps_pk, PK_N, BPK_N, NULL, NULL, NULL, NULL, "spdp" };
+  test_write_read (&domain_config, n_dom, 1, 1, 1, 1, 1, set_encryption_parameters_basic);
+}
+
 static void test_multiple_writers(size_t n_rd_dom, size_t n_rd, size_t n_wr_dom, size_t n_wr, DDS_Security_ProtectionKind metadata_pk)
 {
   struct domain_sec_config domain_config = { PK_N, PK_N, PK_N, metadata_pk, BPK_N, NULL };
@@ -446,6 +459,17 @@ CU_Test(ddssec_secure_communication, check_encrypted_secret, .timeout = 60)
   }
 }
 
+/* Test that RTPS-protected messages sent to multiple unicast locators can be
+   decoded by all receivers, for all RTPS protection kinds */
+CU_Test(ddssec_secure_communication, rtps_protection_multiple_locators, .timeout = 60)
+{
+  DDS_Security_ProtectionKind rtps_pk[] = { PK_S, PK_E, PK_SOA, PK_EOA };
+  for (size_t rtps = 0; rtps < sizeof (rtps_pk) / sizeof (rtps_pk[0]); rtps++)
+  {
+    test_rtps_protection_multiple_locators (3, rtps_pk[rtps]);
+  }
+}
+
 /* Test communication with specific combinations payload and submsg protection
    kinds for 1-3 domains, 1-3 participants per domain and 1-3 readers per participant */
 CU_TheoryDataPoints(ddssec_secure_communication, multiple_readers) = {
@@ -48,6 +48,8 @@ void gendef_pf_boolean (FILE *fp, void *parent, struct cfgelem const * const cfg
 void gendef_pf_boolean_default (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
 void gendef_pf_besmode (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
 void gendef_pf_retransmit_merging (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
+void gendef_pf_xevent_queue_kind (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
+void gendef_pf_trace_format (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
 void gendef_pf_sched_class (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
 void gendef_pf_transport_selector (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
 void gendef_pf_many_sockets_mode (FILE *fp, void *parent, struct cfgelem const * const cfgelem);
@@ -37,6 +37,7 @@
 #include "dds/ddsrt/avl.h"
 #include "dds/ddsrt/fibheap.h"
 #include "dds/ddsrt/atomics.h"
+#include "dds/ddsrt/rusage.h"
 
 #include "cputime.h"
 #include "netload.h"
@@ -79,10 +80,14 @@ static dds_domainid_t did = DDS_DOMAIN_DEFAULT;
 static dds_entity_t rd_participants, rd_subscriptions, rd_publications;
 
 /* Topics, readers, writers (except for pong writers: there are
-   many of those) */
-static dds_entity_t tp_data, tp_ping, tp_pong, tp_stat;
+   many of those); there are ntopics data topics, readers and writers */
+static dds_entity_t tp_ping, tp_pong, tp_stat;
+static dds_entity_t *tp_data, *wr_data, *rd_data;
 static char tpname_data[32], tpname_ping[32], tpname_pong[32];
-static dds_entity_t sub, pub, wr_data, wr_ping, wr_stat, rd_data, rd_ping, rd_pong, rd_stat;
+static dds_entity_t sub, pub, wr_ping, wr_stat, rd_ping, rd_pong, rd_stat;
+
+/* Number of data topics to use, data is published round-robin over them */
+static uint32_t ntopics = 1;
 
 /* Number of different key values to use (must be 1 for OU type) */
 static unsigned nkeyvals = 1;
@@ -176,6 +181,21 @@ static uint64_t min_roundtrips = 0;
 /* Whether to gather/show latency information in "sub" mode */
 static bool sublatency = false;
 
+/* Discovery storm ("disc" mode): in each of disc_rounds rounds, every one
+   of the disc_npeers processes creates disc_npp participants with
+   disc_nrd readers and disc_nwr writers each, spread round-robin over
+   disc_ntp topics, waits for them to match and deletes them again.  Rounds
+   start every disc_period on a schedule shared by all processes. */
+static bool discmode = false;
+static uint32_t disc_npp = 1;
+static uint32_t disc_nrd = 1;
+static uint32_t disc_nwr = 1;
+static uint32_t disc_ntp = 1;
+static uint32_t disc_npeers = 1;
+static uint32_t disc_rounds = 10;
+static dds_duration_t disc_period = DDS_SECS (2);
+static bool disc_loopback = false;
+
 static ddsrt_mutex_t disc_lock;
 
 /* Publisher statistics and lock protecting it */
@@ -602,27 +622,36 @@ static uint32_t pubthread (void *varg)
   assert (topicsel != OU || nkeyvals == 1);
 
   baggage = init_sample (&data, 0);
-  ihs = malloc (nkeyvals * sizeof (dds_instance_handle_t));
+  ihs = malloc (ntopics * nkeyvals * sizeof (dds_instance_handle_t));
   assert(ihs);
   if (!register_instances)
   {
-    for (unsigned k = 0; k < nkeyvals; k++)
+    for (unsigned k = 0; k < ntopics * nkeyvals; k++)
       ihs[k] = 0;
   }
   else
   {
-    for (unsigned k = 0; k < nkeyvals; k++)
+    for (uint32_t t = 0; t < ntopics; t++)
     {
-      data.seq_keyval.keyval = (int32_t) k;
-      if ((result = dds_register_instance (wr_data, &ihs[k], &data)) != DDS_RETCODE_OK)
+      for (unsigned k = 0; k < nkeyvals; k++)
       {
-        printf ("dds_register_instance failed: %d\n", result);
-        fflush (stdout);
-        exit (2);
+        data.seq_keyval.keyval = (int32_t) k;
+        if ((result = dds_register_instance (wr_data[t], &ihs[t * nkeyvals + k], &data)) != DDS_RETCODE_OK)
+        {
+          printf ("dds_register_instance failed: %d\n", result);
+          fflush (stdout);
+          exit (2);
+        }
       }
     }
   }
 
+  /* Each data writer has its own sequence of sequence numbers and key values,
+     so that the subscriber can check for lost samples for each writer */
+  uint32_t *seqs = calloc (ntopics, sizeof (*seqs));
+  int32_t *keyvals = calloc (ntopics, sizeof (*keyvals));
+  assert (seqs && keyvals);
+  uint32_t tidx = 0;
   data.seq_keyval.keyval = 0;
   tfirst = dds_time();
   uint32_t bi = 0;
@@ -631,7 +660,9 @@ static uint32_t pubthread (void *varg)
     /* lsb of timestamp is abused to signal whether the sample is a ping requiring a response or not */
     bool reqresp = (ping_frac == 0) ? 0 : (ping_frac == UINT32_MAX) ? 1 : (ddsrt_random () <= ping_frac);
     const dds_time_t t_write = (dds_time () & ~1) | reqresp;
-    if ((result = dds_write_ts (wr_data, &data, t_write)) != DDS_RETCODE_OK)
+    data.seq = seqs[tidx];
+    data.seq_keyval.keyval = keyvals[tidx];
+    if ((result = dds_write_ts (wr_data[tidx], &data, t_write)) != DDS_RETCODE_OK)
     {
       printf ("write error: %d\n", result);
       fflush (stdout);
@@ -644,7 +675,7 @@ static uint32_t pubthread (void *varg)
     }
     if (reqresp)
     {
-      dds_write_flush (wr_data);
+      dds_write_flush (wr_data[tidx]);
     }
 
     const dds_time_t t_post_write = dds_time ();
@@ -654,8 +685,10 @@ static uint32_t pubthread (void *varg)
     ntot++;
     ddsrt_mutex_unlock (&pubstat_lock);
 
-    data.seq_keyval.keyval = (data.seq_keyval.keyval + 1) % (int32_t) nkeyvals;
-    data.seq++;
+    keyvals[tidx] = (keyvals[tidx] + 1) % (int32_t) nkeyvals;
+    seqs[tidx]++;
+    if (++tidx == ntopics)
+      tidx = 0;
 
     if (pub_rate < HUGE_VAL)
     {
@@ -665,7 +698,8 @@ static uint32_t pubthread (void *varg)
         while (((double) (ntot / burstsize) / ((double) (t - tfirst) / 1e9 + 5e-3)) > pub_rate && !ddsrt_atomic_ld32 (&termflag))
         {
           /* FIXME: flushing manually because batching is not yet implemented properly */
-          dds_write_flush (wr_data);
+          for (uint32_t t = 0; t < ntopics; t++)
+            dds_write_flush (wr_data[t]);
           dds_sleepfor (DDS_MSECS (1));
           t = dds_time ();
         }
@@ -675,6 +709,8 @@ static uint32_t pubthread (void *varg)
   }
   if (baggage)
     free (baggage);
+  free (keyvals);
+  free (seqs);
   free (ihs);
   return 0;
 }
@@ -1112,27 +1148,45 @@ static void maybe_send_new_ping (dds_time_t tnow, dds_time_t *tnextping)
   }
 }
 
-static dds_entity_t make_reader_waitset (dds_entity_t rd)
+static dds_entity_t make_readers_waitset (uint32_t nrds, const dds_entity_t *rds)
 {
   dds_entity_t ws;
   int32_t rc;
   ws = dds_create_waitset (dp);
   if ((rc = dds_waitset_attach (ws, termcond, 0)) < 0)
     error2 ("dds_waitset_attach (termcond, 0): %d\n", (int) rc);
-  if ((rc = dds_set_status_mask (rd, DDS_DATA_AVAILABLE_STATUS | DDS_SUBSCRIPTION_MATCHED_STATUS)) < 0)
-    error2 ("dds_set_status_mask (rd, DDS_DATA_AVAILABLE_STATUS | DDS_SUBSCRIPTION_MATCHED_STATUS): %d\n", (int) rc);
-  if ((rc = dds_waitset_attach (ws, rd, 1)) < 0)
-    error2 ("dds_waitset_attach (ws, rd, 1): %d\n", (int) rc);
+  for (uint32_t i = 0; i < nrds; i++)
+  {
+    if ((rc = dds_set_status_mask (rds[i], DDS_DATA_AVAILABLE_STATUS | DDS_SUBSCRIPTION_MATCHED_STATUS)) < 0)
+      error2 ("dds_set_status_mask (rd, DDS_DATA_AVAILABLE_STATUS | DDS_SUBSCRIPTION_MATCHED_STATUS): %d\n", (int) rc);
+    if ((rc = dds_waitset_attach (ws, rds[i], 1)) < 0)
+      error2 ("dds_waitset_attach (ws, rd, 1): %d\n", (int) rc);
+  }
   return ws;
 }
 
+static dds_entity_t make_reader_waitset (dds_entity_t rd)
+{
+  return make_readers_waitset (1, &rd);
+}
+
+static bool process_data_all (struct subthread_arg *args)
+{
+  /* one subthread_arg per data reader */
+  bool any = false;
+  for (uint32_t i = 0; i < ntopics; i++)
+    if (process_data (args[i].rd, &args[i]))
+      any = true;
+  return any;
+}
+
 static uint32_t subthread_waitset (void *varg)
 {
-  struct subthread_arg * const arg = varg;
-  dds_entity_t ws = make_reader_waitset (rd_data);
+  struct subthread_arg * const args = varg;
+  dds_entity_t ws = make_readers_waitset (ntopics, rd_data);
   while (!ddsrt_atomic_ld32 (&termflag))
   {
-    if (!process_data (rd_data, arg))
+    if (!process_data_all (args))
     {
       /* when we use DATA_AVAILABLE, we must read until nothing remains, or we would deadlock
          if more than max_samples were available and nothing further is received */
@@ -1174,10 +1228,10 @@ static uint32_t subpongthread_waitset (void *varg)
 
 static uint32_t subthread_polling (void *varg)
 {
-  struct subthread_arg * const arg = varg;
+  struct subthread_arg * const args = varg;
   while (!ddsrt_atomic_ld32 (&termflag))
   {
-    if (!process_data (rd_data, arg))
+    if (!process_data_all (args))
       dds_sleepfor (DDS_MSECS (1));
   }
   return 0;
@@ -1333,7 +1387,7 @@ static void participant_data_listener (dds_entity_t rd, void *arg)
             pp->tdisc = dds_time ();
             pp->tdeadline = pp->tdisc + DDS_SECS (5);
             if (pp->handle != dp_handle || ignorelocal == DDS_IGNORELOCAL_NONE)
-              pp->unmatched = MM_ALL & ~(has_reader ? 0 : MM_RD_DATA) & ~(rd_data ? 0 : MM_WR_DATA);
+              pp->unmatched = MM_ALL & ~(has_reader ? 0 : MM_RD_DATA) & ~(rd_data[0] ? 0 : MM_WR_DATA);
             else
               pp->unmatched = 0;
             ddsrt_fibheap_insert (&ppants_to_match_fhd, &ppants_to_match, pp);
@@ -1697,6 +1751,357 @@ static void sigxfsz_handler (int sig __attribute__ ((unused)))
  COMMAND LINE PARSING
  ********************/
 
+/* DISCOVERY STORM */
+
+#define DISC_UDATA_MAGIC "DDSPerfDisc:"
+#define DISC_UDATA_MAGIC_SIZE (sizeof (DISC_UDATA_MAGIC) - 1)
+
+struct disc_endpoint {
+  dds_time_t tcreate;
+  dds_duration_t ttm; /* time-to-match, valid once matched */
+  uint32_t expected;  /* number of remote endpoints it must match */
+  bool matched;
+};
+
+/* Endpoints of the current round that have not yet matched all peers
+   [protected by disc_round_lock] */
+static ddsrt_mutex_t disc_round_lock;
+static ddsrt_cond_t disc_round_cond;
+static uint32_t disc_unmatched;
+
+struct disc_sample {
+  dds_time_t t;
+  int64_t cputime; /* process CPU time (user + system) in ns, or -1 if unknown */
+  bool have_bytes;
+  uint64_t ibytes, obytes;
+};
+
+static void disc_sleepuntil (dds_time_t tend)
+{
+  const dds_time_t tnow = dds_time ();
+  if (tend > tnow)
+    dds_sleepfor (tend - tnow);
+}
+
+static void disc_endpoint_matched (struct disc_endpoint *ep, int32_t current_count)
+{
+  const dds_time_t tnow = dds_time ();
+  ddsrt_mutex_lock (&disc_round_lock);
+  if (!ep->matched && current_count >= 0 && (uint32_t) current_count >= ep->expected)
+  {
+    ep->matched = true;
+    ep->ttm = tnow - ep->tcreate;
+    if (--disc_unmatched == 0)
+      ddsrt_cond_broadcast (&disc_round_cond);
+  }
+  ddsrt_mutex_unlock (&disc_round_lock);
+}
+
+static void disc_subscription_matched_listener (dds_entity_t rd, const dds_subscription_matched_status_t status, void *arg)
+{
+  (void) rd;
+  disc_endpoint_matched (arg, status.current_count);
+}
+
+static void disc_publication_matched_listener (dds_entity_t wr, const dds_publication_matched_status_t status, void *arg)
+{
+  (void) wr;
+  disc_endpoint_matched (arg, status.current_count);
+}
+
+static void disc_take_sample (struct disc_sample *x, struct record_netload_state *netload_state)
+{
+  x->t = dds_time ();
+#if DDSRT_HAVE_RUSAGE
+  ddsrt_rusage_t u;
+  if (ddsrt_getrusage (DDSRT_RUSAGE_SELF, &u) == DDS_RETCODE_OK)
+    x->cputime = u.utime + u.stime;
+  else
+    x->cputime = -1;
+#else
+  x->cputime = -1;
+#endif
+  x->have_bytes = record_netload_bytes (netload_state, &x->ibytes, &x->obytes);
+}
+
+static dds_time_t disc_wait_for_peers (dds_entity_t ctrl, dds_time_t tstartup)
+{
+  /* Every process advertises its start time in the user data of its control
+     participant; once all peers have been found, the latest start time is
+     the reference for the schedule of the rounds, so that all processes
+     create and delete their entities at (almost) the same time. */
+  const dds_time_t tend = dds_time () + ((initmaxwait > 0) ? (dds_duration_t) (initmaxwait * 1e9) : DDS_SECS (10));
+  dds_instance_handle_t *seen = malloc (disc_npeers * sizeof (*seen));
+  uint32_t nseen = 0;
+  dds_time_t tbase = tstartup;
+  dds_entity_t rd;
+  assert (seen);
+  if ((rd = dds_create_reader (ctrl, DDS_BUILTIN_TOPIC_DCPSPARTICIPANT, NULL, NULL)) < 0)
+    error2 ("dds_create_reader(DCPSParticipant) failed: %d\n", (int) rd);
+  while (nseen < disc_npeers && dds_time () < tend)
+  {
+    dds_sample_info_t info;
+    void *msg = NULL;
+    int32_t n;
+    while (nseen < disc_npeers && (n = dds_take (rd, &msg, &info, 1, 1)) > 0)
+    {
+      const dds_builtintopic_participant_t *sample = msg;
+      void *vudata = NULL;
+      size_t usz;
+      uint32_t i;
+      for (i = 0; i < nseen && seen[i] != info.instance_handle; i++)
+        ;
+      if (info.valid_data && i == nseen && dds_qget_userdata (sample->qos, &vudata, &usz) && usz > DISC_UDATA_MAGIC_SIZE)
+      {
+        char udata[64];
+        int64_t t;
+        int pos;
+        (void) ddsrt_strlcpy (udata, vudata, (usz < sizeof (udata)) ? usz + 1 : sizeof (udata));
+        if (sscanf (udata, DISC_UDATA_MAGIC "%"SCNd64"%n", &t, &pos) == 1 && udata[pos] == 0)
+        {
+          seen[nseen++] = info.instance_handle;
+          if (t > tbase)
+            tbase = t;
+        }
+      }
+      dds_free (vudata);
+      dds_return_loan (rd, &msg, n);
+    }
+    if (nseen < disc_npeers)
+      dds_sleepfor (DDS_MSECS (10));
+  }
+  dds_delete (rd);
+  free (seen);
+  if (nseen < disc_npeers)
+  {
+    printf ("[%"PRIdPID"] error: found only %"PRIu32" of %"PRIu32" peers\n", ddsrt_getpid (), nseen, disc_npeers);
+    return DDS_NEVER;
+  }
+  return tbase;
+}
+
+static void disc_create_entities (dds_domainid_t ddid, dds_entity_t *pps, struct disc_endpoint *eps, const uint32_t *rdcount, const uint32_t *wrcount)
+{
+  const uint32_t neps_pp = disc_nrd + disc_nwr;
+  dds_qos_t *qos = dds_create_qos ();
+  dds_qset_reliability (qos, DDS_RELIABILITY_RELIABLE, DDS_SECS (1));
+  dds_entity_t *tps = malloc (disc_ntp * sizeof (*tps));
+  assert (tps);
+  for (uint32_t p = 0; p < disc_npp; p++)
+  {
+    if ((pps[p] = dds_create_participant (ddid, NULL, NULL)) < 0)
+      error2 ("dds_create_participant(domain %d) failed: %d\n", (int) ddid, (int) pps[p]);
+    for (uint32_t t = 0; t < disc_ntp; t++)
+    {
+      char tpname[32];
+      (void) snprintf (tpname, sizeof (tpname), "DDSPerfDisc%"PRIu32, t);
+      if ((tps[t] = dds_create_topic (pps[p], &OneULong_desc, tpname, NULL, NULL)) < 0)
+        error2 ("dds_create_topic(%s) failed: %d\n", tpname, (int) tps[t]);
+    }
+    for (uint32_t j = 0; j < neps_pp; j++)
+    {
+      struct disc_endpoint * const ep = &eps[p * neps_pp + j];
+      const bool isreader = (j < disc_nrd);
+      const uint32_t t = isreader ? (p * disc_nrd + j) % disc_ntp : (p * disc_nwr + j - disc_nrd) % disc_ntp;
+      dds_listener_t *listener = dds_create_listener (ep);
+      dds_entity_t e;
+      ep->expected = disc_npeers * (isreader ? wrcount[t] : rdcount[t]);
+      ep->matched = false;
+      ep->tcreate = dds_time ();
+      if (isreader)
+      {
+        dds_lset_subscription_matched (listener, disc_subscription_matched_listener);
+        if ((e = dds_create_reader (pps[p], tps[t], qos, listener)) < 0)
+          error2 ("dds_create_reader(DDSPerfDisc%"PRIu32") failed: %d\n", t, (int) e);
+      }
+      else
+      {
+        dds_lset_publication_matched (listener, disc_publication_matched_listener);
+        if ((e = dds_create_writer (pps[p], tps[t], qos, listener)) < 0)
+          error2 ("dds_create_writer(DDSPerfDisc%"PRIu32") failed: %d\n", t, (int) e);
+      }
+      dds_delete_listener (listener);
+    }
+  }
+  free (tps);
+  dds_delete_qos (qos);
+}
+
+static void disc_print_ttm (const char *prefix, int64_t *ttm, uint32_t n)
+{
+  if (n == 0)
+    printf ("%s time-to-match: no matches\n", prefix);
+  else
+  {
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+      sum += ttm[i];
+    qsort (ttm, n, sizeof (*ttm), cmp_int64);
+    printf ("%s time-to-match mean %.3fms min %.3fms 50%% %.3fms 90%% %.3fms 99%% %.3fms max %.3fms cnt %"PRIu32"\n",
+            prefix,
+            (double) sum / (double) n / 1e6,
+            (double) ttm[0] / 1e6,
+            (double) ttm[n - (n + 1) / 2] / 1e6,
+            (double) ttm[n - (n + 9) / 10] / 1e6,
+            (double) ttm[n - (n + 99) / 100] / 1e6,
+            (double) ttm[n - 1] / 1e6,
+            n);
+  }
+}
+
+static void disc_print_load (const char *prefix, const struct disc_sample *a, const struct disc_sample *b, uint32_t nrounds, const char *netload_if)
+{
+  /* every process discovers all endpoints of all peers, including its own */
+  const double neps = (double) nrounds * disc_npeers * disc_npp * (disc_nrd + disc_nwr);
+  char line[256];
+  size_t pos = 0;
+  if (a->cputime >= 0 && b->cputime >= 0)
+  {
+    const double cpu = (double) (b->cputime - a->cputime);
+    xsnprintf (line, sizeof (line), &pos, " cpu %.1fms %.1fus/endpoint", cpu / 1e6, (neps > 0) ? cpu / 1e3 / neps : 0.0);
+  }
+  if (a->have_bytes && b->have_bytes)
+  {
+    const double ob = (double) (b->obytes - a->obytes), ib = (double) (b->ibytes - a->ibytes);
+    xsnprintf (line, sizeof (line), &pos, " %s xmit %.0fkB recv %.0fkB %.0fB/endpoint", netload_if, ob / 1e3, ib / 1e3, (neps > 0) ? ob / neps : 0.0);
+  }
+  if (pos > 0)
+    printf ("%s%s\n", prefix, line);
+}
+
+static int run_discmode (dds_domainid_t ddid, struct record_netload_state *netload_state, const char *netload_if)
+{
+  const uint32_t neps_pp = disc_nrd + disc_nwr;
+  const uint32_t neps = disc_npp * neps_pp;
+  const dds_time_t tstartup = dds_time ();
+  uint32_t *rdcount = calloc (disc_ntp, sizeof (*rdcount));
+  uint32_t *wrcount = calloc (disc_ntp, sizeof (*wrcount));
+  dds_entity_t *pps = malloc ((disc_npp > 0 ? disc_npp : 1) * sizeof (*pps));
+  struct disc_endpoint *eps = malloc ((neps > 0 ? neps : 1) * sizeof (*eps));
+  int64_t *ttm = malloc (((size_t) disc_rounds * neps + 1) * sizeof (*ttm));
+  uint32_t nttm = 0, nunmatched_total = 0;
+  dds_entity_t ctrl;
+  dds_qos_t *qos;
+  assert (rdcount && wrcount && pps && eps && ttm);
+
+  for (uint32_t p = 0; p < disc_npp; p++)
+  {
+    for (uint32_t j = 0; j < disc_nrd; j++)
+      rdcount[(p * disc_nrd + j) % disc_ntp]++;
+    for (uint32_t j = 0; j < disc_nwr; j++)
+      wrcount[(p * disc_nwr + j) % disc_ntp]++;
+  }
+
+  ddsrt_mutex_init (&disc_round_lock);
+  ddsrt_cond_init (&disc_round_cond);
+
+  qos = dds_create_qos ();
+  {
+    char udata[64];
+    (void) snprintf (udata, sizeof (udata), DISC_UDATA_MAGIC"%"PRId64, tstartup);
+    dds_qset_userdata (qos, udata, strlen (udata));
+  }
+  if ((ctrl = dds_create_participant (ddid, qos, NULL)) < 0)
+    error2 ("dds_create_participant(domain %d) failed: %d\n", (int) ddid, (int) ctrl);
+  dds_delete_qos (qos);
+
+  const dds_time_t tbase = disc_wait_for_peers (ctrl, tstartup);
+  if (tbase == DDS_NEVER)
+  {
+    dds_delete (ctrl);
+    return 1;
+  }
+
+  printf ("[%"PRIdPID"] discovery storm: %"PRIu32" peers, %"PRIu32" participants with %"PRIu32" readers and %"PRIu32" writers on %"PRIu32" topics per peer, %"PRIu32" rounds of %.3fs\n",
+          ddsrt_getpid (), disc_npeers, disc_npp, disc_nrd, disc_nwr, disc_ntp, disc_rounds, (double) disc_period / 1e9);
+  fflush (stdout);
+
+  /* Rounds are scheduled relative to the latest start time of all peers:
+     entities are created at the start of a round, kept alive for the first
+     half and deleted in the second half, to give every process the same
+     opportunity to discover them. */
+  struct disc_sample sfirst, sprev, snext;
+  dds_time_t tstart = tbase + disc_period;
+  disc_sleepuntil (tstart);
+  disc_take_sample (&sfirst, netload_state);
+  sprev = sfirst;
+  for (uint32_t r = 0; r < disc_rounds; r++, tstart += disc_period)
+  {
+    const dds_time_t tdelete = tstart + disc_period / 2;
+    int64_t * const ttm_round = ttm + nttm;
+    uint32_t nttm_round = 0, nunmatched = 0;
+    char prefix[64];
+
+    ddsrt_mutex_lock (&disc_round_lock);
+    disc_unmatched = neps;
+    ddsrt_mutex_unlock (&disc_round_lock);
+    disc_create_entities (ddid, pps, eps, rdcount, wrcount);
+    const dds_time_t tcreated = dds_time ();
+
+    ddsrt_mutex_lock (&disc_round_lock);
+    for (uint32_t i = 0; i < neps; i++)
+    {
+      /* endpoints on topics without any counterparts have nothing to wait for */
+      if (eps[i].expected == 0 && !eps[i].matched)
+      {
+        eps[i].matched = true;
+        eps[i].ttm = -1;
+        disc_unmatched--;
+      }
+    }
+    while (disc_unmatched > 0 && ddsrt_cond_waituntil (&disc_round_cond, &disc_round_lock, tdelete))
+      ;
+    for (uint32_t i = 0; i < neps; i++)
+    {
+      if (!eps[i].matched)
+        nunmatched++;
+      else if (eps[i].ttm >= 0)
+        ttm_round[nttm_round++] = eps[i].ttm;
+    }
+    ddsrt_mutex_unlock (&disc_round_lock);
+
+    disc_sleepuntil (tdelete);
+    for (uint32_t p = 0; p < disc_npp; p++)
+      dds_delete (pps[p]);
+    const dds_time_t tdeleted = dds_time ();
+    disc_sleepuntil (tstart + disc_period);
+    disc_take_sample (&snext, netload_state);
+
+    (void) snprintf (prefix, sizeof (prefix), "[%"PRIdPID"] round %"PRIu32":", ddsrt_getpid (), r);
+    printf ("%s create %.3fms delete %.3fms unmatched %"PRIu32"\n", prefix,
+            (double) (tcreated - tstart) / 1e6, (double) (tdeleted - tdelete) / 1e6, nunmatched);
+    disc_print_ttm (prefix, ttm_round, nttm_round);
+    disc_print_load (prefix, &sprev, &snext, 1, netload_if);
+    fflush (stdout);
+    nttm += nttm_round;
+    nunmatched_total += nunmatched;
+    sprev = snext;
+  }
+
+  {
+    char prefix[64];
+    (void) snprintf (prefix, sizeof (prefix), "[%"PRIdPID"] total:", ddsrt_getpid ());
+    disc_print_ttm (prefix, ttm, nttm);
+    disc_print_load (prefix, &sfirst, &sprev, disc_rounds, netload_if);
+    fflush (stdout);
+  }
+
+  dds_delete (ctrl);
+  ddsrt_cond_destroy (&disc_round_cond);
+  ddsrt_mutex_destroy (&disc_round_lock);
+  free (ttm);
+  free (eps);
+  free (pps);
+  free (wrcount);
+  free (rdcount);
+  if (nunmatched_total > 0)
+  {
+    printf ("[%"PRIdPID"] error: %"PRIu32" endpoints failed to match within %.3fs\n", ddsrt_getpid (), nunmatched_total, (double) (disc_period / 2) / 1e9);
+    return 1;
+  }
+  return 0;
+}
+
 static void usage (void)
 {
   printf ("\
@@ -1714,6 +2119,8 @@ OPTIONS:\n\
                         OU   seq num\n\
   -n N                number of key values to use for data (only for\n\
                       topics with a key value)\n\
+  -t N                number of data topics to use, data is published\n\
+                      round-robin over all of them (default 1)\n\
   -u                  best-effort instead of reliable\n\
   -k all|N            keep-all or keep-last-N for data (ping/pong is\n\
                       always keep-last-1)\n\
@@ -1767,6 +2174,21 @@ MODE... is zero or more of:\n\
     If desired, a fraction of the samples can be treated as if it were a\n\
     ping, for this, specify a percentage either as \"ping X%%\" (the\n\
     \"ping\" keyword is optional, the %% sign is not).\n\
+  disc [participants N] [readers N] [writers N] [topics N] [peers N]\n\
+       [rounds N] [period DUR] [loopback]\n\
+    Discovery storm, can't be combined with other modes.  Once N peers\n\
+    (ddsperf processes in disc mode, including this one, default 1) have\n\
+    found each other, run N rounds (default 10) of DUR seconds (default 2)\n\
+    in which each process creates N participants (default 1) with N readers\n\
+    and N writers each (default 1) spread over N topics (default 1), and\n\
+    deletes them again halfway through the round.  All peers must use the\n\
+    same parameters.  Reports the distribution of the time it takes\n\
+    each reader/writer to match all its counterparts, the CPU time per\n\
+    discovered endpoint and, if available, the number of bytes on the\n\
+    device given by -d.  \"loopback\" restricts traffic to the loopback\n\
+    interface using unicast discovery and reports the bytes on it, which\n\
+    then is all discovery traffic of all peers.  -Qinitwait:DUR sets the\n\
+    time allowed for finding the peers (default 10s).\n\
 \n\
   Payload size (including fixed part of topic) may be set as part of a\n\
   \"ping\" or \"pub\" specification for topic KS (there is only size,\n\
@@ -1789,6 +2211,9 @@ EXAMPLES:\n\
   ddsperf -L -TOU -D10 pub sub\n\
     basic throughput test within the process with tiny, keyless samples,\n\
     running for 10s\n\
+  ddsperf disc loopback peers 2 participants 4 readers 10 writers 10 topics 5 &\n\
+  ddsperf disc loopback peers 2 participants 4 readers 10 writers 10 topics 5\n\
+    discovery storm between two processes on this machine\n\
 ", argv0, argv0, argv0);
   fflush (stdout);
   exit (3);
@@ -1804,6 +2229,7 @@ static const struct string_int_map_elem modestrings[] = {
   { "pong", 2 },
   { "sub", 3 },
   { "pub", 4 },
+  { "disc", 5 },
   { NULL, 0 }
 };
 
@@ -2006,6 +2432,46 @@ static void set_mode_pub (int *xoptind, int xargc, char * const xargv[])
   }
 }
 
+static void set_mode_disc (int *xoptind, int xargc, char * const xargv[])
+{
+  discmode = true;
+  while (*xoptind < xargc && exact_string_int_map_lookup (modestrings, "mode string", xargv[*xoptind], false) == -1)
+  {
+    int pos = 0;
+    double d;
+    if (set_simple_uint32 (xoptind, xargc, xargv, "participants", NULL, &disc_npp) ||
+        set_simple_uint32 (xoptind, xargc, xargv, "readers", NULL, &disc_nrd) ||
+        set_simple_uint32 (xoptind, xargc, xargv, "writers", NULL, &disc_nwr) ||
+        set_simple_uint32 (xoptind, xargc, xargv, "topics", NULL, &disc_ntp) ||
+        set_simple_uint32 (xoptind, xargc, xargv, "peers", NULL, &disc_npeers) ||
+        set_simple_uint32 (xoptind, xargc, xargv, "rounds", NULL, &disc_rounds))
+    {
+      /* no further work needed */
+    }
+    else if (strcmp (xargv[*xoptind], "period") == 0)
+    {
+      if (++(*xoptind) == xargc)
+        error3 ("argument missing in period specification\n");
+      if (sscanf (xargv[*xoptind], "%lf%n", &d, &pos) != 1 || xargv[*xoptind][pos] != 0 || d <= 0)
+        error3 ("%s: invalid period specification\n", xargv[*xoptind]);
+      disc_period = (dds_duration_t) (d * 1e9 + 0.5);
+    }
+    else if (strcmp (xargv[*xoptind], "loopback") == 0)
+    {
+      disc_loopback = true;
+    }
+    else
+    {
+      error3 ("%s: unrecognised discovery specification\n", xargv[*xoptind]);
+    }
+    (*xoptind)++;
+  }
+  if (disc_ntp == 0)
+    error3 ("disc: invalid number of topics\n");
+  if (disc_npeers == 0)
+    error3 ("disc: invalid number of peers\n");
+}
+
 static void set_mode (int xoptind, int xargc, char * const xargv[])
 {
   int code;
@@ -2023,12 +2489,17 @@ static void set_mode (int xoptind, int xargc, char * const xargv[])
       case 2: set_mode_pong (&xoptind, xargc, xargv); break;
       case 3: set_mode_sub (&xoptind, xargc, xargv); break;
       case 4: set_mode_pub (&xoptind, xargc, xargv); break;
+      case 5: set_mode_disc (&xoptind, xargc, xargv); break;
     }
   }
   if (xoptind != xargc)
   {
     error3 ("%s: unrecognized argument\n", xargv[xoptind]);
   }
+  if (discmode && (pub_rate > 0 || submode != SM_NONE || ping_intv != DDS_INFINITY))
+  {
+    error3 ("disc mode can't be combined with other modes\n");
+  }
 }
 
 int main (int argc, char *argv[])
@@ -2053,7 +2524,7 @@ int main (int argc, char *argv[])
 
   argv0 = argv[0];
 
-  while ((opt = getopt (argc, argv, "1cd:D:i:n:k:ulLK:T:Q:R:Xh")) != EOF)
+  while ((opt = getopt (argc, argv, "1cd:D:i:n:t:k:ulLK:T:Q:R:Xh")) != EOF)
   {
     int pos;
     switch (opt)
@@ -2076,6 +2547,7 @@ int main (int argc, char *argv[])
       case 'D': dur = atof (optarg); if (dur <= 0) dur = HUGE_VAL; break;
       case 'i': did = (dds_domainid_t) atoi (optarg); break;
       case 'n': nkeyvals = (unsigned) atoi (optarg); break;
+      case 't': ntopics = (uint32_t) atoi (optarg); if (ntopics == 0) error3 ("-t %s: invalid number of topics\n", optarg); break;
       case 'u': reliable = false; break;
       case 'k': histdepth = atoi (optarg); if (histdepth < 0) histdepth = 0; break;
       case 'l': sublatency = true; break;
@@ -2150,6 +2622,41 @@ int main (int argc, char *argv[])
   else if ((netload_state = record_netload_new (netload_if, netload_bw)) == NULL)
     error3 ("can't get network utilization information for device %s\n", netload_if);
 
+  if (discmode)
+  {
+    dds_domainid_t ddid = did;
+    if (disc_loopback)
+    {
+      /* loopback only, no multicast: unicast discovery using participant
+         indices for locating the peers on this machine */
+      char config[512];
+      dds_entity_t dom;
+      if (disc_npeers > 110)
+        error3 ("disc: loopback supports at most 110 peers\n");
+      (void) snprintf (config, sizeof (config),
+        "<General><NetworkInterfaceAddress>127.0.0.1</NetworkInterfaceAddress><AllowMulticast>false</AllowMulticast></General>"
+        "<Discovery><ParticipantIndex>auto</ParticipantIndex><MaxAutoParticipantIndex>%"PRIu32"</MaxAutoParticipantIndex>"
+        "<Peers><Peer Address=\"127.0.0.1\"/></Peers></Discovery>", disc_npeers + 9);
+      if (ddid == DDS_DOMAIN_DEFAULT)
+        ddid = 0;
+      if ((dom = dds_create_domain (ddid, config)) < 0)
+        error2 ("dds_create_domain(domain %d) failed: %d\n", (int) ddid, (int) dom);
+      if (netload_state == NULL)
+      {
+#if defined __APPLE__
+        (void) ddsrt_strlcpy (netload_if, "lo0", sizeof (netload_if));
+#else
+        (void) ddsrt_strlcpy (netload_if, "lo", sizeof (netload_if));
+#endif
+        netload_state = record_netload_new (netload_if, 0);
+      }
+    }
+    const int ret = run_discmode (ddid, netload_state, netload_if);
+    record_netload_free (netload_state);
+    dds_delete (DDS_CYCLONEDDS_HANDLE);
+    return ret;
+  }
+
   ddsrt_avl_init (&ppants_td, &ppants);
   ddsrt_fibheap_init (&ppants_to_match_fhd, &ppants_to_match);
 
@@ -2210,8 +2717,21 @@ int main (int argc, char *argv[])
     snprintf (tpname_pong, sizeof (tpname_pong), "DDSPerf%cPong%s", reliable ? 'R' : 'U', tp_suf);
     qos = dds_create_qos ();
     dds_qset_reliability (qos, reliable ? DDS_RELIABILITY_RELIABLE : DDS_RELIABILITY_BEST_EFFORT, DDS_SECS (10));
-    if ((tp_data = dds_create_topic (dp, tp_desc, tpname_data, qos, NULL)) < 0)
-      error2 ("dds_create_topic(%s) failed: %d\n", tpname_data, (int) tp_data);
+    tp_data = malloc (ntopics * sizeof (*tp_data));
+    rd_data = calloc (ntopics, sizeof (*rd_data));
+    wr_data = calloc (ntopics, sizeof (*wr_data));
+    assert (tp_data && rd_data && wr_data);
+    for (uint32_t i = 0; i < ntopics; i++)
+    {
+      /* first one keeps the old name for compatibility with older versions */
+      char tpname[48];
+      if (i == 0)
+        (void) ddsrt_strlcpy (tpname, tpname_data, sizeof (tpname));
+      else
+        (void) snprintf (tpname, sizeof (tpname), "%s_%"PRIu32, tpname_data, i);
+      if ((tp_data[i] = dds_create_topic (dp, tp_desc, tpname, qos, NULL)) < 0)
+        error2 ("dds_create_topic(%s) failed: %d\n", tpname, (int) tp_data[i]);
+    }
     if ((tp_ping = dds_create_topic (dp, tp_desc, tpname_ping, qos, NULL)) < 0)
       error2 ("dds_create_topic(%s) failed: %d\n", tpname_ping, (int) tp_ping);
     if ((tp_pong = dds_create_topic (dp, tp_desc, tpname_pong, qos, NULL)) < 0)
@@ -2280,13 +2800,19 @@ int main (int argc, char *argv[])
   dds_qset_ignorelocal (qos, ignorelocal);
   listener = dds_create_listener ((void *) (uintptr_t) MM_WR_DATA);
   dds_lset_subscription_matched (listener, subscription_matched_listener);
-  if (submode != SM_NONE && (rd_data = dds_create_reader (sub, tp_data, qos, listener)) < 0)
-    error2 ("dds_create_reader(%s) failed: %d\n", tpname_data, (int) rd_data);
+  for (uint32_t i = 0; i < ntopics; i++)
+  {
+    if (submode != SM_NONE && (rd_data[i] = dds_create_reader (sub, tp_data[i], qos, listener)) < 0)
+      error2 ("dds_create_reader(%s) failed: %d\n", tpname_data, (int) rd_data[i]);
+  }
   dds_delete_listener (listener);
   listener = dds_create_listener ((void *) (uintptr_t) MM_RD_DATA);
   dds_lset_publication_matched (listener, publication_matched_listener);
-  if ((wr_data = dds_create_writer (pub, tp_data, qos, listener)) < 0)
-    error2 ("dds_create_writer(%s) failed: %d\n", tpname_data, (int) wr_data);
+  for (uint32_t i = 0; i < ntopics; i++)
+  {
+    if ((wr_data[i] = dds_create_writer (pub, tp_data[i], qos, listener)) < 0)
+      error2 ("dds_create_writer(%s) failed: %d\n", tpname_data, (int) wr_data[i]);
+  }
   dds_delete_listener (listener);
 
   /* We only need a pong reader when sending data with a non-zero probability
@@ -2333,9 +2859,12 @@ int main (int argc, char *argv[])
   /* Make publisher & subscriber thread arguments and start the threads we
      need (so what if we allocate memory for reading data even if we don't
      have a reader or will never really be receiving data) */
-  struct subthread_arg subarg_data, subarg_ping, subarg_pong;
+  struct subthread_arg *subarg_data, subarg_ping, subarg_pong;
   init_eseq_admin (&eseq_admin, nkeyvals);
-  subthread_arg_init (&subarg_data, rd_data, 1000);
+  subarg_data = malloc (ntopics * sizeof (*subarg_data));
+  assert (subarg_data);
+  for (uint32_t i = 0; i < ntopics; i++)
+    subthread_arg_init (&subarg_data[i], rd_data[i], 1000);
   subthread_arg_init (&subarg_ping, rd_ping, 100);
   subthread_arg_init (&subarg_pong, rd_pong, 100);
   uint32_t (*subthread_func) (void *arg) = 0;
@@ -2381,9 +2910,12 @@ int main (int argc, char *argv[])
   if (pub_rate > 0)
     ddsrt_thread_create (&pubtid, "pub", &attr, pubthread, NULL);
   if (subthread_func != 0)
-    ddsrt_thread_create (&subtid, "sub", &attr, subthread_func, &subarg_data);
+    ddsrt_thread_create (&subtid, "sub", &attr, subthread_func, subarg_data);
   else if (submode == SM_LISTENER)
-    set_data_available_listener (rd_data, "rd_data", data_available_listener, &subarg_data);
+  {
+    for (uint32_t i = 0; i < ntopics; i++)
+      set_data_available_listener (rd_data[i], "rd_data", data_available_listener, &subarg_data[i]);
+  }
   /* Need to handle incoming "pong"s only if we can be sending "ping"s (whether that
      be pings from the "ping" mode (i.e. ping_intv != DDS_NEVER), or pings embedded
      in the published data stream (i.e. rate > 0 && ping_frac > 0).  The trouble with
@@ -2410,9 +2942,9 @@ int main (int argc, char *argv[])
   struct dds_stats stats;
   const struct dds_stat_keyvalue dummy_u64 = { .name = "", .kind = DDS_STAT_KIND_UINT64, .u.u64 = 0 };
   const struct dds_stat_keyvalue dummy_u32 = { .name = "", .kind = DDS_STAT_KIND_UINT32, .u.u32 = 0 };
-  stats.substat = dds_create_statistics (rd_data);
+  stats.substat = dds_create_statistics (rd_data[0]);
   stats.discarded_bytes = dds_lookup_statistic (stats.substat, "discarded_bytes");
-  stats.pubstat = dds_create_statistics (wr_data);
+  stats.pubstat = dds_create_statistics (wr_data[0]);
   stats.rexmit_bytes = dds_lookup_statistic (stats.pubstat, "rexmit_bytes");
   stats.time_rexmit = dds_lookup_statistic (stats.pubstat, "time_rexmit");
   stats.time_throttle = dds_lookup_statistic (stats.pubstat, "time_throttle");
@@ -2589,7 +3121,8 @@ err_minmatch_wait:
      (not quite good, but ...) */
   dds_set_listener (rd_ping, NULL);
   dds_set_listener (rd_pong, NULL);
-  dds_set_listener (rd_data, NULL);
+  for (uint32_t i = 0; i < ntopics; i++)
+    dds_set_listener (rd_data[i], NULL);
   dds_set_listener (rd_participants, NULL);
   dds_set_listener (rd_subscriptions, NULL);
   dds_set_listener (rd_publications, NULL);
@@ -2606,7 +3139,8 @@ err_minmatch_wait:
      The fix is to eliminate the waiting and retrying, and instead
      flip the reader's state to out-of-sync and rely on retransmits
      to let it make progress once room is available again.  */
-  dds_delete (rd_data);
+  for (uint32_t i = 0; i < ntopics; i++)
+    dds_delete (rd_data[i]);
 
   uint64_t nlost = 0;
   bool received_ok = true;
@@ -2617,10 +3151,15 @@ err_minmatch_wait:
       received_ok = false;
   }
   fini_eseq_admin (&eseq_admin);
-  subthread_arg_fini (&subarg_data);
+  for (uint32_t i = 0; i < ntopics; i++)
+    subthread_arg_fini (&subarg_data[i]);
+  free (subarg_data);
   subthread_arg_fini (&subarg_ping);
   subthread_arg_fini (&subarg_pong);
   dds_delete (dp);
+  free (rd_data);
+  free (wr_data);
+  free (tp_data);
   ddsrt_mutex_destroy (&disc_lock);
   ddsrt_mutex_destroy (&pongwr_lock);
   ddsrt_mutex_destroy (&pongstat_lock);
@@ -90,6 +90,16 @@ struct record_netload_state *record_netload_new (const char *dev, double bw)
   return st;
 }
 
+bool record_netload_bytes (struct record_netload_state *st, uint64_t *ibytes, uint64_t *obytes)
+{
+  struct ddsrt_netstat x;
+  if (st == NULL || st->errored || ddsrt_netstat_get (st->ctrl, &x) != DDS_RETCODE_OK)
+    return false;
+  *ibytes = x.ibytes;
+  *obytes = x.obytes;
+  return true;
+}
+
 void record_netload_free (struct record_netload_state *st)
 {
   if (st)
@@ -116,6 +126,14 @@ struct record_netload_state *record_netload_new (const char *dev, double bw)
   return NULL;
 }
 
+bool record_netload_bytes (struct record_netload_state *st, uint64_t *ibytes, uint64_t *obytes)
+{
+  (void) st;
+  (void) ibytes;
+  (void) obytes;
+  return false;
+}
+
 void record_netload_free (struct record_netload_state *st)
 {
   (void) st;
@@ -18,6 +18,7 @@ struct record_netload_state;
 
 void record_netload (struct record_netload_state *st, const char *prefix, dds_time_t tnow);
 struct record_netload_state *record_netload_new (const char *dev, double bw);
+bool record_netload_bytes (struct record_netload_state *st, uint64_t *ibytes, uint64_t *obytes);
 void record_netload_free (struct record_netload_state *st);
 
 #endif
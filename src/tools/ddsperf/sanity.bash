@@ -15,6 +15,24 @@ for pid in $ddsperf_pids ; do
         exitcode=$x
     fi
 done
+# discovery storm between two processes over loopback
+ddsperf_pids=""
+for n in 1 2 ; do
+    bin/ddsperf disc loopback peers 2 participants 2 readers 10 writers 10 topics 4 rounds 5 & ddsperf_pids="$ddsperf_pids $!"
+done
+sleep 16
+for pid in $ddsperf_pids ; do
+    if kill -0 $pid 2>/dev/null ; then
+        echo "killing process $pid"
+        kill -9 $pid
+        exitcode=2
+    fi
+    wait $pid
+    x=$?
+    if [[ $x -gt $exitcode ]] ; then
+        exitcode=$x
+    fi
+done
 if [[ $exitcode -gt 0 ]] ; then
     echo "** FAILED **"
 else
@@ -0,0 +1,50 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dds/ddsrt/bintrace.h"
+
+/* Converts a trace written with Tracing/OutputFormat set to "binary" to the
+   same text that would have been written otherwise, so that it can be read
+   or processed further with decode-trace.  Usage:
+   decode-bintrace [INPUT [OUTPUT]], with "-" or no argument meaning standard
+   input/output. */
+
+int main (int argc, char **argv)
+{
+  FILE *in = stdin, *out = stdout;
+  dds_return_t rc;
+  if (argc > 3 || (argc > 1 && strcmp (argv[1], "-h") == 0))
+  {
+    fprintf (stderr, "usage: %s [INPUT [OUTPUT]]\n", argv[0]);
+    return 1;
+  }
+  if (argc > 1 && strcmp (argv[1], "-") != 0 && (in = fopen (argv[1], "rb")) == NULL)
+  {
+    perror (argv[1]);
+    return 1;
+  }
+  if (argc > 2 && strcmp (argv[2], "-") != 0 && (out = fopen (argv[2], "w")) == NULL)
+  {
+    perror (argv[2]);
+    return 1;
+  }
+  if ((rc = ddsrt_bintrace_decode (out, in)) != DDS_RETCODE_OK)
+    fprintf (stderr, "%s: not a binary trace or malformed input\n", (argc > 1) ? argv[1] : "stdin");
+  if (in != stdin)
+    fclose (in);
+  if (out != stdout)
+    fclose (out);
+  return (rc == DDS_RETCODE_OK) ? 0 : 1;
+}
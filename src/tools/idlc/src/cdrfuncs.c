@@ -0,0 +1,669 @@
+/*
+ * Copyright(c) 2021 ADLINK Technology Limited and others
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v. 2.0 which is available at
+ * http://www.eclipse.org/legal/epl-2.0, or the Eclipse Distribution License
+ * v. 1.0 which is available at
+ * http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "idl/print.h"
+#include "idl/processor.h"
+#include "idl/stream.h"
+#include "idl/string.h"
+
+#include "generator.h"
+#include "descriptor.h"
+#include "dds/ddsc/dds_opcodes.h"
+
+/* type-specific (de)serialization functions are generated by partially
+   evaluating the marshalling opcodes: the instruction table is walked exactly
+   the way the interpreter in ddsi_cdrstream.c walks the ops array, but
+   instead of performing the operations, equivalent C code is emitted. offsets
+   and sizes are kept symbolic and the stream primitives are shared with the
+   interpreter, which remains in use for anything not covered here */
+
+enum cdr_func {
+  CDR_WRITE,
+  CDR_READ,
+  CDR_NORMALIZE
+};
+
+struct cdr_funcs {
+  FILE *fp;
+  const struct descriptor *descriptor;
+  enum cdr_func func;
+  uint32_t names; /**< counter for generating unique local names */
+};
+
+/* indexed by DDS_OP_VAL_1BY .. DDS_OP_VAL_8BY */
+static const char *prim_types[] = { NULL, "uint8_t", "uint16_t", "uint32_t", "uint64_t" };
+static const char *prim_sizes[] = { NULL, "1", "2", "4", "8" };
+static const char *prim_bits[] = { NULL, "8", "16", "32", "64" };
+static const char *prim_codes[] = { NULL, "DDS_OP_VAL_1BY", "DDS_OP_VAL_2BY", "DDS_OP_VAL_4BY", "DDS_OP_VAL_8BY" };
+
+#define OPCODE_OF(code) ((code) & (0xffu << 24))
+#define TYPE_OF(code) (((code) >> 16) & 0xffu)
+#define SUBTYPE_OF(code) (((code) >> 8) & 0xffu)
+
+static bool is_prim(uint32_t type)
+{
+  return type >= DDS_OP_VAL_1BY && type <= DDS_OP_VAL_8BY;
+}
+
+static int emit_ops(struct cdr_funcs *funcs, uint32_t index, const char *base, int ind);
+
+static int emit(struct cdr_funcs *funcs, int ind, const char *fmt, ...)
+idl_attribute_format((printf, 3, 4));
+
+static int emit(struct cdr_funcs *funcs, int ind, const char *fmt, ...)
+{
+  int cnt;
+  va_list ap;
+
+  if (ind && idl_fprintf(funcs->fp, "%*s", ind, "") < 0)
+    return -1;
+  va_start(ap, fmt);
+  cnt = idl_vfprintf(funcs->fp, fmt, ap);
+  va_end(ap);
+  return cnt < 0 ? -1 : 0;
+}
+
+/* emit "if (!<expr>) return false;" for normalize */
+static int emit_check(struct cdr_funcs *funcs, int ind, const char *fmt, ...)
+idl_attribute_format((printf, 3, 4));
+
+static int emit_check(struct cdr_funcs *funcs, int ind, const char *fmt, ...)
+{
+  int cnt;
+  char *expr = NULL;
+  va_list ap;
+
+  va_start(ap, fmt);
+  cnt = idl_vasprintf(&expr, fmt, ap);
+  va_end(ap);
+  if (cnt < 0)
+    return -1;
+  cnt = emit(funcs, ind, "if (!%s)\n", expr);
+  free(expr);
+  if (cnt < 0 || emit(funcs, ind+2, "return false;\n") < 0)
+    return -1;
+  return 0;
+}
+
+static const struct instruction *
+instruction(const struct cdr_funcs *funcs, uint32_t index, int type)
+{
+  const struct instruction *inst;
+  assert(index < funcs->descriptor->instructions.count);
+  inst = &funcs->descriptor->instructions.table[index];
+  assert((int)inst->type == type);
+  (void)type;
+  return inst;
+}
+
+static uint32_t opcode(const struct cdr_funcs *funcs, uint32_t index)
+{
+  return instruction(funcs, index, OPCODE)->data.opcode.code;
+}
+
+static uint32_t single(const struct cdr_funcs *funcs, uint32_t index)
+{
+  return instruction(funcs, index, SINGLE)->data.single;
+}
+
+static uint16_t jump(const struct cdr_funcs *funcs, uint32_t index)
+{
+  return instruction(funcs, index, COUPLE)->data.couple.high;
+}
+
+static uint16_t subroutine(const struct cdr_funcs *funcs, uint32_t index)
+{
+  return instruction(funcs, index, COUPLE)->data.couple.low;
+}
+
+static const char *size(const struct cdr_funcs *funcs, uint32_t index)
+{
+  return instruction(funcs, index, SIZE)->data.size.type;
+}
+
+static const char *constant(const struct cdr_funcs *funcs, uint32_t index)
+{
+  const struct instruction *inst = instruction(funcs, index, CONSTANT);
+  return inst->data.constant.value ? inst->data.constant.value : "0";
+}
+
+/* expression for the address of the member described by the offset
+   instruction at index, relative to base */
+static char *address(const struct cdr_funcs *funcs, uint32_t index, const char *base)
+{
+  char *str = NULL;
+  const struct instruction *inst = instruction(funcs, index, OFFSET);
+  if (!inst->data.offset.type)
+    return idl_strdup(base);
+  if (idl_asprintf(&str, "%s + offsetof (%s, %s)", base, inst->data.offset.type, inst->data.offset.member) < 0)
+    return NULL;
+  return str;
+}
+
+static const char *pointer(const struct cdr_funcs *funcs)
+{
+  return funcs->func == CDR_WRITE ? "const char *" : "char *";
+}
+
+/* primitive value, string or bounded string at addr */
+static int emit_value(
+  struct cdr_funcs *funcs, uint32_t type, uint32_t bound, const char *addr, int ind)
+{
+  switch (funcs->func) {
+    case CDR_WRITE:
+      if (is_prim(type))
+        return emit(funcs, ind, "dds_os_put%s (os, *(const %s *) (%s));\n", prim_sizes[type], prim_types[type], addr);
+      else if (type == DDS_OP_VAL_STR)
+        return emit(funcs, ind, "dds_stream_write_string (os, *(char * const *) (%s));\n", addr);
+      else if (type == DDS_OP_VAL_BST)
+        return emit(funcs, ind, "dds_stream_write_string (os, %s);\n", addr);
+      break;
+    case CDR_READ:
+      if (is_prim(type))
+        return emit(funcs, ind, "*(%s *) (%s) = dds_is_get%s (is);\n", prim_types[type], addr, prim_sizes[type]);
+      else if (type == DDS_OP_VAL_STR)
+        return emit(funcs, ind, "*(char **) (%s) = dds_stream_reuse_string (is, *(char **) (%s));\n", addr, addr);
+      else if (type == DDS_OP_VAL_BST)
+        return emit(funcs, ind, "dds_stream_reuse_string_bound (is, %s, %"PRIu32"u);\n", addr, bound);
+      break;
+    case CDR_NORMALIZE:
+      if (type == DDS_OP_VAL_1BY)
+        return emit_check(funcs, ind, "dds_stream_normalize_uint8 (off, size)");
+      else if (is_prim(type))
+        return emit_check(funcs, ind, "dds_stream_normalize_uint%s (data, off, size, bswap)", prim_bits[type]);
+      else if (type == DDS_OP_VAL_STR)
+        return emit_check(funcs, ind, "dds_stream_normalize_string (data, off, size, bswap, SIZE_MAX)");
+      else if (type == DDS_OP_VAL_BST)
+        return emit_check(funcs, ind, "dds_stream_normalize_string (data, off, size, bswap, %"PRIu32"u)", bound);
+      break;
+  }
+  abort();
+  return -1;
+}
+
+/* loop over the elements of a sequence (length nK) or array (length cnt)
+   that require executing subroutine elem */
+static int emit_elements(
+  struct cdr_funcs *funcs, uint32_t elem, const char *elemsize, const char *buffer, const char *count, int ind)
+{
+  char base[32];
+  const uint32_t k = ++funcs->names;
+
+  idl_snprintf(base, sizeof(base), "d%"PRIu32, k);
+  if (emit(funcs, ind, "for (uint32_t i%"PRIu32" = 0; i%"PRIu32" < %s; i%"PRIu32"++)\n", k, k, count, k) < 0)
+    return -1;
+  if (emit(funcs, ind, "{\n") < 0)
+    return -1;
+  if (funcs->func != CDR_NORMALIZE &&
+      emit(funcs, ind+2, "%s%s = (%s) %s + i%"PRIu32" * sizeof (%s);\n", pointer(funcs), base, pointer(funcs), buffer, k, elemsize) < 0)
+    return -1;
+  if (emit_ops(funcs, elem, base, ind+2) < 0)
+    return -1;
+  return emit(funcs, ind, "}\n");
+}
+
+static int emit_sequence(
+  struct cdr_funcs *funcs, uint32_t *index, const char *addr, int ind)
+{
+  const uint32_t code = opcode(funcs, *index);
+  const uint32_t subtype = SUBTYPE_OF(code);
+  const uint32_t k = ++funcs->names;
+  uint32_t bound = 0;
+  char seq[32], num[32], buf[48];
+  const char *elemsize;
+
+  idl_snprintf(seq, sizeof(seq), "s%"PRIu32, k);
+  idl_snprintf(num, sizeof(num), "n%"PRIu32, k);
+  idl_snprintf(buf, sizeof(buf), "%s->_buffer", seq);
+
+  if (emit(funcs, ind, "{\n") < 0)
+    return -1;
+  ind += 2;
+  switch (funcs->func) {
+    case CDR_WRITE:
+      if (emit(funcs, ind, "const dds_sequence_t *%s = (const dds_sequence_t *) (%s);\n", seq, addr) < 0 ||
+          emit(funcs, ind, "const uint32_t %s = %s->_length;\n", num, seq) < 0 ||
+          emit(funcs, ind, "dds_os_put4 (os, %s);\n", num) < 0)
+        return -1;
+      break;
+    case CDR_READ:
+      if (emit(funcs, ind, "dds_sequence_t *%s = (dds_sequence_t *) (%s);\n", seq, addr) < 0 ||
+          emit(funcs, ind, "const uint32_t %s = dds_is_get4 (is);\n", num) < 0 ||
+          emit(funcs, ind, "if (%s == 0)\n", num) < 0 ||
+          emit(funcs, ind+2, "%s->_length = 0;\n", seq) < 0 ||
+          emit(funcs, ind, "else\n") < 0 ||
+          emit(funcs, ind, "{\n") < 0)
+        return -1;
+      ind += 2;
+      break;
+    case CDR_NORMALIZE:
+      if (emit(funcs, ind, "uint32_t %s;\n", num) < 0 ||
+          emit_check(funcs, ind, "dds_stream_read_and_normalize_uint32 (&%s, data, off, size, bswap)", num) < 0)
+        return -1;
+      break;
+  }
+
+  if (is_prim(subtype)) {
+    const char *sz = prim_sizes[subtype];
+    switch (funcs->func) {
+      case CDR_WRITE:
+        if (emit(funcs, ind, "if (%s > 0)\n", num) < 0 ||
+            emit(funcs, ind+2, "dds_os_put_bytes_aligned (os, %s, %s, %su);\n", buf, num, sz) < 0)
+          return -1;
+        break;
+      case CDR_READ:
+        if (emit(funcs, ind, "dds_stream_realloc_sequence_buffer_if_needed (%s, %s, %su, false);\n", seq, num, sz) < 0 ||
+            emit(funcs, ind, "%s->_length = (%s <= %s->_maximum) ? %s : %s->_maximum;\n", seq, num, seq, num, seq) < 0 ||
+            emit(funcs, ind, "dds_is_get_bytes (is, %s, %s->_length, %su);\n", buf, seq, sz) < 0 ||
+            emit(funcs, ind, "if (%s->_length < %s)\n", seq, num) < 0 ||
+            emit(funcs, ind+2, "dds_stream_skip_forward (is, %s - %s->_length, %su);\n", num, seq, sz) < 0)
+          return -1;
+        break;
+      case CDR_NORMALIZE:
+        if (emit_check(funcs, ind, "(%s == 0 || dds_stream_normalize_primarray (data, off, size, bswap, %s, %s))", num, num, prim_codes[subtype]) < 0)
+          return -1;
+        break;
+    }
+    *index += 2;
+  } else if (subtype == DDS_OP_VAL_STR || subtype == DDS_OP_VAL_BST) {
+    if (subtype == DDS_OP_VAL_BST)
+      bound = single(funcs, *index + 2);
+    switch (funcs->func) {
+      case CDR_WRITE:
+        if (emit(funcs, ind, "for (uint32_t i%"PRIu32" = 0; i%"PRIu32" < %s; i%"PRIu32"++)\n", k, k, num, k) < 0)
+          return -1;
+        if (subtype == DDS_OP_VAL_STR) {
+          if (emit(funcs, ind+2, "dds_stream_write_string (os, ((char * const *) %s)[i%"PRIu32"]);\n", buf, k) < 0)
+            return -1;
+        } else {
+          if (emit(funcs, ind+2, "dds_stream_write_string (os, (const char *) %s + i%"PRIu32" * %"PRIu32"u);\n", buf, k, bound) < 0)
+            return -1;
+        }
+        break;
+      case CDR_READ:
+        if (subtype == DDS_OP_VAL_STR) {
+          if (emit(funcs, ind, "dds_stream_realloc_sequence_buffer_if_needed (%s, %s, sizeof (char *), true);\n", seq, num) < 0)
+            return -1;
+        } else {
+          if (emit(funcs, ind, "dds_stream_realloc_sequence_buffer_if_needed (%s, %s, %"PRIu32"u, false);\n", seq, num, bound) < 0)
+            return -1;
+        }
+        if (emit(funcs, ind, "%s->_length = (%s <= %s->_maximum) ? %s : %s->_maximum;\n", seq, num, seq, num, seq) < 0 ||
+            emit(funcs, ind, "for (uint32_t i%"PRIu32" = 0; i%"PRIu32" < %s->_length; i%"PRIu32"++)\n", k, k, seq, k) < 0)
+          return -1;
+        if (subtype == DDS_OP_VAL_STR) {
+          if (emit(funcs, ind+2, "((char **) %s)[i%"PRIu32"] = dds_stream_reuse_string (is, ((char **) %s)[i%"PRIu32"]);\n", buf, k, buf, k) < 0)
+            return -1;
+        } else {
+          if (emit(funcs, ind+2, "dds_stream_reuse_string_bound (is, (char *) %s + i%"PRIu32" * %"PRIu32"u, %"PRIu32"u);\n", buf, k, bound, bound) < 0)
+            return -1;
+        }
+        if (emit(funcs, ind, "for (uint32_t i%"PRIu32" = %s->_length; i%"PRIu32" < %s; i%"PRIu32"++)\n", k, seq, k, num, k) < 0 ||
+            emit(funcs, ind+2, "dds_stream_skip_string (is);\n") < 0)
+          return -1;
+        break;
+      case CDR_NORMALIZE:
+        if (emit(funcs, ind, "for (uint32_t i%"PRIu32" = 0; i%"PRIu32" < %s; i%"PRIu32"++)\n", k, k, num, k) < 0)
+          return -1;
+        if (subtype == DDS_OP_VAL_STR) {
+          if (emit_check(funcs, ind+2, "dds_stream_normalize_string (data, off, size, bswap, SIZE_MAX)") < 0)
+            return -1;
+        } else {
+          if (emit_check(funcs, ind+2, "dds_stream_normalize_string (data, off, size, bswap, %"PRIu32"u)", bound) < 0)
+            return -1;
+        }
+        break;
+    }
+    *index += (subtype == DDS_OP_VAL_STR) ? 2 : 3;
+  } else {
+    const uint32_t elem = *index + subroutine(funcs, *index + 3);
+    const uint32_t jmp = jump(funcs, *index + 3);
+    elemsize = size(funcs, *index + 2);
+    if (funcs->func == CDR_READ) {
+      if (emit(funcs, ind, "dds_stream_realloc_sequence_buffer_if_needed (%s, %s, sizeof (%s), true);\n", seq, num, elemsize) < 0 ||
+          emit(funcs, ind, "%s->_length = (%s <= %s->_maximum) ? %s : %s->_maximum;\n", seq, num, seq, num, seq) < 0)
+        return -1;
+    }
+    if (emit_elements(funcs, elem, elemsize, buf, num, ind) < 0)
+      return -1;
+    *index += jmp ? jmp : 4;
+  }
+
+  if (funcs->func == CDR_READ) {
+    ind -= 2;
+    if (emit(funcs, ind, "}\n") < 0)
+      return -1;
+  }
+  ind -= 2;
+  return emit(funcs, ind, "}\n");
+}
+
+static int emit_array(
+  struct cdr_funcs *funcs, uint32_t *index, const char *addr, int ind)
+{
+  const uint32_t code = opcode(funcs, *index);
+  const uint32_t subtype = SUBTYPE_OF(code);
+  const uint32_t num = single(funcs, *index + 2);
+  uint32_t bound = 0, k;
+  char buf[512], cnt[32];
+
+  idl_snprintf(cnt, sizeof(cnt), "%"PRIu32"u", num);
+  if (is_prim(subtype)) {
+    const char *sz = prim_sizes[subtype];
+    *index += 3;
+    switch (funcs->func) {
+      case CDR_WRITE:
+        return emit(funcs, ind, "dds_os_put_bytes_aligned (os, %s, %s, %su);\n", addr, cnt, sz);
+      case CDR_READ:
+        return emit(funcs, ind, "dds_is_get_bytes (is, %s, %s, %su);\n", addr, cnt, sz);
+      case CDR_NORMALIZE:
+        return emit_check(funcs, ind, "dds_stream_normalize_primarray (data, off, size, bswap, %s, %s)", cnt, prim_codes[subtype]);
+    }
+    return -1;
+  } else if (subtype == DDS_OP_VAL_STR || subtype == DDS_OP_VAL_BST) {
+    if (subtype == DDS_OP_VAL_BST)
+      bound = single(funcs, *index + 4);
+    *index += (subtype == DDS_OP_VAL_STR) ? 3 : 5;
+    k = ++funcs->names;
+    if (emit(funcs, ind, "for (uint32_t i%"PRIu32" = 0; i%"PRIu32" < %s; i%"PRIu32"++)\n", k, k, cnt, k) < 0)
+      return -1;
+    ind += 2;
+    switch (funcs->func) {
+      case CDR_WRITE:
+        if (subtype == DDS_OP_VAL_STR)
+          return emit(funcs, ind, "dds_stream_write_string (os, ((char * const *) (%s))[i%"PRIu32"]);\n", addr, k);
+        return emit(funcs, ind, "dds_stream_write_string (os, (%s) + i%"PRIu32" * %"PRIu32"u);\n", addr, k, bound);
+      case CDR_READ:
+        if (subtype == DDS_OP_VAL_STR)
+          return emit(funcs, ind, "((char **) (%s))[i%"PRIu32"] = dds_stream_reuse_string (is, ((char **) (%s))[i%"PRIu32"]);\n", addr, k, addr, k);
+        return emit(funcs, ind, "dds_stream_reuse_string_bound (is, (%s) + i%"PRIu32" * %"PRIu32"u, %"PRIu32"u);\n", addr, k, bound, bound);
+      case CDR_NORMALIZE:
+        if (subtype == DDS_OP_VAL_STR)
+          return emit_check(funcs, ind, "dds_stream_normalize_string (data, off, size, bswap, SIZE_MAX)");
+        return emit_check(funcs, ind, "dds_stream_normalize_string (data, off, size, bswap, %"PRIu32"u)", bound);
+    }
+    return -1;
+  } else {
+    const uint32_t elem = *index + subroutine(funcs, *index + 3);
+    const uint32_t jmp = jump(funcs, *index + 3);
+    const char *elemsize = size(funcs, *index + 4);
+    *index += jmp ? jmp : 5;
+    idl_snprintf(buf, sizeof(buf), "(%s)", addr);
+    return emit_elements(funcs, elem, elemsize, buf, cnt, ind);
+  }
+}
+
+static int emit_union(
+  struct cdr_funcs *funcs, uint32_t *index, const char *addr, const char *base, int ind)
+{
+  const uint32_t code = opcode(funcs, *index);
+  const uint32_t disctype = SUBTYPE_OF(code);
+  const uint32_t cases = single(funcs, *index + 2);
+  const uint32_t first = *index + subroutine(funcs, *index + 3);
+  const bool has_default = (code & DDS_OP_FLAG_DEF) != 0;
+  const uint32_t k = ++funcs->names;
+  int ret = 0;
+
+  assert(disctype == DDS_OP_VAL_1BY || disctype == DDS_OP_VAL_2BY || disctype == DDS_OP_VAL_4BY);
+  assert(cases > 0);
+  *index += jump(funcs, *index + 3);
+
+  if (emit(funcs, ind, "{\n") < 0)
+    return -1;
+  ind += 2;
+  switch (funcs->func) {
+    case CDR_WRITE:
+      if (emit(funcs, ind, "const %s u%"PRIu32" = *(const %s *) (%s);\n", prim_types[disctype], k, prim_types[disctype], addr) < 0 ||
+          emit(funcs, ind, "dds_os_put%s (os, u%"PRIu32");\n", prim_sizes[disctype], k) < 0 ||
+          emit(funcs, ind, "switch ((uint32_t) u%"PRIu32")\n", k) < 0)
+        return -1;
+      break;
+    case CDR_READ:
+      if (emit(funcs, ind, "const %s u%"PRIu32" = dds_is_get%s (is);\n", prim_types[disctype], k, prim_sizes[disctype]) < 0 ||
+          emit(funcs, ind, "*(%s *) (%s) = u%"PRIu32";\n", prim_types[disctype], addr, k) < 0 ||
+          emit(funcs, ind, "switch ((uint32_t) u%"PRIu32")\n", k) < 0)
+        return -1;
+      break;
+    case CDR_NORMALIZE:
+      if (emit(funcs, ind, "uint32_t u%"PRIu32";\n", k) < 0 ||
+          emit_check(funcs, ind, "dds_stream_normalize_uni_disc (&u%"PRIu32", data, off, size, bswap, %s)", k, prim_codes[disctype]) < 0 ||
+          emit(funcs, ind, "switch (u%"PRIu32")\n", k) < 0)
+        return -1;
+      break;
+  }
+  if (emit(funcs, ind, "{\n") < 0)
+    return -1;
+
+  /* default case is always the last one */
+  for (uint32_t c = 0; c < cases && ret == 0; c++) {
+    const uint32_t jeq = first + 3 * c;
+    const uint32_t jeqcode = opcode(funcs, jeq);
+    const uint32_t valtype = TYPE_OF(jeqcode);
+    char *valaddr;
+
+    assert(OPCODE_OF(jeqcode) == DDS_OP_JEQ);
+    if (has_default && c == cases - 1)
+      ret = emit(funcs, ind+2, "default: {\n");
+    else
+      ret = emit(funcs, ind+2, "case (uint32_t) (%s): {\n", constant(funcs, jeq + 1));
+    if (ret < 0)
+      return -1;
+    if (!(valaddr = address(funcs, jeq + 2, base)))
+      return -1;
+    if (is_prim(valtype) || valtype == DDS_OP_VAL_STR) {
+      ret = emit_value(funcs, valtype, 0, valaddr, ind+4);
+    } else {
+      char valbase[32];
+      const uint32_t j = ++funcs->names;
+      idl_snprintf(valbase, sizeof(valbase), "d%"PRIu32, j);
+      if (funcs->func != CDR_NORMALIZE)
+        ret = emit(funcs, ind+4, "%s%s = %s;\n", pointer(funcs), valbase, valaddr);
+      if (ret == 0)
+        ret = emit_ops(funcs, jeq + (jeqcode & 0xffffu), valbase, ind+4);
+    }
+    free(valaddr);
+    if (ret == 0)
+      ret = emit(funcs, ind+4, "break;\n");
+    if (ret == 0)
+      ret = emit(funcs, ind+2, "}\n");
+  }
+  if (ret < 0)
+    return -1;
+
+  if (emit(funcs, ind, "}\n") < 0)
+    return -1;
+  ind -= 2;
+  return emit(funcs, ind, "}\n");
+}
+
+static int emit_ops(struct cdr_funcs *funcs, uint32_t index, const char *base, int ind)
+{
+  uint32_t code;
+
+  while (OPCODE_OF(code = opcode(funcs, index)) != DDS_OP_RTS) {
+    int ret = -1;
+    const uint32_t type = TYPE_OF(code);
+    char *addr;
+
+    assert(OPCODE_OF(code) == DDS_OP_ADR);
+    if (!(addr = address(funcs, index + 1, base)))
+      return -1;
+    if (is_prim(type) || type == DDS_OP_VAL_STR) {
+      ret = emit_value(funcs, type, 0, addr, ind);
+      index += 2;
+    } else if (type == DDS_OP_VAL_BST) {
+      ret = emit_value(funcs, type, single(funcs, index + 2), addr, ind);
+      index += 3;
+    } else if (type == DDS_OP_VAL_SEQ) {
+      ret = emit_sequence(funcs, &index, addr, ind);
+    } else if (type == DDS_OP_VAL_ARR) {
+      ret = emit_array(funcs, &index, addr, ind);
+    } else if (type == DDS_OP_VAL_UNI) {
+      ret = emit_union(funcs, &index, addr, base, ind);
+    }
+    free(addr);
+    if (ret < 0)
+      return -1;
+  }
+
+  return 0;
+}
+
+static int emit_write_key(struct cdr_funcs *funcs, const char *type, bool keylist)
+{
+  int ret = 0;
+  uint32_t *keys = NULL;
+  const struct descriptor *descriptor = funcs->descriptor;
+
+  funcs->func = CDR_WRITE;
+  if (idl_fprintf(funcs->fp, "static void %s_cdr_write_key (dds_ostream_t *os, const void *sample)\n{\n", type) < 0)
+    return -1;
+  if (descriptor->keys == 0) {
+    if (emit(funcs, 2, "(void) os;\n") < 0 || emit(funcs, 2, "(void) sample;\n") < 0)
+      return -1;
+    return fputs("}\n\n", funcs->fp) < 0 ? -1 : 0;
+  }
+
+  /* keys are serialized in the order of the key descriptors */
+  if (!(keys = calloc(descriptor->keys, sizeof(*keys))))
+    return -1;
+  for (uint32_t i=0, k=0; i < descriptor->instructions.count && k < descriptor->keys; i++) {
+    const struct instruction *inst = &descriptor->instructions.table[i];
+    if (inst->type != OPCODE)
+      continue;
+    if (OPCODE_OF(inst->data.opcode.code) != DDS_OP_ADR || !(inst->data.opcode.code & DDS_OP_FLAG_KEY))
+      continue;
+    assert(inst->data.opcode.order > 0);
+    if (keylist) {
+      assert(inst->data.opcode.order - 1 < descriptor->keys);
+      keys[inst->data.opcode.order - 1] = i;
+    } else {
+      keys[k] = i;
+    }
+    k++;
+  }
+
+  if (emit(funcs, 2, "const char *d0 = sample;\n") < 0)
+    ret = -1;
+  for (uint32_t k=0; k < descriptor->keys && ret == 0; k++) {
+    const uint32_t code = opcode(funcs, keys[k]);
+    char *addr;
+    if (!(addr = address(funcs, keys[k] + 1, "d0"))) {
+      ret = -1;
+    } else if (TYPE_OF(code) == DDS_OP_VAL_ARR) {
+      ret = emit(funcs, 2, "dds_os_put_bytes_aligned (os, %s, %"PRIu32"u, %su);\n",
+                 addr, single(funcs, keys[k] + 2), prim_sizes[SUBTYPE_OF(code)]);
+    } else {
+      ret = emit_value(funcs, TYPE_OF(code), 0, addr, 2);
+    }
+    free(addr);
+  }
+  free(keys);
+  if (ret < 0)
+    return -1;
+  return fputs("}\n\n", funcs->fp) < 0 ? -1 : 0;
+}
+
+/* generated functions must be equivalent to the interpreter, constructs it
+   does not support, or only supports in a way that depends on details of the
+   implementation, are left to the interpreter */
+static bool supported(const struct descriptor *descriptor)
+{
+  for (uint32_t i=0; i < descriptor->instructions.count; i++) {
+    const struct instruction *inst = &descriptor->instructions.table[i];
+    uint32_t code, type, subtype;
+    if (inst->type != OPCODE)
+      continue;
+    code = inst->data.opcode.code;
+    type = TYPE_OF(code);
+    subtype = SUBTYPE_OF(code);
+    switch (OPCODE_OF(code)) {
+      case DDS_OP_RTS:
+        break;
+      case DDS_OP_ADR:
+        if (type == DDS_OP_VAL_STU)
+          return false;
+        if ((code & DDS_OP_FLAG_KEY) &&
+            !(type <= DDS_OP_VAL_BST || (type == DDS_OP_VAL_ARR && is_prim(subtype))))
+          return false;
+        break;
+      case DDS_OP_JEQ:
+        /* bounded strings in unions are not embedded, nor referenced */
+        if (type == DDS_OP_VAL_BST)
+          return false;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+int print_cdr_funcs(FILE *fp, const struct descriptor *descriptor, bool keylist)
+{
+  char *type;
+  struct cdr_funcs funcs;
+  static const char *fmt =
+    "static const dds_topic_cdr_funcs_t %1$s_cdr_funcs =\n{\n"
+    "  %1$s_cdr_write,\n"
+    "  %1$s_cdr_write_key,\n"
+    "  %1$s_cdr_read,\n"
+    "  %1$s_cdr_normalize\n"
+    "};\n\n";
+
+  if (!supported(descriptor))
+    return 1;
+  if (IDL_PRINTA(&type, print_type, descriptor->topic) < 0)
+    return -1;
+
+  memset(&funcs, 0, sizeof(funcs));
+  funcs.fp = fp;
+  funcs.descriptor = descriptor;
+
+  funcs.func = CDR_WRITE;
+  if (idl_fprintf(fp, "static void %s_cdr_write (dds_ostream_t *os, const void *sample)\n{\n", type) < 0 ||
+      emit(&funcs, 2, "const char *d0 = sample;\n") < 0 ||
+      emit_ops(&funcs, 0, "d0", 2) < 0 ||
+      fputs("}\n\n", fp) < 0)
+    return -1;
+
+  if (emit_write_key(&funcs, type, keylist) < 0)
+    return -1;
+
+  funcs.func = CDR_READ;
+  if (idl_fprintf(fp, "static void %s_cdr_read (dds_istream_t *is, void *sample)\n{\n", type) < 0 ||
+      emit(&funcs, 2, "char *d0 = sample;\n") < 0 ||
+      emit_ops(&funcs, 0, "d0", 2) < 0 ||
+      fputs("}\n\n", fp) < 0)
+    return -1;
+
+  funcs.func = CDR_NORMALIZE;
+  if (idl_fprintf(fp, "static bool %s_cdr_normalize (char *data, uint32_t *off, uint32_t size, bool bswap)\n{\n", type) < 0 ||
+      emit(&funcs, 2, "(void) data;\n") < 0 ||
+      emit(&funcs, 2, "(void) bswap;\n") < 0 ||
+      emit_ops(&funcs, 0, "d0", 2) < 0 ||
+      emit(&funcs, 2, "return true;\n") < 0 ||
+      fputs("}\n\n", fp) < 0)
+    return -1;
+
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
+  return 0;
+}
@@ -32,77 +32,6 @@
 
 static const uint16_t nop = UINT16_MAX;
 
-/* store each instruction separately for easy post processing and reduced
-   complexity. arrays and sequences introduce a new scope and the relative
-   offset to the next field is stored with the instructions for the respective
-   field. this requires the generator to revert its position. using separate
-   streams intruduces too much complexity. the table is also used to generate
-   a key offset table after the fact */
-struct instruction {
-  enum {
-    OPCODE,
-    OFFSET,
-    SIZE,
-    CONSTANT,
-    COUPLE,
-    SINGLE,
-  } type;
-  union {
-    struct {
-      uint32_t code;
-      uint32_t order; /**< key order if DDS_OP_FLAG_KEY */
-    } opcode;
-    struct {
-      char *type;
-      char *member;
-    } offset; /**< name of type and member to generate offsetof */
-    struct {
-      char *type;
-    } size; /**< name of type to generate sizeof */
-    struct {
-      char *value;
-    } constant;
-    struct {
-      uint16_t high;
-      uint16_t low;
-    } couple;
-    uint32_t single;
-  } data;
-};
-
-struct field {
-  struct field *previous;
-  const void *node;
-};
-
-struct type {
-  struct type *previous;
-  struct field *fields;
-  const void *node;
-  uint32_t offset;
-  uint32_t label, labels;
-};
-
-struct alignment {
-  int value;
-  int ordering;
-  const char *rendering;
-};
-
-struct descriptor {
-  const idl_node_t *topic;
-  const struct alignment *alignment; /**< alignment of topic type */
-  uint32_t keys; /**< number of keys in topic */
-  uint32_t opcodes; /**< number of opcodes in descriptor */
-  uint32_t flags; /**< topic descriptor flag values */
-  struct type *types;
-  struct {
-    uint32_t size; /**< available number of instructions */
-    uint32_t count; /**< used number of instructions */
-    struct instruction *table;
-  } instructions;
-};
-
 static const struct alignment alignments[] = {
 #define ALIGNMENT_1BY (&alignments[0])
   { 1, 0, "1u" },
@@ -1285,7 +1214,7 @@ err_keys:
 static int print_flags(FILE *fp, struct descriptor *descriptor)
 {
   const char *fmt;
-  const char *vec[4] = { NULL };
+  const char *vec[5] = { NULL };
   size_t cnt, len = 0;
 
   if (descriptor->flags & DDS_TOPIC_NO_OPTIMIZE)
@@ -1310,6 +1239,8 @@ static int print_flags(FILE *fp, struct descriptor *descriptor)
 
   if (fixed_size)
     vec[len++] = "DDS_TOPIC_FIXED_SIZE";
+  if (descriptor->flags & DDS_TOPIC_CDR_FUNCS)
+    vec[len++] = "DDS_TOPIC_CDR_FUNCS";
 
   if (!len)
     vec[len++] = "0u";
@@ -1344,18 +1275,24 @@ static int print_descriptor(FILE *fp, struct descriptor *descriptor)
           "  %3$s_keys,\n" /* key array */
           "  %4$"PRIu32",\n" /* number of ops */
           "  %3$s_ops,\n" /* ops array */
-          "  \"\"\n" /* OpenSplice metadata */
-          "};\n";
+          "  \"\",\n"; /* OpenSplice metadata */
   else
     fmt = "  %1$"PRIu32"u,\n" /* number of keys */
           "  \"%2$s\",\n" /* fully qualified name in IDL */
           "  NULL,\n" /* key array */
           "  %4$"PRIu32",\n" /* number of ops */
           "  %3$s_ops,\n" /* ops array */
-          "  \"\"\n" /* OpenSplice metadata */
-          "};\n";
+          "  \"\",\n"; /* OpenSplice metadata */
   if (idl_fprintf(fp, fmt, descriptor->keys, name, type, descriptor->opcodes) < 0)
     return -1;
+  if (descriptor->flags & DDS_TOPIC_CDR_FUNCS)
+    fmt = "  &%s_cdr_funcs\n" /* type-specific (de)serializers */
+          "};\n";
+  else
+    fmt = "  NULL\n" /* type-specific (de)serializers */
+          "};\n";
+  if (idl_fprintf(fp, fmt, type) < 0)
+    return -1;
 
   return 0;
 }
@@ -1401,6 +1338,13 @@ generate_descriptor(
     { ret = IDL_RETCODE_NO_MEMORY; goto err_print; }
   if (print_opcodes(generator->source.handle, &descriptor) < 0)
     { ret = IDL_RETCODE_NO_MEMORY; goto err_print; }
+  if (generator->cdr_funcs) {
+    int cnt;
+    if ((cnt = print_cdr_funcs(generator->source.handle, &descriptor, keylist)) < 0)
+      { ret = IDL_RETCODE_NO_MEMORY; goto err_print; }
+    if (cnt == 0)
+      descriptor.flags |= DDS_TOPIC_CDR_FUNCS;
+  }
   if (print_descriptor(generator->source.handle, &descriptor) < 0)
     { ret = IDL_RETCODE_NO_MEMORY; goto err_print; }
 
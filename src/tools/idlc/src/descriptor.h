@@ -9,10 +9,92 @@
  *
  * SPDX-License-Identifier: EPL-2.0 OR BSD-3-Clause
  */
+#ifndef DESCRIPTOR_H
+#define DESCRIPTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
 #include "idl/processor.h"
 
+/* store each instruction separately for easy post processing and reduced
+   complexity. arrays and sequences introduce a new scope and the relative
+   offset to the next field is stored with the instructions for the respective
+   field. this requires the generator to revert its position. using separate
+   streams intruduces too much complexity. the table is also used to generate
+   a key offset table after the fact */
+struct instruction {
+  enum {
+    OPCODE,
+    OFFSET,
+    SIZE,
+    CONSTANT,
+    COUPLE,
+    SINGLE,
+  } type;
+  union {
+    struct {
+      uint32_t code;
+      uint32_t order; /**< key order if DDS_OP_FLAG_KEY */
+    } opcode;
+    struct {
+      char *type;
+      char *member;
+    } offset; /**< name of type and member to generate offsetof */
+    struct {
+      char *type;
+    } size; /**< name of type to generate sizeof */
+    struct {
+      char *value;
+    } constant;
+    struct {
+      uint16_t high;
+      uint16_t low;
+    } couple;
+    uint32_t single;
+  } data;
+};
+
+struct field {
+  struct field *previous;
+  const void *node;
+};
+
+struct type {
+  struct type *previous;
+  struct field *fields;
+  const void *node;
+  uint32_t offset;
+  uint32_t label, labels;
+};
+
+struct alignment {
+  int value;
+  int ordering;
+  const char *rendering;
+};
+
+struct descriptor {
+  const idl_node_t *topic;
+  const struct alignment *alignment; /**< alignment of topic type */
+  uint32_t keys; /**< number of keys in topic */
+  uint32_t opcodes; /**< number of opcodes in descriptor */
+  uint32_t flags; /**< topic descriptor flag values */
+  struct type *types;
+  struct {
+    uint32_t size; /**< available number of instructions */
+    uint32_t count; /**< used number of instructions */
+    struct instruction *table;
+  } instructions;
+};
+
 idl_retcode_t
 emit_topic_descriptor(
   const idl_pstate_t *pstate,
   const idl_node_t *node,
   void *user_data);
+
+int print_cdr_funcs(FILE *fp, const struct descriptor *descriptor, bool keylist);
+
+#endif /* DESCRIPTOR_H */
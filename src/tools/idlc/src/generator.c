@@ -26,6 +26,22 @@
 #include "idl/processor.h"
 #include "idl/print.h"
 
+static int generate_cdr = 0;
+
+static const idlc_option_t *opts[] = {
+  &(idlc_option_t){
+    IDLC_FLAG, { .flag = &generate_cdr }, 'f', "generate-cdr", "",
+    "Generate type-specific (de)serialization functions in addition to the "
+    "marshalling opcodes. The opcode interpreter is used for types these "
+    "functions cannot be generated for." },
+  NULL
+};
+
+const idlc_option_t **idlc_generator_options(void)
+{
+  return opts;
+}
+
 static int print_base_type(
   char *str, size_t size, const void *node, void *user_data)
 {
@@ -323,6 +339,9 @@ generate_nosetup(const idl_pstate_t *pstate, struct generator *generator)
       sep = ptr+1;
   if (idl_fprintf(generator->source.handle, "#include \"%s\"\n\n", sep) < 0)
     return IDL_RETCODE_NO_MEMORY;
+  if (generator->cdr_funcs &&
+      fputs("#include \"dds/ddsi/ddsi_cdrstream.h\"\n\n", generator->source.handle) < 0)
+    return IDL_RETCODE_NO_MEMORY;
   if ((ret = generate_types(pstate, generator)))
     return ret;
   if (fputs("#ifdef __cplusplus\n}\n#endif\n\n", generator->header.handle) < 0)
@@ -371,6 +390,7 @@ idlc_generate(const idl_pstate_t *pstate)
 
   memset(&generator, 0, sizeof(generator));
   generator.path = file;
+  generator.cdr_funcs = (generate_cdr != 0);
 
   sep = dir[0] == '\0' ? "" : "/";
   if (idl_asprintf(&generator.header.path, "%s%s%s.h", dir, sep, basename) < 0)
@@ -15,6 +15,7 @@
 #include <stdio.h>
 
 #include "idl/processor.h"
+#include "idlc/options.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -29,11 +30,17 @@ struct generator {
     FILE *handle;
     char *path;
   } source;
+  bool cdr_funcs; /**< generate type-specific (de)serialization functions */
 };
 
 int print_type(char *str, size_t len, const void *ptr, void *user_data);
 int print_scoped_name(char *str, size_t len, const void *ptr, void *user_data);
 
+#if _WIN32
+__declspec(dllexport)
+#endif
+const idlc_option_t **idlc_generator_options(void);
+
 #if _WIN32
 __declspec(dllexport)
 #endif